@@ -0,0 +1,223 @@
+#include <cmath>
+#include <cstring>
+
+#include "behavior_classifier.hpp"
+#include "behavior_model.hpp"
+
+static constexpr size_t ARENA_HALF = BEHAVIOR_ARENA_BYTES / 2;
+
+// the activation arena, layer i reads one half and writes the other
+alignas(16) static int8_t arena[BEHAVIOR_ARENA_BYTES];
+
+/// @brief Whether the layer shapes chain from the input to the logits and every tensor fits half the arena
+static constexpr bool model_fits(const behavior_model_t &model) {
+    if (model.layers == nullptr || model.n_layers == 0 || model.in_len == 0 ||
+        size_t(model.in_len) * BEHAVIOR_F_COUNT > ARENA_HALF) {
+        return false;
+    }
+    size_t len = model.in_len;
+    size_t ch = BEHAVIOR_F_COUNT;
+    int32_t zp = model.in_zp;
+    for (size_t i = 0; i < model.n_layers; i++) {
+        const behavior_layer_t &layer = model.layers[i];
+        if (layer.in_len != len || layer.in_ch != ch || layer.in_zp != zp || layer.out_ch == 0 ||
+            (layer.type == BEHAVIOR_LAYER_CONV1D && (layer.kernel == 0 || layer.kernel > len))) {
+            return false;
+        }
+        len = behavior_layer_out_len(layer);
+        ch = layer.out_ch;
+        zp = layer.out_zp;
+        if (len * ch > ARENA_HALF) {
+            return false;
+        }
+    }
+    return len == 1 && ch == BEHAVIOR_CLASS_COUNT;
+}
+
+static_assert(model_fits(behavior_model), "behavior_model.hpp does not chain or does not fit BEHAVIOR_ARENA_BYTES");
+
+const char *behavior_class_to_str(behavior_class_t cls) {
+    switch (cls) {
+        case BEHAVIOR_SLEEPING:
+            return "sleeping";
+        case BEHAVIOR_WALKING:
+            return "walking";
+        case BEHAVIOR_RUNNING:
+            return "running";
+        case BEHAVIOR_SCRATCHING:
+            return "scratching";
+        case BEHAVIOR_EATING:
+            return "eating";
+        case BEHAVIOR_SHAKING:
+            return "shaking";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+const behavior_model_t &behavior_default_model() {
+    return behavior_model;
+}
+
+// ======================================================================
+// REQUANTIZATION (gemmlowp / TFLite rounding)
+// ======================================================================
+
+/// @brief (a * b * 2) >> 32 rounded to nearest, the one overflowing case saturated
+static inline int32_t saturating_rounding_doubling_high_mul(int32_t a, int32_t b) {
+    if (a == INT32_MIN && b == INT32_MIN) {
+        return INT32_MAX;
+    }
+    const int64_t ab = int64_t(a) * int64_t(b);
+    const int64_t nudge = ab >= 0 ? (int64_t(1) << 30) : 1 - (int64_t(1) << 30);
+    return int32_t((ab + nudge) / (int64_t(1) << 31));
+}
+
+/// @brief x / 2^exponent rounded to nearest, ties away from zero
+static inline int32_t rounding_divide_by_pot(int32_t x, int exponent) {
+    const int32_t mask = int32_t((int64_t(1) << exponent) - 1);
+    const int32_t remainder = x & mask;
+    const int32_t threshold = (mask >> 1) + (x < 0 ? 1 : 0);
+    return (x >> exponent) + (remainder > threshold ? 1 : 0);
+}
+
+static inline int32_t multiply_by_quantized_multiplier(int32_t x, int32_t mult, int shift) {
+    const int left = shift > 0 ? shift : 0;
+    const int right = shift > 0 ? 0 : -shift;
+    return rounding_divide_by_pot(saturating_rounding_doubling_high_mul(int32_t(uint32_t(x) << left), mult), right);
+}
+
+// ======================================================================
+// KERNELS
+// ======================================================================
+
+/// @brief Raw int8 dot product, int32 accumulation (the zero point is folded in by the caller)
+static inline int32_t dot(const int8_t *in, const int8_t *w, size_t n) {
+    int32_t acc = 0;
+    for (size_t i = 0; i < n; i++) {
+        acc += int32_t(in[i]) * int32_t(w[i]);
+    }
+    return acc;
+}
+
+void behavior_layer_run(const behavior_layer_t &layer, const int8_t *in, int8_t *out) {
+    // time major tensors make the taps of one conv1d output a contiguous kernel x in_ch run, the same
+    // shape as a weight row: both layer types are one dot product per output with a row of length n
+    const size_t n = layer.type == BEHAVIOR_LAYER_DENSE ? size_t(layer.in_len) * layer.in_ch
+                                                        : size_t(layer.kernel) * layer.in_ch;
+    const size_t out_len = behavior_layer_out_len(layer);
+    for (size_t c = 0; c < layer.out_ch; c++) {
+        const int8_t *w = layer.weights + c * n;
+
+        // sum((q - zp) * w) = sum(q * w) - zp * sum(w), the second term once per channel
+        int32_t w_sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            w_sum += w[i];
+        }
+        const int32_t base = layer.bias[c] - layer.in_zp * w_sum;
+
+        for (size_t t = 0; t < out_len; t++) {
+            const int32_t acc = base + dot(in + t * layer.in_ch, w, n);
+            int32_t q = layer.out_zp + multiply_by_quantized_multiplier(acc, layer.mult[c], layer.shift[c]);
+            q = q < layer.act_min ? layer.act_min : q;
+            q = q > INT8_MAX ? INT8_MAX : q;
+            out[t * layer.out_ch + c] = int8_t(q);
+        }
+    }
+}
+
+void behavior_quantize_input(const behavior_model_t &model, const behavior_features_t &features, int8_t *q) {
+    for (size_t f = 0; f < BEHAVIOR_F_COUNT; f++) {
+        float x = features.v[f];
+        if ((model.in_sqrt >> f) & 1U) {
+            x = x > 0.0f ? std::sqrt(x) : 0.0f;
+        }
+        // clamped before rounding so a NaN or huge value cannot reach lrintf
+        const float scaled = std::fmin(std::fmax(x * model.in_gain[f], -256.0f), 256.0f);
+        int32_t v = int32_t(std::lrintf(scaled)) + model.in_zp;
+        v = v < INT8_MIN ? INT8_MIN : v;
+        v = v > INT8_MAX ? INT8_MAX : v;
+        q[f] = int8_t(v);
+    }
+}
+
+/// @brief Run the layers on the input already in the first half of the arena
+static void run_in_arena(const behavior_model_t &model, int8_t *logits) {
+    int8_t *in = arena;
+    int8_t *out = arena + ARENA_HALF;
+    for (size_t i = 0; i < model.n_layers; i++) {
+        behavior_layer_run(model.layers[i], in, out);
+        int8_t *swap = in;
+        in = out;
+        out = swap;
+    }
+    std::memcpy(logits, in, BEHAVIOR_CLASS_COUNT);
+}
+
+bool behavior_model_run(const behavior_model_t &model, const int8_t *input, int8_t *logits) {
+    if (input == nullptr || logits == nullptr || !model_fits(model)) {
+        return false;
+    }
+    std::memcpy(arena, input, size_t(model.in_len) * BEHAVIOR_F_COUNT);
+    run_in_arena(model, logits);
+    return true;
+}
+
+// ======================================================================
+// CLASSIFIER
+// ======================================================================
+
+bool behavior_classifier::configure(const behavior_model_t *config) {
+    const behavior_model_t *m = config != nullptr ? config : &behavior_model;
+    if (m->in_len > BEHAVIOR_MAX_IN_LEN || !model_fits(*m)) {
+        return false;
+    }
+    model = m;
+    reset();
+    return true;
+}
+
+void behavior_classifier::reset() {
+    pos = 0;
+    count = 0;
+}
+
+bool behavior_classifier::push(const behavior_features_t &features, behavior_result_t &out) {
+    if (model == nullptr) {
+        return false;
+    }
+    const size_t len = model->in_len;
+    behavior_quantize_input(*model, features, window[pos]);
+    pos = pos + 1 == len ? 0 : pos + 1;
+    if (count < len) {
+        count++;
+    }
+    if (count < len) {
+        return false;
+    }
+
+    // oldest vector first, pos is the oldest once the ring is full
+    for (size_t i = 0; i < len; i++) {
+        const size_t slot = pos + i < len ? pos + i : pos + i - len;
+        std::memcpy(arena + i * BEHAVIOR_F_COUNT, window[slot], BEHAVIOR_F_COUNT);
+    }
+    run_in_arena(*model, out.logits);
+    n_inferences++;
+
+    size_t best = 0;
+    for (size_t c = 1; c < BEHAVIOR_CLASS_COUNT; c++) {
+        if (out.logits[c] > out.logits[best]) {
+            best = c;
+        }
+    }
+    int32_t runner_up = INT8_MIN;
+    for (size_t c = 0; c < BEHAVIOR_CLASS_COUNT; c++) {
+        if (c != best && out.logits[c] > runner_up) {
+            runner_up = out.logits[c];
+        }
+    }
+    out.t_us = features.t_us;
+    out.cls = behavior_class_t(best);
+    out.margin = uint8_t(out.logits[best] - runner_up);
+    return true;
+}
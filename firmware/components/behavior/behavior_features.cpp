@@ -0,0 +1,334 @@
+#include <cmath>
+#include <cstring>
+
+#include "behavior_features.hpp"
+
+static constexpr float PI = 3.14159265358979f;
+static constexpr float DOM_MIN_RMS_MS2 = 1e-3f;   // |accel| ripple with no dominant frequency, far above float rounding
+
+const char *behavior_feature_to_str(behavior_feature_id_t id) {
+    switch (id) {
+        case BEHAVIOR_F_ACC_ENERGY:
+            return "acc_energy";
+        case BEHAVIOR_F_ACC_VAR_X:
+            return "acc_var_x";
+        case BEHAVIOR_F_ACC_VAR_Y:
+            return "acc_var_y";
+        case BEHAVIOR_F_ACC_VAR_Z:
+            return "acc_var_z";
+        case BEHAVIOR_F_ACC_DOM_HZ:
+            return "acc_dom_hz";
+        case BEHAVIOR_F_ACC_DOM_SHARE:
+            return "acc_dom_share";
+        case BEHAVIOR_F_ACC_ZCR_HZ:
+            return "acc_zcr_hz";
+        case BEHAVIOR_F_ACC_JERK:
+            return "acc_jerk";
+        case BEHAVIOR_F_GYRO_ENERGY:
+            return "gyro_energy";
+        case BEHAVIOR_F_GYRO_VAR_X:
+            return "gyro_var_x";
+        case BEHAVIOR_F_GYRO_VAR_Y:
+            return "gyro_var_y";
+        case BEHAVIOR_F_GYRO_VAR_Z:
+            return "gyro_var_z";
+        case BEHAVIOR_F_ORIENT_CHANGE:
+            return "orient_change";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+bool behavior_feature_engine::configure(const behavior_features_config_t &config) {
+    if (!(config.fs_hz > 0.0f) || config.hop < MIN_HOP || config.hop > W || W % config.hop != 0 ||
+        !(config.zcr_deadband_ms2 >= 0.0f)) {
+        return false;
+    }
+    if (!gravity.configure(config.gravity_fc_hz, config.fs_hz) || !acc_stats.configure(W) ||
+        !gyro_stats.configure(W)) {
+        return false;
+    }
+    cfg = config;
+
+    // periodic Hann window, twiddles e^(-2 pi i k / W) and the bit reversal of the W / 2 point FFT
+    constexpr size_t M = W / 2;
+    size_t bits = 0;
+    while ((size_t(1) << bits) < M) {
+        bits++;
+    }
+    for (size_t k = 0; k < W; k++) {
+        hann[k] = 0.5f - 0.5f * std::cos(2.0f * PI * k / W);
+    }
+    for (size_t k = 0; k < M; k++) {
+        tw_re[k] = std::cos(2.0f * PI * k / W);
+        tw_im[k] = -std::sin(2.0f * PI * k / W);
+        size_t r = 0;
+        for (size_t b = 0; b < bits; b++) {
+            r |= ((k >> b) & 1U) << (bits - 1 - b);
+        }
+        bitrev[k] = static_cast<uint16_t>(r);
+    }
+
+    reset();
+    return true;
+}
+
+void behavior_feature_engine::reset() {
+    gravity.reset();
+    acc_stats.reset();
+    gyro_stats.reset();
+    std::memset(crossings, 0, sizeof(crossings));
+    std::memset(zc_sign, 0, sizeof(zc_sign));
+    std::memset(rv_hops, 0, sizeof(rv_hops));
+    energy_sum = 0.0f;
+    jerk_sum = 0.0f;
+    crossing_sum = 0;
+    gyro_energy_sum = 0.0f;
+    acc_pos = 0;
+    acc_count = 0;
+    gyro_pos = 0;
+    gyro_count = 0;
+    since_hop = 0;
+    rv_hop_pos = 0;
+    have_rv = false;
+    n_vectors = 0;
+}
+
+void behavior_feature_engine::add_accel(const imu_sample_t &sample) {
+    const float v[IMU_DSP_AXES] = {sample.data.vec.x, sample.data.vec.y, sample.data.vec.z};
+    float dyn[IMU_DSP_AXES] = {v[0], v[1], v[2]};
+    gravity.process(dyn);
+    acc_stats.process(v, nullptr, nullptr);
+
+    const size_t p = acc_pos;
+    const bool first = (acc_count == 0);
+    if (acc_count == W) {
+        energy_sum -= energy[p];
+        jerk_sum -= jerk[p];
+        crossing_sum -= crossings[p];
+    } else {
+        acc_count++;
+    }
+
+    // a crossing is dynamic accel leaving the dead band on the other side from where it last left
+    uint8_t c = 0;
+    for (int a = 0; a < IMU_DSP_AXES; a++) {
+        const int8_t side = (dyn[a] > cfg.zcr_deadband_ms2) ? 1 : (dyn[a] < -cfg.zcr_deadband_ms2) ? -1 : 0;
+        if (side != 0) {
+            c += (zc_sign[a] == -side) ? 1 : 0;
+            zc_sign[a] = side;
+        }
+    }
+
+    const float dx = v[0] - last_acc[0];
+    const float dy = v[1] - last_acc[1];
+    const float dz = v[2] - last_acc[2];
+    mag[p] = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    energy[p] = dyn[0] * dyn[0] + dyn[1] * dyn[1] + dyn[2] * dyn[2];
+    jerk[p] = first ? 0.0f : std::sqrt(dx * dx + dy * dy + dz * dz) * cfg.fs_hz;
+    crossings[p] = c;
+    energy_sum += energy[p];
+    jerk_sum += jerk[p];
+    crossing_sum += c;
+    std::memcpy(last_acc, v, sizeof(last_acc));
+    acc_t_us = sample.timestamp_us;
+
+    // the running float sums restart from the window once per lap
+    if (++acc_pos == W) {
+        acc_pos = 0;
+        energy_sum = 0.0f;
+        jerk_sum = 0.0f;
+        for (size_t k = 0; k < W; k++) {
+            energy_sum += energy[k];
+            jerk_sum += jerk[k];
+        }
+    }
+}
+
+void behavior_feature_engine::add_gyro(const imu_sample_t &sample) {
+    const float v[IMU_DSP_AXES] = {sample.data.vec.x, sample.data.vec.y, sample.data.vec.z};
+    gyro_stats.process(v, nullptr, nullptr);
+
+    const size_t p = gyro_pos;
+    if (gyro_count == W) {
+        gyro_energy_sum -= gyro_energy[p];
+    } else {
+        gyro_count++;
+    }
+    gyro_energy[p] = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+    gyro_energy_sum += gyro_energy[p];
+
+    if (++gyro_pos == W) {
+        gyro_pos = 0;
+        gyro_energy_sum = 0.0f;
+        for (size_t k = 0; k < W; k++) {
+            gyro_energy_sum += gyro_energy[k];
+        }
+    }
+}
+
+/**
+ * @brief Dominant frequency of |accel| over the window
+ * The window (mean removed, Hann weighted) is packed as W / 2 complex points,
+ * even samples real and odd imaginary, transformed with a radix 2 FFT and
+ * split into the W / 2 + 1 bins of the real spectrum. The peak bin is refined
+ * with a parabola through it and its neighbours.
+ * @param share: power of the peak bin and its neighbours over all bins but DC
+ */
+float behavior_feature_engine::dominant_frequency(float &share) {
+    constexpr size_t M = W / 2;
+
+    float mean = 0.0f;
+    for (size_t k = 0; k < W; k++) {
+        mean += mag[k];
+    }
+    mean /= static_cast<float>(W);
+
+    // acc_pos is the oldest slot of a full window
+    float ripple = 0.0f;
+    for (size_t n = 0; n < M; n++) {
+        const size_t k = 2 * n;
+        const float even = mag[(acc_pos + k) % W] - mean;
+        const float odd = mag[(acc_pos + k + 1) % W] - mean;
+        ripple += even * even + odd * odd;
+        fft_re[bitrev[n]] = even * hann[k];
+        fft_im[bitrev[n]] = odd * hann[k + 1];
+    }
+    // a still window is only rounding noise, its peak would be anywhere
+    if (ripple < DOM_MIN_RMS_MS2 * DOM_MIN_RMS_MS2 * static_cast<float>(W)) {
+        share = 0.0f;
+        return 0.0f;
+    }
+
+    for (size_t len = 2; len <= M; len <<= 1) {
+        const size_t half = len / 2;
+        const size_t step = W / len;
+        for (size_t i = 0; i < M; i += len) {
+            for (size_t j = 0; j < half; j++) {
+                const float wr = tw_re[j * step];
+                const float wi = tw_im[j * step];
+                const size_t a = i + j;
+                const size_t b = a + half;
+                const float tr = wr * fft_re[b] - wi * fft_im[b];
+                const float ti = wr * fft_im[b] + wi * fft_re[b];
+                fft_re[b] = fft_re[a] - tr;
+                fft_im[b] = fft_im[a] - ti;
+                fft_re[a] += tr;
+                fft_im[a] += ti;
+            }
+        }
+    }
+
+    // X[k] = E[k] + e^(-2 pi i k / W) O[k], E = (Z[k] + Z*[M - k]) / 2, O = (Z[k] - Z*[M - k]) / 2i
+    float total = 0.0f;
+    for (size_t k = 0; k <= M; k++) {
+        const size_t a = k % M;
+        const size_t b = (M - k) % M;
+        const float er = 0.5f * (fft_re[a] + fft_re[b]);
+        const float ei = 0.5f * (fft_im[a] - fft_im[b]);
+        const float or_ = 0.5f * (fft_im[a] + fft_im[b]);
+        const float oi = -0.5f * (fft_re[a] - fft_re[b]);
+        const float wr = (k < M) ? tw_re[k] : -1.0f;
+        const float wi = (k < M) ? tw_im[k] : 0.0f;
+        const float xr = er + wr * or_ - wi * oi;
+        const float xi = ei + wr * oi + wi * or_;
+        power[k] = xr * xr + xi * xi;
+        total += (k > 0) ? power[k] : 0.0f;
+    }
+
+    size_t peak = 1;
+    for (size_t k = 2; k < M; k++) {
+        peak = (power[k] > power[peak]) ? k : peak;
+    }
+    if (!(total > 1e-9f)) {
+        share = 0.0f;
+        return 0.0f;
+    }
+
+    const float l = power[peak - 1];
+    const float c = power[peak];
+    const float r = power[peak + 1];
+    const float denom = l - 2.0f * c + r;
+    const float delta = (denom < 0.0f) ? 0.5f * (l - r) / denom : 0.0f;
+    share = (l + c + r) / total;
+    share = (share < 1.0f) ? share : 1.0f;
+    return (static_cast<float>(peak) + delta) * cfg.fs_hz / static_cast<float>(W);
+}
+
+void behavior_feature_engine::emit(behavior_features_t &out) {
+    const float inv_w = 1.0f / static_cast<float>(W);
+    out.t_us = acc_t_us;
+
+    float var[IMU_DSP_AXES];
+    acc_stats.current(nullptr, var);
+    out.v[BEHAVIOR_F_ACC_ENERGY] = energy_sum * inv_w;
+    out.v[BEHAVIOR_F_ACC_VAR_X] = var[0];
+    out.v[BEHAVIOR_F_ACC_VAR_Y] = var[1];
+    out.v[BEHAVIOR_F_ACC_VAR_Z] = var[2];
+    out.v[BEHAVIOR_F_ACC_DOM_HZ] = dominant_frequency(out.v[BEHAVIOR_F_ACC_DOM_SHARE]);
+    out.v[BEHAVIOR_F_ACC_ZCR_HZ] = static_cast<float>(crossing_sum) * cfg.fs_hz * inv_w / IMU_DSP_AXES;
+    out.v[BEHAVIOR_F_ACC_JERK] = jerk_sum * inv_w;
+
+    gyro_stats.current(nullptr, var);
+    out.v[BEHAVIOR_F_GYRO_ENERGY] = (gyro_count > 0) ? gyro_energy_sum / static_cast<float>(gyro_count) : 0.0f;
+    out.v[BEHAVIOR_F_GYRO_VAR_X] = var[0];
+    out.v[BEHAVIOR_F_GYRO_VAR_Y] = var[1];
+    out.v[BEHAVIOR_F_GYRO_VAR_Z] = var[2];
+
+    // the slot after the newest boundary holds the window start, all zero until it has been written
+    const float *q0 = rv_hops[rv_hop_pos];
+    const float *q1 = rv;
+    const float dot = q0[0] * q1[0] + q0[1] * q1[1] + q0[2] * q1[2] + q0[3] * q1[3];
+    const float n0 = q0[0] * q0[0] + q0[1] * q0[1] + q0[2] * q0[2] + q0[3] * q0[3];
+    float angle = 0.0f;
+    if (have_rv && n0 > 0.5f) {
+        const float c = std::fabs(dot) / std::sqrt(n0);
+        angle = 2.0f * std::acos(c < 1.0f ? c : 1.0f);
+    }
+    out.v[BEHAVIOR_F_ORIENT_CHANGE] = angle;
+
+    n_vectors++;
+}
+
+bool behavior_feature_engine::push(const imu_sample_t &sample, behavior_features_t &out) {
+    if (sample.report_id == cfg.accel_rpt) {
+        add_accel(sample);
+        if (++since_hop < cfg.hop) {
+            return false;
+        }
+        since_hop = 0;
+
+        const size_t slots = W / cfg.hop + 1;
+        if (have_rv) {
+            std::memcpy(rv_hops[rv_hop_pos], rv, sizeof(rv));
+        }
+        rv_hop_pos = (rv_hop_pos + 1) % slots;
+        if (acc_count < W) {
+            return false;
+        }
+        emit(out);
+        return true;
+    }
+
+    if (cfg.gyro_rpt != 0 && sample.report_id == cfg.gyro_rpt) {
+        add_gyro(sample);
+    } else if (cfg.rv_rpt != 0 && sample.report_id == cfg.rv_rpt) {
+        rv[0] = sample.data.quat.real;
+        rv[1] = sample.data.quat.i;
+        rv[2] = sample.data.quat.j;
+        rv[3] = sample.data.quat.k;
+        have_rv = true;
+    }
+    return false;
+}
+
+size_t behavior_feature_engine::push(const imu_sample_t *in, size_t count, behavior_features_t *out, size_t max,
+                                     size_t &n_out) {
+    n_out = 0;
+    size_t i = 0;
+    while (i < count && n_out < max) {
+        n_out += push(in[i], out[n_out]) ? 1 : 0;
+        i++;
+    }
+    return i;
+}
@@ -0,0 +1,268 @@
+// behavior_model.hpp
+// Generated by host/tools/behavior_train, do not edit.
+// 10950 training windows (0 from recordings), held out: float 100.0%, int8 100.0%
+#ifndef BEHAVIOR_MODEL_H
+#define BEHAVIOR_MODEL_H
+
+#include "behavior_classifier.hpp"
+
+static constexpr float behavior_model_in_gain[BEHAVIOR_F_COUNT] = {
+    13.3186064f, 27.1016102f, 32.0294571f, 16.9601631f, 19.4477024f, 231.818176f,
+    16.1851234f, 0.310726017f, 19.8235912f, 22.4738731f, 44.7011147f, 116.198616f,
+    248.951553f,
+};
+
+static constexpr int8_t behavior_model_l0_weights[624] = {
+    19, -60, 83, 53, -40, -28, 9, 62, -59, 61, -20, -92, 38, 101, 69, -69,
+    -34, -110, 124, -102, -30, 113, -93, -127, -78, 25, 64, 39, 52, -80, 64, 121,
+    -52, 15, -52, 96, -21, 48, -84, 73, 78, -62, 41, 50, 60, 37, 81, -103,
+    -69, -35, -91, -75, 68, 73, 98, 19, 92, 103, 73, -58, 12, -16, -68, 11,
+    32, -4, 104, 64, 127, 12, 76, 79, 77, -104, -76, -82, -3, -15, -49, 69,
+    -50, 60, -115, 81, -117, -66, -39, 43, 15, 45, 28, -17, 36, -30, 51, 19,
+    127, -34, 46, 26, -25, 56, 21, -8, -80, -59, -64, 44, -65, 49, -38, 19,
+    82, 11, -18, 48, 21, 39, -10, 56, 68, 66, -50, 68, 6, 70, 69, 69,
+    -21, -1, 10, -7, 27, -16, 92, -27, 127, 71, 55, 78, -14, 68, 49, 2,
+    71, 47, 27, 107, 47, 116, 3, 69, 61, 61, 41, -6, -59, 37, 75, 6,
+    -107, -109, -86, 24, 22, -81, 47, -75, 12, 63, -25, -127, -77, -40, -51, -89,
+    -110, 46, 96, 84, 72, 114, -2, 61, -92, 3, -121, -30, 39, 21, 38, -4,
+    78, -124, -76, 2, -99, -78, 96, 46, 8, -59, 16, 66, 66, -68, -79, 78,
+    20, 95, 21, 54, 121, -55, -70, 83, -9, 54, 24, -78, -66, 31, -18, 64,
+    98, 57, -83, 22, 57, -24, 111, 7, 103, 127, -124, -127, 56, -88, -40, 46,
+    68, 53, 63, -77, -2, -21, -89, 34, -49, -70, -114, -42, -13, 43, -123, 96,
+    -68, -103, -82, 27, 2, 47, -101, -25, 85, -48, -111, -126, -79, -95, 84, -50,
+    31, -32, -66, -48, -81, 29, 104, -119, -13, 16, 19, 23, -23, -40, -26, 16,
+    -20, 32, -48, 80, -127, 4, -32, -44, -20, -55, -68, 45, 38, -31, -79, -8,
+    117, -111, -65, 48, 14, -4, -35, 26, 72, -33, 106, 39, -31, 91, -40, 17,
+    -13, -124, -104, -56, -29, 21, -49, 97, -127, -30, -5, 101, -51, 33, -116, -66,
+    5, -46, -71, -1, 6, 112, -35, -30, -74, -2, 3, 12, -67, 57, -26, -15,
+    63, 31, 75, 13, 73, 28, 3, -60, 1, 31, -68, -4, -14, -9, 56, 8,
+    35, 127, 57, -7, -10, 36, 41, -33, 35, -24, -24, -18, -12, 7, 67, 28,
+    37, -20, -60, 38, 44, -59, 78, -4, -89, 68, 52, 4, -1, 71, 95, 108,
+    64, -75, -99, -35, -66, -102, -100, 16, -44, 74, 67, 59, -117, -127, -65, -51,
+    69, 98, 24, 89, 28, 55, -25, 119, 71, 23, -41, -69, -74, 66, -68, -48,
+    29, 127, 31, 82, 24, -18, 73, 37, -30, 0, -57, -59, 69, -54, 76, -54,
+    -27, 8, -86, 44, 29, -91, 17, -44, -37, 27, 66, 105, 20, 21, 73, -56,
+    8, 66, -8, -101, -103, -80, -63, -111, 58, 64, 110, 42, -87, -92, -95, -78,
+    -34, -88, -16, -54, -5, 127, -31, 88, 38, 20, 46, -9, 14, 17, 4, -46,
+    15, -30, 107, -47, -29, -72, 49, 17, 17, 39, -74, -123, 98, 127, -69, -92,
+    -56, 57, -80, -121, -84, 105, -99, 54, 66, -51, -19, -93, -93, -50, 112, 122,
+    108, -67, 115, -47, -61, -51, 32, -72, 95, -2, 76, -89, 69, 118, -46, 16,
+    54, -39, 109, 62, 107, 102, 19, -30, -59, -54, 49, 51, 39, 40, 127, 96,
+    59, -37, 106, 41, -6, -14, 52, 15, -60, 45, -47, 57, 14, 52, 31, 106,
+    -37, -55, -73, 101, -15, 100, -19, -62, 45, 44, 77, -13, -29, 79, -74, -21,
+    18, -55, 19, 88, 30, 20, 74, -8, -9, 54, -24, 4, 49, 70, 17, 72,
+    55, 90, 112, -27, 42, 60, 14, 19, -78, -3, -7, -6, 92, 87, 59, 127,
+};
+static constexpr int32_t behavior_model_l0_bias[16] = {
+    4848, 14690, 16964, 3533, 0, 5107, -11425, 26438, 1232, 19433, -5208, -203, 2887, 0, 7817, 2794,
+};
+static constexpr int32_t behavior_model_l0_mult[16] = {
+    1500126908, 2098419647, 1149717697, 1629483715, 1502749186, 1862768292, 1508420862, 1245090393, 1475560004, 1469316954, 1470349611, 1090986073, 1097049901, 1447998988, 1885075481, 1191866495,
+};
+static constexpr int8_t behavior_model_l0_shift[16] = {
+    -11, -11, -10, -10, -11, -11, -11, -10, -11, -10, -11, -10, -10, -11, -11, -10,
+};
+
+static constexpr int8_t behavior_model_l1_weights[768] = {
+    -26, -14, -15, -121, 23, 5, 55, 95, 3, -46, 0, -10, -45, 18, -56, 20,
+    8, 56, 101, 2, 52, -26, -52, 107, -42, 76, 48, -47, 36, -52, -49, 38,
+    -21, -24, 83, -127, 43, 63, 2, 64, 39, 23, 50, -8, -10, 50, 5, 0,
+    127, 57, 36, -105, 79, 9, 49, 40, -46, 14, -74, -60, -90, -2, 49, -94,
+    6, 50, 95, 44, -69, -62, 43, 81, 44, 36, 45, -94, -74, 19, -36, -24,
+    -3, 60, 43, 0, -32, 73, -73, -34, -17, 92, 1, 17, -94, 13, 78, -84,
+    -49, 79, -6, 73, 45, 36, 40, -121, -11, -5, -24, 78, 15, -12, -33, 22,
+    30, 97, -41, 95, -4, -58, 51, -115, -8, 21, 19, 51, -17, 54, -47, -63,
+    -58, 114, -102, 127, -57, 20, -65, -119, 25, 30, 74, -6, 103, -52, 61, -28,
+    -14, 71, -107, 32, 58, 41, 127, -81, -22, 20, 38, -83, -119, 3, 26, -23,
+    -54, -28, -92, 68, 109, 5, 64, -53, 70, -88, 7, -106, 56, 53, -67, 29,
+    -73, -97, -60, -58, 15, 110, 83, -23, 19, 20, -81, 87, -11, 3, 34, -69,
+    -115, 14, -8, -23, 4, 20, -71, -25, 1, 27, -93, -103, -107, 11, 25, 98,
+    -119, -126, 59, 2, 113, -101, 62, -6, 83, -12, 62, 10, -39, -123, -122, -3,
+    -120, -53, -51, 49, -26, 58, 67, 3, 64, -127, -37, 113, -54, 105, -13, 107,
+    -111, 6, -2, 89, 2, 22, -48, -98, 85, -34, -123, 107, 91, -57, -70, -113,
+    -12, -37, -40, -63, -108, -15, 127, 89, 47, -24, 79, -91, -61, 26, 12, -37,
+    32, -4, -18, -65, 41, 8, 90, 122, -19, -104, 89, -30, -40, -94, -100, -37,
+    54, 39, 86, -88, 35, 1, 68, -34, -13, 80, -75, -23, -33, -71, 45, -45,
+    113, -20, 36, -86, -60, -92, -70, 29, 71, 111, 57, 31, -112, -40, 39, 43,
+    38, 127, 13, -7, 82, 11, -40, 114, -67, 60, -16, -97, -44, -67, -56, 61,
+    -32, 118, 27, 72, 43, -37, 44, -49, 18, 50, -57, 36, 89, -12, -13, -110,
+    -12, 114, -32, 25, -71, -80, 46, -35, 7, 68, 0, 43, 32, -66, -51, -48,
+    15, 78, -27, -30, 26, -46, 74, -15, -55, 83, 84, 60, 104, -6, -100, -127,
+    53, 77, -53, 98, -38, 35, -13, -38, 37, 94, -34, 24, -40, 11, 98, -17,
+    -63, 34, 36, 82, -27, -47, -5, 114, -10, 127, -67, 34, -26, 70, -62, 83,
+    -26, 42, 72, 120, 30, -78, 3, 46, 19, 110, 46, 50, 39, -73, 53, 114,
+    -122, 38, 110, 7, 84, -20, 112, -19, 121, 114, 52, -95, -18, 34, -103, -45,
+    67, 85, -40, 16, -108, 120, 68, 79, 45, -108, -72, 16, -120, 111, 45, 116,
+    -40, 80, 7, -66, 34, 28, 98, -92, -2, 0, 17, -115, -47, 79, 127, 86,
+    -68, 127, -59, 93, -50, -85, 37, 24, -27, 86, 86, 50, 35, 9, -88, -17,
+    51, 71, 62, 125, 37, 47, -22, -76, 8, 15, -19, -41, 82, -11, 3, 12,
+    70, -39, -77, -36, -68, -87, 14, -113, -74, -8, -61, -73, 23, 80, -25, 69,
+    -38, -73, -70, 86, -34, -23, -28, 68, -6, 100, -50, 110, 88, 28, -72, 34,
+    -31, -51, -104, -56, -32, 51, -47, -81, 27, 81, -81, -50, -11, 22, -80, -127,
+    89, 10, -91, 26, -89, 15, 12, 43, -11, -25, 112, -16, 118, 69, -105, 46,
+    -49, -2, 17, 116, 77, 35, 25, -127, 62, 31, 73, 33, -8, -69, -20, 85,
+    33, 45, -89, 76, -13, 72, 61, -74, -48, 47, -24, 14, -67, 40, 15, -31,
+    -49, -10, -65, 87, -59, 27, 49, 27, -88, 55, 43, 51, -50, 0, -8, 59,
+    -86, -95, 20, 118, -41, -43, -8, -39, -45, -18, -36, -5, -43, -46, 32, 61,
+    16, 41, -37, 127, 75, 79, -65, 43, -5, -78, -89, -69, 60, 41, -57, 37,
+    -44, -17, 12, 116, 12, -23, -52, 18, 6, -79, -61, -12, 7, -49, -13, 107,
+    47, 62, -42, 127, -63, 26, -46, -46, 11, 13, -12, 86, 75, -1, 15, -95,
+    -28, -41, -93, 111, -52, -12, 65, -87, -89, 66, -2, 85, 1, -7, -15, 8,
+    9, 74, -78, 60, 58, -84, 69, 29, 74, 72, -15, 5, 85, -52, -6, -95,
+    -119, 34, 69, 103, 30, 86, -90, 17, 91, -89, -108, -95, -102, -53, -56, 52,
+    65, -127, -54, 103, -95, 103, -67, -17, -70, -65, 70, -16, 9, 63, -28, 11,
+    63, -68, -12, 121, -28, -10, -21, 26, 40, 74, -107, -23, -51, 97, 42, 74,
+};
+static constexpr int32_t behavior_model_l1_bias[16] = {
+    1229, 2181, -627, -173, -82, -2413, 1764, 1519, 1558, -204, 610, -268, -1439, -710, 1766, -972,
+};
+static constexpr int32_t behavior_model_l1_mult[16] = {
+    1321727365, 1957800536, 1261516351, 1350568907, 1368801600, 1310192810, 1983270404, 2097093698, 1918983130, 1347888570, 1805523070, 1669704594, 2063942845, 1088924490, 1936395513, 1751930670,
+};
+static constexpr int8_t behavior_model_l1_shift[16] = {
+    -8, -9, -8, -9, -9, -9, -9, -9, -9, -9, -9, -9, -9, -8, -9, -9,
+};
+
+static constexpr int8_t behavior_model_l2_weights[1536] = {
+    -73, -88, 74, -64, -30, 83, -56, 46, 50, -7, -6, -27, -49, 74, -47, -58,
+    -25, -85, 56, -66, 42, 25, -112, -80, -1, -18, -6, 51, 70, -19, -18, -7,
+    65, -95, 21, 74, 47, -15, 17, 56, 80, 41, 0, 69, -51, -28, 27, -61,
+    -41, -82, 127, 39, -65, -36, -55, 23, 6, 80, 41, 40, -51, -14, -11, 81,
+    12, 70, -80, -89, 28, 8, 64, -23, 114, 62, -34, 32, -31, 1, -38, 51,
+    60, 75, 34, 89, 21, -5, 23, 10, 127, 33, 73, 13, 4, -43, 26, 88,
+    39, 56, -75, 16, -12, -76, 57, 64, -14, -74, 76, -111, -74, 69, -56, 110,
+    -26, 78, -102, 23, 51, 63, 60, -18, 101, 77, 53, 21, -9, -29, -51, 22,
+    -34, -47, 124, -31, 44, -47, -89, 50, 67, -41, -22, -19, 58, 51, 36, -68,
+    -10, -54, 56, 49, -61, -48, -82, 89, 98, -20, 59, 75, 87, -47, 102, 1,
+    -78, -8, 127, 53, 61, -40, 34, 28, 87, -73, 93, 2, 23, 3, 81, 9,
+    -105, 41, 75, -53, 35, 56, 51, 87, 15, 62, 92, 25, 87, 21, 63, 62,
+    66, -10, 38, -92, -27, -69, 67, 52, 17, -80, 23, 16, 13, -78, -112, -102,
+    68, 125, 0, -1, -9, -11, 15, 106, -36, 79, -39, -47, -121, 41, 58, 78,
+    109, 40, -93, -15, 21, -1, -20, 74, -54, -1, 89, 13, 41, 38, 77, 12,
+    -22, 75, -22, 55, -22, -53, 127, 27, 114, -19, -17, 46, -95, 43, 49, -26,
+    23, 84, -103, 44, 57, 53, 43, 88, 103, -7, -35, -33, -92, -89, -75, 44,
+    29, -8, -78, -38, 41, -20, 127, 98, -3, -63, 60, -32, -59, 44, -91, 23,
+    46, 114, -99, -34, 7, 8, 68, 80, 82, -48, -33, -49, -33, -15, -11, -44,
+    110, 58, -76, 27, -70, 51, 71, 18, 90, 61, -58, 23, 37, -28, -46, -22,
+    -41, 61, 60, 67, -52, 18, -29, -39, -65, 68, -74, 38, 99, -52, 30, 50,
+    -57, -68, 77, -32, -5, -55, -97, -65, 66, 108, -26, -13, -42, -125, 60, 37,
+    -6, 38, -89, 66, 95, 96, -126, -24, -108, 58, -127, -34, 50, 123, -98, -22,
+    98, -47, -118, -83, 113, -40, -9, 93, -101, -109, -111, -20, 67, 98, 57, 116,
+    15, 24, 80, 15, 101, 88, 42, 84, 11, 101, 40, 127, 62, -22, -22, -89,
+    -70, 45, -101, -52, 89, -36, 40, 97, -39, 31, 25, 103, -66, -30, 32, 63,
+    -58, 87, 36, 69, 73, 73, 45, 57, -5, 34, 3, 107, -101, -114, -94, 27,
+    28, 35, 27, -53, 26, 40, 57, 93, 30, 96, -88, 99, 57, 14, 15, 15,
+    66, 91, 94, 59, -2, 53, -31, -83, -96, 25, 9, 18, -42, -98, 74, 113,
+    95, 101, 27, 91, -24, -81, 4, 80, -112, -47, -24, 66, 32, -82, -120, 6,
+    61, 99, 98, -105, 7, -99, -2, -111, -94, -124, -109, 120, 108, -9, 55, 12,
+    -85, 95, -16, -7, -122, 40, 2, 118, -127, 38, 52, -65, -75, -79, -36, 68,
+    -127, 3, -23, 12, 27, -14, 28, 4, 5, 73, 16, 0, -13, -20, 11, -49,
+    -69, 31, 39, 53, -78, 56, 16, -49, 114, 62, 16, -19, 21, -58, 97, 39,
+    -125, 98, -7, 8, 19, 18, 62, 66, 63, -80, 8, -69, -17, 72, -1, -13,
+    -65, -21, 106, 58, 66, -90, 41, 65, -25, 57, 66, -28, -10, -18, 60, -40,
+    -41, 40, 5, 14, 76, 51, 14, 45, -58, 75, 15, -83, 71, -84, -67, -95,
+    -23, 80, 86, -35, -84, 26, -62, 32, -25, -14, -56, -72, 47, -116, -81, -4,
+    -65, 104, 127, 3, 64, -19, 110, 6, 71, -12, 0, 81, 6, -60, -51, 21,
+    6, 100, 32, 4, 68, 7, 109, -79, -76, 28, 73, -56, 47, 22, -6, -19,
+    -112, -8, 48, -23, -78, -71, 4, 80, 99, 49, 105, -80, -21, -82, 107, -56,
+    -55, -56, 70, -1, -54, 50, -54, 127, 17, -44, -60, -60, -29, -68, 44, 2,
+    36, -5, -30, -66, -72, -73, 36, -13, 24, -36, 57, 58, -59, -56, 43, -52,
+    45, -14, -50, 33, -52, 79, -108, 34, 50, 31, -63, -19, -19, -29, 100, 33,
+    16, 68, 127, -72, 34, 46, -50, -33, 111, -52, 89, 92, 106, -63, 85, 28,
+    -98, 8, 111, 67, 99, 90, -27, -41, -78, -19, -74, -46, 27, -113, 123, -79,
+    -76, 69, 94, 14, 107, 9, -98, 31, -22, -77, -10, 110, 84, 23, 8, -12,
+    -113, 86, 41, -9, -64, -22, -95, 122, 66, -94, 80, 12, 86, -74, 29, -110,
+    71, 47, -104, -71, 50, 70, -96, 16, 36, -44, 4, -37, 43, -2, -63, 17,
+    -87, -50, -115, -50, -74, 12, 32, 105, 51, 68, -6, -39, -90, 59, 13, -8,
+    -48, -34, -127, 44, -37, 87, 2, 48, 123, 8, 93, -61, 10, 100, 84, -45,
+    -52, -102, -48, 78, 90, 95, -44, -43, 77, -1, -69, 21, -96, 25, 56, 108,
+    56, -52, -6, 76, 26, -34, 86, -57, -44, 96, 27, 46, 90, -63, -14, -88,
+    112, 45, 110, -98, -34, -88, 95, -41, 81, -85, -30, 18, 79, -123, -52, 16,
+    -6, -51, 16, 80, 14, -98, 2, 16, 94, 114, -110, -115, 2, -59, -127, 98,
+    58, -16, 21, -67, -37, -28, 124, -88, 56, 17, -86, 27, 34, 36, -45, 20,
+    -24, -37, 54, -55, -74, 32, -30, 58, -49, -20, 37, -114, 65, 14, -70, -90,
+    -57, 14, -102, 100, -79, 116, -90, -116, 16, 51, -54, -107, -112, 89, 99, 75,
+    127, -1, -25, -110, -111, -87, -112, 18, 52, 35, 102, -38, -75, 0, 115, 50,
+    81, 46, 40, -71, -126, -118, 8, 95, -125, 32, -19, -109, -56, -74, 22, 40,
+    -87, -25, 76, 68, -65, -84, 22, 100, -57, 49, 86, -9, 30, 27, 48, -74,
+    5, -86, -18, -4, 20, -41, 7, 108, -19, -64, 91, -1, 27, -16, 93, -14,
+    -68, 70, 50, 71, 44, -55, -50, 127, -91, 65, 44, -32, -22, -4, 66, -17,
+    -51, -11, 96, 35, 62, -11, -11, 25, -21, -57, 11, 91, -103, -30, 48, -101,
+    -4, -120, 8, -121, 87, 103, -22, 121, -99, 69, -85, 39, -59, 97, 61, 23,
+    -72, -127, -6, -58, 101, 51, -80, -23, -88, -36, 62, -107, 102, -95, 117, -45,
+    23, -104, 76, 8, 34, 119, -107, 70, 88, 84, -3, -39, -36, 98, -55, 110,
+    57, -17, 74, -3, -80, 48, -27, -4, -115, -49, 47, 71, 3, -85, 29, 35,
+    41, -6, -80, -25, -55, -65, -15, -61, 94, -26, -36, -63, -42, 51, 68, 83,
+    -8, -2, -62, -76, -36, -41, -47, -50, 9, 17, 77, -66, 101, 84, 69, 33,
+    -8, -49, -20, 7, 75, 53, 31, 10, 92, 37, -72, -75, 67, 33, -54, 121,
+    73, -34, -3, 59, -61, 48, -84, -96, 93, -37, -1, 57, 8, 127, -81, 114,
+    -63, -100, -73, -13, 41, 64, -90, 65, 119, -87, -94, -36, -93, 33, -50, 4,
+    -20, 21, -65, 26, -71, 100, 49, 109, 85, -98, 13, -5, -60, 72, -91, -33,
+    -21, 89, -12, 8, 126, -17, 12, -91, -98, 114, 23, 124, -113, -114, -114, 103,
+    -127, -80, 29, -48, 39, -108, 29, -89, -100, -22, 27, 81, 123, -22, 103, -9,
+    20, -27, 127, 68, -13, -64, 32, -38, -37, 7, 6, -58, 115, 8, 21, 100,
+    -21, 60, 68, 5, -43, 87, 29, -95, -22, 67, 48, 8, 99, 119, -74, -5,
+    61, 4, 53, 63, 60, 27, 34, -107, -18, 0, 80, -20, 19, 95, 52, 9,
+    6, -99, 4, -43, 75, 22, -47, -52, 16, 50, -36, -27, 92, 96, 55, 40,
+    -52, 24, -36, 27, -80, 70, 45, -120, -61, 74, -57, -72, 99, 66, 10, -47,
+    90, 7, 127, 5, -40, 8, -55, 26, 70, 93, -6, -32, 103, 66, -32, 42,
+    -45, 60, -7, 80, 77, 45, 59, -12, -76, 21, 44, 27, 53, 107, 2, -58,
+    88, 90, 10, -30, 9, 74, -47, -98, 89, -21, -3, -66, -44, 15, -56, 30,
+    -117, -99, 58, 73, 29, -115, -17, -28, 99, 7, -53, 37, -87, 81, 59, 82,
+    40, -55, 71, 70, -17, 127, 51, 0, -102, -54, -108, -59, -122, -110, -28, 18,
+    -42, -126, -123, -109, 90, 13, 20, -124, -75, -105, 114, -23, 118, -79, 17, 98,
+    1, 111, -110, -74, -122, -111, 54, 82, 25, -35, 90, -55, -95, -82, 74, 35,
+    48, 9, -36, 34, 49, -2, -18, -92, 79, 57, -17, -60, -57, 22, -114, 27,
+    59, 19, 59, -50, -27, -8, 18, -67, 55, -1, -69, 53, 11, 71, 37, -44,
+    78, 26, 14, -80, 45, 32, 79, -90, -31, 2, -70, -36, -1, 71, 15, -1,
+    127, 79, -86, -25, -71, -66, 125, -85, 21, 10, 27, -74, 9, 90, -38, 14,
+    -46, -19, -2, 23, 32, -14, -89, -26, 29, 16, 57, 55, 57, -35, -20, 6,
+    -72, 68, 125, -32, -78, 18, -30, -120, -46, 69, -20, 13, 5, -48, -18, -34,
+    -68, -58, 85, 94, -22, 71, -49, 58, 64, 44, 83, 77, 16, 71, 14, 93,
+    39, -42, 127, 70, -76, 88, 15, 42, 41, 6, -44, -75, 101, 111, -69, -51,
+};
+static constexpr int32_t behavior_model_l2_bias[24] = {
+    -648, 635, -368, 1380, 2649, 0, -113, -944, -493, -353, -696, 468, 123, 1152, -203, -44,
+    31, -350, 0, -685, -223, -830, 1414, -1863,
+};
+static constexpr int32_t behavior_model_l2_mult[24] = {
+    1974796535, 1778339523, 1136425338, 1629268504, 1115559832, 1279140254, 1605552793, 1333180676, 1958418303, 1789989180, 1838908242, 1521398820, 1707265878, 1566074777, 1300685956, 1779272336,
+    1307283592, 2007480094, 1295069170, 1793299867, 1809314813, 1296666178, 2003785827, 1727824601,
+};
+static constexpr int8_t behavior_model_l2_shift[24] = {
+    -10, -10, -9, -10, -9, -10, -10, -10, -10, -10, -10, -10, -10, -10, -10, -10,
+    -10, -10, -10, -10, -10, -10, -10, -10,
+};
+
+static constexpr int8_t behavior_model_l3_weights[144] = {
+    9, 31, -127, 20, 82, 20, 23, -27, -67, 34, -23, -1, -49, 66, 28, -4,
+    -25, -9, 27, -19, 29, -30, 90, -38, -124, 71, 97, -17, 74, 20, 65, 73,
+    91, 92, 103, 113, -50, 25, 78, 72, -59, -96, 12, -127, -48, 43, -68, -90,
+    -7, 40, 65, 17, -127, -45, -6, 17, 95, 99, 63, 50, -41, 36, -35, -43,
+    -63, -55, 63, 25, 59, 75, -45, 61, 80, -127, 88, -20, -105, -37, 84, 67,
+    -67, -3, 98, 84, 25, -72, 38, 69, 49, -98, 78, -20, -16, -50, -78, 44,
+    -51, 101, -21, 92, 127, -53, 11, 34, 41, -70, 102, -71, 114, -35, 35, -79,
+    -6, 7, 72, -25, -89, -1, -38, -54, 6, 29, 65, -86, -50, 23, -46, 44,
+    -6, -44, 13, 19, 54, -7, -36, -84, -8, 127, -63, 76, 56, -32, 22, 23,
+};
+static constexpr int32_t behavior_model_l3_bias[6] = {
+    187, 101, -185, -153, 240, -286,
+};
+static constexpr int32_t behavior_model_l3_mult[6] = {
+    1859362688, 1728705474, 1164736638, 1107919660, 1211462165, 1196302384,
+};
+static constexpr int8_t behavior_model_l3_shift[6] = {
+    -8, -9, -8, -8, -8, -8,
+};
+
+static constexpr behavior_layer_t behavior_model_layers[] = {
+    {BEHAVIOR_LAYER_CONV1D, 3, 8, 13, 16, -128, -128, -128, behavior_model_l0_weights, behavior_model_l0_bias, behavior_model_l0_mult, behavior_model_l0_shift},
+    {BEHAVIOR_LAYER_CONV1D, 3, 6, 16, 16, -128, -128, -128, behavior_model_l1_weights, behavior_model_l1_bias, behavior_model_l1_mult, behavior_model_l1_shift},
+    {BEHAVIOR_LAYER_DENSE, 0, 4, 16, 24, -128, -128, -128, behavior_model_l2_weights, behavior_model_l2_bias, behavior_model_l2_mult, behavior_model_l2_shift},
+    {BEHAVIOR_LAYER_DENSE, 0, 1, 24, 6, -128, -3, -128, behavior_model_l3_weights, behavior_model_l3_bias, behavior_model_l3_mult, behavior_model_l3_shift},
+};
+
+static constexpr behavior_model_t behavior_model = {behavior_model_layers, 4, 8, behavior_model_in_gain,
+                                                    0x0f0f, -128};
+
+#endif /* BEHAVIOR_MODEL_H */
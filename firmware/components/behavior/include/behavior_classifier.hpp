@@ -0,0 +1,170 @@
+// behavior_classifier.hpp
+#ifndef BEHAVIOR_CLASSIFIER_H
+#define BEHAVIOR_CLASSIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "behavior_features.hpp"
+
+/**
+ * On-collar behavior classifier: a small int8 quantized network (conv1d and
+ * dense layers) over the last few feature vectors of behavior_feature_engine,
+ * so the collar reports one class per hop instead of streaming raw samples
+ * to the phone.
+ *
+ * Arithmetic is the TFLite int8 scheme: int8 activations with a zero point,
+ * symmetric per output channel int8 weights, int32 bias and accumulators, and
+ * requantization by a Q31 multiplier and a shift with the same rounding as
+ * gemmlowp. Integer only past the input quantization, so the host runs the
+ * same kernels bit for bit (host/test/behavior_classifier_test.cpp checks
+ * them against a separate reference).
+ *
+ * Weights are constexpr tables in behavior_model.hpp, generated by
+ * host/tools/behavior_train. Activations live in one statically allocated
+ * arena of BEHAVIOR_ARENA_BYTES, nothing is allocated; inference runs in one
+ * task at a time.
+ */
+
+#ifndef BEHAVIOR_ARENA_BYTES
+#define BEHAVIOR_ARENA_BYTES 256  ///< two activation buffers used in turn, the largest tensor must fit in half
+#endif
+
+/// @brief Classes in the order of the model's outputs
+typedef enum behavior_class_t : uint8_t {
+    BEHAVIOR_SLEEPING,
+    BEHAVIOR_WALKING,
+    BEHAVIOR_RUNNING,
+    BEHAVIOR_SCRATCHING,
+    BEHAVIOR_EATING,
+    BEHAVIOR_SHAKING,
+    BEHAVIOR_CLASS_COUNT
+} behavior_class_t;
+
+const char *behavior_class_to_str(behavior_class_t cls);
+
+typedef enum behavior_layer_type_t : uint8_t {
+    BEHAVIOR_LAYER_CONV1D,   ///< stride 1, no padding: out_len = in_len - kernel + 1
+    BEHAVIOR_LAYER_DENSE,    ///< over the whole input flattened, out_len = 1
+} behavior_layer_type_t;
+
+/**
+ * @brief One quantized layer, tensors are [len][channels] (time major)
+ * @param kernel: conv1d taps, ignored for dense
+ * @param in_zp: input zero point, real = in_scale * (q - in_zp)
+ * @param out_zp: output zero point
+ * @param act_min: output clamp, out_zp for a fused ReLU, -128 without
+ * @param weights: [out_ch][kernel][in_ch] for conv1d, [out_ch][in_len * in_ch] for dense
+ * @param bias: per output channel, scale in_scale * weight_scale[c], zero point 0
+ * @param mult: per output channel requantization multiplier, Q31, from in_scale * weight_scale[c] / out_scale
+ * @param shift: per output channel exponent of that multiplier, negative shifts right
+ */
+typedef struct behavior_layer_t {
+    behavior_layer_type_t type;
+    uint8_t kernel;
+    uint16_t in_len;
+    uint16_t in_ch;
+    uint16_t out_ch;
+    int32_t in_zp;
+    int32_t out_zp;
+    int32_t act_min;
+    const int8_t *weights;
+    const int32_t *bias;
+    const int32_t *mult;
+    const int8_t *shift;
+} behavior_layer_t;
+
+/**
+ * @brief A quantized model
+ * @param layers: in order, the last one gives BEHAVIOR_CLASS_COUNT logits
+ * @param in_len: feature vectors per inference, oldest first
+ * @param in_gain: per feature, q = round(x * in_gain) + in_zp saturated to int8
+ * @param in_sqrt: bit f set when feature f goes through sqrt first (energies and variances, to the amplitude domain)
+ * @param in_zp: input zero point, also layers[0].in_zp
+ */
+typedef struct behavior_model_t {
+    const behavior_layer_t *layers;
+    size_t n_layers;
+    uint16_t in_len;
+    const float *in_gain;
+    uint32_t in_sqrt;
+    int32_t in_zp;
+} behavior_model_t;
+
+/// @brief Output length in time steps of a layer
+constexpr size_t behavior_layer_out_len(const behavior_layer_t &layer)
+{
+    return layer.type == BEHAVIOR_LAYER_DENSE ? 1 : layer.in_len - layer.kernel + 1;
+}
+
+/// @brief Compiled in model (behavior_model.hpp)
+const behavior_model_t &behavior_default_model();
+
+/// @brief Quantize one feature vector to the model's input, BEHAVIOR_F_COUNT values
+void behavior_quantize_input(const behavior_model_t &model, const behavior_features_t &features, int8_t *q);
+
+/**
+ * @brief Run one layer
+ * @param in: in_len x in_ch input
+ * @param out: out_len x out_ch output, must not overlap in
+ */
+void behavior_layer_run(const behavior_layer_t &layer, const int8_t *in, int8_t *out);
+
+/**
+ * @brief Run a model on one quantized input in the static arena
+ * @param input: in_len x BEHAVIOR_F_COUNT values from behavior_quantize_input(), oldest first
+ * @param logits: BEHAVIOR_CLASS_COUNT outputs
+ * @return false if the layer shapes do not chain or a tensor does not fit the arena
+ */
+bool behavior_model_run(const behavior_model_t &model, const int8_t *input, int8_t *logits);
+
+/**
+ * @brief One classification
+ * @param t_us: timestamp of the newest feature vector
+ * @param cls: highest logit, the lower class on a tie
+ * @param margin: logit steps between the best and the runner up, 0 when close
+ * @param logits: raw int8 outputs
+ */
+typedef struct behavior_result_t {
+    uint32_t t_us;
+    behavior_class_t cls;
+    uint8_t margin;
+    int8_t logits[BEHAVIOR_CLASS_COUNT];
+} behavior_result_t;
+
+#ifndef BEHAVIOR_MAX_IN_LEN
+#define BEHAVIOR_MAX_IN_LEN 16    ///< feature vectors kept for the input window
+#endif
+
+/// @brief Feeds feature vectors to a model, one classification per vector once the input window has filled
+class behavior_classifier
+{
+    public:
+        /**
+        * @brief Select the model and clear the window
+        * @param model: nullptr for behavior_default_model()
+        * @return false if the model's in_len is 0 or above BEHAVIOR_MAX_IN_LEN, or it does not fit the arena
+        */
+        bool configure(const behavior_model_t *model = nullptr);
+
+        /// @brief Clear the window, the next result comes in_len vectors later
+        void reset();
+
+        /**
+        * @brief Add the next feature vector
+        * @param out: set when the window is full
+        * @return true if out holds a new classification
+        */
+        bool push(const behavior_features_t &features, behavior_result_t &out);
+
+        uint32_t inferences() const { return n_inferences; }
+
+    private:
+        const behavior_model_t *model = nullptr;
+        int8_t window[BEHAVIOR_MAX_IN_LEN][BEHAVIOR_F_COUNT] = {};   ///< ring of quantized vectors
+        size_t pos = 0;
+        size_t count = 0;
+        uint32_t n_inferences = 0;
+};
+
+#endif /* BEHAVIOR_CLASSIFIER_H */
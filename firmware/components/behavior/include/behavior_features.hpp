@@ -0,0 +1,168 @@
+// behavior_features.hpp
+#ifndef BEHAVIOR_FEATURES_H
+#define BEHAVIOR_FEATURES_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "imu_driver.hpp"
+#include "imu_dsp.hpp"
+
+/**
+ * Windowed features for classifying pet behavior on the collar, in place of
+ * SH2_PERSONAL_ACTIVITY_CLASSIFIER which is tuned for people. Accel, gyro and
+ * a rotation vector are followed over a sliding window of BEHAVIOR_WINDOW
+ * accel samples; every hop accel samples the engine emits one feature vector.
+ *
+ * Per sample work is O(1): windowed sums are updated by adding the new sample
+ * and dropping the oldest (recomputed from the window once per window so
+ * float rounding cannot drift). Per hop the only whole-window step is the
+ * BEHAVIOR_WINDOW point real FFT of |accel| for the dominant frequency.
+ *
+ * The accel report drives the window; gyro and rotation vector samples update
+ * their state as they are drained, at the same rate as accel. One task per
+ * engine, no allocation.
+ */
+
+#ifndef BEHAVIOR_WINDOW
+#define BEHAVIOR_WINDOW 128       ///< samples per window and FFT size, a power of 2 (1.28 s at 100 Hz)
+#endif
+
+static_assert(BEHAVIOR_WINDOW >= 8 && (BEHAVIOR_WINDOW & (BEHAVIOR_WINDOW - 1)) == 0,
+              "BEHAVIOR_WINDOW must be a power of 2");
+static_assert(BEHAVIOR_WINDOW <= IMU_DSP_MAX_WINDOW, "BEHAVIOR_WINDOW is above IMU_DSP_MAX_WINDOW");
+
+/// @brief Index of each value in behavior_features_t::v
+typedef enum behavior_feature_id_t : uint8_t {
+    BEHAVIOR_F_ACC_ENERGY,     ///< mean |dynamic accel|^2 (gravity removed), (m/s^2)^2
+    BEHAVIOR_F_ACC_VAR_X,      ///< accel variance per axis, (m/s^2)^2
+    BEHAVIOR_F_ACC_VAR_Y,
+    BEHAVIOR_F_ACC_VAR_Z,
+    BEHAVIOR_F_ACC_DOM_HZ,     ///< dominant frequency of |accel|, Hz
+    BEHAVIOR_F_ACC_DOM_SHARE,  ///< share of the |accel| spectrum power around the dominant frequency, 0..1
+    BEHAVIOR_F_ACC_ZCR_HZ,     ///< zero crossings of dynamic accel per second, mean over the axes
+    BEHAVIOR_F_ACC_JERK,       ///< mean |d accel / dt|, m/s^3
+    BEHAVIOR_F_GYRO_ENERGY,    ///< mean |gyro|^2, (rad/s)^2
+    BEHAVIOR_F_GYRO_VAR_X,     ///< gyro variance per axis, (rad/s)^2
+    BEHAVIOR_F_GYRO_VAR_Y,
+    BEHAVIOR_F_GYRO_VAR_Z,
+    BEHAVIOR_F_ORIENT_CHANGE,  ///< rotation between the first and last rotation vector of the window, rad
+    BEHAVIOR_F_COUNT
+} behavior_feature_id_t;
+
+const char *behavior_feature_to_str(behavior_feature_id_t id);
+
+/**
+ * @brief One feature vector
+ * @param t_us: timestamp of the last accel sample of the window
+ * @param v: values indexed by behavior_feature_id_t
+ */
+typedef struct behavior_features_t {
+    uint32_t t_us;
+    float v[BEHAVIOR_F_COUNT];
+} behavior_features_t;
+
+/**
+ * @brief Feature engine configuration
+ * @param fs_hz: rate of the accel, gyro and rotation vector reports
+ * @param hop: accel samples between vectors, at least 8 and dividing BEHAVIOR_WINDOW (32: 3.1 vectors/s at 100 Hz)
+ * @param accel_rpt: accel report driving the window, with gravity (SH2_ACCELEROMETER)
+ * @param gyro_rpt: gyro report, 0 leaves the gyro features at 0
+ * @param rv_rpt: rotation vector report, 0 leaves BEHAVIOR_F_ORIENT_CHANGE at 0
+ * @param gravity_fc_hz: corner of the gravity removal for the dynamic accel features
+ * @param zcr_deadband_ms2: dynamic accel must pass +- this to count as a crossing, keeps noise out
+ */
+typedef struct behavior_features_config_t {
+    float fs_hz = 100.0f;
+    uint16_t hop = 32;
+    uint8_t accel_rpt = SH2_ACCELEROMETER;
+    uint8_t gyro_rpt = SH2_GYROSCOPE_CALIBRATED;
+    uint8_t rv_rpt = SH2_ROTATION_VECTOR;
+    float gravity_fc_hz = 0.3f;
+    float zcr_deadband_ms2 = 0.15f;
+} behavior_features_config_t;
+
+class behavior_feature_engine
+{
+    public:
+        /**
+        * @brief Validate and store the configuration and clear the windows
+        * @return false if hop is below 8 or does not divide BEHAVIOR_WINDOW, or a rate is out of range
+        */
+        bool configure(const behavior_features_config_t &config);
+
+        /// @brief Clear the windows, the next vector comes a whole window later
+        void reset();
+
+        /**
+        * @brief Add one drained sample, reports other than the configured three are ignored
+        * @param out: set when the sample completes a hop
+        * @return true if out holds a new vector
+        */
+        bool push(const imu_sample_t &sample, behavior_features_t &out);
+
+        /**
+        * @brief Add drained samples in order
+        * @param out: new vectors
+        * @param max: capacity of out
+        * @param n_out: vectors written
+        * @return samples of in consumed, less than count when out filled up: call again with the rest
+        */
+        size_t push(const imu_sample_t *in, size_t count, behavior_features_t *out, size_t max, size_t &n_out);
+
+        uint32_t vectors() const { return n_vectors; }
+
+    private:
+        void add_accel(const imu_sample_t &sample);
+        void add_gyro(const imu_sample_t &sample);
+        void emit(behavior_features_t &out);
+        float dominant_frequency(float &share);
+
+        static constexpr size_t W = BEHAVIOR_WINDOW;
+        static constexpr size_t MIN_HOP = 8;
+
+        behavior_features_config_t cfg;
+
+        // accel window, one slot per sample at acc_pos
+        imu_dsp_gravity_hp gravity;
+        imu_dsp_moving_stats acc_stats;
+        float mag[W] = {};
+        float energy[W] = {};
+        float jerk[W] = {};
+        uint8_t crossings[W] = {};
+        float energy_sum = 0.0f;
+        float jerk_sum = 0.0f;
+        uint32_t crossing_sum = 0;
+        float last_acc[IMU_DSP_AXES] = {};
+        int8_t zc_sign[IMU_DSP_AXES] = {};
+        size_t acc_pos = 0;
+        size_t acc_count = 0;
+        uint32_t acc_t_us = 0;
+        uint16_t since_hop = 0;
+
+        // gyro window
+        imu_dsp_moving_stats gyro_stats;
+        float gyro_energy[W] = {};
+        float gyro_energy_sum = 0.0f;
+        size_t gyro_pos = 0;
+        size_t gyro_count = 0;
+
+        // rotation vector at each hop boundary, window start is W / hop boundaries back
+        float rv[4] = {1.0f, 0.0f, 0.0f, 0.0f};
+        bool have_rv = false;
+        float rv_hops[W / MIN_HOP + 1][4] = {};
+        size_t rv_hop_pos = 0;
+
+        // FFT tables and buffers: W / 2 point complex FFT plus the real split
+        float hann[W] = {};
+        float tw_re[W / 2] = {};
+        float tw_im[W / 2] = {};
+        uint16_t bitrev[W / 2] = {};
+        float fft_re[W / 2] = {};
+        float fft_im[W / 2] = {};
+        float power[W / 2 + 1] = {};
+
+        uint32_t n_vectors = 0;
+};
+
+#endif /* BEHAVIOR_FEATURES_H */
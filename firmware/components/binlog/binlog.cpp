@@ -0,0 +1,236 @@
+#include <atomic>
+#include <cstdio>
+
+#include "binlog.hpp"
+#include "binlog_ring.hpp"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+static constexpr const char *TAG = "BINLOG";
+
+static binlog_mpsc_ring<binlog_record_t, BINLOG_RING_CAPACITY> log_ring;
+static binlog_config_t log_cfg;
+static std::atomic<uint32_t> logged_cnt{0};
+static std::atomic<uint32_t> dropped_cnt{0};
+static std::atomic<uint32_t> dropped_pending{0};
+static uint32_t emitted_cnt = 0;
+static uint32_t high_water = 0;
+static bool header_written = false;
+static StaticTask_t task_buf;
+static StackType_t task_stack[BINLOG_TASK_STACK / sizeof(StackType_t)];
+
+bool binlog_push(const binlog_site_t *site, const uint32_t *args, uint8_t nargs) {
+    binlog_record_t record;
+    record.timestamp_us = static_cast<uint32_t>(esp_timer_get_time());
+    record.site = site;
+    record.nargs = nargs;
+    std::memcpy(record.args, args, nargs * sizeof(uint32_t));
+
+    // the gap is reported on the next record that makes it in, the common case is one relaxed load
+    uint32_t gap = dropped_pending.load(std::memory_order_relaxed);
+    if (gap != 0) {
+        gap = dropped_pending.exchange(0, std::memory_order_relaxed);
+    }
+    record.dropped_before = (gap > 0xFFFFU) ? 0xFFFFU : static_cast<uint16_t>(gap);
+
+    if (!log_ring.push(record)) {
+        dropped_pending.fetch_add(gap + 1, std::memory_order_relaxed);
+        dropped_cnt.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    logged_cnt.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+size_t binlog_render(const char *fmt, const uint32_t *args, uint8_t nargs, char *out, size_t out_sz) {
+    if (out == nullptr || out_sz == 0) {
+        return 0;
+    }
+
+    size_t len = 0;
+    uint8_t arg = 0;
+    out[0] = '\0';
+
+    auto append = [&](int written) {
+        if (written > 0) {
+            len += static_cast<size_t>(written);
+            if (len >= out_sz) {
+                len = out_sz - 1;
+            }
+        }
+    };
+
+    while (*fmt != '\0' && len < out_sz - 1) {
+        if (*fmt != '%') {
+            out[len++] = *fmt++;
+            out[len] = '\0';
+            continue;
+        }
+
+        if (fmt[1] == '%') {
+            out[len++] = '%';
+            out[len] = '\0';
+            fmt += 2;
+            continue;
+        }
+
+        // copy flags, width and precision, drop length modifiers: every argument is one 32 bit word
+        char spec[16];
+        size_t spec_len = 0;
+        spec[spec_len++] = *fmt++;
+        while (*fmt != '\0' && std::strchr("-+ #0123456789.", *fmt) != nullptr && spec_len < sizeof(spec) - 3) {
+            spec[spec_len++] = *fmt++;
+        }
+        while (*fmt != '\0' && std::strchr("hlLqjzt", *fmt) != nullptr) {
+            fmt++;
+        }
+
+        const char conv = *fmt;
+        if (conv == '\0') {
+            break;
+        }
+        fmt++;
+        spec[spec_len++] = conv;
+        spec[spec_len] = '\0';
+
+        const uint32_t word = (arg < nargs) ? args[arg] : 0;
+        arg++;
+
+        switch (conv) {
+            case 'd':
+            case 'i':
+            case 'c':
+                append(std::snprintf(out + len, out_sz - len, spec, static_cast<int>(static_cast<int32_t>(word))));
+                break;
+
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                append(std::snprintf(out + len, out_sz - len, spec, static_cast<unsigned>(word)));
+                break;
+
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A': {
+                float value;
+                std::memcpy(&value, &word, sizeof(value));
+                append(std::snprintf(out + len, out_sz - len, spec, static_cast<double>(value)));
+                break;
+            }
+
+            default:
+                // %s, %p: the argument never left the call site
+                append(std::snprintf(out + len, out_sz - len, "<%c?>", conv));
+                break;
+        }
+    }
+
+    return len;
+}
+
+static void binlog_emit_text(const binlog_record_t &record) {
+    if (record.dropped_before != 0) {
+        ESP_LOGW(TAG, "%u records dropped", static_cast<unsigned>(record.dropped_before));
+    }
+
+    char text[160];
+    binlog_render(record.site->fmt, record.args, record.nargs, text, sizeof(text));
+    ESP_LOG_LEVEL(record.site->level, record.site->tag, "[%lu] %s", (unsigned long)record.timestamp_us, text);
+}
+
+static void binlog_emit_binary(const binlog_record_t &record) {
+    if (log_cfg.write == nullptr) {
+        return;
+    }
+
+    if (!header_written) {
+        const uint32_t header[2] = {BINLOG_MAGIC, BINLOG_VERSION};
+        log_cfg.write(header, sizeof(header));
+        header_written = true;
+    }
+
+    uint8_t buf[12 + BINLOG_MAX_ARGS * sizeof(uint32_t)];
+    const uint16_t dropped = record.dropped_before;
+    const uint8_t level = static_cast<uint8_t>(record.site->level);
+    std::memcpy(&buf[0], &record.timestamp_us, 4);
+    std::memcpy(&buf[4], &record.site->fmt_id, 4);
+    buf[8] = level;
+    buf[9] = record.nargs;
+    std::memcpy(&buf[10], &dropped, 2);
+    std::memcpy(&buf[12], record.args, record.nargs * sizeof(uint32_t));
+    log_cfg.write(buf, 12 + record.nargs * sizeof(uint32_t));
+}
+
+size_t binlog_flush() {
+    const uint32_t queued = static_cast<uint32_t>(log_ring.size());
+    if (queued > high_water) {
+        high_water = queued;
+    }
+
+    binlog_record_t record;
+    size_t n = 0;
+    while (log_ring.pop(record)) {
+        if (log_cfg.sink == BINLOG_SINK_BINARY) {
+            binlog_emit_binary(record);
+        } else {
+            binlog_emit_text(record);
+        }
+        n++;
+    }
+
+    emitted_cnt += n;
+    return n;
+}
+
+static void binlog_task(void *pvParameters) {
+    const TickType_t period = pdMS_TO_TICKS(log_cfg.drain_period_ms) > 0 ? pdMS_TO_TICKS(log_cfg.drain_period_ms) : 1;
+    while (1) {
+        binlog_flush();
+        vTaskDelay(period);
+    }
+}
+
+bool binlog_start(const binlog_config_t &config) {
+    static bool started = false;
+    if (started) {
+        return true;
+    }
+
+    if (config.sink == BINLOG_SINK_BINARY && config.write == nullptr) {
+        ESP_LOGE(TAG, "Binary sink needs a write function");
+        return false;
+    }
+
+    log_cfg = config;
+    if (xTaskCreateStaticPinnedToCore(binlog_task, "binlog", BINLOG_TASK_STACK, nullptr, config.priority, task_stack,
+                                      &task_buf, config.core_id) == nullptr) {
+        ESP_LOGE(TAG, "Failed to create binlog task");
+        return false;
+    }
+
+    started = true;
+    return true;
+}
+
+binlog_stats_t binlog_get_stats() {
+    binlog_stats_t stats;
+    stats.logged = logged_cnt.load(std::memory_order_relaxed);
+    stats.dropped = dropped_cnt.load(std::memory_order_relaxed);
+    stats.emitted = emitted_cnt;
+    stats.high_water = high_water;
+    stats.capacity = BINLOG_RING_CAPACITY;
+    return stats;
+}
+
+void binlog_reset_stats() {
+    logged_cnt.store(0, std::memory_order_relaxed);
+    dropped_cnt.store(0, std::memory_order_relaxed);
+    emitted_cnt = 0;
+    high_water = 0;
+}
@@ -0,0 +1,185 @@
+// binlog.hpp
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+
+/**
+ * Deferred binary logging. BINLOG_x() in a hot path stores the call site and
+ * the raw argument words in a lock-free ring (no formatting, no UART); the
+ * binlog task formats them later at low priority, or streams the records in
+ * binary for binlog_decode on the host.
+ *
+ * Arguments are 32 bit words: integers up to 32 bits, enums and float/double
+ * (stored as float). Strings are not supported, put fixed text in the format.
+ * The format ID is the FNV-1a hash of the format literal, binlog_table
+ * regenerates the same IDs by scanning the sources.
+ *
+ * Binary stream (little endian):
+ *   file header: "BLG1" magic, uint32 version (1)
+ *   record:      uint32 timestamp_us, uint32 fmt_id, uint8 level, uint8 nargs,
+ *                uint16 dropped_before (saturating), nargs x uint32 args
+ */
+
+#ifndef BINLOG_MAX_ARGS
+#define BINLOG_MAX_ARGS 6
+#endif
+
+#ifndef BINLOG_RING_CAPACITY
+#define BINLOG_RING_CAPACITY 256
+#endif
+
+#ifndef BINLOG_TASK_STACK
+#define BINLOG_TASK_STACK 4096         ///< binlog task stack in bytes, statically allocated
+#endif
+
+/// @brief Levels above this are compiled out entirely
+#ifndef BINLOG_MAX_LEVEL
+#define BINLOG_MAX_LEVEL ESP_LOG_INFO
+#endif
+
+#define BINLOG_MAGIC 0x31474C42UL   ///< "BLG1"
+#define BINLOG_VERSION 1
+
+/// @brief One BINLOG_x() call site, lives in flash
+typedef struct binlog_site_t {
+    uint32_t fmt_id;
+    esp_log_level_t level;
+    const char *tag;
+    const char *fmt;
+} binlog_site_t;
+
+/// @brief One queued log call
+typedef struct binlog_record_t {
+    uint32_t timestamp_us;
+    const binlog_site_t *site;
+    uint8_t nargs;
+    uint16_t dropped_before;    ///< records lost to a full ring just before this one, saturating
+    uint32_t args[BINLOG_MAX_ARGS];
+} binlog_record_t;
+
+typedef enum binlog_sink_t : uint8_t {
+    BINLOG_SINK_TEXT,     ///< format on target and print through esp_log
+    BINLOG_SINK_BINARY,   ///< hand the binary stream to binlog_config_t::write, decode on the host
+} binlog_sink_t;
+
+/**
+ * @brief Binlog task configuration
+ * @param sink: text or binary output
+ * @param write: binary sink output (UART, file, USB), required for BINLOG_SINK_BINARY
+ * @param priority: task priority, keep it below every data path task
+ * @param core_id: core to pin the task to, tskNO_AFFINITY for either
+ * @param drain_period_ms: how often the task empties the ring
+ */
+typedef struct binlog_config_t {
+    binlog_sink_t sink = BINLOG_SINK_TEXT;
+    size_t (*write)(const void *data, size_t len) = nullptr;
+    UBaseType_t priority = 1;
+    BaseType_t core_id = tskNO_AFFINITY;
+    uint32_t drain_period_ms = 50UL;
+} binlog_config_t;
+
+/**
+ * @brief Logger counters
+ * @param logged: records queued
+ * @param dropped: records lost to a full ring
+ * @param emitted: records formatted or streamed by the consumer
+ * @param high_water: highest ring occupancy seen by the consumer
+ * @param capacity: ring slots
+ */
+typedef struct binlog_stats_t {
+    uint32_t logged;
+    uint32_t dropped;
+    uint32_t emitted;
+    uint32_t high_water;
+    uint32_t capacity;
+} binlog_stats_t;
+
+/// @brief FNV-1a of a format string, the format ID of its call site
+constexpr uint32_t binlog_fmt_id(const char *fmt, size_t len) {
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ static_cast<uint8_t>(fmt[i])) * 16777619UL;
+    }
+    return hash;
+}
+
+template <typename T>
+inline uint32_t binlog_word(T value) {
+    if constexpr (std::is_floating_point<T>::value) {
+        float f = static_cast<float>(value);
+        uint32_t word;
+        std::memcpy(&word, &f, sizeof(word));
+        return word;
+    } else if constexpr (std::is_enum<T>::value) {
+        return static_cast<uint32_t>(static_cast<typename std::underlying_type<T>::type>(value));
+    } else {
+        static_assert(std::is_integral<T>::value && sizeof(T) <= sizeof(uint32_t),
+                      "binlog arguments must be integers up to 32 bits, enums or floats");
+        return static_cast<uint32_t>(value);
+    }
+}
+
+/**
+* @brief Queue one record, use the BINLOG_x() macros instead
+* @return false if the ring was full
+*/
+bool binlog_push(const binlog_site_t *site, const uint32_t *args, uint8_t nargs);
+
+template <typename... Args>
+inline void binlog_write(const binlog_site_t *site, Args... args) {
+    static_assert(sizeof...(Args) <= BINLOG_MAX_ARGS, "too many binlog arguments");
+    const uint32_t words[sizeof...(Args) + 1] = {binlog_word(args)...};
+    binlog_push(site, words, static_cast<uint8_t>(sizeof...(Args)));
+}
+
+#define BINLOG_LEVEL(level, tag, fmt, ...)                                                            \
+    do {                                                                                              \
+        if constexpr ((level) <= BINLOG_MAX_LEVEL) {                                                  \
+            static const binlog_site_t binlog_site_ = {binlog_fmt_id(fmt, sizeof(fmt) - 1), (level), \
+                                                       (tag), (fmt)};                                 \
+            binlog_write(&binlog_site_, ##__VA_ARGS__);                                               \
+        }                                                                                             \
+    } while (0)
+
+#define BINLOG_E(tag, fmt, ...) BINLOG_LEVEL(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define BINLOG_W(tag, fmt, ...) BINLOG_LEVEL(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define BINLOG_I(tag, fmt, ...) BINLOG_LEVEL(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define BINLOG_D(tag, fmt, ...) BINLOG_LEVEL(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+#define BINLOG_V(tag, fmt, ...) BINLOG_LEVEL(ESP_LOG_VERBOSE, tag, fmt, ##__VA_ARGS__)
+
+/**
+* @brief Start the low priority task that empties the ring
+* @param config: sink and task settings, copied
+* @return true once started, repeated calls are no-ops
+*/
+bool binlog_start(const binlog_config_t &config = binlog_config_t());
+
+/**
+* @brief Empty the ring in the calling task, the binlog task does this periodically
+* @return number of records emitted
+* @note Single consumer: do not call concurrently with a running binlog task
+*/
+size_t binlog_flush();
+
+/**
+* @brief Render a format with binlog argument words, shared by the target text sink and binlog_decode
+* @param fmt: printf style format, length modifiers are ignored
+* @param args: argument words
+* @param nargs: number of words
+* @param out: destination buffer, always terminated
+* @param out_sz: capacity of out
+* @return number of characters written
+*/
+size_t binlog_render(const char *fmt, const uint32_t *args, uint8_t nargs, char *out, size_t out_sz);
+
+binlog_stats_t binlog_get_stats();
+void binlog_reset_stats();
+
+#endif /* BINLOG_H */
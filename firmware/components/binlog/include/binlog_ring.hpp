@@ -0,0 +1,103 @@
+// binlog_ring.hpp
+#ifndef BINLOG_RING_H
+#define BINLOG_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Bounded multi-producer / single-consumer ring (per-slot sequence numbers).
+ * Producers claim a slot with one CAS and never block each other; a producer
+ * preempted mid-copy only holds back the consumer at that slot, it cannot
+ * deadlock a higher priority task as a spinlock would.
+ */
+
+#ifdef CONFIG_ESP32S3_DATA_CACHE_LINE_SIZE
+#define BINLOG_CACHE_LINE_SIZE CONFIG_ESP32S3_DATA_CACHE_LINE_SIZE
+#else
+#define BINLOG_CACHE_LINE_SIZE 64
+#endif
+
+template <typename T, size_t N>
+class binlog_mpsc_ring
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "ring indices must be lock free");
+
+    public:
+        static constexpr size_t capacity = N;
+
+        binlog_mpsc_ring() {
+            for (size_t i = 0; i < N; i++) {
+                slots[i].seq.store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+            }
+        }
+
+        /**
+        * @brief Append one record, any task or callback
+        * @param item: record to copy in
+        * @return false if the ring was full, the record is dropped
+        */
+        bool push(const T &item) {
+            uint32_t pos = head_idx.load(std::memory_order_relaxed);
+            slot_t *slot;
+
+            while (1) {
+                slot = &slots[pos & MASK];
+                const int32_t diff = static_cast<int32_t>(slot->seq.load(std::memory_order_acquire) - pos);
+                if (diff == 0) {
+                    if (head_idx.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = head_idx.load(std::memory_order_relaxed);
+                }
+            }
+
+            slot->item = item;
+            slot->seq.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+        * @brief Take the oldest published record, consumer side only
+        * @param out: filled with the record
+        * @return false if empty or the oldest slot is still being written
+        */
+        bool pop(T &out) {
+            const uint32_t pos = tail_idx.load(std::memory_order_relaxed);
+            slot_t &slot = slots[pos & MASK];
+            if (static_cast<int32_t>(slot.seq.load(std::memory_order_acquire) - (pos + 1)) < 0) {
+                return false;
+            }
+
+            out = slot.item;
+            slot.seq.store(pos + N, std::memory_order_release);
+            tail_idx.store(pos + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        /**
+        * @brief Claimed but not yet consumed records, approximate while producers run
+        */
+        size_t size() const {
+            return head_idx.load(std::memory_order_relaxed) - tail_idx.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr uint32_t MASK = N - 1;
+
+        struct slot_t {
+            std::atomic<uint32_t> seq;
+            T item;
+        };
+
+        alignas(BINLOG_CACHE_LINE_SIZE) std::atomic<uint32_t> head_idx{0};
+        alignas(BINLOG_CACHE_LINE_SIZE) std::atomic<uint32_t> tail_idx{0};
+        alignas(BINLOG_CACHE_LINE_SIZE) slot_t slots[N];
+};
+
+#endif /* BINLOG_RING_H */
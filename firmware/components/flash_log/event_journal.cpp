@@ -0,0 +1,437 @@
+#include <cstring>
+
+#include "event_journal.hpp"
+#include "flash_ring.hpp"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static constexpr const char *TAG = "EVENT_JOURNAL";
+
+static constexpr size_t EVENT_MAX_BYTES = 1 + 10 + 5;   // type, varint64 delta, varint32 value
+static constexpr uint32_t UNKNOWN = UINT32_MAX;
+
+static flash_ring ring(TAG);
+
+// block being filled in RAM
+static uint8_t block_buf[FLASH_LOG_BLOCK_SIZE];
+static uint8_t staged = 0;
+static uint16_t staged_bytes = 0;
+static uint32_t staged_first_s = 0;
+
+static bool have_last = false;
+static uint64_t last_ms = 0;          // newest event, staged or written
+
+// journal clock: clock_ms at esp_timer time clock_us
+static uint64_t clock_ms = 0;
+static int64_t clock_us = 0;
+
+// observe() state
+static uint32_t last_stability = UNKNOWN;
+static uint32_t last_activity = UNKNOWN;
+static uint32_t last_steps = UNKNOWN;
+static uint32_t pending_steps = 0;
+static uint64_t pending_steps_ms = 0;
+static uint64_t steps_window_ms = 0;
+
+static uint32_t events = 0;
+static uint32_t torn_blocks = 0;
+static uint32_t seek_blocks = 0;
+static uint32_t scan_blocks = 0;
+
+// ===========================================
+// encoding (flash_log_format.hpp, FLASH_LOG_FMT_EVENTS)
+// ===========================================
+
+static bool journal_type_known(uint8_t type) {
+    return type >= JOURNAL_EVT_SIG_MOTION && type <= JOURNAL_EVT_STEPS;
+}
+
+static bool journal_type_has_value(uint8_t type) {
+    return type != JOURNAL_EVT_SIG_MOTION;
+}
+
+static size_t put_varint(uint8_t *dst, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        dst[n++] = static_cast<uint8_t>(v) | 0x80;
+        v >>= 7;
+    }
+    dst[n++] = static_cast<uint8_t>(v);
+    return n;
+}
+
+static bool get_varint(const uint8_t *&p, const uint8_t *end, uint64_t &v) {
+    v = 0;
+    for (uint32_t shift = 0; p < end && shift < 64; shift += 7) {
+        const uint8_t byte = *p++;
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+* @brief Walk the events of one block payload
+* @param fn: bool fn(const journal_event_t &), false stops the walk
+* @return false if the payload is malformed
+*/
+template <typename Fn>
+static bool journal_decode_block(const uint8_t *block, Fn &&fn) {
+    flash_log_block_hdr_t hdr;
+    std::memcpy(&hdr, block, sizeof(hdr));
+    const uint8_t *p = block + FLASH_LOG_BLOCK_HDR_SIZE;
+    const uint8_t *end = p + hdr.bytes;
+
+    uint64_t t = static_cast<uint64_t>(hdr.first_us) * 1000;
+    for (uint8_t i = 0; i < hdr.count; i++) {
+        journal_event_t ev = {};
+        uint64_t delta = 0;
+        uint64_t value = 0;
+        if (p >= end || !journal_type_known(*p)) {
+            return false;
+        }
+        ev.type = *p++;
+        if (!get_varint(p, end, delta) || (journal_type_has_value(ev.type) && !get_varint(p, end, value))) {
+            return false;
+        }
+        t += delta;
+        ev.t_ms = t;
+        ev.value = static_cast<uint32_t>(value);
+        if (!fn(ev)) {
+            return true;
+        }
+    }
+    return true;
+}
+
+static bool journal_block_is_events(const uint8_t *block) {
+    return block[0] == FLASH_LOG_FMT_EVENTS;
+}
+
+// ===========================================
+// writer
+// ===========================================
+
+static void journal_reset_stage() {
+    std::memset(block_buf, 0xFF, sizeof(block_buf));
+    staged = 0;
+    staged_bytes = 0;
+}
+
+static bool journal_write_block() {
+    flash_log_block_hdr_t hdr;
+    hdr.format = FLASH_LOG_FMT_EVENTS;
+    hdr.count = staged;
+    hdr.bytes = staged_bytes;
+    hdr.first_us = staged_first_s;
+    hdr.crc = 0;
+    std::memcpy(block_buf, &hdr, sizeof(hdr));
+
+    const bool ok = ring.write_block(block_buf);
+    journal_reset_stage();
+    return ok;
+}
+
+/// @brief Time of the newest event on flash, from the head's last intact block (or the sector before's)
+static bool journal_last_written_ms(uint64_t &t_ms) {
+    if (ring.empty()) {
+        return false;
+    }
+
+    uint8_t block[FLASH_LOG_BLOCK_SIZE];
+    uint32_t sector = ring.head_sector();
+    uint32_t b = ring.next_block();
+    for (uint32_t pass = 0; pass < 2; pass++) {
+        while (b-- > 1) {
+            if (ring.read_block(sector, b, block) && journal_block_is_events(block)) {
+                bool found = false;
+                journal_decode_block(block, [&](const journal_event_t &ev) {
+                    t_ms = ev.t_ms;
+                    found = true;
+                    return true;
+                });
+                if (found) {
+                    return true;
+                }
+            }
+        }
+        if (ring.oldest_sector() == sector) {
+            break;
+        }
+        sector = (sector + ring.sectors() - 1) % ring.sectors();
+        b = FLASH_LOG_BLOCKS_PER_SECTOR;
+    }
+    return false;
+}
+
+static bool journal_stage(uint8_t type, uint32_t value, uint64_t t_ms) {
+    uint8_t ev[EVENT_MAX_BYTES];
+    for (int attempt = 0; attempt < 2; attempt++) {
+        const bool first = (staged == 0);
+        const uint32_t first_s = first ? static_cast<uint32_t>(t_ms / 1000) : staged_first_s;
+        const uint64_t prev_ms = first ? static_cast<uint64_t>(first_s) * 1000 : last_ms;
+
+        size_t n = 0;
+        ev[n++] = type;
+        n += put_varint(ev + n, t_ms - prev_ms);
+        if (journal_type_has_value(type)) {
+            n += put_varint(ev + n, value);
+        }
+
+        if (staged_bytes + n <= FLASH_LOG_PAYLOAD_SIZE && staged < UINT8_MAX) {
+            std::memcpy(block_buf + FLASH_LOG_BLOCK_HDR_SIZE + staged_bytes, ev, n);
+            staged_bytes += static_cast<uint16_t>(n);
+            staged_first_s = first_s;
+            staged++;
+            return true;
+        }
+
+        // block full: program it, the event opens the next one with its own base second
+        if (!journal_write_block()) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool event_journal_open(const char *label) {
+    if (!ring.open(label)) {
+        return false;
+    }
+
+    journal_reset_stage();
+    events = 0;
+    torn_blocks = ring.recovered().torn ? 1 : 0;
+    seek_blocks = 0;
+    scan_blocks = 0;
+    last_stability = UNKNOWN;
+    last_activity = UNKNOWN;
+    last_steps = UNKNOWN;
+    pending_steps = 0;
+
+    uint64_t recovered_ms = 0;
+    have_last = journal_last_written_ms(recovered_ms);
+    last_ms = recovered_ms;
+
+    // the clock resumes just after the newest event, it never runs backwards across a reboot
+    const uint64_t now = event_journal_now_ms();
+    if (have_last && recovered_ms >= now) {
+        clock_ms = recovered_ms + 1;
+        clock_us = esp_timer_get_time();
+    }
+    ESP_LOGI(TAG, "Journal resumes at %llu ms", (unsigned long long)event_journal_now_ms());
+    return true;
+}
+
+bool event_journal_append(uint8_t type, uint32_t value, uint64_t t_ms) {
+    if (!ring.is_open() || !journal_type_known(type)) {
+        return false;
+    }
+
+    if (have_last && t_ms <= last_ms) {
+        t_ms = last_ms + 1;
+    }
+    if (!journal_stage(type, value, t_ms)) {
+        return false;
+    }
+
+    have_last = true;
+    last_ms = t_ms;
+    events++;
+    return true;
+}
+
+static bool journal_flush_steps() {
+    if (pending_steps == 0) {
+        return true;
+    }
+    const uint32_t steps = pending_steps;
+    pending_steps = 0;
+    return event_journal_append(JOURNAL_EVT_STEPS, steps, pending_steps_ms);
+}
+
+bool event_journal_observe(const imu_sample_t &sample) {
+    // sample clock is the low 32 bits of esp_timer, age it against the same clock
+    const uint32_t now_us = static_cast<uint32_t>(esp_timer_get_time());
+    const int32_t age_us = static_cast<int32_t>(now_us - sample.timestamp_us);
+    const uint64_t now_ms = event_journal_now_ms();
+    const uint64_t age_ms = (age_us > 0) ? static_cast<uint64_t>(age_us) / 1000 : 0;
+    const uint64_t t_ms = (now_ms > age_ms) ? now_ms - age_ms : 0;
+
+    switch (sample.report_id) {
+        case SH2_SIGNIFICANT_MOTION:
+            return event_journal_append(JOURNAL_EVT_SIG_MOTION, 0, t_ms);
+
+        case SH2_SHAKE_DETECTOR:
+            return event_journal_append(JOURNAL_EVT_SHAKE, sample.data.value, t_ms);
+
+        case SH2_STABILITY_CLASSIFIER:
+            if (sample.data.value == last_stability) {
+                return true;
+            }
+            last_stability = sample.data.value;
+            return event_journal_append(JOURNAL_EVT_STABILITY, sample.data.value, t_ms);
+
+        case SH2_PERSONAL_ACTIVITY_CLASSIFIER:
+            if (sample.data.activity.state == last_activity) {
+                return true;
+            }
+            last_activity = sample.data.activity.state;
+            return event_journal_append(JOURNAL_EVT_ACTIVITY,
+                                        sample.data.activity.state | (sample.data.activity.confidence << 8), t_ms);
+
+        case SH2_STEP_COUNTER: {
+            // 16 bit count on the hub: a small backwards step is a wrap, a large one a hub reset
+            const uint32_t steps = sample.data.value & 0xFFFF;
+            if (last_steps != UNKNOWN) {
+                const uint32_t delta = (steps - last_steps) & 0xFFFF;
+                const uint32_t added = (steps < last_steps && delta > 0x8000) ? steps : delta;
+                if (added != 0) {
+                    if (pending_steps == 0) {
+                        steps_window_ms = t_ms;
+                    }
+                    pending_steps += added;
+                    pending_steps_ms = t_ms;
+                }
+            }
+            last_steps = steps;
+            if (pending_steps != 0 && t_ms - steps_window_ms >= EVENT_JOURNAL_STEP_INTERVAL_MS) {
+                return journal_flush_steps();
+            }
+            return true;
+        }
+
+        default:
+            return true;
+    }
+}
+
+bool event_journal_sync() {
+    if (!ring.is_open()) {
+        return false;
+    }
+    const bool steps_ok = journal_flush_steps();
+    return ((staged == 0) || journal_write_block()) && steps_ok;
+}
+
+// ===========================================
+// sync reads
+// ===========================================
+
+/// @brief Every event of the block is at or before since_ms: it starts no later than since_ms - 999
+static bool journal_block_before(uint32_t sector, uint32_t block, uint64_t since_ms) {
+    uint8_t buf[FLASH_LOG_BLOCK_SIZE];
+    seek_blocks++;
+    if (!ring.read_block(sector, block, buf) || !journal_block_is_events(buf)) {
+        return false;   // unknown: searching from earlier only costs decode time
+    }
+    flash_log_block_hdr_t hdr;
+    std::memcpy(&hdr, buf, sizeof(hdr));
+    return static_cast<uint64_t>(hdr.first_us) * 1000 + 999 <= since_ms;
+}
+
+size_t event_journal_read_since(uint64_t since_ms, journal_event_t *out, size_t max) {
+    seek_blocks = 0;
+    scan_blocks = 0;
+    if (!ring.is_open() || out == nullptr || max == 0) {
+        return 0;
+    }
+
+    size_t n = 0;
+    auto collect = [&](const journal_event_t &ev) {
+        if (ev.t_ms > since_ms) {
+            out[n++] = ev;
+        }
+        return n < max;
+    };
+
+    if (!ring.empty()) {
+        const uint32_t sectors = ring.sectors();
+        const uint32_t oldest = ring.oldest_sector();
+        const uint32_t live = (ring.head_sector() + sectors - oldest) % sectors + 1;
+        auto sector_at = [&](uint32_t i) { return (oldest + i) % sectors; };
+        auto end_block = [&](uint32_t sector) {
+            return (sector == ring.head_sector()) ? ring.next_block() : FLASH_LOG_BLOCKS_PER_SECTOR;
+        };
+
+        // last sector, then last block in it, whose first block starts at or before since_ms:
+        // everything before it is older than the cursor
+        uint32_t lo = 0;
+        uint32_t hi = live;
+        while (hi - lo > 1) {
+            const uint32_t mid = lo + (hi - lo) / 2;
+            if (journal_block_before(sector_at(mid), 1, since_ms)) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        const uint32_t start_index = lo;
+        uint32_t start_block = 1;
+        uint32_t blo = 1;
+        uint32_t bhi = end_block(sector_at(start_index));
+        while (bhi - blo > 1) {
+            const uint32_t mid = blo + (bhi - blo) / 2;
+            if (journal_block_before(sector_at(start_index), mid, since_ms)) {
+                blo = mid;
+            } else {
+                bhi = mid;
+            }
+        }
+        start_block = blo;
+
+        uint8_t block[FLASH_LOG_BLOCK_SIZE];
+        for (uint32_t i = start_index; i < live && n < max; i++) {
+            const uint32_t sector = sector_at(i);
+            for (uint32_t b = (i == start_index) ? start_block : 1; b < end_block(sector) && n < max; b++) {
+                scan_blocks++;
+                if (ring.read_block(sector, b, block) && journal_block_is_events(block)) {
+                    journal_decode_block(block, collect);
+                }
+            }
+        }
+    }
+
+    if (staged != 0 && n < max) {
+        flash_log_block_hdr_t hdr = {FLASH_LOG_FMT_EVENTS, staged, staged_bytes, staged_first_s, 0};
+        std::memcpy(block_buf, &hdr, sizeof(hdr));
+        journal_decode_block(block_buf, collect);
+    }
+    return n;
+}
+
+// ===========================================
+// clock, maintenance
+// ===========================================
+
+uint64_t event_journal_now_ms() {
+    return clock_ms + static_cast<uint64_t>(esp_timer_get_time() - clock_us) / 1000;
+}
+
+void event_journal_set_time_ms(uint64_t now_ms) {
+    if (now_ms > event_journal_now_ms()) {
+        clock_ms = now_ms;
+        clock_us = esp_timer_get_time();
+    }
+}
+
+bool event_journal_erase() {
+    journal_reset_stage();
+    pending_steps = 0;
+    return ring.erase();
+}
+
+event_journal_stats_t event_journal_get_stats() {
+    event_journal_stats_t stats = {};
+    stats.events = events;
+    stats.blocks_written = ring.blocks_written;
+    stats.flash_bytes = ring.flash_bytes;
+    stats.payload_bytes = ring.payload_bytes;
+    stats.recovery_reads = ring.recovered().reads;
+    stats.torn_blocks = torn_blocks;
+    stats.seek_blocks = seek_blocks;
+    stats.scan_blocks = scan_blocks;
+    return stats;
+}
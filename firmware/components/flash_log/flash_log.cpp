@@ -0,0 +1,86 @@
+#include <cstring>
+
+#include "flash_log.hpp"
+#include "flash_ring.hpp"
+
+static constexpr const char *TAG = "FLASH_LOG";
+
+static flash_ring ring(TAG);
+static uint8_t block_buf[FLASH_LOG_BLOCK_SIZE];
+static uint8_t staged = 0;
+static uint32_t records = 0;
+static uint32_t torn_blocks = 0;
+
+static void flash_log_reset_stage() {
+    std::memset(block_buf, 0xFF, sizeof(block_buf));
+    staged = 0;
+}
+
+static bool flash_log_write_block() {
+    flash_log_block_hdr_t hdr;
+    std::memcpy(&hdr, block_buf, sizeof(hdr));
+    hdr.format = FLASH_LOG_FMT_COMPACT;
+    hdr.count = staged;
+    hdr.bytes = static_cast<uint16_t>(staged * sizeof(imu_compact_sample_t));
+    std::memcpy(block_buf, &hdr, sizeof(hdr));
+
+    const bool ok = ring.write_block(block_buf);
+    flash_log_reset_stage();
+    return ok;
+}
+
+bool flash_log_open(const char *label) {
+    if (!ring.open(label)) {
+        return false;
+    }
+
+    flash_log_reset_stage();
+    records = 0;
+    torn_blocks = ring.recovered().torn ? 1 : 0;
+    return true;
+}
+
+bool flash_log_append(const imu_compact_sample_t &record) {
+    if (!ring.is_open()) {
+        return false;
+    }
+
+    if (staged == 0) {
+        const uint32_t first_us = record.timestamp_us;
+        std::memcpy(block_buf + offsetof(flash_log_block_hdr_t, first_us), &first_us, sizeof(first_us));
+    }
+    std::memcpy(block_buf + FLASH_LOG_BLOCK_HDR_SIZE + staged * sizeof(record), &record, sizeof(record));
+    staged++;
+    records++;
+
+    return (staged < FLASH_LOG_RECORDS_PER_BLOCK) || flash_log_write_block();
+}
+
+bool flash_log_sync() {
+    if (!ring.is_open()) {
+        return false;
+    }
+    return (staged == 0) || flash_log_write_block();
+}
+
+bool flash_log_erase() {
+    flash_log_reset_stage();
+    return ring.erase();
+}
+
+bool flash_log_wear(uint32_t &min_erases, uint32_t &max_erases) {
+    return ring.wear(min_erases, max_erases);
+}
+
+flash_log_stats_t flash_log_get_stats() {
+    flash_log_stats_t stats = {};
+    stats.records = records;
+    stats.blocks_written = ring.blocks_written;
+    stats.sectors_erased = ring.sectors_erased;
+    stats.flash_bytes = ring.flash_bytes;
+    stats.payload_bytes = ring.payload_bytes;
+    stats.head_seq = ring.head_seq();
+    stats.recovery_reads = ring.recovered().reads;
+    stats.torn_blocks = torn_blocks;
+    return stats;
+}
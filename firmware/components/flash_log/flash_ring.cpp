@@ -0,0 +1,174 @@
+#include <cstring>
+
+#include "flash_ring.hpp"
+#include "esp_log.h"
+
+bool flash_ring::read(uint32_t offset, void *dst, size_t len) const {
+    return part != nullptr && esp_partition_read(part, offset, dst, len) == ESP_OK;
+}
+
+bool flash_ring::read_block(uint32_t sector, uint32_t block, uint8_t *dst) const {
+    return read(sector * FLASH_LOG_SECTOR_SIZE + block * FLASH_LOG_BLOCK_SIZE, dst, FLASH_LOG_BLOCK_SIZE) &&
+           flash_log_block_valid(dst);
+}
+
+/// @brief Erase the next sector of the ring and write its header, the oldest data goes with it
+bool flash_ring::open_sector() {
+    const uint32_t sector = have_head ? (head + 1) % n_sectors : 0;
+    const uint32_t offset = sector * FLASH_LOG_SECTOR_SIZE;
+
+    // carry the wear count over, a sector whose header was lost is taken to be as worn as the head was
+    flash_log_sector_hdr_t old;
+    uint32_t erase_count = lap_erase_count;
+    if (read(offset, &old, sizeof(old)) && flash_log_sector_valid(old)) {
+        erase_count = old.erase_count;
+    }
+
+    esp_err_t err = esp_partition_erase_range(part, offset, FLASH_LOG_SECTOR_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE(tag, "Erase of sector %lu failed: %s", (unsigned long)sector, esp_err_to_name(err));
+        return false;
+    }
+    sectors_erased++;
+
+    flash_log_sector_hdr_t hdr = {};
+    hdr.magic = FLASH_LOG_MAGIC;
+    hdr.version = FLASH_LOG_VERSION;
+    hdr.block_size = FLASH_LOG_BLOCK_SIZE;
+    hdr.seq = have_head ? seq + 1 : 0;
+    hdr.erase_count = erase_count + 1;
+    hdr.crc = flash_log_sector_crc(hdr);
+    err = esp_partition_write(part, offset, &hdr, sizeof(hdr));
+    if (err != ESP_OK) {
+        ESP_LOGE(tag, "Header write of sector %lu failed: %s", (unsigned long)sector, esp_err_to_name(err));
+        return false;
+    }
+
+    have_head = true;
+    head = sector;
+    seq = hdr.seq;
+    lap_erase_count = erase_count;
+    next = 1;
+    flash_bytes += FLASH_LOG_BLOCK_SIZE;
+    return true;
+}
+
+bool flash_ring::write_block(uint8_t *block) {
+    if (part == nullptr) {
+        return false;
+    }
+    if (next >= FLASH_LOG_BLOCKS_PER_SECTOR && !open_sector()) {
+        return false;
+    }
+
+    flash_log_block_hdr_t hdr;
+    std::memcpy(&hdr, block, sizeof(hdr));
+    hdr.crc = flash_log_block_crc(block);
+    std::memcpy(block, &hdr, sizeof(hdr));
+
+    const uint32_t offset = head * FLASH_LOG_SECTOR_SIZE + next * FLASH_LOG_BLOCK_SIZE;
+    esp_err_t err = esp_partition_write(part, offset, block, FLASH_LOG_BLOCK_SIZE);
+    // the block is spent either way, a failed one is skipped by its CRC
+    next++;
+    if (err != ESP_OK) {
+        ESP_LOGE(tag, "Block write at 0x%lx failed: %s", (unsigned long)offset, esp_err_to_name(err));
+        return false;
+    }
+
+    blocks_written++;
+    flash_bytes += FLASH_LOG_BLOCK_SIZE;
+    payload_bytes += hdr.bytes;
+    return true;
+}
+
+bool flash_ring::open(const char *label) {
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (part == nullptr) {
+        ESP_LOGE(tag, "Partition \"%s\" not found", label);
+        return false;
+    }
+
+    n_sectors = part->size / FLASH_LOG_SECTOR_SIZE;
+    if (n_sectors < 2) {
+        ESP_LOGE(tag, "Partition \"%s\" needs at least 2 sectors", label);
+        part = nullptr;
+        return false;
+    }
+
+    blocks_written = 0;
+    sectors_erased = 0;
+    flash_bytes = 0;
+    payload_bytes = 0;
+
+    tail = flash_log_find_tail([this](uint32_t offset, void *dst, size_t len) { return read(offset, dst, len); },
+                               n_sectors);
+    have_head = !tail.empty;
+    head = tail.head_sector;
+    seq = tail.head_seq;
+    lap_erase_count = (tail.head_erase_count != 0) ? tail.head_erase_count - 1 : 0;
+    next = tail.empty ? FLASH_LOG_BLOCKS_PER_SECTOR : tail.next_block;
+
+    if (tail.torn) {
+        ESP_LOGW(tag, "Last block of sector %lu was cut short, skipped", (unsigned long)head);
+    }
+    ESP_LOGI(tag, "Partition \"%s\": %lu sectors, %s, tail found in %lu reads", label, (unsigned long)n_sectors,
+             tail.empty ? "empty" : "resuming", (unsigned long)tail.reads);
+    return true;
+}
+
+bool flash_ring::erase() {
+    if (part == nullptr) {
+        return false;
+    }
+
+    // the headers hold the wear history, restart every sector at the most worn one's count
+    uint32_t min_erases = 0;
+    uint32_t max_erases = 0;
+    wear(min_erases, max_erases);
+
+    esp_err_t err = esp_partition_erase_range(part, 0, n_sectors * FLASH_LOG_SECTOR_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE(tag, "Erase failed: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    have_head = false;
+    lap_erase_count = max_erases + 1;
+    next = FLASH_LOG_BLOCKS_PER_SECTOR;
+    sectors_erased += n_sectors;
+    return true;
+}
+
+bool flash_ring::wear(uint32_t &min_erases, uint32_t &max_erases) const {
+    if (part == nullptr) {
+        return false;
+    }
+
+    min_erases = UINT32_MAX;
+    max_erases = 0;
+    for (uint32_t s = 0; s < n_sectors; s++) {
+        flash_log_sector_hdr_t hdr;
+        const uint32_t erases = (read(s * FLASH_LOG_SECTOR_SIZE, &hdr, sizeof(hdr)) &&
+                                 flash_log_sector_valid(hdr)) ? hdr.erase_count : 0;
+        min_erases = (erases < min_erases) ? erases : min_erases;
+        max_erases = (erases > max_erases) ? erases : max_erases;
+    }
+    return true;
+}
+
+uint32_t flash_ring::oldest_sector() const {
+    if (!have_head) {
+        return 0;
+    }
+
+    // the sector after the head, or the one after that when the head's successor was erased mid-lap
+    for (uint32_t step = 1; step <= 2 && step < n_sectors; step++) {
+        const uint32_t s = (head + step) % n_sectors;
+        flash_log_sector_hdr_t hdr;
+        if (read(s * FLASH_LOG_SECTOR_SIZE, &hdr, sizeof(hdr)) && flash_log_sector_valid(hdr) &&
+            static_cast<int32_t>(seq - hdr.seq) > 0) {
+            return s;
+        }
+    }
+    return 0;
+}
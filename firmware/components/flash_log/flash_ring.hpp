@@ -0,0 +1,81 @@
+// flash_ring.hpp
+#ifndef FLASH_RING_H
+#define FLASH_RING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_partition.h"
+#include "flash_log_format.hpp"
+
+/**
+ * Block writer of one ring partition in the flash_log_format.hpp layout,
+ * shared by flash_log (samples) and event_journal (events). Owns the
+ * partition handle, the head position and the wear counts; the payload of a
+ * block is the caller's. Single writer, no locking.
+ */
+class flash_ring
+{
+    public:
+        explicit flash_ring(const char *log_tag) : tag(log_tag) {}
+
+        /**
+        * @brief Mount a partition and find the tail left by the previous boot
+        * @param label: partition label
+        * @return false if the partition is missing or smaller than two sectors
+        */
+        bool open(const char *label);
+
+        /**
+        * @brief Program one block image at the head, erasing the next sector first when the head is full
+        * @param block: FLASH_LOG_BLOCK_SIZE bytes, format / count / bytes / first_us set, the CRC is filled in
+        * @return false if not open or a flash operation failed (the block is spent either way)
+        */
+        bool write_block(uint8_t *block);
+
+        /// @brief Erase the whole partition, erase counts carry on from the most worn sector
+        bool erase();
+
+        /// @brief Lowest and highest sector erase count, reads every sector header
+        bool wear(uint32_t &min_erases, uint32_t &max_erases) const;
+
+        /// @brief Partition relative read
+        bool read(uint32_t offset, void *dst, size_t len) const;
+
+        /// @brief Read and check one data block, false for an erased, torn or foreign one
+        bool read_block(uint32_t sector, uint32_t block, uint8_t *dst) const;
+
+        /// @brief Sector the oldest data is in, walks at most two headers past the head
+        uint32_t oldest_sector() const;
+
+        bool is_open() const { return part != nullptr; }
+        bool empty() const { return !have_head; }
+        uint32_t sectors() const { return n_sectors; }
+        uint32_t head_sector() const { return head; }
+        uint32_t head_seq() const { return seq; }
+        /// @brief First unwritten block of the head sector, FLASH_LOG_BLOCKS_PER_SECTOR when full
+        uint32_t next_block() const { return next; }
+        /// @brief What open() found
+        const flash_log_tail_t &recovered() const { return tail; }
+
+        // counters since open()
+        uint32_t blocks_written = 0;
+        uint32_t sectors_erased = 0;
+        uint64_t flash_bytes = 0;      ///< whole blocks including sector headers
+        uint64_t payload_bytes = 0;
+
+    private:
+        bool open_sector();
+
+        const char *tag;
+        const esp_partition_t *part = nullptr;
+        uint32_t n_sectors = 0;
+        bool have_head = false;
+        uint32_t head = 0;
+        uint32_t seq = 0;
+        uint32_t lap_erase_count = 0;   // head sector's count before its last erase, for sectors without a header
+        uint32_t next = FLASH_LOG_BLOCKS_PER_SECTOR;
+        flash_log_tail_t tail = {};
+};
+
+#endif /* FLASH_RING_H */
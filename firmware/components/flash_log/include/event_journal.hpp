@@ -0,0 +1,133 @@
+// event_journal.hpp
+#ifndef EVENT_JOURNAL_H
+#define EVENT_JOURNAL_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "imu_driver.hpp"
+
+/**
+ * Journal of the discrete events the app displays: significant motion,
+ * shakes, stability and activity transitions and step counts. Events go to
+ * their own ring partition in the flash_log layout (FLASH_LOG_FMT_EVENTS,
+ * about 3-4 bytes an event with delta coded times), and a sync request seeks
+ * straight to "events since T" by binary searching the block headers instead
+ * of reading the whole journal.
+ *
+ * Times are journal milliseconds: a 64 bit clock that resumes after the last
+ * stored event at open and never runs backwards, so the phone's sync cursor
+ * stays valid across reboots. The phone maps it to wall time with
+ * event_journal_now_ms(), or moves it forward to wall time with
+ * event_journal_set_time_ms(). No two events share a millisecond (a later one
+ * is pushed by 1 ms), so the time of the last event received is an exact cursor.
+ *
+ * Partition table entry (data, any custom subtype), e.g.:
+ *   imuevt, data, 0x41, , 64K
+ *
+ * Single task: observe / append / sync / read from the task draining the sample ring.
+ */
+
+#define EVENT_JOURNAL_DEFAULT_LABEL "imuevt"
+
+#ifndef EVENT_JOURNAL_STEP_INTERVAL_MS
+#define EVENT_JOURNAL_STEP_INTERVAL_MS 60000UL   ///< step counts are summed into one event per interval
+#endif
+
+typedef enum journal_event_type_t : uint8_t {
+    JOURNAL_EVT_SIG_MOTION = 1,   ///< significant motion fired, no value
+    JOURNAL_EVT_SHAKE      = 2,   ///< shake detected, value: shake axis bits
+    JOURNAL_EVT_STABILITY  = 3,   ///< stability classifier changed, value: BNO08xStability
+    JOURNAL_EVT_ACTIVITY   = 4,   ///< most likely activity changed, value: BNO08xActivity | confidence << 8
+    JOURNAL_EVT_STEPS      = 5,   ///< value: steps since the previous STEPS event
+} journal_event_type_t;
+
+/**
+ * @brief One journal event
+ * @param t_ms: journal time
+ * @param type: journal_event_type_t
+ * @param value: see journal_event_type_t, 0 for types without one
+ */
+typedef struct journal_event_t {
+    uint64_t t_ms;
+    uint8_t type;
+    uint32_t value;
+} journal_event_t;
+
+/**
+ * @brief Journal counters since event_journal_open()
+ * @param events: events appended
+ * @param blocks_written: data blocks programmed
+ * @param flash_bytes: flash consumed, whole blocks including sector headers and block padding
+ * @param payload_bytes: encoded event bytes inside those blocks
+ * @param recovery_reads: flash reads open() spent finding the tail
+ * @param torn_blocks: blocks cut short by a power loss, found at open()
+ * @param seek_blocks: blocks the last read_since() read to find where to start
+ * @param scan_blocks: blocks it decoded from there
+ */
+typedef struct event_journal_stats_t {
+    uint32_t events;
+    uint32_t blocks_written;
+    uint64_t flash_bytes;
+    uint64_t payload_bytes;
+    uint32_t recovery_reads;
+    uint32_t torn_blocks;
+    uint32_t seek_blocks;
+    uint32_t scan_blocks;
+} event_journal_stats_t;
+
+/**
+* @brief Mount the journal partition, find its tail and resume the journal clock after the last event
+* @param label: partition label
+* @return false if the partition is missing or smaller than two sectors
+*/
+bool event_journal_open(const char *label = EVENT_JOURNAL_DEFAULT_LABEL);
+
+/**
+* @brief Turn a drained sample into an event when it is one, other reports are ignored
+* @param sample: sample from the ring, timestamp_us must be less than ~71 min old
+* @return false if an event was due and could not be written
+* @note Stability and activity record transitions only, step counts are summed per EVENT_JOURNAL_STEP_INTERVAL_MS
+*/
+bool event_journal_observe(const imu_sample_t &sample);
+
+/**
+* @brief Stage one event, a full block is programmed before the next one starts
+* @param type: journal_event_type_t
+* @param value: event value, ignored for types without one
+* @param t_ms: journal time, raised to 1 ms after the previous event if it is not later
+* @return false if the journal is not open, the type is unknown or the flash write failed
+*/
+bool event_journal_append(uint8_t type, uint32_t value, uint64_t t_ms);
+
+/**
+* @brief Program the staged partial block and any pending step count now, e.g. before sleep
+* @return false on a flash error
+* @note Every sync costs a whole block, staged events are returned by read_since() without one
+*/
+bool event_journal_sync();
+
+/**
+* @brief Read events later than since_ms, oldest first, staged ones included
+* @param since_ms: cursor, the t_ms of the last event the caller already has (0 for everything)
+* @param out: events
+* @param max: capacity of out
+* @return events written, call again with out[n - 1].t_ms while it returns max
+*/
+size_t event_journal_read_since(uint64_t since_ms, journal_event_t *out, size_t max);
+
+/// @brief Current journal time
+uint64_t event_journal_now_ms();
+
+/**
+* @brief Move the journal clock forward, e.g. to wall time in ms sent by the phone
+* @param now_ms: new journal time, ignored unless later than event_journal_now_ms()
+*/
+void event_journal_set_time_ms(uint64_t now_ms);
+
+/// @brief Erase the partition and drop the staged events, the clock keeps running
+bool event_journal_erase();
+
+event_journal_stats_t event_journal_get_stats();
+
+#endif /* EVENT_JOURNAL_H */
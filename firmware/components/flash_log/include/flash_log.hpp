@@ -0,0 +1,87 @@
+// flash_log.hpp
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "flash_log_format.hpp"
+#include "imu_compact.hpp"
+
+/**
+ * Persistent circular log of sensor samples and classifier outputs in a data
+ * partition, so history survives while the phone is out of range. Records
+ * are staged in RAM and programmed one whole block at a time, append only;
+ * the oldest sector is erased when the ring laps. Layout and recovery are
+ * described in flash_log_format.hpp, host/tools/flash_log_decode reads an
+ * image of the partition.
+ *
+ * Partition table entry (data, any custom subtype), e.g.:
+ *   imulog, data, 0x40, , 1M
+ *
+ * Single writer: call append / sync from one task, usually the one draining
+ * the sample ring. Flash writes stall the caches, keep that task off the
+ * data path core's tightest deadlines.
+ */
+
+#define FLASH_LOG_DEFAULT_LABEL "imulog"
+#define FLASH_LOG_RECORDS_PER_BLOCK (FLASH_LOG_PAYLOAD_SIZE / sizeof(imu_compact_sample_t))
+
+/**
+ * @brief Log counters since flash_log_open()
+ * @param records: records appended
+ * @param blocks_written: data blocks programmed
+ * @param sectors_erased: sectors erased to open them
+ * @param flash_bytes: flash consumed, whole blocks including sector headers and block padding
+ * @param payload_bytes: record bytes inside those blocks
+ * @param head_seq: sequence number of the sector being written
+ * @param recovery_reads: flash reads open() spent finding the tail
+ * @param torn_blocks: blocks cut short by a power loss, found at open()
+ */
+typedef struct flash_log_stats_t {
+    uint32_t records;
+    uint32_t blocks_written;
+    uint32_t sectors_erased;
+    uint64_t flash_bytes;
+    uint64_t payload_bytes;
+    uint32_t head_seq;
+    uint32_t recovery_reads;
+    uint32_t torn_blocks;
+} flash_log_stats_t;
+
+/**
+* @brief Mount the log partition and find where the previous boot stopped
+* @param label: partition label
+* @return false if the partition is missing or smaller than two sectors
+* @note Reads O(log sectors) headers, never the whole log
+*/
+bool flash_log_open(const char *label = FLASH_LOG_DEFAULT_LABEL);
+
+/**
+* @brief Stage one record, a full block is programmed before the next one starts
+* @param record: sample in compact form, see imu_compact_pack()
+* @return false if the log is not open or the flash write failed
+*/
+bool flash_log_append(const imu_compact_sample_t &record);
+
+/**
+* @brief Program the staged partial block now, e.g. before sleep or on a low battery warning
+* @return false on a flash error, true if there was nothing to write
+* @note Every sync costs a whole block, sync on a timescale of seconds, not per sample
+*/
+bool flash_log_sync();
+
+/**
+* @brief Erase the whole partition and start an empty log
+* @note Sector erase counts are kept: every sector restarts at the highest count plus one
+*/
+bool flash_log_erase();
+
+/**
+* @brief Lowest and highest sector erase count, reads every sector header
+*/
+bool flash_log_wear(uint32_t &min_erases, uint32_t &max_erases);
+
+flash_log_stats_t flash_log_get_stats();
+
+#endif /* FLASH_LOG_H */
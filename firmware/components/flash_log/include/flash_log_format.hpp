@@ -0,0 +1,207 @@
+// flash_log_format.hpp
+#ifndef FLASH_LOG_FORMAT_H
+#define FLASH_LOG_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "esp_rom_crc.h"
+
+/**
+ * On-flash layout of the flash_log partition, shared by the firmware writer
+ * and the host decoder. Little endian throughout.
+ *
+ * The partition is a ring of 4 KB erase sectors written in order, so every
+ * sector is erased once per lap (wear is even by construction). A sector is
+ * 16 blocks of 256 bytes, each programmed once and never rewritten:
+ *
+ *   block 0      sector header: "FLG1" magic, uint16 version (1), uint16 block size,
+ *                uint32 seq (+1 per sector ever opened), uint32 erase count,
+ *                uint32 CRC-32 of the fields before it, rest of the block unused
+ *   blocks 1-15  data block: uint8 format, uint8 record count, uint16 payload bytes,
+ *                uint32 timestamp_us of the first record, uint32 CRC-32 of the
+ *                8 bytes before it and the payload, then the payload
+ *
+ * Payload formats:
+ *   FLASH_LOG_FMT_COMPACT  count x imu_compact_sample_t (12 bytes, see imu_compact.hpp)
+ *   FLASH_LOG_FMT_EVENTS   count x event (event_journal partition): uint8 type, varint
+ *                          ms since the previous event, varint value (none for types
+ *                          without one). The header's first_us field holds the journal
+ *                          second of the first event instead, whose delta is taken
+ *                          from first_us * 1000, so every block decodes on its own and
+ *                          the block headers double as a sparse time index.
+ *   varint: 7 bits per byte, least significant group first, bit 7 set on all but the last
+ *
+ * An erased block reads 0xFF, format 0xFF is never written. A block whose CRC
+ * fails (a write cut by a brown-out) is skipped by readers.
+ *
+ * Tail recovery reads sector headers only: sequence numbers rise along the
+ * ring up to the newest sector and drop after it, so a binary search finds
+ * it, and a second one finds the first erased block inside it. The sector
+ * after the newest may be erased (power lost between its erase and its
+ * header), the oldest data then starts one sector later.
+ */
+
+#define FLASH_LOG_MAGIC 0x31474C46UL   ///< "FLG1"
+#define FLASH_LOG_VERSION 1
+
+#define FLASH_LOG_SECTOR_SIZE 4096
+#define FLASH_LOG_BLOCK_SIZE 256
+#define FLASH_LOG_BLOCKS_PER_SECTOR (FLASH_LOG_SECTOR_SIZE / FLASH_LOG_BLOCK_SIZE)   ///< block 0 is the header
+#define FLASH_LOG_BLOCK_HDR_SIZE 12
+#define FLASH_LOG_PAYLOAD_SIZE (FLASH_LOG_BLOCK_SIZE - FLASH_LOG_BLOCK_HDR_SIZE)
+
+#define FLASH_LOG_FMT_COMPACT 1
+#define FLASH_LOG_FMT_EVENTS 2
+#define FLASH_LOG_FMT_ERASED 0xFF
+
+typedef struct flash_log_sector_hdr_t {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t block_size;
+    uint32_t seq;
+    uint32_t erase_count;
+    uint32_t crc;
+} flash_log_sector_hdr_t;
+
+typedef struct flash_log_block_hdr_t {
+    uint8_t format;
+    uint8_t count;
+    uint16_t bytes;
+    uint32_t first_us;
+    uint32_t crc;
+} flash_log_block_hdr_t;
+
+static_assert(sizeof(flash_log_sector_hdr_t) == 20, "sector header layout is part of the format");
+static_assert(sizeof(flash_log_block_hdr_t) == FLASH_LOG_BLOCK_HDR_SIZE, "block header layout is part of the format");
+
+inline uint32_t flash_log_sector_crc(const flash_log_sector_hdr_t &hdr) {
+    return esp_rom_crc32_le(0, reinterpret_cast<const uint8_t *>(&hdr), offsetof(flash_log_sector_hdr_t, crc));
+}
+
+inline bool flash_log_sector_valid(const flash_log_sector_hdr_t &hdr) {
+    return hdr.magic == FLASH_LOG_MAGIC && hdr.version == FLASH_LOG_VERSION &&
+           hdr.block_size == FLASH_LOG_BLOCK_SIZE && hdr.crc == flash_log_sector_crc(hdr);
+}
+
+/// @brief CRC of a whole data block image (header fields plus bytes of payload)
+inline uint32_t flash_log_block_crc(const uint8_t *block) {
+    flash_log_block_hdr_t hdr;
+    std::memcpy(&hdr, block, sizeof(hdr));
+    const uint32_t crc = esp_rom_crc32_le(0, block, offsetof(flash_log_block_hdr_t, crc));
+    const uint16_t bytes = (hdr.bytes <= FLASH_LOG_PAYLOAD_SIZE) ? hdr.bytes : FLASH_LOG_PAYLOAD_SIZE;
+    return esp_rom_crc32_le(crc, block + FLASH_LOG_BLOCK_HDR_SIZE, bytes);
+}
+
+/// @brief Block holds a complete, intact payload
+inline bool flash_log_block_valid(const uint8_t *block) {
+    flash_log_block_hdr_t hdr;
+    std::memcpy(&hdr, block, sizeof(hdr));
+    return hdr.format != FLASH_LOG_FMT_ERASED && hdr.bytes <= FLASH_LOG_PAYLOAD_SIZE &&
+           hdr.crc == flash_log_block_crc(block);
+}
+
+inline bool flash_log_block_erased(const uint8_t *block) {
+    return block[0] == FLASH_LOG_FMT_ERASED && block[1] == 0xFF && block[2] == 0xFF && block[3] == 0xFF;
+}
+
+/**
+ * @brief Where the log ends, as found by flash_log_find_tail()
+ * @param empty: no sector was ever written
+ * @param head_sector: newest sector
+ * @param head_seq: its sequence number
+ * @param head_erase_count: its erase count
+ * @param next_block: first erased block in it, FLASH_LOG_BLOCKS_PER_SECTOR when full
+ * @param oldest_sector: sector the oldest data is in
+ * @param torn: the last written block fails its CRC
+ * @param reads: flash reads spent
+ */
+typedef struct flash_log_tail_t {
+    bool empty;
+    uint32_t head_sector;
+    uint32_t head_seq;
+    uint32_t head_erase_count;
+    uint32_t next_block;
+    uint32_t oldest_sector;
+    bool torn;
+    uint32_t reads;
+} flash_log_tail_t;
+
+/**
+ * @brief Locate the newest sector and its first free block without scanning the log
+ * @param read: bool read(uint32_t offset, void *dst, size_t len), partition relative
+ * @param sectors: sectors in the partition
+ */
+template <typename Read>
+flash_log_tail_t flash_log_find_tail(Read &&read, uint32_t sectors) {
+    flash_log_tail_t tail = {};
+    tail.empty = true;
+
+    auto header = [&](uint32_t sector, flash_log_sector_hdr_t &hdr) {
+        tail.reads++;
+        return read(sector * FLASH_LOG_SECTOR_SIZE, &hdr, sizeof(hdr)) && flash_log_sector_valid(hdr);
+    };
+
+    flash_log_sector_hdr_t first;
+    flash_log_sector_hdr_t hdr;
+    if (header(0, first)) {
+        // last sector whose seq is not older than sector 0's, everything after it is older or erased
+        uint32_t lo = 0;
+        uint32_t hi = sectors;
+        while (hi - lo > 1) {
+            const uint32_t mid = lo + (hi - lo) / 2;
+            if (header(mid, hdr) && static_cast<int32_t>(hdr.seq - first.seq) >= 0) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        tail.head_sector = lo;
+    } else if (sectors > 1 && header(sectors - 1, hdr)) {
+        // sector 0 was erased for the next lap, the last sector is the newest
+        tail.head_sector = sectors - 1;
+    } else {
+        return tail;
+    }
+
+    header(tail.head_sector, hdr);
+    tail.empty = false;
+    tail.head_seq = hdr.seq;
+    tail.head_erase_count = hdr.erase_count;
+
+    // blocks are programmed in order: first erased one by binary search
+    const uint32_t base = tail.head_sector * FLASH_LOG_SECTOR_SIZE;
+    uint8_t word[4];
+    uint32_t lo = 0;
+    uint32_t hi = FLASH_LOG_BLOCKS_PER_SECTOR;
+    while (hi - lo > 1) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        tail.reads++;
+        if (read(base + mid * FLASH_LOG_BLOCK_SIZE, word, sizeof(word)) && !flash_log_block_erased(word)) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    tail.next_block = hi;
+
+    if (lo > 0) {
+        uint8_t block[FLASH_LOG_BLOCK_SIZE];
+        tail.reads++;
+        tail.torn = !read(base + lo * FLASH_LOG_BLOCK_SIZE, block, sizeof(block)) || !flash_log_block_valid(block);
+    }
+
+    // oldest: the sector after the head, or the one after that when the head's successor was erased mid-lap
+    tail.oldest_sector = 0;
+    for (uint32_t step = 1; step <= 2 && step < sectors; step++) {
+        const uint32_t s = (tail.head_sector + step) % sectors;
+        if (header(s, hdr) && hdr.seq != tail.head_seq && static_cast<int32_t>(tail.head_seq - hdr.seq) > 0) {
+            tail.oldest_sector = s;
+            break;
+        }
+    }
+    return tail;
+}
+
+#endif /* FLASH_LOG_FORMAT_H */
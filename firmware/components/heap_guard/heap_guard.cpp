@@ -0,0 +1,62 @@
+#include <atomic>
+
+#include "heap_guard.hpp"
+#if __has_include("sdkconfig.h")
+#include "sdkconfig.h"
+#endif
+
+static std::atomic<bool> armed{false};
+static std::atomic<uint32_t> alloc_cnt{0};
+static std::atomic<uint32_t> alloc_bytes{0};
+static std::atomic<uint32_t> first_size{0};
+static std::atomic<const void *> first_caller{nullptr};
+
+void heap_guard_arm() {
+    armed.store(true, std::memory_order_seq_cst);
+}
+
+void heap_guard_disarm() {
+    armed.store(false, std::memory_order_seq_cst);
+}
+
+bool heap_guard_armed() {
+    return armed.load(std::memory_order_relaxed);
+}
+
+heap_guard_stats_t heap_guard_get_stats() {
+    heap_guard_stats_t stats;
+    stats.allocs = alloc_cnt.load(std::memory_order_relaxed);
+    stats.bytes = alloc_bytes.load(std::memory_order_relaxed);
+    stats.first_size = first_size.load(std::memory_order_relaxed);
+    stats.first_caller = first_caller.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void heap_guard_reset_stats() {
+    alloc_cnt.store(0, std::memory_order_relaxed);
+    alloc_bytes.store(0, std::memory_order_relaxed);
+    first_size.store(0, std::memory_order_relaxed);
+    first_caller.store(nullptr, std::memory_order_relaxed);
+}
+
+void heap_guard_on_alloc(size_t size, const void *caller) {
+    if (!armed.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // the first counted allocation keeps its size and call site
+    if (alloc_cnt.fetch_add(1, std::memory_order_relaxed) == 0) {
+        first_size.store(static_cast<uint32_t>(size), std::memory_order_relaxed);
+        first_caller.store(caller, std::memory_order_relaxed);
+    }
+    alloc_bytes.fetch_add(static_cast<uint32_t>(size), std::memory_order_relaxed);
+}
+
+#if defined(CONFIG_HEAP_USE_HOOKS)
+// called by heap_caps for every successful allocation, from any task or ISR
+extern "C" void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+    (void)ptr;
+    (void)caps;
+    heap_guard_on_alloc(size, __builtin_return_address(0));
+}
+#endif
@@ -0,0 +1,53 @@
+// heap_guard.hpp
+#ifndef HEAP_GUARD_H
+#define HEAP_GUARD_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Steady state heap check. Everything the data path needs (ring, caches,
+ * subscriptions, event group, task stacks) is static or allocated during
+ * init; once init is done a task calls heap_guard_arm() and every allocation
+ * from then on is counted as a leak of the zero-heap rule.
+ *
+ * The count comes from the allocator hook: on target esp_heap_trace_alloc_hook()
+ * with CONFIG_HEAP_USE_HOOKS=y, on the host the test's malloc interposer. The
+ * hook only bumps atomics, it never logs or allocates; report the counters from
+ * a task with heap_guard_get_stats().
+ */
+
+/**
+ * @brief Allocations seen while armed
+ * @param allocs: allocations counted
+ * @param bytes: their total size
+ * @param first_size: size of the first one, 0 if none
+ * @param first_caller: return address of the allocator call, for addr2line
+ */
+typedef struct heap_guard_stats_t {
+    uint32_t allocs;
+    uint32_t bytes;
+    uint32_t first_size;
+    const void *first_caller;
+} heap_guard_stats_t;
+
+/// @brief Start counting, the counters are kept across disarm / arm
+void heap_guard_arm();
+
+/// @brief Stop counting, around a rare path that is allowed to allocate (NVS writes)
+void heap_guard_disarm();
+
+bool heap_guard_armed();
+
+heap_guard_stats_t heap_guard_get_stats();
+
+void heap_guard_reset_stats();
+
+/**
+* @brief Count one allocation if armed, called by the allocator hook
+* @param size: requested bytes
+* @param caller: return address of the allocation call
+*/
+void heap_guard_on_alloc(size_t size, const void *caller);
+
+#endif /* HEAP_GUARD_H */
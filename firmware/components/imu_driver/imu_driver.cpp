@@ -1,22 +1,129 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+
 #include "BNO08x.hpp"
+#include "binlog.hpp"
+#include "heap_guard.hpp"
 #include "BNO08xGlobalTypes.hpp"
 #include "imu_driver.hpp"
 #include "freertos/task.h"
+#include "freertos/event_groups.h"
 #include "sh2.h"
+#include "esp_cpu.h"
 #include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
 
 static constexpr const char *TAG = "IMU_DRIVER";
-volatile bool motion_flag = false;
+
+typedef struct imu_live_cfg_t {
+    uint32_t period_us;
+    sh2_SensorConfig_t config;
+} imu_live_cfg_t;
 
 static BNO08x imu;
 
+/**
+ * Hooks the fault recovery needs from esp32_BNO08x: a callback for the SHTP
+ * reset message and runtime selection of the dynamically calibrated sensors.
+ * The pinned release is not vendored here, so both are detected at compile
+ * time; without the callback resets are only found by imu_hub_check(), and
+ * imu_set_dynamic_calibration() refuses.
+ */
+template <typename Lib>
+concept imu_lib_has_reset_cb = requires(Lib &lib, std::function<void(void)> cb) { lib.register_reset_cb(cb); };
+
+template <typename Lib>
+concept imu_lib_has_cal_select = requires(Lib &lib, BNO08xCalSel sensors) {
+    lib.dynamic_calibration_enable(sensors);
+    lib.dynamic_calibration_disable(sensors);
+};
+
+template <typename Lib>
+static bool imu_lib_register_reset_cb(Lib &lib, void (*cb)()) {
+    if constexpr (imu_lib_has_reset_cb<Lib>) {
+        lib.register_reset_cb(cb);
+        return true;
+    } else {
+        return false;
+    }
+}
+
+template <typename Lib>
+static bool imu_lib_cal_select(Lib &lib, uint8_t sensors, bool enable) {
+    if constexpr (imu_lib_has_cal_select<Lib>) {
+        const BNO08xCalSel sel = static_cast<BNO08xCalSel>(sensors);
+        return enable ? lib.dynamic_calibration_enable(sel) : lib.dynamic_calibration_disable(sel);
+    } else {
+        return false;
+    }
+}
+
+#if IMU_SAMPLE_RING_COMPACT
+typedef imu_compact_sample_t imu_ring_record_t;
+#else
+typedef imu_sample_t imu_ring_record_t;
+#endif
+static imu_spsc_ring<imu_ring_record_t, IMU_SAMPLE_RING_CAPACITY> sample_ring;
+static std::atomic<uint64_t> enabled_rpts{0};     // running on the hub
+static std::atomic<uint64_t> desired_rpts{0};     // asked for, replayed after a reset
+static std::array<imu_live_cfg_t, SH2_MAX_SENSOR_ID + 1> live_cfg{};    // valid where desired_rpts has the bit
+static constexpr uint8_t CAL_HUB_DEFAULT = static_cast<uint8_t>(BNO08xCalSel::all);
+static constexpr uint8_t CAL_ALL_SENSORS = CAL_HUB_DEFAULT | static_cast<uint8_t>(BNO08xCalSel::planar_accelerometer);
+static uint8_t cal_desired = CAL_HUB_DEFAULT;     // dynamic calibration sensors asked for
+static uint8_t cal_live = CAL_HUB_DEFAULT;        // what the hub runs, back to the default on reset
+static std::atomic<bool> reset_requested{false};
+static std::atomic<uint32_t> last_sample_us{0};    // newest sample arrival or enable, imu_hub_check()'s heartbeat
+static std::array<imu_seqlock<imu_sample_t>, SH2_MAX_SENSOR_ID + 1> latest_cache;
+static std::array<std::atomic<bool>, SH2_MAX_SENSOR_ID + 1> rpt_batched{};   // delivered through the hub FIFO
+static std::atomic<bool> ring_started{false};
+static int64_t cal_init_us = 0;
+static std::atomic<int64_t> cal_high_us{-1};    // first HIGH accuracy rotation vector, -1 until seen
+#if IMU_METRICS_ENABLED
+static std::array<imu_rpt_metrics_slot, SH2_MAX_SENSOR_ID + 1> rpt_metrics;
+static std::array<std::atomic<uint32_t>, SH2_MAX_SENSOR_ID + 1> metrics_period_us{};  // 0: no gap detection
+static std::atomic<uint32_t> metrics_cb_cycles{0};    // every report's callbacks, wraps
+#endif
+
+static void imu_hub_reset_cb();
+static bool imu_recovery_init();
+static bool imu_requested_reset(bool (BNO08x::*reset)());
+
 bool imu_init() {
+    static bool reset_cb_registered = false;
+    cal_init_us = esp_timer_get_time();
+    cal_high_us.store(-1, std::memory_order_relaxed);
+
     if (!imu.initialize()) {
 
         ESP_LOGE(TAG, "Init failure, returning from imu_driver.");
         return false;
     }
 
+    // initialize() reset the hub, nothing is running and nothing is owed a replay
+    enabled_rpts.store(0, std::memory_order_relaxed);
+    desired_rpts.store(0, std::memory_order_relaxed);
+    cal_desired = CAL_HUB_DEFAULT;
+    cal_live = CAL_HUB_DEFAULT;
+    if (!reset_cb_registered) {
+        imu_recovery_init();
+        if (!imu_lib_register_reset_cb(imu, imu_hub_reset_cb)) {
+            ESP_LOGW(TAG, "esp32_BNO08x has no reset callback, hub resets are found by imu_hub_check()");
+        }
+        reset_cb_registered = true;
+    }
+
+    imu_cal_restore();
+
     ESP_LOGI(TAG, "IMU - INITIALIZED");
     return true;
 }
@@ -27,24 +134,69 @@ bool imu_destructor() {
     return true;
 }
 
+// the reset message clears the hub state, the replay runs here once it arrived rather than from the callback
 bool imu_hard_reset() {
-    imu.hard_reset();
+    if (!imu_requested_reset(&BNO08x::hard_reset)) {
+        return false;
+    }
     ESP_LOGI(TAG, "IMU - HARD RESET");
+    imu_recover();
     return true;
 }
 
 bool imu_soft_reset() {
-    imu.soft_reset();
+    if (!imu_requested_reset(&BNO08x::soft_reset)) {
+        return false;
+    }
     ESP_LOGI(TAG, "IMU - SOFT RESET");
+    imu_recover();
     return true;
 }
 
 bool imu_disable_all_rpts() {
-    imu.disable_all_reports();
+    if (!imu.disable_all_reports()) {
+        ESP_LOGE(TAG, "Failed to disable all reports");
+        return false;
+    }
+    enabled_rpts.store(0, std::memory_order_relaxed);
+    desired_rpts.store(0, std::memory_order_relaxed);
     ESP_LOGI(TAG, "IMU - ALL REPORTS DISABLED");
     return true;
 }
 
+/// @brief Move the hub's calibration config from one sensor set to another, sending only the bits that differ
+static bool imu_cal_config_apply(uint8_t from, uint8_t to, uint32_t &commands) {
+    const uint8_t on = to & ~from;
+    const uint8_t off = from & ~to & CAL_ALL_SENSORS;
+    bool ok = true;
+    if (on != 0) {
+        commands++;
+        ok = imu_lib_cal_select(imu, on, true);
+    }
+    if (off != 0) {
+        commands++;
+        ok = imu_lib_cal_select(imu, off, false) && ok;
+    }
+    return ok;
+}
+
+bool imu_set_dynamic_calibration(uint8_t sensors) {
+    if (!imu_lib_has_cal_select<BNO08x>) {
+        ESP_LOGE(TAG, "esp32_BNO08x cannot select dynamic calibration sensors");
+        return false;
+    }
+    sensors &= CAL_ALL_SENSORS;
+    cal_desired = sensors;
+
+    uint32_t commands = 0;
+    if (!imu_cal_config_apply(cal_live, sensors, commands)) {
+        ESP_LOGE(TAG, "Failed to set dynamic calibration sensors 0x%02X", sensors);
+        return false;
+    }
+    cal_live = sensors;
+    return true;
+}
+
 int imu_get_int_pin() {
     bno08x_config_t imu_config; 
     return imu_config.io_int;
@@ -71,6 +223,7 @@ bool imu_dynamic_calibration() {
     ESP_LOGI(TAG, "");
     
     if(imu.dynamic_calibration_run_routine()) {
+        imu_cal_save();
         ESP_LOGI(TAG, "");
         ESP_LOGI(TAG, "========================================");
         ESP_LOGI(TAG, "   CALIBRATION COMPLETE - SUCCESS!");
@@ -85,7 +238,28 @@ bool imu_dynamic_calibration() {
     }
 }
 
-bool imu_frs_read(BNO08xFrsID frs_id, uint32_t (&data)[16], uint16_t &rx_data_sz) {
+// ============================================================================
+// FRS access: every handshake goes through imu_frs_bus_read/write. The cache
+// keeps the records in RAM, stages changes and commits them in one session,
+// reading each written record back to verify it.
+// ============================================================================
+
+typedef struct imu_frs_slot_t {
+    uint16_t frs_id;
+    uint16_t size;
+    bool valid;
+    bool dirty;
+    uint32_t last_use;
+    uint32_t data[16];
+} imu_frs_slot_t;
+
+static std::mutex frs_lock;
+static std::array<imu_frs_slot_t, IMU_FRS_CACHE_SLOTS> frs_cache{};
+static uint32_t frs_use_clock = 0;
+static imu_frs_cache_stats_t frs_stats = {};
+
+static bool imu_frs_bus_read(BNO08xFrsID frs_id, uint32_t (&data)[16], uint16_t &rx_data_sz) {
+    frs_stats.bus_reads++;
     if (!imu.get_frs(frs_id, data, rx_data_sz)) {
         ESP_LOGE(TAG, "Failed to read FRS record: %s (0x%04X)",
                  BNO08xFrsID_to_str(frs_id), static_cast<uint16_t>(frs_id));
@@ -95,302 +269,858 @@ bool imu_frs_read(BNO08xFrsID frs_id, uint32_t (&data)[16], uint16_t &rx_data_sz
     return true;
 }
 
+static bool imu_frs_bus_write(BNO08xFrsID frs_id, uint32_t *data, uint16_t tx_data_sz) {
+    frs_stats.bus_writes++;
+    if (!imu.write_frs(frs_id, data, tx_data_sz)) {
+        ESP_LOGE(TAG, "Failed to write FRS record: %s (0x%04X)",
+                 BNO08xFrsID_to_str(frs_id), static_cast<uint16_t>(frs_id));
+        return false;
+    }
+    ESP_LOGI(TAG, "FRS write success: %s, %u words", BNO08xFrsID_to_str(frs_id), tx_data_sz);
+    return true;
+}
+
+static imu_frs_slot_t *imu_frs_find_slot(BNO08xFrsID frs_id) {
+    for (imu_frs_slot_t &slot : frs_cache) {
+        if (slot.valid && slot.frs_id == static_cast<uint16_t>(frs_id)) {
+            slot.last_use = ++frs_use_clock;
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+static bool imu_frs_commit_locked();
+
+/// @brief Free slot, else the least recently used clean one, else commit to make every slot clean
+static imu_frs_slot_t *imu_frs_alloc_slot(BNO08xFrsID frs_id) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        imu_frs_slot_t *victim = nullptr;
+        for (imu_frs_slot_t &slot : frs_cache) {
+            if (!slot.valid) {
+                victim = &slot;
+                break;
+            }
+            if (!slot.dirty && (victim == nullptr || slot.last_use < victim->last_use)) {
+                victim = &slot;
+            }
+        }
+
+        if (victim != nullptr) {
+            if (victim->valid) {
+                frs_stats.evictions++;
+            }
+            victim->frs_id = static_cast<uint16_t>(frs_id);
+            victim->size = 0;
+            victim->valid = true;
+            victim->dirty = false;
+            victim->last_use = ++frs_use_clock;
+            return victim;
+        }
+
+        if (!imu_frs_commit_locked()) {
+            break;
+        }
+    }
+
+    ESP_LOGE(TAG, "FRS cache full of uncommitted records");
+    return nullptr;
+}
+
+/// @brief Keep a cached clean copy in step with a direct bus transfer
+static void imu_frs_refresh_slot(BNO08xFrsID frs_id, const uint32_t *data, uint16_t size) {
+    imu_frs_slot_t *slot = imu_frs_find_slot(frs_id);
+    if (slot != nullptr && !slot->dirty) {
+        std::memcpy(slot->data, data, size * sizeof(uint32_t));
+        slot->size = size;
+    }
+}
+
+bool imu_frs_read(BNO08xFrsID frs_id, uint32_t (&data)[16], uint16_t &rx_data_sz) {
+    std::lock_guard<std::mutex> guard(frs_lock);
+    if (!imu_frs_bus_read(frs_id, data, rx_data_sz)) {
+        return false;
+    }
+    imu_frs_refresh_slot(frs_id, data, rx_data_sz);
+    return true;
+}
+
 bool imu_frs_write(BNO08xFrsID frs_id, uint32_t *data, uint16_t tx_data_sz) {
     if (data == nullptr || tx_data_sz == 0) {
         ESP_LOGE(TAG, "Invalid FRS write parameters");
         return false;
     }
 
-    if (!imu.write_frs(frs_id, data, tx_data_sz)) {
-        ESP_LOGE(TAG, "Failed to write FRS record: %s (0x%04X)",
-                 BNO08xFrsID_to_str(frs_id), static_cast<uint16_t>(frs_id));
+    std::lock_guard<std::mutex> guard(frs_lock);
+    if (!imu_frs_bus_write(frs_id, data, tx_data_sz)) {
         return false;
     }
-    ESP_LOGI(TAG, "FRS write success: %s, %u words", BNO08xFrsID_to_str(frs_id), tx_data_sz);
+    imu_frs_refresh_slot(frs_id, data, tx_data_sz);
+    return true;
+}
+
+bool imu_frs_cached_read(BNO08xFrsID frs_id, uint32_t (&data)[16], uint16_t &rx_data_sz) {
+    std::lock_guard<std::mutex> guard(frs_lock);
+    imu_frs_slot_t *slot = imu_frs_find_slot(frs_id);
+    if (slot != nullptr) {
+        frs_stats.hits++;
+        std::memcpy(data, slot->data, slot->size * sizeof(uint32_t));
+        rx_data_sz = slot->size;
+        return true;
+    }
+
+    frs_stats.misses++;
+    if (!imu_frs_bus_read(frs_id, data, rx_data_sz)) {
+        return false;
+    }
+
+    // a full cache of dirty records still returns the data, it just is not kept
+    slot = imu_frs_alloc_slot(frs_id);
+    if (slot != nullptr) {
+        std::memcpy(slot->data, data, rx_data_sz * sizeof(uint32_t));
+        slot->size = rx_data_sz;
+    }
+    return true;
+}
+
+bool imu_frs_stage(BNO08xFrsID frs_id, const uint32_t *data, uint16_t tx_data_sz) {
+    if (data == nullptr || tx_data_sz == 0 || tx_data_sz > 16) {
+        ESP_LOGE(TAG, "Invalid FRS stage parameters");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(frs_lock);
+    imu_frs_slot_t *slot = imu_frs_find_slot(frs_id);
+    if (slot != nullptr && slot->size == tx_data_sz &&
+            std::memcmp(slot->data, data, tx_data_sz * sizeof(uint32_t)) == 0) {
+        return true;
+    }
+
+    if (slot == nullptr && (slot = imu_frs_alloc_slot(frs_id)) == nullptr) {
+        return false;
+    }
+
+    std::memcpy(slot->data, data, tx_data_sz * sizeof(uint32_t));
+    slot->size = tx_data_sz;
+    slot->dirty = true;
     return true;
 }
 
+static bool imu_frs_commit_locked() {
+    std::array<bool, IMU_FRS_CACHE_SLOTS> written{};
+    size_t n_written = 0;
+    bool ok = true;
+
+    // write every dirty record first, then verify, so the session is one burst of bus traffic
+    for (size_t i = 0; i < frs_cache.size(); i++) {
+        imu_frs_slot_t &slot = frs_cache[i];
+        if (!slot.valid || !slot.dirty) {
+            continue;
+        }
+        written[i] = imu_frs_bus_write(static_cast<BNO08xFrsID>(slot.frs_id), slot.data, slot.size);
+        ok &= written[i];
+        n_written += written[i] ? 1 : 0;
+    }
+
+    for (size_t i = 0; i < frs_cache.size(); i++) {
+        if (!written[i]) {
+            continue;
+        }
+
+        imu_frs_slot_t &slot = frs_cache[i];
+        uint32_t readback[16] = {0};
+        uint16_t size = 0;
+        if (imu_frs_bus_read(static_cast<BNO08xFrsID>(slot.frs_id), readback, size) && size == slot.size &&
+                std::memcmp(readback, slot.data, size * sizeof(uint32_t)) == 0) {
+            slot.dirty = false;
+            continue;
+        }
+
+        frs_stats.verify_failures++;
+        ok = false;
+        ESP_LOGE(TAG, "FRS verify failed: %s (0x%04X), record stays dirty",
+                 BNO08xFrsID_to_str(static_cast<BNO08xFrsID>(slot.frs_id)), slot.frs_id);
+    }
+
+    if (n_written != 0) {
+        frs_stats.commits++;
+    }
+    return ok;
+}
+
+bool imu_frs_commit() {
+    std::lock_guard<std::mutex> guard(frs_lock);
+    return imu_frs_commit_locked();
+}
+
+size_t imu_frs_dirty_count() {
+    std::lock_guard<std::mutex> guard(frs_lock);
+    size_t n = 0;
+    for (const imu_frs_slot_t &slot : frs_cache) {
+        n += (slot.valid && slot.dirty) ? 1 : 0;
+    }
+    return n;
+}
+
+void imu_frs_invalidate(BNO08xFrsID frs_id) {
+    std::lock_guard<std::mutex> guard(frs_lock);
+    imu_frs_slot_t *slot = imu_frs_find_slot(frs_id);
+    if (slot != nullptr) {
+        slot->valid = false;
+    }
+}
+
+void imu_frs_invalidate_all() {
+    std::lock_guard<std::mutex> guard(frs_lock);
+    for (imu_frs_slot_t &slot : frs_cache) {
+        slot.valid = false;
+    }
+}
+
+imu_frs_cache_stats_t imu_frs_cache_get_stats() {
+    std::lock_guard<std::mutex> guard(frs_lock);
+    return frs_stats;
+}
+
+void imu_frs_cache_reset_stats() {
+    std::lock_guard<std::mutex> guard(frs_lock);
+    frs_stats = {};
+}
+
 void imu_frs_dump(BNO08xFrsID frs_id) {
     uint32_t data[16] = {0};
     uint16_t size = 0;
 
-    if (!imu_frs_read(frs_id, data, size)) {
+    if (!imu_frs_cached_read(frs_id, data, size)) {
         ESP_LOGE(TAG, "FRS dump failed for %s", BNO08xFrsID_to_str(frs_id));
         return;
     }
 
-    ESP_LOGI(TAG, "=== FRS Dump: %s (0x%04X) ===",
-             BNO08xFrsID_to_str(frs_id), static_cast<uint16_t>(frs_id));
+    ESP_LOGI(TAG, "=== FRS Dump: %s (0x%04X)%s ===", BNO08xFrsID_to_str(frs_id), static_cast<uint16_t>(frs_id),
+             (imu_frs_dirty_count() != 0) ? ", uncommitted changes pending" : "");
     ESP_LOGI(TAG, "Size: %u words", size);
     for (uint16_t i = 0; i < size; i++) {
-        ESP_LOGI(TAG, "  Word[%u]: 0x%08lX (%lu)", i, data[i], data[i]);
+        BINLOG_I(TAG, "  Word[%u]: 0x%08lX (%lu)", i, data[i], data[i]);
     }
     ESP_LOGI(TAG, "=== End FRS Dump ===");
 }
 
 // ============================================================================
-// Significant Motion Detector Configuration (FRS 0xC274)
-// Q24 = 16777216, Q26 = 67108864
+// Typed FRS records, decoded from the cache
+// Q24 = 16777216, Q26 = 67108864, Q30 = 1073741824
 // ============================================================================
 static constexpr float Q24_SCALE = 16777216.0f;
 static constexpr float Q26_SCALE = 67108864.0f;
+static constexpr float Q30_SCALE = 1073741824.0f;
 
-bool imu_get_sig_motion_config(imu_sig_motion_config_t &config) {
-    uint32_t data[16] = {0};
+static inline float imu_q_to_float(uint32_t word, float scale) {
+    return static_cast<int32_t>(word) / scale;
+}
+
+static inline uint32_t imu_float_to_q(float value, float scale) {
+    return static_cast<uint32_t>(static_cast<int32_t>(value * scale));
+}
+
+static bool imu_frs_get_words(BNO08xFrsID frs_id, uint32_t (&data)[16], uint16_t min_words) {
     uint16_t size = 0;
+    if (!imu_frs_cached_read(frs_id, data, size)) {
+        return false;
+    }
+
+    if (size < min_words) {
+        ESP_LOGE(TAG, "%s too small: %u words", BNO08xFrsID_to_str(frs_id), size);
+        return false;
+    }
+    return true;
+}
 
-    if (!imu_frs_read(BNO08xFrsID::SIG_MOTION_DETECT_CONFIG, data, size)) {
+static bool imu_frs_set_words(BNO08xFrsID frs_id, const uint32_t *data, uint16_t size, bool commit) {
+    if (!imu_frs_stage(frs_id, data, size)) {
         return false;
     }
+    return !commit || imu_frs_commit();
+}
 
-    if (size < 2) {
-        ESP_LOGE(TAG, "Sig motion config too small: %u words", size);
+bool imu_get_sig_motion_config(imu_sig_motion_config_t &config) {
+    uint32_t data[16] = {0};
+    if (!imu_frs_get_words(BNO08xFrsID::SIG_MOTION_DETECT_CONFIG, data, 2)) {
         return false;
     }
 
     // Word 0: Acceleration threshold (Q24 signed fixed point)
-    config.accel_threshold_ms2 = static_cast<int32_t>(data[0]) / Q24_SCALE;
+    config.accel_threshold_ms2 = imu_q_to_float(data[0], Q24_SCALE);
     // Word 1: Step threshold (unsigned integer)
     config.step_threshold = data[1];
 
     return true;
 }
 
-bool imu_set_sig_motion_config(const imu_sig_motion_config_t &config) {
+bool imu_set_sig_motion_config(const imu_sig_motion_config_t &config, bool commit) {
     uint32_t data[2];
 
     // Word 0: Acceleration threshold (Q24)
-    data[0] = static_cast<uint32_t>(static_cast<int32_t>(config.accel_threshold_ms2 * Q24_SCALE));
+    data[0] = imu_float_to_q(config.accel_threshold_ms2, Q24_SCALE);
     // Word 1: Step threshold
     data[1] = config.step_threshold;
 
-    return imu_frs_write(BNO08xFrsID::SIG_MOTION_DETECT_CONFIG, data, 2);
-}
-
-void imu_print_sig_motion_config(const imu_sig_motion_config_t &config) {
-    ESP_LOGI(TAG, "=== Significant Motion Config ===");
-    ESP_LOGI(TAG, "  Accel Threshold: %.2f m/s^2", config.accel_threshold_ms2);
-    ESP_LOGI(TAG, "  Step Threshold:  %lu steps", config.step_threshold);
-    ESP_LOGI(TAG, "=================================");
+    return imu_frs_set_words(BNO08xFrsID::SIG_MOTION_DETECT_CONFIG, data, 2, commit);
 }
 
+bool imu_get_stability_config(imu_stability_config_t &config) {
+    uint32_t data[16] = {0};
+    if (!imu_frs_get_words(BNO08xFrsID::STABILITY_DETECTOR_CONFIG, data, 2)) {
+        return false;
+    }
 
-bool imu_get_meta_data(sh2_SensorId_t report_id, bno08x_meta_data_t &meta_data) {
-    switch (report_id) {
-        case SH2_RAW_ACCELEROMETER:
-            return imu.rpt.raw_accelerometer.get_meta_data(meta_data);
+    // Word 0: Acceleration threshold (Q24), Word 1: Duration (us)
+    config.accel_threshold_ms2 = imu_q_to_float(data[0], Q24_SCALE);
+    config.duration_us = data[1];
+    return true;
+}
 
-        case SH2_GYROSCOPE_CALIBRATED:
-            return imu.rpt.cal_gyro.get_meta_data(meta_data);
+bool imu_set_stability_config(const imu_stability_config_t &config, bool commit) {
+    const uint32_t data[2] = {imu_float_to_q(config.accel_threshold_ms2, Q24_SCALE), config.duration_us};
+    return imu_frs_set_words(BNO08xFrsID::STABILITY_DETECTOR_CONFIG, data, 2, commit);
+}
 
-        case SH2_GYROSCOPE_UNCALIBRATED:
-            return imu.rpt.uncal_gyro.get_meta_data(meta_data);
+bool imu_get_shake_config(imu_shake_config_t &config) {
+    uint32_t data[16] = {0};
+    if (!imu_frs_get_words(BNO08xFrsID::SHAKE_DETECT_CONFIG, data, 5)) {
+        return false;
+    }
 
-        case SH2_RAW_MAGNETOMETER:
-            return imu.rpt.raw_magnetometer.get_meta_data(meta_data);
+    // Word 0: Threshold (Q24), Words 1-2: Min/max time between direction changes (us),
+    // Word 3: Direction changes, Word 4: Enabled axes
+    config.accel_threshold_ms2 = imu_q_to_float(data[0], Q24_SCALE);
+    config.min_time_us = data[1];
+    config.max_time_us = data[2];
+    config.direction_changes = data[3];
+    config.enabled_axes = data[4];
+    return true;
+}
 
-        case SH2_MAGNETIC_FIELD_CALIBRATED:
-            return imu.rpt.cal_magnetometer.get_meta_data(meta_data);
+bool imu_set_shake_config(const imu_shake_config_t &config, bool commit) {
+    const uint32_t data[5] = {imu_float_to_q(config.accel_threshold_ms2, Q24_SCALE), config.min_time_us,
+                              config.max_time_us, config.direction_changes, config.enabled_axes};
+    return imu_frs_set_words(BNO08xFrsID::SHAKE_DETECT_CONFIG, data, 5, commit);
+}
 
-        case SH2_MAGNETIC_FIELD_UNCALIBRATED:
-            return imu.rpt.uncal_magnetometer.get_meta_data(meta_data);
+bool imu_get_system_orientation(imu_orientation_t &orientation) {
+    uint32_t data[16] = {0};
+    uint16_t size = 0;
+    if (!imu_frs_cached_read(BNO08xFrsID::SYSTEM_ORIENTATION, data, size)) {
+        return false;
+    }
 
-        case SH2_ROTATION_VECTOR:
-            return imu.rpt.rv.get_meta_data(meta_data);
+    // an empty record is the identity rotation
+    if (size == 0) {
+        orientation = {1.0f, 0.0f, 0.0f, 0.0f};
+        return true;
+    }
+    if (size < 4) {
+        ESP_LOGE(TAG, "%s too small: %u words", BNO08xFrsID_to_str(BNO08xFrsID::SYSTEM_ORIENTATION), size);
+        return false;
+    }
 
-        case SH2_GAME_ROTATION_VECTOR:
-            return imu.rpt.rv_game.get_meta_data(meta_data);
+    // Words 0-3: X, Y, Z, W (Q30)
+    orientation.i = imu_q_to_float(data[0], Q30_SCALE);
+    orientation.j = imu_q_to_float(data[1], Q30_SCALE);
+    orientation.k = imu_q_to_float(data[2], Q30_SCALE);
+    orientation.real = imu_q_to_float(data[3], Q30_SCALE);
+    return true;
+}
 
-        case SH2_ARVR_STABILIZED_RV:
-            return imu.rpt.rv_ARVR_stabilized.get_meta_data(meta_data);
+bool imu_set_system_orientation(const imu_orientation_t &orientation, bool commit) {
+    const uint32_t data[4] = {imu_float_to_q(orientation.i, Q30_SCALE), imu_float_to_q(orientation.j, Q30_SCALE),
+                              imu_float_to_q(orientation.k, Q30_SCALE), imu_float_to_q(orientation.real, Q30_SCALE)};
+    return imu_frs_set_words(BNO08xFrsID::SYSTEM_ORIENTATION, data, 4, commit);
+}
 
-        case SH2_ARVR_STABILIZED_GRV:
-            return imu.rpt.rv_ARVR_stabilized_game.get_meta_data(meta_data);
+bool imu_get_max_fusion_period(uint32_t &period_us) {
+    uint32_t data[16] = {0};
+    if (!imu_frs_get_words(BNO08xFrsID::MAX_FUSION_PERIOD, data, 1)) {
+        return false;
+    }
 
-        case SH2_GYRO_INTEGRATED_RV:
-            return imu.rpt.rv_gyro_integrated.get_meta_data(meta_data);
+    period_us = data[0];
+    return true;
+}
 
-        case SH2_GEOMAGNETIC_ROTATION_VECTOR:
-            return imu.rpt.rv_geomagnetic.get_meta_data(meta_data);
+bool imu_set_max_fusion_period(uint32_t period_us, bool commit) {
+    return imu_frs_set_words(BNO08xFrsID::MAX_FUSION_PERIOD, &period_us, 1, commit);
+}
 
-        case SH2_PERSONAL_ACTIVITY_CLASSIFIER:
-            return imu.rpt.activity_classifier.get_meta_data(meta_data);
+void imu_print_sig_motion_config(const imu_sig_motion_config_t &config) {
+    ESP_LOGI(TAG, "=== Significant Motion Config ===");
+    ESP_LOGI(TAG, "  Accel Threshold: %.2f m/s^2", config.accel_threshold_ms2);
+    ESP_LOGI(TAG, "  Step Threshold:  %lu steps", config.step_threshold);
+    ESP_LOGI(TAG, "=================================");
+}
 
-        case SH2_STABILITY_CLASSIFIER:
-            return imu.rpt.stability_classifier.get_meta_data(meta_data);
 
-        case SH2_SHAKE_DETECTOR:
-            return imu.rpt.shake_detector.get_meta_data(meta_data);
+// ============================================================================
+// Dynamic calibration persistence: the hub saves its DCD to FRS 0x1F1F, the
+// driver keeps a CRC protected copy in NVS with the boot it was taken on and
+// writes it back when the hub comes up without it.
+// ============================================================================
 
-        case SH2_STEP_COUNTER:
-            return imu.rpt.step_counter.get_meta_data(meta_data);
+static constexpr const char *CAL_NVS_NAMESPACE = "imu_cal";
+static constexpr const char *CAL_NVS_KEY_DCD = "dcd";
+static constexpr const char *CAL_NVS_KEY_BOOTS = "boots";
+static constexpr uint32_t CAL_MAGIC = 0x31444344UL;    // "DCD1"
+static constexpr uint16_t CAL_VERSION = 1;
+
+typedef struct imu_cal_snapshot_t {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t words;
+    uint32_t boot;
+    uint32_t dcd[16];
+    uint32_t crc;   ///< CRC-32 of every field above
+} imu_cal_snapshot_t;
+
+static imu_cal_stats_t cal_stats = {IMU_CAL_RESTORE_NONE, 0, 0, 0, -1};
+static int64_t cal_last_save_us = -1;
+
+static uint32_t imu_cal_crc(const imu_cal_snapshot_t &snap) {
+    return esp_rom_crc32_le(0, reinterpret_cast<const uint8_t *>(&snap), offsetof(imu_cal_snapshot_t, crc));
+}
 
-        case SH2_SIGNIFICANT_MOTION:
-            return imu.rpt.significant_motion.get_meta_data(meta_data);
+static bool imu_cal_nvs_open(nvs_handle_t &nvs) {
+    esp_err_t err = nvs_open(CAL_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_ERR_NVS_NOT_INITIALIZED) {
+        // the application normally brings NVS up, never erase its partition from here
+        err = nvs_flash_init();
+        if (err == ESP_OK) {
+            err = nvs_open(CAL_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+        }
+    }
 
-        default:
-            ESP_LOGE(TAG, "Invalid report ID: %d", report_id);
-            return false;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Calibration NVS unavailable: %s", esp_err_to_name(err));
+        return false;
     }
     return true;
 }
 
+static bool imu_cal_snapshot_valid(const imu_cal_snapshot_t &snap, size_t len) {
+    return len == sizeof(snap) && snap.magic == CAL_MAGIC && snap.version == CAL_VERSION &&
+           snap.words != 0 && snap.words <= 16 && snap.crc == imu_cal_crc(snap);
+}
 
-bool imu_enable_rpt(sh2_SensorId_t report_id, uint32_t period_us, sh2_SensorConfig_t config) {
-    switch (report_id) {
-        case SH2_RAW_ACCELEROMETER:
-            return imu.rpt.raw_accelerometer.enable(period_us, config);
+static imu_cal_restore_t imu_cal_write_dcd(const imu_cal_snapshot_t &snap) {
+    uint32_t hub_dcd[16] = {0};
+    uint16_t hub_words = 0;
+    if (imu_frs_read(BNO08xFrsID::DYNAMIC_CALIBRATION, hub_dcd, hub_words) && hub_words == snap.words &&
+            std::memcmp(hub_dcd, snap.dcd, snap.words * sizeof(uint32_t)) == 0) {
+        return IMU_CAL_RESTORE_CURRENT;
+    }
 
-        case SH2_ACCELEROMETER:
-            return imu.rpt.accelerometer.enable(period_us, config);
+    uint32_t dcd[16];
+    std::memcpy(dcd, snap.dcd, sizeof(dcd));
+    if (!imu_frs_write(BNO08xFrsID::DYNAMIC_CALIBRATION, dcd, snap.words)) {
+        return IMU_CAL_RESTORE_FAILED;
+    }
 
-        case SH2_LINEAR_ACCELERATION:
-            return imu.rpt.linear_accelerometer.enable(period_us, config);
+    // the hub only loads the DCD record at startup, the reset is ours and the configuration is replayed after it
+    if (imu_requested_reset(&BNO08x::soft_reset)) {
+        imu_recover();
+    }
+    return IMU_CAL_RESTORE_WRITTEN;
+}
 
-        case SH2_GRAVITY:
-            return imu.rpt.gravity.enable(period_us, config);
+imu_cal_restore_t imu_cal_restore() {
+    cal_stats.snapshot_age_boots = 0;
 
-        case SH2_RAW_GYROSCOPE:
-            return imu.rpt.raw_gyro.enable(period_us, config);
+    nvs_handle_t nvs;
+    if (!imu_cal_nvs_open(nvs)) {
+        cal_stats.restore = IMU_CAL_RESTORE_FAILED;
+        return cal_stats.restore;
+    }
 
-        case SH2_GYROSCOPE_CALIBRATED:
-            return imu.rpt.cal_gyro.enable(period_us, config);
+    uint32_t boots = 0;
+    nvs_get_u32(nvs, CAL_NVS_KEY_BOOTS, &boots);    // not found on the first boot
+    cal_stats.boot = ++boots;
+    nvs_set_u32(nvs, CAL_NVS_KEY_BOOTS, boots);
+
+    imu_cal_snapshot_t snap;
+    size_t len = sizeof(snap);
+    esp_err_t err = nvs_get_blob(nvs, CAL_NVS_KEY_DCD, &snap, &len);
+
+    imu_cal_restore_t result;
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        result = IMU_CAL_RESTORE_NONE;
+    } else if (err != ESP_OK && err != ESP_ERR_NVS_INVALID_LENGTH) {
+        ESP_LOGE(TAG, "Calibration snapshot read failed: %s", esp_err_to_name(err));
+        result = IMU_CAL_RESTORE_FAILED;
+    } else if (err != ESP_OK || !imu_cal_snapshot_valid(snap, len)) {
+        nvs_erase_key(nvs, CAL_NVS_KEY_DCD);
+        result = IMU_CAL_RESTORE_CORRUPT;
+    } else {
+        cal_stats.snapshot_age_boots = boots - snap.boot;
+        if (cal_stats.snapshot_age_boots > IMU_CAL_MAX_AGE_BOOTS) {
+            nvs_erase_key(nvs, CAL_NVS_KEY_DCD);
+            result = IMU_CAL_RESTORE_STALE;
+        } else {
+            result = imu_cal_write_dcd(snap);
+        }
+    }
 
-        case SH2_GYROSCOPE_UNCALIBRATED:
-            return imu.rpt.uncal_gyro.enable(period_us, config);
+    nvs_commit(nvs);
+    nvs_close(nvs);
 
-        case SH2_RAW_MAGNETOMETER:
-            return imu.rpt.raw_magnetometer.enable(period_us, config);
+    static constexpr const char *result_str[] = {"none stored", "written", "already current", "stale", "corrupt", "failed"};
+    ESP_LOGI(TAG, "IMU - DCD RESTORE: %s (boot %lu, snapshot age %lu boots)", result_str[result],
+             (unsigned long)cal_stats.boot, (unsigned long)cal_stats.snapshot_age_boots);
+    cal_stats.restore = result;
+    return result;
+}
 
-        case SH2_MAGNETIC_FIELD_CALIBRATED:
-            return imu.rpt.cal_magnetometer.enable(period_us, config);
+bool imu_cal_save() {
+    if (!imu.dynamic_calibration_save()) {
+        ESP_LOGE(TAG, "Hub DCD save failed");
+        return false;
+    }
 
-        case SH2_MAGNETIC_FIELD_UNCALIBRATED:
-            return imu.rpt.uncal_magnetometer.enable(period_us, config);
+    imu_cal_snapshot_t snap = {};
+    uint16_t words = 0;
+    if (!imu_frs_read(BNO08xFrsID::DYNAMIC_CALIBRATION, snap.dcd, words) || words == 0) {
+        ESP_LOGE(TAG, "No DCD record to snapshot");
+        return false;
+    }
 
-        case SH2_ROTATION_VECTOR:
-            return imu.rpt.rv.enable(period_us, config);
+    snap.magic = CAL_MAGIC;
+    snap.version = CAL_VERSION;
+    snap.words = words;
+    snap.boot = cal_stats.boot;
+    snap.crc = imu_cal_crc(snap);
 
-        case SH2_GAME_ROTATION_VECTOR:
-            return imu.rpt.rv_game.enable(period_us, config);
+    nvs_handle_t nvs;
+    if (!imu_cal_nvs_open(nvs)) {
+        return false;
+    }
 
-        case SH2_ARVR_STABILIZED_RV:
-            return imu.rpt.rv_ARVR_stabilized.enable(period_us, config);
+    // identical snapshot from this boot already stored: spare the flash
+    imu_cal_snapshot_t stored;
+    size_t len = sizeof(stored);
+    bool ok = true;
+    if (nvs_get_blob(nvs, CAL_NVS_KEY_DCD, &stored, &len) != ESP_OK || len != sizeof(stored) ||
+            std::memcmp(&stored, &snap, sizeof(snap)) != 0) {
+        esp_err_t err = nvs_set_blob(nvs, CAL_NVS_KEY_DCD, &snap, sizeof(snap));
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Calibration snapshot write failed: %s", esp_err_to_name(err));
+            ok = false;
+        } else {
+            cal_stats.saves++;
+        }
+    }
+    nvs_close(nvs);
 
-        case SH2_ARVR_STABILIZED_GRV:
-            return imu.rpt.rv_ARVR_stabilized_game.enable(period_us, config);
+    if (ok) {
+        cal_last_save_us = esp_timer_get_time();
+        ESP_LOGI(TAG, "IMU - DCD SNAPSHOT: %u words, boot %lu", words, (unsigned long)snap.boot);
+    }
+    return ok;
+}
 
-        case SH2_GYRO_INTEGRATED_RV:
-            return imu.rpt.rv_gyro_integrated.enable(period_us, config);
+bool imu_cal_save_if_converged() {
+    const int64_t now = esp_timer_get_time();
+    if (cal_last_save_us >= 0 && now - cal_last_save_us < static_cast<int64_t>(IMU_CAL_SAVE_INTERVAL_MS) * 1000) {
+        return false;
+    }
 
-        case SH2_GEOMAGNETIC_ROTATION_VECTOR:
-            return imu.rpt.rv_geomagnetic.enable(period_us, config);
+    // a disabled report still holds its last value, only trust a live rotation vector
+    if ((enabled_rpts.load(std::memory_order_relaxed) & (1ULL << SH2_ROTATION_VECTOR)) == 0 ||
+            imu.rpt.rv.get_quat().accuracy != BNO08xAccuracy::HIGH) {
+        return false;
+    }
 
-        case SH2_PERSONAL_ACTIVITY_CLASSIFIER:
-            return imu.rpt.activity_classifier.enable(period_us, config);
+    // without the ingestion callback the first HIGH sample is only seen here
+    int64_t unseen = -1;
+    cal_high_us.compare_exchange_strong(unseen, now, std::memory_order_relaxed);
+    return imu_cal_save();
+}
 
-        case SH2_STABILITY_CLASSIFIER:
-            return imu.rpt.stability_classifier.enable(period_us, config);
+bool imu_cal_erase() {
+    nvs_handle_t nvs;
+    if (!imu_cal_nvs_open(nvs)) {
+        return false;
+    }
 
-        case SH2_SHAKE_DETECTOR:
-            return imu.rpt.shake_detector.enable(period_us, config);
+    esp_err_t err = nvs_erase_key(nvs, CAL_NVS_KEY_DCD);
+    nvs_commit(nvs);
+    nvs_close(nvs);
+    return err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND;
+}
 
-        case SH2_STEP_COUNTER:
-            return imu.rpt.step_counter.enable(period_us, config);
+imu_cal_stats_t imu_cal_get_stats() {
+    imu_cal_stats_t stats = cal_stats;
+    const int64_t high_us = cal_high_us.load(std::memory_order_relaxed);
+    stats.boot_to_high_us = (high_us < 0) ? -1 : high_us - cal_init_us;
+    return stats;
+}
 
-        case SH2_SIGNIFICANT_MOTION:
-            return imu.rpt.significant_motion.enable(period_us, config);
 
-            
-        default:
-            ESP_LOGE(TAG, "Invalid report ID: %d", report_id);
-            return false;
-    }
-    return true;
+// ============================================================================
+// Report registry: one constexpr table indexed by sh2_SensorId_t replaces the
+// per-operation switch statements. Every report object derives from BNO08xRpt,
+// so enable/disable/has_new_data/get_meta_data dispatch through one pointer.
+// ============================================================================
+
+typedef struct imu_rpt_entry_t {
+    BNO08xRpt *rpt;
+    uint8_t caps;
+} imu_rpt_entry_t;
+
+typedef struct imu_rpt_def_t {
+    uint8_t id;
+    BNO08xRpt *rpt;
+    uint8_t caps;
+} imu_rpt_def_t;
+
+static constexpr uint8_t CAP_SAMPLED = IMU_RPT_CAP_CONTINUOUS | IMU_RPT_CAP_BATCHABLE;
+static constexpr uint8_t CAP_RAW = CAP_SAMPLED | IMU_RPT_CAP_TIMESTAMP;
+
+static constexpr imu_rpt_def_t rpt_defs[] = {
+    {SH2_RAW_ACCELEROMETER,            &imu.rpt.raw_accelerometer,       CAP_RAW},
+    {SH2_ACCELEROMETER,                &imu.rpt.accelerometer,           CAP_SAMPLED},
+    {SH2_LINEAR_ACCELERATION,          &imu.rpt.linear_accelerometer,    CAP_SAMPLED},
+    {SH2_GRAVITY,                      &imu.rpt.gravity,                 CAP_SAMPLED},
+    {SH2_RAW_GYROSCOPE,                &imu.rpt.raw_gyro,                CAP_RAW},
+    {SH2_GYROSCOPE_CALIBRATED,         &imu.rpt.cal_gyro,                CAP_SAMPLED},
+    {SH2_GYROSCOPE_UNCALIBRATED,       &imu.rpt.uncal_gyro,              CAP_SAMPLED},
+    {SH2_RAW_MAGNETOMETER,             &imu.rpt.raw_magnetometer,        CAP_RAW},
+    {SH2_MAGNETIC_FIELD_CALIBRATED,    &imu.rpt.cal_magnetometer,        CAP_SAMPLED},
+    {SH2_MAGNETIC_FIELD_UNCALIBRATED,  &imu.rpt.uncal_magnetometer,      CAP_SAMPLED},
+    {SH2_ROTATION_VECTOR,              &imu.rpt.rv,                      CAP_SAMPLED},
+    {SH2_GAME_ROTATION_VECTOR,         &imu.rpt.rv_game,                 CAP_SAMPLED},
+    {SH2_ARVR_STABILIZED_RV,           &imu.rpt.rv_ARVR_stabilized,      CAP_SAMPLED},
+    {SH2_ARVR_STABILIZED_GRV,          &imu.rpt.rv_ARVR_stabilized_game, CAP_SAMPLED},
+    {SH2_GYRO_INTEGRATED_RV,           &imu.rpt.rv_gyro_integrated,      IMU_RPT_CAP_CONTINUOUS},
+    {SH2_GEOMAGNETIC_ROTATION_VECTOR,  &imu.rpt.rv_geomagnetic,          CAP_SAMPLED},
+    {SH2_PERSONAL_ACTIVITY_CLASSIFIER, &imu.rpt.activity_classifier,     IMU_RPT_CAP_EVENT | IMU_RPT_CAP_BATCHABLE},
+    {SH2_STABILITY_CLASSIFIER,         &imu.rpt.stability_classifier,    IMU_RPT_CAP_EVENT | IMU_RPT_CAP_BATCHABLE},
+    {SH2_SHAKE_DETECTOR,               &imu.rpt.shake_detector,          IMU_RPT_CAP_EVENT | IMU_RPT_CAP_BATCHABLE},
+    {SH2_STEP_COUNTER,                 &imu.rpt.step_counter,            IMU_RPT_CAP_EVENT | IMU_RPT_CAP_BATCHABLE},
+    {SH2_SIGNIFICANT_MOTION,           &imu.rpt.significant_motion,      IMU_RPT_CAP_EVENT | IMU_RPT_CAP_ONE_SHOT},
+};
+
+static constexpr size_t RPT_TABLE_SZ = SH2_MAX_SENSOR_ID + 1;
+static_assert(RPT_TABLE_SZ <= 64, "report masks are 64 bit");
+
+static constexpr std::array<imu_rpt_entry_t, RPT_TABLE_SZ> rpt_table = [] {
+    std::array<imu_rpt_entry_t, RPT_TABLE_SZ> table{};
+    for (const imu_rpt_def_t &def : rpt_defs) {
+        table[def.id] = {def.rpt, def.caps};
+    }
+    return table;
+}();
+
+static inline BNO08xRpt *imu_find_rpt(uint8_t report_id) {
+    return (report_id < RPT_TABLE_SZ) ? rpt_table[report_id].rpt : nullptr;
 }
 
-bool imu_enable_multi_rpts(imu_report_cfg_t *rpts, size_t count) {
-    bool all_enabled = true;
-    for(size_t i = 0; i < count; i++) {
-        if(!imu_enable_rpt(rpts[i].report_id, rpts[i].period_us)) {
-            all_enabled = false;
-        }
+static inline void imu_mark_enabled(uint8_t report_id, bool enabled) {
+    if (enabled) {
+        desired_rpts.fetch_or(IMU_RPT_BIT(report_id), std::memory_order_relaxed);
+        enabled_rpts.fetch_or(IMU_RPT_BIT(report_id), std::memory_order_relaxed);
+    } else {
+        desired_rpts.fetch_and(~IMU_RPT_BIT(report_id), std::memory_order_relaxed);
+        enabled_rpts.fetch_and(~IMU_RPT_BIT(report_id), std::memory_order_relaxed);
     }
-    return all_enabled;
 }
 
+/// @brief Period the metrics hold a report to, only continuous reports delivered one by one have one
+static inline void imu_metrics_expect(uint8_t report_id, uint32_t period_us, const sh2_SensorConfig_t &config) {
+#if IMU_METRICS_ENABLED
+    const bool periodic = (rpt_table[report_id].caps & IMU_RPT_CAP_CONTINUOUS) && config.batchInterval_us == 0;
+    metrics_period_us[report_id].store(periodic ? period_us : 0, std::memory_order_relaxed);
+#else
+    (void)report_id;
+    (void)period_us;
+    (void)config;
+#endif
+}
 
+uint8_t imu_get_rpt_caps(uint8_t report_id) {
+    return (report_id < RPT_TABLE_SZ) ? rpt_table[report_id].caps : static_cast<uint8_t>(IMU_RPT_CAP_NONE);
+}
 
-bool imu_disable_rpt(sh2_SensorId_t report_id) {
-    switch (report_id) {
-        case SH2_RAW_ACCELEROMETER:
-            return imu.rpt.raw_accelerometer.disable();
+uint64_t imu_get_enabled_rpts() {
+    return enabled_rpts.load(std::memory_order_relaxed);
+}
 
-        case SH2_ACCELEROMETER:
-            return imu.rpt.accelerometer.disable();
+bool imu_get_meta_data(uint8_t report_id, bno08x_meta_data_t &meta_data) {
+    BNO08xRpt *rpt = imu_find_rpt(report_id);
+    if (rpt == nullptr) {
+        ESP_LOGE(TAG, "Invalid report ID: %d", report_id);
+        return false;
+    }
+    return rpt->get_meta_data(meta_data);
+}
 
-        case SH2_LINEAR_ACCELERATION:
-            return imu.rpt.linear_accelerometer.disable();
+bool imu_enable_rpt(uint8_t report_id, uint32_t period_us, sh2_SensorConfig_t config) {
+    BNO08xRpt *rpt = imu_find_rpt(report_id);
+    if (rpt == nullptr) {
+        ESP_LOGE(TAG, "Invalid report ID: %d", report_id);
+        return false;
+    }
 
-        case SH2_GRAVITY:
-            return imu.rpt.gravity.disable();
+    if (config.batchInterval_us != 0 && !(rpt_table[report_id].caps & IMU_RPT_CAP_BATCHABLE)) {
+        ESP_LOGW(TAG, "Report %d cannot be batched, enabling unbatched", report_id);
+        config.batchInterval_us = 0;
+    }
 
-        case SH2_RAW_GYROSCOPE:
-            return imu.rpt.raw_gyro.disable();
+    if (!rpt->enable(period_us, config)) {
+        return false;
+    }
+    config.reportInterval_us = period_us;
+    live_cfg[report_id] = {period_us, config};
+    imu_metrics_expect(report_id, period_us, config);
+    rpt_batched[report_id].store(config.batchInterval_us != 0, std::memory_order_relaxed);
+    imu_mark_enabled(report_id, true);
+    last_sample_us.store(static_cast<uint32_t>(esp_timer_get_time()), std::memory_order_relaxed);
+    return true;
+}
 
-        case SH2_GYROSCOPE_CALIBRATED:
-            return imu.rpt.cal_gyro.disable();
+bool imu_enable_rpt_batched(uint8_t report_id, uint32_t period_us, uint32_t batch_us, sh2_SensorConfig_t config) {
+    config.batchInterval_us = batch_us;
+    return imu_enable_rpt(report_id, period_us, config);
+}
 
-        case SH2_GYROSCOPE_UNCALIBRATED:
-            return imu.rpt.uncal_gyro.disable();
+bool imu_enable_multi_rpts(imu_report_cfg_t *rpts, size_t count) {
+    bool all_enabled = true;
+    for(size_t i = 0; i < count; i++) {
+        sh2_SensorConfig_t config = rpts[i].config;
+        if (rpts[i].batch_us != 0) {
+            config.batchInterval_us = rpts[i].batch_us;
+        }
 
-        case SH2_RAW_MAGNETOMETER:
-            return imu.rpt.raw_magnetometer.disable();
+        if(!imu_enable_rpt(rpts[i].report_id, rpts[i].period_us, config)) {
+            all_enabled = false;
+        }
+    }
+    return all_enabled;
+}
 
-        case SH2_MAGNETIC_FIELD_CALIBRATED:
-            return imu.rpt.cal_magnetometer.disable();
+static bool imu_same_sensor_cfg(const sh2_SensorConfig_t &a, const sh2_SensorConfig_t &b) {
+    return a.changeSensitivityEnabled == b.changeSensitivityEnabled &&
+           a.changeSensitivityRelative == b.changeSensitivityRelative &&
+           a.wakeupEnabled == b.wakeupEnabled &&
+           a.alwaysOnEnabled == b.alwaysOnEnabled &&
+           a.sniffEnabled == b.sniffEnabled &&
+           a.changeSensitivity == b.changeSensitivity &&
+           a.batchInterval_us == b.batchInterval_us &&
+           a.sensorSpecific == b.sensorSpecific;
+}
 
-        case SH2_MAGNETIC_FIELD_UNCALIBRATED:
-            return imu.rpt.uncal_magnetometer.disable();
+bool imu_apply_rpt_profile(const imu_report_cfg_t *rpts, size_t count, imu_reconfig_stats_t *stats) {
+    const int64_t start_us = esp_timer_get_time();
+    const uint64_t live = enabled_rpts.load(std::memory_order_relaxed);
+    imu_reconfig_stats_t diff = {};
+    uint64_t wanted = 0;
+    bool all_ok = true;
 
-        case SH2_ROTATION_VECTOR:
-            return imu.rpt.rv.disable();
+    for (size_t i = 0; i < count; i++) {
+        if (imu_find_rpt(rpts[i].report_id) != nullptr) {
+            wanted |= IMU_RPT_BIT(rpts[i].report_id);
+        }
+    }
 
-        case SH2_GAME_ROTATION_VECTOR:
-            return imu.rpt.rv_game.disable();
+    // drop what the new profile no longer wants first, the hub never carries both sets at once
+    uint64_t stale = live & ~wanted;
+    while (stale != 0) {
+        const uint8_t report_id = static_cast<uint8_t>(__builtin_ctzll(stale));
+        stale &= stale - 1;
+        all_ok = imu_disable_rpt(report_id) && all_ok;
+        diff.disabled++;
+    }
 
-        case SH2_ARVR_STABILIZED_RV:
-            return imu.rpt.rv_ARVR_stabilized.disable();
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t report_id = rpts[i].report_id;
+        if (imu_find_rpt(report_id) == nullptr) {
+            ESP_LOGE(TAG, "Invalid report ID: %d", report_id);
+            all_ok = false;
+            continue;
+        }
 
-        case SH2_ARVR_STABILIZED_GRV:
-            return imu.rpt.rv_ARVR_stabilized_game.disable();
+        sh2_SensorConfig_t config = rpts[i].config;
+        if (rpts[i].batch_us != 0) {
+            config.batchInterval_us = rpts[i].batch_us;
+        }
+        if (!(rpt_table[report_id].caps & IMU_RPT_CAP_BATCHABLE)) {
+            config.batchInterval_us = 0;
+        }
 
-        case SH2_GYRO_INTEGRATED_RV:
-            return imu.rpt.rv_gyro_integrated.disable();
+        const bool was_live = (live & IMU_RPT_BIT(report_id)) != 0;
+        if (was_live && !(rpt_table[report_id].caps & IMU_RPT_CAP_ONE_SHOT) &&
+            live_cfg[report_id].period_us == rpts[i].period_us &&
+            imu_same_sensor_cfg(live_cfg[report_id].config, config)) {
+            diff.unchanged++;
+            continue;
+        }
 
-        case SH2_GEOMAGNETIC_ROTATION_VECTOR:
-            return imu.rpt.rv_geomagnetic.disable();
+        // set-feature replaces the running config, no disable needed in between
+        all_ok = imu_enable_rpt(report_id, rpts[i].period_us, config) && all_ok;
+        if (was_live) {
+            diff.changed++;
+        } else {
+            diff.enabled++;
+        }
+    }
 
-        case SH2_PERSONAL_ACTIVITY_CLASSIFIER:
-            return imu.rpt.activity_classifier.disable();
+    diff.duration_us = static_cast<uint32_t>(esp_timer_get_time() - start_us);
+    ESP_LOGI(TAG, "IMU - PROFILE APPLIED: +%u ~%u -%u =%u in %lu us", diff.enabled, diff.changed, diff.disabled,
+             diff.unchanged, (unsigned long)diff.duration_us);
 
-        case SH2_STABILITY_CLASSIFIER:
-            return imu.rpt.stability_classifier.disable();
+    if (stats != nullptr) {
+        *stats = diff;
+    }
+    return all_ok;
+}
 
-        case SH2_SHAKE_DETECTOR:
-            return imu.rpt.shake_detector.disable();
+bool imu_get_rpt_cfg(uint8_t report_id, imu_report_cfg_t &cfg) {
+    if (imu_find_rpt(report_id) == nullptr || !(enabled_rpts.load(std::memory_order_relaxed) & IMU_RPT_BIT(report_id))) {
+        return false;
+    }
 
-        case SH2_STEP_COUNTER:
-            return imu.rpt.step_counter.disable();
+    cfg.report_id = report_id;
+    cfg.period_us = live_cfg[report_id].period_us;
+    cfg.config = live_cfg[report_id].config;
+    cfg.batch_us = cfg.config.batchInterval_us;
+    return true;
+}
 
-        case SH2_SIGNIFICANT_MOTION:
-            return imu.rpt.significant_motion.disable();
+bool imu_flush_rpts() {
+    uint64_t pending = enabled_rpts.load(std::memory_order_relaxed);
+    bool all_flushed = true;
 
-            
-        default:
-            ESP_LOGE(TAG, "Invalid report ID: %d", report_id);
-            return false;
+    while (pending != 0) {
+        const uint8_t report_id = static_cast<uint8_t>(__builtin_ctzll(pending));
+        pending &= pending - 1;
+        if ((rpt_table[report_id].caps & IMU_RPT_CAP_BATCHABLE) && !rpt_table[report_id].rpt->flush()) {
+            all_flushed = false;
+        }
+    }
+    return all_flushed;
+}
+
+bool imu_disable_rpt(uint8_t report_id) {
+    BNO08xRpt *rpt = imu_find_rpt(report_id);
+    if (rpt == nullptr) {
+        ESP_LOGE(TAG, "Invalid report ID: %d", report_id);
+        return false;
+    }
+
+    // a rejected disable leaves the report streaming, the driver's state must keep saying so
+    if (!rpt->disable()) {
+        ESP_LOGE(TAG, "Failed to disable report %d", report_id);
+        return false;
     }
+    imu_mark_enabled(report_id, false);
     return true;
 }
 
@@ -405,183 +1135,1317 @@ bool imu_disable_rpts(imu_report_cfg_t *rpts, size_t count) {
 }
 
 bool imu_rearm_sig_motion(uint32_t period_us, sh2_SensorConfig_t config) {
-    imu.rpt.significant_motion.disable();
+    // the disable clears the one-shot's latched state, the enable alone decides whether it is armed
+    if (!imu.rpt.significant_motion.disable()) {
+        ESP_LOGW(TAG, "Failed to disable significant motion before re-arming");
+    }
 
-    imu.rpt.significant_motion.enable(period_us, config);
+    if (!imu.rpt.significant_motion.enable(period_us, config)) {
+        ESP_LOGE(TAG, "Failed to re-arm significant motion");
+        imu_mark_enabled(SH2_SIGNIFICANT_MOTION, false);
+        return false;
+    }
+    config.reportInterval_us = period_us;
+    live_cfg[SH2_SIGNIFICANT_MOTION] = {period_us, config};
+    imu_mark_enabled(SH2_SIGNIFICANT_MOTION, true);
     ESP_LOGI(TAG, "IMU - SIGNIFICANT MOTION REPORT ENABLED");
     return true;
 }
 
-bool imu_has_new_data(sh2_SensorId_t report_id) {
-    switch (report_id) {
-        case SH2_RAW_ACCELEROMETER:
-            return imu.rpt.raw_accelerometer.has_new_data();
+bool imu_has_new_data(uint8_t report_id) {
+    BNO08xRpt *rpt = imu_find_rpt(report_id);
+    if (rpt == nullptr) {
+        ESP_LOGE(TAG, "Invalid report ID: %d", report_id);
+        return false;
+    }
+    return rpt->has_new_data();
+}
 
-        case SH2_ACCELEROMETER:
-            return imu.rpt.accelerometer.has_new_data();
+uint64_t imu_poll_new_data() {
+    uint64_t pending = enabled_rpts.load(std::memory_order_relaxed);
+    uint64_t fresh = 0;
+
+    while (pending != 0) {
+        const uint8_t report_id = static_cast<uint8_t>(__builtin_ctzll(pending));
+        pending &= pending - 1;
+        if (rpt_table[report_id].rpt->has_new_data()) {
+            fresh |= IMU_RPT_BIT(report_id);
+        }
+    }
+    return fresh;
+}
+
+template <> bno08x_raw_accel_t imu_get<SH2_RAW_ACCELEROMETER>() { return imu.rpt.raw_accelerometer.get(); }
+template <> bno08x_accel_t imu_get<SH2_ACCELEROMETER>() { return imu.rpt.accelerometer.get(); }
+template <> bno08x_accel_t imu_get<SH2_LINEAR_ACCELERATION>() { return imu.rpt.linear_accelerometer.get(); }
+template <> bno08x_accel_t imu_get<SH2_GRAVITY>() { return imu.rpt.gravity.get(); }
+template <> bno08x_raw_gyro_t imu_get<SH2_RAW_GYROSCOPE>() { return imu.rpt.raw_gyro.get(); }
+template <> bno08x_gyro_t imu_get<SH2_GYROSCOPE_CALIBRATED>() { return imu.rpt.cal_gyro.get(); }
+template <> bno08x_gyro_t imu_get<SH2_GYROSCOPE_UNCALIBRATED>() { return imu.rpt.uncal_gyro.get_vel(); }
+template <> bno08x_raw_magf_t imu_get<SH2_RAW_MAGNETOMETER>() { return imu.rpt.raw_magnetometer.get(); }
+template <> bno08x_magf_t imu_get<SH2_MAGNETIC_FIELD_CALIBRATED>() { return imu.rpt.cal_magnetometer.get(); }
+template <> bno08x_magf_t imu_get<SH2_MAGNETIC_FIELD_UNCALIBRATED>() { return imu.rpt.uncal_magnetometer.get_magf(); }
+template <> bno08x_quat_t imu_get<SH2_ROTATION_VECTOR>() { return imu.rpt.rv.get_quat(); }
+template <> bno08x_quat_t imu_get<SH2_GAME_ROTATION_VECTOR>() { return imu.rpt.rv_game.get_quat(); }
+template <> bno08x_quat_t imu_get<SH2_ARVR_STABILIZED_RV>() { return imu.rpt.rv_ARVR_stabilized.get_quat(); }
+template <> bno08x_quat_t imu_get<SH2_ARVR_STABILIZED_GRV>() { return imu.rpt.rv_ARVR_stabilized_game.get_quat(); }
+template <> bno08x_quat_t imu_get<SH2_GYRO_INTEGRATED_RV>() { return imu.rpt.rv_gyro_integrated.get_quat(); }
+template <> bno08x_quat_t imu_get<SH2_GEOMAGNETIC_ROTATION_VECTOR>() { return imu.rpt.rv_geomagnetic.get_quat(); }
+template <> bno08x_activity_classifier_t imu_get<SH2_PERSONAL_ACTIVITY_CLASSIFIER>() { return imu.rpt.activity_classifier.get(); }
+template <> bno08x_stability_classifier_t imu_get<SH2_STABILITY_CLASSIFIER>() { return imu.rpt.stability_classifier.get(); }
+template <> bno08x_shake_detector_t imu_get<SH2_SHAKE_DETECTOR>() { return imu.rpt.shake_detector.get(); }
+template <> bno08x_step_counter_t imu_get<SH2_STEP_COUNTER>() { return imu.rpt.step_counter.get(); }
+template <> bno08x_significant_motion_t imu_get<SH2_SIGNIFICANT_MOTION>() { return imu.rpt.significant_motion.get(); }
+
+bno08x_raw_accel_t imu_get_raw_accel() { return imu_get<SH2_RAW_ACCELEROMETER>(); }
+bno08x_accel_t imu_get_accel() { return imu_get<SH2_ACCELEROMETER>(); }
+bno08x_accel_t imu_get_linear_accel() { return imu_get<SH2_LINEAR_ACCELERATION>(); }
+bno08x_accel_t imu_get_gravity() { return imu_get<SH2_GRAVITY>(); }
+bno08x_raw_gyro_t imu_get_raw_gyro() { return imu_get<SH2_RAW_GYROSCOPE>(); }
+bno08x_gyro_t imu_get_cal_gyro() { return imu_get<SH2_GYROSCOPE_CALIBRATED>(); }
+bno08x_gyro_t imu_get_uncal_gyro() { return imu_get<SH2_GYROSCOPE_UNCALIBRATED>(); }
+bno08x_gyro_bias_t imu_get_gyro_bias() { return imu.rpt.uncal_gyro.get_bias(); }
+bno08x_raw_magf_t imu_get_raw_magf() { return imu_get<SH2_RAW_MAGNETOMETER>(); }
+bno08x_magf_t imu_get_cal_magf() { return imu_get<SH2_MAGNETIC_FIELD_CALIBRATED>(); }
+bno08x_magf_t imu_get_uncal_magf() { return imu_get<SH2_MAGNETIC_FIELD_UNCALIBRATED>(); }
+bno08x_magf_bias_t imu_get_magf_bias() { return imu.rpt.uncal_magnetometer.get_bias(); }
+bno08x_quat_t imu_get_rv() { return imu_get<SH2_ROTATION_VECTOR>(); }
+bno08x_euler_angle_t imu_get_rv_euler(bool degrees) { return imu.rpt.rv.get_euler(degrees); }
+bno08x_quat_t imu_get_rv_geomagnetic() { return imu_get<SH2_GEOMAGNETIC_ROTATION_VECTOR>(); }
+bno08x_euler_angle_t imu_get_rv_geomagnetic_euler(bool degrees) { return imu.rpt.rv_geomagnetic.get_euler(degrees); }
+bno08x_activity_classifier_t imu_get_activity_classifier() { return imu_get<SH2_PERSONAL_ACTIVITY_CLASSIFIER>(); }
+bno08x_stability_classifier_t imu_get_stability_classifier() { return imu_get<SH2_STABILITY_CLASSIFIER>(); }
+bno08x_shake_detector_t imu_get_shake_detector() { return imu_get<SH2_SHAKE_DETECTOR>(); }
+bno08x_step_counter_t imu_get_step_counter() { return imu_get<SH2_STEP_COUNTER>(); }
+bno08x_significant_motion_t imu_get_significant_motion() { return imu_get<SH2_SIGNIFICANT_MOTION>(); }
+
+
+// ============================================================================
+// Clock sync: only the ingestion callback writes the estimate, readers on
+// other tasks copy the published model through a seqlock. See the header for
+// the method.
+// ============================================================================
+
+typedef struct imu_clock_model_t {
+    uint32_t ref_hub_us;
+    uint32_t ref_host_us;
+    float drift_ppm;
+    uint32_t delay_us;
+    uint32_t samples;
+    uint32_t windows;
+    uint32_t resyncs;
+} imu_clock_model_t;
+
+typedef struct imu_clock_point_t {
+    uint32_t hub_us;
+    int32_t offset_us;
+} imu_clock_point_t;
+
+// writer side, ingestion callback only
+typedef struct imu_clock_state_t {
+    imu_clock_model_t model;
+    bool window_open;
+    uint32_t window_start_us;
+    imu_clock_point_t window_min;
+    uint32_t last_hub_us;
+    int32_t delay_q4;
+    imu_clock_point_t minima[IMU_CLOCK_WINDOWS];
+} imu_clock_state_t;
+
+static imu_clock_state_t clock_state{};
+static imu_seqlock<imu_clock_model_t> clock_pub;
+static std::atomic<bool> clock_reset_pending{false};
+
+static inline uint32_t imu_clock_map(const imu_clock_model_t &model, uint32_t hub_us) {
+    const int32_t dt = static_cast<int32_t>(hub_us - model.ref_hub_us);
+    const int32_t correction = static_cast<int32_t>(static_cast<float>(dt) * model.drift_ppm * -1e-6f);
+    return model.ref_host_us + static_cast<uint32_t>(dt) + static_cast<uint32_t>(correction);
+}
+
+static void imu_clock_restart(uint32_t resyncs) {
+    clock_state = imu_clock_state_t{};
+    clock_state.model.resyncs = resyncs;
+}
+
+/// @brief Least squares drift through the stored window minima, centred so float keeps its precision over a long baseline
+static float imu_clock_fit_drift(const imu_clock_point_t *points, uint32_t n) {
+    const imu_clock_point_t &origin = points[0];
+    float mx = 0.0f, my = 0.0f;
+    for (uint32_t i = 0; i < n; i++) {
+        mx += static_cast<float>(static_cast<int32_t>(points[i].hub_us - origin.hub_us));
+        my += static_cast<float>(points[i].offset_us - origin.offset_us);
+    }
+    mx /= static_cast<float>(n);
+    my /= static_cast<float>(n);
+
+    float sxx = 0.0f, sxy = 0.0f;
+    for (uint32_t i = 0; i < n; i++) {
+        const float dx = static_cast<float>(static_cast<int32_t>(points[i].hub_us - origin.hub_us)) - mx;
+        const float dy = static_cast<float>(points[i].offset_us - origin.offset_us) - my;
+        sxx += dx * dx;
+        sxy += dx * dy;
+    }
+    // offset grows when the hub runs slow, hence the sign
+    return (sxx > 0.0f) ? -1e6f * sxy / sxx : 0.0f;
+}
+
+static void imu_clock_close_window() {
+    imu_clock_state_t &st = clock_state;
+    imu_clock_model_t &model = st.model;
+
+    if (model.windows < IMU_CLOCK_WINDOWS) {
+        st.minima[model.windows] = st.window_min;
+    } else {
+        std::memmove(&st.minima[0], &st.minima[1], (IMU_CLOCK_WINDOWS - 1) * sizeof(st.minima[0]));
+        st.minima[IMU_CLOCK_WINDOWS - 1] = st.window_min;
+    }
+    model.windows++;
+
+    const uint32_t points = (model.windows < IMU_CLOCK_WINDOWS) ? model.windows : IMU_CLOCK_WINDOWS;
+    model.drift_ppm = (points >= 2) ? imu_clock_fit_drift(st.minima, points) : 0.0f;
+    model.ref_hub_us = st.window_min.hub_us;
+    model.ref_host_us = st.window_min.hub_us + static_cast<uint32_t>(st.window_min.offset_us);
+    st.window_open = false;
+}
 
+/**
+ * @brief Feed one raw report and get its measurement time on the esp_timer clock
+ * @param hub_us: the report's hub timestamp
+ * @param arrival_us: esp_timer time the callback started at
+ */
+static uint32_t imu_clock_on_raw(uint32_t hub_us, uint32_t arrival_us) {
+    imu_clock_state_t &st = clock_state;
+    const bool stepped = st.model.samples != 0 &&
+            (static_cast<int32_t>(hub_us - st.last_hub_us) < -static_cast<int32_t>(IMU_CLOCK_RESYNC_US) ||
+             static_cast<int32_t>(arrival_us - imu_clock_map(st.model, hub_us)) < -static_cast<int32_t>(IMU_CLOCK_RESYNC_US));
+    if (clock_reset_pending.exchange(false, std::memory_order_relaxed) || stepped) {
+        // hub time went backwards or now maps into the future: the hub clock restarted
+        imu_clock_restart(st.model.resyncs + 1);
+    }
+
+    imu_clock_model_t &model = st.model;
+    const imu_clock_point_t point = {hub_us, static_cast<int32_t>(arrival_us - hub_us)};
+    if (!st.window_open) {
+        st.window_open = true;
+        st.window_start_us = hub_us;
+        st.window_min = point;
+    } else if (point.offset_us < st.window_min.offset_us) {
+        st.window_min = point;
+    }
+    st.last_hub_us = hub_us;
+    model.samples++;
+
+    bool publish = (model.windows == 0);
+    if (model.windows == 0) {
+        // not locked yet, follow the running minimum
+        model.ref_hub_us = st.window_min.hub_us;
+        model.ref_host_us = st.window_min.hub_us + static_cast<uint32_t>(st.window_min.offset_us);
+    }
+    if (hub_us - st.window_start_us >= IMU_CLOCK_WINDOW_MS * 1000UL) {
+        imu_clock_close_window();
+        publish = true;
+    }
+
+    const uint32_t measured_us = imu_clock_map(model, hub_us);
+    const int32_t delay = std::clamp<int32_t>(static_cast<int32_t>(arrival_us - measured_us), 0, 1L << 24);
+    st.delay_q4 += ((delay << 4) - st.delay_q4) >> 4;
+    model.delay_us = static_cast<uint32_t>(st.delay_q4 >> 4);
+
+    if (publish) {
+        clock_pub.write(model);
+    }
+    return measured_us;
+}
+
+/// @brief Measurement time of a report without a hub timestamp
+static inline uint32_t imu_clock_on_arrival(uint8_t report_id, uint32_t arrival_us) {
+    if (clock_state.model.samples == 0 || rpt_batched[report_id].load(std::memory_order_relaxed)) {
+        return arrival_us;
+    }
+    return arrival_us - clock_state.model.delay_us;
+}
+
+bool imu_clock_hub_to_host(uint32_t hub_us, uint32_t &host_us) {
+    imu_clock_model_t model;
+    if (clock_pub.read(model) == 0 || model.samples == 0) {
+        return false;
+    }
+    host_us = imu_clock_map(model, hub_us);
+    return true;
+}
+
+imu_clock_stats_t imu_clock_get_stats() {
+    imu_clock_model_t model{};
+    clock_pub.read(model);
+
+    imu_clock_stats_t stats;
+    stats.locked = model.windows != 0;
+    stats.offset_us = static_cast<int32_t>(model.ref_host_us - model.ref_hub_us);
+    stats.drift_ppm = model.drift_ppm;
+    stats.delay_us = model.delay_us;
+    stats.samples = model.samples;
+    stats.windows = model.windows;
+    stats.resyncs = model.resyncs;
+    return stats;
+}
+
+void imu_clock_reset() {
+    clock_reset_pending.store(true, std::memory_order_relaxed);
+}
+
+
+// ============================================================================
+// Compact samples: the Q point comes from the report, so packing is a scale
+// and a round per component and unpacking one multiply.
+// ============================================================================
+
+void imu_compact_pack(const imu_sample_t &in, imu_compact_sample_t &out) {
+    const uint8_t q = imu_report_q_point(in.report_id);
+    out.timestamp_us = in.timestamp_us;
+    out.report_id = in.report_id;
+    out.format = static_cast<uint8_t>(q | ((in.accuracy & IMU_COMPACT_ACC_MASK) << IMU_COMPACT_ACC_SHIFT));
+
+    switch (imu_sample_kind(in.report_id)) {
+        case IMU_SAMPLE_VEC:
+            out.v[0] = imu_float_to_q16(in.data.vec.x, q);
+            out.v[1] = imu_float_to_q16(in.data.vec.y, q);
+            out.v[2] = imu_float_to_q16(in.data.vec.z, q);
+            break;
+
+        case IMU_SAMPLE_QUAT: {
+            // q and -q are the same rotation, keep the half with real >= 0 so real can be dropped
+            const float sign = (in.data.quat.real < 0.0f) ? -1.0f : 1.0f;
+            out.v[0] = imu_float_to_q16(sign * in.data.quat.i, q);
+            out.v[1] = imu_float_to_q16(sign * in.data.quat.j, q);
+            out.v[2] = imu_float_to_q16(sign * in.data.quat.k, q);
+            break;
+        }
+
+        case IMU_SAMPLE_ACTIVITY:
+            out.v[0] = in.data.activity.state;
+            out.v[1] = in.data.activity.confidence;
+            out.v[2] = 0;
+            break;
+
+        case IMU_SAMPLE_VALUE:
+            out.v[0] = static_cast<int16_t>(in.data.value & 0xFFFFU);
+            out.v[1] = static_cast<int16_t>(in.data.value >> 16);
+            out.v[2] = 0;
+            break;
+    }
+}
+
+void imu_compact_unpack(const imu_compact_sample_t &in, imu_sample_t &out) {
+    const float scale = std::ldexp(1.0f, -static_cast<int>(imu_compact_q_point(in)));
+    out.timestamp_us = in.timestamp_us;
+    out.report_id = in.report_id;
+    out.accuracy = imu_compact_accuracy(in);
+    out.reserved = 0;
+
+    switch (imu_sample_kind(in.report_id)) {
+        case IMU_SAMPLE_VEC:
+            out.data.vec = {in.v[0] * scale, in.v[1] * scale, in.v[2] * scale};
+            break;
+
+        case IMU_SAMPLE_QUAT: {
+            const float i = in.v[0] * scale;
+            const float j = in.v[1] * scale;
+            const float k = in.v[2] * scale;
+            out.data.quat = {std::sqrt(std::max(0.0f, 1.0f - i * i - j * j - k * k)), i, j, k};
+            break;
+        }
+
+        case IMU_SAMPLE_ACTIVITY:
+            out.data.activity = {static_cast<uint8_t>(in.v[0]), static_cast<uint8_t>(in.v[1])};
+            break;
+
+        case IMU_SAMPLE_VALUE:
+            out.data.value = static_cast<uint16_t>(in.v[0]) | (static_cast<uint32_t>(static_cast<uint16_t>(in.v[1])) << 16);
+            break;
+    }
+}
+
+void imu_compact_unpack_batch(const imu_compact_sample_t *in, size_t n, imu_sample_t *out) {
+    for (size_t i = 0; i < n; i++) {
+        imu_compact_unpack(in[i], out[i]);
+    }
+}
+
+
+// ============================================================================
+// Sample ring: the driver callback copies the report into a typed record and
+// pushes it, nothing else runs in the SHTP servicing context.
+// ============================================================================
+
+static void imu_sample_ring_notify();
+static void imu_sub_dispatch(const imu_sample_t &sample);
+
+/**
+ * @brief Copy a report out of the library into a ring record
+ * @param hub_us: set to the hub timestamp for raw reports, untouched otherwise
+ */
+static bool imu_read_sample(uint8_t report_id, imu_sample_t &sample, uint32_t &hub_us) {
+    sample.report_id = report_id;
+    sample.accuracy = static_cast<uint8_t>(BNO08xAccuracy::UNDEFINED);
+    sample.reserved = 0;
+
+    switch (report_id) {
+        case SH2_ACCELEROMETER:
         case SH2_LINEAR_ACCELERATION:
-            return imu.rpt.linear_accelerometer.has_new_data();
+        case SH2_GRAVITY: {
+            bno08x_accel_t accel = (report_id == SH2_ACCELEROMETER) ? imu.rpt.accelerometer.get()
+                                 : (report_id == SH2_LINEAR_ACCELERATION) ? imu.rpt.linear_accelerometer.get()
+                                 : imu.rpt.gravity.get();
+            sample.data.vec = {accel.x, accel.y, accel.z};
+            sample.accuracy = static_cast<uint8_t>(accel.accuracy);
+            return true;
+        }
 
-        case SH2_GRAVITY:
-            return imu.rpt.gravity.has_new_data();
+        case SH2_RAW_ACCELEROMETER: {
+            bno08x_raw_accel_t raw = imu.rpt.raw_accelerometer.get();
+            sample.data.vec = {static_cast<float>(raw.x), static_cast<float>(raw.y), static_cast<float>(raw.z)};
+            hub_us = raw.timestamp_us;
+            return true;
+        }
 
-        case SH2_RAW_GYROSCOPE:
-            return imu.rpt.raw_gyro.has_new_data();
+        case SH2_RAW_GYROSCOPE: {
+            bno08x_raw_gyro_t raw = imu.rpt.raw_gyro.get();
+            sample.data.vec = {static_cast<float>(raw.x), static_cast<float>(raw.y), static_cast<float>(raw.z)};
+            hub_us = raw.timestamp_us;
+            return true;
+        }
 
-        case SH2_GYROSCOPE_CALIBRATED:
-            return imu.rpt.cal_gyro.has_new_data();
+        case SH2_GYROSCOPE_CALIBRATED: {
+            bno08x_gyro_t gyro = imu.rpt.cal_gyro.get();
+            sample.data.vec = {gyro.x, gyro.y, gyro.z};
+            return true;
+        }
 
-        case SH2_GYROSCOPE_UNCALIBRATED:
-            return imu.rpt.uncal_gyro.has_new_data();
+        case SH2_GYROSCOPE_UNCALIBRATED: {
+            bno08x_gyro_t gyro = imu.rpt.uncal_gyro.get_vel();
+            sample.data.vec = {gyro.x, gyro.y, gyro.z};
+            return true;
+        }
 
-        case SH2_RAW_MAGNETOMETER:
-            return imu.rpt.raw_magnetometer.has_new_data();
+        case SH2_RAW_MAGNETOMETER: {
+            bno08x_raw_magf_t raw = imu.rpt.raw_magnetometer.get();
+            sample.data.vec = {static_cast<float>(raw.x), static_cast<float>(raw.y), static_cast<float>(raw.z)};
+            hub_us = raw.timestamp_us;
+            return true;
+        }
 
         case SH2_MAGNETIC_FIELD_CALIBRATED:
-            return imu.rpt.cal_magnetometer.has_new_data();
-
-        case SH2_MAGNETIC_FIELD_UNCALIBRATED:
-            return imu.rpt.uncal_magnetometer.has_new_data();
+        case SH2_MAGNETIC_FIELD_UNCALIBRATED: {
+            bno08x_magf_t magf = (report_id == SH2_MAGNETIC_FIELD_CALIBRATED) ? imu.rpt.cal_magnetometer.get()
+                               : imu.rpt.uncal_magnetometer.get_magf();
+            sample.data.vec = {magf.x, magf.y, magf.z};
+            sample.accuracy = static_cast<uint8_t>(magf.accuracy);
+            return true;
+        }
 
         case SH2_ROTATION_VECTOR:
-            return imu.rpt.rv.has_new_data();
-
         case SH2_GAME_ROTATION_VECTOR:
-            return imu.rpt.rv_game.has_new_data();
-
         case SH2_ARVR_STABILIZED_RV:
-            return imu.rpt.rv_ARVR_stabilized.has_new_data();
-
         case SH2_ARVR_STABILIZED_GRV:
-            return imu.rpt.rv_ARVR_stabilized_game.has_new_data();
-
         case SH2_GYRO_INTEGRATED_RV:
-            return imu.rpt.rv_gyro_integrated.has_new_data();
-
-        case SH2_GEOMAGNETIC_ROTATION_VECTOR:
-            return imu.rpt.rv_geomagnetic.has_new_data();
+        case SH2_GEOMAGNETIC_ROTATION_VECTOR: {
+            bno08x_quat_t quat = (report_id == SH2_ROTATION_VECTOR) ? imu.rpt.rv.get_quat()
+                               : (report_id == SH2_GAME_ROTATION_VECTOR) ? imu.rpt.rv_game.get_quat()
+                               : (report_id == SH2_ARVR_STABILIZED_RV) ? imu.rpt.rv_ARVR_stabilized.get_quat()
+                               : (report_id == SH2_ARVR_STABILIZED_GRV) ? imu.rpt.rv_ARVR_stabilized_game.get_quat()
+                               : (report_id == SH2_GYRO_INTEGRATED_RV) ? imu.rpt.rv_gyro_integrated.get_quat()
+                               : imu.rpt.rv_geomagnetic.get_quat();
+            sample.data.quat = {quat.real, quat.i, quat.j, quat.k};
+            sample.accuracy = static_cast<uint8_t>(quat.accuracy);
+            return true;
+        }
 
-        case SH2_PERSONAL_ACTIVITY_CLASSIFIER:
-            return imu.rpt.activity_classifier.has_new_data();
+        case SH2_PERSONAL_ACTIVITY_CLASSIFIER: {
+            bno08x_activity_classifier_t activity = imu.rpt.activity_classifier.get();
+            sample.data.activity = {static_cast<uint8_t>(activity.mostLikelyState), activity.confidence};
+            return true;
+        }
 
         case SH2_STABILITY_CLASSIFIER:
-            return imu.rpt.stability_classifier.has_new_data();
+            sample.data.value = static_cast<uint32_t>(imu.rpt.stability_classifier.get().stability);
+            return true;
 
         case SH2_SHAKE_DETECTOR:
-            return imu.rpt.shake_detector.has_new_data();
+            sample.data.value = imu.rpt.shake_detector.get().shake;
+            return true;
 
         case SH2_STEP_COUNTER:
-            return imu.rpt.step_counter.has_new_data();
+            sample.data.value = imu.rpt.step_counter.get().steps;
+            return true;
 
         case SH2_SIGNIFICANT_MOTION:
-            return imu.rpt.significant_motion.has_new_data();
+            sample.data.value = imu.rpt.significant_motion.get().motion;
+            return true;
 
         default:
-            ESP_LOGE(TAG, "Invalid report ID: %d", report_id);
             return false;
     }
+}
+
+static inline bool imu_ring_push(const imu_sample_t &sample) {
+#if IMU_SAMPLE_RING_COMPACT
+    imu_compact_sample_t record;
+    imu_compact_pack(sample, record);
+    return sample_ring.push(record);
+#else
+    return sample_ring.push(sample);
+#endif
+}
+
+/// @brief Pop into either record type, converting in small chunks when it differs from the ring's
+template <typename T>
+static size_t imu_ring_pop(T *out, size_t max) {
+    if constexpr (std::is_same<T, imu_ring_record_t>::value) {
+        return sample_ring.pop_batch(out, max);
+    } else {
+        imu_ring_record_t chunk[16];
+        size_t n = 0;
+        while (n < max) {
+            const size_t got = sample_ring.pop_batch(chunk, std::min(max - n, sizeof(chunk) / sizeof(chunk[0])));
+            for (size_t i = 0; i < got; i++) {
+                if constexpr (std::is_same<T, imu_sample_t>::value) {
+                    imu_compact_unpack(chunk[i], out[n + i]);
+                } else {
+                    imu_compact_pack(chunk[i], out[n + i]);
+                }
+            }
+            n += got;
+            if (got == 0) {
+                break;
+            }
+        }
+        return n;
+    }
+}
+
+/**
+ * The one ingestion callback: the report is read out of the library once,
+ * stamped with its measurement time, then published to the latest-value cache,
+ * queued in the ring if started, and handed to the report's subscribers.
+ */
+static void imu_ingest_cb(uint8_t report_id) {
+#if IMU_METRICS_ENABLED
+    const esp_cpu_cycle_count_t cb_start = esp_cpu_get_cycle_count();
+#endif
+    const uint32_t arrival_us = static_cast<uint32_t>(esp_timer_get_time());
+    last_sample_us.store(arrival_us, std::memory_order_relaxed);
+    imu_sample_t sample;
+    uint32_t hub_us = 0;
+    if (!imu_read_sample(report_id, sample, hub_us)) {
+        return;
+    }
+    sample.timestamp_us = (rpt_table[report_id].caps & IMU_RPT_CAP_TIMESTAMP) ? imu_clock_on_raw(hub_us, arrival_us)
+                                                                              : imu_clock_on_arrival(report_id, arrival_us);
+#if IMU_METRICS_ENABLED
+    rpt_metrics[report_id].on_sample(arrival_us, metrics_period_us[report_id].load(std::memory_order_relaxed));
+#endif
+
+    latest_cache[report_id].write(sample);
+    if (report_id == SH2_ROTATION_VECTOR && sample.accuracy == static_cast<uint8_t>(BNO08xAccuracy::HIGH) &&
+            cal_high_us.load(std::memory_order_relaxed) < 0) {
+        cal_high_us.store(esp_timer_get_time(), std::memory_order_relaxed);
+    }
+    if (ring_started.load(std::memory_order_relaxed) && imu_ring_push(sample)) {
+        imu_sample_ring_notify();
+    }
+    imu_sub_dispatch(sample);
+#if IMU_METRICS_ENABLED
+    const uint32_t cb_cycles = esp_cpu_get_cycle_count() - cb_start;
+    rpt_metrics[report_id].on_callback(cb_cycles);
+    metrics_cb_cycles.store(metrics_cb_cycles.load(std::memory_order_relaxed) + cb_cycles, std::memory_order_relaxed);
+#endif
+}
+
+static void imu_ingest_start() {
+    static bool registered = false;
+    if (registered) {
+        return;
+    }
+
+    // the only callable handed to the library, registered once: a plain function sits in
+    // std::function's local buffer, everything else fans out through the static subscription table
+    imu.register_cb(imu_ingest_cb);
+    registered = true;
+}
+
+bool imu_sample_ring_start() {
+    if (ring_started.exchange(true)) {
+        return true;
+    }
+
+    imu_ingest_start();
+    ESP_LOGI(TAG, "IMU - SAMPLE RING STARTED (%u slots)", static_cast<unsigned>(IMU_SAMPLE_RING_CAPACITY));
     return true;
 }
 
-bno08x_raw_accel_t imu_get_raw_accel() { return imu.rpt.raw_accelerometer.get(); }
-bno08x_accel_t imu_get_accel() { return imu.rpt.accelerometer.get(); }
-bno08x_accel_t imu_get_linear_accel() { return imu.rpt.linear_accelerometer.get(); }
-bno08x_accel_t imu_get_gravity() { return imu.rpt.gravity.get(); }
-bno08x_raw_gyro_t imu_get_raw_gyro() { return imu.rpt.raw_gyro.get(); }
-bno08x_gyro_t imu_get_cal_gyro() { return imu.rpt.cal_gyro.get(); }
-bno08x_gyro_t imu_get_uncal_gyro() { return imu.rpt.uncal_gyro.get_vel(); }
-bno08x_gyro_bias_t imu_get_gyro_bias() { return imu.rpt.uncal_gyro.get_bias(); }
-bno08x_raw_magf_t imu_get_raw_magf() { return imu.rpt.raw_magnetometer.get(); }
-bno08x_magf_t imu_get_cal_magf() { return imu.rpt.cal_magnetometer.get(); }
-bno08x_magf_t imu_get_uncal_magf() { return imu.rpt.uncal_magnetometer.get_magf(); }
-bno08x_magf_bias_t imu_get_magf_bias() { return imu.rpt.uncal_magnetometer.get_bias(); }
-bno08x_quat_t imu_get_rv() { return imu.rpt.rv.get_quat(); }
-bno08x_euler_angle_t imu_get_rv_euler() { return imu.rpt.rv.get_euler();}
-bno08x_quat_t imu_get_rv_geomagnetic() { return imu.rpt.rv_geomagnetic.get_quat(); }
-bno08x_euler_angle_t imu_get_rv_geomagnetic_euler() { return imu.rpt.rv_geomagnetic.get_euler(); }
-bno08x_activity_classifier_t imu_get_activity_classifier() { return imu.rpt.activity_classifier.get(); }
-bno08x_stability_classifier_t imu_get_stability_classifier() { return imu.rpt.stability_classifier.get(); }
-bno08x_shake_detector_t imu_get_shake_detector() { return imu.rpt.shake_detector.get(); }
-bno08x_step_counter_t imu_get_step_counter() { return imu.rpt.step_counter.get(); }
-bno08x_significant_motion_t imu_get_significant_motion() { return imu.rpt.significant_motion.get();}
+size_t imu_sample_ring_drain(imu_sample_t *out, size_t max) {
+    if (out == nullptr || max == 0) {
+        return 0;
+    }
+    return imu_ring_pop(out, max);
+}
 
+size_t imu_sample_ring_drain_compact(imu_compact_sample_t *out, size_t max) {
+    if (out == nullptr || max == 0) {
+        return 0;
+    }
+    return imu_ring_pop(out, max);
+}
+
+imu_ring_stats_t imu_sample_ring_get_stats() { return sample_ring.get_stats(); }
+void imu_sample_ring_reset_stats() { sample_ring.reset_stats(); }
 
-//TESTING FUNCTIONS
-void motion_detection_task(void *pvParameters) {
 
-    imu_enable_rpt(SH2_SIGNIFICANT_MOTION, 100000UL);
+// ============================================================================
+// Latest-value cache: one seqlock per report, written only by the ingestion
+// callback. Readers on any task copy without locks and use the sequence to
+// tell a fresh sample from one they have already seen.
+// ============================================================================
+
+bool imu_latest_start() {
+    imu_ingest_start();
+    return true;
+}
+
+uint32_t imu_latest_read(uint8_t report_id, imu_sample_t &out) {
+    if (imu_find_rpt(report_id) == nullptr) {
+        return 0;
+    }
+    return latest_cache[report_id].read(out);
+}
+
+bool imu_latest_read_new(uint8_t report_id, imu_sample_t &out, uint32_t &last_seq) {
+    if (imu_find_rpt(report_id) == nullptr || latest_cache[report_id].sequence() == last_seq) {
+        return false;
+    }
 
-    //Register once to start 
-    imu.rpt.significant_motion.register_cb([]()
-    {
-        if(imu.rpt.significant_motion.has_new_data()) {
-            motion_flag = true;
+    uint32_t seq = latest_cache[report_id].read(out);
+    if (seq == last_seq) {
+        return false;
+    }
+    last_seq = seq;
+    return true;
+}
+
+uint32_t imu_latest_seq(uint8_t report_id) {
+    return (imu_find_rpt(report_id) != nullptr) ? latest_cache[report_id].sequence() : 0;
+}
+
+
+// ============================================================================
+// Subscriptions: writers (serialized by sub_lock) build the inactive copy of
+// the fan-out table and flip to it; the callback pins the live copy with a
+// reader count while it dispatches. A copy is only rebuilt once no dispatch
+// is left on it, which also keeps a freed slot out of reach before reuse.
+// ============================================================================
+
+// bumped by the dispatching callback, read by imu_sub_get_stats() from any task
+typedef struct imu_sub_counters_t {
+    std::atomic<uint32_t> delivered{0};
+    std::atomic<uint32_t> decimated{0};
+    std::atomic<uint32_t> filtered{0};
+} imu_sub_counters_t;
+
+typedef struct imu_sub_slot_t {
+    imu_sub_cfg_t cfg;
+    bool used;
+    uint16_t phase[SH2_MAX_SENSOR_ID + 1];   // samples since the last delivery, per report
+    imu_sub_counters_t stats;
+} imu_sub_slot_t;
+
+typedef struct imu_fanout_t {
+    uint8_t n[SH2_MAX_SENSOR_ID + 1];
+    uint8_t slot[SH2_MAX_SENSOR_ID + 1][IMU_MAX_SUBSCRIBERS];
+} imu_fanout_t;
+
+static_assert(IMU_MAX_SUBSCRIBERS > 0 && IMU_MAX_SUBSCRIBERS <= UINT8_MAX, "IMU_MAX_SUBSCRIBERS out of range");
+
+static std::mutex sub_lock;
+static std::array<imu_sub_slot_t, IMU_MAX_SUBSCRIBERS> sub_slots{};
+static imu_fanout_t fanout[2] = {};
+static std::atomic<uint8_t> fanout_live{0};
+static std::atomic<uint32_t> fanout_readers[2] = {};
+static std::atomic<uint32_t> sub_total{0};
+
+static void imu_sub_dispatch(const imu_sample_t &sample) {
+    if (sub_total.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+
+    // pin the live copy, retry if a writer flipped between the load and the pin
+    uint8_t t;
+    while (true) {
+        t = fanout_live.load(std::memory_order_seq_cst);
+        fanout_readers[t].fetch_add(1, std::memory_order_seq_cst);
+        if (fanout_live.load(std::memory_order_seq_cst) == t) {
+            break;
         }
-    });
-    
-    BaseType_t xCoreID = xPortGetCoreID();
-    ESP_LOGI(TAG, "IMU task running on core: %d", xCoreID);
-
-    while (1)
-    {
-
-        vTaskDelay(pdMS_TO_TICKS(50));
-        if(motion_flag) {
-            ESP_LOGI(TAG, "WOKE UP, MOTION DETECTED");
-            motion_flag = false;
-            // One-shot sensor auto-disables, but we need to explicitly disable to clear state
-            imu_rearm_sig_motion();
-            // Re-register callback after re-arming (disable/enable clears the callback)
-            imu.rpt.significant_motion.register_cb([]()
-            {
-                if(imu.rpt.significant_motion.has_new_data()) {
-                    motion_flag = true;
-                }
-            });
+        fanout_readers[t].fetch_sub(1, std::memory_order_release);
+    }
+
+    const uint8_t report_id = sample.report_id;
+    const imu_fanout_t &table = fanout[t];
+    for (uint8_t i = 0; i < table.n[report_id]; i++) {
+        imu_sub_slot_t &sub = sub_slots[table.slot[report_id][i]];
+        if (sub.cfg.decimation > 1) {
+            if (++sub.phase[report_id] < sub.cfg.decimation) {
+                sub.stats.decimated.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            sub.phase[report_id] = 0;
         }
+        if (sub.cfg.filter != nullptr && !sub.cfg.filter(sample, sub.cfg.arg)) {
+            sub.stats.filtered.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        sub.cfg.fn(sample, sub.cfg.arg);
+        sub.stats.delivered.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    fanout_readers[t].fetch_sub(1, std::memory_order_release);
+}
 
-        vTaskDelay(10UL / portTICK_PERIOD_MS);
+/// @brief Rebuild the inactive fan-out copy from the slots and make it live, call with sub_lock held
+static void imu_sub_publish() {
+    const uint8_t next = fanout_live.load(std::memory_order_relaxed) ^ 1U;
+    imu_fanout_t &table = fanout[next];
+    table = {};
+    uint32_t total = 0;
+    for (uint8_t s = 0; s < IMU_MAX_SUBSCRIBERS; s++) {
+        if (!sub_slots[s].used) {
+            continue;
+        }
+        total++;
+        uint64_t mask = sub_slots[s].cfg.report_mask;
+        while (mask != 0) {
+            const uint8_t report_id = static_cast<uint8_t>(__builtin_ctzll(mask));
+            mask &= mask - 1;
+            table.slot[report_id][table.n[report_id]++] = s;
+        }
     }
+
+    fanout_live.store(next, std::memory_order_seq_cst);
+    sub_total.store(total, std::memory_order_relaxed);
 }
 
-void data_processing_task(void *pvParameters) {
-    imu_report_cfg_t rpts_to_enable[] = {
+/// @brief Wait until no dispatch is left on the inactive copy, call with sub_lock held before touching slots
+static void imu_sub_quiesce() {
+    const uint8_t idle = fanout_live.load(std::memory_order_seq_cst) ^ 1U;
+    while (fanout_readers[idle].load(std::memory_order_acquire) != 0) {
+        vTaskDelay(1);
+    }
+}
 
-        {SH2_ACCELEROMETER, 100000UL},
-        {SH2_GYROSCOPE_CALIBRATED, 100000UL},
-        {SH2_MAGNETIC_FIELD_CALIBRATED, 100000UL},
-        {SH2_ROTATION_VECTOR, 100000UL},
-        {SH2_PERSONAL_ACTIVITY_CLASSIFIER, 100000UL}, 
-    };
+int imu_subscribe(const imu_sub_cfg_t &cfg) {
+    uint64_t valid = 0;
+    for (uint64_t mask = cfg.report_mask; mask != 0; mask &= mask - 1) {
+        const uint8_t report_id = static_cast<uint8_t>(__builtin_ctzll(mask));
+        if (imu_find_rpt(report_id) != nullptr) {
+            valid |= IMU_RPT_BIT(report_id);
+        }
+    }
+    if (cfg.fn == nullptr || valid == 0) {
+        ESP_LOGE(TAG, "Subscription needs a callback and at least one valid report");
+        return -1;
+    }
 
-    imu_enable_multi_rpts(rpts_to_enable, sizeof(rpts_to_enable)/sizeof(rpts_to_enable[0]));
-    
-    imu.register_cb([]()
-    {
-        if(imu_has_new_data(SH2_ACCELEROMETER)) {
-            bno08x_accel_t accel = imu.rpt.accelerometer.get();
-            ESP_LOGI(TAG, "Accel: %.2f, %.2f, %.2f", accel.x, accel.y, accel.z);
+    std::lock_guard<std::mutex> guard(sub_lock);
+    imu_sub_quiesce();
+    for (uint8_t s = 0; s < IMU_MAX_SUBSCRIBERS; s++) {
+        imu_sub_slot_t &sub = sub_slots[s];
+        if (sub.used) {
+            continue;
         }
-        if(imu_has_new_data(SH2_GYROSCOPE_CALIBRATED)) {
-            bno08x_gyro_t gyro = imu.rpt.cal_gyro.get();
-            ESP_LOGI(TAG, "Gyro: %.2f, %.2f, %.2f", gyro.x, gyro.y, gyro.z);
+        sub.cfg = cfg;
+        sub.cfg.report_mask = valid;
+        // the first sample of each report is delivered, then every decimation-th
+        std::fill(std::begin(sub.phase), std::end(sub.phase), cfg.decimation > 1 ? cfg.decimation - 1 : 0);
+        sub.stats.delivered.store(0, std::memory_order_relaxed);
+        sub.stats.decimated.store(0, std::memory_order_relaxed);
+        sub.stats.filtered.store(0, std::memory_order_relaxed);
+        sub.used = true;
+        imu_sub_publish();
+        imu_ingest_start();
+        return s;
+    }
+
+    ESP_LOGE(TAG, "No free subscription slot (%d)", IMU_MAX_SUBSCRIBERS);
+    return -1;
+}
+
+bool imu_unsubscribe(int handle) {
+    if (handle < 0 || handle >= IMU_MAX_SUBSCRIBERS) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(sub_lock);
+    if (!sub_slots[handle].used) {
+        return false;
+    }
+    imu_sub_quiesce();
+    sub_slots[handle].used = false;
+    imu_sub_publish();
+    // the old copy may still be dispatching to the slot, wait it out before returning
+    imu_sub_quiesce();
+    return true;
+}
+
+bool imu_sub_get_stats(int handle, imu_sub_stats_t &out) {
+    if (handle < 0 || handle >= IMU_MAX_SUBSCRIBERS) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(sub_lock);
+    const imu_sub_slot_t &sub = sub_slots[handle];
+    if (!sub.used) {
+        return false;
+    }
+    out.delivered = sub.stats.delivered.load(std::memory_order_relaxed);
+    out.decimated = sub.stats.decimated.load(std::memory_order_relaxed);
+    out.filtered = sub.stats.filtered.load(std::memory_order_relaxed);
+    return true;
+}
+
+size_t imu_sub_count() {
+    return sub_total.load(std::memory_order_relaxed);
+}
+
+
+// ============================================================================
+// Report metrics: recorded by the ingestion callback, see imu_metrics.hpp.
+// ============================================================================
+
+#if IMU_METRICS_ENABLED
+bool imu_metrics_get(uint8_t report_id, imu_rpt_metrics_t &out) {
+    if (imu_find_rpt(report_id) == nullptr) {
+        return false;
+    }
+    rpt_metrics[report_id].read(out);
+    return true;
+}
+
+void imu_metrics_reset() {
+    for (imu_rpt_metrics_slot &slot : rpt_metrics) {
+        slot.request_reset();
+    }
+}
+
+size_t imu_metrics_snapshot(uint8_t *out, size_t out_sz) {
+    static constexpr size_t HEADER_SZ = 20;
+    static constexpr size_t RECORD_SZ = 4 + sizeof(imu_rpt_metrics_t);
+    if (out == nullptr || out_sz < HEADER_SZ) {
+        return 0;
+    }
+
+    size_t len = HEADER_SZ;
+    uint16_t reports = 0;
+    for (uint8_t id = 0; id <= SH2_MAX_SENSOR_ID; id++) {
+        imu_rpt_metrics_t metrics;
+        if (!imu_metrics_get(id, metrics) || metrics.received == 0) {
+            continue;
         }
-        if(imu_has_new_data(SH2_MAGNETIC_FIELD_CALIBRATED)) {
-            bno08x_magf_t magf = imu.rpt.cal_magnetometer.get();
-            ESP_LOGI(TAG, "Magf: %.2f, %.2f, %.2f", magf.x, magf.y, magf.z);
+        if (len + RECORD_SZ > out_sz) {
+            return 0;
         }
-        if(imu_has_new_data(SH2_ROTATION_VECTOR)) {
-            bno08x_quat_t rv = imu.rpt.rv.get_quat();
-            ESP_LOGI(TAG, "RV: %.2f, %.2f, %.2f, %.2f", rv.real, rv.i, rv.j, rv.k);
+
+        const uint8_t record_head[4] = {id, 0, 0, 0};
+        std::memcpy(out + len, record_head, sizeof(record_head));
+        std::memcpy(out + len + sizeof(record_head), &metrics, sizeof(metrics));
+        len += RECORD_SZ;
+        reports++;
+    }
+
+    const uint32_t magic = IMU_METRICS_MAGIC;
+    const uint16_t version = IMU_METRICS_VERSION;
+    const uint8_t hist[2] = {IMU_METRICS_HIST_BUCKETS, IMU_METRICS_HIST_SHIFT};
+    const uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+    const uint32_t timestamp_us = static_cast<uint32_t>(esp_timer_get_time());
+    const uint16_t record_sz = RECORD_SZ;
+    std::memcpy(out + 0, &magic, 4);
+    std::memcpy(out + 4, &version, 2);
+    std::memcpy(out + 6, hist, 2);
+    std::memcpy(out + 8, &ticks_per_us, 4);
+    std::memcpy(out + 12, &timestamp_us, 4);
+    std::memcpy(out + 16, &reports, 2);
+    std::memcpy(out + 18, &record_sz, 2);
+    return len;
+}
+
+void imu_metrics_print() {
+    const uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+    for (uint8_t id = 0; id <= SH2_MAX_SENSOR_ID; id++) {
+        imu_rpt_metrics_t m;
+        if (!imu_metrics_get(id, m) || m.received == 0) {
+            continue;
         }
-        if(imu_has_new_data(SH2_PERSONAL_ACTIVITY_CLASSIFIER)) {
-            bno08x_activity_classifier_t activity = imu.rpt.activity_classifier.get();
-            ESP_LOGI(TAG, "Activity: %d", activity.mostLikelyState);
-            ESP_LOGI(TAG, "Confidence: %d", activity.confidence);
+
+        // median bucket as the typical callback time
+        uint32_t seen = 0;
+        uint32_t p50 = 0;
+        while (p50 + 1 < IMU_METRICS_HIST_BUCKETS && (seen += m.cb_hist[p50]) * 2 < m.received) {
+            p50++;
         }
-    });
+        const uint32_t p50_limit = imu_metrics_bucket_limit_cycles(p50);
+
+        ESP_LOGI(TAG, "Report 0x%02X: %lu rx, %.1f Hz, jitter %.0f us, interval %lu..%lu us, %lu gaps (%lu missed), "
+                 "cb p50 <%lu us, max %lu us", id, (unsigned long)m.received, imu_metrics_rate_hz(m),
+                 imu_metrics_jitter_us(m), (unsigned long)m.interval_min_us, (unsigned long)m.interval_max_us,
+                 (unsigned long)m.gaps, (unsigned long)m.missed,
+                 (unsigned long)((p50_limit != 0) ? (p50_limit + ticks_per_us - 1) / ticks_per_us : 0),
+                 (unsigned long)(m.cb_max_cycles / ticks_per_us));
+    }
+}
+
+uint32_t imu_metrics_cb_cycles() {
+    return metrics_cb_cycles.load(std::memory_order_relaxed);
+}
+#else
+bool imu_metrics_get(uint8_t, imu_rpt_metrics_t &) { return false; }
+uint32_t imu_metrics_cb_cycles() { return 0; }
+void imu_metrics_reset() {}
+size_t imu_metrics_snapshot(uint8_t *, size_t) { return 0; }
+void imu_metrics_print() {}
+#endif
+
+
+// ============================================================================
+// Motion events: the driver callback posts bits into one event group and the
+// waiting task blocks on it, no polling. Each motion event keeps the time of
+// its first unconsumed post, so the waiter measures the latency of exactly the
+// events it was woken for.
+// ============================================================================
+
+static constexpr size_t IMU_EVT_STAMPED = 3;   ///< IMU_EVT_ALL occupies bits 0..2
+static_assert(IMU_EVT_ALL == (1UL << IMU_EVT_STAMPED) - 1, "motion event bits must be the low bits");
+
+static StaticEventGroup_t imu_event_buf;
+static EventGroupHandle_t imu_events = nullptr;
+static std::atomic<uint32_t> event_post_us[IMU_EVT_STAMPED] = {};
+static uint8_t last_stability = static_cast<uint8_t>(BNO08xStability::UNDEFINED);
+static imu_wake_stats_t wake_stats = {};
+static std::atomic<bool> burst_waiting{false};
+
+static void imu_sample_ring_notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (burst_waiting.load(std::memory_order_relaxed)) {
+        xEventGroupSetBits(imu_events, IMU_EVT_SAMPLES);
+    }
+}
+
+static void imu_event_cb(const imu_sample_t &sample, void *) {
+    uint32_t events = 0;
+
+    switch (sample.report_id) {
+        case SH2_SIGNIFICANT_MOTION:
+            events = IMU_EVT_SIG_MOTION;
+            break;
+
+        case SH2_SHAKE_DETECTOR:
+            events = IMU_EVT_SHAKE;
+            break;
+
+        case SH2_STABILITY_CLASSIFIER: {
+            uint8_t stability = static_cast<uint8_t>(sample.data.value);
+            if (stability == last_stability) {
+                return;
+            }
+            last_stability = stability;
+            events = IMU_EVT_STABILITY_CHANGE;
+            break;
+        }
+
+        default:
+            return;
+    }
+
+    // 0 means "nothing pending", force bit 0 so a post at t == 0 still counts
+    const size_t slot = static_cast<size_t>(__builtin_ctz(events));
+    uint32_t expected = 0;
+    event_post_us[slot].compare_exchange_strong(expected, static_cast<uint32_t>(esp_timer_get_time()) | 1U);
+    xEventGroupSetBits(imu_events, events);
+}
+
+bool imu_events_start() {
+    if (imu_events != nullptr) {
+        return true;
+    }
+
+    imu_events = xEventGroupCreateStatic(&imu_event_buf);
+    if (imu_events == nullptr) {
+        ESP_LOGE(TAG, "Failed to create IMU event group");
+        return false;
+    }
+
+    imu_sub_cfg_t sub;
+    sub.report_mask = IMU_RPT_BIT(SH2_SIGNIFICANT_MOTION) | IMU_RPT_BIT(SH2_SHAKE_DETECTOR) |
+                      IMU_RPT_BIT(SH2_STABILITY_CLASSIFIER);
+    sub.fn = imu_event_cb;
+    if (imu_subscribe(sub) < 0) {
+        ESP_LOGE(TAG, "Failed to subscribe the IMU event callback");
+        imu_events = nullptr;
+        return false;
+    }
+    return true;
+}
+
+uint32_t imu_wait_events(uint32_t events, TickType_t ticks_to_wait) {
+    if (imu_events == nullptr) {
+        ESP_LOGE(TAG, "imu_wait_events() before imu_events_start()");
+        return 0;
+    }
+
+    uint32_t bits = xEventGroupWaitBits(imu_events, events, pdTRUE, pdFALSE, ticks_to_wait) & events;
+    if (bits == 0) {
+        return 0;
+    }
+
+    // only the returned events are consumed, a poll drops their stamps without counting a wake
+    const uint32_t now_us = static_cast<uint32_t>(esp_timer_get_time());
+    for (size_t slot = 0; slot < IMU_EVT_STAMPED; slot++) {
+        if ((bits & (1UL << slot)) == 0) {
+            continue;
+        }
+        const uint32_t posted = event_post_us[slot].exchange(0);
+        if (posted == 0 || ticks_to_wait == 0) {
+            continue;
+        }
+        const uint32_t latency_us = now_us - posted;
+        wake_stats.wakes++;
+        wake_stats.last_us = latency_us;
+        wake_stats.total_us += latency_us;
+        if (latency_us > wake_stats.max_us) {
+            wake_stats.max_us = latency_us;
+        }
+    }
+    return bits;
+}
+
+imu_wake_stats_t imu_get_wake_stats() { return wake_stats; }
+void imu_reset_wake_stats() { wake_stats = {}; }
+
+
+// ============================================================================
+// Fault recovery: the reset event only records the reset and wakes a task,
+// the library is mid transfer there. imu_recover() diffs the desired
+// snapshot against the (now empty) hub and sends what is missing.
+// ============================================================================
+
+static std::mutex recovery_lock;
+static std::atomic<uint32_t> reset_at_us{0};      // first reset not yet replayed, 0 when none
+static std::atomic<uint32_t> resets_seen{0};
+static std::atomic<uint32_t> resets_unexpected{0};
+static std::atomic<uint32_t> resets_silent{0};
+static imu_recovery_stats_t recovery_stats = {};
+static StaticEventGroup_t reset_event_buf;
+static EventGroupHandle_t reset_events = nullptr;    // RESET_SEEN, for imu_requested_reset()
+static constexpr EventBits_t RESET_SEEN = (1UL << 0);
+
+static bool imu_recovery_init() {
+    if (reset_events == nullptr) {
+        reset_events = xEventGroupCreateStatic(&reset_event_buf);
+    }
+    return reset_events != nullptr;
+}
+
+static void imu_hub_reset_cb() {
+    // 0 means "nothing pending", force bit 0 so a reset at t == 0 still counts
+    uint32_t expected = 0;
+    reset_at_us.compare_exchange_strong(expected, static_cast<uint32_t>(esp_timer_get_time()) | 1U);
+    enabled_rpts.store(0, std::memory_order_relaxed);
+    imu_clock_reset();
+
+    resets_seen.fetch_add(1, std::memory_order_relaxed);
+    if (!reset_requested.exchange(false, std::memory_order_relaxed)) {
+        resets_unexpected.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (reset_events != nullptr) {
+        xEventGroupSetBits(reset_events, RESET_SEEN);
+    }
+    if (imu_events != nullptr) {
+        xEventGroupSetBits(imu_events, IMU_EVT_HUB_RESET);
+    }
+}
+
+/**
+ * A reset the driver asks for, counted as requested. The library returns once
+ * the reset is issued; on hardware the hub's reset message only follows once
+ * it has booted, so wait for it before the caller replays anything. Without a
+ * reset callback the driver records the reset itself when the call returns.
+ */
+static bool imu_requested_reset(bool (BNO08x::*reset)()) {
+    if (!imu_lib_has_reset_cb<BNO08x>) {
+        if (!(imu.*reset)()) {
+            return false;
+        }
+        reset_requested.store(true, std::memory_order_relaxed);
+        imu_hub_reset_cb();
+        return true;
+    }
+
+    xEventGroupClearBits(reset_events, RESET_SEEN);
+    reset_requested.store(true, std::memory_order_relaxed);
+    if (!(imu.*reset)()) {
+        reset_requested.store(false, std::memory_order_relaxed);
+        return false;
+    }
+    const EventBits_t seen =
+            xEventGroupWaitBits(reset_events, RESET_SEEN, pdTRUE, pdFALSE, pdMS_TO_TICKS(IMU_HUB_BOOT_MAX_MS));
+    if (!(seen & RESET_SEEN)) {
+        // a late message is then counted as unexpected, and whoever waits on IMU_EVT_HUB_RESET replays
+        reset_requested.store(false, std::memory_order_relaxed);
+        ESP_LOGW(TAG, "No reset message within %d ms", IMU_HUB_BOOT_MAX_MS);
+        return false;
+    }
+    return true;
+}
+
+bool imu_hub_check() {
+    // continuous reports delivered one by one are the heartbeat, batched ones arrive a FIFO at a time
+    uint64_t running = enabled_rpts.load(std::memory_order_relaxed);
+    uint32_t longest_us = 0;
+    while (running != 0) {
+        const uint8_t report_id = static_cast<uint8_t>(__builtin_ctzll(running));
+        running &= running - 1;
+        if ((rpt_table[report_id].caps & IMU_RPT_CAP_CONTINUOUS) && !rpt_batched[report_id].load(std::memory_order_relaxed)) {
+            longest_us = std::max(longest_us, live_cfg[report_id].period_us);
+        }
+    }
+    if (longest_us == 0) {
+        return false;
+    }
+
+    const uint32_t silent_us = static_cast<uint32_t>(esp_timer_get_time()) - last_sample_us.load(std::memory_order_relaxed);
+    if (silent_us < std::max<uint32_t>(IMU_HUB_SILENT_MS * 1000UL, IMU_HUB_SILENT_PERIODS * longest_us)) {
+        return false;
+    }
+
+    // a reset whose message was lost looks like this: the hub runs nothing and sends nothing
+    BINLOG_W(TAG, "Hub silent for %lu us with reports running, replaying as after a reset", silent_us);
+    resets_silent.fetch_add(1, std::memory_order_relaxed);
+    imu_hub_reset_cb();
+    return true;
+}
+
+/// @brief Samples a continuous report missed between its last one before the reset and now
+static uint32_t imu_recovery_lost(uint8_t report_id, uint32_t reset_us, uint32_t now_us) {
+    const uint32_t period_us = live_cfg[report_id].period_us;
+    if (!(rpt_table[report_id].caps & IMU_RPT_CAP_CONTINUOUS) || period_us == 0) {
+        return 0;
+    }
+
+    // the hub was already silent while it rebooted, count from its last sample if that is recent
+    uint32_t since_us = reset_us;
+    imu_sample_t last;
+    if (latest_cache[report_id].read(last) != 0 &&
+            reset_us - last.timestamp_us <= period_us + IMU_HUB_BOOT_MAX_MS * 1000UL) {
+        since_us = last.timestamp_us;
+    }
+    return (now_us - since_us) / period_us;
+}
+
+bool imu_recover() {
+    if (reset_at_us.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(recovery_lock);
+    const uint32_t reset_us = reset_at_us.load(std::memory_order_relaxed);
+    if (reset_us == 0) {
+        return false;
+    }
+
+    uint32_t commands = 0;
+    uint32_t failed = 0;
+    const uint64_t desired = desired_rpts.load(std::memory_order_relaxed);
+    uint64_t missing = desired & ~enabled_rpts.load(std::memory_order_relaxed);
+    while (missing != 0) {
+        const uint8_t report_id = static_cast<uint8_t>(__builtin_ctzll(missing));
+        missing &= missing - 1;
+        const imu_live_cfg_t cfg = live_cfg[report_id];
+        commands++;
+        if (!imu_enable_rpt(report_id, cfg.period_us, cfg.config)) {
+            failed++;
+        }
+    }
+
+    cal_live = CAL_HUB_DEFAULT;
+    if (imu_cal_config_apply(cal_live, cal_desired, commands)) {
+        cal_live = cal_desired;
+    } else {
+        failed++;
+    }
+
+    const uint32_t now_us = static_cast<uint32_t>(esp_timer_get_time());
+    uint32_t lost = 0;
+    uint64_t counted = desired;
+    while (counted != 0) {
+        const uint8_t report_id = static_cast<uint8_t>(__builtin_ctzll(counted));
+        counted &= counted - 1;
+        lost += imu_recovery_lost(report_id, reset_us, now_us);
+    }
+
+    imu_recovery_stats_t &st = recovery_stats;
+    const uint32_t took_us = now_us - reset_us;
+    st.replays++;
+    st.commands += commands;
+    st.failed += failed;
+    st.last_us = took_us;
+    if (took_us > st.max_us) {
+        st.max_us = took_us;
+    }
+    st.last_lost = lost;
+    st.lost += lost;
+
+    // a rejected command keeps the reset pending, the next call sends only what is still missing
+    last_sample_us.store(now_us, std::memory_order_relaxed);
+    if (failed == 0) {
+        reset_at_us.store(0, std::memory_order_relaxed);
+    }
+    BINLOG_W(TAG, "Hub reset recovered: %lu commands (%lu failed) in %lu us, ~%lu samples lost", commands, failed,
+             took_us, lost);
+    return true;
+}
+
+uint64_t imu_get_desired_rpts() {
+    return desired_rpts.load(std::memory_order_relaxed);
+}
+
+imu_recovery_stats_t imu_recovery_get_stats() {
+    imu_recovery_stats_t stats = recovery_stats;
+    stats.resets = resets_seen.load(std::memory_order_relaxed);
+    stats.unexpected = resets_unexpected.load(std::memory_order_relaxed);
+    stats.silent = resets_silent.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void imu_recovery_reset_stats() {
+    recovery_stats = {};
+    resets_seen.store(0, std::memory_order_relaxed);
+    resets_unexpected.store(0, std::memory_order_relaxed);
+    resets_silent.store(0, std::memory_order_relaxed);
+}
+
+
+// ============================================================================
+// Burst drain: with hub batching the callback fires back to back for a whole
+// FIFO flush. The consumer sleeps on IMU_EVT_SAMPLES and keeps popping until
+// the flush goes quiet, so one wake handles one flush.
+// ============================================================================
+
+size_t imu_sample_ring_drain_burst(imu_sample_t *out, size_t max, TickType_t ticks_to_wait) {
+    if (out == nullptr || max == 0 || !imu_events_start()) {
+        return 0;
+    }
+
+    static constexpr TickType_t GAP_TICKS = (pdMS_TO_TICKS(IMU_BURST_GAP_MS) > 0) ? pdMS_TO_TICKS(IMU_BURST_GAP_MS) : 1;
+    size_t n = 0;
+    TickType_t wait = ticks_to_wait;
+
+    // the callback only posts while we wait, the fence pair keeps a push from slipping between check and wait
+    xEventGroupClearBits(imu_events, IMU_EVT_SAMPLES);
+    burst_waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (n < max) {
+        size_t got = imu_ring_pop(out + n, max - n);
+        if (got != 0) {
+            n += got;
+            wait = GAP_TICKS;
+            continue;
+        }
+
+        if ((xEventGroupWaitBits(imu_events, IMU_EVT_SAMPLES, pdTRUE, pdFALSE, wait) & IMU_EVT_SAMPLES) == 0) {
+            break;
+        }
+    }
+    burst_waiting.store(false, std::memory_order_relaxed);
+    return n;
+}
+
+
+//TESTING FUNCTIONS
+static void imu_log_sample(const imu_sample_t &sample) {
+    switch (sample.report_id) {
+        case SH2_ACCELEROMETER:
+            BINLOG_I(TAG, "Accel: %.2f, %.2f, %.2f", sample.data.vec.x, sample.data.vec.y, sample.data.vec.z);
+            break;
+        case SH2_GYROSCOPE_CALIBRATED:
+            BINLOG_I(TAG, "Gyro: %.2f, %.2f, %.2f", sample.data.vec.x, sample.data.vec.y, sample.data.vec.z);
+            break;
+        case SH2_MAGNETIC_FIELD_CALIBRATED:
+            BINLOG_I(TAG, "Magf: %.2f, %.2f, %.2f", sample.data.vec.x, sample.data.vec.y, sample.data.vec.z);
+            break;
+        case SH2_ROTATION_VECTOR:
+            BINLOG_I(TAG, "RV: %.2f, %.2f, %.2f, %.2f",
+                     sample.data.quat.real, sample.data.quat.i, sample.data.quat.j, sample.data.quat.k);
+            break;
+        case SH2_PERSONAL_ACTIVITY_CLASSIFIER:
+            BINLOG_I(TAG, "Activity: %d, Confidence: %d", sample.data.activity.state, sample.data.activity.confidence);
+            break;
+        default:
+            break;
+    }
+}
+
+void data_processing_task(void *pvParameters) {
+    const imu_processing_cfg_t *cfg = static_cast<const imu_processing_cfg_t *>(pvParameters);
+    static constexpr size_t BATCH_SZ = 32;
+    static constexpr TickType_t IDLE_TICKS = pdMS_TO_TICKS(100);   ///< longest sleep without samples, bounds housekeeping delay
+    static constexpr int64_t CAL_CHECK_PERIOD_US = 1000000LL;
+    static constexpr int64_t STATS_PERIOD_US = 10000000LL;
+
+    // per-sample lines go through binlog, formatting happens in its low priority task
+    // the report set belongs to pm_task, which applies its active profile and suspends this task outside ACTIVE
+    binlog_start();
+    imu_sample_ring_start();
+    imu_events_start();
+
+    // init is done, nothing below may allocate
+    heap_guard_arm();
+
+    imu_sample_t batch[BATCH_SZ];
+    int64_t cal_check_us = esp_timer_get_time();
+    int64_t stats_us = cal_check_us;
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // sleeps on the ring's data signal, wakes for the first sample or after IDLE_TICKS for housekeeping
+        const size_t n = imu_sample_ring_drain_burst(batch, BATCH_SZ, IDLE_TICKS);
+        for (size_t i = 0; i < n; i++) {
+            imu_log_sample(batch[i]);
+        }
+        if (n != 0 && cfg != nullptr && cfg->on_batch != nullptr) {
+            cfg->on_batch(batch, n);
+        }
+
+        const int64_t now_us = esp_timer_get_time();
+        if (now_us - cal_check_us >= CAL_CHECK_PERIOD_US) {
+            cal_check_us = now_us;
+            // an NVS write allocates, it happens once per convergence and is not part of the steady state
+            heap_guard_disarm();
+            imu_cal_save_if_converged();
+            heap_guard_arm();
+        }
+
+        if (now_us - stats_us >= STATS_PERIOD_US) {
+            stats_us = now_us;
+            // ESP_LOGx formats in this task and newlib's %f can allocate: a diagnostic, not the steady state
+            heap_guard_disarm();
+            imu_ring_stats_t stats = imu_sample_ring_get_stats();
+            ESP_LOGI(TAG, "Ring: pushed %lu, overflows %lu, high water %lu/%lu",
+                     (unsigned long)stats.pushed, (unsigned long)stats.overflows,
+                     (unsigned long)stats.high_water, (unsigned long)stats.capacity);
+            imu_metrics_print();
+
+            heap_guard_stats_t heap = heap_guard_get_stats();
+            if (heap.allocs != 0) {
+                ESP_LOGW(TAG, "Heap: %lu allocations (%lu B) since init, first %lu B from %p",
+                         (unsigned long)heap.allocs, (unsigned long)heap.bytes,
+                         (unsigned long)heap.first_size, heap.first_caller);
+            }
+            heap_guard_arm();
+        }
     }
-}
\ No newline at end of file
+}
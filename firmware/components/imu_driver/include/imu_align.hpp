@@ -0,0 +1,267 @@
+// imu_align.hpp
+#ifndef IMU_ALIGN_H
+#define IMU_ALIGN_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "imu_driver.hpp"
+
+/**
+ * Consumer side frame aligner: feed it the samples drained from the ring and
+ * it emits one frame per grid tick holding every configured report at that
+ * exact instant, so reports sampled at different phases and rates can be
+ * fused or correlated without up to a period of skew between them.
+ *
+ * Vector reports are interpolated linearly, rotation vectors with nlerp, and
+ * event reports (classifiers, detectors) hold their latest value. A tick is
+ * emitted once every interpolated report has a sample at or after it, so a
+ * frame trails the live data by about one period of the slowest report.
+ * Single task only, no locking.
+ */
+
+#ifndef IMU_ALIGN_MAX_RPTS
+#define IMU_ALIGN_MAX_RPTS 6          ///< reports per frame
+#endif
+
+#ifndef IMU_ALIGN_HISTORY
+#define IMU_ALIGN_HISTORY 8           ///< samples kept per report, power of two
+#endif
+
+static_assert((IMU_ALIGN_HISTORY & (IMU_ALIGN_HISTORY - 1)) == 0, "IMU_ALIGN_HISTORY must be a power of two");
+
+typedef enum imu_align_mode_t : uint8_t {
+    IMU_ALIGN_LINEAR,   ///< vec members interpolated linearly
+    IMU_ALIGN_NLERP,    ///< quat members, normalized lerp along the shorter arc
+    IMU_ALIGN_HOLD,     ///< latest sample at or before the tick, never gates a frame
+} imu_align_mode_t;
+
+/// @brief How a report is brought onto the grid, from the imu_sample_t member it fills
+constexpr imu_align_mode_t imu_align_mode(uint8_t report_id) {
+    return (imu_sample_kind(report_id) == IMU_SAMPLE_VEC) ? IMU_ALIGN_LINEAR
+         : (imu_sample_kind(report_id) == IMU_SAMPLE_QUAT) ? IMU_ALIGN_NLERP
+         : IMU_ALIGN_HOLD;
+}
+
+/**
+ * @brief Every configured report at one grid tick
+ * @param timestamp_us: the tick, esp_timer clock like imu_sample_t::timestamp_us
+ * @param count: number of reports, in the order given to configure()
+ * @param valid: bit i set when rpt[i] holds data, a held report has none until its first sample
+ * @param rpt: one sample per report, timestamp_us is the tick for interpolated reports and the source sample's for held ones
+ */
+typedef struct imu_frame_t {
+    uint32_t timestamp_us;
+    uint8_t count;
+    uint8_t valid;
+    imu_sample_t rpt[IMU_ALIGN_MAX_RPTS];
+} imu_frame_t;
+
+class imu_frame_aligner
+{
+    public:
+        /**
+        * @brief Select the reports of a frame and the grid, drops any buffered samples
+        * @param report_ids: reports in frame order
+        * @param count: number of reports, up to IMU_ALIGN_MAX_RPTS
+        * @param grid_period_us: tick spacing, usually the period of the fastest report
+        * @return false on a bad count or a zero period
+        */
+        bool configure(const uint8_t *report_ids, size_t count, uint32_t grid_period_us) {
+            if (report_ids == nullptr || count == 0 || count > IMU_ALIGN_MAX_RPTS || grid_period_us == 0) {
+                return false;
+            }
+
+            n_rpts = static_cast<uint8_t>(count);
+            period_us = grid_period_us;
+            for (size_t i = 0; i < count; i++) {
+                chan[i].report_id = report_ids[i];
+                chan[i].mode = imu_align_mode(report_ids[i]);
+            }
+            reset();
+            return true;
+        }
+
+        /// @brief Drop buffered samples and restart the grid at the next samples
+        void reset() {
+            for (uint8_t i = 0; i < n_rpts; i++) {
+                chan[i].head = 0;
+                chan[i].size = 0;
+            }
+            grid_started = false;
+            skipped_ticks = 0;
+        }
+
+        /**
+        * @brief Buffer one sample, samples of reports that are not in the frame are ignored
+        * @return true if the sample belongs to the frame
+        * @note Samples of one report must come in time order, as they do out of the ring
+        */
+        bool push(const imu_sample_t &sample) {
+            for (uint8_t i = 0; i < n_rpts; i++) {
+                channel_t &c = chan[i];
+                if (c.report_id != sample.report_id) {
+                    continue;
+                }
+
+                c.hist[(c.head + c.size) & MASK] = sample;
+                if (c.size < IMU_ALIGN_HISTORY) {
+                    c.size++;
+                } else {
+                    c.head = (c.head + 1) & MASK;
+                }
+                return true;
+            }
+            return false;
+        }
+
+        /**
+        * @brief Build the next frame if every interpolated report has caught up with its tick
+        * @param out: filled with the frame
+        * @return false if the next tick is not covered yet
+        * @note Call in a loop after each drain, one call emits at most one frame
+        */
+        bool next(imu_frame_t &out) {
+            if (!grid_started && !start_grid()) {
+                return false;
+            }
+
+            // a tick older than some report's history can no longer be interpolated, move past it
+            for (uint8_t i = 0; i < n_rpts; i++) {
+                const channel_t &c = chan[i];
+                if (c.mode == IMU_ALIGN_HOLD || c.size == 0) {
+                    continue;
+                }
+                const int32_t behind = static_cast<int32_t>(c.oldest().timestamp_us - tick_us);
+                if (behind > 0) {
+                    const uint32_t ticks = (static_cast<uint32_t>(behind) + period_us - 1) / period_us;
+                    tick_us += ticks * period_us;
+                    skipped_ticks += ticks;
+                }
+            }
+
+            for (uint8_t i = 0; i < n_rpts; i++) {
+                const channel_t &c = chan[i];
+                if (c.mode != IMU_ALIGN_HOLD && (c.size == 0 || before(c.newest().timestamp_us, tick_us))) {
+                    return false;
+                }
+            }
+
+            out.timestamp_us = tick_us;
+            out.count = n_rpts;
+            out.valid = 0;
+            for (uint8_t i = 0; i < n_rpts; i++) {
+                if (sample_at(chan[i], tick_us, out.rpt[i])) {
+                    out.valid |= static_cast<uint8_t>(1U << i);
+                }
+            }
+            tick_us += period_us;
+            return true;
+        }
+
+        /// @brief Ticks that could not be built because the caller fell more than IMU_ALIGN_HISTORY samples behind
+        uint32_t skipped() const { return skipped_ticks; }
+
+    private:
+        static constexpr uint32_t MASK = IMU_ALIGN_HISTORY - 1;
+
+        struct channel_t {
+            uint8_t report_id = 0;
+            imu_align_mode_t mode = IMU_ALIGN_HOLD;
+            uint32_t head = 0;
+            uint32_t size = 0;
+            imu_sample_t hist[IMU_ALIGN_HISTORY];
+
+            const imu_sample_t &oldest() const { return hist[head]; }
+            const imu_sample_t &newest() const { return hist[(head + size - 1) & MASK]; }
+            const imu_sample_t &at(uint32_t i) const { return hist[(head + i) & MASK]; }
+        };
+
+        static bool before(uint32_t a, uint32_t b) {
+            return static_cast<int32_t>(a - b) < 0;
+        }
+
+        /// @brief First tick: the grid period multiple right after every interpolated report has started
+        bool start_grid() {
+            bool any = false;
+            uint32_t start = 0;
+            for (uint8_t i = 0; i < n_rpts; i++) {
+                const channel_t &c = chan[i];
+                if (c.mode == IMU_ALIGN_HOLD) {
+                    continue;
+                }
+                if (c.size == 0) {
+                    return false;
+                }
+                if (!any || before(start, c.oldest().timestamp_us)) {
+                    start = c.oldest().timestamp_us;
+                }
+                any = true;
+            }
+            if (!any) {
+                return false;
+            }
+
+            tick_us = (start + period_us - 1) / period_us * period_us;
+            grid_started = true;
+            return true;
+        }
+
+        static bool sample_at(const channel_t &c, uint32_t t_us, imu_sample_t &out) {
+            if (c.size == 0) {
+                return false;
+            }
+
+            // newest sample at or before t, the bracket's right side is the one after it
+            uint32_t left = 0;
+            for (uint32_t i = 0; i < c.size && !before(t_us, c.at(i).timestamp_us); i++) {
+                left = i;
+            }
+            const imu_sample_t &a = c.at(left);
+            if (c.mode == IMU_ALIGN_HOLD) {
+                if (before(t_us, a.timestamp_us)) {
+                    return false;
+                }
+                out = a;
+                return true;
+            }
+
+            const imu_sample_t &b = (left + 1 < c.size) ? c.at(left + 1) : a;
+            const uint32_t span = b.timestamp_us - a.timestamp_us;
+            const float w = (span != 0) ? static_cast<float>(static_cast<int32_t>(t_us - a.timestamp_us)) / static_cast<float>(span)
+                                        : 0.0f;
+
+            out = (w < 0.5f) ? a : b;
+            out.timestamp_us = t_us;
+            if (c.mode == IMU_ALIGN_LINEAR) {
+                out.data.vec.x = a.data.vec.x + (b.data.vec.x - a.data.vec.x) * w;
+                out.data.vec.y = a.data.vec.y + (b.data.vec.y - a.data.vec.y) * w;
+                out.data.vec.z = a.data.vec.z + (b.data.vec.z - a.data.vec.z) * w;
+            } else {
+                const float dot = a.data.quat.real * b.data.quat.real + a.data.quat.i * b.data.quat.i +
+                                  a.data.quat.j * b.data.quat.j + a.data.quat.k * b.data.quat.k;
+                const float sb = (dot < 0.0f) ? -w : w;
+                const float sa = 1.0f - w;
+                float q[4] = {
+                    sa * a.data.quat.real + sb * b.data.quat.real,
+                    sa * a.data.quat.i + sb * b.data.quat.i,
+                    sa * a.data.quat.j + sb * b.data.quat.j,
+                    sa * a.data.quat.k + sb * b.data.quat.k,
+                };
+                const float norm = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+                const float inv = (norm > 0.0f) ? 1.0f / norm : 0.0f;
+                out.data.quat = {q[0] * inv, q[1] * inv, q[2] * inv, q[3] * inv};
+            }
+            return true;
+        }
+
+        channel_t chan[IMU_ALIGN_MAX_RPTS];
+        uint8_t n_rpts = 0;
+        uint32_t period_us = 1;
+        uint32_t tick_us = 0;
+        uint32_t skipped_ticks = 0;
+        bool grid_started = false;
+};
+
+#endif /* IMU_ALIGN_H */
@@ -0,0 +1,501 @@
+// imu_codec.hpp
+#ifndef IMU_CODEC_H
+#define IMU_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "imu_compact.hpp"
+
+/**
+ * Lossless streaming codec for compact samples (imu_compact.hpp), for radio
+ * uploads and storage. Each report is predicted from its own history and
+ * only the residual is written, bit packed when small, so a 100 Hz report
+ * costs about 3-4 bytes a sample instead of 12 (compact) or 24 (imu_sample_t).
+ *
+ * Output is cut into self contained blocks of at most IMU_CODEC_BLOCK_BYTES
+ * (one BLE notification at MTU 247): every report restarts from a key sample
+ * in each block, so any block decodes on its own (random access, a lost packet
+ * loses one block) and the encoder holds one block plus IMU_CODEC_MAX_CHANNELS
+ * predictor states, nothing else. Larger blocks amortize the key samples
+ * better, see imu_codec_encoder_t.
+ *
+ * Block (little endian):
+ *   uint8 flags (IMU_CODEC_F_*), uint8 reserved (0), uint16 sample count, then per sample
+ *   uint8 tag: bits 0..2 channel (order of first appearance in the block), bit 3 key sample,
+ *              bit 4 interval residual follows (else the interval repeats), bit 5 ext byte follows,
+ *              bits 6..7 residual packing (IMU_CODEC_PACK_*)
+ *   key:       uint8 report_id, uint8 format, timestamp_us (uint32 for the block's first
+ *              sample, else zigzag varint from it), 3 x zigzag varint v
+ *   predicted: [uint8 ext: bit 0 format byte follows, bit 1 hemisphere flips], [uint8 format],
+ *              [zigzag varint interval - previous interval], 3 residuals as packed by bits 6..7
+ *
+ * Prediction per axis: the previous value (order 1) or 2 x previous - the one
+ * before (order 2). With IMU_CODEC_F_ADAPTIVE each channel uses whichever
+ * order had the smaller residuals so far, the decoder makes the same choice
+ * from the same history. With IMU_CODEC_F_QUAT_TRACK rotation vectors are
+ * predicted on a continuous hemisphere: compact samples store q with real >= 0,
+ * so i, j, k change sign when the real part crosses zero; the channel keeps
+ * coding on the far side (ext bit 1 marks the crossing) and the jump costs one
+ * byte instead of three large residuals.
+ *
+ * Residual packing, r = zigzag(residual): 0 three varints, 1 three 5 bit fields
+ * in 2 bytes, 2 three bytes, 3 three 10 bit fields in 4 bytes (x | y << n | z << 2n).
+ * varint: 7 bits per byte, least significant group first, bit 7 set on all but the last
+ * zigzag: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+ */
+
+#ifndef IMU_CODEC_BLOCK_BYTES
+#define IMU_CODEC_BLOCK_BYTES 244      ///< default block size, one BLE notification at ATT MTU 247
+#endif
+
+#define IMU_CODEC_MAX_CHANNELS 8       ///< reports per block, a ninth one starts the next block
+#define IMU_CODEC_HDR_BYTES 4
+#define IMU_CODEC_MAX_SAMPLE_BYTES 20  ///< tag, ext, format, 5 byte interval, 3 x 3 byte residual (or a key sample)
+
+#define IMU_CODEC_F_ADAPTIVE 0x01      ///< per channel choice of order 1 / order 2 prediction
+#define IMU_CODEC_F_QUAT_TRACK 0x02    ///< sign continuous rotation vector prediction
+#define IMU_CODEC_F_DEFAULT (IMU_CODEC_F_ADAPTIVE | IMU_CODEC_F_QUAT_TRACK)
+
+#define IMU_CODEC_TAG_CHANNEL 0x07
+#define IMU_CODEC_TAG_KEY 0x08
+#define IMU_CODEC_TAG_INTERVAL 0x10
+#define IMU_CODEC_TAG_EXT 0x20
+#define IMU_CODEC_TAG_PACK_SHIFT 6
+#define IMU_CODEC_EXT_FORMAT 0x01
+#define IMU_CODEC_EXT_NEGATED 0x02
+
+#define IMU_CODEC_PACK_VARINT 0
+#define IMU_CODEC_PACK_5 1
+#define IMU_CODEC_PACK_8 2
+#define IMU_CODEC_PACK_10 3
+
+inline uint32_t imu_codec_zigzag(int32_t v) {
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+inline int32_t imu_codec_unzigzag(uint32_t v) {
+    return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+}
+
+inline size_t imu_codec_put_varint(uint8_t *dst, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        dst[n++] = static_cast<uint8_t>(v) | 0x80;
+        v >>= 7;
+    }
+    dst[n++] = static_cast<uint8_t>(v);
+    return n;
+}
+
+inline bool imu_codec_get_varint(const uint8_t *&p, const uint8_t *end, uint32_t &v) {
+    v = 0;
+    for (uint32_t shift = 0; p < end && shift < 35; shift += 7) {
+        const uint8_t byte = *p++;
+        v |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief Write three zigzag residuals in the smallest packing that holds them, returns bytes written
+inline size_t imu_codec_put_residuals(uint8_t *dst, const uint32_t r[3], uint8_t &pack) {
+    const uint32_t m = r[0] | r[1] | r[2];
+    if (m < (1U << 5)) {
+        const uint32_t w = r[0] | (r[1] << 5) | (r[2] << 10);
+        dst[0] = static_cast<uint8_t>(w);
+        dst[1] = static_cast<uint8_t>(w >> 8);
+        pack = IMU_CODEC_PACK_5;
+        return 2;
+    }
+    if (m < (1U << 8)) {
+        dst[0] = static_cast<uint8_t>(r[0]);
+        dst[1] = static_cast<uint8_t>(r[1]);
+        dst[2] = static_cast<uint8_t>(r[2]);
+        pack = IMU_CODEC_PACK_8;
+        return 3;
+    }
+    if (m < (1U << 10)) {
+        const uint32_t w = r[0] | (r[1] << 10) | (r[2] << 20);
+        std::memcpy(dst, &w, sizeof(w));
+        pack = IMU_CODEC_PACK_10;
+        return 4;
+    }
+    size_t n = 0;
+    for (int a = 0; a < 3; a++) {
+        n += imu_codec_put_varint(dst + n, r[a]);
+    }
+    pack = IMU_CODEC_PACK_VARINT;
+    return n;
+}
+
+inline bool imu_codec_get_residuals(const uint8_t *&p, const uint8_t *end, uint8_t pack, uint32_t r[3]) {
+    static constexpr uint8_t bytes[] = {0, 2, 3, 4};
+    if (pack != IMU_CODEC_PACK_VARINT && end - p < bytes[pack]) {
+        return false;
+    }
+    switch (pack) {
+        case IMU_CODEC_PACK_5: {
+            const uint32_t w = p[0] | (p[1] << 8);
+            r[0] = w & 0x1F;
+            r[1] = (w >> 5) & 0x1F;
+            r[2] = (w >> 10) & 0x1F;
+            break;
+        }
+        case IMU_CODEC_PACK_8:
+            r[0] = p[0];
+            r[1] = p[1];
+            r[2] = p[2];
+            break;
+        case IMU_CODEC_PACK_10: {
+            uint32_t w;
+            std::memcpy(&w, p, sizeof(w));
+            r[0] = w & 0x3FF;
+            r[1] = (w >> 10) & 0x3FF;
+            r[2] = (w >> 20) & 0x3FF;
+            break;
+        }
+        default:
+            return imu_codec_get_varint(p, end, r[0]) && imu_codec_get_varint(p, end, r[1]) &&
+                   imu_codec_get_varint(p, end, r[2]);
+    }
+    p += bytes[pack];
+    return true;
+}
+
+/**
+ * Predictor state of one report inside a block, identical on the encoder and
+ * decoder side. x1 / x2 hold the last two values as coded (negated while
+ * negated is set), cost1 / cost2 decaying sums of the order 1 / order 2 residuals.
+ */
+typedef struct imu_codec_channel_t {
+    uint8_t report_id;
+    uint8_t format;
+    bool quat;
+    bool negated;
+    uint32_t last_us;
+    int32_t last_dt;
+    int32_t x1[3];
+    int32_t x2[3];
+    uint32_t cost1;
+    uint32_t cost2;
+} imu_codec_channel_t;
+
+inline void imu_codec_channel_key(imu_codec_channel_t &c, const imu_compact_sample_t &s) {
+    c.report_id = s.report_id;
+    c.format = s.format;
+    c.quat = imu_sample_kind(s.report_id) == IMU_SAMPLE_QUAT;
+    c.negated = false;
+    c.last_us = s.timestamp_us;
+    c.last_dt = 0;
+    for (int a = 0; a < 3; a++) {
+        c.x1[a] = s.v[a];
+        c.x2[a] = s.v[a];
+    }
+    c.cost1 = 0;
+    c.cost2 = 0;
+}
+
+inline void imu_codec_predict(const imu_codec_channel_t &c, uint8_t flags, int32_t pred[3]) {
+    const bool order2 = (flags & IMU_CODEC_F_ADAPTIVE) && c.cost2 < c.cost1;
+    for (int a = 0; a < 3; a++) {
+        pred[a] = order2 ? 2 * c.x1[a] - c.x2[a] : c.x1[a];
+    }
+}
+
+/// @brief Shift in a coded value and score both predictors on it
+inline void imu_codec_update(imu_codec_channel_t &c, const int32_t coded[3]) {
+    uint32_t e1 = 0;
+    uint32_t e2 = 0;
+    for (int a = 0; a < 3; a++) {
+        const int32_t r1 = coded[a] - c.x1[a];
+        const int32_t r2 = coded[a] - (2 * c.x1[a] - c.x2[a]);
+        e1 += static_cast<uint32_t>(r1 < 0 ? -r1 : r1);
+        e2 += static_cast<uint32_t>(r2 < 0 ? -r2 : r2);
+        c.x2[a] = c.x1[a];
+        c.x1[a] = coded[a];
+    }
+    c.cost1 += e1 - (c.cost1 >> 3);
+    c.cost2 += e2 - (c.cost2 >> 3);
+}
+
+/**
+ * Block encoder. push() samples in the order they are drained; when it returns
+ * false the block is complete: send or store block() / size(), call
+ * start_block() and push the same sample again. Cheap enough for the ingestion
+ * path: a few adds and compares per axis, no division, no allocation.
+ * @tparam BLOCK_BYTES: block size limit, the encoder's whole buffer
+ */
+template <size_t BLOCK_BYTES = IMU_CODEC_BLOCK_BYTES>
+class imu_codec_encoder_t
+{
+    static_assert(BLOCK_BYTES >= IMU_CODEC_HDR_BYTES + IMU_CODEC_MAX_SAMPLE_BYTES, "block must hold a sample");
+    static_assert(BLOCK_BYTES <= 65535, "block size must fit the format");
+
+    public:
+        explicit imu_codec_encoder_t(uint8_t flags = IMU_CODEC_F_DEFAULT) : codec_flags(flags) {
+            start_block();
+        }
+
+        /// @brief Drop the current block and start an empty one
+        void start_block() {
+            buf[0] = codec_flags;
+            buf[1] = 0;
+            len = IMU_CODEC_HDR_BYTES;
+            count = 0;
+            n_channels = 0;
+            set_count();
+        }
+
+        /**
+        * @brief Append one sample to the block
+        * @return false if it does not fit (bytes or channels), the block is unchanged
+        */
+        bool push(const imu_compact_sample_t &s) {
+            uint8_t ch = 0;
+            while (ch < n_channels && channels[ch].report_id != s.report_id) {
+                ch++;
+            }
+            const bool key = (ch == n_channels);
+            if ((key && n_channels == IMU_CODEC_MAX_CHANNELS) || count == UINT16_MAX ||
+                len + IMU_CODEC_MAX_SAMPLE_BYTES > BLOCK_BYTES) {
+                return false;
+            }
+
+            len += key ? put_key(buf + len, ch, s) : put_predicted(buf + len, channels[ch], ch, s);
+            count++;
+            set_count();
+            return true;
+        }
+
+        const uint8_t *block() const { return buf; }
+        size_t size() const { return len; }
+        uint16_t samples() const { return count; }
+
+    private:
+        void set_count() {
+            buf[2] = static_cast<uint8_t>(count);
+            buf[3] = static_cast<uint8_t>(count >> 8);
+        }
+
+        size_t put_key(uint8_t *out, uint8_t ch, const imu_compact_sample_t &s) {
+            size_t n = 0;
+            out[n++] = static_cast<uint8_t>(ch | IMU_CODEC_TAG_KEY);
+            out[n++] = s.report_id;
+            out[n++] = s.format;
+            if (count == 0) {
+                std::memcpy(out + n, &s.timestamp_us, sizeof(s.timestamp_us));
+                n += sizeof(s.timestamp_us);
+                block_us = s.timestamp_us;
+            } else {
+                n += imu_codec_put_varint(out + n, imu_codec_zigzag(static_cast<int32_t>(s.timestamp_us - block_us)));
+            }
+            for (int a = 0; a < 3; a++) {
+                n += imu_codec_put_varint(out + n, imu_codec_zigzag(s.v[a]));
+            }
+            imu_codec_channel_key(channels[ch], s);
+            n_channels++;
+            return n;
+        }
+
+        size_t put_predicted(uint8_t *out, imu_codec_channel_t &c, uint8_t ch, const imu_compact_sample_t &s) {
+            uint8_t tag = ch;
+            uint8_t ext = 0;
+            size_t n = 1;
+
+            int32_t pred[3];
+            imu_codec_predict(c, codec_flags, pred);
+            const int32_t sign = c.negated ? -1 : 1;
+            int32_t coded[3] = {sign * s.v[0], sign * s.v[1], sign * s.v[2]};
+            if (c.quat && (codec_flags & IMU_CODEC_F_QUAT_TRACK)) {
+                uint32_t same = 0;
+                uint32_t flipped = 0;
+                for (int a = 0; a < 3; a++) {
+                    const int32_t d = coded[a] - pred[a];
+                    const int32_t f = -coded[a] - pred[a];
+                    same += static_cast<uint32_t>(d < 0 ? -d : d);
+                    flipped += static_cast<uint32_t>(f < 0 ? -f : f);
+                }
+                if (flipped < same) {
+                    ext |= IMU_CODEC_EXT_NEGATED;
+                    c.negated = !c.negated;
+                    for (int a = 0; a < 3; a++) {
+                        coded[a] = -coded[a];
+                    }
+                }
+            }
+
+            if (s.format != c.format) {
+                ext |= IMU_CODEC_EXT_FORMAT;
+            }
+            if (ext != 0) {
+                tag |= IMU_CODEC_TAG_EXT;
+                out[n++] = ext;
+                if (ext & IMU_CODEC_EXT_FORMAT) {
+                    out[n++] = s.format;
+                    c.format = s.format;
+                }
+            }
+
+            const int32_t dt = static_cast<int32_t>(s.timestamp_us - c.last_us);
+            if (dt != c.last_dt) {
+                tag |= IMU_CODEC_TAG_INTERVAL;
+                n += imu_codec_put_varint(out + n, imu_codec_zigzag(dt - c.last_dt));
+            }
+            c.last_us = s.timestamp_us;
+            c.last_dt = dt;
+
+            uint32_t r[3];
+            for (int a = 0; a < 3; a++) {
+                r[a] = imu_codec_zigzag(coded[a] - pred[a]);
+            }
+            uint8_t pack = IMU_CODEC_PACK_VARINT;
+            n += imu_codec_put_residuals(out + n, r, pack);
+            imu_codec_update(c, coded);
+
+            out[0] = static_cast<uint8_t>(tag | (pack << IMU_CODEC_TAG_PACK_SHIFT));
+            return n;
+        }
+
+        uint8_t codec_flags;
+        uint8_t buf[BLOCK_BYTES];
+        size_t len = 0;
+        uint16_t count = 0;
+        uint32_t block_us = 0;
+        uint8_t n_channels = 0;
+        imu_codec_channel_t channels[IMU_CODEC_MAX_CHANNELS];
+};
+
+using imu_codec_encoder = imu_codec_encoder_t<>;
+
+/// @brief Samples in a block, 0 for a block too short to have a header
+inline uint16_t imu_codec_block_samples(const uint8_t *block, size_t len) {
+    return (len >= IMU_CODEC_HDR_BYTES) ? static_cast<uint16_t>(block[2] | (block[3] << 8)) : 0;
+}
+
+/**
+* @brief Timestamp of a block's first sample (always a key sample), for seeking without decoding
+* @return false for an empty or truncated block
+*/
+inline bool imu_codec_block_first_us(const uint8_t *block, size_t len, uint32_t &first_us) {
+    if (imu_codec_block_samples(block, len) == 0 || len < IMU_CODEC_HDR_BYTES + 7) {
+        return false;
+    }
+    std::memcpy(&first_us, block + IMU_CODEC_HDR_BYTES + 3, sizeof(first_us));
+    return true;
+}
+
+/**
+* @brief Decode one block
+* @param block: block as produced by imu_codec_encoder_t, of any size
+* @param len: its size
+* @param out: decoded samples
+* @param max: capacity of out, imu_codec_block_samples() gives the count
+* @return samples decoded, 0 for a malformed block or max too small
+*/
+inline size_t imu_codec_decode_block(const uint8_t *block, size_t len, imu_compact_sample_t *out, size_t max) {
+    const uint16_t count = imu_codec_block_samples(block, len);
+    if (count > max) {
+        return 0;
+    }
+
+    const uint8_t flags = block[0];
+    const uint8_t *p = block + IMU_CODEC_HDR_BYTES;
+    const uint8_t *end = block + len;
+    imu_codec_channel_t channels[IMU_CODEC_MAX_CHANNELS];
+    uint8_t n_channels = 0;
+    uint32_t block_us = 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        if (p >= end) {
+            return 0;
+        }
+        const uint8_t tag = *p++;
+        const uint8_t ch = tag & IMU_CODEC_TAG_CHANNEL;
+        imu_compact_sample_t &s = out[i];
+        uint32_t u = 0;
+
+        if (tag & IMU_CODEC_TAG_KEY) {
+            if (ch != n_channels || end - p < 2) {
+                return 0;
+            }
+            s.report_id = *p++;
+            s.format = *p++;
+            if (i == 0) {
+                if (end - p < 4) {
+                    return 0;
+                }
+                std::memcpy(&block_us, p, sizeof(block_us));
+                p += sizeof(block_us);
+                s.timestamp_us = block_us;
+            } else {
+                if (!imu_codec_get_varint(p, end, u)) {
+                    return 0;
+                }
+                s.timestamp_us = block_us + static_cast<uint32_t>(imu_codec_unzigzag(u));
+            }
+            for (int a = 0; a < 3; a++) {
+                if (!imu_codec_get_varint(p, end, u)) {
+                    return 0;
+                }
+                s.v[a] = static_cast<int16_t>(imu_codec_unzigzag(u));
+            }
+            imu_codec_channel_key(channels[ch], s);
+            n_channels++;
+            continue;
+        }
+
+        if (ch >= n_channels) {
+            return 0;
+        }
+        imu_codec_channel_t &c = channels[ch];
+        uint8_t ext = 0;
+        if (tag & IMU_CODEC_TAG_EXT) {
+            if (p >= end) {
+                return 0;
+            }
+            ext = *p++;
+            if (ext & IMU_CODEC_EXT_NEGATED) {
+                c.negated = !c.negated;
+            }
+            if (ext & IMU_CODEC_EXT_FORMAT) {
+                if (p >= end) {
+                    return 0;
+                }
+                c.format = *p++;
+            }
+        }
+        if (tag & IMU_CODEC_TAG_INTERVAL) {
+            if (!imu_codec_get_varint(p, end, u)) {
+                return 0;
+            }
+            c.last_dt += imu_codec_unzigzag(u);
+        }
+        c.last_us += static_cast<uint32_t>(c.last_dt);
+
+        uint32_t r[3];
+        if (!imu_codec_get_residuals(p, end, tag >> IMU_CODEC_TAG_PACK_SHIFT, r)) {
+            return 0;
+        }
+        int32_t pred[3];
+        int32_t coded[3];
+        imu_codec_predict(c, flags, pred);
+        for (int a = 0; a < 3; a++) {
+            coded[a] = pred[a] + imu_codec_unzigzag(r[a]);
+        }
+        imu_codec_update(c, coded);
+
+        s.timestamp_us = c.last_us;
+        s.report_id = c.report_id;
+        s.format = c.format;
+        for (int a = 0; a < 3; a++) {
+            s.v[a] = static_cast<int16_t>(c.negated ? -coded[a] : coded[a]);
+        }
+    }
+    return count;
+}
+
+#endif /* IMU_CODEC_H */
@@ -0,0 +1,90 @@
+// imu_compact.hpp
+#ifndef IMU_COMPACT_H
+#define IMU_COMPACT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "imu_report_types.hpp"
+
+/**
+ * Compact sample: a report kept in the hub's native form, int16 at the
+ * report's Q point (imu_report_q_point()), 12 bytes against 24 for
+ * imu_sample_t. Meant for long buffers (pre-trigger history), logs and radio
+ * payloads; convert to float only where the values are consumed. Packing and
+ * unpacking full samples lives in imu_driver.hpp (COMPACT SAMPLES).
+ *
+ * Record (little endian, 12 bytes):
+ *   uint32 timestamp_us, uint8 report_id, uint8 format, 3 x int16 v
+ *   format: bits 0..3 Q point, bits 4..6 BNO08xAccuracy
+ *   v by imu_sample_kind():
+ *     VEC       x, y, z at the Q point
+ *     QUAT      i, j, k at the Q point, stored with real >= 0 (q and -q are the same
+ *               rotation) and restored as sqrt(1 - i^2 - j^2 - k^2)
+ *     ACTIVITY  state, confidence
+ *     VALUE     low 16 bits, high 16 bits
+ */
+
+#define IMU_COMPACT_Q_MASK 0x0FU
+#define IMU_COMPACT_ACC_SHIFT 4
+#define IMU_COMPACT_ACC_MASK 0x07U
+
+typedef struct imu_compact_sample_t {
+    uint32_t timestamp_us;
+    uint8_t report_id;
+    uint8_t format;
+    int16_t v[3];
+} imu_compact_sample_t;
+
+static_assert(sizeof(imu_compact_sample_t) == 12, "compact record layout is part of the log format");
+
+inline uint8_t imu_compact_q_point(const imu_compact_sample_t &s) {
+    return s.format & IMU_COMPACT_Q_MASK;
+}
+
+inline uint8_t imu_compact_accuracy(const imu_compact_sample_t &s) {
+    return (s.format >> IMU_COMPACT_ACC_SHIFT) & IMU_COMPACT_ACC_MASK;
+}
+
+/// @brief float -> Q point int16, rounded and saturated
+inline int16_t imu_float_to_q16(float value, uint8_t q_point) {
+    const float scaled = std::round(std::ldexp(value, q_point));
+    return static_cast<int16_t>(std::clamp(scaled, -32768.0f, 32767.0f));
+}
+
+/**
+* @brief Convert a run of Q point values to float, written to auto-vectorize (one multiply per element)
+* @param in: int16 values, all at q_point
+* @param out: n floats
+* @param n: number of values
+* @param q_point: fractional bits of in
+*/
+inline void imu_q16_to_float(const int16_t *__restrict in, float *__restrict out, size_t n, uint8_t q_point) {
+    const float scale = std::ldexp(1.0f, -static_cast<int>(q_point));
+    for (size_t i = 0; i < n; i++) {
+        out[i] = static_cast<float>(in[i]) * scale;
+    }
+}
+
+/**
+* @brief Convert the vectors of a run of compact VEC samples of one report to interleaved x, y, z floats
+* @param in: samples of a single report, as a pre-trigger buffer of one sensor holds them
+* @param n: number of samples
+* @param out_xyz: 3 * n floats
+*/
+inline void imu_compact_vec_to_float(const imu_compact_sample_t *__restrict in, size_t n, float *__restrict out_xyz) {
+    if (n == 0) {
+        return;
+    }
+
+    const float scale = std::ldexp(1.0f, -static_cast<int>(imu_compact_q_point(in[0])));
+    for (size_t i = 0; i < n; i++) {
+        out_xyz[3 * i + 0] = static_cast<float>(in[i].v[0]) * scale;
+        out_xyz[3 * i + 1] = static_cast<float>(in[i].v[1]) * scale;
+        out_xyz[3 * i + 2] = static_cast<float>(in[i].v[2]) * scale;
+    }
+}
+
+#endif /* IMU_COMPACT_H */
@@ -2,28 +2,66 @@
 #ifndef IMU_DRIVER_H
 #define IMU_DRIVER_H
 
+#include "freertos/FreeRTOS.h"
 #include "BNO08xGlobalTypes.hpp"
 #include "BNO08xPrivateTypes.hpp"
+#include "imu_compact.hpp"
+#include "imu_metrics.hpp"
+#include "imu_report_types.hpp"
+#include "imu_sample_ring.hpp"
+#include "imu_seqlock.hpp"
 
 /**
  * IMU Driver - Thin wrapper around BNO08x library
  */
 
-extern volatile bool motion_flag;
-
 /**
  * @brief Configuration for an IMU report, used to enable/disablemultiple reports
  * @param report_id: the ID of the report to enable
  * @param period_us: the period in microseconds to sample the report auto set to 100ms if not provided
+ * @param batch_us: hub FIFO batch latency, 0 keeps config.batchInterval_us (immediate by default)
  * @param config: the configuration for the report
  */
 typedef struct imu_report_cfg_t {
     sh2_SensorId_t report_id;
     uint32_t period_us;
+    uint32_t batch_us = 0;
     sh2_SensorConfig_t config = BNO08xPrivateTypes::default_sensor_cfg;
 } imu_report_cfg_t;
 
 
+/**
+ * @brief One report sample as queued from the driver callback to the processing task
+ * @param timestamp_us: estimated measurement time, low 32 bits of the esp_timer clock, wraps every ~71 min (see CLOCK SYNC)
+ * @param report_id: sh2_SensorId_t of the sample, selects the active data member
+ * @param accuracy: BNO08xAccuracy of the sample where the report carries one
+ */
+typedef struct imu_sample_t {
+    uint32_t timestamp_us;
+    uint8_t report_id;
+    uint8_t accuracy;
+    uint16_t reserved;
+    union {
+        struct { float x, y, z; } vec;              ///< accel, gyro, magf (raw reports as counts)
+        struct { float real, i, j, k; } quat;       ///< rotation vectors
+        struct { uint8_t state, confidence; } activity;
+        uint32_t value;                             ///< stability, shake bits, steps, sig motion
+    } data;
+} imu_sample_t;
+
+#ifndef IMU_SAMPLE_RING_CAPACITY
+#define IMU_SAMPLE_RING_CAPACITY 256   ///< 320 ms of 400 Hz accel + gyro
+#endif
+
+#ifndef IMU_SAMPLE_RING_COMPACT
+#define IMU_SAMPLE_RING_COMPACT 0      ///< 1 stores ring records as imu_compact_sample_t, half the ring SRAM
+#endif
+
+#ifndef IMU_BURST_GAP_MS
+#define IMU_BURST_GAP_MS 5             ///< silence that ends a FIFO flush burst
+#endif
+
+
 bool imu_init();
 bool imu_destructor();
 
@@ -46,8 +84,66 @@ bool imu_destructor();
 bool imu_enable_rpt(uint8_t report_id, uint32_t period_us = 100000UL, 
                        sh2_SensorConfig_t config = BNO08xPrivateTypes::default_sensor_cfg);
 
+/**
+* @brief Enable a report with hub side batching, samples queue in the BNO08x FIFO for up to batch_us
+* @param report_id: the ID of the report to enable
+* @param period_us: the period in microseconds to sample the report
+* @param batch_us: longest time a sample may wait in the hub FIFO before the host is woken, 0 for immediate
+* @param config: the configuration for the report, batchInterval_us is overwritten with batch_us
+* @return true if the report was enabled successfully, false otherwise
+* @note The whole FIFO is flushed at once, size IMU_SAMPLE_RING_CAPACITY for batch_us / period_us per report
+*/
+bool imu_enable_rpt_batched(uint8_t report_id, uint32_t period_us, uint32_t batch_us,
+                            sh2_SensorConfig_t config = BNO08xPrivateTypes::default_sensor_cfg);
+
+/**
+* @brief Enable several reports, each with its own period, batch latency and config
+* @param rpts: reports to enable
+* @param count: number of entries in rpts
+* @return true if every report was enabled, false if any failed (the others are still enabled)
+*/
 bool imu_enable_multi_rpts(imu_report_cfg_t *rpts, size_t count);
 
+/**
+* @brief Counters of one imu_apply_rpt_profile() call
+* @param enabled: reports that were off and got a set-feature
+* @param changed: reports already on whose period or config changed
+* @param disabled: reports on but not in the profile
+* @param unchanged: reports left alone, they keep streaming through the switch
+* @param duration_us: wall time of the whole reconfiguration
+*/
+typedef struct imu_reconfig_stats_t {
+    uint8_t enabled;
+    uint8_t changed;
+    uint8_t disabled;
+    uint8_t unchanged;
+    uint32_t duration_us;
+} imu_reconfig_stats_t;
+
+/**
+* @brief Switch to a report profile with the fewest set-feature commands, diffed against the live set
+* @param rpts: the full profile, reports not listed are disabled
+* @param count: number of entries in rpts
+* @param stats: optional, filled with the diff counters and reconfiguration time
+* @return true if every command succeeded
+* @note One-shot reports in the profile are always re-sent, the hub may have retired them since
+*/
+bool imu_apply_rpt_profile(const imu_report_cfg_t *rpts, size_t count, imu_reconfig_stats_t *stats = nullptr);
+
+/**
+* @brief Get the period and config a report was last enabled with through imu_driver
+* @param report_id: the ID of the report
+* @param cfg: filled with the live configuration, batch_us mirrors config.batchInterval_us
+* @return false if the report is not enabled
+*/
+bool imu_get_rpt_cfg(uint8_t report_id, imu_report_cfg_t &cfg);
+
+/**
+* @brief Ask the hub to flush its batch FIFO now instead of waiting for the batch interval
+* @return true if every batched report accepted the flush request
+*/
+bool imu_flush_rpts();
+
 /** 
 * @brief Disable a specific report
 * @param report_id: the ID of the report to disable
@@ -70,10 +166,9 @@ bool imu_has_new_data(uint8_t report_id);
 
 /** 
 * @brief Rearm the significant motion report
-* @param report_id: the ID of the report to disable
 * @param period_us: the period in microseconds to sample the report auto set to 100ms if not provided
 * @param config: the configuration for the report
-* @return true if the report was enabled successfully, false otherwise
+* @return true if the report was enabled successfully, false if the hub rejected the enable and it is not armed
 */
 bool imu_rearm_sig_motion(uint32_t period_us = 100000UL, 
                           sh2_SensorConfig_t config = BNO08xPrivateTypes::default_sensor_cfg);
@@ -84,7 +179,7 @@ bool imu_rearm_sig_motion(uint32_t period_us = 100000UL,
 * ====================================== 
 *       GETTERS FOR ALL REPORTS 
 * ======================================
-* @note Only raw reports have timestamps
+* @note Only raw reports have timestamps, imu_latest_read() and the sample ring stamp every report
 * ======================================
 */
 
@@ -217,6 +312,45 @@ bno08x_step_counter_t imu_get_step_counter();
 */
 bno08x_significant_motion_t imu_get_significant_motion();
 
+/**
+* @brief Typed getter for any report, resolved at compile time
+* @tparam ID: the ID of the report, e.g. imu_get<SH2_ACCELEROMETER>()
+* @return the report's data struct, see imu_report_types.hpp for the mapping
+* @note Uncalibrated reports return the calibrated-style value, rotation vectors the quaternion
+*/
+template <uint8_t ID>
+typename imu_report_traits<ID>::type imu_get();
+
+
+/** 
+* ====================================== 
+*       REPORT REGISTRY
+* ======================================
+*/
+
+/// @brief Bit of a report in the masks returned by imu_get_enabled_rpts() / imu_poll_new_data()
+#define IMU_RPT_BIT(report_id) (1ULL << (report_id))
+
+/**
+* @brief Get the capability flags of a report
+* @param report_id: the ID of the report
+* @return OR of imu_rpt_cap_t flags, IMU_RPT_CAP_NONE for unsupported IDs
+*/
+uint8_t imu_get_rpt_caps(uint8_t report_id);
+
+/**
+* @brief Get the set of reports currently enabled through imu_driver
+* @return mask of IMU_RPT_BIT(report_id)
+*/
+uint64_t imu_get_enabled_rpts();
+
+/**
+* @brief Check every enabled report for new data in one pass
+* @return mask of IMU_RPT_BIT(report_id) with new data
+* @note Consumes the new data flags, same as imu_has_new_data()
+*/
+uint64_t imu_poll_new_data();
+
 
 /** 
 * ====================================== 
@@ -225,9 +359,22 @@ bno08x_significant_motion_t imu_get_significant_motion();
 */
 
 int imu_get_int_pin();                       
+
+/**
+* @brief Reset the hub, wait for its reset message and replay the desired configuration (see FAULT RECOVERY)
+* @return false if the reset failed or its message did not arrive within IMU_HUB_BOOT_MAX_MS (the task waiting
+*         on IMU_EVT_HUB_RESET replays when it does), replay failures are counted in imu_recovery_get_stats()
+*/
 bool imu_hard_reset();
 bool imu_soft_reset();
 
+/**
+* @brief Choose the sensors the hub calibrates dynamically, a runtime setting the hub forgets on reset
+* @param sensors: OR of BNO08xCalSel bits, BNO08xCalSel::all is the hub's default after a reset
+* @return true if the hub accepted it, only the bits that change are sent
+*/
+bool imu_set_dynamic_calibration(uint8_t sensors);
+
 /**
 * @brief Run the dynamic calibration routine with user-friendly instructions
 * @return true if the dynamic calibration routine was run successfully
@@ -262,11 +409,89 @@ bool imu_frs_read(BNO08xFrsID frs_id, uint32_t (&data)[16], uint16_t &rx_data_sz
 bool imu_frs_write(BNO08xFrsID frs_id, uint32_t *data, uint16_t tx_data_sz);
 
 /**
-* @brief Dump raw FRS record contents to serial for debugging
+* @brief Dump FRS record contents to serial for debugging
 * @param frs_id: the FRS record ID to dump
+* @note Served from the FRS cache, staged changes that are not committed yet show as dirty
 */
 void imu_frs_dump(BNO08xFrsID frs_id);
 
+/** 
+* ===========================================
+*   FRS RECORD CACHE
+* ===========================================
+* Records are kept in RAM after the first read. Changes are staged (dirty) and
+* imu_frs_commit() writes every dirty record in one session, then reads each
+* back and compares. The bus is only touched on a miss or a commit. Records
+* live in hub flash, so the cache survives hub resets.
+*/
+
+#ifndef IMU_FRS_CACHE_SLOTS
+#define IMU_FRS_CACHE_SLOTS 8   ///< records cached at once, least recently used clean record is evicted
+#endif
+
+/**
+ * @brief FRS cache counters
+ * @param hits: reads served from RAM
+ * @param misses: reads that went to the bus
+ * @param bus_reads: FRS read handshakes, misses and verify reads
+ * @param bus_writes: FRS write handshakes
+ * @param commits: commit sessions that wrote at least one record
+ * @param verify_failures: records that read back different from what was written
+ * @param evictions: clean records dropped to make room
+ */
+typedef struct imu_frs_cache_stats_t {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t bus_reads;
+    uint32_t bus_writes;
+    uint32_t commits;
+    uint32_t verify_failures;
+    uint32_t evictions;
+} imu_frs_cache_stats_t;
+
+/**
+* @brief Read an FRS record through the cache
+* @param frs_id: the FRS record ID to read
+* @param data: buffer to store the record (max 16 uint32_t words)
+* @param rx_data_sz: on success, number of words (0 for an empty record)
+* @return true if the record is cached or was read successfully
+* @note Returns staged contents for dirty records
+*/
+bool imu_frs_cached_read(BNO08xFrsID frs_id, uint32_t (&data)[16], uint16_t &rx_data_sz);
+
+/**
+* @brief Stage a record change in RAM, nothing is sent until imu_frs_commit()
+* @param frs_id: the FRS record ID to change
+* @param data: new record contents
+* @param tx_data_sz: number of words, 1 to 16
+* @return true if staged (a change equal to the cached record is dropped and not marked dirty)
+*/
+bool imu_frs_stage(BNO08xFrsID frs_id, const uint32_t *data, uint16_t tx_data_sz);
+
+/**
+* @brief Write every dirty record in one session and verify each by reading it back
+* @return true if every dirty record was written and verified, failed records stay dirty
+*/
+bool imu_frs_commit();
+
+/**
+* @brief Number of staged records not committed yet
+*/
+size_t imu_frs_dirty_count();
+
+/**
+* @brief Drop one cached record (staged changes included), the next read goes to the bus
+*/
+void imu_frs_invalidate(BNO08xFrsID frs_id);
+
+/**
+* @brief Drop the whole cache, e.g. after the hub flash was erased or replaced
+*/
+void imu_frs_invalidate_all();
+
+imu_frs_cache_stats_t imu_frs_cache_get_stats();
+void imu_frs_cache_reset_stats();
+
 /** 
 * ===========================================
 *   SIGNIFICANT MOTION CONFIGURATION via FRS
@@ -287,9 +512,10 @@ bool imu_get_sig_motion_config(imu_sig_motion_config_t &config);
 /**
 * @brief Set significant motion detector configuration
 * @param config: struct containing new config values
+* @param commit: write and verify now, false only stages it for the next imu_frs_commit()
 * @return true on success
 */
-bool imu_set_sig_motion_config(const imu_sig_motion_config_t &config);
+bool imu_set_sig_motion_config(const imu_sig_motion_config_t &config, bool commit = true);
 
 /**
 * @brief Print significant motion config to serial in human-readable format
@@ -297,11 +523,600 @@ bool imu_set_sig_motion_config(const imu_sig_motion_config_t &config);
 */
 void imu_print_sig_motion_config(const imu_sig_motion_config_t &config);
 
+/** 
+* ===========================================
+*   TYPED FRS RECORDS (through the FRS cache)
+* ===========================================
+* Getters fail on an empty record (the hub then runs its built-in defaults),
+* except the system orientation where empty means identity. Setters take the
+* same commit flag as imu_set_sig_motion_config().
+*/
+
+/// @brief Stability detector configuration (FRS 0xED85)
+typedef struct {
+    float accel_threshold_ms2;  ///< acceleration below which the device counts as stable, Q24
+    uint32_t duration_us;       ///< time below the threshold before STABLE is reported
+} imu_stability_config_t;
+
+/// @brief Shake detector configuration (FRS 0x7D7D)
+typedef struct {
+    float accel_threshold_ms2;      ///< acceleration that counts as a shake direction change, Q24
+    uint32_t min_time_us;           ///< minimum time between direction changes
+    uint32_t max_time_us;           ///< maximum time between direction changes
+    uint32_t direction_changes;     ///< direction changes required for a shake
+    uint32_t enabled_axes;          ///< bit 0 X, bit 1 Y, bit 2 Z
+} imu_shake_config_t;
+
+/// @brief System orientation (FRS 0x2D3E), rotation from the sensor frame to the collar frame, Q30
+typedef struct {
+    float real, i, j, k;
+} imu_orientation_t;
+
+bool imu_get_stability_config(imu_stability_config_t &config);
+bool imu_set_stability_config(const imu_stability_config_t &config, bool commit = true);
+
+bool imu_get_shake_config(imu_shake_config_t &config);
+bool imu_set_shake_config(const imu_shake_config_t &config, bool commit = true);
+
+/**
+* @note Takes effect after the next hub reset
+*/
+bool imu_get_system_orientation(imu_orientation_t &orientation);
+bool imu_set_system_orientation(const imu_orientation_t &orientation, bool commit = true);
+
+/**
+* @brief Maximum fusion period (FRS 0xD7D7), caps how slowly the fusion filter may run
+*/
+bool imu_get_max_fusion_period(uint32_t &period_us);
+bool imu_set_max_fusion_period(uint32_t period_us, bool commit = true);
+
+
+/** 
+* ===========================================
+*   DYNAMIC CALIBRATION PERSISTENCE (DCD)
+* ===========================================
+* Once the rotation vector reaches HIGH accuracy the hub saves its DCD and the
+* driver keeps a CRC protected copy in NVS. imu_init() writes that copy back to
+* the DCD FRS record (0x1F1F) when the hub's own record is missing or differs,
+* so a cold boot starts calibrated instead of converging for minutes.
+*/
+
+#ifndef IMU_CAL_MAX_AGE_BOOTS
+#define IMU_CAL_MAX_AGE_BOOTS 100          ///< snapshots older than this are discarded, magnetic surroundings drift
+#endif
+
+#ifndef IMU_CAL_SAVE_INTERVAL_MS
+#define IMU_CAL_SAVE_INTERVAL_MS 600000UL  ///< minimum spacing of snapshots, NVS and hub flash wear
+#endif
+
+typedef enum imu_cal_restore_t : uint8_t {
+    IMU_CAL_RESTORE_NONE,       ///< no snapshot stored
+    IMU_CAL_RESTORE_WRITTEN,    ///< snapshot written to the DCD record, hub reset to load it
+    IMU_CAL_RESTORE_CURRENT,    ///< hub record already matches the snapshot, nothing sent
+    IMU_CAL_RESTORE_STALE,      ///< snapshot older than IMU_CAL_MAX_AGE_BOOTS, erased
+    IMU_CAL_RESTORE_CORRUPT,    ///< bad magic, version, length or CRC, erased
+    IMU_CAL_RESTORE_FAILED,     ///< NVS or FRS access failed
+} imu_cal_restore_t;
+
+/**
+ * @brief Calibration persistence counters
+ * @param restore: what imu_init() did with the stored snapshot
+ * @param snapshot_age_boots: boots since the restored snapshot was taken
+ * @param boot: boot count of this run, kept in NVS
+ * @param saves: snapshots written this boot
+ * @param boot_to_high_us: imu_init() to the first HIGH accuracy rotation vector, -1 until seen
+ */
+typedef struct imu_cal_stats_t {
+    imu_cal_restore_t restore;
+    uint32_t snapshot_age_boots;
+    uint32_t boot;
+    uint32_t saves;
+    int64_t boot_to_high_us;
+} imu_cal_stats_t;
+
+/**
+* @brief Restore the stored DCD snapshot, called by imu_init()
+* @return what was done, see imu_cal_restore_t
+* @note Resets the hub when the DCD record is rewritten, call before enabling reports
+*/
+imu_cal_restore_t imu_cal_restore();
+
+/**
+* @brief Save the hub DCD and snapshot it to NVS now, regardless of accuracy
+* @return true if the snapshot is stored (unchanged snapshots are not rewritten)
+*/
+bool imu_cal_save();
+
+/**
+* @brief Snapshot the DCD if the rotation vector is at HIGH accuracy and the last save is old enough
+* @return true if a snapshot was taken
+* @note Cheap when nothing is due, call it periodically from a task (never from a report callback)
+*/
+bool imu_cal_save_if_converged();
+
+/**
+* @brief Erase the NVS snapshot, the hub keeps its own record
+*/
+bool imu_cal_erase();
+
+imu_cal_stats_t imu_cal_get_stats();
+
+
+
+/** 
+* ===========================================
+*   SAMPLE RING (callback -> processing task)
+* ===========================================
+*/
+
+/**
+* @brief Register the driver callback that copies every enabled report into the sample ring
+* @return true once the callback is registered, repeated calls are no-ops
+* @note The callback only copies and pushes, all formatting happens on the consumer side
+*/
+bool imu_sample_ring_start();
+
+/**
+* @brief Drain queued samples in FIFO order, call from a single consumer task only
+* @param out: destination array
+* @param max: capacity of out
+* @return number of samples copied
+*/
+size_t imu_sample_ring_drain(imu_sample_t *out, size_t max);
+
+/**
+* @brief Block until samples arrive, then drain the whole burst (a hub FIFO flush) in one call
+* @param out: destination array, size it for a full flush
+* @param max: capacity of out
+* @param ticks_to_wait: FreeRTOS ticks to wait for the first sample, portMAX_DELAY to wait forever
+* @return number of samples copied, 0 on timeout
+* @note The burst ends once no sample arrived for IMU_BURST_GAP_MS, same single consumer rule as imu_sample_ring_drain()
+*/
+size_t imu_sample_ring_drain_burst(imu_sample_t *out, size_t max, TickType_t ticks_to_wait = portMAX_DELAY);
+
+/**
+* @brief Get the ring counters (pushed, popped, overflows, high water mark)
+* @return ring stats struct
+*/
+imu_ring_stats_t imu_sample_ring_get_stats();
+
+/**
+* @brief Zero the ring counters, call from the consumer task
+*/
+void imu_sample_ring_reset_stats();
+
+
+
+/** 
+* ===========================================
+*   COMPACT SAMPLES (native Q point int16)
+* ===========================================
+* imu_compact_sample_t keeps a sample as the hub produced it, 12 bytes instead
+* of 24, see imu_compact.hpp for the layout. Pack where samples are stored or
+* sent, unpack (or use the imu_compact.hpp batch converters) where they are
+* consumed. With IMU_SAMPLE_RING_COMPACT=1 the sample ring itself stores
+* compact records; both drain calls work either way.
+*/
+
+/**
+* @brief Pack a sample in its native Q point form
+* @param in: sample from the ring or the latest-value cache
+* @param out: compact record
+* @note Lossless except for rotation vectors, whose real part is recomputed from i, j, k on unpack
+*/
+void imu_compact_pack(const imu_sample_t &in, imu_compact_sample_t &out);
+
+/**
+* @brief Expand a compact record back into a full sample
+*/
+void imu_compact_unpack(const imu_compact_sample_t &in, imu_sample_t &out);
+
+/**
+* @brief Expand a run of compact records, mixed reports allowed
+* @param in: compact records
+* @param n: number of records
+* @param out: n samples
+*/
+void imu_compact_unpack_batch(const imu_compact_sample_t *in, size_t n, imu_sample_t *out);
+
+/**
+* @brief imu_sample_ring_drain() into compact records, for buffers and logs that keep the native form
+* @param out: destination array
+* @param max: capacity of out
+* @return number of records copied
+*/
+size_t imu_sample_ring_drain_compact(imu_compact_sample_t *out, size_t max);
+
+
+
+/** 
+* ===========================================
+*   LATEST-VALUE CACHE (any number of readers)
+* ===========================================
+*/
+
+/**
+* @brief Register the ingestion callback that keeps the latest sample of every report
+* @return true once started, repeated calls are no-ops
+* @note imu_sample_ring_start() shares the same callback, either call starts the cache
+*/
+bool imu_latest_start();
+
+/**
+* @brief Copy the latest sample of a report without locks, callable from any task
+* @param report_id: the ID of the report
+* @param out: filled with the latest sample, untouched contents if the sequence is 0
+* @return sequence of the sample (one per sample received), 0 if none yet or the ID is invalid
+*/
+uint32_t imu_latest_read(uint8_t report_id, imu_sample_t &out);
+
+/**
+* @brief Copy the latest sample only if it is newer than last_seq, a non-destructive has_new_data()
+* @param report_id: the ID of the report
+* @param out: filled with the new sample
+* @param last_seq: caller's cursor, start at 0, advanced on success
+* @return true if a sample newer than last_seq was copied
+* @note Samples in between are not queued, use the sample ring when every sample matters
+*/
+bool imu_latest_read_new(uint8_t report_id, imu_sample_t &out, uint32_t &last_seq);
+
+/**
+* @brief Get the sequence of the latest sample of a report without copying it
+* @return sequence, 0 if none yet or the ID is invalid
+*/
+uint32_t imu_latest_seq(uint8_t report_id);
+
+
+
+/** 
+* ===========================================
+*   SUBSCRIPTIONS (fan-out from the callback)
+* ===========================================
+* Any number of components (logger, classifier, power manager, uploader) up
+* to IMU_MAX_SUBSCRIBERS subscribe to the reports they need, each with its
+* own decimation and filter. The ingestion callback hands every sample to
+* the subscribers of its report through a per-report fan-out table rebuilt
+* on subscribe / unsubscribe, nothing is allocated or searched per sample.
+* Subscriptions belong to the driver, not to the library's report objects:
+* they persist across enable / disable, imu_rearm_sig_motion() and resets.
+*/
+
+#ifndef IMU_MAX_SUBSCRIBERS
+#define IMU_MAX_SUBSCRIBERS 8          ///< subscription slots, each costs a decimation counter per report
+#endif
+
+/// @brief Subscriber callback, runs in the driver callback context: copy or post, do not block
+typedef void (*imu_sub_fn_t)(const imu_sample_t &sample, void *arg);
+
+/// @brief Subscriber filter, false drops the sample for this subscriber only
+typedef bool (*imu_sub_filter_t)(const imu_sample_t &sample, void *arg);
+
+/**
+* @brief One subscription
+* @param report_mask: OR of IMU_RPT_BIT(report_id) for every report wanted
+* @param fn: callback for each delivered sample
+* @param arg: passed to fn and filter
+* @param decimation: deliver every Nth sample of each report, counted before the filter, 0 and 1 deliver all
+* @param filter: optional, applied to the samples decimation keeps
+*/
+typedef struct imu_sub_cfg_t {
+    uint64_t report_mask = 0;
+    imu_sub_fn_t fn = nullptr;
+    void *arg = nullptr;
+    uint16_t decimation = 1;
+    imu_sub_filter_t filter = nullptr;
+} imu_sub_cfg_t;
+
+/**
+* @brief Counters of one subscription, since it was made
+* @param delivered: calls to fn
+* @param decimated: samples skipped by decimation
+* @param filtered: samples the filter dropped
+*/
+typedef struct imu_sub_stats_t {
+    uint32_t delivered;
+    uint32_t decimated;
+    uint32_t filtered;
+} imu_sub_stats_t;
+
+/**
+* @brief Subscribe to reports, starts the ingestion callback if needed
+* @param cfg: subscription, copied
+* @return handle for imu_unsubscribe(), -1 if fn is null, the mask holds no valid report or all slots are taken
+* @note Not callable from a subscriber callback, the fan-out table swap waits for the dispatch in flight
+*/
+int imu_subscribe(const imu_sub_cfg_t &cfg);
+
+/**
+* @brief Remove a subscription, once this returns fn is not running and will not be called again
+* @param handle: from imu_subscribe()
+* @return false if the handle is not subscribed
+*/
+bool imu_unsubscribe(int handle);
+
+/**
+* @brief Get the counters of a subscription
+* @return false if the handle is not subscribed
+*/
+bool imu_sub_get_stats(int handle, imu_sub_stats_t &out);
+
+/// @brief Number of live subscriptions
+size_t imu_sub_count();
+
+
+
+/** 
+* ===========================================
+*   CLOCK SYNC (hub -> esp_timer time)
+* ===========================================
+* Raw reports carry the hub's microsecond timestamp. The ingestion callback
+* pairs it with the esp_timer time it runs at: arrival minus hub time is the
+* clock offset plus a delivery delay that is never negative, so the minimum of
+* each IMU_CLOCK_WINDOW_MS window (the delivery closest to the HINT edge)
+* tracks the offset and a line through the last IMU_CLOCK_WINDOWS minima gives
+* the drift. The minima still scatter by tens of microseconds, so the drift is
+* only good to a few ppm once the line spans most of the IMU_CLOCK_WINDOWS
+* windows; over the first seconds expect tens of ppm. The offset is tracked
+* every window either way. Every sample in the ring and the latest cache is
+* then stamped:
+*   - raw reports: hub timestamp mapped onto the esp_timer clock
+*   - other unbatched reports: arrival minus the typical delivery delay seen on raw reports
+*   - other batched reports: arrival time, the hub FIFO hides their measurement time
+* Enable any raw report (a slow one is enough) to get the mapping, without one
+* every sample keeps its arrival time.
+*/
+
+#ifndef IMU_CLOCK_WINDOW_MS
+#define IMU_CLOCK_WINDOW_MS 500        ///< envelope window, one offset point per window
+#endif
+
+#ifndef IMU_CLOCK_WINDOWS
+#define IMU_CLOCK_WINDOWS 32           ///< window minima the drift line is fitted through, 16 s of baseline
+#endif
+
+#define IMU_CLOCK_RESYNC_US 20000UL    ///< a hub time step larger than this (hub reset) restarts the estimate
+
+/**
+* @brief Clock sync state
+* @param locked: true once a full window was seen, before that the offset follows the running minimum
+* @param offset_us: esp_timer time minus hub time at the latest reference point
+* @param drift_ppm: hub clock rate error against esp_timer, positive when the hub runs fast, 0 until two windows
+* @param delay_us: typical delivery delay above the envelope, subtracted from non raw arrivals
+* @param samples: raw samples fed since the last restart
+* @param windows: windows closed since the last restart
+* @param resyncs: restarts after a hub reset or a hub time step
+*/
+typedef struct imu_clock_stats_t {
+    bool locked;
+    int32_t offset_us;
+    float drift_ppm;
+    uint32_t delay_us;
+    uint32_t samples;
+    uint32_t windows;
+    uint32_t resyncs;
+} imu_clock_stats_t;
+
+/**
+* @brief Map a hub timestamp (raw report timestamp_us) onto the esp_timer clock
+* @param hub_us: hub time
+* @param host_us: low 32 bits of the matching esp_timer time
+* @return false until the callback has seen a raw report
+*/
+bool imu_clock_hub_to_host(uint32_t hub_us, uint32_t &host_us);
+
+imu_clock_stats_t imu_clock_get_stats();
+
+/**
+* @brief Drop the estimate, the callback restarts it on the next raw sample
+* @note imu_hard_reset() and imu_soft_reset() call this, the hub clock restarts with the hub
+*/
+void imu_clock_reset();
+
+
+
+/** 
+* ===========================================
+*   REPORT METRICS (ingestion callback)
+* ===========================================
+* Compiled out with IMU_METRICS_ENABLED=0: the callback records nothing and the
+* calls below return false / 0.
+*/
+
+#define IMU_METRICS_SNAPSHOT_MAX (20 + (SH2_MAX_SENSOR_ID + 1) * (4 + sizeof(imu_rpt_metrics_t)))
+
+/**
+* @brief Copy the metrics of one report, lock free, callable from any task
+* @param report_id: the ID of the report
+* @param out: filled with the counters since the last reset
+* @return false if metrics are compiled out or the ID is invalid
+* @note Needs the ingestion callback, started by imu_latest_start() or imu_sample_ring_start()
+*/
+bool imu_metrics_get(uint8_t report_id, imu_rpt_metrics_t &out);
+
+/**
+* @brief Zero every report's metrics, applied by the callback on each report's next sample
+*/
+void imu_metrics_reset();
+
+/**
+* @brief Write the binary snapshot described in imu_metrics.hpp, reports with no samples are skipped
+* @param out: destination buffer, IMU_METRICS_SNAPSHOT_MAX bytes always fit
+* @param out_sz: capacity of out
+* @return bytes written, 0 if compiled out or out is too small
+*/
+size_t imu_metrics_snapshot(uint8_t *out, size_t out_sz);
+
+/**
+* @brief Log one line per active report: rate, jitter, gaps and callback duration
+*/
+void imu_metrics_print();
+
+/**
+* @brief Cycles spent in the ingestion callback over every report, the ingestion core's CPU budget
+* @return running total, wraps (every ~18 s of callback time at 240 MHz): take differences
+*/
+uint32_t imu_metrics_cb_cycles();
+
+
+
+/** 
+* ===========================================
+*   MOTION EVENTS
+* ===========================================
+*/
+
+/// @brief Event bits posted by the driver callback, OR them together to wait on several
+typedef enum imu_event_t : uint32_t {
+    IMU_EVT_SIG_MOTION       = (1UL << 0),  ///< significant motion fired (one-shot, re-arm to catch the next)
+    IMU_EVT_SHAKE            = (1UL << 1),  ///< shake detector fired
+    IMU_EVT_STABILITY_CHANGE = (1UL << 2),  ///< stability classifier output changed value
+    IMU_EVT_SAMPLES          = (1UL << 3),  ///< sample ring went non-empty, only posted while imu_sample_ring_drain_burst() waits
+    IMU_EVT_HUB_RESET        = (1UL << 4),  ///< the hub reset, call imu_recover() to replay the configuration
+} imu_event_t;
+
+/// @brief Motion events only, IMU_EVT_SAMPLES belongs to imu_sample_ring_drain_burst()
+#define IMU_EVT_ALL (IMU_EVT_SIG_MOTION | IMU_EVT_SHAKE | IMU_EVT_STABILITY_CHANGE)
+
+/**
+* @brief Latency from the driver callback posting an event to the waiting task running
+* @param wakes: motion events a blocking wait returned, each timed from its own first post
+* @param last_us: latency of the most recent wake
+* @param max_us: worst latency seen
+* @param total_us: sum of all latencies, divide by wakes for the mean
+*/
+typedef struct imu_wake_stats_t {
+    uint32_t wakes;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} imu_wake_stats_t;
+
+/**
+* @brief Create the event word and subscribe the callback that posts sig motion / shake / stability events
+* @return true once started, repeated calls are no-ops
+* @note Takes one subscription slot, which like every subscription survives imu_rearm_sig_motion() and resets
+*/
+bool imu_events_start();
+
+/**
+* @brief Block until any of the requested events is posted
+* @param events: OR of imu_event_t bits to wait for
+* @param ticks_to_wait: FreeRTOS ticks to block, portMAX_DELAY to wait forever
+* @return the requested bits that were set (and are now cleared), 0 on timeout
+* @note Only the returned motion events count in imu_get_wake_stats(), a poll (0 ticks) counts none
+*/
+uint32_t imu_wait_events(uint32_t events, TickType_t ticks_to_wait = portMAX_DELAY);
+
+/**
+* @brief Get the event-to-task wake latency counters
+* @return wake stats struct
+* @note Measured from the driver callback, the HINT ISR itself belongs to esp32_BNO08x
+*/
+imu_wake_stats_t imu_get_wake_stats();
+
+void imu_reset_wake_stats();
+
+
+
+/** 
+* ===========================================
+*   FAULT RECOVERY
+* ===========================================
+* The driver keeps the configuration the application asked for, not only
+* what the hub is running: a mask of wanted reports, each report's period and
+* sensor config, and the runtime settings the hub keeps in RAM (dynamic
+* calibration sensors). FRS records live in hub flash and survive a reset.
+*
+* Every hub reset reaches the driver through the library's SH2_RESET event,
+* raised by the SHTP reset message, including the ones nobody asked for (hub
+* watchdog, brown-out, ESD). The event marks every report off and posts
+* IMU_EVT_HUB_RESET; imu_recover() then replays the snapshot from task
+* context. After a reset the hub runs nothing, so a replay is one set-feature
+* per wanted report plus a calibration command only where the wanted sensors
+* differ from the hub default, never a disable. Several resets before one
+* replay cost one replay.
+*
+* A reset whose message is lost, or a library release without the reset
+* callback, leaves only silence: imu_hub_check() treats continuous reports
+* going quiet for IMU_HUB_SILENT_MS as a reset.
+*/
+
+#ifndef IMU_HUB_BOOT_MAX_MS
+#define IMU_HUB_BOOT_MAX_MS 500        ///< longest a reset keeps the hub silent before its reset message
+#endif
+
+#ifndef IMU_HUB_SILENT_MS
+#define IMU_HUB_SILENT_MS 1000         ///< continuous reports silent this long count as a reset, see imu_hub_check()
+#endif
+
+#ifndef IMU_HUB_SILENT_PERIODS
+#define IMU_HUB_SILENT_PERIODS 4       ///< and at least this many periods of the slowest continuous report
+#endif
+
+/**
+* @brief Recovery counters
+* @param resets: hub resets seen, requested or not
+* @param unexpected: resets not requested through imu_hard_reset() / imu_soft_reset()
+* @param silent: of those, resets imu_hub_check() found by the silence, without a reset message
+* @param replays: snapshot replays
+* @param commands: commands the replays sent
+* @param failed: commands the hub rejected, imu_recover() retries them
+* @param last_us: reset message to snapshot replayed, last replay
+* @param max_us: worst replay
+* @param last_lost: samples the last reset cost, see imu_recover()
+* @param lost: total over every reset
+*/
+typedef struct imu_recovery_stats_t {
+    uint32_t resets;
+    uint32_t unexpected;
+    uint32_t silent;
+    uint32_t replays;
+    uint32_t commands;
+    uint32_t failed;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint32_t last_lost;
+    uint64_t lost;
+} imu_recovery_stats_t;
+
+/**
+* @brief Replay the desired configuration if the hub reset since the last replay
+* @return true if a replay ran
+* @note Call from a task waiting on IMU_EVT_HUB_RESET, it sends commands and must not run in a callback.
+*       Samples lost are estimated per wanted continuous report, from its last sample before the reset
+*       (at most IMU_HUB_BOOT_MAX_MS before the reset message) to the end of the replay, at its period.
+*/
+bool imu_recover();
+
+/**
+* @brief Treat the hub as reset if every unbatched continuous report it should run went silent
+* @return true if it did: IMU_EVT_HUB_RESET is posted, imu_recover() replays as after a reset message
+* @note Call every IMU_HUB_SILENT_MS from the task that runs imu_recover(), pm_task does
+*/
+bool imu_hub_check();
+
+/**
+* @brief Get the reports the driver holds the hub to, enabled or waiting for a replay
+* @return mask of IMU_RPT_BIT(report_id)
+*/
+uint64_t imu_get_desired_rpts();
+
+imu_recovery_stats_t imu_recovery_get_stats();
+
+void imu_recovery_reset_stats();
+
 
 
 //TESTING FUNCTIONS
 
-void motion_detection_task(void *pvParameters);
+/**
+ * @brief data_processing_task parameters, pass a pointer that outlives the task as pvParameters (or nullptr)
+ * @param on_batch: called with every batch drained from the sample ring, after logging; may be nullptr
+ */
+typedef struct imu_processing_cfg_t {
+    void (*on_batch)(const imu_sample_t *samples, size_t count) = nullptr;
+} imu_processing_cfg_t;
+
 void data_processing_task(void *pvParameters);
 
 
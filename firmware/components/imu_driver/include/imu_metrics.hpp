@@ -0,0 +1,183 @@
+// imu_metrics.hpp
+#ifndef IMU_METRICS_H
+#define IMU_METRICS_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Per-report hot path metrics, written only by the ingestion callback. Every
+ * counter is a relaxed atomic word updated with a plain load/store pair (one
+ * writer), so readers on other tasks copy them without locks. Jitter and the
+ * average interval are EWMAs in us x16 (1/16 weight), no 64 bit math on
+ * the write side.
+ *
+ * Build with IMU_METRICS_ENABLED=0 to compile every recording site out.
+ *
+ * Binary snapshot (imu_metrics_snapshot, little endian):
+ *   header: "IMM1" magic, uint16 version (1), uint8 buckets, uint8 hist_shift,
+ *           uint32 cpu ticks per us, uint32 timestamp_us, uint16 reports, uint16 record bytes
+ *   record: uint8 report_id, 3 x uint8 reserved, then imu_rpt_metrics_t as 32 bit words
+ */
+
+#ifndef IMU_METRICS_ENABLED
+#define IMU_METRICS_ENABLED 1
+#endif
+
+#define IMU_METRICS_HIST_BUCKETS 12   ///< callback duration histogram buckets
+#define IMU_METRICS_HIST_SHIFT 8      ///< bucket 0 is < 2^8 cycles (~1 us at 240 MHz), each next one doubles
+
+#ifndef IMU_METRICS_GAP_PCT
+#define IMU_METRICS_GAP_PCT 150       ///< an interval over this % of the requested period counts as a gap
+#endif
+
+#define IMU_METRICS_MAGIC 0x314D4D49UL   ///< "IMM1"
+#define IMU_METRICS_VERSION 1
+
+/**
+ * @brief Metrics of one report since the last reset
+ * @param received: samples seen by the ingestion callback
+ * @param gaps: intervals longer than IMU_METRICS_GAP_PCT of the requested period (continuous, unbatched reports)
+ * @param missed: samples estimated lost inside those gaps
+ * @param interval_min_us: shortest inter-sample interval
+ * @param interval_max_us: longest inter-sample interval
+ * @param interval_avg_q4: EWMA of the interval, us x16
+ * @param jitter_q4: EWMA of |interval - average|, us x16
+ * @param cb_max_cycles: longest ingestion callback run
+ * @param cb_hist: ingestion callback durations, bucket b holds runs below 2^(b + IMU_METRICS_HIST_SHIFT) cycles,
+ *                 the last bucket everything longer
+ */
+typedef struct imu_rpt_metrics_t {
+    uint32_t received;
+    uint32_t gaps;
+    uint32_t missed;
+    uint32_t interval_min_us;
+    uint32_t interval_max_us;
+    uint32_t interval_avg_q4;
+    uint32_t jitter_q4;
+    uint32_t cb_max_cycles;
+    uint32_t cb_hist[IMU_METRICS_HIST_BUCKETS];
+} imu_rpt_metrics_t;
+
+/// @brief Effective rate from the average interval, 0 until two samples were seen
+inline float imu_metrics_rate_hz(const imu_rpt_metrics_t &m) {
+    return (m.interval_avg_q4 != 0) ? 16000000.0f / static_cast<float>(m.interval_avg_q4) : 0.0f;
+}
+
+inline float imu_metrics_jitter_us(const imu_rpt_metrics_t &m) {
+    return static_cast<float>(m.jitter_q4) / 16.0f;
+}
+
+/// @brief Exclusive upper bound of a histogram bucket in cycles, 0 for the open ended last bucket
+inline uint32_t imu_metrics_bucket_limit_cycles(uint32_t bucket) {
+    return (bucket + 1 < IMU_METRICS_HIST_BUCKETS) ? (1UL << (bucket + IMU_METRICS_HIST_SHIFT)) : 0;
+}
+
+/**
+ * Writer side of one report's metrics. on_sample() and on_callback() run in
+ * the ingestion callback only; read() and request_reset() from any task. A
+ * reset is applied by the writer on its next sample so it never races a
+ * half finished update.
+ */
+class imu_rpt_metrics_slot
+{
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "metrics words must be lock free");
+
+    public:
+        /**
+        * @param t_us: arrival time of the sample
+        * @param period_us: requested period, 0 disables gap detection (event or batched reports)
+        */
+        void on_sample(uint32_t t_us, uint32_t period_us) {
+            if (reset_pending.load(std::memory_order_relaxed)) {
+                clear();
+                reset_pending.store(false, std::memory_order_relaxed);
+            }
+
+            const uint32_t received = m[RECEIVED].load(std::memory_order_relaxed);
+            m[RECEIVED].store(received + 1, std::memory_order_relaxed);
+
+            if (received != 0) {
+                const uint32_t interval = std::min<uint32_t>(t_us - last_us, MAX_INTERVAL_US);
+                on_interval(interval, period_us, received == 1);
+            }
+            last_us = t_us;
+        }
+
+        void on_callback(uint32_t cycles) {
+            const uint32_t bucket = std::min<uint32_t>(std::bit_width(cycles >> IMU_METRICS_HIST_SHIFT),
+                                                       IMU_METRICS_HIST_BUCKETS - 1);
+            bump(HIST + bucket);
+            if (cycles > m[CB_MAX].load(std::memory_order_relaxed)) {
+                m[CB_MAX].store(cycles, std::memory_order_relaxed);
+            }
+        }
+
+        void read(imu_rpt_metrics_t &out) const {
+            uint32_t words[WORDS];
+            const bool cleared = reset_pending.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < WORDS; i++) {
+                words[i] = cleared ? 0 : m[i].load(std::memory_order_relaxed);
+            }
+            std::memcpy(&out, words, sizeof(out));
+        }
+
+        void request_reset() {
+            reset_pending.store(true, std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr size_t WORDS = sizeof(imu_rpt_metrics_t) / sizeof(uint32_t);
+        static constexpr uint32_t MAX_INTERVAL_US = 1UL << 26;   // keeps interval x16 inside int32
+
+        enum : size_t {
+            RECEIVED, GAPS, MISSED, INTERVAL_MIN, INTERVAL_MAX, INTERVAL_AVG, JITTER, CB_MAX, HIST,
+        };
+        static_assert(HIST + IMU_METRICS_HIST_BUCKETS == WORDS, "word map must follow imu_rpt_metrics_t");
+
+        void bump(size_t word) {
+            m[word].store(m[word].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        void on_interval(uint32_t interval, uint32_t period_us, bool first) {
+            if (first || interval < m[INTERVAL_MIN].load(std::memory_order_relaxed)) {
+                m[INTERVAL_MIN].store(interval, std::memory_order_relaxed);
+            }
+            if (interval > m[INTERVAL_MAX].load(std::memory_order_relaxed)) {
+                m[INTERVAL_MAX].store(interval, std::memory_order_relaxed);
+            }
+
+            const int32_t sample_q4 = static_cast<int32_t>(interval << 4);
+            int32_t avg_q4 = static_cast<int32_t>(m[INTERVAL_AVG].load(std::memory_order_relaxed));
+            int32_t jitter_q4 = static_cast<int32_t>(m[JITTER].load(std::memory_order_relaxed));
+            if (first) {
+                avg_q4 = sample_q4;
+            }
+            const int32_t deviation_q4 = (sample_q4 > avg_q4) ? sample_q4 - avg_q4 : avg_q4 - sample_q4;
+            avg_q4 += (sample_q4 - avg_q4) >> 4;
+            jitter_q4 += (deviation_q4 - jitter_q4) >> 4;
+            m[INTERVAL_AVG].store(static_cast<uint32_t>(avg_q4), std::memory_order_relaxed);
+            m[JITTER].store(static_cast<uint32_t>(jitter_q4), std::memory_order_relaxed);
+
+            if (period_us != 0 && interval > period_us / 100 * IMU_METRICS_GAP_PCT) {
+                bump(GAPS);
+                const uint32_t lost = (interval + period_us / 2) / period_us - 1;
+                m[MISSED].store(m[MISSED].load(std::memory_order_relaxed) + lost, std::memory_order_relaxed);
+            }
+        }
+
+        void clear() {
+            for (size_t i = 0; i < WORDS; i++) {
+                m[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        std::atomic<uint32_t> m[WORDS] = {};
+        std::atomic<bool> reset_pending{false};
+        uint32_t last_us = 0;
+};
+
+#endif /* IMU_METRICS_H */
@@ -0,0 +1,125 @@
+// imu_report_types.hpp
+#ifndef IMU_REPORT_TYPES_H
+#define IMU_REPORT_TYPES_H
+
+#include <cstdint>
+#include "BNO08xGlobalTypes.hpp"
+
+/**
+ * Compile-time description of every report imu_driver exposes: the data struct
+ * imu_get<ID>() returns, the capability flags stored in the report registry,
+ * the sample member it fills and the Q point of its native output.
+ */
+
+/// @brief Capability flags of a report, see imu_get_rpt_caps()
+enum imu_rpt_cap_t : uint8_t {
+    IMU_RPT_CAP_NONE        = 0,
+    IMU_RPT_CAP_TIMESTAMP   = (1U << 0),  ///< sample carries a sensor hub timestamp (raw reports only)
+    IMU_RPT_CAP_CONTINUOUS  = (1U << 1),  ///< produces a sample every period
+    IMU_RPT_CAP_EVENT       = (1U << 2),  ///< produces a sample on change only (classifiers, detectors)
+    IMU_RPT_CAP_ONE_SHOT    = (1U << 3),  ///< disables itself after firing, must be re-armed
+    IMU_RPT_CAP_BATCHABLE   = (1U << 4),  ///< can be queued in the hub FIFO with a batch interval
+};
+
+/// @brief imu_sample_t data member a report fills
+enum imu_sample_kind_t : uint8_t {
+    IMU_SAMPLE_VEC,        ///< data.vec: accel, gyro, magf (raw reports as counts)
+    IMU_SAMPLE_QUAT,       ///< data.quat: rotation vectors
+    IMU_SAMPLE_ACTIVITY,   ///< data.activity: personal activity classifier
+    IMU_SAMPLE_VALUE,      ///< data.value: stability, shake, steps, sig motion
+};
+
+constexpr imu_sample_kind_t imu_sample_kind(uint8_t report_id) {
+    switch (report_id) {
+        case SH2_RAW_ACCELEROMETER:
+        case SH2_ACCELEROMETER:
+        case SH2_LINEAR_ACCELERATION:
+        case SH2_GRAVITY:
+        case SH2_RAW_GYROSCOPE:
+        case SH2_GYROSCOPE_CALIBRATED:
+        case SH2_GYROSCOPE_UNCALIBRATED:
+        case SH2_RAW_MAGNETOMETER:
+        case SH2_MAGNETIC_FIELD_CALIBRATED:
+        case SH2_MAGNETIC_FIELD_UNCALIBRATED:
+            return IMU_SAMPLE_VEC;
+
+        case SH2_ROTATION_VECTOR:
+        case SH2_GAME_ROTATION_VECTOR:
+        case SH2_ARVR_STABILIZED_RV:
+        case SH2_ARVR_STABILIZED_GRV:
+        case SH2_GYRO_INTEGRATED_RV:
+        case SH2_GEOMAGNETIC_ROTATION_VECTOR:
+            return IMU_SAMPLE_QUAT;
+
+        case SH2_PERSONAL_ACTIVITY_CLASSIFIER:
+            return IMU_SAMPLE_ACTIVITY;
+
+        default:
+            return IMU_SAMPLE_VALUE;
+    }
+}
+
+/**
+ * @brief Q point of the hub's int16 output for a report (SH-2 reference manual), 0 for raw counts and integers
+ * @note The library scales by the same Q points, so float -> Q -> float round trips exactly
+ */
+constexpr uint8_t imu_report_q_point(uint8_t report_id) {
+    switch (report_id) {
+        case SH2_ACCELEROMETER:
+        case SH2_LINEAR_ACCELERATION:
+        case SH2_GRAVITY:
+            return 8;
+
+        case SH2_GYROSCOPE_CALIBRATED:
+        case SH2_GYROSCOPE_UNCALIBRATED:
+            return 9;
+
+        case SH2_MAGNETIC_FIELD_CALIBRATED:
+        case SH2_MAGNETIC_FIELD_UNCALIBRATED:
+            return 4;
+
+        case SH2_ROTATION_VECTOR:
+        case SH2_GAME_ROTATION_VECTOR:
+        case SH2_ARVR_STABILIZED_RV:
+        case SH2_ARVR_STABILIZED_GRV:
+        case SH2_GYRO_INTEGRATED_RV:
+        case SH2_GEOMAGNETIC_ROTATION_VECTOR:
+            return 14;
+
+        default:
+            return 0;
+    }
+}
+
+template <uint8_t ID> struct imu_report_traits;
+
+#define IMU_REPORT_TRAITS(id, data_t)                    \
+    template <> struct imu_report_traits<id> {           \
+        using type = data_t;                             \
+    }
+
+IMU_REPORT_TRAITS(SH2_RAW_ACCELEROMETER, bno08x_raw_accel_t);
+IMU_REPORT_TRAITS(SH2_ACCELEROMETER, bno08x_accel_t);
+IMU_REPORT_TRAITS(SH2_LINEAR_ACCELERATION, bno08x_accel_t);
+IMU_REPORT_TRAITS(SH2_GRAVITY, bno08x_accel_t);
+IMU_REPORT_TRAITS(SH2_RAW_GYROSCOPE, bno08x_raw_gyro_t);
+IMU_REPORT_TRAITS(SH2_GYROSCOPE_CALIBRATED, bno08x_gyro_t);
+IMU_REPORT_TRAITS(SH2_GYROSCOPE_UNCALIBRATED, bno08x_gyro_t);
+IMU_REPORT_TRAITS(SH2_RAW_MAGNETOMETER, bno08x_raw_magf_t);
+IMU_REPORT_TRAITS(SH2_MAGNETIC_FIELD_CALIBRATED, bno08x_magf_t);
+IMU_REPORT_TRAITS(SH2_MAGNETIC_FIELD_UNCALIBRATED, bno08x_magf_t);
+IMU_REPORT_TRAITS(SH2_ROTATION_VECTOR, bno08x_quat_t);
+IMU_REPORT_TRAITS(SH2_GAME_ROTATION_VECTOR, bno08x_quat_t);
+IMU_REPORT_TRAITS(SH2_ARVR_STABILIZED_RV, bno08x_quat_t);
+IMU_REPORT_TRAITS(SH2_ARVR_STABILIZED_GRV, bno08x_quat_t);
+IMU_REPORT_TRAITS(SH2_GYRO_INTEGRATED_RV, bno08x_quat_t);
+IMU_REPORT_TRAITS(SH2_GEOMAGNETIC_ROTATION_VECTOR, bno08x_quat_t);
+IMU_REPORT_TRAITS(SH2_PERSONAL_ACTIVITY_CLASSIFIER, bno08x_activity_classifier_t);
+IMU_REPORT_TRAITS(SH2_STABILITY_CLASSIFIER, bno08x_stability_classifier_t);
+IMU_REPORT_TRAITS(SH2_SHAKE_DETECTOR, bno08x_shake_detector_t);
+IMU_REPORT_TRAITS(SH2_STEP_COUNTER, bno08x_step_counter_t);
+IMU_REPORT_TRAITS(SH2_SIGNIFICANT_MOTION, bno08x_significant_motion_t);
+
+#undef IMU_REPORT_TRAITS
+
+#endif /* IMU_REPORT_TYPES_H */
@@ -0,0 +1,140 @@
+// imu_sample_ring.hpp
+#ifndef IMU_SAMPLE_RING_H
+#define IMU_SAMPLE_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Lock-free single-producer / single-consumer ring. The producer (driver callback)
+ * only touches head and its own counters, the consumer only touches tail, each on
+ * its own cache line so the two cores never bounce a line on the hot path.
+ */
+
+#ifdef CONFIG_ESP32S3_DATA_CACHE_LINE_SIZE
+#define IMU_CACHE_LINE_SIZE CONFIG_ESP32S3_DATA_CACHE_LINE_SIZE
+#else
+#define IMU_CACHE_LINE_SIZE 64
+#endif
+
+/**
+ * @brief Ring occupancy counters
+ * @param pushed: records accepted since the last reset
+ * @param popped: records handed to the consumer since the last reset
+ * @param overflows: records dropped because the ring was full
+ * @param high_water: highest occupancy seen, size against this
+ * @param capacity: number of slots
+ */
+typedef struct imu_ring_stats_t {
+    uint32_t pushed;
+    uint32_t popped;
+    uint32_t overflows;
+    uint32_t high_water;
+    uint32_t capacity;
+} imu_ring_stats_t;
+
+template <typename T, size_t N>
+class imu_spsc_ring
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "ring indices must be lock free");
+
+    public:
+        static constexpr size_t capacity = N;
+
+        /**
+        * @brief Append one record, producer side only
+        * @param item: record to copy in
+        * @return false if the ring was full, the record is dropped and counted as overflow
+        */
+        bool push(const T &item) {
+            const uint32_t head = head_idx.load(std::memory_order_relaxed);
+            const uint32_t tail = tail_idx.load(std::memory_order_acquire);
+            const uint32_t used = head - tail;
+
+            if (used >= N) {
+                overflow_cnt.store(overflow_cnt.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            slots[head & MASK] = item;
+            head_idx.store(head + 1, std::memory_order_release);
+
+            if (used + 1 > high_water.load(std::memory_order_relaxed)) {
+                high_water.store(used + 1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        /**
+        * @brief Move up to max records out in FIFO order, consumer side only
+        * @param out: destination array
+        * @param max: capacity of out
+        * @return number of records copied
+        */
+        size_t pop_batch(T *out, size_t max) {
+            const uint32_t tail = tail_idx.load(std::memory_order_relaxed);
+            const uint32_t head = head_idx.load(std::memory_order_acquire);
+            uint32_t avail = head - tail;
+            if (avail > max) {
+                avail = static_cast<uint32_t>(max);
+            }
+
+            for (uint32_t i = 0; i < avail; i++) {
+                out[i] = slots[(tail + i) & MASK];
+            }
+
+            tail_idx.store(tail + avail, std::memory_order_release);
+            popped_cnt += avail;
+            return avail;
+        }
+
+        /**
+        * @brief Number of records waiting, exact on the consumer side
+        */
+        size_t size() const {
+            return head_idx.load(std::memory_order_acquire) - tail_idx.load(std::memory_order_acquire);
+        }
+
+        bool empty() const { return size() == 0; }
+
+        imu_ring_stats_t get_stats() const {
+            imu_ring_stats_t stats;
+            stats.pushed = head_idx.load(std::memory_order_relaxed) - head_base;
+            stats.popped = popped_cnt - popped_base;
+            stats.overflows = overflow_cnt.load(std::memory_order_relaxed);
+            stats.high_water = high_water.load(std::memory_order_relaxed);
+            stats.capacity = N;
+            return stats;
+        }
+
+        /**
+        * @brief Zero the counters without touching queued records, consumer side only
+        * @note overflow and high water are producer owned, a concurrent push may be lost from them
+        */
+        void reset_stats() {
+            head_base = head_idx.load(std::memory_order_relaxed);
+            popped_base = popped_cnt;
+            overflow_cnt.store(0, std::memory_order_relaxed);
+            high_water.store(static_cast<uint32_t>(size()), std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr uint32_t MASK = N - 1;
+
+        // producer owned
+        alignas(IMU_CACHE_LINE_SIZE) std::atomic<uint32_t> head_idx{0};
+        std::atomic<uint32_t> overflow_cnt{0};
+        std::atomic<uint32_t> high_water{0};
+
+        // consumer owned
+        alignas(IMU_CACHE_LINE_SIZE) std::atomic<uint32_t> tail_idx{0};
+        uint32_t popped_cnt = 0;
+        uint32_t popped_base = 0;
+        uint32_t head_base = 0;
+
+        alignas(IMU_CACHE_LINE_SIZE) T slots[N];
+};
+
+#endif /* IMU_SAMPLE_RING_H */
@@ -0,0 +1,94 @@
+// imu_seqlock.hpp
+#ifndef IMU_SEQLOCK_H
+#define IMU_SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/**
+ * Single-writer seqlock holding the latest copy of a trivially copyable value.
+ * The writer never waits, readers retry if a write overlapped their copy. The
+ * payload lives in relaxed atomic words, so a torn read is detected rather
+ * than being a data race. A reader that keeps failing sleeps a tick between
+ * attempts: if it preempted the writer on the writer's own core, spinning
+ * would never let the write finish.
+ */
+
+template <typename T>
+class imu_seqlock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "seqlock payload must be trivially copyable");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "seqlock words must be lock free");
+
+    public:
+        /**
+        * @brief Publish a new value, writer side only
+        * @param value: value to copy in
+        */
+        void write(const T &value) {
+            uint32_t buf[WORDS] = {};
+            std::memcpy(buf, &value, sizeof(T));
+
+            const uint32_t seq = seq_num.load(std::memory_order_relaxed);
+            seq_num.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (size_t i = 0; i < WORDS; i++) {
+                words[i].store(buf[i], std::memory_order_relaxed);
+            }
+
+            seq_num.store(seq + 2, std::memory_order_release);
+        }
+
+        /**
+        * @brief Copy out the latest value, safe from any number of tasks
+        * @param out: filled with a consistent copy
+        * @return sequence of the copy, it grows by one per write, 0 if never written
+        * @note Task context only, after SPIN_RETRIES failed copies each retry waits a tick
+        */
+        uint32_t read(T &out) const {
+            uint32_t buf[WORDS];
+            uint32_t before;
+            uint32_t after;
+
+            for (uint32_t attempt = 0;; attempt++) {
+                before = seq_num.load(std::memory_order_acquire);
+                for (size_t i = 0; i < WORDS; i++) {
+                    buf[i] = words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = seq_num.load(std::memory_order_relaxed);
+                if (!(before & 1U) && before == after) {
+                    break;
+                }
+                // a write on another core ends within a few copies, a preempted one needs the CPU back
+                if (attempt >= SPIN_RETRIES) {
+                    vTaskDelay(1);
+                }
+            }
+
+            std::memcpy(&out, buf, sizeof(T));
+            return before >> 1;
+        }
+
+        /**
+        * @brief Sequence of the latest completed write without copying the value
+        */
+        uint32_t sequence() const {
+            return seq_num.load(std::memory_order_acquire) >> 1;
+        }
+
+    private:
+        static constexpr uint32_t SPIN_RETRIES = 4;    ///< back to back copies before a reader starts yielding
+        static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+        std::atomic<uint32_t> seq_num{0};
+        std::atomic<uint32_t> words[WORDS];
+};
+
+#endif /* IMU_SEQLOCK_H */
@@ -0,0 +1,468 @@
+#include <cmath>
+#include <cstring>
+
+#include "imu_dsp.hpp"
+
+// esp-dsp maps dsps_biquad_f32 to its PIE kernel on the ESP32-S3 (CONFIG_DSP_OPTIMIZED)
+#if __has_include("dsps_biquad.h")
+#include "dsps_biquad.h"
+#define IMU_DSP_ESP_DSP 1
+#else
+#define IMU_DSP_ESP_DSP 0
+#endif
+
+static_assert(sizeof(imu_dsp_biquad_t) == 5 * sizeof(float), "coefficients must match esp-dsp's coef[5]");
+
+static constexpr float PI = 3.14159265358979f;
+
+/**
+ * x, y, z of one sample and an unused lane as one 16 byte vector (GCC / Clang
+ * vector extension): SSE or NEON on the host, plain float code on Xtensa. The
+ * recursive filters run across the axes in it, time has no parallelism to give.
+ */
+typedef float lanes_t __attribute__((vector_size(16)));
+
+static inline lanes_t to_lanes(const float (&v)[IMU_DSP_AXES]) {
+    return lanes_t{v[0], v[1], v[2], 0.0f};
+}
+
+static inline void from_lanes(lanes_t l, float (&v)[IMU_DSP_AXES]) {
+    v[0] = l[0];
+    v[1] = l[1];
+    v[2] = l[2];
+}
+
+template <size_t N>
+static inline lanes_t load_lanes(const float (&x)[IMU_DSP_AXES][N], size_t i) {
+    return lanes_t{x[0][i], x[1][i], x[2][i], 0.0f};
+}
+
+template <size_t N>
+static inline void store_lanes(float (&x)[IMU_DSP_AXES][N], size_t i, lanes_t v) {
+    x[0][i] = v[0];
+    x[1][i] = v[1];
+    x[2][i] = v[2];
+}
+
+size_t imu_dsp_gather(const imu_sample_t *in, size_t count, uint8_t report_id, imu_dsp_block_t &block) {
+    size_t i = 0;
+    for (; i < count && block.n < IMU_DSP_BLOCK_LEN; i++) {
+        if (in[i].report_id != report_id) {
+            continue;
+        }
+        block.axis[0][block.n] = in[i].data.vec.x;
+        block.axis[1][block.n] = in[i].data.vec.y;
+        block.axis[2][block.n] = in[i].data.vec.z;
+        block.t_us[block.n] = in[i].timestamp_us;
+        block.n++;
+    }
+    return i;
+}
+
+// ============================================================
+// BIQUAD DESIGN
+// ============================================================
+
+/// @brief RBJ cookbook second order section, numerator b = {1 -+ cos, +-2 (1 -+ cos), 1 -+ cos} / 2
+static bool design_biquad(imu_dsp_biquad_t &coef, float fc_hz, float fs_hz, float q, bool highpass) {
+    if (!(fs_hz > 0.0f) || !(fc_hz > 0.0f) || !(fc_hz < 0.5f * fs_hz) || !(q > 0.0f)) {
+        return false;
+    }
+
+    const float w0 = 2.0f * PI * fc_hz / fs_hz;
+    const float cos_w0 = std::cos(w0);
+    const float alpha = std::sin(w0) / (2.0f * q);
+    const float a0 = 1.0f + alpha;
+    const float b = highpass ? (1.0f + cos_w0) / 2.0f : (1.0f - cos_w0) / 2.0f;
+
+    coef.b0 = b / a0;
+    coef.b1 = (highpass ? -2.0f * b : 2.0f * b) / a0;
+    coef.b2 = b / a0;
+    coef.a1 = -2.0f * cos_w0 / a0;
+    coef.a2 = (1.0f - alpha) / a0;
+    return true;
+}
+
+bool imu_dsp_lowpass(imu_dsp_biquad_t &coef, float fc_hz, float fs_hz, float q) {
+    return design_biquad(coef, fc_hz, fs_hz, q, false);
+}
+
+bool imu_dsp_highpass(imu_dsp_biquad_t &coef, float fc_hz, float fs_hz, float q) {
+    return design_biquad(coef, fc_hz, fs_hz, q, true);
+}
+
+bool imu_dsp_butterworth_lowpass(imu_dsp_biquad_t *stages, size_t n_stages, float fc_hz, float fs_hz) {
+    if (n_stages == 0 || n_stages > IMU_DSP_MAX_STAGES) {
+        return false;
+    }
+
+    // pole pair k of an order 2n Butterworth: Q = 1 / (2 cos((2k + 1) pi / 4n))
+    for (size_t k = 0; k < n_stages; k++) {
+        const float q = 1.0f / (2.0f * std::cos((2.0f * k + 1.0f) * PI / (4.0f * n_stages)));
+        if (!design_biquad(stages[k], fc_hz, fs_hz, q, false)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ============================================================
+// BIQUAD CASCADE
+// ============================================================
+
+bool imu_dsp_cascade::configure(const imu_dsp_biquad_t *stages, size_t count) {
+    if (stages == nullptr || count == 0 || count > IMU_DSP_MAX_STAGES) {
+        return false;
+    }
+    std::memcpy(coef, stages, count * sizeof(imu_dsp_biquad_t));
+    n_stages = count;
+    reset();
+    return true;
+}
+
+void imu_dsp_cascade::reset() {
+    std::memset(w, 0, sizeof(w));
+}
+
+void imu_dsp_cascade::process(float v[IMU_DSP_AXES]) {
+    for (size_t s = 0; s < n_stages; s++) {
+        const imu_dsp_biquad_t &c = coef[s];
+        for (int a = 0; a < IMU_DSP_AXES; a++) {
+            float *st = w[s][a];
+            const float d = v[a] - c.a2 * st[1] - c.a1 * st[0];
+            v[a] = c.b0 * d + c.b1 * st[0] + c.b2 * st[1];
+            st[1] = st[0];
+            st[0] = d;
+        }
+    }
+}
+
+#if IMU_DSP_ESP_DSP
+/// @brief One stage over a block, one esp-dsp call per axis
+static void biquad_block(const imu_dsp_biquad_t &c, float (&st)[IMU_DSP_AXES][2],
+                         float (&x)[IMU_DSP_AXES][IMU_DSP_BLOCK_LEN], size_t n) {
+    alignas(16) float y[IMU_DSP_BLOCK_LEN];
+    for (int a = 0; a < IMU_DSP_AXES; a++) {
+        dsps_biquad_f32(x[a], y, static_cast<int>(n), const_cast<float *>(&c.b0), st[a]);
+        std::memcpy(x[a], y, n * sizeof(float));
+    }
+}
+#else
+/**
+ * @brief All stages over a block
+ * Sample by sample with the three axes in one lanes_t, so each step of the
+ * recursion is one SIMD operation; unrolled over the stages so the state
+ * stays in registers and stage s of sample i overlaps stage s - 1 of sample
+ * i + 1. Same operations in the same order as the one sample form.
+ */
+template <size_t STAGES>
+static void cascade_block(const imu_dsp_biquad_t *coef, float (*w)[IMU_DSP_AXES][2],
+                          float (&x)[IMU_DSP_AXES][IMU_DSP_BLOCK_LEN], size_t n) {
+    lanes_t b0[STAGES], b1[STAGES], b2[STAGES], a1[STAGES], a2[STAGES];
+    lanes_t d1[STAGES], d2[STAGES];
+    for (size_t s = 0; s < STAGES; s++) {
+        b0[s] = lanes_t{} + coef[s].b0;
+        b1[s] = lanes_t{} + coef[s].b1;
+        b2[s] = lanes_t{} + coef[s].b2;
+        a1[s] = lanes_t{} + coef[s].a1;
+        a2[s] = lanes_t{} + coef[s].a2;
+        d1[s] = lanes_t{w[s][0][0], w[s][1][0], w[s][2][0], 0.0f};
+        d2[s] = lanes_t{w[s][0][1], w[s][1][1], w[s][2][1], 0.0f};
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        lanes_t v = load_lanes(x, i);
+        for (size_t s = 0; s < STAGES; s++) {
+            const lanes_t d = v - a2[s] * d2[s] - a1[s] * d1[s];
+            v = b0[s] * d + b1[s] * d1[s] + b2[s] * d2[s];
+            d2[s] = d1[s];
+            d1[s] = d;
+        }
+        store_lanes(x, i, v);
+    }
+
+    for (size_t s = 0; s < STAGES; s++) {
+        for (int a = 0; a < IMU_DSP_AXES; a++) {
+            w[s][a][0] = d1[s][a];
+            w[s][a][1] = d2[s][a];
+        }
+    }
+}
+#endif
+
+void imu_dsp_cascade::process(imu_dsp_block_t &block) {
+    if (block.n == 0) {
+        return;
+    }
+#if IMU_DSP_ESP_DSP
+    for (size_t s = 0; s < n_stages; s++) {
+        biquad_block(coef[s], w[s], block.axis, block.n);
+    }
+#else
+    static_assert(IMU_DSP_MAX_STAGES <= 4, "add cascade_block cases");
+    switch (n_stages) {
+        case 1:
+            cascade_block<1>(coef, w, block.axis, block.n);
+            break;
+        case 2:
+            cascade_block<2>(coef, w, block.axis, block.n);
+            break;
+        case 3:
+            cascade_block<3>(coef, w, block.axis, block.n);
+            break;
+        default:
+            cascade_block<4>(coef, w, block.axis, block.n);
+            break;
+    }
+#endif
+}
+
+// ============================================================
+// MOVING MEAN / VARIANCE
+// ============================================================
+
+bool imu_dsp_moving_stats::configure(size_t window) {
+    if (window == 0 || window > IMU_DSP_MAX_WINDOW) {
+        return false;
+    }
+    len = window;
+    reset();
+    return true;
+}
+
+void imu_dsp_moving_stats::reset() {
+    std::memset(shift, 0, sizeof(shift));
+    std::memset(sum, 0, sizeof(sum));
+    std::memset(sumsq, 0, sizeof(sumsq));
+    pos = 0;
+    count = 0;
+}
+
+/// @brief Move the shift to the window mean and recompute the sums from the window, called once per window
+void imu_dsp_moving_stats::rebase() {
+    for (int a = 0; a < IMU_DSP_AXES; a++) {
+        shift[a] += sum[a] / static_cast<float>(count);
+        float s = 0.0f;
+        float q = 0.0f;
+        for (size_t k = 0; k < count; k++) {
+            const float d = hist[a][k] - shift[a];
+            s += d;
+            q += d * d;
+        }
+        sum[a] = s;
+        sumsq[a] = q;
+    }
+}
+
+void imu_dsp_moving_stats::current(float *mean, float *var) const {
+    const float c = static_cast<float>(count > 0 ? count : 1);
+    for (int a = 0; a < IMU_DSP_AXES; a++) {
+        const float m = sum[a] / c;
+        if (mean != nullptr) {
+            mean[a] = (count > 0) ? shift[a] + m : 0.0f;
+        }
+        if (var != nullptr) {
+            const float sigma2 = sumsq[a] / c - m * m;
+            var[a] = sigma2 > 0.0f ? sigma2 : 0.0f;
+        }
+    }
+}
+
+void imu_dsp_moving_stats::process(const float v[IMU_DSP_AXES], float *mean, float *var) {
+    if (count == 0) {
+        std::memcpy(shift, v, sizeof(shift));
+    }
+    const bool full = (count == len);
+    count += full ? 0 : 1;
+    const float c = static_cast<float>(count);
+
+    for (int a = 0; a < IMU_DSP_AXES; a++) {
+        if (full) {
+            const float o = hist[a][pos] - shift[a];
+            sum[a] -= o;
+            sumsq[a] -= o * o;
+        }
+        const float d = v[a] - shift[a];
+        hist[a][pos] = v[a];
+        sum[a] += d;
+        sumsq[a] += d * d;
+
+        const float m = sum[a] / c;
+        if (mean != nullptr) {
+            mean[a] = shift[a] + m;
+        }
+        if (var != nullptr) {
+            const float sigma2 = sumsq[a] / c - m * m;
+            var[a] = sigma2 > 0.0f ? sigma2 : 0.0f;
+        }
+    }
+
+    if (++pos == len) {
+        pos = 0;
+        rebase();
+    }
+}
+
+void imu_dsp_moving_stats::process(const imu_dsp_block_t &in, imu_dsp_block_t *mean, imu_dsp_block_t *var) {
+    if (count == 0 && in.n > 0) {
+        for (int a = 0; a < IMU_DSP_AXES; a++) {
+            shift[a] = in.axis[a][0];
+        }
+    }
+
+    // segments end where the history wraps, each runs over contiguous history with the sums in registers
+    const lanes_t zero = {};
+    lanes_t sh = to_lanes(shift);
+    lanes_t s = to_lanes(sum);
+    lanes_t q = to_lanes(sumsq);
+    size_t i = 0;
+    while (i < in.n) {
+        const size_t seg = (in.n - i < len - pos) ? in.n - i : len - pos;
+        size_t n = count;
+        for (size_t k = 0; k < seg; k++) {
+            const lanes_t v = load_lanes(in.axis, i + k);
+            if (n == len) {
+                const lanes_t o = load_lanes(hist, pos + k) - sh;
+                s -= o;
+                q -= o * o;
+            } else {
+                n++;
+            }
+            const lanes_t d = v - sh;
+            store_lanes(hist, pos + k, v);
+            s += d;
+            q += d * d;
+
+            const lanes_t c = zero + static_cast<float>(n);
+            const lanes_t m = s / c;
+            if (mean != nullptr) {
+                store_lanes(mean->axis, i + k, sh + m);
+            }
+            if (var != nullptr) {
+                const lanes_t sigma2 = q / c - m * m;
+                store_lanes(var->axis, i + k, sigma2 > zero ? sigma2 : zero);
+            }
+        }
+
+        count = (count + seg < len) ? count + seg : len;
+        pos += seg;
+        i += seg;
+        if (pos == len) {
+            from_lanes(s, sum);
+            from_lanes(q, sumsq);
+            pos = 0;
+            rebase();
+            sh = to_lanes(shift);
+            s = to_lanes(sum);
+            q = to_lanes(sumsq);
+        }
+    }
+    from_lanes(s, sum);
+    from_lanes(q, sumsq);
+
+    for (imu_dsp_block_t *out : {mean, var}) {
+        if (out != nullptr) {
+            std::memcpy(out->t_us, in.t_us, in.n * sizeof(uint32_t));
+            out->n = in.n;
+        }
+    }
+}
+
+// ============================================================
+// GRAVITY REMOVAL
+// ============================================================
+
+bool imu_dsp_gravity_hp::configure(float fc_hz, float fs_hz) {
+    if (!(fs_hz > 0.0f) || !(fc_hz > 0.0f) || !(fc_hz < 0.5f * fs_hz)) {
+        return false;
+    }
+    alpha = 1.0f - std::exp(-2.0f * PI * fc_hz / fs_hz);
+    reset();
+    return true;
+}
+
+void imu_dsp_gravity_hp::reset() {
+    std::memset(g, 0, sizeof(g));
+    seeded = false;
+}
+
+void imu_dsp_gravity_hp::process(float v[IMU_DSP_AXES]) {
+    // seed with the first sample, a cold start from 0 would pass 1 g through for seconds
+    if (!seeded) {
+        std::memcpy(g, v, sizeof(g));
+        seeded = true;
+    }
+    for (int a = 0; a < IMU_DSP_AXES; a++) {
+        g[a] += alpha * (v[a] - g[a]);
+        v[a] -= g[a];
+    }
+}
+
+void imu_dsp_gravity_hp::process(imu_dsp_block_t &block) {
+    if (block.n == 0) {
+        return;
+    }
+    if (!seeded) {
+        for (int a = 0; a < IMU_DSP_AXES; a++) {
+            g[a] = block.axis[a][0];
+        }
+        seeded = true;
+    }
+
+    const lanes_t k = lanes_t{} + alpha;
+    lanes_t gl = to_lanes(g);
+    for (size_t i = 0; i < block.n; i++) {
+        const lanes_t v = load_lanes(block.axis, i);
+        gl += k * (v - gl);
+        store_lanes(block.axis, i, v - gl);
+    }
+    from_lanes(gl, g);
+}
+
+// ============================================================
+// DECIMATION
+// ============================================================
+
+bool imu_dsp_decimator::configure(uint32_t decimate_by, float fs_hz, size_t n_stages) {
+    if (decimate_by == 0) {
+        return false;
+    }
+
+    imu_dsp_biquad_t stages[IMU_DSP_MAX_STAGES];
+    const float fc_hz = 0.4f * fs_hz / static_cast<float>(decimate_by);
+    if (!imu_dsp_butterworth_lowpass(stages, n_stages, fc_hz, fs_hz) || !anti_alias.configure(stages, n_stages)) {
+        return false;
+    }
+    factor = decimate_by;
+    phase = 0;
+    return true;
+}
+
+void imu_dsp_decimator::reset() {
+    anti_alias.reset();
+    phase = 0;
+}
+
+bool imu_dsp_decimator::process(float v[IMU_DSP_AXES]) {
+    anti_alias.process(v);
+    const bool keep = (phase == 0);
+    phase = (phase + 1 == factor) ? 0 : phase + 1;
+    return keep;
+}
+
+void imu_dsp_decimator::process(imu_dsp_block_t &block) {
+    anti_alias.process(block);
+
+    size_t out = 0;
+    for (size_t i = 0; i < block.n; i++) {
+        if (phase == 0) {
+            for (int a = 0; a < IMU_DSP_AXES; a++) {
+                block.axis[a][out] = block.axis[a][i];
+            }
+            block.t_us[out] = block.t_us[i];
+            out++;
+        }
+        phase = (phase + 1 == factor) ? 0 : phase + 1;
+    }
+    block.n = out;
+}
@@ -0,0 +1,225 @@
+// imu_dsp.hpp
+#ifndef IMU_DSP_H
+#define IMU_DSP_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "imu_driver.hpp"
+
+/**
+ * Streaming filters for 3 axis reports (accel, linear accel, gyro, magf):
+ * biquad cascades, moving mean / variance, gravity removal and decimation.
+ *
+ * Every filter takes either one sample (process(float v[3]), for a consumer
+ * handling samples as they are drained) or a block of up to IMU_DSP_BLOCK_LEN
+ * samples in struct of arrays layout, filled from drained samples with
+ * imu_dsp_gather(). The block kernels keep the state in registers across the
+ * block and run the three axes of a sample as one 4 lane vector (SSE / NEON
+ * on the host, about 2x the one sample form). On the ESP32-S3 with esp-dsp
+ * available the biquads run on its PIE (SIMD) kernels instead. Both forms
+ * give the same output for the same input, bit exact on the host and to
+ * rounding where the block form runs on esp-dsp.
+ *
+ * No allocation, filters are plain objects with their state inside; one task
+ * per filter object.
+ */
+
+#ifndef IMU_DSP_BLOCK_LEN
+#define IMU_DSP_BLOCK_LEN 32      ///< samples per block, 320 ms of a 100 Hz report
+#endif
+
+#ifndef IMU_DSP_MAX_STAGES
+#define IMU_DSP_MAX_STAGES 4      ///< biquads per cascade, up to 8th order
+#endif
+
+#ifndef IMU_DSP_MAX_WINDOW
+#define IMU_DSP_MAX_WINDOW 128    ///< moving mean / variance window limit in samples
+#endif
+
+#define IMU_DSP_AXES 3
+
+/**
+ * @brief Block of one report's samples, struct of arrays
+ * @param axis: x, y, z values, axis[a][i] is axis a of sample i
+ * @param t_us: sample timestamps
+ * @param n: samples in the block
+ */
+typedef struct imu_dsp_block_t {
+    alignas(16) float axis[IMU_DSP_AXES][IMU_DSP_BLOCK_LEN];
+    uint32_t t_us[IMU_DSP_BLOCK_LEN];
+    size_t n;
+} imu_dsp_block_t;
+
+/**
+ * @brief Append the samples of one 3 axis report to a block
+ * @param in: drained samples, other reports are skipped
+ * @param count: samples in in
+ * @param report_id: report to collect, must be an IMU_SAMPLE_VEC report
+ * @param block: block to append to, full at IMU_DSP_BLOCK_LEN
+ * @return samples of in consumed, less than count when the block filled up: process it, set n to 0 and call again with the rest
+ */
+size_t imu_dsp_gather(const imu_sample_t *in, size_t count, uint8_t report_id, imu_dsp_block_t &block);
+
+/**
+ * @brief Biquad coefficients, y = b0 d + b1 d1 + b2 d2 with d = x - a1 d1 - a2 d2 (direct form II, a0 = 1)
+ * @note Same layout as esp-dsp's float coef[5]
+ */
+typedef struct imu_dsp_biquad_t {
+    float b0, b1, b2, a1, a2;
+} imu_dsp_biquad_t;
+
+/**
+* @brief Second order low pass
+* @param fc_hz: cutoff, below fs_hz / 2
+* @param fs_hz: sample rate
+* @param q: quality factor, 0.7071 for Butterworth
+* @return false if fc_hz or q is out of range
+*/
+bool imu_dsp_lowpass(imu_dsp_biquad_t &coef, float fc_hz, float fs_hz, float q = 0.7071f);
+
+/// @brief Second order high pass, same parameters as imu_dsp_lowpass()
+bool imu_dsp_highpass(imu_dsp_biquad_t &coef, float fc_hz, float fs_hz, float q = 0.7071f);
+
+/**
+* @brief Butterworth low pass of order 2 x n_stages as a biquad cascade
+* @param stages: n_stages coefficient sets to fill
+* @return false if n_stages is 0 or above IMU_DSP_MAX_STAGES, or the cutoff is out of range
+*/
+bool imu_dsp_butterworth_lowpass(imu_dsp_biquad_t *stages, size_t n_stages, float fc_hz, float fs_hz);
+
+/// @brief Cascade of biquads applied to each axis
+class imu_dsp_cascade
+{
+    public:
+        /**
+        * @brief Set the stages and clear the state
+        * @return false if n_stages is 0 or above IMU_DSP_MAX_STAGES
+        */
+        bool configure(const imu_dsp_biquad_t *stages, size_t n_stages);
+        void reset();
+
+        /// @brief Filter one sample in place
+        void process(float v[IMU_DSP_AXES]);
+        /// @brief Filter a block in place
+        void process(imu_dsp_block_t &block);
+
+        size_t stages() const { return n_stages; }
+
+    private:
+        imu_dsp_biquad_t coef[IMU_DSP_MAX_STAGES] = {};
+        float w[IMU_DSP_MAX_STAGES][IMU_DSP_AXES][2] = {};   ///< d1, d2 per stage and axis
+        size_t n_stages = 0;
+};
+
+/**
+ * Moving mean and variance over the last window samples. Sums are kept
+ * relative to a shift near the mean (the first sample, then the previous
+ * window's mean) and recomputed from the window once per window, so float
+ * rounding neither drifts nor cancels the variance of a small signal on a
+ * large offset (accel with gravity).
+ */
+class imu_dsp_moving_stats
+{
+    public:
+        /**
+        * @brief Set the window and clear the history
+        * @return false if window is 0 or above IMU_DSP_MAX_WINDOW
+        */
+        bool configure(size_t window);
+        void reset();
+
+        /**
+        * @brief Add one sample
+        * @param mean: mean of the window ending at v, may be nullptr
+        * @param var: population variance of that window, may be nullptr
+        * @note Until the window has filled up, the statistics are over the samples so far
+        */
+        void process(const float v[IMU_DSP_AXES], float *mean, float *var);
+
+        /// @brief Add a block, mean / var (either may be nullptr) get one value per sample with in's timestamps
+        void process(const imu_dsp_block_t &in, imu_dsp_block_t *mean, imu_dsp_block_t *var);
+
+        /// @brief Mean / variance (either may be nullptr) of the window as of the last sample added, 0 before the first
+        void current(float *mean, float *var) const;
+
+        size_t window() const { return len; }
+        size_t filled() const { return count; }
+
+    private:
+        void rebase();
+
+        float hist[IMU_DSP_AXES][IMU_DSP_MAX_WINDOW] = {};
+        float shift[IMU_DSP_AXES] = {};
+        float sum[IMU_DSP_AXES] = {};
+        float sumsq[IMU_DSP_AXES] = {};
+        size_t len = 0;
+        size_t pos = 0;
+        size_t count = 0;
+};
+
+/**
+ * Gravity removal for accel reports: a one pole low pass tracks gravity and
+ * is subtracted. Lets a consumer run on SH2_ACCELEROMETER alone instead of
+ * also enabling SH2_LINEAR_ACCELERATION, which needs the hub's fusion.
+ */
+class imu_dsp_gravity_hp
+{
+    public:
+        /**
+        * @brief Set the corner and clear the estimate, the next sample seeds it
+        * @param fc_hz: corner, e.g. 0.3 Hz, below fs_hz / 2
+        * @param fs_hz: sample rate
+        * @return false if fc_hz is out of range
+        */
+        bool configure(float fc_hz, float fs_hz);
+        void reset();
+
+        /// @brief Remove gravity from one sample in place
+        void process(float v[IMU_DSP_AXES]);
+        /// @brief Remove gravity from a block in place
+        void process(imu_dsp_block_t &block);
+
+        /// @brief Current gravity estimate
+        const float *gravity() const { return g; }
+
+    private:
+        float alpha = 0.0f;
+        float g[IMU_DSP_AXES] = {};
+        bool seeded = false;
+};
+
+/**
+ * Decimation by an integer factor behind a Butterworth anti-alias low pass
+ * at 0.4 x the output rate, e.g. 400 Hz accel to 100 Hz for a consumer that
+ * does not need the hub's full rate.
+ */
+class imu_dsp_decimator
+{
+    public:
+        /**
+        * @brief Set the factor and design the anti-alias filter
+        * @param factor: input samples per output sample, 1 passes everything through the filter
+        * @param fs_hz: input sample rate
+        * @param n_stages: anti-alias biquads
+        * @return false if factor is 0 or n_stages is out of range
+        */
+        bool configure(uint32_t factor, float fs_hz, size_t n_stages = 2);
+        void reset();
+
+        /**
+        * @brief Filter one sample in place
+        * @return true if v is an output sample, false if it was dropped
+        */
+        bool process(float v[IMU_DSP_AXES]);
+
+        /// @brief Filter and decimate a block in place, block.n shrinks to the output samples
+        void process(imu_dsp_block_t &block);
+
+    private:
+        imu_dsp_cascade anti_alias;
+        uint32_t factor = 1;
+        uint32_t phase = 0;
+};
+
+#endif /* IMU_DSP_H */
@@ -0,0 +1,210 @@
+// pipeline.hpp
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "behavior_features.hpp"
+#include "imu_driver.hpp"
+
+/**
+ * Two-core data path. The ESP32-S3 has two cores and the sensor side has the
+ * tightest deadlines, so each core gets one side of the sample ring:
+ *
+ *   INGEST  (PIPELINE_INGEST_CORE)   esp32_BNO08x's SHTP tasks and the
+ *           ingestion callback they run, the only producer of the ring
+ *   PROCESS (PIPELINE_PROCESS_CORE)  drains the ring, runs the behavior
+ *           feature engine, packs compact records into the store queue
+ *   STORE   (PIPELINE_PROCESS_CORE)  codec blocks for the uplink and the
+ *           flash log, below PROCESS so a flash write cannot delay it
+ *
+ * The library creates its own tasks and takes no affinity, so they are
+ * pinned to PIPELINE_INGEST_CORE in its menuconfig. pipeline_start() waits
+ * for an ingestion callback and refuses to start when it runs on another
+ * core; after that a decimated subscriber keeps recording the callback's
+ * core, and every stage counts activations on the wrong core. binlog's task
+ * belongs on the process core.
+ *
+ * The application hooks in without a task of its own: on_batch sees every
+ * batch PROCESS drained, housekeeping runs periodically in STORE, where a
+ * slow call (an NVS write) cannot delay the sample path.
+ *
+ * Every hand-off is bounded. The ring drops the newest sample when full
+ * (the callback cannot wait); the store queue and the feature queue follow
+ * pipeline_policy_t. PROCESS drains at most `batch` samples per wake, so a
+ * sample waits at most batch / sample rate in the ring; STORE stamps each
+ * record with its age from measurement and counts those over the budget.
+ * pipeline_get_stats() reports per-stage depth, drops, CPU time and core.
+ */
+
+#ifndef PIPELINE_INGEST_CORE
+#define PIPELINE_INGEST_CORE 0
+#endif
+
+#ifndef PIPELINE_PROCESS_CORE
+#define PIPELINE_PROCESS_CORE 1
+#endif
+
+#ifndef PIPELINE_STORE_QUEUE_LEN
+#define PIPELINE_STORE_QUEUE_LEN 256       ///< compact records between PROCESS and STORE, 3 KB
+#endif
+
+#ifndef PIPELINE_FEATURE_QUEUE_LEN
+#define PIPELINE_FEATURE_QUEUE_LEN 8       ///< feature vectors waiting for pipeline_pop_features()
+#endif
+
+#ifndef PIPELINE_MAX_BATCH
+#define PIPELINE_MAX_BATCH 32              ///< largest ring drain per PROCESS wake
+#endif
+
+#ifndef PIPELINE_TASK_STACK
+#define PIPELINE_TASK_STACK 4096           ///< bytes per stage task, statically allocated
+#endif
+
+/// @brief What a full queue does with a new item
+typedef enum pipeline_policy_t : uint8_t {
+    PIPELINE_DROP_NEWEST,    ///< reject the new item, the queue keeps the older ones
+    PIPELINE_DROP_OLDEST,    ///< discard the oldest item to take the new one, for data that goes stale
+    PIPELINE_BLOCK,          ///< the producer waits up to block_ms for space, then drops the new item
+} pipeline_policy_t;
+
+typedef enum pipeline_stage_t : uint8_t {
+    PIPELINE_STAGE_INGEST,
+    PIPELINE_STAGE_PROCESS,
+    PIPELINE_STAGE_STORE,
+    PIPELINE_STAGE_COUNT
+} pipeline_stage_t;
+
+/**
+ * @brief Pipeline configuration
+ * @param process_priority: PROCESS task priority, keep it above STORE and binlog
+ * @param store_priority: STORE task priority
+ * @param batch: samples drained per PROCESS wake, 1..PIPELINE_MAX_BATCH, bounds the time a sample waits in the ring
+ * @param features: feature engine configuration, fs_hz must match the reports' rate
+ * @param features_enabled: false skips the feature engine
+ * @param store_policy: store queue policy
+ * @param feature_policy: feature queue policy, PIPELINE_BLOCK is treated as PIPELINE_DROP_NEWEST (nobody may stall PROCESS)
+ * @param block_ms: longest PROCESS waits on a full store queue with PIPELINE_BLOCK
+ * @param flash_log: append every record to the flash log, flash_log_open() first
+ * @param block_sink: called by STORE with every full codec block (uplink), nullptr skips compression
+ * @param latency_budget_ms: age from measurement at which a stored record counts as late
+ * @param ingest_check_ms: how long pipeline_start() waits for an ingestion callback to check its core, 0 skips;
+ *                         no callback in that time (no report streaming) starts with a warning
+ * @param on_batch: called by PROCESS with every drained batch, after it was queued for STORE; may be nullptr
+ * @param housekeeping: called by STORE every housekeeping_ms, may block; may be nullptr
+ * @param housekeeping_ms: period of housekeeping
+ */
+typedef struct pipeline_config_t {
+    UBaseType_t process_priority = 10;
+    UBaseType_t store_priority = 5;
+    size_t batch = 8;
+    behavior_features_config_t features;
+    bool features_enabled = true;
+    pipeline_policy_t store_policy = PIPELINE_BLOCK;
+    pipeline_policy_t feature_policy = PIPELINE_DROP_OLDEST;
+    uint32_t block_ms = 10UL;
+    bool flash_log = false;
+    void (*block_sink)(const uint8_t *block, size_t len) = nullptr;
+    uint32_t latency_budget_ms = 50UL;
+    uint32_t ingest_check_ms = 200UL;
+    void (*on_batch)(const imu_sample_t *samples, size_t count) = nullptr;
+    void (*housekeeping)() = nullptr;
+    uint32_t housekeeping_ms = 1000UL;
+} pipeline_config_t;
+
+/**
+ * @brief Counters of one bounded queue
+ * @param depth: items in it now
+ * @param high_water: most items it held
+ * @param capacity: slots
+ * @param dropped: items lost to its policy
+ * @param blocked_us: time the producer waited for space
+ */
+typedef struct pipeline_queue_stats_t {
+    uint32_t depth;
+    uint32_t high_water;
+    uint32_t capacity;
+    uint32_t dropped;
+    uint32_t blocked_us;
+} pipeline_queue_stats_t;
+
+/**
+ * @brief Counters of one stage
+ * @param input: the queue the stage consumes (the sample ring for PROCESS, the store queue for STORE),
+ *               for INGEST the ring seen from the producer: dropped counts ring overflows
+ * @param items: items the stage finished
+ * @param busy_us: CPU time spent working, waits excluded
+ * @param max_run_us: longest single activation
+ * @param latency_max_us: worst age of an item when the stage finished it, from its measurement time (0 for INGEST)
+ * @param core: core the stage last ran on, -1 before it ran
+ * @param misplaced: activations seen on the wrong core
+ */
+typedef struct pipeline_stage_stats_t {
+    pipeline_queue_stats_t input;
+    uint32_t items;
+    uint32_t busy_us;
+    uint32_t max_run_us;
+    uint32_t latency_max_us;
+    int8_t core;
+    uint32_t misplaced;
+} pipeline_stage_stats_t;
+
+/**
+ * @brief Pipeline counters since start or the last reset
+ * @param stage: per pipeline_stage_t
+ * @param features: the feature vector queue
+ * @param window_us: wall time the counters cover, divide busy_us by it for a core's load
+ * @param late: records stored later than latency_budget_ms after measurement
+ * @param latency_avg_us: mean age of a stored record
+ */
+typedef struct pipeline_stats_t {
+    pipeline_stage_stats_t stage[PIPELINE_STAGE_COUNT];
+    pipeline_queue_stats_t features;
+    uint32_t window_us;
+    uint32_t late;
+    uint32_t latency_avg_us;
+} pipeline_stats_t;
+
+/**
+* @brief Start the ring and the PROCESS and STORE tasks, pinned to PIPELINE_PROCESS_CORE
+* @param config: configuration to copy
+* @return false if the configuration is invalid, ingestion runs off PIPELINE_INGEST_CORE, a task could not be
+*         created or the pipeline already runs
+* @note The pipeline is the sample ring's only consumer, do not drain it elsewhere while it runs
+*/
+bool pipeline_start(const pipeline_config_t &config);
+
+/**
+* @brief Stop both tasks, hand the partial codec block to block_sink and sync the flash log
+* @note Records still in the store queue are stored first. Call from a task, it waits for the stages to exit
+*/
+void pipeline_stop();
+
+bool pipeline_running();
+
+/**
+* @brief The PROCESS task, for a power manager that suspends processing outside ACTIVE
+* @return the task handle, nullptr before the first successful pipeline_start()
+* @note Resume it before pipeline_stop(), which waits for PROCESS to park
+*/
+TaskHandle_t pipeline_get_process_task();
+
+/**
+* @brief Take feature vectors PROCESS produced, from a single consumer task
+* @param out: destination
+* @param max: capacity of out
+* @param ticks_to_wait: how long to wait for the first one
+* @return vectors copied, 0 on timeout
+*/
+size_t pipeline_pop_features(behavior_features_t *out, size_t max, TickType_t ticks_to_wait = 0);
+
+pipeline_stats_t pipeline_get_stats();
+
+void pipeline_reset_stats();
+
+const char *pipeline_stage_to_str(pipeline_stage_t stage);
+
+#endif /* PIPELINE_H */
@@ -0,0 +1,463 @@
+#include <atomic>
+
+#include "pipeline.hpp"
+#include "pipeline_queue.hpp"
+#include "flash_log.hpp"
+#include "imu_codec.hpp"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+
+static constexpr const char *TAG = "PIPELINE";
+static constexpr uint16_t PROBE_DECIMATION = 64;    // ingestion callbacks per core check
+static constexpr TickType_t IDLE_TICKS = pdMS_TO_TICKS(100);    // how often an idle stage looks at stopping
+
+enum : EventBits_t {
+    EVT_PROCESS_RUN = (1UL << 0),
+    EVT_PROCESS_IDLE = (1UL << 1),
+    EVT_STORE_IDLE = (1UL << 2),
+    EVT_STORE_DATA = (1UL << 3),
+    EVT_STORE_SPACE = (1UL << 4),
+    EVT_FEATURE_DATA = (1UL << 5),
+    EVT_FEATURE_SPACE = (1UL << 6),
+    EVT_STORE_RUN = (1UL << 7),
+    EVT_INGEST_SEEN = (1UL << 8),
+};
+
+/**
+ * Counters of one stage, written only by that stage (INGEST: the probe
+ * subscriber) with plain load/store pairs. A reset is requested from any
+ * task and applied by the writer on its next activation, as the report
+ * metrics do.
+ */
+typedef struct pl_stage_counters_t {
+    std::atomic<uint32_t> items{0};
+    std::atomic<uint32_t> busy_us{0};
+    std::atomic<uint32_t> max_run_us{0};
+    std::atomic<uint32_t> latency_max_us{0};
+    std::atomic<uint32_t> misplaced{0};
+    std::atomic<int32_t> core{-1};
+    std::atomic<bool> reset{false};
+} pl_stage_counters_t;
+
+static pipeline_config_t pl_cfg;
+static std::atomic<bool> running{false};
+static std::atomic<bool> stopping{false};
+static StaticEventGroup_t event_buf;
+static EventGroupHandle_t events = nullptr;
+
+static pipeline_queue<imu_compact_sample_t, PIPELINE_STORE_QUEUE_LEN> store_q;
+static pipeline_queue<behavior_features_t, PIPELINE_FEATURE_QUEUE_LEN> feature_q;
+static behavior_feature_engine engine;
+static imu_codec_encoder encoder;
+
+static StaticTask_t process_buf;
+static StackType_t process_stack[PIPELINE_TASK_STACK / sizeof(StackType_t)];
+static StaticTask_t store_buf;
+static StackType_t store_stack[PIPELINE_TASK_STACK / sizeof(StackType_t)];
+static TaskHandle_t process_task = nullptr;
+static TaskHandle_t store_task = nullptr;
+
+static pl_stage_counters_t counters[PIPELINE_STAGE_COUNT];
+static std::atomic<uint32_t> late{0};
+static std::atomic<uint32_t> latency_avg_q4{0};    // EWMA of a stored record's age, us x16
+static int64_t window_start_us = 0;
+static uint32_t ingest_cycles_base = 0;
+static int probe_handle = -1;
+static std::atomic<bool> ingest_seen{false};
+
+const char *pipeline_stage_to_str(pipeline_stage_t stage) {
+    switch (stage) {
+        case PIPELINE_STAGE_INGEST:
+            return "INGEST";
+        case PIPELINE_STAGE_PROCESS:
+            return "PROCESS";
+        case PIPELINE_STAGE_STORE:
+            return "STORE";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+static inline void pl_add(std::atomic<uint32_t> &word, uint32_t value) {
+    word.store(word.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+static inline void pl_raise(std::atomic<uint32_t> &word, uint32_t value) {
+    if (value > word.load(std::memory_order_relaxed)) {
+        word.store(value, std::memory_order_relaxed);
+    }
+}
+
+/// @brief Start of one activation: apply a pending reset and check the core
+static void pl_stage_begin(pl_stage_counters_t &c, BaseType_t want_core) {
+    if (c.reset.exchange(false, std::memory_order_relaxed)) {
+        c.items.store(0, std::memory_order_relaxed);
+        c.busy_us.store(0, std::memory_order_relaxed);
+        c.max_run_us.store(0, std::memory_order_relaxed);
+        c.latency_max_us.store(0, std::memory_order_relaxed);
+        c.misplaced.store(0, std::memory_order_relaxed);
+    }
+
+    const BaseType_t core = xPortGetCoreID();
+    c.core.store(core, std::memory_order_relaxed);
+    if (core != want_core) {
+        pl_add(c.misplaced, 1);
+    }
+}
+
+static void pl_stage_end(pl_stage_counters_t &c, esp_cpu_cycle_count_t start, uint32_t waited_us, uint32_t items) {
+    const uint32_t ran_us = (esp_cpu_get_cycle_count() - start) / esp_rom_get_cpu_ticks_per_us();
+    const uint32_t run_us = ran_us > waited_us ? ran_us - waited_us : 0;
+    pl_add(c.items, items);
+    pl_add(c.busy_us, run_us);
+    pl_raise(c.max_run_us, run_us);
+}
+
+/// @brief Time since a sample was measured, 0 if the clock model maps it slightly into the future
+static inline uint32_t pl_age_us(uint32_t timestamp_us) {
+    const int32_t age_us = static_cast<int32_t>(static_cast<uint32_t>(esp_timer_get_time()) - timestamp_us);
+    return age_us > 0 ? static_cast<uint32_t>(age_us) : 0;
+}
+
+// runs in the ingestion callback every PROBE_DECIMATION samples: which core the library delivers on
+static void pl_ingest_probe(const imu_sample_t &, void *) {
+    pl_stage_begin(counters[PIPELINE_STAGE_INGEST], PIPELINE_INGEST_CORE);
+    // the first sample after subscribing is always delivered, pipeline_start() waits for it
+    if (!ingest_seen.load(std::memory_order_relaxed) && !ingest_seen.exchange(true, std::memory_order_relaxed)) {
+        xEventGroupSetBits(events, EVT_INGEST_SEEN);
+    }
+}
+
+/**
+ * The library's tasks take no affinity, so they cannot be pinned from here:
+ * wait for one ingestion callback and refuse a core other than
+ * PIPELINE_INGEST_CORE, before PROCESS and STORE run beside it.
+ * @return false if ingestion was seen on the wrong core
+ */
+static bool pl_check_ingest_core(uint32_t wait_ms) {
+    if (wait_ms == 0) {
+        return true;
+    }
+    if ((xEventGroupWaitBits(events, EVT_INGEST_SEEN, pdTRUE, pdFALSE, pdMS_TO_TICKS(wait_ms)) & EVT_INGEST_SEEN) == 0) {
+        ESP_LOGW(TAG, "No ingestion in %lu ms, its core is only checked once samples flow", (unsigned long)wait_ms);
+        return true;
+    }
+
+    const int32_t core = counters[PIPELINE_STAGE_INGEST].core.load(std::memory_order_relaxed);
+    if (core != PIPELINE_INGEST_CORE) {
+        ESP_LOGE(TAG, "Ingestion runs on core %ld, pin the esp32_BNO08x tasks to core %d", (long)core,
+                 PIPELINE_INGEST_CORE);
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Stage tasks: created once and pinned, they park on their run bit between
+// pipeline_stop() and the next pipeline_start() instead of being deleted, so
+// the static task buffers are never reused under the kernel. Each task
+// consumes its bit on waking: a stop that comes before the task woke still
+// finds the bit set, the task wakes, sees stopping and parks again.
+// ============================================================================
+
+static void pipeline_process_task(void *pvParameters) {
+    static imu_sample_t batch[PIPELINE_MAX_BATCH];
+    pl_stage_counters_t &c = counters[PIPELINE_STAGE_PROCESS];
+
+    while (true) {
+        xEventGroupWaitBits(events, EVT_PROCESS_RUN, pdTRUE, pdFALSE, portMAX_DELAY);
+        const TickType_t block_ticks = pdMS_TO_TICKS(pl_cfg.block_ms);
+        const pipeline_policy_t feature_policy =
+                pl_cfg.feature_policy == PIPELINE_BLOCK ? PIPELINE_DROP_NEWEST : pl_cfg.feature_policy;
+
+        while (!stopping.load(std::memory_order_relaxed)) {
+            // at most batch samples per wake: the oldest waited at most batch sample periods
+            const size_t n = imu_sample_ring_drain_burst(batch, pl_cfg.batch, IDLE_TICKS);
+            if (n == 0) {
+                continue;
+            }
+
+            const esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+            const uint32_t blocked_before = store_q.get_stats().blocked_us;
+            pl_stage_begin(c, PIPELINE_PROCESS_CORE);
+
+            for (size_t i = 0; i < n; i++) {
+                behavior_features_t fv;
+                if (pl_cfg.features_enabled && engine.push(batch[i], fv)) {
+                    feature_q.push(fv, feature_policy, 0);
+                }
+                imu_compact_sample_t rec;
+                imu_compact_pack(batch[i], rec);
+                store_q.push(rec, pl_cfg.store_policy, block_ticks);
+            }
+            if (pl_cfg.on_batch != nullptr) {
+                pl_cfg.on_batch(batch, n);
+            }
+
+            pl_raise(c.latency_max_us, pl_age_us(batch[0].timestamp_us));
+            pl_stage_end(c, start, store_q.get_stats().blocked_us - blocked_before, static_cast<uint32_t>(n));
+        }
+        xEventGroupSetBits(events, EVT_PROCESS_IDLE);
+    }
+}
+
+/// @brief Store one record: codec block for the uplink, flash log, then its age
+static void pl_store_record(const imu_compact_sample_t &rec, pl_stage_counters_t &c) {
+    if (pl_cfg.block_sink != nullptr && !encoder.push(rec)) {
+        pl_cfg.block_sink(encoder.block(), encoder.size());
+        encoder.start_block();
+        encoder.push(rec);
+    }
+    if (pl_cfg.flash_log) {
+        flash_log_append(rec);
+    }
+
+    const uint32_t age_us = pl_age_us(rec.timestamp_us);
+    pl_raise(c.latency_max_us, age_us);
+    const uint32_t avg = latency_avg_q4.load(std::memory_order_relaxed);
+    latency_avg_q4.store(avg + static_cast<uint32_t>((static_cast<int32_t>(age_us << 4) - static_cast<int32_t>(avg)) >> 4),
+                         std::memory_order_relaxed);
+    if (age_us > pl_cfg.latency_budget_ms * 1000UL) {
+        pl_add(late, 1);
+    }
+}
+
+static void pipeline_store_task(void *pvParameters) {
+    static imu_compact_sample_t recs[PIPELINE_MAX_BATCH];
+    pl_stage_counters_t &c = counters[PIPELINE_STAGE_STORE];
+
+    while (true) {
+        xEventGroupWaitBits(events, EVT_STORE_RUN, pdTRUE, pdFALSE, portMAX_DELAY);
+        int64_t housekeeping_us = esp_timer_get_time();
+
+        while (true) {
+            // outside the stage's activation: housekeeping time is not STORE's load
+            if (pl_cfg.housekeeping != nullptr) {
+                const int64_t now_us = esp_timer_get_time();
+                if (now_us - housekeeping_us >= pl_cfg.housekeeping_ms * 1000LL) {
+                    housekeeping_us = now_us;
+                    pl_cfg.housekeeping();
+                }
+            }
+
+            const size_t n = store_q.pop(recs, PIPELINE_MAX_BATCH, IDLE_TICKS);
+            if (n == 0) {
+                // PROCESS parks first, whatever it queued before that is stored before STORE parks
+                if (stopping.load(std::memory_order_relaxed) && (xEventGroupGetBits(events) & EVT_PROCESS_IDLE)) {
+                    break;
+                }
+                continue;
+            }
+
+            const esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+            pl_stage_begin(c, PIPELINE_PROCESS_CORE);
+            for (size_t i = 0; i < n; i++) {
+                pl_store_record(recs[i], c);
+            }
+            pl_stage_end(c, start, 0, static_cast<uint32_t>(n));
+        }
+
+        if (pl_cfg.block_sink != nullptr && encoder.samples() != 0) {
+            pl_cfg.block_sink(encoder.block(), encoder.size());
+            encoder.start_block();
+        }
+        if (pl_cfg.flash_log) {
+            flash_log_sync();
+        }
+        xEventGroupSetBits(events, EVT_STORE_IDLE);
+    }
+}
+
+/// @brief Undo a pipeline_start() that got past the probe subscription, the tasks stay parked
+static void pl_start_failed() {
+    xEventGroupClearBits(events, EVT_PROCESS_RUN | EVT_STORE_RUN | EVT_INGEST_SEEN);
+    imu_unsubscribe(probe_handle);
+    probe_handle = -1;
+}
+
+bool pipeline_start(const pipeline_config_t &config) {
+    if (running.load(std::memory_order_relaxed)) {
+        ESP_LOGE(TAG, "Pipeline already running");
+        return false;
+    }
+    if (config.batch == 0 || config.batch > PIPELINE_MAX_BATCH) {
+        ESP_LOGE(TAG, "batch must be 1 to %d samples", PIPELINE_MAX_BATCH);
+        return false;
+    }
+    if (config.process_priority <= config.store_priority) {
+        ESP_LOGE(TAG, "PROCESS priority (%u) must be above STORE (%u)", config.process_priority, config.store_priority);
+        return false;
+    }
+    if (config.features_enabled && !engine.configure(config.features)) {
+        ESP_LOGE(TAG, "Invalid feature engine configuration");
+        return false;
+    }
+    if (config.housekeeping != nullptr && config.housekeeping_ms == 0) {
+        ESP_LOGE(TAG, "housekeeping period must be non zero");
+        return false;
+    }
+
+    if (events == nullptr) {
+        events = xEventGroupCreateStatic(&event_buf);
+        if (events == nullptr) {
+            ESP_LOGE(TAG, "Failed to create pipeline event group");
+            return false;
+        }
+    }
+
+    pl_cfg = config;
+    store_q.init(events, EVT_STORE_DATA, EVT_STORE_SPACE);
+    feature_q.init(events, EVT_FEATURE_DATA, EVT_FEATURE_SPACE);
+    encoder.start_block();
+
+    xEventGroupClearBits(events, EVT_INGEST_SEEN);
+    ingest_seen.store(false, std::memory_order_relaxed);
+    imu_sub_cfg_t probe;
+    probe.report_mask = ~0ULL;
+    probe.fn = pl_ingest_probe;
+    probe.decimation = PROBE_DECIMATION;
+    probe_handle = imu_subscribe(probe);
+    if (probe_handle < 0) {
+        ESP_LOGE(TAG, "No subscription slot for the ingest probe");
+        return false;
+    }
+    if (!imu_sample_ring_start()) {
+        ESP_LOGE(TAG, "Failed to start the sample ring");
+        pl_start_failed();
+        return false;
+    }
+    if (!pl_check_ingest_core(config.ingest_check_ms)) {
+        pl_start_failed();
+        return false;
+    }
+
+    // each task is created once and parks on its run bit, a retry after a failure only creates what is missing
+    if (process_task == nullptr) {
+        process_task = xTaskCreateStaticPinnedToCore(pipeline_process_task, "pl_process", PIPELINE_TASK_STACK, nullptr,
+                                                     config.process_priority, process_stack, &process_buf,
+                                                     PIPELINE_PROCESS_CORE);
+        if (process_task == nullptr) {
+            ESP_LOGE(TAG, "Failed to create the PROCESS task");
+            pl_start_failed();
+            return false;
+        }
+    }
+    if (store_task == nullptr) {
+        store_task = xTaskCreateStaticPinnedToCore(pipeline_store_task, "pl_store", PIPELINE_TASK_STACK, nullptr,
+                                                   config.store_priority, store_stack, &store_buf,
+                                                   PIPELINE_PROCESS_CORE);
+        if (store_task == nullptr) {
+            ESP_LOGE(TAG, "Failed to create the STORE task");
+            pl_start_failed();
+            return false;
+        }
+    }
+
+    pipeline_reset_stats();
+    xEventGroupClearBits(events, EVT_PROCESS_IDLE | EVT_STORE_IDLE);
+    stopping.store(false, std::memory_order_relaxed);
+    xEventGroupSetBits(events, EVT_PROCESS_RUN | EVT_STORE_RUN);
+    running.store(true, std::memory_order_relaxed);
+    ESP_LOGI(TAG, "Pipeline started: ingest core %d, process core %d, batch %u", PIPELINE_INGEST_CORE,
+             PIPELINE_PROCESS_CORE, static_cast<unsigned>(config.batch));
+    return true;
+}
+
+void pipeline_stop() {
+    if (!running.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // the run bits stay as they are: a task that has not taken its bit yet wakes on it and parks
+    stopping.store(true, std::memory_order_relaxed);
+    xEventGroupWaitBits(events, EVT_PROCESS_IDLE | EVT_STORE_IDLE, pdFALSE, pdTRUE, portMAX_DELAY);
+
+    imu_unsubscribe(probe_handle);
+    probe_handle = -1;
+    running.store(false, std::memory_order_relaxed);
+    ESP_LOGI(TAG, "Pipeline stopped");
+}
+
+bool pipeline_running() {
+    return running.load(std::memory_order_relaxed);
+}
+
+TaskHandle_t pipeline_get_process_task() {
+    return process_task;
+}
+
+size_t pipeline_pop_features(behavior_features_t *out, size_t max, TickType_t ticks_to_wait) {
+    if (out == nullptr || max == 0 || events == nullptr) {
+        return 0;
+    }
+    return feature_q.pop(out, max, ticks_to_wait);
+}
+
+pipeline_stats_t pipeline_get_stats() {
+    pipeline_stats_t stats = {};
+    for (int s = 0; s < PIPELINE_STAGE_COUNT; s++) {
+        const pl_stage_counters_t &c = counters[s];
+        pipeline_stage_stats_t &out = stats.stage[s];
+        if (c.reset.load(std::memory_order_relaxed)) {
+            // requested but not applied yet: the stage has not run since
+            out.core = -1;
+            continue;
+        }
+        out.items = c.items.load(std::memory_order_relaxed);
+        out.busy_us = c.busy_us.load(std::memory_order_relaxed);
+        out.max_run_us = c.max_run_us.load(std::memory_order_relaxed);
+        out.latency_max_us = c.latency_max_us.load(std::memory_order_relaxed);
+        out.misplaced = c.misplaced.load(std::memory_order_relaxed);
+        out.core = static_cast<int8_t>(c.core.load(std::memory_order_relaxed));
+    }
+
+    // the ring is the INGEST -> PROCESS queue, the callback's own counters are the driver's
+    const imu_ring_stats_t ring = imu_sample_ring_get_stats();
+    pipeline_queue_stats_t ring_q;
+    ring_q.depth = ring.pushed > ring.popped ? ring.pushed - ring.popped : 0;
+    ring_q.high_water = ring.high_water;
+    ring_q.capacity = ring.capacity;
+    ring_q.dropped = ring.overflows;
+    ring_q.blocked_us = 0;
+
+    const uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+    pipeline_stage_stats_t &ingest = stats.stage[PIPELINE_STAGE_INGEST];
+    ingest.input = ring_q;
+    ingest.items = ring.pushed + ring.overflows;
+    ingest.busy_us = (imu_metrics_cb_cycles() - ingest_cycles_base) / ticks_per_us;
+    ingest.latency_max_us = 0;
+    uint32_t cb_max_cycles = 0;
+    for (uint8_t id = 0; id <= SH2_MAX_SENSOR_ID; id++) {
+        imu_rpt_metrics_t m;
+        if (imu_metrics_get(id, m) && m.cb_max_cycles > cb_max_cycles) {
+            cb_max_cycles = m.cb_max_cycles;
+        }
+    }
+    ingest.max_run_us = cb_max_cycles / ticks_per_us;
+
+    stats.stage[PIPELINE_STAGE_PROCESS].input = ring_q;
+    stats.stage[PIPELINE_STAGE_STORE].input = store_q.get_stats();
+    stats.features = feature_q.get_stats();
+    stats.window_us = static_cast<uint32_t>(esp_timer_get_time() - window_start_us);
+    stats.late = late.load(std::memory_order_relaxed);
+    stats.latency_avg_us = latency_avg_q4.load(std::memory_order_relaxed) >> 4;
+    return stats;
+}
+
+void pipeline_reset_stats() {
+    for (pl_stage_counters_t &c : counters) {
+        c.reset.store(true, std::memory_order_relaxed);
+    }
+    store_q.reset_stats();
+    feature_q.reset_stats();
+    imu_sample_ring_reset_stats();
+    imu_metrics_reset();
+    late.store(0, std::memory_order_relaxed);
+    latency_avg_q4.store(0, std::memory_order_relaxed);
+    ingest_cycles_base = imu_metrics_cb_cycles();
+    window_start_us = esp_timer_get_time();
+}
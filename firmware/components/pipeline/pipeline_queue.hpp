@@ -0,0 +1,158 @@
+// pipeline_queue.hpp
+#ifndef PIPELINE_QUEUE_H
+#define PIPELINE_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+#include "pipeline.hpp"
+
+/**
+ * Bounded queue between two pipeline tasks, one producer and one consumer.
+ * Unlike the sample ring this one is locked: dropping the oldest item means
+ * the producer moves the tail, and both sides run in tasks at batch rate, not
+ * per sample in the ingestion callback. Blocking waits sleep on two event
+ * group bits (data, space) rather than polling; a side clears its bit under
+ * the lock before waiting, so a post from the other side cannot be missed.
+ */
+template <typename T, size_t N>
+class pipeline_queue
+{
+    static_assert(N >= 2, "queue needs at least two slots");
+
+    public:
+        /**
+        * @param events: event group the waits sleep on
+        * @param data_bit: posted after every push
+        * @param space_bit: posted after every pop
+        */
+        void init(EventGroupHandle_t events, EventBits_t data_bit, EventBits_t space_bit) {
+            evt = events;
+            data = data_bit;
+            space = space_bit;
+            std::lock_guard<std::mutex> guard(lock);
+            head = 0;
+            tail = 0;
+            reset_stats_locked();
+        }
+
+        /**
+        * @brief Append one item, producer side
+        * @param item: item to copy in
+        * @param policy: what a full queue does
+        * @param block_ticks: longest wait for space with PIPELINE_BLOCK
+        * @return false if the new item was dropped
+        */
+        bool push(const T &item, pipeline_policy_t policy, TickType_t block_ticks) {
+            int64_t wait_start_us = -1;
+            while (true) {
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    if (head - tail >= N && policy == PIPELINE_DROP_OLDEST) {
+                        tail++;
+                        dropped++;
+                    }
+                    if (head - tail < N) {
+                        slots[head % N] = item;
+                        head++;
+                        if (head - tail > high_water) {
+                            high_water = head - tail;
+                        }
+                        if (wait_start_us >= 0) {
+                            blocked_us += static_cast<uint32_t>(esp_timer_get_time() - wait_start_us);
+                        }
+                        break;
+                    }
+                    if (policy != PIPELINE_BLOCK || wait_start_us >= 0) {
+                        dropped++;
+                        if (wait_start_us >= 0) {
+                            blocked_us += static_cast<uint32_t>(esp_timer_get_time() - wait_start_us);
+                        }
+                        return false;
+                    }
+                    xEventGroupClearBits(evt, space);
+                }
+                // one wait: a timeout comes back around and drops, a post retries
+                wait_start_us = esp_timer_get_time();
+                xEventGroupWaitBits(evt, space, pdTRUE, pdFALSE, block_ticks);
+            }
+            xEventGroupSetBits(evt, data);
+            return true;
+        }
+
+        /**
+        * @brief Move up to max items out in FIFO order, consumer side
+        * @param ticks_to_wait: how long to sleep for the first item when empty
+        * @return number of items copied, 0 on timeout
+        */
+        size_t pop(T *out, size_t max, TickType_t ticks_to_wait) {
+            size_t n = pop_now(out, max);
+            if (n != 0 || ticks_to_wait == 0) {
+                return n;
+            }
+
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (head == tail) {
+                    xEventGroupClearBits(evt, data);
+                }
+            }
+            xEventGroupWaitBits(evt, data, pdTRUE, pdFALSE, ticks_to_wait);
+            return pop_now(out, max);
+        }
+
+        pipeline_queue_stats_t get_stats() {
+            std::lock_guard<std::mutex> guard(lock);
+            pipeline_queue_stats_t stats;
+            stats.depth = head - tail;
+            stats.high_water = high_water;
+            stats.capacity = N;
+            stats.dropped = dropped;
+            stats.blocked_us = blocked_us;
+            return stats;
+        }
+
+        void reset_stats() {
+            std::lock_guard<std::mutex> guard(lock);
+            reset_stats_locked();
+        }
+
+    private:
+        size_t pop_now(T *out, size_t max) {
+            size_t n = 0;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                while (n < max && tail != head) {
+                    out[n++] = slots[tail % N];
+                    tail++;
+                }
+            }
+            if (n != 0) {
+                xEventGroupSetBits(evt, space);
+            }
+            return n;
+        }
+
+        void reset_stats_locked() {
+            high_water = head - tail;
+            dropped = 0;
+            blocked_us = 0;
+        }
+
+        std::mutex lock;
+        T slots[N];
+        uint32_t head = 0;
+        uint32_t tail = 0;
+        uint32_t high_water = 0;
+        uint32_t dropped = 0;
+        uint32_t blocked_us = 0;
+        EventGroupHandle_t evt = nullptr;
+        EventBits_t data = 0;
+        EventBits_t space = 0;
+};
+
+#endif /* PIPELINE_QUEUE_H */
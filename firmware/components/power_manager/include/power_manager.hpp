@@ -0,0 +1,104 @@
+// power_manager.hpp
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "imu_driver.hpp"
+
+/**
+ * Motion-gated duty cycle: SLEEP (only sig motion armed, CPU in light sleep)
+ * -> ACTIVE (full report set, processing task running) -> STATIC (processing
+ * suspended, slow linear accel watch) -> SLEEP.
+ */
+
+typedef enum pm_state_t : uint8_t {
+    PM_STATE_SLEEP,
+    PM_STATE_ACTIVE,
+    PM_STATE_STATIC,
+    PM_STATE_COUNT
+} pm_state_t;
+
+/**
+ * @brief Power manager configuration
+ * @param active_rpts: reports enabled while ACTIVE, linear accel is added if missing
+ * @param active_rpt_count: number of entries in active_rpts
+ * @param static_period_us: linear accel period kept while STATIC
+ * @param still_threshold_ms2: |linear accel| below this counts as still
+ * @param motion_threshold_ms2: |linear accel| above this leaves STATIC, keep above still_threshold_ms2 for hysteresis
+ * @param still_time_ms: continuous stillness needed before ACTIVE -> STATIC
+ * @param static_timeout_ms: time spent STATIC before re-arming sig motion and sleeping
+ * @param eval_period_ms: how often motion is evaluated while ACTIVE / STATIC
+ * @param light_sleep: enter ESP32 light sleep in SLEEP, woken by the BNO08x HINT pin
+ * @param processing_task: task suspended outside ACTIVE, may be nullptr
+ * @param on_transition: called after every state change, may be nullptr
+ * @param active_period: asked for each active report on every ACTIVE entry, false keeps the profile's period
+ *                       and a 0 period leaves the report off; lets the rate governor's level win, may be nullptr
+ */
+typedef struct pm_config_t {
+    imu_report_cfg_t *active_rpts = nullptr;
+    size_t active_rpt_count = 0;
+    uint32_t static_period_us = 200000UL;
+    float still_threshold_ms2 = 0.35f;
+    float motion_threshold_ms2 = 0.8f;
+    uint32_t still_time_ms = 5000UL;
+    uint32_t static_timeout_ms = 30000UL;
+    uint32_t eval_period_ms = 100UL;
+    bool light_sleep = true;
+    TaskHandle_t processing_task = nullptr;
+    void (*on_transition)(pm_state_t from, pm_state_t to) = nullptr;
+    bool (*active_period)(uint8_t report_id, uint32_t &period_us) = nullptr;
+} pm_config_t;
+
+/**
+ * @brief Time spent in each state
+ * @param residency_us: accumulated time per state, includes the current visit
+ * @param entries: number of times each state was entered
+ * @param light_sleeps: number of light sleep entries
+ * @param light_sleep_us: time spent inside esp_light_sleep_start()
+ * @param false_wakes: HINT wakes from SLEEP that did not carry sig motion
+ * @param rearm_failures: STATIC -> SLEEP attempts that stayed STATIC because sig motion could not be armed
+ */
+typedef struct pm_stats_t {
+    uint64_t residency_us[PM_STATE_COUNT];
+    uint32_t entries[PM_STATE_COUNT];
+    uint32_t light_sleeps;
+    uint64_t light_sleep_us;
+    uint32_t false_wakes;
+    uint32_t rearm_failures;
+} pm_stats_t;
+
+/**
+* @brief Validate and store the configuration, call before starting pm_task
+* @param config: configuration to copy, active_rpts must stay valid
+* @return false if the thresholds or report list are invalid
+*/
+bool pm_init(const pm_config_t &config);
+
+/**
+* @brief Power manager task, starts ACTIVE and never returns
+* @param pvParameters: unused
+* @note Owns the IMU event loop: sig motion wakes, imu_recover() after a hub reset and imu_hub_check()
+*/
+void pm_task(void *pvParameters);
+
+/**
+* @brief Get the current power state
+* @return the current state
+*/
+pm_state_t pm_get_state();
+
+/**
+* @brief Get the residency counters, the current visit is accounted up to now
+* @return stats struct
+*/
+pm_stats_t pm_get_stats();
+
+void pm_reset_stats();
+
+const char *pm_state_to_str(pm_state_t state);
+
+#endif /* POWER_MANAGER_H */
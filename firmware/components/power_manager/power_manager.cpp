@@ -0,0 +1,290 @@
+#include <atomic>
+#include <cmath>
+
+#include "power_manager.hpp"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+
+static constexpr const char *TAG = "POWER_MANAGER";
+
+static pm_config_t pm_cfg;
+static imu_report_cfg_t active_profile[SH2_MAX_SENSOR_ID + 1];
+static size_t active_profile_count = 0;
+static std::atomic<pm_state_t> pm_state{PM_STATE_ACTIVE};
+static pm_stats_t pm_stats = {};
+static int64_t state_enter_us = 0;
+static int64_t hub_check_us = 0;
+
+const char *pm_state_to_str(pm_state_t state) {
+    switch (state) {
+        case PM_STATE_SLEEP:
+            return "SLEEP";
+        case PM_STATE_ACTIVE:
+            return "ACTIVE";
+        case PM_STATE_STATIC:
+            return "STATIC";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+bool pm_init(const pm_config_t &config) {
+    if (config.active_rpts == nullptr || config.active_rpt_count == 0 || config.active_rpt_count > SH2_MAX_SENSOR_ID) {
+        ESP_LOGE(TAG, "No active report profile");
+        return false;
+    }
+
+    if (config.still_threshold_ms2 >= config.motion_threshold_ms2) {
+        ESP_LOGE(TAG, "still threshold (%.2f) must be below motion threshold (%.2f)",
+                 config.still_threshold_ms2, config.motion_threshold_ms2);
+        return false;
+    }
+
+    if (config.eval_period_ms == 0) {
+        ESP_LOGE(TAG, "eval period must be non zero");
+        return false;
+    }
+
+    if (!imu_events_start() || !imu_latest_start()) {
+        return false;
+    }
+
+    pm_cfg = config;
+
+    // motion is judged from linear accel, keep it in the profile at the profile's own rate
+    active_profile_count = 0;
+    bool has_linear_accel = false;
+    for (size_t i = 0; i < config.active_rpt_count; i++) {
+        active_profile[active_profile_count++] = config.active_rpts[i];
+        has_linear_accel |= (config.active_rpts[i].report_id == SH2_LINEAR_ACCELERATION);
+    }
+    if (!has_linear_accel) {
+        active_profile[active_profile_count++] = {SH2_LINEAR_ACCELERATION, config.active_rpts[0].period_us};
+    }
+
+    pm_reset_stats();
+    return true;
+}
+
+pm_state_t pm_get_state() {
+    return pm_state.load(std::memory_order_relaxed);
+}
+
+pm_stats_t pm_get_stats() {
+    pm_stats_t stats = pm_stats;
+    stats.residency_us[pm_get_state()] += static_cast<uint64_t>(esp_timer_get_time() - state_enter_us);
+    return stats;
+}
+
+void pm_reset_stats() {
+    pm_stats = {};
+    state_enter_us = esp_timer_get_time();
+}
+
+/**
+* @brief Magnitude of the latest linear accel sample, read from the seqlock cache the ingest callback writes
+* @param magnitude_ms2: set to |linear accel| when a sample exists
+* @return false if linear accel has not reported yet, the caller keeps its current state
+*/
+static bool pm_linear_accel_magnitude(float &magnitude_ms2) {
+    imu_sample_t sample;
+    if (imu_latest_read(SH2_LINEAR_ACCELERATION, sample) == 0) {
+        return false;
+    }
+    const float x = sample.data.vec.x;
+    const float y = sample.data.vec.y;
+    const float z = sample.data.vec.z;
+    magnitude_ms2 = std::sqrt(x * x + y * y + z * z);
+    return true;
+}
+
+/**
+ * Every state waits here. A hub reset is recovered whatever the state, the
+ * replay restores the reports the state last applied (sig motion in SLEEP),
+ * and the hub is checked for silence every IMU_HUB_SILENT_MS.
+ */
+static uint32_t pm_wait(uint32_t events, TickType_t ticks) {
+    const uint32_t posted = imu_wait_events(events | IMU_EVT_HUB_RESET, ticks);
+    if (posted & IMU_EVT_HUB_RESET) {
+        imu_recover();
+    }
+
+    const int64_t now_us = esp_timer_get_time();
+    if (now_us - hub_check_us >= IMU_HUB_SILENT_MS * 1000LL) {
+        hub_check_us = now_us;
+        imu_hub_check();
+    }
+    return posted & events;
+}
+
+static void pm_enter_active() {
+    // one set-feature per report: the governed periods go out with the profile, not after it
+    imu_report_cfg_t profile[SH2_MAX_SENSOR_ID + 1];
+    size_t count = 0;
+    for (size_t i = 0; i < active_profile_count; i++) {
+        imu_report_cfg_t rpt = active_profile[i];
+        if (pm_cfg.active_period != nullptr) {
+            pm_cfg.active_period(rpt.report_id, rpt.period_us);
+        }
+        if (rpt.period_us != 0) {
+            profile[count++] = rpt;
+        }
+    }
+    imu_apply_rpt_profile(profile, count);
+
+    if (pm_cfg.processing_task != nullptr) {
+        vTaskResume(pm_cfg.processing_task);
+    }
+}
+
+static void pm_apply_static_profile() {
+    // linear accel only changes period, it keeps streaming through the switch
+    imu_report_cfg_t static_profile[] = {{SH2_LINEAR_ACCELERATION, pm_cfg.static_period_us}};
+    imu_apply_rpt_profile(static_profile, 1);
+}
+
+static void pm_enter_static() {
+    if (pm_cfg.processing_task != nullptr) {
+        vTaskSuspend(pm_cfg.processing_task);
+    }
+    pm_apply_static_profile();
+}
+
+/// @return false if sig motion could not be armed, the STATIC watch is restored and nothing changed
+static bool pm_enter_sleep() {
+    imu_apply_rpt_profile(nullptr, 0);
+    // drop a stale post so only motion seen after arming wakes us
+    imu_wait_events(IMU_EVT_SIG_MOTION, 0);
+    if (!imu_rearm_sig_motion()) {
+        // asleep without sig motion nothing would ever wake us
+        ESP_LOGW(TAG, "Sig motion not armed, staying STATIC");
+        pm_stats.rearm_failures++;
+        pm_apply_static_profile();
+        return false;
+    }
+    return true;
+}
+
+/// @return false if the state could not be entered, the current one is kept
+static bool pm_transition(pm_state_t to) {
+    const pm_state_t from = pm_get_state();
+
+    switch (to) {
+        case PM_STATE_ACTIVE:
+            pm_enter_active();
+            break;
+        case PM_STATE_STATIC:
+            pm_enter_static();
+            break;
+        case PM_STATE_SLEEP:
+            if (!pm_enter_sleep()) {
+                return false;
+            }
+            break;
+        default:
+            break;
+    }
+
+    const int64_t now_us = esp_timer_get_time();
+    pm_stats.residency_us[from] += static_cast<uint64_t>(now_us - state_enter_us);
+    pm_stats.entries[to]++;
+    state_enter_us = now_us;
+    pm_state.store(to, std::memory_order_relaxed);
+    ESP_LOGI(TAG, "%s -> %s", pm_state_to_str(from), pm_state_to_str(to));
+
+    if (pm_cfg.on_transition != nullptr) {
+        pm_cfg.on_transition(from, to);
+    }
+    return true;
+}
+
+/**
+ * One light sleep until the HINT pin goes low. The only report armed is sig
+ * motion, so the hub has nothing else to interrupt us for.
+ * @return true if HINT woke us
+ */
+static bool pm_light_sleep() {
+    const gpio_num_t int_pin = static_cast<gpio_num_t>(imu_get_int_pin());
+
+    gpio_wakeup_enable(int_pin, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+
+    bool hint_wake = false;
+    const int64_t sleep_start_us = esp_timer_get_time();
+    if (esp_light_sleep_start() == ESP_OK) {
+        pm_stats.light_sleeps++;
+        pm_stats.light_sleep_us += static_cast<uint64_t>(esp_timer_get_time() - sleep_start_us);
+        hint_wake = (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO);
+    }
+
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO);
+    gpio_wakeup_disable(int_pin);
+    return hint_wake;
+}
+
+void pm_task(void *pvParameters) {
+    const TickType_t eval_ticks = pdMS_TO_TICKS(pm_cfg.eval_period_ms);
+    // nothing to evaluate while asleep, wake only for sig motion, a reset or the silence check
+    const TickType_t sleep_ticks = pdMS_TO_TICKS(IMU_HUB_SILENT_MS);
+    uint32_t still_ms = 0;
+    uint32_t static_ms = 0;
+
+    pm_stats.entries[PM_STATE_ACTIVE]++;
+    state_enter_us = esp_timer_get_time();
+    hub_check_us = state_enter_us;
+    pm_state.store(PM_STATE_ACTIVE, std::memory_order_relaxed);
+    pm_enter_active();
+
+    while (1) {
+        switch (pm_get_state()) {
+            case PM_STATE_ACTIVE: {
+                pm_wait(0, eval_ticks);
+                float magnitude_ms2;
+                if (!pm_linear_accel_magnitude(magnitude_ms2)) {
+                    break;
+                }
+                still_ms = (magnitude_ms2 < pm_cfg.still_threshold_ms2) ? still_ms + pm_cfg.eval_period_ms : 0;
+                if (still_ms >= pm_cfg.still_time_ms) {
+                    still_ms = 0;
+                    static_ms = 0;
+                    pm_transition(PM_STATE_STATIC);
+                }
+                break;
+            }
+
+            case PM_STATE_STATIC: {
+                pm_wait(0, eval_ticks);
+                float magnitude_ms2;
+                if (pm_linear_accel_magnitude(magnitude_ms2) && magnitude_ms2 > pm_cfg.motion_threshold_ms2) {
+                    pm_transition(PM_STATE_ACTIVE);
+                    break;
+                }
+
+                // a failed re-arm keeps static_ms past the timeout, the next evaluation tries again
+                static_ms += pm_cfg.eval_period_ms;
+                if (static_ms >= pm_cfg.static_timeout_ms) {
+                    pm_transition(PM_STATE_SLEEP);
+                }
+                break;
+            }
+
+            case PM_STATE_SLEEP: {
+                const bool hint_wake = pm_cfg.light_sleep && pm_light_sleep();
+
+                if (pm_wait(IMU_EVT_SIG_MOTION, sleep_ticks) & IMU_EVT_SIG_MOTION) {
+                    ESP_LOGI(TAG, "Motion detected, wake latency %lu us", (unsigned long)imu_get_wake_stats().last_us);
+                    pm_transition(PM_STATE_ACTIVE);
+                } else if (hint_wake) {
+                    pm_stats.false_wakes++;
+                }
+                break;
+            }
+
+            default:
+                pm_transition(PM_STATE_ACTIVE);
+                break;
+        }
+    }
+}
@@ -0,0 +1,148 @@
+// rate_governor.hpp
+#ifndef RATE_GOVERNOR_H
+#define RATE_GOVERNOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "imu_driver.hpp"
+
+/**
+ * Activity driven report rates: REST (slow) -> CALM -> VIGOROUS (fast). The
+ * level is chosen from the variance of |accel| the governor measures itself
+ * and from the hub's activity and stability classifiers, and every governed
+ * report is retuned to that level's period in the rate table. Reports not in
+ * the table are left alone.
+ *
+ * Moving up takes up_dwell_ms and either source asking for it, so the start
+ * of a run is sampled fast. Moving down takes down_dwell_ms with both
+ * sources agreeing, and a variance must fall hysteresis below a threshold to
+ * count as under it, so a pet shifting in its sleep does not thrash the hub.
+ *
+ * No task of its own: the task draining the sample ring passes every batch to
+ * rg_feed(), and time is sample time. Each change is logged through binlog
+ * with the inputs that caused it, for tuning the thresholds offline. The
+ * state is kept under one lock, so the stats and rg_reapply() can be used
+ * from any other task.
+ */
+
+typedef enum rg_level_t : uint8_t {
+    RG_LEVEL_REST,
+    RG_LEVEL_CALM,
+    RG_LEVEL_VIGOROUS,
+    RG_LEVEL_COUNT
+} rg_level_t;
+
+#ifndef RG_MAX_RPTS
+#define RG_MAX_RPTS 8              ///< governed reports
+#endif
+
+/**
+ * @brief Periods of one governed report
+ * @param report_id: the report
+ * @param period_us: per rg_level_t, 0 disables the report at that level
+ */
+typedef struct rg_rpt_rates_t {
+    uint8_t report_id;
+    uint32_t period_us[RG_LEVEL_COUNT];
+} rg_rpt_rates_t;
+
+/**
+ * @brief Rate governor configuration
+ * @param rates: governed reports, up to RG_MAX_RPTS, copied
+ * @param rate_count: number of entries in rates
+ * @param accel_rpt: report the variance is measured on, must be in rates and enabled at every level
+ * @param calm_var: variance of |accel| over one window, (m/s^2)^2, at or above which CALM is wanted
+ * @param vigorous_var: same for VIGOROUS, above calm_var
+ * @param hysteresis: fraction below a threshold the variance must fall to count as under it, 0..1
+ * @param min_confidence: activity classifier confidence (percent) below which its output is ignored
+ * @param classifier_timeout_ms: classifier outputs older than this (sample time) are ignored
+ * @param eval_period_ms: variance window, the level is decided once per window
+ * @param up_dwell_ms: how long a higher level must be wanted before moving up
+ * @param down_dwell_ms: how long a lower level must be wanted before moving down
+ * @param initial: level applied by rg_init()
+ * @param on_change: called from rg_feed() after every change, may be nullptr
+ */
+typedef struct rg_config_t {
+    const rg_rpt_rates_t *rates = nullptr;
+    size_t rate_count = 0;
+    uint8_t accel_rpt = SH2_ACCELEROMETER;
+    float calm_var = 0.05f;
+    float vigorous_var = 12.0f;
+    float hysteresis = 0.3f;
+    uint8_t min_confidence = 50;
+    uint32_t classifier_timeout_ms = 5000UL;
+    uint32_t eval_period_ms = 500UL;
+    uint32_t up_dwell_ms = 1000UL;
+    uint32_t down_dwell_ms = 10000UL;
+    rg_level_t initial = RG_LEVEL_CALM;
+    void (*on_change)(rg_level_t from, rg_level_t to) = nullptr;
+} rg_config_t;
+
+/**
+ * @brief Governor counters
+ * @param residency_us: sample time spent at each level, up to the last fed sample
+ * @param entries: number of times each level was entered
+ * @param windows: variance windows evaluated
+ * @param held: windows that wanted another level but were held by the dwell times
+ * @param commands: set-feature commands sent, unchanged reports send none
+ * @param failed: commands the driver rejected
+ */
+typedef struct rg_stats_t {
+    uint64_t residency_us[RG_LEVEL_COUNT];
+    uint32_t entries[RG_LEVEL_COUNT];
+    uint32_t windows;
+    uint32_t held;
+    uint32_t commands;
+    uint32_t failed;
+} rg_stats_t;
+
+/**
+* @brief Validate and store the configuration and apply the initial level's rates
+* @param config: configuration to copy
+* @return false if the table or thresholds are invalid
+*/
+bool rg_init(const rg_config_t &config);
+
+/**
+* @brief Pass drained samples in order, call from the single task draining the ring
+* @param samples: drained samples, ungoverned reports included (the classifiers are read from here)
+* @param count: number of samples
+* @return true if the level changed, the new rates are already applied
+*/
+bool rg_feed(const imu_sample_t *samples, size_t count);
+
+/**
+* @brief Send the current level's rates again, any task
+* @note Call after something else retuned governed reports
+*/
+void rg_reapply();
+
+/**
+* @brief Period of a governed report at the current level, any task
+* @param report_id: the report
+* @param period_us: set to the level's period, 0 if the report is off at this level
+* @return false if the report is not governed, period_us is left alone
+* @note Matches pm_config_t::active_period, so ACTIVE entries apply the governed periods directly
+*/
+bool rg_get_period(uint8_t report_id, uint32_t &period_us);
+
+/**
+* @brief Get the current level, any task
+* @return the current level
+*/
+rg_level_t rg_get_level();
+
+/**
+* @brief Variance of |accel| over the last complete window
+* @return (m/s^2)^2, 0 before the first window
+*/
+float rg_get_variance();
+
+rg_stats_t rg_get_stats();
+
+void rg_reset_stats();
+
+const char *rg_level_to_str(rg_level_t level);
+
+#endif /* RATE_GOVERNOR_H */
@@ -0,0 +1,371 @@
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+#include "rate_governor.hpp"
+#include "binlog.hpp"
+#include "esp_log.h"
+
+static constexpr const char *TAG = "RATE_GOVERNOR";
+
+// rg_feed() runs on the draining task, rg_get_stats() and rg_reapply() on any other: all state below under rg_lock
+static std::mutex rg_lock;
+static rg_config_t rg_cfg;
+static rg_rpt_rates_t rg_rates[RG_MAX_RPTS];
+static std::atomic<rg_level_t> rg_level{RG_LEVEL_CALM};
+static std::atomic<float> rg_variance{0.0f};
+static rg_stats_t rg_stats = {};
+
+// variance window over |accel|, sums taken around the first sample so float does not cancel
+static bool win_open = false;
+static uint32_t win_start_us = 0;
+static uint32_t win_n = 0;
+static float win_shift = 0.0f;
+static float win_sum = 0.0f;
+static float win_sum_sq = 0.0f;
+
+// latest classifier outputs seen in the stream
+static bool have_activity = false;
+static uint32_t activity_t_us = 0;
+static uint8_t activity_state = 0;
+static uint8_t activity_confidence = 0;
+static bool have_stability = false;
+static uint32_t stability_t_us = 0;
+static uint32_t stability_state = 0;
+
+// a change wanted but not yet made: direction (+1 up, -1 down, 0 none) and how long
+static int pending_dir = 0;
+static uint32_t pending_us = 0;
+
+static uint32_t last_t_us = 0;
+static uint32_t level_enter_us = 0;
+static bool have_time = false;
+
+const char *rg_level_to_str(rg_level_t level) {
+    switch (level) {
+        case RG_LEVEL_REST:
+            return "REST";
+        case RG_LEVEL_CALM:
+            return "CALM";
+        case RG_LEVEL_VIGOROUS:
+            return "VIGOROUS";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+/// @brief Send the set-feature commands that move every governed report to the level's period
+static void rg_apply(rg_level_t level) {
+    for (size_t i = 0; i < rg_cfg.rate_count; i++) {
+        const rg_rpt_rates_t &r = rg_rates[i];
+        const uint32_t period_us = r.period_us[level];
+        imu_report_cfg_t live;
+        const bool on = imu_get_rpt_cfg(r.report_id, live);
+
+        bool ok = true;
+        if (period_us == 0) {
+            if (!on) {
+                continue;
+            }
+            ok = imu_disable_rpt(r.report_id);
+        } else if (!on || live.period_us != period_us) {
+            // keep the live config (batching, sensitivity), only the period is governed
+            ok = on ? imu_enable_rpt(r.report_id, period_us, live.config) : imu_enable_rpt(r.report_id, period_us);
+        } else {
+            continue;
+        }
+
+        rg_stats.commands++;
+        if (!ok) {
+            rg_stats.failed++;
+            ESP_LOGW(TAG, "Report 0x%02X: set-feature for %s failed", r.report_id, rg_level_to_str(level));
+        }
+    }
+}
+
+bool rg_init(const rg_config_t &config) {
+    if (config.rates == nullptr || config.rate_count == 0 || config.rate_count > RG_MAX_RPTS) {
+        ESP_LOGE(TAG, "Rate table must have 1 to %d reports", RG_MAX_RPTS);
+        return false;
+    }
+
+    bool has_accel = false;
+    for (size_t i = 0; i < config.rate_count; i++) {
+        const rg_rpt_rates_t &r = config.rates[i];
+        if (r.report_id == 0 || r.report_id > SH2_MAX_SENSOR_ID) {
+            ESP_LOGE(TAG, "Invalid report 0x%02X in rate table", r.report_id);
+            return false;
+        }
+        for (size_t j = 0; j < i; j++) {
+            if (config.rates[j].report_id == r.report_id) {
+                ESP_LOGE(TAG, "Report 0x%02X listed twice", r.report_id);
+                return false;
+            }
+        }
+        if (r.report_id == config.accel_rpt) {
+            has_accel = r.period_us[RG_LEVEL_REST] != 0 && r.period_us[RG_LEVEL_CALM] != 0 &&
+                        r.period_us[RG_LEVEL_VIGOROUS] != 0;
+        }
+    }
+    if (!has_accel) {
+        ESP_LOGE(TAG, "Accel report 0x%02X must be governed and on at every level", config.accel_rpt);
+        return false;
+    }
+
+    if (!(config.calm_var > 0.0f) || !(config.vigorous_var > config.calm_var)) {
+        ESP_LOGE(TAG, "calm variance (%.3f) must be positive and below vigorous variance (%.3f)",
+                 config.calm_var, config.vigorous_var);
+        return false;
+    }
+
+    if (!(config.hysteresis >= 0.0f && config.hysteresis < 1.0f)) {
+        ESP_LOGE(TAG, "hysteresis (%.2f) must be in [0, 1)", config.hysteresis);
+        return false;
+    }
+
+    if (config.eval_period_ms == 0 || config.initial >= RG_LEVEL_COUNT) {
+        ESP_LOGE(TAG, "eval period must be non zero and the initial level valid");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(rg_lock);
+    rg_cfg = config;
+    for (size_t i = 0; i < config.rate_count; i++) {
+        rg_rates[i] = config.rates[i];
+    }
+    rg_cfg.rates = rg_rates;
+
+    win_open = false;
+    have_activity = false;
+    have_stability = false;
+    have_time = false;
+    pending_dir = 0;
+    pending_us = 0;
+    rg_variance.store(0.0f, std::memory_order_relaxed);
+
+    rg_stats = {};
+    level_enter_us = last_t_us;
+    rg_level.store(config.initial, std::memory_order_relaxed);
+    rg_stats.entries[config.initial]++;
+    rg_apply(config.initial);
+    return true;
+}
+
+rg_level_t rg_get_level() {
+    return rg_level.load(std::memory_order_relaxed);
+}
+
+float rg_get_variance() {
+    return rg_variance.load(std::memory_order_relaxed);
+}
+
+void rg_reapply() {
+    std::lock_guard<std::mutex> guard(rg_lock);
+    if (rg_cfg.rates != nullptr) {
+        rg_apply(rg_get_level());
+    }
+}
+
+bool rg_get_period(uint8_t report_id, uint32_t &period_us) {
+    std::lock_guard<std::mutex> guard(rg_lock);
+    for (size_t i = 0; i < rg_cfg.rate_count; i++) {
+        if (rg_rates[i].report_id == report_id) {
+            period_us = rg_rates[i].period_us[rg_get_level()];
+            return true;
+        }
+    }
+    return false;
+}
+
+rg_stats_t rg_get_stats() {
+    std::lock_guard<std::mutex> guard(rg_lock);
+    rg_stats_t stats = rg_stats;
+    if (have_time) {
+        stats.residency_us[rg_get_level()] += last_t_us - level_enter_us;
+    }
+    return stats;
+}
+
+void rg_reset_stats() {
+    std::lock_guard<std::mutex> guard(rg_lock);
+    rg_stats = {};
+    level_enter_us = last_t_us;
+}
+
+/// @brief Whether a classifier output at t_us is still current at now_us
+static bool rg_fresh(uint32_t t_us, uint32_t now_us) {
+    return static_cast<int32_t>(now_us - t_us) <= static_cast<int32_t>(rg_cfg.classifier_timeout_ms * 1000UL);
+}
+
+/// @brief Level the variance asks for, thresholds crossed downwards only hysteresis below them
+static rg_level_t rg_variance_level(float var, rg_level_t current) {
+    const float keep = 1.0f - rg_cfg.hysteresis;
+    if (var >= rg_cfg.vigorous_var || (current == RG_LEVEL_VIGOROUS && var >= rg_cfg.vigorous_var * keep)) {
+        return RG_LEVEL_VIGOROUS;
+    }
+    if (var >= rg_cfg.calm_var || (current != RG_LEVEL_REST && var >= rg_cfg.calm_var * keep)) {
+        return RG_LEVEL_CALM;
+    }
+    return RG_LEVEL_REST;
+}
+
+/// @brief Level the activity classifier asks for, RG_LEVEL_COUNT for no vote
+static rg_level_t rg_activity_level(uint32_t now_us) {
+    if (!have_activity || activity_confidence < rg_cfg.min_confidence || !rg_fresh(activity_t_us, now_us)) {
+        return RG_LEVEL_COUNT;
+    }
+    switch (static_cast<BNO08xActivity>(activity_state)) {
+        case BNO08xActivity::STILL:
+            return RG_LEVEL_REST;
+        case BNO08xActivity::ON_FOOT:
+        case BNO08xActivity::WALKING:
+        case BNO08xActivity::ON_STAIRS:
+        case BNO08xActivity::ON_BICYCLE:
+            return RG_LEVEL_CALM;
+        case BNO08xActivity::RUNNING:
+            return RG_LEVEL_VIGOROUS;
+        default:
+            // unknown, tilting, in vehicle: nothing about how fast the pet moves
+            return RG_LEVEL_COUNT;
+    }
+}
+
+static bool rg_stationary(uint32_t now_us) {
+    const BNO08xStability s = static_cast<BNO08xStability>(stability_state);
+    return have_stability && rg_fresh(stability_t_us, now_us) &&
+           (s == BNO08xStability::ON_TABLE || s == BNO08xStability::STATIONARY);
+}
+
+static void rg_change(rg_level_t to, uint32_t now_us, float var) {
+    const rg_level_t from = rg_get_level();
+
+    rg_stats.residency_us[from] += now_us - level_enter_us;
+    rg_stats.entries[to]++;
+    level_enter_us = now_us;
+
+    rg_apply(to);
+    rg_level.store(to, std::memory_order_relaxed);
+    pending_dir = 0;
+    pending_us = 0;
+
+    // raw inputs rather than a verdict, so thresholds can be re-tuned against the log
+    BINLOG_I(TAG, "Level %u -> %u: var %.3f, activity %u (%u%%), stability %lu", from, to, var,
+             have_activity ? activity_state : 0, have_activity ? activity_confidence : 0,
+             have_stability ? stability_state : 0);
+}
+
+/// @brief Decide the level at the end of one variance window
+static bool rg_evaluate(uint32_t now_us, uint32_t window_us) {
+    const rg_level_t current = rg_get_level();
+    rg_stats.windows++;
+
+    rg_level_t wanted = current;
+    float var = rg_get_variance();
+    if (win_n >= 2) {
+        const float mean = win_sum / win_n;
+        var = std::fmax(win_sum_sq / win_n - mean * mean, 0.0f);
+        rg_variance.store(var, std::memory_order_relaxed);
+        wanted = rg_variance_level(var, current);
+    }
+
+    // up on either source, down only when both agree: the higher vote wins
+    const rg_level_t activity = rg_activity_level(now_us);
+    if (activity != RG_LEVEL_COUNT && activity > wanted) {
+        wanted = activity;
+    }
+    // the hub's stationary detector outranks a variance sitting in the CALM band
+    if (wanted == RG_LEVEL_CALM && (activity == RG_LEVEL_COUNT || activity == RG_LEVEL_REST) &&
+        rg_stationary(now_us)) {
+        wanted = RG_LEVEL_REST;
+    }
+
+    if (wanted == current) {
+        pending_dir = 0;
+        pending_us = 0;
+        return false;
+    }
+
+    const int dir = wanted > current ? 1 : -1;
+    pending_us = dir == pending_dir ? pending_us + window_us : window_us;
+    pending_dir = dir;
+    if (pending_us < (dir > 0 ? rg_cfg.up_dwell_ms : rg_cfg.down_dwell_ms) * 1000ULL) {
+        rg_stats.held++;
+        return false;
+    }
+
+    rg_change(wanted, now_us, var);
+    return true;
+}
+
+/// @brief Take one sample into the classifier state or the variance window, rg_lock held
+static bool rg_feed_one(const imu_sample_t &s) {
+    if (s.report_id == SH2_PERSONAL_ACTIVITY_CLASSIFIER) {
+        have_activity = true;
+        activity_t_us = s.timestamp_us;
+        activity_state = s.data.activity.state;
+        activity_confidence = s.data.activity.confidence;
+        return false;
+    }
+    if (s.report_id == SH2_STABILITY_CLASSIFIER) {
+        have_stability = true;
+        stability_t_us = s.timestamp_us;
+        stability_state = s.data.value;
+        return false;
+    }
+    if (s.report_id != rg_cfg.accel_rpt) {
+        return false;
+    }
+
+    const uint32_t t_us = s.timestamp_us;
+    if (!have_time) {
+        have_time = true;
+        level_enter_us = t_us;
+    }
+    last_t_us = t_us;
+
+    bool changed = false;
+    const uint32_t window_us = t_us - win_start_us;
+    if (win_open && window_us >= rg_cfg.eval_period_ms * 1000UL) {
+        changed = rg_evaluate(t_us, window_us);
+        win_open = false;
+    }
+
+    const float mag = std::sqrt(s.data.vec.x * s.data.vec.x + s.data.vec.y * s.data.vec.y +
+                                s.data.vec.z * s.data.vec.z);
+    if (!win_open) {
+        win_open = true;
+        win_start_us = t_us;
+        win_n = 0;
+        win_shift = mag;
+        win_sum = 0.0f;
+        win_sum_sq = 0.0f;
+    }
+    const float d = mag - win_shift;
+    win_n++;
+    win_sum += d;
+    win_sum_sq += d * d;
+    return changed;
+}
+
+bool rg_feed(const imu_sample_t *samples, size_t count) {
+    bool changed = false;
+    for (size_t i = 0; i < count; i++) {
+        // locked per sample so on_change runs unlocked and may call back into the governor
+        rg_level_t from;
+        bool changed_now;
+        void (*on_change)(rg_level_t from, rg_level_t to);
+        {
+            std::lock_guard<std::mutex> guard(rg_lock);
+            from = rg_get_level();
+            changed_now = rg_feed_one(samples[i]);
+            on_change = rg_cfg.on_change;
+        }
+        if (changed_now) {
+            changed = true;
+            if (on_change != nullptr) {
+                on_change(from, rg_get_level());
+            }
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,109 @@
+// bench_util.hpp
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+/**
+ * Shared timing helpers for the host benchmarks. Calls are timed in blocks so the
+ * clock read does not dominate nanosecond scale paths.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace bench
+{
+    using clock_t = std::chrono::steady_clock;
+
+    /// @brief Per-call latency summary in nanoseconds.
+    typedef struct latency_t {
+        double mean_ns = 0.0;
+        double p50_ns = 0.0;
+        double p99_ns = 0.0;
+        double max_ns = 0.0;
+        uint64_t calls = 0;
+    } latency_t;
+
+    inline double elapsed_ns(clock_t::time_point start, clock_t::time_point end)
+    {
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+
+    /// @brief Keep a value alive so the optimizer cannot drop the measured call.
+    template <typename T>
+    inline void do_not_optimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    /**
+     * @brief Time fxn over iterations calls, sampled in blocks of block_sz
+     * @param iterations: total calls, rounded up to a whole block
+     * @param fxn: callable invoked once per call, receives the call index
+     */
+    template <typename Fxn>
+    latency_t measure(uint64_t iterations, Fxn&& fxn, uint32_t block_sz = 64)
+    {
+        std::vector<double> per_call;
+        per_call.reserve(iterations / block_sz + 1);
+
+        double total_ns = 0.0;
+        uint64_t done = 0;
+        while (done < iterations)
+        {
+            auto start = clock_t::now();
+            for (uint32_t i = 0; i < block_sz; i++)
+                fxn(done + i);
+            auto end = clock_t::now();
+
+            double block_ns = elapsed_ns(start, end);
+            total_ns += block_ns;
+            per_call.push_back(block_ns / block_sz);
+            done += block_sz;
+        }
+
+        latency_t lat;
+        lat.calls = done;
+        lat.mean_ns = total_ns / static_cast<double>(done);
+        std::sort(per_call.begin(), per_call.end());
+        lat.p50_ns = per_call[per_call.size() / 2];
+        lat.p99_ns = per_call[(per_call.size() * 99) / 100];
+        lat.max_ns = per_call.back();
+        return lat;
+    }
+
+    inline void print_header(const char* title)
+    {
+        std::printf("\n== %s ==\n", title);
+        std::printf("%-36s %12s %10s %10s %10s %10s\n", "path", "calls", "mean ns", "p50 ns", "p99 ns", "max ns");
+    }
+
+    inline void print_latency(const char* name, const latency_t& lat)
+    {
+        std::printf("%-36s %12llu %10.1f %10.1f %10.1f %10.1f\n", name, static_cast<unsigned long long>(lat.calls),
+                lat.mean_ns, lat.p50_ns, lat.p99_ns, lat.max_ns);
+    }
+
+    /// @brief Parse "--name value" from argv, returns fallback if absent.
+    inline const char* arg_value(int argc, char** argv, const char* name, const char* fallback)
+    {
+        for (int i = 1; i + 1 < argc; i++)
+        {
+            if (std::strcmp(argv[i], name) == 0)
+                return argv[i + 1];
+        }
+        return fallback;
+    }
+
+    inline uint64_t arg_u64(int argc, char** argv, const char* name, uint64_t fallback)
+    {
+        const char* value = arg_value(argc, argv, name, nullptr);
+        return (value != nullptr) ? std::strtoull(value, nullptr, 10) : fallback;
+    }
+} // namespace bench
+
+#endif /* BENCH_UTIL_H */
@@ -0,0 +1,2215 @@
+/**
+ * imu_driver host benchmark: per-call latency of the enable / has_new_data / getter
+ * paths and end-to-end callback throughput with the data_processing_task report set.
+ *
+ * usage: imu_driver_bench [--iterations N] [--profile sleep|walk|run|scratch|eat|shake] [--csv recording.csv]
+ *                         [--flash-log-image log.img]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "behavior_classifier.hpp"
+#include "behavior_features.hpp"
+#include "bench_util.hpp"
+#include "binlog.hpp"
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "esp_partition_sim.hpp"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "flash_log.hpp"
+#include "imu_align.hpp"
+#include "imu_codec.hpp"
+#include "imu_driver.hpp"
+#include "imu_dsp.hpp"
+#include "nvs_flash.h"
+#include "pipeline.hpp"
+#include "rate_governor.hpp"
+
+namespace
+{
+    constexpr uint8_t processing_rpts[] = {
+        SH2_ACCELEROMETER,
+        SH2_GYROSCOPE_CALIBRATED,
+        SH2_MAGNETIC_FIELD_CALIBRATED,
+        SH2_ROTATION_VECTOR,
+        SH2_PERSONAL_ACTIVITY_CLASSIFIER,
+    };
+
+    bno08x_sim_profile_t parse_profile(const char* name)
+    {
+        if (std::strcmp(name, "sleep") == 0)
+            return bno08x_sim_profile_t::SLEEP;
+        if (std::strcmp(name, "run") == 0)
+            return bno08x_sim_profile_t::RUN;
+        if (std::strcmp(name, "scratch") == 0)
+            return bno08x_sim_profile_t::SCRATCH;
+        if (std::strcmp(name, "eat") == 0)
+            return bno08x_sim_profile_t::EAT;
+        if (std::strcmp(name, "shake") == 0)
+            return bno08x_sim_profile_t::SHAKE;
+        return bno08x_sim_profile_t::WALK;
+    }
+
+    void bench_call_paths(uint64_t iterations)
+    {
+        bench::print_header("imu_driver call paths");
+
+        bench::print_latency("imu_enable_rpt", bench::measure(iterations, [](uint64_t) {
+            bench::do_not_optimize(imu_enable_rpt(SH2_ACCELEROMETER, 10000UL));
+        }));
+
+        bench::print_latency("imu_has_new_data (hit)", bench::measure(iterations, [](uint64_t i) {
+            bno08x_sim_sample_t sample;
+            sample.t_us = static_cast<uint32_t>(i);
+            sample.report_id = SH2_ACCELEROMETER;
+            bno08x_sim::inject(sample);
+            bench::do_not_optimize(imu_has_new_data(SH2_ACCELEROMETER));
+        }));
+
+        bench::print_latency("imu_has_new_data (miss)", bench::measure(iterations, [](uint64_t) {
+            bench::do_not_optimize(imu_has_new_data(SH2_ACCELEROMETER));
+        }));
+
+        bench::print_latency("imu_has_new_data (last case)", bench::measure(iterations, [](uint64_t) {
+            bench::do_not_optimize(imu_has_new_data(SH2_SIGNIFICANT_MOTION));
+        }));
+
+        imu_enable_rpt(SH2_GYROSCOPE_CALIBRATED, 10000UL);
+        imu_enable_rpt(SH2_MAGNETIC_FIELD_CALIBRATED, 10000UL);
+        imu_enable_rpt(SH2_ROTATION_VECTOR, 10000UL);
+        imu_enable_rpt(SH2_PERSONAL_ACTIVITY_CLASSIFIER, 10000UL);
+        bench::print_latency("imu_poll_new_data (5 enabled)", bench::measure(iterations, [](uint64_t) {
+            bench::do_not_optimize(imu_poll_new_data());
+        }));
+
+        bench::print_latency("imu_get<SH2_ACCELEROMETER>", bench::measure(iterations, [](uint64_t) {
+            bench::do_not_optimize(imu_get<SH2_ACCELEROMETER>());
+        }));
+
+        bench::print_latency("imu_get_accel", bench::measure(iterations, [](uint64_t) {
+            bench::do_not_optimize(imu_get_accel());
+        }));
+
+        bench::print_latency("imu_get_cal_gyro", bench::measure(iterations, [](uint64_t) {
+            bench::do_not_optimize(imu_get_cal_gyro());
+        }));
+
+        bench::print_latency("imu_get_rv", bench::measure(iterations, [](uint64_t) {
+            bench::do_not_optimize(imu_get_rv());
+        }));
+
+        bench::print_latency("imu_get_activity_classifier", bench::measure(iterations, [](uint64_t) {
+            bench::do_not_optimize(imu_get_activity_classifier());
+        }));
+
+        bench::print_latency("imu_get_uncal_gyro", bench::measure(iterations, [](uint64_t) {
+            bench::do_not_optimize(imu_get_uncal_gyro());
+        }));
+    }
+
+    /**
+     * Mirrors the data_processing_task callback minus ESP_LOGI: poll every report of
+     * the set and read the ones with new data.
+     */
+    void processing_cb()
+    {
+        if (imu_has_new_data(SH2_ACCELEROMETER))
+            bench::do_not_optimize(imu_get_accel());
+        if (imu_has_new_data(SH2_GYROSCOPE_CALIBRATED))
+            bench::do_not_optimize(imu_get_cal_gyro());
+        if (imu_has_new_data(SH2_MAGNETIC_FIELD_CALIBRATED))
+            bench::do_not_optimize(imu_get_cal_magf());
+        if (imu_has_new_data(SH2_ROTATION_VECTOR))
+            bench::do_not_optimize(imu_get_rv());
+        if (imu_has_new_data(SH2_PERSONAL_ACTIVITY_CLASSIFIER))
+            bench::do_not_optimize(imu_get_activity_classifier());
+    }
+
+    void bench_callback_throughput(const std::vector<bno08x_sim_sample_t>& stream)
+    {
+        imu_disable_all_rpts();
+        imu_report_cfg_t rpts[sizeof(processing_rpts)];
+        for (size_t i = 0; i < sizeof(processing_rpts); i++)
+            rpts[i] = {processing_rpts[i], 10000UL};
+        imu_enable_multi_rpts(rpts, sizeof(processing_rpts));
+
+        bno08x_sim::active()->register_cb(processing_cb);
+        bno08x_sim::reset_stats();
+
+        auto start = bench::clock_t::now();
+        size_t accepted = bno08x_sim::replay(stream.data(), stream.size());
+        auto end = bench::clock_t::now();
+
+        double ns = bench::elapsed_ns(start, end);
+        bno08x_sim_stats_t stats = bno08x_sim::stats();
+
+        std::printf("\n== callback throughput (%zu samples, %zu accepted, %llu dropped) ==\n", stream.size(), accepted,
+                static_cast<unsigned long long>(stats.samples_dropped));
+        std::printf("%-36s %12.0f samples/s\n", "inject -> register_cb", 1e9 * static_cast<double>(accepted) / ns);
+        std::printf("%-36s %12.1f ns/sample\n", "per-sample cost", ns / static_cast<double>(accepted ? accepted : 1));
+    }
+
+    /**
+     * 400 Hz accel + gyro pushed through the driver callback into the sample ring
+     * and drained in batches.
+     */
+    void bench_sample_ring(uint64_t iterations)
+    {
+        bench::print_header("sample ring");
+
+        imu_disable_all_rpts();
+        imu_enable_rpt(SH2_ACCELEROMETER, 2500UL);
+        imu_enable_rpt(SH2_GYROSCOPE_CALIBRATED, 2500UL);
+        imu_sample_ring_start();
+
+        imu_sample_t batch[32];
+        bench::print_latency("inject + ring push + drain", bench::measure(iterations, [&](uint64_t i) {
+            bno08x_sim_sample_t sample;
+            sample.t_us = static_cast<uint32_t>(i);
+            sample.report_id = (i & 1U) ? SH2_GYROSCOPE_CALIBRATED : SH2_ACCELEROMETER;
+            bno08x_sim::inject(sample);
+            if ((i & 31U) == 31U)
+                bench::do_not_optimize(imu_sample_ring_drain(batch, 32));
+        }));
+        while (imu_sample_ring_drain(batch, 32) > 0) {
+        }
+
+        // consumer wakes every drain_period_us of stream time, as data_processing_task does
+        constexpr uint8_t ring_rpts[] = {SH2_ACCELEROMETER, SH2_GYROSCOPE_CALIBRATED};
+        constexpr uint32_t drain_period_us = 100000UL;
+        std::vector<bno08x_sim_sample_t> stream;
+        bno08x_sim::generate(bno08x_sim_profile_t::RUN, ring_rpts, 2, 2500UL, 60000000UL, stream);
+
+        imu_sample_ring_reset_stats();
+        uint32_t next_drain_us = drain_period_us;
+        for (const bno08x_sim_sample_t& sample : stream)
+        {
+            if (sample.t_us >= next_drain_us)
+            {
+                while (imu_sample_ring_drain(batch, 32) > 0) {
+                }
+                next_drain_us += drain_period_us;
+            }
+            bno08x_sim::inject(sample);
+        }
+
+        imu_ring_stats_t stats = imu_sample_ring_get_stats();
+        std::printf("%-36s pushed %lu, overflows %lu, high water %lu/%lu (400 Hz x2, %lu ms drain)\n",
+                "ring sizing", (unsigned long)stats.pushed, (unsigned long)stats.overflows,
+                (unsigned long)stats.high_water, (unsigned long)stats.capacity,
+                (unsigned long)(drain_period_us / 1000UL));
+    }
+
+    /**
+     * 100 Hz accel + gyro with the hub FIFO batch interval swept: host wakes per
+     * second and the size of the burst each wake drains in one call.
+     */
+    void bench_batching()
+    {
+        std::printf("\n== hardware batching (100 Hz accel + gyro, 60 s walk) ==\n");
+
+        constexpr uint8_t batch_rpts[] = {SH2_ACCELEROMETER, SH2_GYROSCOPE_CALIBRATED};
+        constexpr uint32_t batch_intervals_us[] = {0UL, 100000UL, 500000UL, 1000000UL};
+        constexpr uint32_t duration_us = 60000000UL;
+        std::vector<bno08x_sim_sample_t> stream;
+        bno08x_sim::generate(bno08x_sim_profile_t::WALK, batch_rpts, 2, 10000UL, duration_us, stream);
+
+        imu_sample_ring_start();
+        static imu_sample_t burst[IMU_SAMPLE_RING_CAPACITY];
+
+        for (uint32_t batch_us : batch_intervals_us)
+        {
+            imu_disable_all_rpts();
+            imu_report_cfg_t rpts[] = {
+                {SH2_ACCELEROMETER, 10000UL, batch_us},
+                {SH2_GYROSCOPE_CALIBRATED, 10000UL, batch_us},
+            };
+            imu_enable_multi_rpts(rpts, 2);
+            while (imu_sample_ring_drain(burst, IMU_SAMPLE_RING_CAPACITY) > 0) {
+            }
+            imu_sample_ring_reset_stats();
+            bno08x_sim::reset_stats();
+
+            // every host wake is served by one burst drain, as a consumer blocked in drain_burst would be
+            uint32_t drains = 0;
+            size_t max_burst = 0;
+            uint32_t wakes_seen = 0;
+            for (const bno08x_sim_sample_t& sample : stream)
+            {
+                bno08x_sim::inject(sample);
+                uint32_t wakes = bno08x_sim::stats().host_wakes;
+                if (wakes != wakes_seen)
+                {
+                    wakes_seen = wakes;
+                    size_t n = imu_sample_ring_drain_burst(burst, IMU_SAMPLE_RING_CAPACITY, 0);
+                    max_burst = (n > max_burst) ? n : max_burst;
+                    drains++;
+                }
+            }
+
+            bno08x_sim_stats_t stats = bno08x_sim::stats();
+            imu_ring_stats_t ring = imu_sample_ring_get_stats();
+            char label[48];
+            std::snprintf(label, sizeof(label), "batch %lu ms", (unsigned long)(batch_us / 1000UL));
+            std::printf("%-36s %8.1f wakes/s, mean burst %6.1f, max burst %4zu, ring overflows %lu\n", label,
+                    stats.host_wakes / (duration_us / 1e6),
+                    drains ? static_cast<double>(ring.popped) / drains : 0.0, max_burst,
+                    (unsigned long)ring.overflows);
+
+            // leave nothing in the hub FIFO for the next interval
+            imu_flush_rpts();
+        }
+        imu_disable_all_rpts();
+    }
+
+    /**
+     * idle -> walk -> play -> idle cycles, applied by tearing everything down and
+     * re-enabling (the old path) versus the diffing imu_apply_rpt_profile().
+     */
+    void bench_profile_switch(uint64_t cycles)
+    {
+        std::printf("\n== profile switch (idle -> walk -> play, %llu cycles) ==\n", (unsigned long long)cycles);
+
+        imu_report_cfg_t idle[] = {
+            {SH2_LINEAR_ACCELERATION, 200000UL},
+            {SH2_STABILITY_CLASSIFIER, 1000000UL},
+        };
+        imu_report_cfg_t walk[] = {
+            {SH2_LINEAR_ACCELERATION, 20000UL},
+            {SH2_STABILITY_CLASSIFIER, 1000000UL},
+            {SH2_GAME_ROTATION_VECTOR, 20000UL},
+            {SH2_STEP_COUNTER, 1000000UL},
+            {SH2_PERSONAL_ACTIVITY_CLASSIFIER, 1000000UL},
+        };
+        imu_report_cfg_t play[] = {
+            {SH2_LINEAR_ACCELERATION, 10000UL},
+            {SH2_STABILITY_CLASSIFIER, 1000000UL},
+            {SH2_GAME_ROTATION_VECTOR, 10000UL},
+            {SH2_GYROSCOPE_CALIBRATED, 10000UL},
+            {SH2_STEP_COUNTER, 1000000UL},
+            {SH2_PERSONAL_ACTIVITY_CLASSIFIER, 1000000UL},
+        };
+        struct profile_t {
+            imu_report_cfg_t* rpts;
+            size_t count;
+        };
+        const profile_t profiles[] = {{walk, 5}, {play, 6}, {idle, 2}};
+
+        imu_disable_all_rpts();
+        bno08x_sim::reset_stats();
+        auto start = bench::clock_t::now();
+        for (uint64_t i = 0; i < cycles; i++)
+        {
+            for (const profile_t& profile : profiles)
+            {
+                imu_disable_all_rpts();
+                imu_enable_multi_rpts(profile.rpts, profile.count);
+            }
+        }
+        double full_ns = bench::elapsed_ns(start, bench::clock_t::now());
+        uint32_t full_cmds = bno08x_sim::stats().set_feature_cmds;
+
+        imu_disable_all_rpts();
+        imu_apply_rpt_profile(idle, 2);
+        bno08x_sim::reset_stats();
+        uint64_t kept = 0;
+        start = bench::clock_t::now();
+        for (uint64_t i = 0; i < cycles; i++)
+        {
+            for (const profile_t& profile : profiles)
+            {
+                imu_reconfig_stats_t diff;
+                imu_apply_rpt_profile(profile.rpts, profile.count, &diff);
+                kept += diff.unchanged;
+            }
+        }
+        double diff_ns = bench::elapsed_ns(start, bench::clock_t::now());
+        uint32_t diff_cmds = bno08x_sim::stats().set_feature_cmds;
+
+        const double switches = 3.0 * static_cast<double>(cycles);
+        std::printf("%-36s %8.1f set-feature/switch, %8.0f ns/switch\n", "disable_all + enable_multi",
+                full_cmds / switches, full_ns / switches);
+        std::printf("%-36s %8.1f set-feature/switch, %8.0f ns/switch, %.1f reports kept streaming\n",
+                "imu_apply_rpt_profile", diff_cmds / switches, diff_ns / switches, kept / switches);
+        imu_disable_all_rpts();
+    }
+
+    /**
+     * Latest-value cache: read cost, and readers on other threads checking every
+     * copy for tearing while the injecting thread keeps writing.
+     */
+    void bench_latest_cache(uint64_t iterations)
+    {
+        bench::print_header("latest-value cache");
+
+        imu_disable_all_rpts();
+        imu_enable_rpt(SH2_ACCELEROMETER, 2500UL);
+        imu_latest_start();
+
+        bench::print_latency("imu_latest_read", bench::measure(iterations, [](uint64_t) {
+            imu_sample_t sample;
+            bench::do_not_optimize(imu_latest_read(SH2_ACCELEROMETER, sample));
+        }));
+
+        uint32_t cursor = imu_latest_seq(SH2_ACCELEROMETER);
+        bench::print_latency("imu_latest_read_new (nothing new)", bench::measure(iterations, [&](uint64_t) {
+            imu_sample_t sample;
+            bench::do_not_optimize(imu_latest_read_new(SH2_ACCELEROMETER, sample, cursor));
+        }));
+
+        // earlier sections left generated samples in the cache, only judge copies written below
+        const uint32_t first_seq = imu_latest_seq(SH2_ACCELEROMETER) + 1;
+        constexpr int readers = 2;
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> reads{0};
+        std::atomic<uint64_t> torn{0};
+        std::atomic<uint64_t> backwards{0};
+        std::vector<std::thread> threads;
+        for (int r = 0; r < readers; r++)
+        {
+            threads.emplace_back([&]() {
+                uint32_t last = 0;
+                uint64_t n = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    imu_sample_t sample;
+                    uint32_t seq = imu_latest_read(SH2_ACCELEROMETER, sample);
+                    if (seq >= first_seq &&
+                        (sample.data.vec.x != sample.data.vec.y || sample.data.vec.y != sample.data.vec.z))
+                        torn.fetch_add(1, std::memory_order_relaxed);
+                    if (seq < last)
+                        backwards.fetch_add(1, std::memory_order_relaxed);
+                    last = seq;
+                    n++;
+                }
+                reads.fetch_add(n, std::memory_order_relaxed);
+            });
+        }
+
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            bno08x_sim_sample_t sample;
+            sample.report_id = SH2_ACCELEROMETER;
+            sample.v[0] = sample.v[1] = sample.v[2] = static_cast<float>(i);
+            bno08x_sim::inject(sample);
+        }
+        stop.store(true);
+        for (std::thread& t : threads)
+            t.join();
+
+        std::printf("%-36s %llu writes, %llu reads, %llu torn, %llu out of order\n", "concurrent readers (2)",
+                (unsigned long long)iterations, (unsigned long long)reads.load(),
+                (unsigned long long)torn.load(), (unsigned long long)backwards.load());
+    }
+
+    size_t binlog_discard(const void*, size_t len)
+    {
+        return len;
+    }
+
+    /**
+     * Cost a hot path pays per log line: printf-style float formatting (what
+     * ESP_LOGI does before it even reaches the UART) versus a deferred record.
+     */
+    void bench_deferred_log(uint64_t iterations)
+    {
+        bench::print_header("deferred logging (3 floats per line)");
+
+        static constexpr const char* TAG = "BENCH";
+        bench::print_latency("snprintf \"%.2f\" x3 (ESP_LOGI body)", bench::measure(iterations, [](uint64_t i) {
+            char line[64];
+            float v = static_cast<float>(i);
+            bench::do_not_optimize(std::snprintf(line, sizeof(line), "Accel: %.2f, %.2f, %.2f", v, v * 0.5f, 9.81f));
+        }));
+
+        binlog_config_t config;
+        config.sink = BINLOG_SINK_BINARY;
+        config.write = binlog_discard;
+        config.drain_period_ms = 1;
+        binlog_start(config);
+        binlog_reset_stats();
+
+        // push in bursts the ring can hold and let the binlog task drain in between, only pushes are timed
+        constexpr uint32_t burst = BINLOG_RING_CAPACITY / 2;
+        double push_ns = 0.0;
+        uint64_t pushed = 0;
+        while (pushed < iterations)
+        {
+            auto start = bench::clock_t::now();
+            for (uint32_t i = 0; i < burst; i++)
+            {
+                float v = static_cast<float>(pushed + i);
+                BINLOG_I(TAG, "Accel: %.2f, %.2f, %.2f", v, v * 0.5f, 9.81f);
+            }
+            push_ns += bench::elapsed_ns(start, bench::clock_t::now());
+            pushed += burst;
+            while (binlog_get_stats().emitted < binlog_get_stats().logged)
+                std::this_thread::yield();
+        }
+        std::printf("%-36s %12.1f ns/line mean\n", "BINLOG_I", push_ns / static_cast<double>(pushed));
+
+        binlog_stats_t stats = binlog_get_stats();
+        std::printf("%-36s logged %lu, dropped %lu (ring %lu, drained every %lu ms)\n", "binlog ring",
+                (unsigned long)stats.logged, (unsigned long)stats.dropped, (unsigned long)stats.capacity,
+                (unsigned long)config.drain_period_ms);
+    }
+
+    /**
+     * Significant motion posted from the driver callback to a task blocked in
+     * imu_wait_events(), the pm_task wake path out of SLEEP.
+     */
+    void bench_motion_wake(uint64_t wakes)
+    {
+        imu_events_start();
+        imu_reset_wake_stats();
+        imu_rearm_sig_motion();
+
+        std::atomic<uint64_t> handled{0};
+        std::thread waiter([&]() {
+            for (uint64_t i = 0; i < wakes; i++)
+            {
+                imu_wait_events(IMU_EVT_SIG_MOTION);
+                imu_rearm_sig_motion();
+                handled.store(i + 1, std::memory_order_release);
+            }
+        });
+
+        for (uint64_t i = 0; i < wakes; i++)
+        {
+            bno08x_sim_sample_t sample;
+            sample.report_id = SH2_SIGNIFICANT_MOTION;
+            sample.v[0] = 1.0f;
+            bno08x_sim::inject(sample);
+            while (handled.load(std::memory_order_acquire) <= i)
+                std::this_thread::yield();
+        }
+        waiter.join();
+
+        imu_wake_stats_t stats = imu_get_wake_stats();
+        std::printf("\n== motion wake path (%lu wakes) ==\n", (unsigned long)stats.wakes);
+        std::printf("%-36s mean %.1f us, max %lu us\n", "event post -> task wake",
+                stats.wakes ? static_cast<double>(stats.total_us) / stats.wakes : 0.0, (unsigned long)stats.max_us);
+    }
+
+    /**
+     * Report metrics: cost of one record on the ingestion path, then the
+     * data_processing_task report set paced in real time for a few seconds with
+     * every 50th accel sample withheld, so the gap counter has something to find.
+     */
+    void bench_metrics(uint64_t iterations)
+    {
+        bench::print_header("report metrics");
+
+        imu_rpt_metrics_slot slot;
+        bench::print_latency("on_sample + on_callback", bench::measure(iterations, [&](uint64_t i) {
+            slot.on_sample(static_cast<uint32_t>(i * 10000U), 10000U);
+            slot.on_callback(static_cast<uint32_t>(i & 0x3FF));
+        }));
+
+        imu_disable_all_rpts();
+        imu_report_cfg_t rpts[sizeof(processing_rpts)];
+        for (size_t i = 0; i < sizeof(processing_rpts); i++)
+            rpts[i] = {processing_rpts[i], 10000UL};
+        imu_enable_multi_rpts(rpts, sizeof(processing_rpts));
+        imu_latest_start();
+
+        std::vector<bno08x_sim_sample_t> stream;
+        bno08x_sim::generate(bno08x_sim_profile_t::WALK, processing_rpts, sizeof(processing_rpts), 10000UL, 3000000UL,
+                stream);
+        imu_metrics_reset();
+
+        const auto start = bench::clock_t::now();
+        uint32_t accel_seen = 0;
+        for (const bno08x_sim_sample_t& sample : stream)
+        {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(sample.t_us));
+            if (sample.report_id == SH2_ACCELEROMETER && ++accel_seen % 50 == 0)
+                continue;
+            bno08x_sim::inject(sample);
+        }
+
+        const uint32_t ticks_per_us = esp_rom_get_cpu_ticks_per_us();
+        std::printf("%-8s %8s %8s %10s %12s %6s %7s %10s\n", "report", "rx", "Hz", "jitter us", "interval us", "gaps",
+                "missed", "cb max us");
+        for (uint8_t id : processing_rpts)
+        {
+            imu_rpt_metrics_t m;
+            imu_metrics_get(id, m);
+            std::printf("0x%02X     %8lu %8.1f %10.1f %5lu..%-6lu %6lu %7lu %10.1f\n", id, (unsigned long)m.received,
+                    imu_metrics_rate_hz(m), imu_metrics_jitter_us(m), (unsigned long)m.interval_min_us,
+                    (unsigned long)m.interval_max_us, (unsigned long)m.gaps, (unsigned long)m.missed,
+                    static_cast<double>(m.cb_max_cycles) / ticks_per_us);
+        }
+
+        uint8_t snapshot[IMU_METRICS_SNAPSHOT_MAX];
+        std::printf("%-36s %zu bytes for %zu reports\n", "binary snapshot", imu_metrics_snapshot(snapshot, sizeof(snapshot)),
+                sizeof(processing_rpts));
+        imu_disable_all_rpts();
+    }
+
+    /**
+     * @brief Run a stream through the driver with the data_processing_task report set and collect the ring in compact form
+     * @note The replay runs far faster than real time, records keep the recording's clock
+     */
+    std::vector<imu_compact_sample_t> replay_compact(const std::vector<bno08x_sim_sample_t>& stream)
+    {
+        imu_disable_all_rpts();
+        imu_report_cfg_t rpts[sizeof(processing_rpts)];
+        for (size_t i = 0; i < sizeof(processing_rpts); i++)
+            rpts[i] = {processing_rpts[i], 10000UL};
+        imu_enable_multi_rpts(rpts, sizeof(processing_rpts));
+        imu_sample_ring_start();
+
+        std::vector<imu_compact_sample_t> records;
+        imu_compact_sample_t drained[64];
+        while (imu_sample_ring_drain_compact(drained, 64) > 0) {}
+        for (const bno08x_sim_sample_t& sample : stream)
+        {
+            bno08x_sim::inject(sample);
+            size_t n = imu_sample_ring_drain_compact(drained, 64);
+            for (size_t i = 0; i < n; i++)
+                drained[i].timestamp_us = static_cast<uint32_t>(sample.t_us);
+            records.insert(records.end(), drained, drained + n);
+        }
+        imu_disable_all_rpts();
+        return records;
+    }
+
+    /// @brief Run a stream through the driver and return the drained samples, stamped with stream time
+    std::vector<imu_sample_t> replay_samples(const std::vector<bno08x_sim_sample_t>& stream)
+    {
+        imu_disable_all_rpts();
+        imu_report_cfg_t rpts[sizeof(processing_rpts)];
+        for (size_t i = 0; i < sizeof(processing_rpts); i++)
+            rpts[i] = {processing_rpts[i], 10000UL};
+        imu_enable_multi_rpts(rpts, sizeof(processing_rpts));
+        imu_sample_ring_start();
+
+        std::vector<imu_sample_t> samples;
+        imu_sample_t drained[64];
+        while (imu_sample_ring_drain(drained, 64) > 0) {}
+        for (const bno08x_sim_sample_t& sample : stream)
+        {
+            bno08x_sim::inject(sample);
+            size_t n = imu_sample_ring_drain(drained, 64);
+            for (size_t i = 0; i < n; i++)
+                drained[i].timestamp_us = static_cast<uint32_t>(sample.t_us);
+            samples.insert(samples.end(), drained, drained + n);
+        }
+        imu_disable_all_rpts();
+        return samples;
+    }
+
+    /**
+     * Flash ring log: bytes of flash per sample and write amplification
+     * (flash consumed / record bytes) for three sync policies over the
+     * stream, erase spread after lapping the partition, tail recovery reads
+     * against a full scan, and a power cut in the middle of a block write.
+     */
+    void bench_flash_log(const std::vector<bno08x_sim_sample_t>& stream, const char* image_path)
+    {
+        std::printf("\n== flash ring log ==\n");
+
+        constexpr uint32_t PARTITION_SIZE = 256U * 1024U;
+        const esp_partition_t* part = esp_partition_sim::add(FLASH_LOG_DEFAULT_LABEL, PARTITION_SIZE, image_path);
+        if (part == nullptr || !flash_log_open())
+        {
+            std::printf("flash log partition unavailable\n");
+            return;
+        }
+
+        const std::vector<imu_compact_sample_t> records = replay_compact(stream);
+        const double seconds = stream.empty() ? 0.0 : stream.back().t_us * 1e-6;
+
+        std::printf("%-36s %zu records over %.0f s, partition %lu KB\n", "input", records.size(), seconds,
+                (unsigned long)(PARTITION_SIZE / 1024));
+        std::printf("%-36s %10s %8s %8s %10s\n", "sync policy", "B/sample", "WA", "blocks", "erases");
+
+        struct policy_t {
+            const char* label;
+            uint32_t sync_us;
+        };
+        constexpr policy_t policies[] = {
+            {"full blocks only", 0},
+            {"sync every 1 s", 1000000UL},
+            {"sync every 100 ms", 100000UL},
+        };
+        for (const policy_t& policy : policies)
+        {
+            flash_log_erase();
+            const flash_log_stats_t start = flash_log_get_stats();
+            uint32_t last_sync_us = records.empty() ? 0 : records.front().timestamp_us;
+            for (const imu_compact_sample_t& record : records)
+            {
+                flash_log_append(record);
+                if (policy.sync_us != 0 && record.timestamp_us - last_sync_us >= policy.sync_us)
+                {
+                    flash_log_sync();
+                    last_sync_us = record.timestamp_us;
+                }
+            }
+            flash_log_sync();
+
+            const flash_log_stats_t end = flash_log_get_stats();
+            const double flash_bytes = static_cast<double>(end.flash_bytes - start.flash_bytes);
+            std::printf("%-36s %10.2f %8.3f %8lu %10lu\n", policy.label, flash_bytes / (end.records - start.records),
+                    flash_bytes / static_cast<double>(end.payload_bytes - start.payload_bytes),
+                    (unsigned long)(end.blocks_written - start.blocks_written),
+                    (unsigned long)(end.sectors_erased - start.sectors_erased));
+        }
+
+        uint32_t min_erases = 0;
+        uint32_t max_erases = 0;
+        flash_log_wear(min_erases, max_erases);
+        std::printf("%-36s %lu..%lu erases per sector\n", "sector wear over the three runs", (unsigned long)min_erases,
+                (unsigned long)max_erases);
+
+        const auto open_start = bench::clock_t::now();
+        flash_log_open();
+        const double open_us = bench::elapsed_ns(open_start, bench::clock_t::now()) / 1000.0;
+        std::printf("%-36s %8lu reads (%lu sector headers + blocks for a full scan), %.1f us\n", "tail recovery",
+                (unsigned long)flash_log_get_stats().recovery_reads,
+                (unsigned long)(PARTITION_SIZE / FLASH_LOG_SECTOR_SIZE * FLASH_LOG_BLOCKS_PER_SECTOR), open_us);
+
+        // power lost 100 bytes into a block: the block is skipped, the log resumes after it
+        const uint32_t before = flash_log_get_stats().head_seq;
+        esp_partition_sim::tear_next_write(part, 100);
+        for (size_t i = 0; i < FLASH_LOG_RECORDS_PER_BLOCK; i++)
+        {
+            imu_compact_sample_t record = records[i];
+            record.timestamp_us += records.back().timestamp_us;
+            flash_log_append(record);
+        }
+        flash_log_open();
+        const flash_log_stats_t reopened = flash_log_get_stats();
+        std::printf("%-36s %lu torn block skipped, head sector seq %lu -> %lu\n", "power cut mid block",
+                (unsigned long)reopened.torn_blocks, (unsigned long)before, (unsigned long)reopened.head_seq);
+        if (image_path != nullptr)
+            std::printf("%-36s %s, decode with flash_log_decode\n", "image", image_path);
+    }
+
+    /**
+     * Compact samples: bytes per sample, round trip error of the driver's
+     * samples against one LSB of each report's Q point, and the cost of
+     * packing and of the lazy float conversions.
+     */
+    void bench_compact(uint64_t iterations)
+    {
+        bench::print_header("compact samples");
+
+        std::vector<bno08x_sim_sample_t> stream;
+        bno08x_sim::generate(bno08x_sim_profile_t::WALK, processing_rpts, sizeof(processing_rpts), 10000UL, 2000000UL,
+                stream);
+        imu_disable_all_rpts();
+        imu_report_cfg_t rpts[sizeof(processing_rpts)];
+        for (size_t i = 0; i < sizeof(processing_rpts); i++)
+            rpts[i] = {processing_rpts[i], 10000UL};
+        imu_enable_multi_rpts(rpts, sizeof(processing_rpts));
+        imu_sample_ring_start();
+
+        std::vector<imu_sample_t> samples;
+        imu_sample_t drained[64];
+        while (imu_sample_ring_drain(drained, 64) > 0) {}
+        for (const bno08x_sim_sample_t& sample : stream)
+        {
+            bno08x_sim::inject(sample);
+            size_t n = imu_sample_ring_drain(drained, 64);
+            samples.insert(samples.end(), drained, drained + n);
+        }
+        imu_disable_all_rpts();
+
+        std::vector<imu_compact_sample_t> packed(samples.size());
+        std::vector<imu_sample_t> unpacked(samples.size());
+        double vec_lsb = 0.0, quat_rad = 0.0;
+        bool values_exact = true;
+        for (size_t i = 0; i < samples.size(); i++)
+        {
+            imu_compact_pack(samples[i], packed[i]);
+            imu_compact_unpack(packed[i], unpacked[i]);
+            const imu_sample_t& a = samples[i];
+            const imu_sample_t& b = unpacked[i];
+            values_exact &= a.timestamp_us == b.timestamp_us && a.accuracy == b.accuracy;
+            switch (imu_sample_kind(a.report_id))
+            {
+                case IMU_SAMPLE_VEC: {
+                    const double lsb = std::ldexp(1.0, -imu_report_q_point(a.report_id));
+                    vec_lsb = std::max({vec_lsb, std::fabs(a.data.vec.x - b.data.vec.x) / lsb,
+                            std::fabs(a.data.vec.y - b.data.vec.y) / lsb, std::fabs(a.data.vec.z - b.data.vec.z) / lsb});
+                    break;
+                }
+                case IMU_SAMPLE_QUAT: {
+                    const double dot = std::fabs(a.data.quat.real * b.data.quat.real + a.data.quat.i * b.data.quat.i +
+                                                 a.data.quat.j * b.data.quat.j + a.data.quat.k * b.data.quat.k);
+                    quat_rad = std::max(quat_rad, 2.0 * std::acos(std::min(1.0, dot)));
+                    break;
+                }
+                case IMU_SAMPLE_ACTIVITY:
+                    values_exact &= a.data.activity.state == b.data.activity.state &&
+                                    a.data.activity.confidence == b.data.activity.confidence;
+                    break;
+                case IMU_SAMPLE_VALUE:
+                    values_exact &= a.data.value == b.data.value;
+                    break;
+            }
+        }
+
+        const size_t history = 10 * 100 * sizeof(processing_rpts);
+        std::printf("%-36s %8zu B/sample full, %zu B/sample compact\n", "record size", sizeof(imu_sample_t),
+                sizeof(imu_compact_sample_t));
+        std::printf("%-36s %8zu B full, %zu B compact\n", "10 s history, 5 reports at 100 Hz", history * sizeof(imu_sample_t),
+                history * sizeof(imu_compact_sample_t));
+        std::printf("%-36s %8zu B (%s records)\n", "sample ring", IMU_SAMPLE_RING_CAPACITY *
+                (IMU_SAMPLE_RING_COMPACT ? sizeof(imu_compact_sample_t) : sizeof(imu_sample_t)),
+                IMU_SAMPLE_RING_COMPACT ? "compact" : "full");
+        std::printf("%-36s %8.3f LSB vec, %.5f rad quat, stamps / events %s\n", "round trip error max", vec_lsb, quat_rad,
+                values_exact ? "exact" : "DIFFER");
+
+        const size_t n = samples.size();
+        bench::print_latency("imu_compact_pack", bench::measure(iterations, [&](uint64_t i) {
+            imu_compact_sample_t record;
+            imu_compact_pack(samples[i % n], record);
+            bench::do_not_optimize(record);
+        }));
+        bench::print_latency("imu_compact_unpack", bench::measure(iterations, [&](uint64_t i) {
+            imu_sample_t sample;
+            imu_compact_unpack(packed[i % n], sample);
+            bench::do_not_optimize(sample);
+        }));
+
+        // one report's history converted at consumption: per sample unpack against the batch converters
+        std::vector<imu_compact_sample_t> accel;
+        for (const imu_compact_sample_t& record : packed)
+            if (record.report_id == SH2_ACCELEROMETER)
+                accel.push_back(record);
+        std::vector<imu_sample_t> accel_full(accel.size());
+        std::vector<float> xyz(3 * accel.size());
+        std::vector<int16_t> soa(3 * accel.size());
+        for (size_t i = 0; i < accel.size(); i++)
+            for (size_t c = 0; c < 3; c++)
+                soa[c * accel.size() + i] = accel[i].v[c];
+
+        const uint64_t passes = std::max<uint64_t>(1, iterations / accel.size());
+        auto per_sample = [&](auto&& fxn) {
+            const auto start = bench::clock_t::now();
+            for (uint64_t p = 0; p < passes; p++)
+                fxn();
+            return bench::elapsed_ns(start, bench::clock_t::now()) / static_cast<double>(passes * accel.size());
+        };
+        const double unpack_ns = per_sample([&]() {
+            imu_compact_unpack_batch(accel.data(), accel.size(), accel_full.data());
+            bench::do_not_optimize(accel_full[0]);
+        });
+        const double vec_ns = per_sample([&]() {
+            imu_compact_vec_to_float(accel.data(), accel.size(), xyz.data());
+            bench::do_not_optimize(xyz[0]);
+        });
+        const double soa_ns = per_sample([&]() {
+            imu_q16_to_float(soa.data(), xyz.data(), soa.size(), imu_report_q_point(SH2_ACCELEROMETER));
+            bench::do_not_optimize(xyz[0]);
+        });
+        std::printf("%-36s %8.2f ns/sample (%zu accel samples)\n", "imu_compact_unpack_batch", unpack_ns, accel.size());
+        std::printf("%-36s %8.2f ns/sample\n", "imu_compact_vec_to_float", vec_ns);
+        std::printf("%-36s %8.2f ns/sample\n", "imu_q16_to_float (x, y, z planes)", soa_ns);
+    }
+
+    /**
+     * Timestamp reconstruction against a hub clock 1.2 s ahead and 50 ppm fast,
+     * delivered in real time with a random host side delay per interrupt: stamp
+     * error of arrival times against reconstructed times. Then the frame
+     * aligner on accel / gyro / RV streams sampled at different phases: value
+     * error of pairing each accel sample with the latest other samples against
+     * interpolating all three to one grid.
+     */
+    void bench_clock_sync()
+    {
+        std::printf("\n== clock sync and frame alignment ==\n");
+
+        constexpr int32_t HUB_OFFSET_US = 1200000;
+        constexpr float HUB_DRIFT_PPM = 50.0f;
+        // long enough for the drift line to span most of its IMU_CLOCK_WINDOWS windows
+        constexpr uint32_t DURATION_US = 20000000UL;
+        constexpr uint8_t sync_rpts[] = {SH2_RAW_ACCELEROMETER, SH2_ACCELEROMETER, SH2_ROTATION_VECTOR};
+
+        imu_disable_all_rpts();
+        imu_report_cfg_t rpts[sizeof(sync_rpts)];
+        for (size_t i = 0; i < sizeof(sync_rpts); i++)
+            rpts[i] = {static_cast<sh2_SensorId_t>(sync_rpts[i]), 10000UL};
+        imu_enable_multi_rpts(rpts, sizeof(sync_rpts));
+        imu_sample_ring_start();
+        bno08x_sim::set_hub_clock(HUB_OFFSET_US, HUB_DRIFT_PPM);
+        imu_clock_reset();
+
+        imu_sample_t drained[64];
+        while (imu_sample_ring_drain(drained, 64) > 0) {}
+
+        std::vector<bno08x_sim_sample_t> stream;
+        bno08x_sim::generate(bno08x_sim_profile_t::WALK, sync_rpts, sizeof(sync_rpts), 10000UL, DURATION_US, stream);
+
+        struct stamp_err_t {
+            double arrival_sum = 0.0, arrival_max = 0.0, stamp_sum = 0.0, stamp_max = 0.0;
+            uint32_t n = 0;
+        } raw_err, fused_err;
+
+        // interrupt delay: 100..1600 us, one in 20 stalls for 3..8 ms behind other work
+        uint32_t rng = 12345U;
+        auto next_rand = [&rng]() {
+            rng = rng * 1664525U + 1013904223U;
+            return rng >> 8;
+        };
+
+        const auto start = bench::clock_t::now();
+        const int64_t host0_us = esp_timer_get_time();
+        uint32_t last_t_us = 0xFFFFFFFFUL;
+        uint32_t delay_us = 0;
+        for (const bno08x_sim_sample_t& sample : stream)
+        {
+            if (sample.t_us != last_t_us)
+            {
+                last_t_us = sample.t_us;
+                delay_us = (next_rand() % 20 == 0) ? 3000 + next_rand() % 5000 : 100 + next_rand() % 1500;
+            }
+            std::this_thread::sleep_until(start + std::chrono::microseconds(sample.t_us + delay_us));
+            const uint32_t arrival_us = static_cast<uint32_t>(esp_timer_get_time());
+            bno08x_sim::inject(sample);
+
+            size_t n = imu_sample_ring_drain(drained, 64);
+            const uint32_t true_us = static_cast<uint32_t>(host0_us + sample.t_us);
+            // the first windows are spent locking on, score the rest
+            for (size_t i = 0; i < n && sample.t_us >= 1000000UL; i++)
+            {
+                stamp_err_t& err = (drained[i].report_id == SH2_RAW_ACCELEROMETER) ? raw_err : fused_err;
+                const double arrival = std::fabs(static_cast<double>(static_cast<int32_t>(arrival_us - true_us)));
+                const double stamp = std::fabs(static_cast<double>(static_cast<int32_t>(drained[i].timestamp_us - true_us)));
+                err.arrival_sum += arrival;
+                err.arrival_max = std::max(err.arrival_max, arrival);
+                err.stamp_sum += stamp;
+                err.stamp_max = std::max(err.stamp_max, stamp);
+                err.n++;
+            }
+        }
+
+        imu_clock_stats_t clock = imu_clock_get_stats();
+        std::printf("%-36s %8.1f ppm (hub set to %.1f), delay %lu us, %lu windows, %lu resyncs\n", "estimated drift",
+                clock.drift_ppm, HUB_DRIFT_PPM, (unsigned long)clock.delay_us, (unsigned long)clock.windows,
+                (unsigned long)clock.resyncs);
+        std::printf("%-36s %10s %10s %10s %10s\n", "stamp error vs true sample time", "arr mean", "arr max",
+                "stamp mean", "stamp max");
+        auto print_err = [](const char* label, const stamp_err_t& err) {
+            const double n = (err.n != 0) ? err.n : 1;
+            std::printf("%-36s %7.0f us %7.0f us %7.0f us %7.0f us\n", label, err.arrival_sum / n, err.arrival_max,
+                    err.stamp_sum / n, err.stamp_max);
+        };
+        print_err("raw accel (hub timestamp mapped)", raw_err);
+        print_err("accel + RV (arrival - typical delay)", fused_err);
+
+        imu_disable_all_rpts();
+        bno08x_sim::set_hub_clock(0, 0.0f);
+        imu_clock_reset();
+
+        // alignment: 2 Hz gait swing on accel (phase 0) and gyro (phase 4 ms), 1 Hz yaw on RV at 50 Hz (phase 7 ms)
+        constexpr double PI = 3.14159265358979;
+        auto swing = [](uint32_t t_us) { return static_cast<float>(std::sin(2.0 * PI * 2.0 * t_us * 1e-6)); };
+        auto yaw = [](uint32_t t_us) { return 0.8 * std::sin(2.0 * PI * 1.0 * t_us * 1e-6); };
+        auto make = [&](uint8_t id, uint32_t t_us) {
+            imu_sample_t s{};
+            s.timestamp_us = t_us;
+            s.report_id = id;
+            if (id == SH2_ROTATION_VECTOR)
+                s.data.quat = {static_cast<float>(std::cos(yaw(t_us) / 2)), 0.0f, 0.0f,
+                               static_cast<float>(std::sin(yaw(t_us) / 2))};
+            else
+                s.data.vec = {swing(t_us), 0.0f, 0.0f};
+            return s;
+        };
+        auto yaw_of = [](const imu_sample_t& s) { return 2.0 * std::atan2(s.data.quat.k, s.data.quat.real); };
+
+        std::vector<imu_sample_t> synth;
+        for (uint32_t t_us = 0; t_us < 10000000UL; t_us += 1000)
+        {
+            if (t_us % 10000 == 0)
+                synth.push_back(make(SH2_ACCELEROMETER, t_us));
+            if (t_us % 10000 == 4000)
+                synth.push_back(make(SH2_GYROSCOPE_CALIBRATED, t_us));
+            if (t_us % 20000 == 7000)
+                synth.push_back(make(SH2_ROTATION_VECTOR, t_us));
+        }
+
+        double naive_gyro = 0.0, naive_yaw = 0.0, naive_skew = 0.0;
+        imu_sample_t last_gyro{}, last_rv{};
+        bool have_gyro = false, have_rv = false;
+        for (const imu_sample_t& s : synth)
+        {
+            if (s.report_id == SH2_GYROSCOPE_CALIBRATED)
+                last_gyro = s, have_gyro = true;
+            else if (s.report_id == SH2_ROTATION_VECTOR)
+                last_rv = s, have_rv = true;
+            else if (have_gyro && have_rv)
+            {
+                naive_gyro = std::max(naive_gyro, std::fabs(static_cast<double>(last_gyro.data.vec.x - swing(s.timestamp_us))));
+                naive_yaw = std::max(naive_yaw, std::fabs(yaw_of(last_rv) - yaw(s.timestamp_us)));
+                naive_skew = std::max(naive_skew, static_cast<double>(s.timestamp_us - last_rv.timestamp_us));
+            }
+        }
+
+        constexpr uint8_t frame_rpts[] = {SH2_ACCELEROMETER, SH2_GYROSCOPE_CALIBRATED, SH2_ROTATION_VECTOR};
+        imu_frame_aligner aligner;
+        aligner.configure(frame_rpts, sizeof(frame_rpts), 10000UL);
+        double aligned_gyro = 0.0, aligned_yaw = 0.0;
+        uint32_t frames = 0;
+        imu_frame_t frame;
+        const auto align_start = bench::clock_t::now();
+        for (const imu_sample_t& s : synth)
+        {
+            aligner.push(s);
+            while (aligner.next(frame))
+            {
+                aligned_gyro = std::max(aligned_gyro,
+                        std::fabs(static_cast<double>(frame.rpt[1].data.vec.x - swing(frame.timestamp_us))));
+                aligned_yaw = std::max(aligned_yaw, std::fabs(yaw_of(frame.rpt[2]) - yaw(frame.timestamp_us)));
+                frames++;
+            }
+        }
+        const double align_ns = bench::elapsed_ns(align_start, bench::clock_t::now());
+
+        std::printf("%-36s %8s %12s %12s\n", "accel-referenced gyro / RV", "skew max", "gyro err max", "yaw err max");
+        std::printf("%-36s %5.1f ms %12.4f %8.4f rad\n", "latest sample pairing", naive_skew / 1000.0, naive_gyro, naive_yaw);
+        std::printf("%-36s %5.1f ms %12.4f %8.4f rad\n", "aligned frames (10 ms grid)", 0.0, aligned_gyro, aligned_yaw);
+        std::printf("%-36s %8.1f ns/frame, %lu frames, %lu skipped ticks\n", "aligner push + next", align_ns / frames,
+                (unsigned long)frames, (unsigned long)aligner.skipped());
+    }
+
+    /**
+     * FRS handshakes per config change: the read / write / read back / dump
+     * pattern of main.cpp against the FRS cache, and a settings change applied
+     * with a commit per setter against one batched commit.
+     */
+    void bench_frs_cache(uint64_t cycles)
+    {
+        std::printf("\n== FRS cache (%llu config changes) ==\n", (unsigned long long)cycles);
+
+        auto transactions = []() {
+            bno08x_sim_stats_t sim = bno08x_sim::stats();
+            return static_cast<double>(sim.frs_reads + sim.frs_writes);
+        };
+
+        bno08x_sim::reset_stats();
+        for (uint64_t i = 0; i < cycles; i++)
+        {
+            uint32_t data[16];
+            uint16_t size = 0;
+            imu_frs_read(BNO08xFrsID::SIG_MOTION_DETECT_CONFIG, data, size);
+            data[1] = 3 + (i & 1);
+            imu_frs_write(BNO08xFrsID::SIG_MOTION_DETECT_CONFIG, data, 2);
+            imu_frs_read(BNO08xFrsID::SIG_MOTION_DETECT_CONFIG, data, size);
+            imu_frs_read(BNO08xFrsID::SIG_MOTION_DETECT_CONFIG, data, size);
+        }
+        std::printf("%-36s %8.2f FRS transactions/change\n", "direct read, write, read, dump", transactions() / cycles);
+
+        imu_frs_invalidate_all();
+        imu_frs_cache_reset_stats();
+        bno08x_sim::reset_stats();
+        for (uint64_t i = 0; i < cycles; i++)
+        {
+            imu_sig_motion_config_t config;
+            imu_get_sig_motion_config(config);
+            config.step_threshold = 3 + (i & 1);
+            imu_set_sig_motion_config(config);
+            imu_get_sig_motion_config(config);
+
+            uint32_t data[16];
+            uint16_t size = 0;
+            imu_frs_cached_read(BNO08xFrsID::SIG_MOTION_DETECT_CONFIG, data, size);
+        }
+        imu_frs_cache_stats_t cache = imu_frs_cache_get_stats();
+        std::printf("%-36s %8.2f FRS transactions/change, %lu hits, %lu misses, %lu verify failures\n",
+                "cached get, set (verified), get, dump", transactions() / cycles, (unsigned long)cache.hits,
+                (unsigned long)cache.misses, (unsigned long)cache.verify_failures);
+
+        // one settings change: the sig motion threshold and step count edited separately, the stability
+        // duration changed, shake and fusion period set to what they already are
+        auto apply_settings = [](uint64_t i, bool commit) {
+            const uint32_t step = static_cast<uint32_t>(i & 1);
+            imu_sig_motion_config_t sig_motion;
+            imu_get_sig_motion_config(sig_motion);
+            sig_motion.accel_threshold_ms2 = 10.0f + step;
+            imu_set_sig_motion_config(sig_motion, commit);
+            sig_motion.step_threshold = 3 + step;
+            imu_set_sig_motion_config(sig_motion, commit);
+            imu_set_stability_config({0.2f, 500000U + step}, commit);
+            imu_set_shake_config({12.0f, 50000U, 400000U, 4, 0x7}, commit);
+            imu_set_max_fusion_period(10000U, commit);
+            if (!commit)
+                imu_frs_commit();
+        };
+
+        bno08x_sim::reset_stats();
+        for (uint64_t i = 0; i < cycles; i++)
+            apply_settings(i, true);
+        std::printf("%-36s %8.2f FRS transactions/settings change\n", "5 setters, commit each", transactions() / cycles);
+
+        imu_frs_cache_reset_stats();
+        bno08x_sim::reset_stats();
+        for (uint64_t i = 0; i < cycles; i++)
+            apply_settings(i, false);
+        std::printf("%-36s %8.2f FRS transactions/settings change, %lu commits\n", "5 setters staged, one commit",
+                transactions() / cycles, (unsigned long)imu_frs_cache_get_stats().commits);
+    }
+
+    /// @return stream time of the first HIGH accuracy rotation vector in ms, -1 if it never got there
+    double replay_to_high_ms(const std::vector<bno08x_sim_sample_t>& stream)
+    {
+        uint32_t seq = 0;
+        for (const bno08x_sim_sample_t& sample : stream)
+        {
+            bno08x_sim::inject(sample);
+            imu_sample_t latest;
+            if (imu_latest_read_new(SH2_ROTATION_VECTOR, latest, seq) &&
+                    latest.accuracy == static_cast<uint8_t>(BNO08xAccuracy::HIGH))
+                return sample.t_us / 1000.0;
+        }
+        return -1.0;
+    }
+
+    /**
+     * Boot to HIGH accuracy rotation vector (stream time) on a cold boot without
+     * a snapshot, a blank hub restored from NVS, a hub that kept its DCD, and the
+     * boot after the snapshot ages out.
+     */
+    void bench_cal_restore()
+    {
+        std::printf("\n== DCD persistence (boot to HIGH accuracy rotation vector) ==\n");
+        static constexpr const char* result_str[] = {"none", "written", "current", "stale", "corrupt", "failed"};
+
+        const uint8_t rv = SH2_ROTATION_VECTOR;
+        std::vector<bno08x_sim_sample_t> stream;
+        bno08x_sim::generate(bno08x_sim_profile_t::WALK, &rv, 1, 10000UL, 300000000UL, stream);
+        imu_latest_start();
+
+        auto boot = [&](const char* label, bool keep_flash) {
+            bno08x_sim::power_cycle(keep_flash);
+            bno08x_sim::reset_stats();
+            imu_init();
+            imu_enable_rpt(SH2_ROTATION_VECTOR, 10000UL);
+            const double high_ms = replay_to_high_ms(stream);
+            const imu_cal_stats_t cal = imu_cal_get_stats();
+            std::printf("%-36s %10.0f ms to HIGH, restore %-7s (age %lu boots), %lu FRS writes\n", label, high_ms,
+                    result_str[cal.restore], (unsigned long)cal.snapshot_age_boots,
+                    (unsigned long)bno08x_sim::stats().frs_writes);
+        };
+
+        nvs_flash_erase();
+        boot("cold boot, nothing stored", false);
+        if (!imu_cal_save_if_converged())
+            std::printf("snapshot was not taken\n");
+
+        boot("cold boot, blank hub, NVS snapshot", false);
+        boot("warm boot, hub kept its DCD", true);
+
+        while (imu_cal_get_stats().snapshot_age_boots < IMU_CAL_MAX_AGE_BOOTS)
+            imu_init();
+        boot("boot after the snapshot aged out", false);
+
+        imu_cal_erase();
+        imu_disable_all_rpts();
+    }
+
+    /**
+     * Sample codec: compression ratio against compact (12 B) and imu_sample_t
+     * (24 B) records for sleep, walk and run sessions (and a CSV recording when
+     * given), with each predictor option turned off and with larger blocks to
+     * show what they buy, encode / decode throughput, and a lossless check of
+     * every block. The facing south session is a rotation vector alone near a
+     * half turn, where the stored real >= 0 quaternion keeps flipping sign.
+     */
+    void bench_codec(const std::vector<bno08x_sim_sample_t>& recording, bool have_recording)
+    {
+        std::printf("\n== sample codec ==\n");
+        std::printf("%-22s %-14s %8s %8s %8s %8s %9s %9s %8s\n", "session", "options", "samples", "B/sample",
+                "vs 12 B", "vs 24 B", "enc MB/s", "dec MB/s", "lossless");
+
+        struct session_t {
+            const char* label;
+            std::vector<imu_compact_sample_t> records;
+        };
+        std::vector<session_t> sessions;
+        const bno08x_sim_profile_t profiles[] = {bno08x_sim_profile_t::SLEEP, bno08x_sim_profile_t::WALK,
+                                                 bno08x_sim_profile_t::RUN};
+        const char* labels[] = {"sleep 60 s", "walk 60 s", "run 60 s"};
+        for (size_t i = 0; i < 3; i++)
+        {
+            std::vector<bno08x_sim_sample_t> stream;
+            bno08x_sim::generate(profiles[i], processing_rpts, sizeof(processing_rpts), 10000UL, 60000000UL, stream);
+            sessions.push_back({labels[i], replay_compact(stream)});
+        }
+        if (have_recording)
+            sessions.push_back({"recording (--csv)", replay_compact(recording)});
+
+        // rotation vector of a pet facing south: yaw ~180 deg puts the real part near 0, so the stored
+        // real >= 0 form flips the sign of i, j, k whenever the head swings across it
+        session_t spin = {"RV facing south 60 s", {}};
+        for (uint32_t i = 0; i < 6000; i++)
+        {
+            const float t = static_cast<float>(i) * 0.01f;
+            const float yaw = 3.14159265f + 0.15f * std::sin(6.2831853f * 0.5f * t) + 0.05f * std::sin(6.2831853f * 3.1f * t);
+            const float pitch = 0.1f * std::sin(6.2831853f * 2.0f * t);
+            imu_sample_t q = {};
+            q.timestamp_us = i * 10000UL;
+            q.report_id = SH2_ROTATION_VECTOR;
+            q.accuracy = 3;
+            q.data.quat = {std::cos(0.5f * yaw) * std::cos(0.5f * pitch), -std::sin(0.5f * yaw) * std::sin(0.5f * pitch),
+                           std::cos(0.5f * yaw) * std::sin(0.5f * pitch), std::sin(0.5f * yaw) * std::cos(0.5f * pitch)};
+            imu_compact_sample_t record;
+            imu_compact_pack(q, record);
+            spin.records.push_back(record);
+        }
+        sessions.push_back(spin);
+
+        auto encode_all = [](auto& encoder, const std::vector<imu_compact_sample_t>& records, std::vector<uint8_t>& blocks,
+                std::vector<uint32_t>& offsets) {
+            auto take_block = [&]() {
+                offsets.push_back(static_cast<uint32_t>(blocks.size()));
+                blocks.insert(blocks.end(), encoder.block(), encoder.block() + encoder.size());
+                encoder.start_block();
+            };
+            for (const imu_compact_sample_t& record : records)
+            {
+                if (!encoder.push(record))
+                {
+                    take_block();
+                    encoder.push(record);
+                }
+            }
+            if (encoder.samples() != 0)
+                take_block();
+            offsets.push_back(static_cast<uint32_t>(blocks.size()));
+        };
+
+        auto run = [&](const session_t& session, const char* option, auto& encoder) {
+            const std::vector<imu_compact_sample_t>& records = session.records;
+            std::vector<uint8_t> blocks;
+            std::vector<uint32_t> offsets;
+            const auto enc_start = bench::clock_t::now();
+            encode_all(encoder, records, blocks, offsets);
+            const double enc_ns = bench::elapsed_ns(enc_start, bench::clock_t::now());
+
+            std::vector<imu_compact_sample_t> decoded(records.size());
+            size_t n = 0;
+            const auto dec_start = bench::clock_t::now();
+            for (size_t b = 0; b + 1 < offsets.size(); b++)
+                n += imu_codec_decode_block(blocks.data() + offsets[b], offsets[b + 1] - offsets[b], decoded.data() + n,
+                        decoded.size() - n);
+            const double dec_ns = bench::elapsed_ns(dec_start, bench::clock_t::now());
+
+            const bool lossless = n == records.size() &&
+                    std::memcmp(decoded.data(), records.data(), n * sizeof(imu_compact_sample_t)) == 0;
+            const double in_mb = static_cast<double>(records.size() * sizeof(imu_compact_sample_t)) / 1e6;
+            const double per_sample = static_cast<double>(blocks.size()) / records.size();
+            std::printf("%-22s %-14s %8zu %8.2f %7.2fx %7.2fx %9.1f %9.1f %8s\n", session.label, option, records.size(),
+                    per_sample, sizeof(imu_compact_sample_t) / per_sample, sizeof(imu_sample_t) / per_sample,
+                    in_mb / (enc_ns * 1e-9), in_mb / (dec_ns * 1e-9), lossless ? "yes" : "NO");
+        };
+
+        for (const session_t& session : sessions)
+        {
+            if (session.records.empty())
+                continue;
+
+            imu_codec_encoder full;
+            imu_codec_encoder no_quat(IMU_CODEC_F_ADAPTIVE);
+            imu_codec_encoder order1(IMU_CODEC_F_QUAT_TRACK);
+            imu_codec_encoder_t<1024> kb1;
+            imu_codec_encoder_t<4096> kb4;
+            run(session, "244 B blocks", full);
+            run(session, "no quat track", no_quat);
+            run(session, "order 1 only", order1);
+            run(session, "1 KB blocks", kb1);
+            run(session, "4 KB blocks", kb4);
+        }
+
+        // the ingestion path cost: one push per sample, a block handed off every ~60
+        const std::vector<imu_compact_sample_t>& walk = sessions[1].records;
+        imu_codec_encoder encoder;
+        bench::print_latency("imu_codec_encoder::push", bench::measure(walk.size(), [&](uint64_t i) {
+            if (!encoder.push(walk[i % walk.size()]))
+            {
+                encoder.start_block();
+                encoder.push(walk[i % walk.size()]);
+            }
+        }));
+    }
+
+    /**
+     * Filter bank: ns per accel sample for each imu_dsp filter fed one sample
+     * at a time against whole IMU_DSP_BLOCK_LEN blocks, and the largest
+     * difference between the two outputs. The chain row starts from drained
+     * samples of the whole report set: per sample report check against
+     * imu_dsp_gather(), then gravity removal, a 4th order low pass, moving
+     * variance and decimation by 4.
+     */
+    void bench_dsp(const std::vector<bno08x_sim_sample_t>& stream)
+    {
+        std::printf("\n== dsp filter bank ==\n");
+
+        std::vector<imu_sample_t> drained;
+        for (const bno08x_sim_sample_t& in : stream)
+        {
+            if (imu_sample_kind(in.report_id) != IMU_SAMPLE_VEC)
+                continue;
+            imu_sample_t s = {};
+            s.timestamp_us = in.t_us;
+            s.report_id = in.report_id;
+            s.data.vec = {in.v[0], in.v[1], in.v[2]};
+            drained.push_back(s);
+        }
+
+        std::vector<imu_dsp_block_t> blocks(1);
+        blocks.back().n = 0;
+        for (size_t i = 0; i < drained.size();)
+        {
+            i += imu_dsp_gather(drained.data() + i, drained.size() - i, SH2_ACCELEROMETER, blocks.back());
+            if (blocks.back().n == IMU_DSP_BLOCK_LEN)
+                blocks.push_back({});
+        }
+        if (blocks.back().n == 0)
+            blocks.pop_back();
+        size_t n_samples = 0;
+        for (const imu_dsp_block_t& b : blocks)
+            n_samples += b.n;
+
+        constexpr int PASSES = 20;
+        std::printf("%zu accel samples in %zu blocks of %d, %d passes\n", n_samples, blocks.size(), IMU_DSP_BLOCK_LEN,
+                PASSES);
+        std::printf("%-36s %10s %10s %8s %12s\n", "filter", "scalar ns", "block ns", "speedup", "max |diff|");
+
+        // scalar(v) filters v in place and returns whether it is an output, block(b) filters b in place
+        auto run = [&](const char* name, auto&& reset, auto&& scalar, auto&& block) {
+            // outputs land in the same SoA blocks either way, so the two differ only in how the filter is called
+            std::vector<imu_dsp_block_t> out_scalar(blocks.size());
+            std::vector<imu_dsp_block_t> out_block(blocks.size());
+
+            double scalar_ns = 0.0;
+            for (int pass = 0; pass < PASSES; pass++)
+            {
+                reset();
+                const auto start = bench::clock_t::now();
+                for (size_t k = 0; k < blocks.size(); k++)
+                {
+                    const imu_dsp_block_t& b = blocks[k];
+                    imu_dsp_block_t& out = out_scalar[k];
+                    out.n = 0;
+                    for (size_t i = 0; i < b.n; i++)
+                    {
+                        float v[IMU_DSP_AXES] = {b.axis[0][i], b.axis[1][i], b.axis[2][i]};
+                        if (scalar(v))
+                        {
+                            for (int a = 0; a < IMU_DSP_AXES; a++)
+                                out.axis[a][out.n] = v[a];
+                            out.n++;
+                        }
+                    }
+                }
+                scalar_ns += bench::elapsed_ns(start, bench::clock_t::now());
+            }
+
+            double block_ns = 0.0;
+            for (int pass = 0; pass < PASSES; pass++)
+            {
+                reset();
+                const auto start = bench::clock_t::now();
+                for (size_t k = 0; k < blocks.size(); k++)
+                {
+                    out_block[k] = blocks[k];
+                    block(out_block[k]);
+                }
+                block_ns += bench::elapsed_ns(start, bench::clock_t::now());
+            }
+
+            double max_diff = 0.0;
+            for (size_t k = 0; k < blocks.size(); k++)
+            {
+                if (out_scalar[k].n != out_block[k].n)
+                    max_diff = INFINITY;
+                for (size_t i = 0; i < out_scalar[k].n && i < out_block[k].n; i++)
+                    for (int a = 0; a < IMU_DSP_AXES; a++)
+                        max_diff = std::max(max_diff,
+                                static_cast<double>(std::fabs(out_scalar[k].axis[a][i] - out_block[k].axis[a][i])));
+            }
+
+            const double per = 1.0 / (static_cast<double>(PASSES) * n_samples);
+            std::printf("%-36s %10.2f %10.2f %7.2fx %12.3g\n", name, scalar_ns * per, block_ns * per,
+                    scalar_ns / block_ns, max_diff);
+        };
+
+        constexpr float FS_HZ = 100.0f;
+        imu_dsp_biquad_t lp4[2];
+        imu_dsp_biquad_t lp8[4];
+        imu_dsp_butterworth_lowpass(lp4, 2, 10.0f, FS_HZ);
+        imu_dsp_butterworth_lowpass(lp8, 4, 10.0f, FS_HZ);
+
+        imu_dsp_cascade cascade;
+        cascade.configure(lp4, 2);
+        run("biquad x2 (4th order low pass)", [&] { cascade.reset(); },
+                [&](float* v) { cascade.process(v); return true; },
+                [&](imu_dsp_block_t& b) { cascade.process(b); });
+
+        cascade.configure(lp8, 4);
+        run("biquad x4 (8th order low pass)", [&] { cascade.reset(); },
+                [&](float* v) { cascade.process(v); return true; },
+                [&](imu_dsp_block_t& b) { cascade.process(b); });
+
+        imu_dsp_moving_stats stats;
+        stats.configure(64);
+        run("moving mean + variance (64)", [&] { stats.reset(); },
+                [&](float* v) { float mean[IMU_DSP_AXES]; stats.process(v, mean, v); return true; },
+                [&](imu_dsp_block_t& b) { imu_dsp_block_t mean; stats.process(b, &mean, &b); });
+
+        imu_dsp_gravity_hp gravity;
+        gravity.configure(0.3f, FS_HZ);
+        run("gravity high pass (0.3 Hz)", [&] { gravity.reset(); },
+                [&](float* v) { gravity.process(v); return true; },
+                [&](imu_dsp_block_t& b) { gravity.process(b); });
+
+        imu_dsp_decimator decimator;
+        decimator.configure(4, FS_HZ);
+        run("decimate by 4 (2 biquads)", [&] { decimator.reset(); },
+                [&](float* v) { return decimator.process(v); },
+                [&](imu_dsp_block_t& b) { decimator.process(b); });
+
+        // the chain starts from the drained mix of reports, timed per accel sample
+        auto reset_chain = [&] {
+            gravity.reset();
+            cascade.configure(lp4, 2);
+            stats.reset();
+            decimator.reset();
+        };
+        auto chain_scalar = [&](float* v) {
+            gravity.process(v);
+            cascade.process(v);
+            stats.process(v, nullptr, v);
+            return decimator.process(v);
+        };
+        auto chain_block = [&](imu_dsp_block_t& b) {
+            gravity.process(b);
+            cascade.process(b);
+            stats.process(b, nullptr, &b);
+            decimator.process(b);
+        };
+
+        double scalar_ns = 0.0;
+        double block_ns = 0.0;
+        size_t kept_scalar = 0;
+        size_t kept_block = 0;
+        for (int pass = 0; pass < PASSES; pass++)
+        {
+            reset_chain();
+            auto start = bench::clock_t::now();
+            for (const imu_sample_t& s : drained)
+            {
+                if (s.report_id != SH2_ACCELEROMETER)
+                    continue;
+                float v[IMU_DSP_AXES] = {s.data.vec.x, s.data.vec.y, s.data.vec.z};
+                if (chain_scalar(v))
+                {
+                    kept_scalar++;
+                    bench::do_not_optimize(v);
+                }
+            }
+            scalar_ns += bench::elapsed_ns(start, bench::clock_t::now());
+
+            reset_chain();
+            start = bench::clock_t::now();
+            imu_dsp_block_t b;
+            b.n = 0;
+            for (size_t i = 0; i < drained.size();)
+            {
+                i += imu_dsp_gather(drained.data() + i, drained.size() - i, SH2_ACCELEROMETER, b);
+                if (b.n == IMU_DSP_BLOCK_LEN || i == drained.size())
+                {
+                    chain_block(b);
+                    kept_block += b.n;
+                    bench::do_not_optimize(b);
+                    b.n = 0;
+                }
+            }
+            block_ns += bench::elapsed_ns(start, bench::clock_t::now());
+        }
+        const double per = 1.0 / (static_cast<double>(PASSES) * n_samples);
+        std::printf("%-36s %10.2f %10.2f %7.2fx %12s\n", "chain from drained samples", scalar_ns * per,
+                block_ns * per, scalar_ns / block_ns, (kept_scalar == kept_block) ? "same count" : "COUNT DIFFERS");
+    }
+
+    /**
+     * Feature engine: the data_processing_task report set (accel, gyro, magf,
+     * rotation vector, activity at 100 Hz) drained from the ring for 60 s
+     * sleep, walk and run sessions. Prints mean feature values per session
+     * as a sanity check (the walk gait is 2 Hz, its |accel| peak follows it),
+     * ns per drained sample, the cost of the hops that emit a vector, and
+     * the share of one core the engine takes at 100 Hz.
+     */
+    void bench_features()
+    {
+        std::printf("\n== behavior features ==\n");
+        behavior_features_config_t config;
+        std::printf("window %d samples, hop %u, %d features per vector, engine %zu B\n", BEHAVIOR_WINDOW,
+                (unsigned)config.hop, BEHAVIOR_F_COUNT, sizeof(behavior_feature_engine));
+
+        const behavior_feature_id_t shown[] = {BEHAVIOR_F_ACC_DOM_HZ, BEHAVIOR_F_ACC_DOM_SHARE, BEHAVIOR_F_ACC_ENERGY,
+                                               BEHAVIOR_F_ACC_ZCR_HZ, BEHAVIOR_F_ACC_JERK, BEHAVIOR_F_GYRO_ENERGY,
+                                               BEHAVIOR_F_ORIENT_CHANGE};
+        std::printf("%-10s %8s", "session", "vectors");
+        for (behavior_feature_id_t id : shown)
+            std::printf(" %13s", behavior_feature_to_str(id));
+        std::printf("\n");
+
+        const bno08x_sim_profile_t profiles[] = {bno08x_sim_profile_t::SLEEP, bno08x_sim_profile_t::WALK,
+                                                 bno08x_sim_profile_t::RUN};
+        const char* labels[] = {"sleep", "walk", "run"};
+        struct timing_t {
+            double ns_per_sample;
+            double samples_per_s;
+            std::vector<double> hop_ns;
+        };
+        std::vector<timing_t> timings;
+
+        static behavior_feature_engine engine;
+        for (size_t p = 0; p < 3; p++)
+        {
+            std::vector<bno08x_sim_sample_t> stream;
+            bno08x_sim::generate(profiles[p], processing_rpts, sizeof(processing_rpts), 10000UL, 60000000UL, stream);
+            const std::vector<imu_sample_t> samples = replay_samples(stream);
+
+            engine.configure(config);
+            std::vector<behavior_features_t> vectors(samples.size() / config.hop + 1);
+            size_t n_vectors = 0;
+            for (const imu_sample_t& s : samples)
+                n_vectors += engine.push(s, vectors[n_vectors]) ? 1 : 0;
+
+            double mean[BEHAVIOR_F_COUNT] = {};
+            for (size_t i = 0; i < n_vectors; i++)
+                for (int f = 0; f < BEHAVIOR_F_COUNT; f++)
+                    mean[f] += vectors[i].v[f] / static_cast<double>(n_vectors);
+            std::printf("%-10s %8zu", labels[p], n_vectors);
+            for (behavior_feature_id_t id : shown)
+                std::printf(" %13.3f", mean[id]);
+            std::printf("\n");
+
+            // whole stream in one go for the per sample cost, then hop by hop for the emitting calls
+            timing_t t;
+            constexpr int PASSES = 10;
+            auto start = bench::clock_t::now();
+            for (int pass = 0; pass < PASSES; pass++)
+            {
+                engine.reset();
+                size_t consumed = 0;
+                while (consumed < samples.size())
+                {
+                    size_t n_out = 0;
+                    consumed += engine.push(samples.data() + consumed, samples.size() - consumed, vectors.data(),
+                            vectors.size(), n_out);
+                }
+            }
+            t.ns_per_sample = bench::elapsed_ns(start, bench::clock_t::now()) / (PASSES * samples.size());
+            t.samples_per_s = samples.size() / 60.0;
+
+            engine.reset();
+            behavior_features_t out;
+            for (const imu_sample_t& s : samples)
+            {
+                start = bench::clock_t::now();
+                const bool emitted = engine.push(s, out);
+                const double ns = bench::elapsed_ns(start, bench::clock_t::now());
+                if (emitted)
+                    t.hop_ns.push_back(ns);
+            }
+            std::sort(t.hop_ns.begin(), t.hop_ns.end());
+            timings.push_back(std::move(t));
+        }
+
+        std::printf("%-10s %12s %12s %12s %12s %14s\n", "session", "ns/sample", "hop p50 us", "hop p99 us",
+                "samples/s", "core % host");
+        for (size_t p = 0; p < timings.size(); p++)
+        {
+            const timing_t& t = timings[p];
+            const double hop_p50 = t.hop_ns.empty() ? 0.0 : t.hop_ns[t.hop_ns.size() / 2] * 1e-3;
+            const double hop_p99 = t.hop_ns.empty() ? 0.0 : t.hop_ns[(t.hop_ns.size() * 99) / 100] * 1e-3;
+            std::printf("%-10s %12.1f %12.2f %12.2f %12.0f %13.4f%%\n", labels[p], t.ns_per_sample, hop_p50, hop_p99,
+                    t.samples_per_s, t.ns_per_sample * t.samples_per_s * 1e-9 * 100.0);
+        }
+    }
+    /**
+     * Behavior classifier: the int8 model on feature vectors of each simulated
+     * behavior drained through the driver (sessions the weights were not
+     * trained on), inference latency, static footprint, and the uplink a
+     * phone side classifier would need for the same answer.
+     */
+    void bench_classifier(uint64_t iterations)
+    {
+        std::printf("\n== behavior classifier ==\n");
+        const behavior_model_t& model = behavior_default_model();
+        size_t weight_bytes = sizeof(float) * BEHAVIOR_F_COUNT;
+        size_t macs = 0;
+        for (size_t i = 0; i < model.n_layers; i++)
+        {
+            const behavior_layer_t& l = model.layers[i];
+            const size_t n = l.type == BEHAVIOR_LAYER_DENSE ? size_t(l.in_len) * l.in_ch : size_t(l.kernel) * l.in_ch;
+            weight_bytes += l.out_ch * (n + sizeof(int32_t) * 2 + 1);
+            macs += behavior_layer_out_len(l) * l.out_ch * n;
+        }
+        std::printf("%zu layers, %zu MAC per inference, weights %zu B (flash), arena %d B + classifier %zu B (static)\n",
+                model.n_layers, macs, weight_bytes, BEHAVIOR_ARENA_BYTES, sizeof(behavior_classifier));
+
+        const bno08x_sim_profile_t profiles[BEHAVIOR_CLASS_COUNT] = {
+            bno08x_sim_profile_t::SLEEP,   bno08x_sim_profile_t::WALK, bno08x_sim_profile_t::RUN,
+            bno08x_sim_profile_t::SCRATCH, bno08x_sim_profile_t::EAT,  bno08x_sim_profile_t::SHAKE,
+        };
+        static behavior_feature_engine engine;
+        behavior_classifier classifier;
+        std::vector<int8_t> inputs;
+        double samples_per_s = 0.0, results_per_s = 0.0;
+        std::printf("%-12s %8s %10s %10s  %s\n", "session", "results", "correct %", "margin", "most common other");
+        for (size_t c = 0; c < BEHAVIOR_CLASS_COUNT; c++)
+        {
+            std::vector<bno08x_sim_sample_t> stream;
+            bno08x_sim::generate(profiles[c], processing_rpts, sizeof(processing_rpts), 10000UL, 60000000UL, stream,
+                    4242U + c);
+            const std::vector<imu_sample_t> samples = replay_samples(stream);
+            engine.configure(behavior_features_config_t{});
+            classifier.configure();
+
+            size_t results = 0, correct = 0, margin = 0;
+            size_t other[BEHAVIOR_CLASS_COUNT] = {};
+            behavior_features_t v;
+            behavior_result_t r;
+            for (const imu_sample_t& s : samples)
+            {
+                if (!engine.push(s, v))
+                    continue;
+                int8_t q[BEHAVIOR_F_COUNT];
+                behavior_quantize_input(model, v, q);
+                inputs.insert(inputs.end(), q, q + BEHAVIOR_F_COUNT);
+                if (!classifier.push(v, r))
+                    continue;
+                results++;
+                correct += r.cls == c;
+                margin += r.margin;
+                other[r.cls] += r.cls != c;
+            }
+            size_t worst = c == 0 ? 1 : 0;
+            for (size_t o = 0; o < BEHAVIOR_CLASS_COUNT; o++)
+                worst = (o != c && other[o] > other[worst]) ? o : worst;
+            std::printf("%-12s %8zu %10.1f %10.1f  %s (%zu)\n", behavior_class_to_str(behavior_class_t(c)), results,
+                    100.0 * correct / results, static_cast<double>(margin) / results,
+                    behavior_class_to_str(behavior_class_t(worst)), other[worst]);
+            samples_per_s += samples.size() / 60.0 / double(BEHAVIOR_CLASS_COUNT);
+            results_per_s += results / 60.0 / double(BEHAVIOR_CLASS_COUNT);
+        }
+
+        const size_t n_inputs = inputs.size() / BEHAVIOR_F_COUNT - model.in_len + 1;
+        int8_t logits[BEHAVIOR_CLASS_COUNT];
+        std::printf("%-36s %12s %10s %10s %10s %10s\n", "path", "calls", "mean ns", "p50 ns", "p99 ns", "max ns");
+        bench::print_latency("behavior_model_run", bench::measure(iterations, [&](uint64_t i) {
+            behavior_model_run(model, inputs.data() + (i % n_inputs) * BEHAVIOR_F_COUNT, logits);
+            bench::do_not_optimize(logits);
+        }));
+        behavior_features_t v = {};
+        behavior_result_t r;
+        classifier.configure();
+        bench::print_latency("behavior_classifier::push", bench::measure(iterations, [&](uint64_t i) {
+            v.v[BEHAVIOR_F_ACC_DOM_HZ] = static_cast<float>(i % 8);
+            bench::do_not_optimize(classifier.push(v, r));
+        }));
+
+        std::printf("uplink for the same answer: raw samples %.0f B/s, results %.1f B/s (%zu B each)\n",
+                samples_per_s * sizeof(imu_sample_t), results_per_s * sizeof(behavior_result_t),
+                sizeof(behavior_result_t));
+    }
+
+    /**
+     * Rate governor: a scripted stretch of a day (sleep, restless sleep with
+     * one second twitches, walk, run, walk, eat, sleep) generated at the
+     * fastest governed rate and thinned to whatever period each report is
+     * live at, as the hub would deliver it, then drained through the driver
+     * into rg_feed(). Prints the level timeline, the delay from each motion
+     * onset to the matching level, the changes without hysteresis and dwell
+     * (thrash), and samples delivered against fixed rate report sets.
+     */
+    void bench_rate_governor()
+    {
+        std::printf("\n== rate governor ==\n");
+        const rg_rpt_rates_t rates[] = {
+            {SH2_ACCELEROMETER, {100000UL, 20000UL, 5000UL}},
+            {SH2_GYROSCOPE_CALIBRATED, {200000UL, 20000UL, 5000UL}},
+            {SH2_MAGNETIC_FIELD_CALIBRATED, {500000UL, 100000UL, 50000UL}},
+            {SH2_ROTATION_VECTOR, {200000UL, 20000UL, 10000UL}},
+        };
+        constexpr size_t N_RATES = sizeof(rates) / sizeof(rates[0]);
+        const uint8_t stream_rpts[] = {SH2_ACCELEROMETER, SH2_GYROSCOPE_CALIBRATED, SH2_MAGNETIC_FIELD_CALIBRATED,
+                                       SH2_ROTATION_VECTOR, SH2_PERSONAL_ACTIVITY_CLASSIFIER,
+                                       SH2_STABILITY_CLASSIFIER};
+        constexpr uint32_t GRID_US = 5000UL;
+
+        struct segment_t {
+            const char* label;
+            bno08x_sim_profile_t profile;
+            uint32_t duration_s;
+            rg_level_t expected;
+        };
+        const segment_t segments[] = {
+            {"sleep", bno08x_sim_profile_t::SLEEP, 60, RG_LEVEL_REST},
+            {"twitchy", bno08x_sim_profile_t::SLEEP, 30, RG_LEVEL_CALM},
+            {"walk", bno08x_sim_profile_t::WALK, 30, RG_LEVEL_CALM},
+            {"run", bno08x_sim_profile_t::RUN, 20, RG_LEVEL_VIGOROUS},
+            {"walk", bno08x_sim_profile_t::WALK, 20, RG_LEVEL_CALM},
+            {"eat", bno08x_sim_profile_t::EAT, 30, RG_LEVEL_CALM},
+            {"sleep", bno08x_sim_profile_t::SLEEP, 60, RG_LEVEL_REST},
+        };
+        constexpr size_t N_SEGMENTS = sizeof(segments) / sizeof(segments[0]);
+
+        // the twitchy segment is 2 s of sleep and 1 s of walking in turn
+        std::vector<bno08x_sim_sample_t> stream;
+        uint32_t seg_start_us[N_SEGMENTS + 1] = {};
+        uint32_t t0_us = 0;
+        for (size_t g = 0; g < N_SEGMENTS; g++)
+        {
+            seg_start_us[g] = t0_us;
+            const bool twitchy = std::strcmp(segments[g].label, "twitchy") == 0;
+            const uint32_t chunk_s = twitchy ? 1 : segments[g].duration_s;
+            for (uint32_t c = 0; c < segments[g].duration_s; c += chunk_s)
+            {
+                const bno08x_sim_profile_t profile =
+                        twitchy && (c % 3) == 2 ? bno08x_sim_profile_t::WALK : segments[g].profile;
+                std::vector<bno08x_sim_sample_t> chunk;
+                bno08x_sim::generate(profile, stream_rpts, sizeof(stream_rpts), GRID_US, chunk_s * 1000000UL, chunk,
+                        77U + static_cast<uint32_t>(g * 1000 + c));
+                for (bno08x_sim_sample_t& sample : chunk)
+                    sample.t_us += t0_us;
+                stream.insert(stream.end(), chunk.begin(), chunk.end());
+                t0_us += chunk_s * 1000000UL;
+            }
+        }
+        seg_start_us[N_SEGMENTS] = t0_us;
+        const double total_s = t0_us * 1e-6;
+
+        struct run_t {
+            size_t delivered = 0;
+            size_t changes = 0;
+            std::vector<std::pair<uint32_t, rg_level_t>> timeline;
+            rg_stats_t stats = {};
+            double feed_ns = 0.0;
+        };
+        auto run = [&](const rg_config_t& config) {
+            run_t r;
+            imu_disable_all_rpts();
+            imu_enable_rpt(SH2_PERSONAL_ACTIVITY_CLASSIFIER, 1000000UL);
+            imu_enable_rpt(SH2_STABILITY_CLASSIFIER, 1000000UL);
+            imu_sample_ring_start();
+            imu_sample_t drained[64];
+            while (imu_sample_ring_drain(drained, 64) > 0) {}
+            rg_init(config);
+            r.timeline.push_back({0U, rg_get_level()});
+
+            uint32_t last_us[SH2_MAX_SENSOR_ID + 1] = {};
+            bool seen[SH2_MAX_SENSOR_ID + 1] = {};
+            for (const bno08x_sim_sample_t& sample : stream)
+            {
+                // the hub only produces a report at its live period
+                imu_report_cfg_t live;
+                if (!imu_get_rpt_cfg(sample.report_id, live))
+                    continue;
+                if (seen[sample.report_id] && sample.t_us - last_us[sample.report_id] < live.period_us)
+                    continue;
+                seen[sample.report_id] = true;
+                last_us[sample.report_id] = sample.t_us;
+
+                bno08x_sim::inject(sample);
+                const size_t n = imu_sample_ring_drain(drained, 64);
+                for (size_t i = 0; i < n; i++)
+                    drained[i].timestamp_us = sample.t_us;
+                r.delivered += n;
+                const auto start = bench::clock_t::now();
+                const bool changed = rg_feed(drained, n);
+                r.feed_ns += bench::elapsed_ns(start, bench::clock_t::now());
+                if (changed)
+                {
+                    r.changes++;
+                    r.timeline.push_back({sample.t_us, rg_get_level()});
+                }
+            }
+            r.stats = rg_get_stats();
+            imu_disable_all_rpts();
+            return r;
+        };
+
+        rg_config_t config;
+        config.rates = rates;
+        config.rate_count = N_RATES;
+        const run_t governed = run(config);
+
+        rg_config_t bare = config;
+        bare.hysteresis = 0.0f;
+        bare.up_dwell_ms = 0;
+        bare.down_dwell_ms = 0;
+        const run_t thrash = run(bare);
+
+        std::printf("%.0f s script, eval %lu ms, dwell up %lu / down %lu ms, hysteresis %.0f%%, governor %zu B "
+                    "(static)\n", total_s, (unsigned long)config.eval_period_ms, (unsigned long)config.up_dwell_ms,
+                (unsigned long)config.down_dwell_ms, config.hysteresis * 100.0f,
+                sizeof(rg_config_t) + sizeof(rg_rpt_rates_t) * RG_MAX_RPTS + sizeof(rg_stats_t));
+        std::printf("%-10s %8s %10s  %-12s %10s\n", "segment", "start s", "expected", "level at end", "reached s");
+        for (size_t g = 0; g < N_SEGMENTS; g++)
+        {
+            // level in force at the end of the segment, and when it was first reached inside it
+            rg_level_t at_end = governed.timeline.front().second;
+            double reached_s = -1.0;
+            for (const auto& [t_us, level] : governed.timeline)
+            {
+                if (t_us >= seg_start_us[g + 1])
+                    break;
+                at_end = level;
+                if (t_us >= seg_start_us[g] && level == segments[g].expected && reached_s < 0.0)
+                    reached_s = (t_us - seg_start_us[g]) * 1e-6;
+            }
+            char reached[16];
+            if (reached_s >= 0.0)
+                std::snprintf(reached, sizeof(reached), "%.2f", reached_s);
+            else
+                std::snprintf(reached, sizeof(reached), "%s", at_end == segments[g].expected ? "held" : "-");
+            std::printf("%-10s %8.0f %10s  %-12s %10s\n", segments[g].label, seg_start_us[g] * 1e-6,
+                    rg_level_to_str(segments[g].expected), rg_level_to_str(at_end), reached);
+        }
+
+        std::printf("%-28s %8s %8s %10s %10s %10s %10s\n", "governor", "changes", "held", "commands", "rest %",
+                "calm %", "vigor. %");
+        const run_t* runs[] = {&governed, &thrash};
+        const char* names[] = {"hysteresis + dwell", "no hysteresis, no dwell"};
+        for (size_t i = 0; i < 2; i++)
+        {
+            const rg_stats_t& st = runs[i]->stats;
+            const double total_us = static_cast<double>(st.residency_us[0] + st.residency_us[1] + st.residency_us[2]);
+            std::printf("%-28s %8zu %8lu %10lu %9.1f%% %9.1f%% %9.1f%%\n", names[i], runs[i]->changes,
+                    (unsigned long)st.held, (unsigned long)st.commands, 100.0 * st.residency_us[0] / total_us,
+                    100.0 * st.residency_us[1] / total_us, 100.0 * st.residency_us[2] / total_us);
+        }
+
+        // the same reports at one fixed level for the whole script, classifiers at 1 Hz in every case
+        std::printf("%-28s %12s %12s\n", "report set", "samples/s", "vs governed");
+        const double governed_per_s = governed.delivered / total_s;
+        std::printf("%-28s %12.1f %11.2fx\n", "governed", governed_per_s, 1.0);
+        for (size_t level = 0; level < RG_LEVEL_COUNT; level++)
+        {
+            double per_s = 2.0;
+            for (size_t i = 0; i < N_RATES; i++)
+                per_s += 1e6 / rates[i].period_us[level];
+            char name[32];
+            std::snprintf(name, sizeof(name), "fixed %s", rg_level_to_str(rg_level_t(level)));
+            std::printf("%-28s %12.1f %11.2fx\n", name, per_s, per_s / governed_per_s);
+        }
+        std::printf("rg_feed: %.1f ns per drained sample\n", governed.feed_ns / governed.delivered);
+    }
+
+    /**
+     * Subscriptions: cost of the callback's fan-out with 0 up to every free
+     * slot subscribed to accel, the counts a decimating and a filtering
+     * subscriber see, and whether subscriptions keep delivering after a
+     * disable / enable, a sig motion re-arm and a hard reset.
+     */
+    void bench_subscriptions(uint64_t iterations)
+    {
+        bench::print_header("subscriptions");
+
+        imu_disable_all_rpts();
+        imu_enable_rpt(SH2_ACCELEROMETER, 2500UL);
+        imu_latest_start();
+
+        static uint32_t sink[IMU_MAX_SUBSCRIBERS];
+        auto count = [](const imu_sample_t&, void* arg) { ++*static_cast<uint32_t*>(arg); };
+        std::vector<int> handles;
+        const size_t free_slots = IMU_MAX_SUBSCRIBERS - imu_sub_count();
+        for (size_t n = 0; n <= free_slots; n++)
+        {
+            if (n > 0)
+            {
+                imu_sub_cfg_t cfg;
+                cfg.report_mask = IMU_RPT_BIT(SH2_ACCELEROMETER);
+                cfg.fn = count;
+                cfg.arg = &sink[n - 1];
+                handles.push_back(imu_subscribe(cfg));
+            }
+            if (n != 0 && n != 1 && n != free_slots)
+                continue;
+            char name[48];
+            std::snprintf(name, sizeof(name), "inject, %zu accel subscriber%s", n, n == 1 ? "" : "s");
+            bench::print_latency(name, bench::measure(iterations, [](uint64_t i) {
+                bno08x_sim_sample_t sample;
+                sample.t_us = static_cast<uint32_t>(i);
+                sample.report_id = SH2_ACCELEROMETER;
+                bno08x_sim::inject(sample);
+            }));
+        }
+        for (int h : handles)
+            imu_unsubscribe(h);
+
+        // every report, accel decimated by 4, HIGH accuracy only
+        constexpr uint32_t N = 4000;
+        uint32_t all = 0, quarter = 0, high = 0;
+        imu_sub_cfg_t cfg;
+        cfg.report_mask = IMU_RPT_BIT(SH2_ACCELEROMETER) | IMU_RPT_BIT(SH2_GYROSCOPE_CALIBRATED) |
+                          IMU_RPT_BIT(SH2_SIGNIFICANT_MOTION);
+        cfg.fn = count;
+        cfg.arg = &all;
+        const int h_all = imu_subscribe(cfg);
+        cfg.report_mask = IMU_RPT_BIT(SH2_ACCELEROMETER);
+        cfg.decimation = 4;
+        cfg.arg = &quarter;
+        const int h_quarter = imu_subscribe(cfg);
+        cfg.decimation = 1;
+        cfg.arg = &high;
+        cfg.filter = [](const imu_sample_t& sample, void*) {
+            return sample.accuracy == static_cast<uint8_t>(BNO08xAccuracy::HIGH);
+        };
+        const int h_high = imu_subscribe(cfg);
+
+        auto inject_accel = [](uint32_t n, uint32_t t0) {
+            for (uint32_t i = 0; i < n; i++)
+            {
+                bno08x_sim_sample_t sample;
+                sample.t_us = t0 + i * 2500UL;
+                sample.report_id = SH2_ACCELEROMETER;
+                sample.accuracy = (i & 1U) ? 3 : 1;
+                bno08x_sim::inject(sample);
+            }
+        };
+        inject_accel(N, 0);
+        std::printf("%-36s all %lu, every 4th %lu, HIGH only %lu (of %lu accel)\n", "delivered",
+                (unsigned long)all, (unsigned long)quarter, (unsigned long)high, (unsigned long)N);
+
+        // the library forgets report callbacks on disable and reset, subscriptions belong to the driver
+        struct step_t {
+            const char* label;
+            void (*apply)();
+        };
+        const step_t steps[] = {
+            {"disable + enable", [] {
+                imu_disable_rpt(SH2_ACCELEROMETER);
+                imu_enable_rpt(SH2_ACCELEROMETER, 2500UL);
+            }},
+            {"sig motion re-arm", [] { imu_rearm_sig_motion(); }},
+            {"hard reset + enable", [] {
+                imu_hard_reset();
+                imu_enable_rpt(SH2_ACCELEROMETER, 2500UL);
+            }},
+            {"soft reset + enable", [] {
+                imu_soft_reset();
+                imu_enable_rpt(SH2_ACCELEROMETER, 2500UL);
+            }},
+        };
+        for (const step_t& step : steps)
+        {
+            const uint32_t before = all;
+            step.apply();
+            inject_accel(100, 0);
+            std::printf("%-36s %lu / 100 delivered after\n", step.label, (unsigned long)(all - before));
+        }
+
+        imu_sub_stats_t st;
+        imu_sub_get_stats(h_quarter, st);
+        std::printf("%-36s delivered %lu, decimated %lu, filtered %lu\n", "decimating subscriber",
+                (unsigned long)st.delivered, (unsigned long)st.decimated, (unsigned long)st.filtered);
+        imu_sub_get_stats(h_high, st);
+        std::printf("%-36s delivered %lu, decimated %lu, filtered %lu\n", "filtering subscriber",
+                (unsigned long)st.delivered, (unsigned long)st.decimated, (unsigned long)st.filtered);
+        imu_unsubscribe(h_all);
+        imu_unsubscribe(h_quarter);
+        imu_unsubscribe(h_high);
+        imu_disable_all_rpts();
+    }
+
+    /**
+     * Fault recovery: the 400 Hz accel / gyro set with the classifiers, sig
+     * motion and a non-default calibration config, paced in real time while
+     * the hub resets under it: two unexpected power cycles (the hub silent for
+     * HUB_BOOT_US first, as a real reboot is) and one requested hard reset. A
+     * thread waits on IMU_EVT_HUB_RESET like pm_task. Lost
+     * samples are checked against what the sim actually dropped or never sent.
+     */
+    void bench_recovery()
+    {
+        std::printf("\n== fault recovery (hub resets under a 400 Hz stream) ==\n");
+        constexpr uint32_t FAST_US = 2500UL;
+        constexpr uint32_t HUB_BOOT_US = 50000UL;
+        constexpr uint32_t DURATION_US = 3000000UL;
+        const uint8_t fast_rpts[] = {SH2_ACCELEROMETER, SH2_GYROSCOPE_CALIBRATED};
+        const uint8_t cal_sensors = static_cast<uint8_t>(BNO08xCalSel::accelerometer) |
+                                    static_cast<uint8_t>(BNO08xCalSel::gyro);
+
+        imu_disable_all_rpts();
+        imu_events_start();
+        imu_latest_start();
+        imu_report_cfg_t rpts[] = {
+            {SH2_ACCELEROMETER, FAST_US},
+            {SH2_GYROSCOPE_CALIBRATED, FAST_US},
+            {SH2_ROTATION_VECTOR, 10000UL},
+            {SH2_PERSONAL_ACTIVITY_CLASSIFIER, 1000000UL},
+            {SH2_STABILITY_CLASSIFIER, 1000000UL},
+            {SH2_SIGNIFICANT_MOTION, 100000UL},
+        };
+        imu_enable_multi_rpts(rpts, sizeof(rpts) / sizeof(rpts[0]));
+        imu_set_dynamic_calibration(cal_sensors);
+        const uint64_t desired = imu_get_desired_rpts();
+
+        std::vector<bno08x_sim_sample_t> stream;
+        bno08x_sim::generate(bno08x_sim_profile_t::WALK, fast_rpts, sizeof(fast_rpts), FAST_US, DURATION_US, stream);
+
+        std::atomic<bool> stop{false};
+        std::thread recovery([&]() {
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                if (imu_wait_events(IMU_EVT_HUB_RESET, pdMS_TO_TICKS(10)) & IMU_EVT_HUB_RESET)
+                    imu_recover();
+            }
+        });
+
+        struct fault_t {
+            uint32_t t_us;
+            bool requested;
+        };
+        const fault_t faults[] = {{700000UL, false}, {1500000UL, true}, {2300000UL, false}};
+        size_t next_fault = 0;
+        uint32_t silent_until_us = 0;
+        uint64_t never_sent = 0;
+
+        imu_recovery_reset_stats();
+        bno08x_sim::reset_stats();
+        const auto start = bench::clock_t::now();
+        for (const bno08x_sim_sample_t& sample : stream)
+        {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(sample.t_us));
+            if (next_fault < sizeof(faults) / sizeof(faults[0]) && sample.t_us >= faults[next_fault].t_us)
+            {
+                if (faults[next_fault].requested)
+                    imu_hard_reset();
+                else
+                    silent_until_us = sample.t_us + HUB_BOOT_US;
+                next_fault++;
+            }
+            if (silent_until_us != 0)
+            {
+                if (sample.t_us < silent_until_us)
+                {
+                    never_sent++;
+                    continue;
+                }
+                // back up: the SHTP reset message comes first, then the hub samples again
+                bno08x_sim::power_cycle(true);
+                silent_until_us = 0;
+            }
+            bno08x_sim::inject(sample);
+        }
+        stop.store(true, std::memory_order_relaxed);
+        recovery.join();
+
+        const imu_recovery_stats_t st = imu_recovery_get_stats();
+        const bno08x_sim_stats_t sim = bno08x_sim::stats();
+        const uint64_t actual = never_sent + sim.samples_dropped;
+        std::printf("%-36s %lu (%lu unexpected), %lu replays\n", "hub resets", (unsigned long)st.resets,
+                (unsigned long)st.unexpected, (unsigned long)st.replays);
+        std::printf("%-36s %.1f per replay for %d wanted reports, %lu failed\n", "commands",
+                st.replays ? static_cast<double>(st.commands) / st.replays : 0.0, __builtin_popcountll(desired),
+                (unsigned long)st.failed);
+        std::printf("%-36s last %lu us, max %lu us\n", "reset message -> replayed", (unsigned long)st.last_us,
+                (unsigned long)st.max_us);
+        std::printf("%-36s %llu estimated, %llu actual (%llu during hub boot)\n", "samples lost",
+                (unsigned long long)st.lost, (unsigned long long)actual, (unsigned long long)never_sent);
+        std::printf("%-36s reports %s, calibration %s\n", "hub state after",
+                imu_get_enabled_rpts() == desired ? "match" : "DIFFER",
+                bno08x_sim::cal_config() == cal_sensors ? "match" : "DIFFER");
+
+        imu_set_dynamic_calibration(static_cast<uint8_t>(BNO08xCalSel::all));
+        imu_disable_all_rpts();
+    }
+    /**
+     * Two-core pipeline: the 400 Hz accel / gyro set paced in real time by an
+     * injector task pinned to the ingest core, as the library's SHTP tasks
+     * are, through PROCESS and STORE on the other core. The nominal run uses
+     * a free uplink; the overload runs stall the uplink per codec block until
+     * STORE cannot keep up, and show where each store policy puts the loss.
+     */
+    struct pipeline_injector_t {
+        const std::vector<bno08x_sim_sample_t>* stream;
+        std::atomic<bool> done;
+    };
+
+    void pipeline_inject_task(void* arg)
+    {
+        pipeline_injector_t* inj = static_cast<pipeline_injector_t*>(arg);
+        const auto start = bench::clock_t::now();
+        for (const bno08x_sim_sample_t& sample : *inj->stream)
+        {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(sample.t_us));
+            bno08x_sim::inject(sample);
+        }
+        inj->done.store(true, std::memory_order_release);
+        vTaskDelete(nullptr);
+    }
+
+    std::atomic<uint32_t> uplink_blocks{0};
+    std::atomic<uint32_t> uplink_stall_ms{0};
+
+    void uplink_sink(const uint8_t*, size_t)
+    {
+        uplink_blocks.fetch_add(1, std::memory_order_relaxed);
+        const uint32_t stall_ms = uplink_stall_ms.load(std::memory_order_relaxed);
+        if (stall_ms != 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(stall_ms));
+    }
+
+    void bench_pipeline()
+    {
+        std::printf("\n== two-core pipeline (400 Hz accel + gyro, real time) ==\n");
+        constexpr uint32_t FAST_US = 2500UL;
+        constexpr uint32_t DURATION_US = 3000000UL;
+        const uint8_t fast_rpts[] = {SH2_ACCELEROMETER, SH2_GYROSCOPE_CALIBRATED};
+
+        imu_disable_all_rpts();
+        imu_report_cfg_t rpts[] = {{SH2_ACCELEROMETER, FAST_US}, {SH2_GYROSCOPE_CALIBRATED, FAST_US}};
+        imu_enable_multi_rpts(rpts, 2);
+        std::vector<bno08x_sim_sample_t> stream;
+        bno08x_sim::generate(bno08x_sim_profile_t::WALK, fast_rpts, sizeof(fast_rpts), FAST_US, DURATION_US, stream);
+
+        struct run_t {
+            const char* label;
+            pipeline_policy_t store_policy;
+            uint32_t stall_ms;
+        };
+        const run_t runs[] = {
+            {"nominal, BLOCK", PIPELINE_BLOCK, 0},
+            {"uplink stalls 150 ms/block, BLOCK", PIPELINE_BLOCK, 150},
+            {"uplink stalls 150 ms/block, DROP_OLDEST", PIPELINE_DROP_OLDEST, 150},
+        };
+        for (const run_t& run : runs)
+        {
+            // the pipeline is the ring's only consumer, earlier sections left samples in it
+            static imu_sample_t stale[32];
+            imu_sample_ring_start();
+            while (imu_sample_ring_drain(stale, 32) > 0)
+                ;
+
+            pipeline_config_t cfg;
+            cfg.features.fs_hz = 1e6f / FAST_US;
+            cfg.features.rv_rpt = 0;
+            cfg.store_policy = run.store_policy;
+            cfg.block_sink = uplink_sink;
+            uplink_blocks.store(0, std::memory_order_relaxed);
+            uplink_stall_ms.store(run.stall_ms, std::memory_order_relaxed);
+            if (!pipeline_start(cfg))
+            {
+                std::printf("%-36s pipeline_start failed\n", run.label);
+                continue;
+            }
+
+            static StaticTask_t inject_buf;
+            static StackType_t inject_stack[4096 / sizeof(StackType_t)];
+            pipeline_injector_t inj;
+            inj.stream = &stream;
+            inj.done.store(false, std::memory_order_relaxed);
+            xTaskCreateStaticPinnedToCore(pipeline_inject_task, "inject", sizeof(inject_stack), &inj, 20,
+                    inject_stack, &inject_buf, PIPELINE_INGEST_CORE);
+
+            // an app task taking feature vectors, as the classifier would
+            uint32_t vectors = 0;
+            behavior_features_t fv[PIPELINE_FEATURE_QUEUE_LEN];
+            while (!inj.done.load(std::memory_order_acquire))
+                vectors += pipeline_pop_features(fv, PIPELINE_FEATURE_QUEUE_LEN, pdMS_TO_TICKS(50));
+            // stop stores what is still queued, the counters then cover every sample
+            pipeline_stop();
+            const pipeline_stats_t st = pipeline_get_stats();
+
+            std::printf("%s:\n", run.label);
+            for (int s = 0; s < PIPELINE_STAGE_COUNT; s++)
+            {
+                const pipeline_stage_stats_t& stage = st.stage[s];
+                char name[48];
+                std::snprintf(name, sizeof(name), "  %s (core %d, %lu misplaced)",
+                        pipeline_stage_to_str(static_cast<pipeline_stage_t>(s)), stage.core,
+                        (unsigned long)stage.misplaced);
+                std::printf("%-36s in depth %lu, high %lu/%lu, dropped %lu; busy %.2f%%, run max %lu us, "
+                            "age max %lu us\n",
+                        name, (unsigned long)stage.input.depth, (unsigned long)stage.input.high_water,
+                        (unsigned long)stage.input.capacity, (unsigned long)stage.input.dropped,
+                        st.window_us ? 100.0 * stage.busy_us / st.window_us : 0.0,
+                        (unsigned long)stage.max_run_us, (unsigned long)stage.latency_max_us);
+            }
+            std::printf("%-36s %lu stored of %zu, %lu blocks up, PROCESS blocked %lu ms, %lu vectors\n", "  throughput",
+                    (unsigned long)st.stage[PIPELINE_STAGE_STORE].items, stream.size(),
+                    (unsigned long)uplink_blocks.load(), (unsigned long)(st.stage[PIPELINE_STAGE_STORE].input.blocked_us / 1000),
+                    (unsigned long)vectors);
+            std::printf("%-36s avg %lu us, max %lu us, %lu over %lu ms\n", "  measurement -> stored",
+                    (unsigned long)st.latency_avg_us, (unsigned long)st.stage[PIPELINE_STAGE_STORE].latency_max_us,
+                    (unsigned long)st.late, (unsigned long)cfg.latency_budget_ms);
+        }
+        imu_disable_all_rpts();
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const uint64_t iterations = bench::arg_u64(argc, argv, "--iterations", 1000000ULL);
+    const char* profile = bench::arg_value(argc, argv, "--profile", "walk");
+    const char* csv = bench::arg_value(argc, argv, "--csv", nullptr);
+    const char* flash_image = bench::arg_value(argc, argv, "--flash-log-image", nullptr);
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+    if (!imu_init())
+    {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    std::vector<bno08x_sim_sample_t> stream;
+    if (csv != nullptr)
+    {
+        if (!bno08x_sim::load_csv(csv, stream))
+        {
+            std::fprintf(stderr, "failed to load %s\n", csv);
+            return 1;
+        }
+    }
+    else
+    {
+        // 10 minutes of the data_processing_task report set at 100 Hz
+        bno08x_sim::generate(parse_profile(profile), processing_rpts, sizeof(processing_rpts), 10000UL,
+                600000000UL, stream);
+    }
+
+    bench_call_paths(iterations);
+    bench_callback_throughput(stream);
+    bench_sample_ring(iterations);
+    bench_batching();
+    bench_profile_switch(1000);
+    bench_latest_cache(iterations);
+    bench_deferred_log(iterations);
+    bench_motion_wake(1000);
+    bench_cal_restore();
+    bench_frs_cache(1000);
+    bench_metrics(iterations);
+    bench_clock_sync();
+    bench_compact(iterations);
+    bench_flash_log(stream, flash_image);
+    bench_codec(stream, csv != nullptr);
+    bench_dsp(stream);
+    bench_features();
+    bench_classifier(iterations);
+    bench_rate_governor();
+    bench_subscriptions(iterations);
+    bench_recovery();
+    bench_pipeline();
+    return 0;
+}
@@ -0,0 +1,919 @@
+#include "BNO08x.hpp"
+#include "bno08x_sim.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr float RAD_2_DEG = 57.2957795131f;
+
+    std::atomic<BNO08x*> active_imu{nullptr};
+    std::atomic<uint32_t> reset_msg_delay_us{0};
+    std::atomic<uint32_t> commands_to_reject{0};
+    std::atomic<uint32_t> frs_writes_to_corrupt{0};
+
+    /// @return true if budget was non-zero, it is then one less
+    bool take_one(std::atomic<uint32_t>& budget)
+    {
+        uint32_t left = budget.load();
+        while (left != 0)
+        {
+            if (budget.compare_exchange_weak(left, left - 1))
+                return true;
+        }
+        return false;
+    }
+
+    /// @return true if this set-feature command is one bno08x_sim::reject_commands() asked to fail
+    bool reject_command()
+    {
+        return take_one(commands_to_reject);
+    }
+
+    struct sim_counters_t {
+        std::atomic<uint32_t> set_feature_cmds{0};
+        std::atomic<uint32_t> frs_reads{0};
+        std::atomic<uint32_t> frs_writes{0};
+        std::atomic<uint32_t> cal_config_cmds{0};
+        std::atomic<uint32_t> resets{0};
+        std::atomic<uint64_t> samples_delivered{0};
+        std::atomic<uint64_t> samples_dropped{0};
+        std::atomic<uint64_t> samples_batched{0};
+        std::atomic<uint32_t> host_wakes{0};
+        std::atomic<uint32_t> fifo_flushes{0};
+    } counters;
+
+    /**
+     * Hub batch FIFO shared by every report, sized like the BNO086 batch buffer
+     * (~16 KB of 16 byte records). Samples of reports enabled with a batch
+     * interval wait here until the oldest one's interval expires, the FIFO
+     * fills, a non-batched sample wakes the host anyway, or flush() is called.
+     */
+    constexpr size_t SIM_HUB_FIFO_SAMPLES = 1000;
+
+    struct sim_hub_fifo_t {
+        std::mutex lock;
+        std::vector<bno08x_sim_sample_t> queued;
+        uint32_t deadline_us = 0;
+    } hub_fifo;
+
+    /**
+     * Dynamic calibration. Without a DCD the magnetometer fused outputs start
+     * UNRELIABLE and climb one accuracy level per SIM_CAL_STEP_US of motion; a
+     * DCD that was saved at HIGH accuracy and loaded at reset settles within
+     * SIM_CAL_DCD_SETTLE_US. Record layout: word 0 accuracy at save, then biases.
+     */
+    constexpr uint32_t SIM_CAL_STEP_US = 40000000UL;
+    constexpr uint32_t SIM_CAL_DCD_SETTLE_US = 300000UL;
+    constexpr uint16_t SIM_DCD_WORDS = 10;
+
+    struct sim_cal_t {
+        std::mutex lock;
+        bool dcd_loaded = false;
+        bool started = false;
+        uint32_t origin_us = 0;
+        uint8_t accuracy = 0;
+        uint8_t sensors = static_cast<uint8_t>(BNO08xCalSel::all);   // ME calibration config, volatile
+    } cal;
+
+    bool cal_limited(uint8_t report_ID)
+    {
+        return report_ID == SH2_ROTATION_VECTOR || report_ID == SH2_ARVR_STABILIZED_RV ||
+               report_ID == SH2_GEOMAGNETIC_ROTATION_VECTOR || report_ID == SH2_MAGNETIC_FIELD_CALIBRATED;
+    }
+
+    /// @brief Accuracy the fusion can report for this sample given the calibration state
+    uint8_t cal_accuracy(const bno08x_sim_sample_t& sample)
+    {
+        if (!cal_limited(sample.report_id))
+            return sample.accuracy;
+
+        std::lock_guard<std::mutex> guard(cal.lock);
+        if (!cal.started)
+        {
+            cal.started = true;
+            cal.origin_us = sample.t_us;
+        }
+
+        const uint32_t elapsed_us = sample.t_us - cal.origin_us;
+        const uint8_t high = static_cast<uint8_t>(BNO08xAccuracy::HIGH);
+        if (cal.dcd_loaded)
+            cal.accuracy = (elapsed_us >= SIM_CAL_DCD_SETTLE_US) ? high : static_cast<uint8_t>(BNO08xAccuracy::LOW);
+        else
+            cal.accuracy = static_cast<uint8_t>(std::min<uint32_t>(high, elapsed_us / SIM_CAL_STEP_US));
+
+        return std::min(cal.accuracy, sample.accuracy);
+    }
+
+    /**
+     * Hub clock. Raw reports are stamped with the hub's own microsecond counter,
+     * which runs off its own oscillator: offset from the stream time and off by
+     * a rate error. Both are zero by default (hub time == stream time).
+     */
+    struct sim_hub_clock_t {
+        std::atomic<int32_t> offset_us{0};
+        std::atomic<float> drift_ppm{0.0f};
+    } hub_clock;
+
+    uint32_t hub_time_us(uint32_t t_us)
+    {
+        const double drift = static_cast<double>(t_us) * hub_clock.drift_ppm.load() * 1e-6;
+        return t_us + static_cast<uint32_t>(hub_clock.offset_us.load()) +
+               static_cast<uint32_t>(static_cast<int32_t>(std::lround(drift)));
+    }
+
+    // Q points and rate limits reported in each sensor's FRS meta data record.
+    struct sim_meta_t {
+        uint8_t id;
+        uint16_t q_point_1;
+        uint16_t q_point_2;
+        uint32_t min_period_us;
+        uint32_t fifo_max;
+    };
+
+    constexpr sim_meta_t sim_meta[] = {
+        {SH2_RAW_ACCELEROMETER, 0, 0, 2500, 1000},
+        {SH2_ACCELEROMETER, 8, 0, 2500, 1000},
+        {SH2_LINEAR_ACCELERATION, 8, 0, 2500, 1000},
+        {SH2_GRAVITY, 8, 0, 2500, 1000},
+        {SH2_RAW_GYROSCOPE, 0, 0, 2500, 1000},
+        {SH2_GYROSCOPE_CALIBRATED, 9, 0, 2500, 1000},
+        {SH2_GYROSCOPE_UNCALIBRATED, 9, 9, 2500, 1000},
+        {SH2_RAW_MAGNETOMETER, 0, 0, 10000, 500},
+        {SH2_MAGNETIC_FIELD_CALIBRATED, 4, 0, 10000, 500},
+        {SH2_MAGNETIC_FIELD_UNCALIBRATED, 4, 4, 10000, 500},
+        {SH2_ROTATION_VECTOR, 14, 12, 2500, 600},
+        {SH2_GAME_ROTATION_VECTOR, 14, 0, 2500, 600},
+        {SH2_ARVR_STABILIZED_RV, 14, 12, 2500, 600},
+        {SH2_ARVR_STABILIZED_GRV, 14, 0, 2500, 600},
+        {SH2_GYRO_INTEGRATED_RV, 14, 10, 1000, 0},
+        {SH2_GEOMAGNETIC_ROTATION_VECTOR, 14, 12, 10000, 600},
+        {SH2_PERSONAL_ACTIVITY_CLASSIFIER, 0, 0, 0, 100},
+        {SH2_STABILITY_CLASSIFIER, 0, 0, 0, 100},
+        {SH2_SHAKE_DETECTOR, 0, 0, 0, 100},
+        {SH2_STEP_COUNTER, 0, 0, 0, 100},
+        {SH2_SIGNIFICANT_MOTION, 0, 0, 0, 0},
+    };
+} // namespace
+
+/// @brief Grants the sim control functions access to driver internals.
+struct bno08x_sim_access {
+    static BNO08xRpt* find_report(BNO08x* imu, uint8_t report_ID)
+    {
+        return imu->find_report(report_ID);
+    }
+
+    static void power_cycle(BNO08x* imu, bool keep_flash)
+    {
+        if (!keep_flash)
+            imu->frs_records.clear();
+        imu->reset_reports();
+        imu->notify_reset();
+    }
+
+    /// @return batch interval of an enabled report, 0 if it reports immediately
+    static bool batch_interval(BNO08xRpt* rpt, uint32_t& batch_us)
+    {
+        std::lock_guard<std::mutex> guard(rpt->data_lock);
+        batch_us = rpt->sensor_cfg.batchInterval_us;
+        return rpt->enabled;
+    }
+
+    static bool deliver(BNO08x* imu, BNO08xRpt* rpt, const bno08x_sim_sample_t& sample)
+    {
+        std::function<void(void)> rpt_cb;
+
+        {
+            std::lock_guard<std::mutex> guard(rpt->data_lock);
+            if (!rpt->enabled)
+                return false;
+
+            rpt->update_data(sample);
+            rpt->new_data = true;
+            rpt_cb = rpt->cb;
+        }
+
+        if (rpt_cb)
+            rpt_cb();
+
+        std::lock_guard<std::recursive_mutex> guard(imu->cb_lock);
+        for (size_t i = 0; i < imu->cb_list_void.size(); i++)
+            imu->cb_list_void[i]();
+        for (size_t i = 0; i < imu->cb_list_id.size(); i++)
+            imu->cb_list_id[i](rpt->ID);
+
+        return true;
+    }
+};
+
+/* ============================== BNO08xRpt ============================== */
+
+bool BNO08xRpt::enable(uint32_t time_between_reports, sh2_SensorConfig_t sensor_cfg)
+{
+    counters.set_feature_cmds++;
+    if (reject_command())
+        return false;
+
+    std::lock_guard<std::mutex> guard(data_lock);
+    sensor_cfg.reportInterval_us = time_between_reports;
+    this->sensor_cfg = sensor_cfg;
+    period_us = time_between_reports;
+    enabled = true;
+    return true;
+}
+
+bool BNO08xRpt::disable(sh2_SensorConfig_t sensor_cfg)
+{
+    counters.set_feature_cmds++;
+    if (reject_command())
+        return false;
+
+    std::lock_guard<std::mutex> guard(data_lock);
+    this->sensor_cfg = sensor_cfg;
+    period_us = 0;
+    enabled = false;
+    new_data = false;
+    // mirrors lib/sig-motion-ext: disabling a report drops its callback
+    cb = nullptr;
+    return true;
+}
+
+bool BNO08xRpt::has_new_data()
+{
+    std::lock_guard<std::mutex> guard(data_lock);
+    bool ret = new_data;
+    new_data = false;
+    return ret;
+}
+
+void BNO08xRpt::register_cb(std::function<void(void)> cb_fxn)
+{
+    std::lock_guard<std::mutex> guard(data_lock);
+    cb = std::move(cb_fxn);
+}
+
+bool BNO08xRpt::get_meta_data(bno08x_meta_data_t& meta_data)
+{
+    for (const sim_meta_t& meta : sim_meta)
+    {
+        if (meta.id != ID)
+            continue;
+
+        meta_data = bno08x_meta_data_t();
+        meta_data.q_point_1 = meta.q_point_1;
+        meta_data.q_point_2 = meta.q_point_2;
+        meta_data.min_period_uS = meta.min_period_us;
+        meta_data.max_period_uS = 1000000UL;
+        meta_data.fifo_max = meta.fifo_max;
+        meta_data.batch_buffer_bytes = meta.fifo_max * 16UL;
+        std::snprintf(meta_data.vendor_id, sizeof(meta_data.vendor_id), "PetPulse host sim");
+        meta_data.vendor_id_len = std::strlen(meta_data.vendor_id);
+        return true;
+    }
+
+    return false;
+}
+
+bool BNO08xRpt::flush()
+{
+    bno08x_sim::flush();
+    return true;
+}
+
+void BNO08xRptAcceleration::update_data(const bno08x_sim_sample_t& sample)
+{
+    data.x = sample.v[0];
+    data.y = sample.v[1];
+    data.z = sample.v[2];
+    data.accuracy = static_cast<BNO08xAccuracy>(sample.accuracy);
+}
+
+void BNO08xRptRawAccelerometer::update_data(const bno08x_sim_sample_t& sample)
+{
+    data.x = static_cast<int16_t>(sample.v[0]);
+    data.y = static_cast<int16_t>(sample.v[1]);
+    data.z = static_cast<int16_t>(sample.v[2]);
+    data.timestamp_us = hub_time_us(sample.t_us);
+}
+
+void BNO08xRptRawGyro::update_data(const bno08x_sim_sample_t& sample)
+{
+    data.x = static_cast<int16_t>(sample.v[0]);
+    data.y = static_cast<int16_t>(sample.v[1]);
+    data.z = static_cast<int16_t>(sample.v[2]);
+    data.temperature = static_cast<int16_t>(sample.v[3]);
+    data.timestamp_us = hub_time_us(sample.t_us);
+}
+
+void BNO08xRptCalGyro::update_data(const bno08x_sim_sample_t& sample)
+{
+    data.x = sample.v[0];
+    data.y = sample.v[1];
+    data.z = sample.v[2];
+}
+
+void BNO08xRptUncalGyro::update_data(const bno08x_sim_sample_t& sample)
+{
+    data.x = sample.v[0];
+    data.y = sample.v[1];
+    data.z = sample.v[2];
+    bias_data.x = sample.v[3];
+    bias_data.y = sample.v[4];
+    bias_data.z = sample.v[5];
+}
+
+void BNO08xRptUncalGyro::get(bno08x_gyro_t& vel, bno08x_gyro_bias_t& bias)
+{
+    std::lock_guard<std::mutex> guard(data_lock);
+    vel = data;
+    bias = bias_data;
+}
+
+bno08x_gyro_t BNO08xRptUncalGyro::get_vel()
+{
+    std::lock_guard<std::mutex> guard(data_lock);
+    return data;
+}
+
+bno08x_gyro_bias_t BNO08xRptUncalGyro::get_bias()
+{
+    std::lock_guard<std::mutex> guard(data_lock);
+    return bias_data;
+}
+
+void BNO08xRptRawMagnetometer::update_data(const bno08x_sim_sample_t& sample)
+{
+    data.x = static_cast<int16_t>(sample.v[0]);
+    data.y = static_cast<int16_t>(sample.v[1]);
+    data.z = static_cast<int16_t>(sample.v[2]);
+    data.timestamp_us = hub_time_us(sample.t_us);
+}
+
+void BNO08xRptCalMagnetometer::update_data(const bno08x_sim_sample_t& sample)
+{
+    data.x = sample.v[0];
+    data.y = sample.v[1];
+    data.z = sample.v[2];
+    data.accuracy = static_cast<BNO08xAccuracy>(sample.accuracy);
+}
+
+void BNO08xRptUncalMagnetometer::update_data(const bno08x_sim_sample_t& sample)
+{
+    data.x = sample.v[0];
+    data.y = sample.v[1];
+    data.z = sample.v[2];
+    data.accuracy = static_cast<BNO08xAccuracy>(sample.accuracy);
+    bias_data.x = sample.v[3];
+    bias_data.y = sample.v[4];
+    bias_data.z = sample.v[5];
+}
+
+void BNO08xRptUncalMagnetometer::get(bno08x_magf_t& magf, bno08x_magf_bias_t& bias)
+{
+    std::lock_guard<std::mutex> guard(data_lock);
+    magf = data;
+    bias = bias_data;
+}
+
+bno08x_magf_t BNO08xRptUncalMagnetometer::get_magf()
+{
+    std::lock_guard<std::mutex> guard(data_lock);
+    return data;
+}
+
+bno08x_magf_bias_t BNO08xRptUncalMagnetometer::get_bias()
+{
+    std::lock_guard<std::mutex> guard(data_lock);
+    return bias_data;
+}
+
+void BNO08xRptRVGeneric::update_data(const bno08x_sim_sample_t& sample)
+{
+    data.real = sample.v[0];
+    data.i = sample.v[1];
+    data.j = sample.v[2];
+    data.k = sample.v[3];
+    data.rad_accuracy = sample.v[4];
+    data.accuracy = static_cast<BNO08xAccuracy>(sample.accuracy);
+}
+
+bno08x_quat_t BNO08xRptRVGeneric::get_quat()
+{
+    std::lock_guard<std::mutex> guard(data_lock);
+    return data;
+}
+
+bno08x_euler_angle_t BNO08xRptRVGeneric::get_euler(bool in_degrees)
+{
+    bno08x_quat_t quat = get_quat();
+    bno08x_euler_angle_t euler;
+
+    float sinr_cosp = 2.0f * (quat.real * quat.i + quat.j * quat.k);
+    float cosr_cosp = 1.0f - 2.0f * (quat.i * quat.i + quat.j * quat.j);
+    float sinp = 2.0f * (quat.real * quat.j - quat.k * quat.i);
+    float siny_cosp = 2.0f * (quat.real * quat.k + quat.i * quat.j);
+    float cosy_cosp = 1.0f - 2.0f * (quat.j * quat.j + quat.k * quat.k);
+
+    euler.x = std::atan2(sinr_cosp, cosr_cosp);
+    euler.y = (std::fabs(sinp) >= 1.0f) ? std::copysign(1.5707963f, sinp) : std::asin(sinp);
+    euler.z = std::atan2(siny_cosp, cosy_cosp);
+    euler.accuracy = quat.accuracy;
+    euler.rad_accuracy = quat.rad_accuracy;
+
+    if (in_degrees)
+    {
+        euler.x *= RAD_2_DEG;
+        euler.y *= RAD_2_DEG;
+        euler.z *= RAD_2_DEG;
+        euler.rad_accuracy *= RAD_2_DEG;
+    }
+
+    return euler;
+}
+
+void BNO08xRptActivityClassifier::update_data(const bno08x_sim_sample_t& sample)
+{
+    data.page = 0;
+    data.lastPage = true;
+    data.mostLikelyState = static_cast<BNO08xActivity>(sample.v[0]);
+    data.confidence = static_cast<uint8_t>(sample.v[1]);
+}
+
+void BNO08xRptStabilityClassifier::update_data(const bno08x_sim_sample_t& sample)
+{
+    data.stability = static_cast<BNO08xStability>(sample.v[0]);
+}
+
+void BNO08xRptShakeDetector::update_data(const bno08x_sim_sample_t& sample)
+{
+    data.shake = static_cast<uint16_t>(sample.v[0]);
+}
+
+void BNO08xRptStepCounter::update_data(const bno08x_sim_sample_t& sample)
+{
+    data.steps = static_cast<uint16_t>(sample.v[0]);
+    data.latency = static_cast<uint32_t>(sample.v[1]);
+}
+
+void BNO08xRptSignificantMotion::update_data(const bno08x_sim_sample_t& sample)
+{
+    data.motion = static_cast<uint16_t>(sample.v[0]);
+}
+
+/* ================================ BNO08x ================================ */
+
+BNO08x::BNO08x(bno08x_config_t imu_config)
+    : rpt(this)
+    , imu_config(imu_config)
+{
+    // Q24 10.0 m/s^2, 5 steps: factory default of the sig motion detector record
+    frs_records[static_cast<uint16_t>(BNO08xFrsID::SIG_MOTION_DETECT_CONFIG)] = {167772160UL, 5UL};
+    active_imu = this;
+}
+
+BNO08x::~BNO08x()
+{
+    BNO08x* self = this;
+    active_imu.compare_exchange_strong(self, nullptr);
+}
+
+bool BNO08x::initialize()
+{
+    reset_reports();
+    return true;
+}
+
+bool BNO08x::hard_reset()
+{
+    counters.resets++;
+    reset_reports();
+    notify_reset();
+    return true;
+}
+
+bool BNO08x::soft_reset()
+{
+    counters.resets++;
+    reset_reports();
+    notify_reset();
+    return true;
+}
+
+bool BNO08x::disable_all_reports()
+{
+    for (uint8_t id = 0; id <= SH2_MAX_SENSOR_ID; id++)
+    {
+        BNO08xRpt* report = find_report(id);
+        if (report == nullptr)
+            continue;
+
+        bool enabled = false;
+        {
+            std::lock_guard<std::mutex> guard(report->data_lock);
+            enabled = report->enabled;
+        }
+
+        if (enabled && !report->disable())
+            return false;
+    }
+
+    return true;
+}
+
+bool BNO08x::data_available()
+{
+    for (uint8_t id = 0; id <= SH2_MAX_SENSOR_ID; id++)
+    {
+        BNO08xRpt* report = find_report(id);
+        if (report == nullptr)
+            continue;
+
+        std::lock_guard<std::mutex> guard(report->data_lock);
+        if (report->new_data)
+            return true;
+    }
+
+    return false;
+}
+
+void BNO08x::register_cb(std::function<void(void)> cb_fxn)
+{
+    std::lock_guard<std::recursive_mutex> guard(cb_lock);
+    cb_list_void.push_back(std::move(cb_fxn));
+}
+
+void BNO08x::register_cb(std::function<void(uint8_t report_ID)> cb_fxn)
+{
+    std::lock_guard<std::recursive_mutex> guard(cb_lock);
+    cb_list_id.push_back(std::move(cb_fxn));
+}
+
+void BNO08x::register_reset_cb(std::function<void(void)> cb_fxn)
+{
+    std::lock_guard<std::recursive_mutex> guard(cb_lock);
+    cb_list_reset.push_back(std::move(cb_fxn));
+}
+
+void BNO08x::notify_reset()
+{
+    // the SHTP reset message arrives once the hub is back up, with every report already off
+    auto deliver = [this]() {
+        std::lock_guard<std::recursive_mutex> guard(cb_lock);
+        for (size_t i = 0; i < cb_list_reset.size(); i++)
+            cb_list_reset[i]();
+    };
+
+    const uint32_t delay_us = reset_msg_delay_us.load();
+    if (delay_us == BNO08X_SIM_RESET_MSG_LOST)
+        return;
+    if (delay_us == 0)
+    {
+        deliver();
+        return;
+    }
+    std::thread([deliver, delay_us]() {
+        std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
+        deliver();
+    }).detach();
+}
+
+bool BNO08x::get_frs(BNO08xFrsID frs_ID, uint32_t (&data)[16], uint16_t& rx_data_sz)
+{
+    counters.frs_reads++;
+
+    rx_data_sz = 0;
+    auto record = frs_records.find(static_cast<uint16_t>(frs_ID));
+    if (record == frs_records.end())
+        return true; // empty record, valid on SH-2
+
+    for (uint32_t word : record->second)
+    {
+        if (rx_data_sz >= 16)
+            break;
+        data[rx_data_sz++] = word;
+    }
+
+    return true;
+}
+
+bool BNO08x::write_frs(BNO08xFrsID frs_ID, uint32_t* data, uint16_t tx_data_sz)
+{
+    counters.frs_writes++;
+
+    if (data == nullptr || tx_data_sz > 16)
+        return false;
+
+    std::vector<uint32_t>& record = frs_records[static_cast<uint16_t>(frs_ID)];
+    record.assign(data, data + tx_data_sz);
+    // the handshake completes, the flash holds something else
+    if (tx_data_sz != 0 && take_one(frs_writes_to_corrupt))
+        record.back() ^= 0x1U;
+    return true;
+}
+
+bool BNO08x::dynamic_calibration_enable(BNO08xCalSel sensor)
+{
+    counters.cal_config_cmds++;
+
+    std::lock_guard<std::mutex> guard(cal.lock);
+    cal.sensors |= static_cast<uint8_t>(sensor);
+    return true;
+}
+
+bool BNO08x::dynamic_calibration_disable(BNO08xCalSel sensor)
+{
+    counters.cal_config_cmds++;
+
+    std::lock_guard<std::mutex> guard(cal.lock);
+    cal.sensors &= static_cast<uint8_t>(~static_cast<uint8_t>(sensor));
+    return true;
+}
+
+bool BNO08x::dynamic_calibration_run_routine()
+{
+    return true;
+}
+
+bool BNO08x::dynamic_calibration_save()
+{
+    // hub internal save of the live DCD, no FRS handshake on the bus
+    std::vector<uint32_t> dcd(SIM_DCD_WORDS);
+    {
+        std::lock_guard<std::mutex> guard(cal.lock);
+        dcd[0] = cal.accuracy;
+    }
+    for (uint16_t i = 1; i < SIM_DCD_WORDS; i++)
+        dcd[i] = 0x3C000000UL + i * 0x00011111UL;
+
+    frs_records[static_cast<uint16_t>(BNO08xFrsID::DYNAMIC_CALIBRATION)] = dcd;
+    return true;
+}
+
+BNO08xRpt* BNO08x::find_report(uint8_t report_ID)
+{
+    switch (report_ID)
+    {
+        case SH2_RAW_ACCELEROMETER:
+            return &rpt.raw_accelerometer;
+        case SH2_ACCELEROMETER:
+            return &rpt.accelerometer;
+        case SH2_LINEAR_ACCELERATION:
+            return &rpt.linear_accelerometer;
+        case SH2_GRAVITY:
+            return &rpt.gravity;
+        case SH2_RAW_GYROSCOPE:
+            return &rpt.raw_gyro;
+        case SH2_GYROSCOPE_CALIBRATED:
+            return &rpt.cal_gyro;
+        case SH2_GYROSCOPE_UNCALIBRATED:
+            return &rpt.uncal_gyro;
+        case SH2_RAW_MAGNETOMETER:
+            return &rpt.raw_magnetometer;
+        case SH2_MAGNETIC_FIELD_CALIBRATED:
+            return &rpt.cal_magnetometer;
+        case SH2_MAGNETIC_FIELD_UNCALIBRATED:
+            return &rpt.uncal_magnetometer;
+        case SH2_ROTATION_VECTOR:
+            return &rpt.rv;
+        case SH2_GAME_ROTATION_VECTOR:
+            return &rpt.rv_game;
+        case SH2_ARVR_STABILIZED_RV:
+            return &rpt.rv_ARVR_stabilized;
+        case SH2_ARVR_STABILIZED_GRV:
+            return &rpt.rv_ARVR_stabilized_game;
+        case SH2_GYRO_INTEGRATED_RV:
+            return &rpt.rv_gyro_integrated;
+        case SH2_GEOMAGNETIC_ROTATION_VECTOR:
+            return &rpt.rv_geomagnetic;
+        case SH2_PERSONAL_ACTIVITY_CLASSIFIER:
+            return &rpt.activity_classifier;
+        case SH2_STABILITY_CLASSIFIER:
+            return &rpt.stability_classifier;
+        case SH2_SHAKE_DETECTOR:
+            return &rpt.shake_detector;
+        case SH2_STEP_COUNTER:
+            return &rpt.step_counter;
+        case SH2_SIGNIFICANT_MOTION:
+            return &rpt.significant_motion;
+        default:
+            return nullptr;
+    }
+}
+
+void BNO08x::reset_reports()
+{
+    // the hub forgets every set-feature on reset, callbacks stay registered host side
+    for (uint8_t id = 0; id <= SH2_MAX_SENSOR_ID; id++)
+    {
+        BNO08xRpt* report = find_report(id);
+        if (report == nullptr)
+            continue;
+
+        std::lock_guard<std::mutex> guard(report->data_lock);
+        report->enabled = false;
+        report->new_data = false;
+        report->period_us = 0;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(hub_fifo.lock);
+        counters.samples_dropped += hub_fifo.queued.size();
+        hub_fifo.queued.clear();
+    }
+
+    // the hub loads its DCD from flash at startup and recalibrates from there
+    auto dcd = frs_records.find(static_cast<uint16_t>(BNO08xFrsID::DYNAMIC_CALIBRATION));
+    std::lock_guard<std::mutex> guard(cal.lock);
+    cal.dcd_loaded = dcd != frs_records.end() && dcd->second.size() == SIM_DCD_WORDS &&
+                     dcd->second[0] == static_cast<uint32_t>(BNO08xAccuracy::HIGH);
+    cal.started = false;
+    cal.accuracy = 0;
+    cal.sensors = static_cast<uint8_t>(BNO08xCalSel::all);
+}
+
+/* ============================== bno08x_sim ============================== */
+
+namespace bno08x_sim
+{
+    BNO08x* active()
+    {
+        return active_imu.load();
+    }
+
+    namespace
+    {
+        bool deliver_now(BNO08x* imu, const bno08x_sim_sample_t& sample)
+        {
+            BNO08xRpt* report = bno08x_sim_access::find_report(imu, sample.report_id);
+            bno08x_sim_sample_t fused = sample;
+            fused.accuracy = cal_accuracy(sample);
+            if (report == nullptr || !bno08x_sim_access::deliver(imu, report, fused))
+            {
+                counters.samples_dropped++;
+                return false;
+            }
+
+            counters.samples_delivered++;
+            return true;
+        }
+
+        /// @brief Send the whole hub FIFO to the host as one burst, callbacks run outside the FIFO lock.
+        size_t flush_fifo(BNO08x* imu)
+        {
+            std::vector<bno08x_sim_sample_t> burst;
+            {
+                std::lock_guard<std::mutex> guard(hub_fifo.lock);
+                burst.swap(hub_fifo.queued);
+            }
+
+            if (burst.empty())
+                return 0;
+
+            counters.fifo_flushes++;
+            for (const bno08x_sim_sample_t& queued : burst)
+                deliver_now(imu, queued);
+            return burst.size();
+        }
+    } // namespace
+
+    bool inject(const bno08x_sim_sample_t& sample)
+    {
+        BNO08x* imu = active_imu.load();
+        if (imu == nullptr)
+            return false;
+
+        BNO08xRpt* report = bno08x_sim_access::find_report(imu, sample.report_id);
+        uint32_t batch_us = 0;
+        if (report == nullptr || !bno08x_sim_access::batch_interval(report, batch_us))
+        {
+            counters.samples_dropped++;
+            return false;
+        }
+
+        if (batch_us == 0)
+        {
+            // the host is woken for this sample, the hub sends whatever it was holding first
+            counters.host_wakes++;
+            flush_fifo(imu);
+            return deliver_now(imu, sample);
+        }
+
+        bool expired = false;
+        {
+            std::lock_guard<std::mutex> guard(hub_fifo.lock);
+            const uint32_t deadline_us = sample.t_us + batch_us;
+            if (hub_fifo.queued.empty() || static_cast<int32_t>(deadline_us - hub_fifo.deadline_us) < 0)
+                hub_fifo.deadline_us = deadline_us;
+
+            hub_fifo.queued.push_back(sample);
+            counters.samples_batched++;
+            expired = hub_fifo.queued.size() >= SIM_HUB_FIFO_SAMPLES ||
+                      static_cast<int32_t>(sample.t_us - hub_fifo.deadline_us) >= 0;
+        }
+
+        if (expired)
+        {
+            counters.host_wakes++;
+            flush_fifo(imu);
+        }
+        return true;
+    }
+
+    size_t flush()
+    {
+        BNO08x* imu = active_imu.load();
+        if (imu == nullptr)
+            return 0;
+
+        size_t flushed = flush_fifo(imu);
+        if (flushed != 0)
+            counters.host_wakes++;
+        return flushed;
+    }
+
+    bool power_cycle(bool keep_flash)
+    {
+        BNO08x* imu = active_imu.load();
+        if (imu == nullptr)
+            return false;
+
+        counters.resets++;
+        bno08x_sim_access::power_cycle(imu, keep_flash);
+        return true;
+    }
+
+    void set_reset_message_delay(uint32_t delay_us)
+    {
+        reset_msg_delay_us.store(delay_us);
+    }
+
+    void reject_commands(uint32_t count)
+    {
+        commands_to_reject.store(count);
+    }
+
+    void corrupt_frs_writes(uint32_t count)
+    {
+        frs_writes_to_corrupt.store(count);
+    }
+
+    uint8_t cal_config()
+    {
+        std::lock_guard<std::mutex> guard(cal.lock);
+        return cal.sensors;
+    }
+
+    void set_hub_clock(int32_t offset_us, float drift_ppm)
+    {
+        hub_clock.offset_us.store(offset_us);
+        hub_clock.drift_ppm.store(drift_ppm);
+    }
+
+    size_t replay(const bno08x_sim_sample_t* samples, size_t count)
+    {
+        size_t accepted = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (inject(samples[i]))
+                accepted++;
+        }
+        return accepted;
+    }
+
+    bno08x_sim_stats_t stats()
+    {
+        bno08x_sim_stats_t snapshot;
+        snapshot.set_feature_cmds = counters.set_feature_cmds.load();
+        snapshot.frs_reads = counters.frs_reads.load();
+        snapshot.frs_writes = counters.frs_writes.load();
+        snapshot.cal_config_cmds = counters.cal_config_cmds.load();
+        snapshot.resets = counters.resets.load();
+        snapshot.samples_delivered = counters.samples_delivered.load();
+        snapshot.samples_dropped = counters.samples_dropped.load();
+        snapshot.samples_batched = counters.samples_batched.load();
+        snapshot.host_wakes = counters.host_wakes.load();
+        snapshot.fifo_flushes = counters.fifo_flushes.load();
+        return snapshot;
+    }
+
+    void reset_stats()
+    {
+        counters.set_feature_cmds = 0;
+        counters.frs_reads = 0;
+        counters.frs_writes = 0;
+        counters.cal_config_cmds = 0;
+        counters.resets = 0;
+        counters.samples_delivered = 0;
+        counters.samples_dropped = 0;
+        counters.samples_batched = 0;
+        counters.host_wakes = 0;
+        counters.fifo_flushes = 0;
+    }
+} // namespace bno08x_sim
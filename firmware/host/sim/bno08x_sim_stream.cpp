@@ -0,0 +1,266 @@
+#include "bno08x_sim.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    constexpr float TWO_PI = 6.28318530718f;
+    constexpr float GRAVITY_MS2 = 9.80665f;
+
+    /// @brief Per-profile motion parameters of the synthetic pet.
+    struct profile_params_t {
+        float step_hz;        ///< gait / breathing fundamental
+        float accel_amp_ms2;  ///< dynamic acceleration amplitude
+        float gyro_amp_rads;  ///< angular rate amplitude
+        float tilt_amp_rad;   ///< body pitch / roll swing
+        float noise_ms2;      ///< accelerometer noise floor
+        float pitch_rad;      ///< posture, head down is negative
+        BNO08xActivity activity;
+        BNO08xStability stability;
+    };
+
+    profile_params_t params_for(bno08x_sim_profile_t profile)
+    {
+        switch (profile)
+        {
+            case bno08x_sim_profile_t::SLEEP:
+                return {0.25f, 0.05f, 0.01f, 0.01f, 0.01f, 0.0f, BNO08xActivity::STILL, BNO08xStability::STATIONARY};
+            case bno08x_sim_profile_t::WALK:
+                return {2.0f, 2.5f, 0.8f, 0.08f, 0.05f, 0.0f, BNO08xActivity::WALKING, BNO08xStability::MOTION};
+            case bno08x_sim_profile_t::SCRATCH:
+                return {6.0f, 3.0f, 1.2f, 0.05f, 0.1f, 0.5f, BNO08xActivity::STILL, BNO08xStability::MOTION};
+            case bno08x_sim_profile_t::EAT:
+                return {1.2f, 0.4f, 0.15f, 0.03f, 0.03f, -0.7f, BNO08xActivity::STILL, BNO08xStability::STABLE};
+            case bno08x_sim_profile_t::SHAKE:
+                return {4.5f, 12.0f, 9.0f, 0.6f, 0.2f, 0.0f, BNO08xActivity::TILTING, BNO08xStability::MOTION};
+            case bno08x_sim_profile_t::RUN:
+            default:
+                return {3.5f, 8.0f, 2.5f, 0.2f, 0.15f, 0.0f, BNO08xActivity::RUNNING, BNO08xStability::MOTION};
+        }
+    }
+
+    /// @brief xorshift32 noise source so identical seeds give identical streams.
+    struct noise_t {
+        uint32_t state;
+
+        float next()
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return (static_cast<float>(state & 0xFFFFFFU) / 8388608.0f) - 1.0f;
+        }
+    };
+
+    void fill_sample(bno08x_sim_sample_t& sample, const profile_params_t& p, float t, uint32_t period_us,
+            noise_t& noise, uint32_t& steps)
+    {
+        const float phase = TWO_PI * p.step_hz * t;
+        const float roll = p.tilt_amp_rad * std::sin(phase);
+        const float pitch = p.pitch_rad + p.tilt_amp_rad * std::cos(0.5f * phase);
+        const float yaw = 0.3f * std::sin(0.05f * TWO_PI * t);
+
+        const float grav_x = -GRAVITY_MS2 * std::sin(pitch);
+        const float grav_y = GRAVITY_MS2 * std::sin(roll) * std::cos(pitch);
+        const float grav_z = GRAVITY_MS2 * std::cos(roll) * std::cos(pitch);
+
+        const float lin_x = 0.4f * p.accel_amp_ms2 * std::sin(phase + 0.7f) + p.noise_ms2 * noise.next();
+        const float lin_y = 0.3f * p.accel_amp_ms2 * std::sin(0.5f * phase) + p.noise_ms2 * noise.next();
+        const float lin_z = p.accel_amp_ms2 * std::sin(2.0f * phase) + p.noise_ms2 * noise.next();
+
+        switch (sample.report_id)
+        {
+            case SH2_ACCELEROMETER:
+                sample.v[0] = grav_x + lin_x;
+                sample.v[1] = grav_y + lin_y;
+                sample.v[2] = grav_z + lin_z;
+                break;
+
+            case SH2_LINEAR_ACCELERATION:
+                sample.v[0] = lin_x;
+                sample.v[1] = lin_y;
+                sample.v[2] = lin_z;
+                break;
+
+            case SH2_GRAVITY:
+                sample.v[0] = grav_x;
+                sample.v[1] = grav_y;
+                sample.v[2] = grav_z;
+                break;
+
+            case SH2_RAW_ACCELEROMETER:
+                // raw ADC counts, ~1 mg/LSB
+                sample.v[0] = (grav_x + lin_x) * 102.0f;
+                sample.v[1] = (grav_y + lin_y) * 102.0f;
+                sample.v[2] = (grav_z + lin_z) * 102.0f;
+                break;
+
+            case SH2_GYROSCOPE_CALIBRATED:
+            case SH2_GYROSCOPE_UNCALIBRATED:
+            case SH2_RAW_GYROSCOPE:
+            {
+                float scale = (sample.report_id == SH2_RAW_GYROSCOPE) ? 900.0f : 1.0f;
+                sample.v[0] = scale * (p.gyro_amp_rads * std::cos(phase) + 0.01f * noise.next());
+                sample.v[1] = scale * (0.5f * p.gyro_amp_rads * std::sin(0.5f * phase) + 0.01f * noise.next());
+                sample.v[2] = scale * (0.2f * p.gyro_amp_rads * std::cos(0.25f * phase) + 0.01f * noise.next());
+                if (sample.report_id == SH2_GYROSCOPE_UNCALIBRATED)
+                {
+                    sample.v[3] = 0.002f;
+                    sample.v[4] = -0.001f;
+                    sample.v[5] = 0.0005f;
+                }
+                else if (sample.report_id == SH2_RAW_GYROSCOPE)
+                {
+                    sample.v[3] = 2500.0f; // temperature counts
+                }
+                break;
+            }
+
+            case SH2_MAGNETIC_FIELD_CALIBRATED:
+            case SH2_MAGNETIC_FIELD_UNCALIBRATED:
+            case SH2_RAW_MAGNETOMETER:
+            {
+                float scale = (sample.report_id == SH2_RAW_MAGNETOMETER) ? 16.0f : 1.0f;
+                sample.v[0] = scale * (22.0f * std::cos(yaw) + 0.3f * noise.next());
+                sample.v[1] = scale * (-22.0f * std::sin(yaw) + 0.3f * noise.next());
+                sample.v[2] = scale * (-41.0f + 0.3f * noise.next());
+                if (sample.report_id == SH2_MAGNETIC_FIELD_UNCALIBRATED)
+                {
+                    sample.v[3] = 1.5f;
+                    sample.v[4] = -0.5f;
+                    sample.v[5] = 2.0f;
+                }
+                break;
+            }
+
+            case SH2_ROTATION_VECTOR:
+            case SH2_GAME_ROTATION_VECTOR:
+            case SH2_GEOMAGNETIC_ROTATION_VECTOR:
+            case SH2_ARVR_STABILIZED_RV:
+            case SH2_ARVR_STABILIZED_GRV:
+            case SH2_GYRO_INTEGRATED_RV:
+            {
+                const float cr = std::cos(0.5f * roll), sr = std::sin(0.5f * roll);
+                const float cp = std::cos(0.5f * pitch), sp = std::sin(0.5f * pitch);
+                const float cy = std::cos(0.5f * yaw), sy = std::sin(0.5f * yaw);
+                sample.v[0] = cr * cp * cy + sr * sp * sy;
+                sample.v[1] = sr * cp * cy - cr * sp * sy;
+                sample.v[2] = cr * sp * cy + sr * cp * sy;
+                sample.v[3] = cr * cp * sy - sr * sp * cy;
+                sample.v[4] = 0.05f;
+                break;
+            }
+
+            case SH2_PERSONAL_ACTIVITY_CLASSIFIER:
+                sample.v[0] = static_cast<float>(p.activity);
+                sample.v[1] = 90.0f;
+                break;
+
+            case SH2_STABILITY_CLASSIFIER:
+                sample.v[0] = static_cast<float>(p.stability);
+                break;
+
+            case SH2_STEP_COUNTER:
+                if (p.activity == BNO08xActivity::WALKING || p.activity == BNO08xActivity::RUNNING)
+                    steps = static_cast<uint32_t>(2.0f * p.step_hz * t);
+                sample.v[0] = static_cast<float>(steps & 0xFFFFU);
+                sample.v[1] = static_cast<float>(period_us);
+                break;
+
+            case SH2_SHAKE_DETECTOR:
+                sample.v[0] = 0x4; // Z axis shake
+                break;
+
+            case SH2_SIGNIFICANT_MOTION:
+                sample.v[0] = 1.0f;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    /// @brief Event style reports only fire on a change, not every period.
+    bool emits_at(uint8_t report_id, bno08x_sim_profile_t profile, uint32_t t_us, uint32_t period_us)
+    {
+        switch (report_id)
+        {
+            case SH2_SIGNIFICANT_MOTION:
+                return profile != bno08x_sim_profile_t::SLEEP && t_us == period_us;
+            case SH2_SHAKE_DETECTOR:
+                if (profile == bno08x_sim_profile_t::SHAKE)
+                    return (t_us % 500000UL) < period_us;
+                return profile == bno08x_sim_profile_t::RUN && (t_us % 2000000UL) < period_us;
+            default:
+                return true;
+        }
+    }
+} // namespace
+
+namespace bno08x_sim
+{
+    void generate(bno08x_sim_profile_t profile, const uint8_t* report_ids, size_t count, uint32_t period_us,
+            uint32_t duration_us, std::vector<bno08x_sim_sample_t>& out, uint32_t seed)
+    {
+        if (report_ids == nullptr || count == 0 || period_us == 0)
+            return;
+
+        const profile_params_t p = params_for(profile);
+        noise_t noise = {seed != 0 ? seed : 1U};
+        uint32_t steps = 0;
+
+        out.reserve(out.size() + count * (duration_us / period_us + 1));
+        for (uint32_t t_us = period_us; t_us <= duration_us; t_us += period_us)
+        {
+            const float t = static_cast<float>(t_us) * 1e-6f;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (!emits_at(report_ids[i], profile, t_us, period_us))
+                    continue;
+
+                bno08x_sim_sample_t sample;
+                sample.t_us = t_us;
+                sample.report_id = report_ids[i];
+                sample.accuracy = static_cast<uint8_t>(BNO08xAccuracy::HIGH);
+                fill_sample(sample, p, t, period_us, noise, steps);
+                out.push_back(sample);
+            }
+        }
+    }
+
+    bool load_csv(const char* path, std::vector<bno08x_sim_sample_t>& out)
+    {
+        FILE* file = std::fopen(path, "r");
+        if (file == nullptr)
+            return false;
+
+        char line[256];
+        bool ok = true;
+        while (std::fgets(line, sizeof(line), file) != nullptr)
+        {
+            if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+                continue;
+
+            unsigned long t_us = 0;
+            unsigned int report_id = 0, accuracy = 0;
+            bno08x_sim_sample_t sample;
+            int fields = std::sscanf(line, "%lu,%u,%u,%f,%f,%f,%f,%f,%f", &t_us, &report_id, &accuracy, &sample.v[0],
+                    &sample.v[1], &sample.v[2], &sample.v[3], &sample.v[4], &sample.v[5]);
+            if (fields < 3)
+            {
+                ok = false;
+                break;
+            }
+
+            sample.t_us = static_cast<uint32_t>(t_us);
+            sample.report_id = static_cast<uint8_t>(report_id);
+            sample.accuracy = static_cast<uint8_t>(accuracy);
+            out.push_back(sample);
+        }
+
+        std::fclose(file);
+        return ok;
+    }
+} // namespace bno08x_sim
@@ -0,0 +1,198 @@
+#include "driver/gpio.h"
+#include "esp_cpu.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_rom_sys.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace
+{
+    const std::chrono::steady_clock::time_point boot_time = std::chrono::steady_clock::now();
+
+    std::mutex log_lock;
+    esp_log_level_t default_level = ESP_LOG_INFO;
+    std::map<std::string, esp_log_level_t> tag_levels;
+
+    constexpr char level_letter[] = {'N', 'E', 'W', 'I', 'D', 'V'};
+    constexpr uint32_t SIM_CPU_MHZ = 240;
+
+    esp_sleep_wakeup_cause_t wakeup_cause = ESP_SLEEP_WAKEUP_UNDEFINED;
+    bool gpio_wakeup_armed = false;
+    bool timer_wakeup_armed = false;
+
+    esp_log_level_t level_for(const char* tag)
+    {
+        auto it = tag_levels.find(tag);
+        return (it != tag_levels.end()) ? it->second : default_level;
+    }
+} // namespace
+
+extern "C" int64_t esp_timer_get_time(void)
+{
+    auto elapsed = std::chrono::steady_clock::now() - boot_time;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+extern "C" esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void)
+{
+    auto elapsed = std::chrono::steady_clock::now() - boot_time;
+    const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    return static_cast<esp_cpu_cycle_count_t>(ns * SIM_CPU_MHZ / 1000);
+}
+
+extern "C" uint32_t esp_log_timestamp(void)
+{
+    return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+}
+
+extern "C" void esp_log_level_set(const char* tag, esp_log_level_t level)
+{
+    std::lock_guard<std::mutex> guard(log_lock);
+    if (tag == nullptr || std::string(tag) == "*")
+    {
+        default_level = level;
+        return;
+    }
+    tag_levels[tag] = level;
+}
+
+extern "C" void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+{
+    std::lock_guard<std::mutex> guard(log_lock);
+    if (level == ESP_LOG_NONE || level > level_for(tag))
+        return;
+
+    std::printf("%c (%lu) %s: ", level_letter[level], static_cast<unsigned long>(esp_log_timestamp()), tag);
+    va_list args;
+    va_start(args, format);
+    std::vprintf(format, args);
+    va_end(args);
+    std::printf("\n");
+}
+
+extern "C" int esp_rom_printf(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int ret = std::vprintf(fmt, args);
+    va_end(args);
+    return ret;
+}
+
+extern "C" uint32_t esp_rom_get_cpu_ticks_per_us(void)
+{
+    return SIM_CPU_MHZ;
+}
+
+extern "C" uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len)
+{
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0U - (crc & 1U)));
+    }
+    return ~crc;
+}
+
+extern "C" const char* esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+        case ESP_OK:
+            return "ESP_OK";
+        case ESP_FAIL:
+            return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:
+            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:
+            return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:
+            return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:
+            return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:
+            return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:
+            return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:
+            return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_CRC:
+            return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_NVS_NOT_INITIALIZED:
+            return "ESP_ERR_NVS_NOT_INITIALIZED";
+        case ESP_ERR_NVS_NOT_FOUND:
+            return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_READ_ONLY:
+            return "ESP_ERR_NVS_READ_ONLY";
+        case ESP_ERR_NVS_INVALID_HANDLE:
+            return "ESP_ERR_NVS_INVALID_HANDLE";
+        case ESP_ERR_NVS_INVALID_LENGTH:
+            return "ESP_ERR_NVS_INVALID_LENGTH";
+        case ESP_ERR_NVS_NO_FREE_PAGES:
+            return "ESP_ERR_NVS_NO_FREE_PAGES";
+        case ESP_ERR_NVS_NEW_VERSION_FOUND:
+            return "ESP_ERR_NVS_NEW_VERSION_FOUND";
+        default:
+            return "UNKNOWN ERROR";
+    }
+}
+
+extern "C" esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+    (void)gpio_num;
+    return (intr_type == GPIO_INTR_LOW_LEVEL || intr_type == GPIO_INTR_HIGH_LEVEL) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+extern "C" esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num)
+{
+    (void)gpio_num;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_sleep_enable_gpio_wakeup(void)
+{
+    gpio_wakeup_armed = true;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us)
+{
+    (void)time_in_us;
+    timer_wakeup_armed = true;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_wakeup_cause_t source)
+{
+    if (source == ESP_SLEEP_WAKEUP_GPIO || source == ESP_SLEEP_WAKEUP_ALL)
+        gpio_wakeup_armed = false;
+    if (source == ESP_SLEEP_WAKEUP_TIMER || source == ESP_SLEEP_WAKEUP_ALL)
+        timer_wakeup_armed = false;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_light_sleep_start(void)
+{
+    if (!gpio_wakeup_armed && !timer_wakeup_armed)
+        return ESP_ERR_INVALID_STATE;
+
+    wakeup_cause = gpio_wakeup_armed ? ESP_SLEEP_WAKEUP_GPIO : ESP_SLEEP_WAKEUP_TIMER;
+    return ESP_OK;
+}
+
+extern "C" esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void)
+{
+    return wakeup_cause;
+}
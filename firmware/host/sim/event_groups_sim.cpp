@@ -0,0 +1,95 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+
+/// @brief Host side state of a simulated event group.
+struct sim_event_group_t {
+    std::mutex lock;
+    std::condition_variable cv;
+    EventBits_t bits = 0;
+    bool is_static = false;
+};
+
+static_assert(sizeof(sim_event_group_t) <= sizeof(StaticEventGroup_t), "grow StaticEventGroup_t");
+static_assert(alignof(sim_event_group_t) <= alignof(StaticEventGroup_t), "align StaticEventGroup_t");
+
+namespace
+{
+    bool bits_satisfied(EventBits_t bits, EventBits_t wait_for, BaseType_t wait_all)
+    {
+        return wait_all ? ((bits & wait_for) == wait_for) : ((bits & wait_for) != 0);
+    }
+} // namespace
+
+extern "C" EventGroupHandle_t xEventGroupCreate(void)
+{
+    return new sim_event_group_t();
+}
+
+extern "C" EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t* pxEventGroupBuffer)
+{
+    if (pxEventGroupBuffer == nullptr)
+        return nullptr;
+
+    sim_event_group_t* group = new (pxEventGroupBuffer->storage) sim_event_group_t();
+    group->is_static = true;
+    return group;
+}
+
+extern "C" void vEventGroupDelete(EventGroupHandle_t xEventGroup)
+{
+    if (xEventGroup == nullptr)
+        return;
+
+    if (xEventGroup->is_static)
+        xEventGroup->~sim_event_group_t();
+    else
+        delete xEventGroup;
+}
+
+extern "C" EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet)
+{
+    EventBits_t bits;
+    {
+        std::lock_guard<std::mutex> guard(xEventGroup->lock);
+        xEventGroup->bits |= uxBitsToSet;
+        bits = xEventGroup->bits;
+    }
+    xEventGroup->cv.notify_all();
+    return bits;
+}
+
+extern "C" EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear)
+{
+    std::lock_guard<std::mutex> guard(xEventGroup->lock);
+    EventBits_t before = xEventGroup->bits;
+    xEventGroup->bits &= ~uxBitsToClear;
+    return before;
+}
+
+extern "C" EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup)
+{
+    std::lock_guard<std::mutex> guard(xEventGroup->lock);
+    return xEventGroup->bits;
+}
+
+extern "C" EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToWaitFor,
+        const BaseType_t xClearOnExit, const BaseType_t xWaitForAllBits, TickType_t xTicksToWait)
+{
+    std::unique_lock<std::mutex> guard(xEventGroup->lock);
+    auto ready = [&]() { return bits_satisfied(xEventGroup->bits, uxBitsToWaitFor, xWaitForAllBits); };
+
+    if (xTicksToWait == portMAX_DELAY)
+        xEventGroup->cv.wait(guard, ready);
+    else
+        xEventGroup->cv.wait_for(guard, std::chrono::milliseconds(xTicksToWait * portTICK_PERIOD_MS), ready);
+
+    EventBits_t bits = xEventGroup->bits;
+    if (xClearOnExit && ready())
+        xEventGroup->bits &= ~uxBitsToWaitFor;
+    return bits;
+}
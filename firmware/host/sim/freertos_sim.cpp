@@ -0,0 +1,158 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+
+/// @brief Host side bookkeeping of a simulated task.
+struct sim_task_t {
+    TaskFunction_t fxn;
+    void* arg;
+    BaseType_t core_id;
+    std::mutex lock;
+    std::condition_variable resumed;
+    bool suspended = false;
+    bool is_static = false;
+};
+
+static_assert(sizeof(sim_task_t) <= sizeof(StaticTask_t), "grow StaticTask_t");
+static_assert(alignof(sim_task_t) <= alignof(StaticTask_t), "align StaticTask_t");
+
+namespace
+{
+    /// @brief Thrown by vTaskDelete(NULL) to unwind back to the task trampoline.
+    struct task_exit_t {
+    };
+
+    thread_local sim_task_t* current_task = nullptr;
+
+    void park_if_suspended(sim_task_t* task)
+    {
+        if (task == nullptr)
+            return;
+
+        std::unique_lock<std::mutex> guard(task->lock);
+        task->resumed.wait(guard, [task]() { return !task->suspended; });
+    }
+
+    const std::chrono::steady_clock::time_point boot_time = std::chrono::steady_clock::now();
+
+    void task_trampoline(sim_task_t* task)
+    {
+        current_task = task;
+        try
+        {
+            task->fxn(task->arg);
+        }
+        catch (const task_exit_t&)
+        {
+        }
+        current_task = nullptr;
+        if (task->is_static)
+            task->~sim_task_t();
+        else
+            delete task;
+    }
+} // namespace
+
+extern "C" BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pxTaskCode, const char* pcName, uint32_t usStackDepth,
+        void* pvParameters, UBaseType_t uxPriority, TaskHandle_t* pxCreatedTask, BaseType_t xCoreID)
+{
+    (void)pcName;
+    (void)usStackDepth;
+    (void)uxPriority;
+
+    if (pxTaskCode == nullptr)
+        return pdFAIL;
+
+    sim_task_t* task = new sim_task_t();
+    task->fxn = pxTaskCode;
+    task->arg = pvParameters;
+    task->core_id = (xCoreID == tskNO_AFFINITY) ? 0 : xCoreID;
+    if (pxCreatedTask != nullptr)
+        *pxCreatedTask = task;
+
+    std::thread(task_trampoline, task).detach();
+    return pdPASS;
+}
+
+extern "C" TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t pxTaskCode, const char* pcName,
+        uint32_t ulStackDepth, void* pvParameters, UBaseType_t uxPriority, StackType_t* puxStackBuffer,
+        StaticTask_t* pxTaskBuffer, BaseType_t xCoreID)
+{
+    (void)pcName;
+    (void)ulStackDepth;
+    (void)uxPriority;
+
+    if (pxTaskCode == nullptr || puxStackBuffer == nullptr || pxTaskBuffer == nullptr)
+        return nullptr;
+
+    // the task record lives in the caller's buffer, the host thread still has its own stack
+    sim_task_t* task = new (pxTaskBuffer->storage) sim_task_t();
+    task->fxn = pxTaskCode;
+    task->arg = pvParameters;
+    task->core_id = (xCoreID == tskNO_AFFINITY) ? 0 : xCoreID;
+    task->is_static = true;
+
+    std::thread(task_trampoline, task).detach();
+    return task;
+}
+
+extern "C" void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+    // only self deletion is supported, threads cannot be killed from outside
+    if (xTaskToDelete == nullptr || xTaskToDelete == current_task)
+        throw task_exit_t();
+}
+
+extern "C" void vTaskSuspend(TaskHandle_t xTaskToSuspend)
+{
+    sim_task_t* task = (xTaskToSuspend != nullptr) ? xTaskToSuspend : current_task;
+    if (task == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> guard(task->lock);
+        task->suspended = true;
+    }
+
+    if (task == current_task)
+        park_if_suspended(task);
+}
+
+extern "C" void vTaskResume(TaskHandle_t xTaskToResume)
+{
+    if (xTaskToResume == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> guard(xTaskToResume->lock);
+        xTaskToResume->suspended = false;
+    }
+    xTaskToResume->resumed.notify_all();
+}
+
+extern "C" void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(xTicksToDelay * portTICK_PERIOD_MS));
+    park_if_suspended(current_task);
+}
+
+extern "C" TickType_t xTaskGetTickCount(void)
+{
+    auto elapsed = std::chrono::steady_clock::now() - boot_time;
+    return static_cast<TickType_t>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+}
+
+extern "C" TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return current_task;
+}
+
+extern "C" BaseType_t xPortGetCoreID(void)
+{
+    return (current_task != nullptr) ? current_task->core_id : 0;
+}
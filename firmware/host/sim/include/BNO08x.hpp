@@ -0,0 +1,361 @@
+// BNO08x.hpp (host simulation)
+#ifndef BNO08X_HPP
+#define BNO08X_HPP
+
+/**
+ * Host stand-in for the esp32_BNO08x driver. Exposes the same public surface the
+ * firmware uses (rpt.* report objects, register_cb, get_frs/write_frs, resets) but
+ * is fed from scripted or recorded sample streams through bno08x_sim.hpp instead
+ * of SPI/SHTP traffic.
+ */
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "BNO08xGlobalTypes.hpp"
+#include "BNO08xPrivateTypes.hpp"
+
+class BNO08x;
+
+/// @brief One report sample as delivered by the simulated sensor hub.
+typedef struct bno08x_sim_sample_t {
+    uint32_t t_us = 0;         ///< sensor-hub timestamp of the sample
+    uint8_t report_id = 0;     ///< sh2_SensorId_t of the report
+    uint8_t accuracy = 3;      ///< BNO08xAccuracy of the sample
+    float v[6] = {};           ///< report payload, meaning depends on report_id
+} bno08x_sim_sample_t;
+
+class BNO08xRpt
+{
+    public:
+        const uint8_t ID;
+
+        bool enable(uint32_t time_between_reports, sh2_SensorConfig_t sensor_cfg = BNO08xPrivateTypes::default_sensor_cfg);
+        bool disable(sh2_SensorConfig_t sensor_cfg = BNO08xPrivateTypes::default_sensor_cfg);
+        bool has_new_data();
+        void register_cb(std::function<void(void)> cb_fxn);
+        bool get_meta_data(bno08x_meta_data_t& meta_data);
+        bool flush();
+
+        virtual ~BNO08xRpt() = default;
+
+    protected:
+        BNO08xRpt(BNO08x* imu, uint8_t ID)
+            : ID(ID)
+            , imu(imu)
+        {
+        }
+
+        virtual void update_data(const bno08x_sim_sample_t& sample) = 0;
+
+        BNO08x* imu;
+        std::mutex data_lock;
+        bool enabled = false;
+        bool new_data = false;
+        uint32_t period_us = 0;
+        sh2_SensorConfig_t sensor_cfg = BNO08xPrivateTypes::default_sensor_cfg;
+        std::function<void(void)> cb;
+
+        friend class BNO08x;
+        friend struct bno08x_sim_access;
+};
+
+/// @brief Report holding a single data struct returned by get().
+template <typename T>
+class BNO08xRptValue : public BNO08xRpt
+{
+    public:
+        T get()
+        {
+            std::lock_guard<std::mutex> guard(data_lock);
+            return data;
+        }
+
+    protected:
+        using BNO08xRpt::BNO08xRpt;
+        T data{};
+};
+
+class BNO08xRptAcceleration : public BNO08xRptValue<bno08x_accel_t>
+{
+    public:
+        BNO08xRptAcceleration(BNO08x* imu, uint8_t ID)
+            : BNO08xRptValue(imu, ID)
+        {
+        }
+
+    private:
+        void update_data(const bno08x_sim_sample_t& sample) override;
+};
+
+class BNO08xRptRawAccelerometer : public BNO08xRptValue<bno08x_raw_accel_t>
+{
+    public:
+        explicit BNO08xRptRawAccelerometer(BNO08x* imu)
+            : BNO08xRptValue(imu, SH2_RAW_ACCELEROMETER)
+        {
+        }
+
+    private:
+        void update_data(const bno08x_sim_sample_t& sample) override;
+};
+
+class BNO08xRptRawGyro : public BNO08xRptValue<bno08x_raw_gyro_t>
+{
+    public:
+        explicit BNO08xRptRawGyro(BNO08x* imu)
+            : BNO08xRptValue(imu, SH2_RAW_GYROSCOPE)
+        {
+        }
+
+    private:
+        void update_data(const bno08x_sim_sample_t& sample) override;
+};
+
+class BNO08xRptCalGyro : public BNO08xRptValue<bno08x_gyro_t>
+{
+    public:
+        explicit BNO08xRptCalGyro(BNO08x* imu)
+            : BNO08xRptValue(imu, SH2_GYROSCOPE_CALIBRATED)
+        {
+        }
+
+    private:
+        void update_data(const bno08x_sim_sample_t& sample) override;
+};
+
+class BNO08xRptUncalGyro : public BNO08xRpt
+{
+    public:
+        explicit BNO08xRptUncalGyro(BNO08x* imu)
+            : BNO08xRpt(imu, SH2_GYROSCOPE_UNCALIBRATED)
+        {
+        }
+
+        void get(bno08x_gyro_t& vel, bno08x_gyro_bias_t& bias);
+        bno08x_gyro_t get_vel();
+        bno08x_gyro_bias_t get_bias();
+
+    private:
+        void update_data(const bno08x_sim_sample_t& sample) override;
+        bno08x_gyro_t data{};
+        bno08x_gyro_bias_t bias_data{};
+};
+
+class BNO08xRptRawMagnetometer : public BNO08xRptValue<bno08x_raw_magf_t>
+{
+    public:
+        explicit BNO08xRptRawMagnetometer(BNO08x* imu)
+            : BNO08xRptValue(imu, SH2_RAW_MAGNETOMETER)
+        {
+        }
+
+    private:
+        void update_data(const bno08x_sim_sample_t& sample) override;
+};
+
+class BNO08xRptCalMagnetometer : public BNO08xRptValue<bno08x_magf_t>
+{
+    public:
+        explicit BNO08xRptCalMagnetometer(BNO08x* imu)
+            : BNO08xRptValue(imu, SH2_MAGNETIC_FIELD_CALIBRATED)
+        {
+        }
+
+    private:
+        void update_data(const bno08x_sim_sample_t& sample) override;
+};
+
+class BNO08xRptUncalMagnetometer : public BNO08xRpt
+{
+    public:
+        explicit BNO08xRptUncalMagnetometer(BNO08x* imu)
+            : BNO08xRpt(imu, SH2_MAGNETIC_FIELD_UNCALIBRATED)
+        {
+        }
+
+        void get(bno08x_magf_t& magf, bno08x_magf_bias_t& bias);
+        bno08x_magf_t get_magf();
+        bno08x_magf_bias_t get_bias();
+
+    private:
+        void update_data(const bno08x_sim_sample_t& sample) override;
+        bno08x_magf_t data{};
+        bno08x_magf_bias_t bias_data{};
+};
+
+class BNO08xRptRVGeneric : public BNO08xRpt
+{
+    public:
+        BNO08xRptRVGeneric(BNO08x* imu, uint8_t ID)
+            : BNO08xRpt(imu, ID)
+        {
+        }
+
+        bno08x_quat_t get_quat();
+        bno08x_euler_angle_t get_euler(bool in_degrees = true);
+
+    private:
+        void update_data(const bno08x_sim_sample_t& sample) override;
+        bno08x_quat_t data{};
+};
+
+class BNO08xRptActivityClassifier : public BNO08xRptValue<bno08x_activity_classifier_t>
+{
+    public:
+        explicit BNO08xRptActivityClassifier(BNO08x* imu)
+            : BNO08xRptValue(imu, SH2_PERSONAL_ACTIVITY_CLASSIFIER)
+        {
+        }
+
+    private:
+        void update_data(const bno08x_sim_sample_t& sample) override;
+};
+
+class BNO08xRptStabilityClassifier : public BNO08xRptValue<bno08x_stability_classifier_t>
+{
+    public:
+        explicit BNO08xRptStabilityClassifier(BNO08x* imu)
+            : BNO08xRptValue(imu, SH2_STABILITY_CLASSIFIER)
+        {
+        }
+
+    private:
+        void update_data(const bno08x_sim_sample_t& sample) override;
+};
+
+class BNO08xRptShakeDetector : public BNO08xRptValue<bno08x_shake_detector_t>
+{
+    public:
+        explicit BNO08xRptShakeDetector(BNO08x* imu)
+            : BNO08xRptValue(imu, SH2_SHAKE_DETECTOR)
+        {
+        }
+
+    private:
+        void update_data(const bno08x_sim_sample_t& sample) override;
+};
+
+class BNO08xRptStepCounter : public BNO08xRptValue<bno08x_step_counter_t>
+{
+    public:
+        explicit BNO08xRptStepCounter(BNO08x* imu)
+            : BNO08xRptValue(imu, SH2_STEP_COUNTER)
+        {
+        }
+
+    private:
+        void update_data(const bno08x_sim_sample_t& sample) override;
+};
+
+class BNO08xRptSignificantMotion : public BNO08xRptValue<bno08x_significant_motion_t>
+{
+    public:
+        explicit BNO08xRptSignificantMotion(BNO08x* imu)
+            : BNO08xRptValue(imu, SH2_SIGNIFICANT_MOTION)
+        {
+        }
+
+    private:
+        void update_data(const bno08x_sim_sample_t& sample) override;
+};
+
+/// @brief Report objects exposed through BNO08x::rpt, names match esp32_BNO08x.
+typedef struct bno08x_reports_t {
+    BNO08xRptRawAccelerometer raw_accelerometer;
+    BNO08xRptAcceleration accelerometer;
+    BNO08xRptAcceleration linear_accelerometer;
+    BNO08xRptAcceleration gravity;
+    BNO08xRptRawGyro raw_gyro;
+    BNO08xRptCalGyro cal_gyro;
+    BNO08xRptUncalGyro uncal_gyro;
+    BNO08xRptRawMagnetometer raw_magnetometer;
+    BNO08xRptCalMagnetometer cal_magnetometer;
+    BNO08xRptUncalMagnetometer uncal_magnetometer;
+    BNO08xRptRVGeneric rv;
+    BNO08xRptRVGeneric rv_game;
+    BNO08xRptRVGeneric rv_ARVR_stabilized;
+    BNO08xRptRVGeneric rv_ARVR_stabilized_game;
+    BNO08xRptRVGeneric rv_gyro_integrated;
+    BNO08xRptRVGeneric rv_geomagnetic;
+    BNO08xRptActivityClassifier activity_classifier;
+    BNO08xRptStabilityClassifier stability_classifier;
+    BNO08xRptShakeDetector shake_detector;
+    BNO08xRptStepCounter step_counter;
+    BNO08xRptSignificantMotion significant_motion;
+
+    explicit bno08x_reports_t(BNO08x* imu)
+        : raw_accelerometer(imu)
+        , accelerometer(imu, SH2_ACCELEROMETER)
+        , linear_accelerometer(imu, SH2_LINEAR_ACCELERATION)
+        , gravity(imu, SH2_GRAVITY)
+        , raw_gyro(imu)
+        , cal_gyro(imu)
+        , uncal_gyro(imu)
+        , raw_magnetometer(imu)
+        , cal_magnetometer(imu)
+        , uncal_magnetometer(imu)
+        , rv(imu, SH2_ROTATION_VECTOR)
+        , rv_game(imu, SH2_GAME_ROTATION_VECTOR)
+        , rv_ARVR_stabilized(imu, SH2_ARVR_STABILIZED_RV)
+        , rv_ARVR_stabilized_game(imu, SH2_ARVR_STABILIZED_GRV)
+        , rv_gyro_integrated(imu, SH2_GYRO_INTEGRATED_RV)
+        , rv_geomagnetic(imu, SH2_GEOMAGNETIC_ROTATION_VECTOR)
+        , activity_classifier(imu)
+        , stability_classifier(imu)
+        , shake_detector(imu)
+        , step_counter(imu)
+        , significant_motion(imu)
+    {
+    }
+} bno08x_reports_t;
+
+class BNO08x
+{
+    public:
+        explicit BNO08x(bno08x_config_t imu_config = bno08x_config_t());
+        ~BNO08x();
+
+        bool initialize();
+        bool hard_reset();
+        bool soft_reset();
+        bool disable_all_reports();
+        bool data_available();
+
+        void register_cb(std::function<void(void)> cb_fxn);
+        void register_cb(std::function<void(uint8_t report_ID)> cb_fxn);
+
+        /// @brief Called after every hub reset (SH2_RESET async event), requested or not, from the library's context
+        /// @note A sim hook: imu_driver detects at compile time whether the esp32_BNO08x release has it
+        void register_reset_cb(std::function<void(void)> cb_fxn);
+
+        bool get_frs(BNO08xFrsID frs_ID, uint32_t (&data)[16], uint16_t& rx_data_sz);
+        bool write_frs(BNO08xFrsID frs_ID, uint32_t* data, uint16_t tx_data_sz);
+
+        bool dynamic_calibration_enable(BNO08xCalSel sensor);
+        bool dynamic_calibration_disable(BNO08xCalSel sensor);
+        bool dynamic_calibration_run_routine();
+        bool dynamic_calibration_save();
+
+        bno08x_reports_t rpt;
+
+    private:
+        BNO08xRpt* find_report(uint8_t report_ID);
+        void reset_reports();
+        void notify_reset();
+
+        bno08x_config_t imu_config;
+        std::recursive_mutex cb_lock;
+        std::vector<std::function<void(void)>> cb_list_void;
+        std::vector<std::function<void(uint8_t)>> cb_list_id;
+        std::vector<std::function<void(void)>> cb_list_reset;
+        std::map<uint16_t, std::vector<uint32_t>> frs_records;
+
+        friend class BNO08xRpt;
+        friend struct bno08x_sim_access;
+};
+
+#endif /* BNO08X_HPP */
@@ -0,0 +1,289 @@
+// BNO08xGlobalTypes.hpp (host simulation)
+#ifndef BNO08X_GLOBAL_TYPES_HPP
+#define BNO08X_GLOBAL_TYPES_HPP
+
+/**
+ * Public types of the esp32_BNO08x component, reproduced for the host build.
+ * Layouts follow the lib/sig-motion-ext branch used by the firmware.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include "driver/gpio.h"
+#include "sh2.h"
+
+/// @brief IMU configuration settings passed into constructor
+typedef struct bno08x_config_t {
+    int spi_peripheral = 1;
+    gpio_num_t io_mosi = 11;
+    gpio_num_t io_miso = 13;
+    gpio_num_t io_sclk = 12;
+    gpio_num_t io_cs = 10;
+    gpio_num_t io_int = 9;
+    gpio_num_t io_rst = 8;
+    uint32_t sclk_speed = 2000000UL;
+    bool install_isr_service = true;
+} bno08x_config_t;
+
+enum class BNO08xAccuracy : uint8_t {
+    UNRELIABLE,
+    LOW,
+    MED,
+    HIGH,
+    UNDEFINED
+};
+
+enum class BNO08xActivity : uint8_t {
+    UNKNOWN = 0,
+    IN_VEHICLE = 1,
+    ON_BICYCLE = 2,
+    ON_FOOT = 3,
+    STILL = 4,
+    TILTING = 5,
+    WALKING = 6,
+    RUNNING = 7,
+    ON_STAIRS = 8,
+    UNDEFINED = 9
+};
+
+enum class BNO08xStability : uint8_t {
+    UNKNOWN = 0,
+    ON_TABLE = 1,
+    STATIONARY = 2,
+    STABLE = 3,
+    MOTION = 4,
+    RESERVED = 5,
+    UNDEFINED = 6
+};
+
+enum class BNO08xCalSel : uint8_t {
+    accelerometer = (1U << 0U),
+    gyro = (1U << 1U),
+    magnetometer = (1U << 2U),
+    planar_accelerometer = (1U << 3U),
+    all = (1U << 0U) | (1U << 1U) | (1U << 2U)
+};
+
+enum class BNO08xFrsID : uint16_t {
+    STATIC_CALIBRATION_AGM = 0x7979,
+    NOMINAL_CALIBRATION = 0x4D4D,
+    STATIC_CALIBRATION_SRA = 0x8A8A,
+    NOMINAL_CALIBRATION_SRA = 0x4E4E,
+    DYNAMIC_CALIBRATION = 0x1F1F,
+    ME_POWER_MGMT = 0xD3E2,
+    SYSTEM_ORIENTATION = 0x2D3E,
+    ACCEL_ORIENTATION = 0x2D41,
+    SCREEN_ACCEL_ORIENTATION = 0x2D43,
+    GYROSCOPE_ORIENTATION = 0x2D46,
+    MAGNETOMETER_ORIENTATION = 0x2D4C,
+    ARVR_STABILIZATION_RV = 0x3E2D,
+    ARVR_STABILIZATION_GRV = 0x3E2E,
+    TAP_DETECT_CONFIG = 0xC269,
+    SIG_MOTION_DETECT_CONFIG = 0xC274,
+    SHAKE_DETECT_CONFIG = 0x7D7D,
+    MAX_FUSION_PERIOD = 0xD7D7,
+    SERIAL_NUMBER = 0x4B4B,
+    ES_PRESSURE_CAL = 0x39AF,
+    ES_TEMPERATURE_CAL = 0x4D20,
+    ES_HUMIDITY_CAL = 0x1AC9,
+    ES_AMBIENT_LIGHT_CAL = 0x39B1,
+    ES_PROXIMITY_CAL = 0x4DA2,
+    ALS_CAL = 0xD401,
+    PROXIMITY_SENSOR_CAL = 0xD402,
+    PICKUP_DETECTOR_CONFIG = 0x1B2A,
+    FLIP_DETECTOR_CONFIG = 0xFC94,
+    STABILITY_DETECTOR_CONFIG = 0xED85,
+    ACTIVITY_TRACKER_CONFIG = 0xED88,
+    SLEEP_DETECTOR_CONFIG = 0xED87,
+    TILT_DETECTOR_CONFIG = 0xED89,
+    POCKET_DETECTOR_CONFIG = 0xEF27,
+    CIRCLE_DETECTOR_CONFIG = 0xEE51,
+    USER_RECORD = 0x74B4,
+    ME_TIME_SOURCE_SELECT = 0xD403,
+    UART_FORMAT = 0xA1A1,
+    GYRO_INTEGRATED_RV_CONFIG = 0xA1A2,
+    DR_IMU_CONFIG = 0xDED2,
+    DR_VEL_EST_CONFIG = 0xDED3,
+    DR_SYNC_CONFIG = 0xDED4,
+    DR_QUAL_CONFIG = 0xDED5,
+    DR_CAL_CONFIG = 0xDED6,
+    DR_LIGHT_REC_CONFIG = 0xDED8,
+    DR_FUSION_CONFIG = 0xDED9,
+    DR_OF_CONFIG = 0xDEDA,
+    DR_WHEEL_CONFIG = 0xDEDB,
+    DR_CAL = 0xDEDC,
+    DR_WHEEL_SELECT = 0xDEDF,
+    FRS_ID_META_RAW_ACCELEROMETER = 0xE301,
+    FRS_ID_META_ACCELEROMETER = 0xE302,
+    FRS_ID_META_LINEAR_ACCELERATION = 0xE303,
+    FRS_ID_META_GRAVITY = 0xE304,
+    FRS_ID_META_RAW_GYROSCOPE = 0xE305,
+    FRS_ID_META_GYROSCOPE_CALIBRATED = 0xE306,
+    FRS_ID_META_GYROSCOPE_UNCALIBRATED = 0xE307,
+    FRS_ID_META_RAW_MAGNETOMETER = 0xE308,
+    FRS_ID_META_MAGNETIC_FIELD_CALIBRATED = 0xE309,
+    FRS_ID_META_MAGNETIC_FIELD_UNCALIBRATED = 0xE30A,
+    FRS_ID_META_ROTATION_VECTOR = 0xE30B,
+    FRS_ID_META_GAME_ROTATION_VECTOR = 0xE30C,
+    FRS_ID_META_GEOMAGNETIC_ROTATION_VECTOR = 0xE30D,
+    FRS_ID_META_STABILITY_CLASSIFIER = 0xE31F,
+    FRS_ID_META_SHAKE_DETECTOR = 0xE320,
+    FRS_ID_META_SIGNIFICANT_MOTION = 0xE322,
+    FRS_ID_META_PERSONAL_ACTIVITY_CLASSIFIER = 0xE325,
+    UNDEFINED = 0xFFFF
+};
+
+inline const char* BNO08xFrsID_to_str(BNO08xFrsID id)
+{
+    switch (id)
+    {
+        case BNO08xFrsID::STATIC_CALIBRATION_AGM:
+            return "STATIC_CALIBRATION_AGM";
+        case BNO08xFrsID::NOMINAL_CALIBRATION:
+            return "NOMINAL_CALIBRATION";
+        case BNO08xFrsID::DYNAMIC_CALIBRATION:
+            return "DYNAMIC_CALIBRATION";
+        case BNO08xFrsID::ME_POWER_MGMT:
+            return "ME_POWER_MGMT";
+        case BNO08xFrsID::SYSTEM_ORIENTATION:
+            return "SYSTEM_ORIENTATION";
+        case BNO08xFrsID::TAP_DETECT_CONFIG:
+            return "TAP_DETECT_CONFIG";
+        case BNO08xFrsID::SIG_MOTION_DETECT_CONFIG:
+            return "SIG_MOTION_DETECT_CONFIG";
+        case BNO08xFrsID::SHAKE_DETECT_CONFIG:
+            return "SHAKE_DETECT_CONFIG";
+        case BNO08xFrsID::MAX_FUSION_PERIOD:
+            return "MAX_FUSION_PERIOD";
+        case BNO08xFrsID::SERIAL_NUMBER:
+            return "SERIAL_NUMBER";
+        case BNO08xFrsID::STABILITY_DETECTOR_CONFIG:
+            return "STABILITY_DETECTOR_CONFIG";
+        case BNO08xFrsID::ACTIVITY_TRACKER_CONFIG:
+            return "ACTIVITY_TRACKER_CONFIG";
+        case BNO08xFrsID::USER_RECORD:
+            return "USER_RECORD";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+/// @brief Meta data of a sensor, read from its FRS meta data record.
+typedef struct bno08x_meta_data_t {
+    uint8_t me_version = 0;
+    uint8_t mh_version = 0;
+    uint8_t sh_version = 0;
+    uint32_t range = 0;
+    uint32_t resolution = 0;
+    uint16_t revision = 0;
+    uint16_t power_mA = 0;
+    uint32_t min_period_uS = 0;
+    uint32_t max_period_uS = 0;
+    uint32_t fifo_reserved = 0;
+    uint32_t fifo_max = 0;
+    uint32_t batch_buffer_bytes = 0;
+    uint16_t q_point_1 = 0;
+    uint16_t q_point_2 = 0;
+    uint16_t q_point_3 = 0;
+    uint32_t vendor_id_len = 0;
+    char vendor_id[48] = {};
+    uint32_t sensor_specific_len = 0;
+    uint8_t sensor_specific[48] = {};
+} bno08x_meta_data_t;
+
+typedef struct bno08x_quat_t {
+    float real = 0.0f;
+    float i = 0.0f;
+    float j = 0.0f;
+    float k = 0.0f;
+    BNO08xAccuracy accuracy = BNO08xAccuracy::UNDEFINED;
+    float rad_accuracy = 0.0f;
+} bno08x_quat_t;
+
+typedef struct bno08x_euler_angle_t {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+    BNO08xAccuracy accuracy = BNO08xAccuracy::UNDEFINED;
+    float rad_accuracy = 0.0f;
+} bno08x_euler_angle_t;
+
+typedef struct bno08x_gyro_t {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+} bno08x_gyro_t;
+
+typedef struct bno08x_gyro_bias_t {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+} bno08x_gyro_bias_t;
+
+typedef struct bno08x_accel_t {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+    BNO08xAccuracy accuracy = BNO08xAccuracy::UNDEFINED;
+} bno08x_accel_t;
+
+typedef struct bno08x_magf_t {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+    BNO08xAccuracy accuracy = BNO08xAccuracy::UNDEFINED;
+} bno08x_magf_t;
+
+typedef struct bno08x_magf_bias_t {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+} bno08x_magf_bias_t;
+
+typedef struct bno08x_raw_accel_t {
+    int16_t x = 0;
+    int16_t y = 0;
+    int16_t z = 0;
+    uint32_t timestamp_us = 0;
+} bno08x_raw_accel_t;
+
+typedef struct bno08x_raw_gyro_t {
+    int16_t x = 0;
+    int16_t y = 0;
+    int16_t z = 0;
+    int16_t temperature = 0;
+    uint32_t timestamp_us = 0;
+} bno08x_raw_gyro_t;
+
+typedef struct bno08x_raw_magf_t {
+    int16_t x = 0;
+    int16_t y = 0;
+    int16_t z = 0;
+    uint32_t timestamp_us = 0;
+} bno08x_raw_magf_t;
+
+typedef struct bno08x_step_counter_t {
+    uint32_t latency = 0;
+    uint16_t steps = 0;
+} bno08x_step_counter_t;
+
+typedef struct bno08x_activity_classifier_t {
+    uint8_t page = 0;
+    bool lastPage = false;
+    BNO08xActivity mostLikelyState = BNO08xActivity::UNDEFINED;
+    uint8_t confidence = 0;
+} bno08x_activity_classifier_t;
+
+typedef struct bno08x_stability_classifier_t {
+    BNO08xStability stability = BNO08xStability::UNDEFINED;
+} bno08x_stability_classifier_t;
+
+typedef struct bno08x_shake_detector_t {
+    uint16_t shake = 0;
+} bno08x_shake_detector_t;
+
+typedef struct bno08x_significant_motion_t {
+    uint16_t motion = 0;
+} bno08x_significant_motion_t;
+
+#endif /* BNO08X_GLOBAL_TYPES_HPP */
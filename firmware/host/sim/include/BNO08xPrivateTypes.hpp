@@ -0,0 +1,23 @@
+// BNO08xPrivateTypes.hpp (host simulation)
+#ifndef BNO08X_PRIVATE_TYPES_HPP
+#define BNO08X_PRIVATE_TYPES_HPP
+
+#include "sh2.h"
+
+namespace BNO08xPrivateTypes
+{
+    /// @brief Sensor config used when none is supplied to enable().
+    static constexpr sh2_SensorConfig_t default_sensor_cfg = {
+        .changeSensitivityEnabled = false,
+        .changeSensitivityRelative = false,
+        .wakeupEnabled = false,
+        .alwaysOnEnabled = false,
+        .sniffEnabled = false,
+        .changeSensitivity = 0,
+        .reportInterval_us = 0,
+        .batchInterval_us = 0,
+        .sensorSpecific = 0
+    };
+} // namespace BNO08xPrivateTypes
+
+#endif /* BNO08X_PRIVATE_TYPES_HPP */
@@ -0,0 +1,139 @@
+// bno08x_sim.hpp
+#ifndef BNO08X_SIM_H
+#define BNO08X_SIM_H
+
+/**
+ * Control surface of the simulated BNO08x used by the host build. Samples are
+ * injected synchronously: the report is updated and every registered callback
+ * runs on the injecting thread before inject() returns.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BNO08x.hpp"
+
+/// @brief Bus level counters of the simulated sensor hub.
+typedef struct bno08x_sim_stats_t {
+    uint32_t set_feature_cmds = 0;   ///< enable/disable requests sent to the hub
+    uint32_t frs_reads = 0;          ///< FRS read handshakes
+    uint32_t frs_writes = 0;         ///< FRS write handshakes
+    uint32_t cal_config_cmds = 0;    ///< dynamic calibration enable / disable commands
+    uint32_t resets = 0;             ///< hard + soft resets and power cycles
+    uint64_t samples_delivered = 0;  ///< samples accepted by an enabled report
+    uint64_t samples_dropped = 0;    ///< samples for reports that were not enabled
+    uint64_t samples_batched = 0;    ///< samples held in the hub FIFO before delivery
+    uint32_t host_wakes = 0;         ///< times the hub asserted HINT (one per immediate sample or FIFO flush)
+    uint32_t fifo_flushes = 0;       ///< non-empty hub FIFO flushes
+} bno08x_sim_stats_t;
+
+/// @brief bno08x_sim::set_reset_message_delay() value for a reset message that never arrives
+#define BNO08X_SIM_RESET_MSG_LOST UINT32_MAX
+
+/// @brief Motion profiles available to the scripted stream generator.
+enum class bno08x_sim_profile_t : uint8_t {
+    SLEEP,
+    WALK,
+    RUN,
+    SCRATCH,    ///< sitting, hind leg scratching at the collar
+    EAT,        ///< head down over a bowl, chewing
+    SHAKE,      ///< whole body shake, large fast roll
+};
+
+namespace bno08x_sim
+{
+    /**
+     * @brief Get the most recently constructed BNO08x instance
+     * @return pointer to the instance, nullptr if none exists
+     */
+    BNO08x* active();
+
+    /**
+     * @brief Deliver one sample to the active instance
+     * @param sample: sample to deliver
+     * @return true if the target report was enabled and the sample was accepted
+     * @note Reports enabled with a batchInterval_us queue in the hub FIFO, callbacks run when it is flushed
+     */
+    bool inject(const bno08x_sim_sample_t& sample);
+
+    /**
+     * @brief Flush the hub FIFO now, as a host flush request or the batch timer would
+     * @return number of samples flushed
+     */
+    size_t flush();
+
+    /**
+     * @brief Power cycle the hub: every report is disabled and calibration restarts from the stored DCD
+     * @param keep_flash: false models a blank or replaced hub, every FRS record (DCD included) is lost
+     * @note The host is not asked, it learns of the reset from the SHTP reset message (register_reset_cb())
+     * @return false if no instance exists
+     */
+    bool power_cycle(bool keep_flash = true);
+
+    /**
+     * @brief When the SHTP reset message follows a reset or power cycle, 0 (the default) before the call returns
+     * @param delay_us: delivered from another thread this long after the reset, as a booting hub sends it;
+     *                  BNO08X_SIM_RESET_MSG_LOST drops it, the host only sees the reports go silent
+     */
+    void set_reset_message_delay(uint32_t delay_us);
+
+    /**
+     * @brief Make the hub reject the next set-feature commands (enable / disable), the report keeps its state
+     * @param count: commands to reject, 0 stops rejecting; rejected commands still count in set_feature_cmds
+     */
+    void reject_commands(uint32_t count);
+
+    /**
+     * @brief Make the next FRS writes report success but store the record with its last word altered
+     * @param count: writes to corrupt, 0 stops corrupting; only a read back finds them
+     */
+    void corrupt_frs_writes(uint32_t count);
+
+    /**
+     * @brief Sensors the hub is running dynamic calibration for, volatile: a reset restores BNO08xCalSel::all
+     * @return OR of BNO08xCalSel bits
+     */
+    uint8_t cal_config();
+
+    /**
+     * @brief Set the hub clock raw report timestamps are taken from
+     * @param offset_us: hub time at stream time 0
+     * @param drift_ppm: hub oscillator rate error, positive when the hub clock runs fast
+     */
+    void set_hub_clock(int32_t offset_us, float drift_ppm);
+
+    /**
+     * @brief Deliver a sequence of samples in order
+     * @param samples: samples to deliver
+     * @param count: number of samples
+     * @return number of samples accepted
+     */
+    size_t replay(const bno08x_sim_sample_t* samples, size_t count);
+
+    /**
+     * @brief Load a recorded stream from CSV (t_us,report_id,accuracy,v0..v5 per line, '#' comments)
+     * @param path: file to read
+     * @param out: vector the samples are appended to
+     * @return true if the file could be opened and parsed
+     */
+    bool load_csv(const char* path, std::vector<bno08x_sim_sample_t>& out);
+
+    /**
+     * @brief Generate a scripted stream for a set of reports
+     * @param profile: motion profile to synthesize
+     * @param report_ids: reports to generate, each at period_us
+     * @param count: number of reports in report_ids
+     * @param period_us: sample period of every report
+     * @param duration_us: length of the stream
+     * @param out: vector the samples are appended to, ordered by timestamp
+     * @param seed: noise seed, identical seeds give identical streams
+     */
+    void generate(bno08x_sim_profile_t profile, const uint8_t* report_ids, size_t count, uint32_t period_us,
+            uint32_t duration_us, std::vector<bno08x_sim_sample_t>& out, uint32_t seed = 1U);
+
+    bno08x_sim_stats_t stats();
+    void reset_stats();
+} // namespace bno08x_sim
+
+#endif /* BNO08X_SIM_H */
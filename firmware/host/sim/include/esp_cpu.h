@@ -0,0 +1,23 @@
+// esp_cpu.h (host simulation)
+#ifndef ESP_CPU_H
+#define ESP_CPU_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+/**
+ * @brief CCOUNT of the running core, the host build derives it from the monotonic
+ * clock at esp_rom_get_cpu_ticks_per_us() so cycle based math matches the target
+ */
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESP_CPU_H */
@@ -0,0 +1,56 @@
+// esp_partition_sim.hpp
+#ifndef ESP_PARTITION_SIM_H
+#define ESP_PARTITION_SIM_H
+
+/**
+ * Control surface of the simulated data partitions. A partition is RAM
+ * backed, or file backed when a path is given: the file is loaded at add()
+ * and every write and erase goes through to it, so a second process (or a
+ * test after a simulated power cut) sees exactly what was programmed.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_partition.h"
+
+/// @brief Flash operation counters of one partition
+typedef struct esp_partition_sim_stats_t {
+    uint64_t bytes_read = 0;
+    uint64_t bytes_written = 0;
+    uint32_t reads = 0;
+    uint32_t writes = 0;
+    uint32_t sector_erases = 0;
+} esp_partition_sim_stats_t;
+
+namespace esp_partition_sim
+{
+    constexpr uint32_t SECTOR_SIZE = 4096;
+
+    /**
+     * @brief Create (or replace) a data partition
+     * @param label: label esp_partition_find_first() matches
+     * @param size: bytes, a multiple of SECTOR_SIZE
+     * @param path: backing file, nullptr for RAM only; an existing file of the same size is loaded, anything else starts erased
+     * @return the partition, nullptr on a bad size or an unwritable path
+     */
+    const esp_partition_t* add(const char* label, uint32_t size, const char* path = nullptr);
+
+    /// @brief Drop every partition, files stay on disk
+    void remove_all();
+
+    /**
+     * @brief Cut power during the next write longer than keep_bytes: only its first keep_bytes reach the flash
+     * @note The write still reports ESP_OK, as the caller never finds out on a real brown-out. Shorter
+     *       writes before it (headers) go through untouched.
+     */
+    void tear_next_write(const esp_partition_t* partition, size_t keep_bytes);
+
+    /// @brief Contents of a partition, valid until it is replaced
+    const uint8_t* data(const esp_partition_t* partition);
+
+    esp_partition_sim_stats_t stats(const esp_partition_t* partition);
+    void reset_stats(const esp_partition_t* partition);
+} // namespace esp_partition_sim
+
+#endif /* ESP_PARTITION_SIM_H */
@@ -0,0 +1,21 @@
+// esp_rom_crc.h (host simulation)
+#ifndef ESP_ROM_CRC_H
+#define ESP_ROM_CRC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief CRC-32 (IEEE 802.3, reflected), same results as the ROM routine
+ * @param crc: running CRC, 0 to start
+ */
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESP_ROM_CRC_H */
@@ -0,0 +1,22 @@
+// esp_rom_sys.h (host simulation)
+#ifndef ESP_ROM_SYS_H
+#define ESP_ROM_SYS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int esp_rom_printf(const char *fmt, ...);
+
+/**
+ * @brief CPU cycles per microsecond, the host build models a 240 MHz ESP32-S3
+ */
+uint32_t esp_rom_get_cpu_ticks_per_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESP_ROM_SYS_H */
@@ -0,0 +1,39 @@
+// FreeRTOS.h (host simulation)
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+/**
+ * Minimal FreeRTOS kernel types for the host build. Tasks map onto std::thread,
+ * one tick is one millisecond.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdFAIL (pdFALSE)
+#define pdPASS (pdTRUE)
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ (1000)
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(((uint64_t)(xTimeInMs) * (uint64_t)configTICK_RATE_HZ) / (uint64_t)1000U))
+#define portNUM_PROCESSORS (2)
+#define tskNO_AFFINITY ((BaseType_t)0x7FFFFFFF)
+#define configMAX_PRIORITIES (25)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FREERTOS_H */
@@ -0,0 +1,37 @@
+// event_groups.h (host simulation)
+#ifndef FREERTOS_EVENT_GROUPS_H
+#define FREERTOS_EVENT_GROUPS_H
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t EventBits_t;
+typedef struct sim_event_group_t *EventGroupHandle_t;
+
+/// @brief Caller provided storage for xEventGroupCreateStatic()
+typedef struct StaticEventGroup_t {
+    uint64_t storage[24];
+} StaticEventGroup_t;
+
+EventGroupHandle_t xEventGroupCreate(void);
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *pxEventGroupBuffer);
+void vEventGroupDelete(EventGroupHandle_t xEventGroup);
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToWaitFor,
+                                const BaseType_t xClearOnExit, const BaseType_t xWaitForAllBits,
+                                TickType_t xTicksToWait);
+
+#define xEventGroupSetBitsFromISR(xEventGroup, uxBitsToSet, pxHigherPriorityTaskWoken) \
+    ((void)(pxHigherPriorityTaskWoken), (BaseType_t)(xEventGroupSetBits((xEventGroup), (uxBitsToSet)), pdPASS))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FREERTOS_EVENT_GROUPS_H */
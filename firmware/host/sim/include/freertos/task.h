@@ -0,0 +1,59 @@
+// task.h (host simulation)
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*TaskFunction_t)(void *);
+typedef struct sim_task_t *TaskHandle_t;
+
+/// @brief Caller provided storage for xTaskCreateStaticPinnedToCore(), the stack buffer is unused on the host
+typedef struct StaticTask_t {
+    uint64_t storage[32];
+} StaticTask_t;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pxTaskCode, const char *pcName, uint32_t usStackDepth,
+                                   void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pxCreatedTask,
+                                   BaseType_t xCoreID);
+
+static inline BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char *pcName, uint32_t usStackDepth,
+                                     void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pxCreatedTask)
+{
+    return xTaskCreatePinnedToCore(pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pxCreatedTask,
+                                   tskNO_AFFINITY);
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t pxTaskCode, const char *pcName, uint32_t ulStackDepth,
+                                           void *pvParameters, UBaseType_t uxPriority, StackType_t *puxStackBuffer,
+                                           StaticTask_t *pxTaskBuffer, BaseType_t xCoreID);
+
+static inline TaskHandle_t xTaskCreateStatic(TaskFunction_t pxTaskCode, const char *pcName, uint32_t ulStackDepth,
+                                             void *pvParameters, UBaseType_t uxPriority, StackType_t *puxStackBuffer,
+                                             StaticTask_t *pxTaskBuffer)
+{
+    return xTaskCreateStaticPinnedToCore(pxTaskCode, pcName, ulStackDepth, pvParameters, uxPriority, puxStackBuffer,
+                                         pxTaskBuffer, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+
+/**
+ * @brief Suspend a task. Host threads cannot be pre-empted, a suspended task parks at
+ *        its next vTaskDelay() (or immediately when suspending itself).
+ */
+void vTaskSuspend(TaskHandle_t xTaskToSuspend);
+void vTaskResume(TaskHandle_t xTaskToResume);
+void vTaskDelay(const TickType_t xTicksToDelay);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xPortGetCoreID(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FREERTOS_TASK_H */
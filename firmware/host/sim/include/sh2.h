@@ -0,0 +1,84 @@
+// sh2.h (host simulation)
+#ifndef SH2_H
+#define SH2_H
+
+/**
+ * Subset of the CEVA SH-2 API consumed by imu_driver. Values mirror the real
+ * sh2.h shipped inside esp32_BNO08x so report IDs and configs are wire compatible.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SH2_OK (0)
+#define SH2_ERR (-1)
+
+enum sh2_SensorId_e {
+    SH2_RAW_ACCELEROMETER = 0x14,
+    SH2_ACCELEROMETER = 0x01,
+    SH2_LINEAR_ACCELERATION = 0x04,
+    SH2_GRAVITY = 0x06,
+    SH2_RAW_GYROSCOPE = 0x15,
+    SH2_GYROSCOPE_CALIBRATED = 0x02,
+    SH2_GYROSCOPE_UNCALIBRATED = 0x07,
+    SH2_RAW_MAGNETOMETER = 0x16,
+    SH2_MAGNETIC_FIELD_CALIBRATED = 0x03,
+    SH2_MAGNETIC_FIELD_UNCALIBRATED = 0x0f,
+    SH2_ROTATION_VECTOR = 0x05,
+    SH2_GAME_ROTATION_VECTOR = 0x08,
+    SH2_GEOMAGNETIC_ROTATION_VECTOR = 0x09,
+    SH2_PRESSURE = 0x0a,
+    SH2_AMBIENT_LIGHT = 0x0b,
+    SH2_HUMIDITY = 0x0c,
+    SH2_PROXIMITY = 0x0d,
+    SH2_TEMPERATURE = 0x0e,
+    SH2_RESERVED = 0x17,
+    SH2_TAP_DETECTOR = 0x10,
+    SH2_STEP_DETECTOR = 0x18,
+    SH2_STEP_COUNTER = 0x11,
+    SH2_SIGNIFICANT_MOTION = 0x12,
+    SH2_STABILITY_CLASSIFIER = 0x13,
+    SH2_SHAKE_DETECTOR = 0x19,
+    SH2_FLIP_DETECTOR = 0x1a,
+    SH2_PICKUP_DETECTOR = 0x1b,
+    SH2_STABILITY_DETECTOR = 0x1c,
+    SH2_PERSONAL_ACTIVITY_CLASSIFIER = 0x1e,
+    SH2_SLEEP_DETECTOR = 0x1f,
+    SH2_TILT_DETECTOR = 0x20,
+    SH2_POCKET_DETECTOR = 0x21,
+    SH2_CIRCLE_DETECTOR = 0x22,
+    SH2_HEART_RATE_MONITOR = 0x23,
+    SH2_ARVR_STABILIZED_RV = 0x28,
+    SH2_ARVR_STABILIZED_GRV = 0x29,
+    SH2_GYRO_INTEGRATED_RV = 0x2A,
+    SH2_IZRO_MOTION_REQUEST = 0x2B,
+    SH2_RAW_OPTICAL_FLOW = 0x2C,
+    SH2_DEAD_RECKONING_POSE = 0x2D,
+    SH2_WHEEL_ENCODER = 0x2E,
+
+    // UPDATE to reflect greatest sensor id
+    SH2_MAX_SENSOR_ID = 0x2E,
+};
+typedef uint8_t sh2_SensorId_t;
+
+typedef struct sh2_SensorConfig {
+    bool changeSensitivityEnabled;
+    bool changeSensitivityRelative;
+    bool wakeupEnabled;
+    bool alwaysOnEnabled;
+    bool sniffEnabled;
+    uint16_t changeSensitivity;
+    uint32_t reportInterval_us;
+    uint32_t batchInterval_us;
+    uint32_t sensorSpecific;
+} sh2_SensorConfig_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SH2_H */
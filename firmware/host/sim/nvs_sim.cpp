@@ -0,0 +1,144 @@
+#include "nvs_flash.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct sim_nvs_handle_t {
+        std::string ns;
+        nvs_open_mode_t mode;
+    };
+
+    std::mutex nvs_lock;
+    bool initialized = false;
+    std::map<std::string, std::vector<uint8_t>> entries;   // "namespace/key" -> value bytes
+    std::map<nvs_handle_t, sim_nvs_handle_t> handles;
+    nvs_handle_t next_handle = 1;
+
+    esp_err_t entry_key(nvs_handle_t handle, const char* key, bool write, std::string& out)
+    {
+        auto it = handles.find(handle);
+        if (it == handles.end())
+            return ESP_ERR_NVS_INVALID_HANDLE;
+        if (key == nullptr)
+            return ESP_ERR_INVALID_ARG;
+        if (write && it->second.mode == NVS_READONLY)
+            return ESP_ERR_NVS_READ_ONLY;
+
+        out = it->second.ns + "/" + key;
+        return ESP_OK;
+    }
+
+    esp_err_t set_bytes(nvs_handle_t handle, const char* key, const void* value, size_t length)
+    {
+        std::lock_guard<std::mutex> guard(nvs_lock);
+        std::string name;
+        esp_err_t err = entry_key(handle, key, true, name);
+        if (err != ESP_OK)
+            return err;
+
+        const uint8_t* bytes = static_cast<const uint8_t*>(value);
+        entries[name].assign(bytes, bytes + length);
+        return ESP_OK;
+    }
+} // namespace
+
+extern "C" esp_err_t nvs_flash_init(void)
+{
+    std::lock_guard<std::mutex> guard(nvs_lock);
+    initialized = true;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t nvs_flash_erase(void)
+{
+    std::lock_guard<std::mutex> guard(nvs_lock);
+    entries.clear();
+    return ESP_OK;
+}
+
+extern "C" esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle)
+{
+    std::lock_guard<std::mutex> guard(nvs_lock);
+    if (!initialized)
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    if (name == nullptr || out_handle == nullptr)
+        return ESP_ERR_INVALID_ARG;
+
+    *out_handle = next_handle++;
+    handles[*out_handle] = {name, open_mode};
+    return ESP_OK;
+}
+
+extern "C" void nvs_close(nvs_handle_t handle)
+{
+    std::lock_guard<std::mutex> guard(nvs_lock);
+    handles.erase(handle);
+}
+
+extern "C" esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    std::lock_guard<std::mutex> guard(nvs_lock);
+    return (handles.count(handle) != 0) ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
+
+extern "C" esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* out_value)
+{
+    size_t length = sizeof(uint32_t);
+    return nvs_get_blob(handle, key, out_value, &length);
+}
+
+extern "C" esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value)
+{
+    return set_bytes(handle, key, &value, sizeof(value));
+}
+
+extern "C" esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length)
+{
+    std::lock_guard<std::mutex> guard(nvs_lock);
+    std::string name;
+    esp_err_t err = entry_key(handle, key, false, name);
+    if (err != ESP_OK)
+        return err;
+    if (length == nullptr)
+        return ESP_ERR_INVALID_ARG;
+
+    auto it = entries.find(name);
+    if (it == entries.end())
+        return ESP_ERR_NVS_NOT_FOUND;
+
+    // a null buffer asks for the stored length, like the IDF API
+    if (out_value == nullptr)
+    {
+        *length = it->second.size();
+        return ESP_OK;
+    }
+    if (*length < it->second.size())
+        return ESP_ERR_NVS_INVALID_LENGTH;
+
+    std::memcpy(out_value, it->second.data(), it->second.size());
+    *length = it->second.size();
+    return ESP_OK;
+}
+
+extern "C" esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length)
+{
+    if (value == nullptr && length != 0)
+        return ESP_ERR_INVALID_ARG;
+    return set_bytes(handle, key, value, length);
+}
+
+extern "C" esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key)
+{
+    std::lock_guard<std::mutex> guard(nvs_lock);
+    std::string name;
+    esp_err_t err = entry_key(handle, key, true, name);
+    if (err != ESP_OK)
+        return err;
+
+    return (entries.erase(name) != 0) ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
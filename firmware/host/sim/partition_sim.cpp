@@ -0,0 +1,215 @@
+#include "esp_partition_sim.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct sim_partition_t {
+        esp_partition_t part{};
+        std::vector<uint8_t> flash;
+        std::string path;
+        std::FILE* file = nullptr;
+        size_t tear_keep = 0;
+        bool tear_armed = false;
+        esp_partition_sim_stats_t stats;
+    };
+
+    std::mutex partition_lock;
+    std::list<sim_partition_t> partitions;   // list: esp_partition_t pointers stay valid
+
+    sim_partition_t* find(const esp_partition_t* partition)
+    {
+        for (sim_partition_t& p : partitions)
+            if (&p.part == partition)
+                return &p;
+        return nullptr;
+    }
+
+    void write_through(sim_partition_t& p, size_t offset, size_t size)
+    {
+        if (p.file == nullptr)
+            return;
+        std::fseek(p.file, static_cast<long>(offset), SEEK_SET);
+        std::fwrite(p.flash.data() + offset, 1, size, p.file);
+        std::fflush(p.file);
+    }
+
+    bool in_range(const sim_partition_t& p, size_t offset, size_t size)
+    {
+        return offset <= p.part.size && size <= p.part.size - offset;
+    }
+} // namespace
+
+extern "C" const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+        const char* label)
+{
+    std::lock_guard<std::mutex> guard(partition_lock);
+    for (sim_partition_t& p : partitions)
+    {
+        if (type != ESP_PARTITION_TYPE_ANY && p.part.type != type)
+            continue;
+        if (subtype != ESP_PARTITION_SUBTYPE_ANY && p.part.subtype != subtype)
+            continue;
+        if (label != nullptr && std::strncmp(p.part.label, label, sizeof(p.part.label)) != 0)
+            continue;
+        return &p.part;
+    }
+    return nullptr;
+}
+
+extern "C" esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size)
+{
+    std::lock_guard<std::mutex> guard(partition_lock);
+    sim_partition_t* p = find(partition);
+    if (p == nullptr || dst == nullptr)
+        return ESP_ERR_INVALID_ARG;
+    if (!in_range(*p, src_offset, size))
+        return ESP_ERR_INVALID_SIZE;
+
+    std::memcpy(dst, p->flash.data() + src_offset, size);
+    p->stats.reads++;
+    p->stats.bytes_read += size;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size)
+{
+    std::lock_guard<std::mutex> guard(partition_lock);
+    sim_partition_t* p = find(partition);
+    if (p == nullptr || src == nullptr)
+        return ESP_ERR_INVALID_ARG;
+    if (!in_range(*p, dst_offset, size))
+        return ESP_ERR_INVALID_SIZE;
+
+    size_t programmed = size;
+    if (p->tear_armed && size > p->tear_keep)
+    {
+        programmed = std::min(size, p->tear_keep);
+        p->tear_armed = false;
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < programmed; i++)
+        p->flash[dst_offset + i] &= bytes[i];
+    write_through(*p, dst_offset, programmed);
+
+    p->stats.writes++;
+    p->stats.bytes_written += size;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size)
+{
+    std::lock_guard<std::mutex> guard(partition_lock);
+    sim_partition_t* p = find(partition);
+    if (p == nullptr)
+        return ESP_ERR_INVALID_ARG;
+    if (!in_range(*p, offset, size) || offset % esp_partition_sim::SECTOR_SIZE != 0 ||
+            size % esp_partition_sim::SECTOR_SIZE != 0)
+        return ESP_ERR_INVALID_SIZE;
+
+    std::memset(p->flash.data() + offset, 0xFF, size);
+    write_through(*p, offset, size);
+    p->stats.sector_erases += static_cast<uint32_t>(size / esp_partition_sim::SECTOR_SIZE);
+    return ESP_OK;
+}
+
+namespace esp_partition_sim
+{
+    const esp_partition_t* add(const char* label, uint32_t size, const char* path)
+    {
+        if (label == nullptr || size == 0 || size % SECTOR_SIZE != 0)
+            return nullptr;
+
+        std::lock_guard<std::mutex> guard(partition_lock);
+        for (auto it = partitions.begin(); it != partitions.end(); ++it)
+        {
+            if (std::strncmp(it->part.label, label, sizeof(it->part.label)) == 0)
+            {
+                if (it->file != nullptr)
+                    std::fclose(it->file);
+                partitions.erase(it);
+                break;
+            }
+        }
+
+        sim_partition_t& p = partitions.emplace_back();
+        p.part.type = ESP_PARTITION_TYPE_DATA;
+        p.part.subtype = static_cast<esp_partition_subtype_t>(0x40);
+        p.part.size = size;
+        p.part.erase_size = SECTOR_SIZE;
+        std::strncpy(p.part.label, label, sizeof(p.part.label) - 1);
+        p.flash.assign(size, 0xFF);
+
+        if (path != nullptr)
+        {
+            p.path = path;
+            std::FILE* existing = std::fopen(path, "rb");
+            bool loaded = false;
+            if (existing != nullptr)
+            {
+                loaded = std::fread(p.flash.data(), 1, size, existing) == size && std::fgetc(existing) == EOF;
+                std::fclose(existing);
+            }
+            if (!loaded)
+                std::fill(p.flash.begin(), p.flash.end(), 0xFF);
+
+            p.file = std::fopen(path, loaded ? "r+b" : "w+b");
+            if (p.file == nullptr)
+            {
+                partitions.pop_back();
+                return nullptr;
+            }
+            if (!loaded)
+                write_through(p, 0, size);
+        }
+        return &p.part;
+    }
+
+    void remove_all()
+    {
+        std::lock_guard<std::mutex> guard(partition_lock);
+        for (sim_partition_t& p : partitions)
+            if (p.file != nullptr)
+                std::fclose(p.file);
+        partitions.clear();
+    }
+
+    void tear_next_write(const esp_partition_t* partition, size_t keep_bytes)
+    {
+        std::lock_guard<std::mutex> guard(partition_lock);
+        sim_partition_t* p = find(partition);
+        if (p == nullptr)
+            return;
+        p->tear_armed = true;
+        p->tear_keep = keep_bytes;
+    }
+
+    const uint8_t* data(const esp_partition_t* partition)
+    {
+        std::lock_guard<std::mutex> guard(partition_lock);
+        sim_partition_t* p = find(partition);
+        return (p != nullptr) ? p->flash.data() : nullptr;
+    }
+
+    esp_partition_sim_stats_t stats(const esp_partition_t* partition)
+    {
+        std::lock_guard<std::mutex> guard(partition_lock);
+        sim_partition_t* p = find(partition);
+        return (p != nullptr) ? p->stats : esp_partition_sim_stats_t{};
+    }
+
+    void reset_stats(const esp_partition_t* partition)
+    {
+        std::lock_guard<std::mutex> guard(partition_lock);
+        sim_partition_t* p = find(partition);
+        if (p != nullptr)
+            p->stats = esp_partition_sim_stats_t{};
+    }
+} // namespace esp_partition_sim
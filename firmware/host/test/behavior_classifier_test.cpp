@@ -0,0 +1,357 @@
+/**
+ * behavior_classifier host test: the firmware's int8 kernels against a plain
+ * reference written from the quantization spec (nested index loops, 64 bit
+ * requantization), bit for bit. Covers requantization edge cases, random
+ * conv1d / dense layers, and the compiled in model layer by layer on feature
+ * vectors from recorded sessions (a --csv recording, or every simulated
+ * behavior), through both behavior_model_run() and the streaming classifier.
+ *
+ * usage: behavior_classifier_test [--csv recording.csv]
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "behavior_classifier.hpp"
+#include "bno08x_sim.hpp"
+#include "test_check.hpp"
+
+namespace {
+    struct rng_t {
+        uint32_t state;
+
+        uint32_t next() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        int32_t range(int32_t lo, int32_t hi) { return lo + static_cast<int32_t>(next() % uint32_t(hi - lo + 1)); }
+    };
+
+    // ======================================================================
+    // REFERENCE
+    // ======================================================================
+
+    /// @brief round(a * b / 2^31), halves towards +inf, 2^31 saturated (gemmlowp SaturatingRoundingDoublingHighMul)
+    int64_t ref_high_mul(int64_t a, int64_t b) {
+        const int64_t p = a * b;
+        if (p == (int64_t(1) << 62)) {
+            return INT32_MAX;
+        }
+        return (p + (int64_t(1) << 30)) >> 31;   // arithmetic shift: floor division
+    }
+
+    /// @brief round(x / 2^e), halves away from zero (gemmlowp RoundingDivideByPOT)
+    int64_t ref_divide_pot(int64_t x, int e) {
+        if (e == 0) {
+            return x;
+        }
+        const int64_t mag = x >= 0 ? x : -x;
+        const int64_t q = (mag + (int64_t(1) << (e - 1))) >> e;
+        return x >= 0 ? q : -q;
+    }
+
+    int32_t ref_requant(int32_t acc, int32_t mult, int shift) {
+        // the left shift wraps in 32 bits on the target, as it does there
+        const int32_t shifted = shift > 0 ? int32_t(uint32_t(acc) << shift) : acc;
+        return static_cast<int32_t>(ref_divide_pot(ref_high_mul(shifted, mult), shift > 0 ? 0 : -shift));
+    }
+
+    void ref_layer(const behavior_layer_t& l, const int8_t* in, int8_t* out) {
+        const size_t out_len = behavior_layer_out_len(l);
+        for (size_t t = 0; t < out_len; t++) {
+            for (size_t c = 0; c < l.out_ch; c++) {
+                int64_t acc = l.bias[c];
+                if (l.type == BEHAVIOR_LAYER_DENSE) {
+                    for (size_t j = 0; j < size_t(l.in_len) * l.in_ch; j++) {
+                        acc += (int64_t(in[j]) - l.in_zp) * l.weights[c * l.in_len * l.in_ch + j];
+                    }
+                } else {
+                    for (size_t k = 0; k < l.kernel; k++) {
+                        for (size_t i = 0; i < l.in_ch; i++) {
+                            acc += (int64_t(in[(t + k) * l.in_ch + i]) - l.in_zp) *
+                                   l.weights[(c * l.kernel + k) * l.in_ch + i];
+                        }
+                    }
+                }
+                int64_t q = l.out_zp + int64_t(ref_requant(int32_t(acc), l.mult[c], l.shift[c]));
+                q = q < l.act_min ? l.act_min : (q > 127 ? 127 : q);
+                out[t * l.out_ch + c] = static_cast<int8_t>(q);
+            }
+        }
+    }
+
+    void ref_quantize(const behavior_model_t& m, const behavior_features_t& f, int8_t* q) {
+        for (size_t i = 0; i < BEHAVIOR_F_COUNT; i++) {
+            float x = f.v[i];
+            if (m.in_sqrt & (1U << i)) {
+                x = x > 0.0f ? std::sqrt(x) : 0.0f;
+            }
+            float s = x * m.in_gain[i];
+            s = s < -256.0f ? -256.0f : (s > 256.0f ? 256.0f : s);
+            long v = static_cast<long>(std::nearbyint(s)) + m.in_zp;
+            q[i] = static_cast<int8_t>(v < -128 ? -128 : (v > 127 ? 127 : v));
+        }
+    }
+
+    // ======================================================================
+    // CASES
+    // ======================================================================
+
+    /// @brief One dense tap with weight 1 and no zero points: the output is the requantized bias
+    void test_requant(rng_t& rng) {
+        int8_t w = 1, in = 0, out = 0;
+        int32_t bias = 0, mult = 0;
+        int8_t shift = 0;
+        behavior_layer_t l = {BEHAVIOR_LAYER_DENSE, 0, 1, 1, 1, 0, 0, -128, &w, &bias, &mult, &shift};
+
+        const int32_t edge_acc[] = {0, 1, -1, 2, -2, 3, -3, 127, -128, 1 << 20, -(1 << 20), INT32_MAX, INT32_MIN};
+        const int32_t edge_mult[] = {0, 1, INT32_MAX, INT32_MIN, 1 << 30, (1 << 30) + 1, -(1 << 30), 1518500250};
+        const int edge_shift[] = {0, 1, -1, -2, -7, -15, -31};
+        for (int32_t a : edge_acc) {
+            for (int32_t m : edge_mult) {
+                for (int s : edge_shift) {
+                    bias = a;
+                    mult = m;
+                    shift = static_cast<int8_t>(s);
+                    int8_t expected;
+                    ref_layer(l, &in, &expected);
+                    behavior_layer_run(l, &in, &out);
+                    CHECK(out == expected);
+                }
+            }
+        }
+
+        // ties: an accumulator and multiplier landing exactly on a half step
+        for (int s = 1; s <= 8; s++) {
+            for (int32_t a = -600; a <= 600; a++) {
+                bias = a;
+                mult = 1 << 30;   // 0.5
+                shift = static_cast<int8_t>(-s);
+                int8_t expected;
+                ref_layer(l, &in, &expected);
+                behavior_layer_run(l, &in, &out);
+                CHECK(out == expected);
+            }
+        }
+
+        size_t mismatches = 0;
+        for (int i = 0; i < 200000; i++) {
+            bias = static_cast<int32_t>(rng.next());
+            mult = static_cast<int32_t>((rng.next() >> 1) | (1U << 30));
+            shift = static_cast<int8_t>(rng.range(-31, 2));
+            l.out_zp = rng.range(-128, 127);
+            int8_t expected;
+            ref_layer(l, &in, &expected);
+            behavior_layer_run(l, &in, &out);
+            mismatches += out != expected;
+        }
+        CHECK(mismatches == 0);
+    }
+
+    /// @brief Random shapes, weights, zero points and multipliers, conv1d and dense
+    void test_random_layers(rng_t& rng) {
+        size_t mismatches = 0;
+        for (int trial = 0; trial < 2000; trial++) {
+            const bool dense = trial % 2 == 1;
+            const size_t in_len = static_cast<size_t>(rng.range(1, 12));
+            const size_t in_ch = static_cast<size_t>(rng.range(1, 24));
+            const size_t out_ch = static_cast<size_t>(rng.range(1, 24));
+            const size_t kernel = dense ? 0 : static_cast<size_t>(rng.range(1, static_cast<int32_t>(in_len)));
+            const size_t n = dense ? in_len * in_ch : kernel * in_ch;
+
+            std::vector<int8_t> w(out_ch * n), in(in_len * in_ch);
+            std::vector<int32_t> bias(out_ch), mult(out_ch);
+            std::vector<int8_t> shift(out_ch);
+            for (int8_t& v : w) {
+                v = static_cast<int8_t>(rng.range(-127, 127));
+            }
+            for (int8_t& v : in) {
+                v = static_cast<int8_t>(rng.range(-128, 127));
+            }
+            for (size_t c = 0; c < out_ch; c++) {
+                bias[c] = rng.range(-40000, 40000);
+                mult[c] = static_cast<int32_t>((rng.next() >> 1) | (1U << 30));
+                shift[c] = static_cast<int8_t>(rng.range(-14, 0));
+            }
+            const int32_t out_zp = rng.range(-128, 127);
+            const behavior_layer_t l = {dense ? BEHAVIOR_LAYER_DENSE : BEHAVIOR_LAYER_CONV1D,
+                                        static_cast<uint8_t>(kernel),
+                                        static_cast<uint16_t>(in_len),
+                                        static_cast<uint16_t>(in_ch),
+                                        static_cast<uint16_t>(out_ch),
+                                        rng.range(-128, 127),
+                                        out_zp,
+                                        trial % 3 == 0 ? out_zp : -128,
+                                        w.data(),
+                                        bias.data(),
+                                        mult.data(),
+                                        shift.data()};
+
+            const size_t out_size = behavior_layer_out_len(l) * out_ch;
+            std::vector<int8_t> expected(out_size), out(out_size);
+            ref_layer(l, in.data(), expected.data());
+            behavior_layer_run(l, in.data(), out.data());
+            mismatches += std::memcmp(expected.data(), out.data(), out_size) != 0;
+        }
+        CHECK(mismatches == 0);
+    }
+
+    bool to_imu_sample(const bno08x_sim_sample_t& in, imu_sample_t& out) {
+        out = {};
+        out.timestamp_us = in.t_us;
+        out.report_id = in.report_id;
+        out.accuracy = in.accuracy;
+        switch (imu_sample_kind(in.report_id)) {
+            case IMU_SAMPLE_VEC:
+                out.data.vec = {in.v[0], in.v[1], in.v[2]};
+                return true;
+            case IMU_SAMPLE_QUAT:
+                out.data.quat = {in.v[0], in.v[1], in.v[2], in.v[3]};
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    std::vector<behavior_features_t> features_of(const std::vector<bno08x_sim_sample_t>& stream) {
+        static behavior_feature_engine engine;
+        engine.configure(behavior_features_config_t{});
+        std::vector<behavior_features_t> vectors;
+        for (const bno08x_sim_sample_t& s : stream) {
+            imu_sample_t sample;
+            behavior_features_t v;
+            if (to_imu_sample(s, sample) && engine.push(sample, v)) {
+                vectors.push_back(v);
+            }
+        }
+        return vectors;
+    }
+
+    /**
+     * @brief The compiled in model on a session: every layer of every window against the reference, the
+     *        logits of behavior_model_run() and of the streaming classifier against the reference's
+     * @return windows classified as label, or of any class when label is BEHAVIOR_CLASS_COUNT
+     */
+    size_t check_session(const std::vector<behavior_features_t>& vectors, behavior_class_t label, size_t& windows) {
+        const behavior_model_t& m = behavior_default_model();
+        const size_t in_size = size_t(m.in_len) * BEHAVIOR_F_COUNT;
+        behavior_classifier classifier;
+        CHECK(classifier.configure());
+
+        std::vector<int8_t> quantized(vectors.size() * BEHAVIOR_F_COUNT);
+        size_t input_mismatches = 0, layer_mismatches = 0, logit_mismatches = 0, correct = 0;
+        for (size_t v = 0; v < vectors.size(); v++) {
+            int8_t q[BEHAVIOR_F_COUNT];
+            behavior_quantize_input(m, vectors[v], q);
+            ref_quantize(m, vectors[v], &quantized[v * BEHAVIOR_F_COUNT]);
+            input_mismatches += std::memcmp(q, &quantized[v * BEHAVIOR_F_COUNT], BEHAVIOR_F_COUNT) != 0;
+
+            behavior_result_t result;
+            const bool classified = classifier.push(vectors[v], result);
+            CHECK(classified == (v + 1 >= m.in_len));
+            if (!classified) {
+                continue;
+            }
+
+            // layer by layer, the firmware kernel fed the reference's input each time
+            const int8_t* input = &quantized[(v + 1 - m.in_len) * BEHAVIOR_F_COUNT];
+            std::vector<int8_t> ref_in(input, input + in_size);
+            for (size_t i = 0; i < m.n_layers; i++) {
+                const behavior_layer_t& l = m.layers[i];
+                const size_t out_size = behavior_layer_out_len(l) * l.out_ch;
+                std::vector<int8_t> ref_out(out_size), out(out_size);
+                ref_layer(l, ref_in.data(), ref_out.data());
+                behavior_layer_run(l, ref_in.data(), out.data());
+                layer_mismatches += std::memcmp(ref_out.data(), out.data(), out_size) != 0;
+                ref_in.swap(ref_out);
+            }
+
+            int8_t logits[BEHAVIOR_CLASS_COUNT];
+            CHECK(behavior_model_run(m, input, logits));
+            logit_mismatches += std::memcmp(logits, ref_in.data(), BEHAVIOR_CLASS_COUNT) != 0;
+            logit_mismatches += std::memcmp(result.logits, ref_in.data(), BEHAVIOR_CLASS_COUNT) != 0;
+            CHECK(result.t_us == vectors[v].t_us);
+
+            size_t best = 0;
+            for (size_t c = 1; c < BEHAVIOR_CLASS_COUNT; c++) {
+                best = ref_in[c] > ref_in[best] ? c : best;
+            }
+            CHECK(result.cls == best);
+            correct += label == BEHAVIOR_CLASS_COUNT || result.cls == label;
+            windows++;
+        }
+        CHECK(input_mismatches == 0);
+        CHECK(layer_mismatches == 0);
+        CHECK(logit_mismatches == 0);
+        return correct;
+    }
+
+    void test_model_on_sessions() {
+        const uint8_t rpts[] = {SH2_ACCELEROMETER, SH2_GYROSCOPE_CALIBRATED, SH2_ROTATION_VECTOR};
+        const bno08x_sim_profile_t profiles[BEHAVIOR_CLASS_COUNT] = {
+            bno08x_sim_profile_t::SLEEP,   bno08x_sim_profile_t::WALK, bno08x_sim_profile_t::RUN,
+            bno08x_sim_profile_t::SCRATCH, bno08x_sim_profile_t::EAT,  bno08x_sim_profile_t::SHAKE,
+        };
+        for (size_t c = 0; c < BEHAVIOR_CLASS_COUNT; c++) {
+            std::vector<bno08x_sim_sample_t> stream;
+            bno08x_sim::generate(profiles[c], rpts, sizeof(rpts), 10000UL, 30000000UL, stream, 77U + c);
+            size_t windows = 0;
+            const size_t correct = check_session(features_of(stream), behavior_class_t(c), windows);
+            CHECK(windows > 0);
+            // a regression guard on the shipped weights, not a measure of accuracy on real pets
+            CHECK(correct * 10 >= windows * 9);
+            std::printf("%-10s %5zu windows, %5.1f%% classified as such\n",
+                    behavior_class_to_str(behavior_class_t(c)), windows, 100.0 * correct / windows);
+        }
+    }
+
+    void test_arena_limits() {
+        behavior_model_t m = behavior_default_model();
+        int8_t input[BEHAVIOR_MAX_IN_LEN * BEHAVIOR_F_COUNT] = {};
+        int8_t logits[BEHAVIOR_CLASS_COUNT];
+        CHECK(behavior_model_run(m, input, logits));
+
+        m.n_layers--;   // ends before the logits
+        CHECK(!behavior_model_run(m, input, logits));
+
+        m = behavior_default_model();
+        m.in_len++;     // no longer chains into the first layer
+        CHECK(!behavior_model_run(m, input, logits));
+
+        behavior_classifier classifier;
+        CHECK(!classifier.configure(&m));
+        behavior_result_t result;
+        CHECK(!classifier.push(behavior_features_t{}, result));
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* csv = nullptr;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], "--csv") == 0) {
+            csv = argv[i + 1];
+        }
+    }
+
+    rng_t rng{0x2545F491U};
+    test_requant(rng);
+    test_random_layers(rng);
+    test_arena_limits();
+    if (csv != nullptr) {
+        std::vector<bno08x_sim_sample_t> stream;
+        CHECK(bno08x_sim::load_csv(csv, stream));
+        size_t windows = 0;
+        check_session(features_of(stream), BEHAVIOR_CLASS_COUNT, windows);
+        std::printf("%s: %zu windows bit exact\n", csv, windows);
+    } else {
+        test_model_on_sessions();
+    }
+
+    return test::result("behavior_classifier_test");
+}
@@ -0,0 +1,246 @@
+/**
+ * behavior_features host test: the first vector comes once BEHAVIOR_WINDOW
+ * accel samples are in, then one every hop, stamped with the window's last
+ * accel sample. On synthetic motion with known answers (a sine along gravity,
+ * a constant turn) every feature lands on its analytic value: energy,
+ * variance, dominant frequency and its share, zero crossing rate, jerk, gyro
+ * energy and the rotation across the window. A still sensor gives zeros, the
+ * batch push matches the one sample push, reset() restarts the window, and
+ * reports left out of the configuration leave their features at 0.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "behavior_features.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr float PI = 3.14159265358979f;
+    constexpr float FS_HZ = 100.0f;
+    constexpr uint32_t PERIOD_US = 10000UL;
+    constexpr float GRAVITY = 9.81f;
+
+    /**
+     * @brief Motion to synthesize: a bounce of amp_ms2 at freq_hz along gravity
+     *        and a turn about gravity at turn_rad_s
+     */
+    struct motion_t {
+        float amp_ms2 = 0.0f;
+        float freq_hz = 0.0f;
+        float turn_rad_s = 0.0f;
+    };
+
+    /// @brief Accel, gyro and rotation vector samples of tick i, in drain order
+    void tick(const motion_t &m, uint32_t i, imu_sample_t out[3]) {
+        const float t = static_cast<float>(i) / FS_HZ;
+        const uint32_t t_us = i * PERIOD_US;
+
+        out[0] = {};
+        out[0].report_id = SH2_ACCELEROMETER;
+        out[0].timestamp_us = t_us;
+        out[0].data.vec = {0.0f, 0.0f, GRAVITY + m.amp_ms2 * std::sin(2.0f * PI * m.freq_hz * t)};
+
+        out[1] = {};
+        out[1].report_id = SH2_GYROSCOPE_CALIBRATED;
+        out[1].timestamp_us = t_us;
+        out[1].data.vec = {0.0f, 0.0f, m.turn_rad_s};
+
+        out[2] = {};
+        out[2].report_id = SH2_ROTATION_VECTOR;
+        out[2].timestamp_us = t_us;
+        const float yaw = m.turn_rad_s * t;
+        out[2].data.quat = {std::cos(yaw / 2.0f), 0.0f, 0.0f, std::sin(yaw / 2.0f)};
+    }
+
+    /// @brief Run ticks [from, to) through the engine, collect the vectors
+    std::vector<behavior_features_t> run(behavior_feature_engine &engine, const motion_t &m, uint32_t from, uint32_t to) {
+        std::vector<behavior_features_t> out;
+        for (uint32_t i = from; i < to; i++) {
+            imu_sample_t samples[3];
+            tick(m, i, samples);
+            for (const imu_sample_t &s : samples) {
+                behavior_features_t f;
+                if (engine.push(s, f)) {
+                    out.push_back(f);
+                }
+            }
+        }
+        return out;
+    }
+
+    bool near(float value, float expected, float rel) {
+        return std::fabs(value - expected) <= rel * std::fabs(expected);
+    }
+
+    void test_configure() {
+        behavior_feature_engine engine;
+        behavior_features_config_t config;
+        CHECK(engine.configure(config));
+        config.hop = 4;
+        CHECK(!engine.configure(config));
+        config.hop = 48;
+        CHECK(!engine.configure(config));
+        config.hop = BEHAVIOR_WINDOW;
+        CHECK(engine.configure(config));
+        config.hop = 32;
+        config.fs_hz = 0.0f;
+        CHECK(!engine.configure(config));
+        config.fs_hz = FS_HZ;
+        config.gravity_fc_hz = 60.0f;
+        CHECK(!engine.configure(config));
+        CHECK(std::string(behavior_feature_to_str(BEHAVIOR_F_ACC_DOM_HZ)) == "acc_dom_hz");
+        CHECK(std::string(behavior_feature_to_str(BEHAVIOR_F_COUNT)) == "UNKNOWN");
+    }
+
+    void test_cadence() {
+        static behavior_feature_engine engine;
+        behavior_features_config_t config;
+        CHECK(engine.configure(config));
+        const motion_t still;
+
+        // nothing until the window has filled, then one vector per hop
+        CHECK(run(engine, still, 0, BEHAVIOR_WINDOW - 1).empty());
+        std::vector<behavior_features_t> v = run(engine, still, BEHAVIOR_WINDOW - 1, BEHAVIOR_WINDOW);
+        CHECK(v.size() == 1);
+        CHECK(!v.empty() && v[0].t_us == (BEHAVIOR_WINDOW - 1) * PERIOD_US);
+        v = run(engine, still, BEHAVIOR_WINDOW, BEHAVIOR_WINDOW + 10 * config.hop);
+        CHECK(v.size() == 10);
+        CHECK(engine.vectors() == 11);
+        CHECK(v.size() == 10 && v[9].t_us - v[8].t_us == config.hop * PERIOD_US);
+
+        // still: nothing moves, the spectrum is empty
+        bool zero = true;
+        for (float f : v.back().v) {
+            zero &= std::fabs(f) < 1e-4f;
+        }
+        CHECK(zero);
+
+        // a reset waits for a whole window again
+        engine.reset();
+        CHECK(engine.vectors() == 0);
+        CHECK(run(engine, still, 0, BEHAVIOR_WINDOW - 1).empty());
+        CHECK(run(engine, still, BEHAVIOR_WINDOW - 1, BEHAVIOR_WINDOW).size() == 1);
+    }
+
+    void test_bounce_and_turn() {
+        static behavior_feature_engine engine;
+        behavior_features_config_t config;
+        CHECK(engine.configure(config));
+
+        // a 2 m/s^2 bounce along gravity, three whole cycles per window (2.34 Hz), turning at 1 rad/s
+        motion_t m;
+        m.amp_ms2 = 2.0f;
+        m.freq_hz = 3.0f * FS_HZ / BEHAVIOR_WINDOW;
+        m.turn_rad_s = 1.0f;
+        const std::vector<behavior_features_t> v = run(engine, m, 0, 2000);
+        CHECK(!v.empty());
+        if (v.empty()) {
+            return;
+        }
+        const behavior_features_t &f = v.back();
+        std::printf("bounce: dom %.2f Hz share %.2f, zcr %.2f Hz, jerk %.1f, orient %.3f rad\n",
+                    f.v[BEHAVIOR_F_ACC_DOM_HZ], f.v[BEHAVIOR_F_ACC_DOM_SHARE], f.v[BEHAVIOR_F_ACC_ZCR_HZ],
+                    f.v[BEHAVIOR_F_ACC_JERK], f.v[BEHAVIOR_F_ORIENT_CHANGE]);
+
+        // a sine of amplitude A: power and variance A^2 / 2, the energy through the gravity high pass (~0.98)
+        const float power = m.amp_ms2 * m.amp_ms2 / 2.0f;
+        CHECK(near(f.v[BEHAVIOR_F_ACC_ENERGY], power, 0.05f));
+        CHECK(near(f.v[BEHAVIOR_F_ACC_VAR_Z], power, 0.05f));
+        CHECK(f.v[BEHAVIOR_F_ACC_VAR_X] < 1e-6f && f.v[BEHAVIOR_F_ACC_VAR_Y] < 1e-6f);
+
+        // exactly on a bin
+        CHECK(std::fabs(f.v[BEHAVIOR_F_ACC_DOM_HZ] - m.freq_hz) < 0.05f);
+        CHECK(f.v[BEHAVIOR_F_ACC_DOM_SHARE] > 0.8f && f.v[BEHAVIOR_F_ACC_DOM_SHARE] <= 1.0f);
+
+        // two crossings per cycle on one axis of three
+        CHECK(near(f.v[BEHAVIOR_F_ACC_ZCR_HZ], 2.0f * m.freq_hz / 3.0f, 0.15f));
+
+        // mean |d/dt A sin(wt)| = 2 A w / pi = 4 A f
+        CHECK(near(f.v[BEHAVIOR_F_ACC_JERK], 4.0f * m.amp_ms2 * m.freq_hz, 0.05f));
+
+        // a constant turn: energy w^2, no variance
+        CHECK(near(f.v[BEHAVIOR_F_GYRO_ENERGY], m.turn_rad_s * m.turn_rad_s, 1e-3f));
+        CHECK(f.v[BEHAVIOR_F_GYRO_VAR_Z] < 1e-6f);
+
+        // the rotation vector turns through one window of hops
+        CHECK(near(f.v[BEHAVIOR_F_ORIENT_CHANGE], m.turn_rad_s * BEHAVIOR_WINDOW / FS_HZ, 0.02f));
+    }
+
+    void test_batch_push_and_config() {
+        static behavior_feature_engine one, batch, accel_only;
+        behavior_features_config_t config;
+        CHECK(one.configure(config));
+        CHECK(batch.configure(config));
+        config.gyro_rpt = 0;
+        config.rv_rpt = 0;
+        CHECK(accel_only.configure(config));
+
+        motion_t m;
+        m.amp_ms2 = 1.0f;
+        m.freq_hz = 4.0f;
+        m.turn_rad_s = 0.5f;
+        std::vector<imu_sample_t> drained;
+        for (uint32_t i = 0; i < 600; i++) {
+            imu_sample_t samples[3];
+            tick(m, i, samples);
+            drained.insert(drained.end(), samples, samples + 3);
+            // a report the engine does not follow
+            imu_sample_t other = samples[0];
+            other.report_id = SH2_MAGNETIC_FIELD_CALIBRATED;
+            drained.push_back(other);
+        }
+
+        std::vector<behavior_features_t> expected;
+        for (const imu_sample_t &s : drained) {
+            behavior_features_t f;
+            if (one.push(s, f)) {
+                expected.push_back(f);
+            }
+        }
+
+        // two vectors at a time: the batch push stops when out is full
+        std::vector<behavior_features_t> got;
+        size_t pos = 0;
+        bool stopped_full = true;
+        while (pos < drained.size()) {
+            behavior_features_t out[2];
+            size_t n_out = 0;
+            const size_t used = batch.push(drained.data() + pos, drained.size() - pos, out, 2, n_out);
+            stopped_full &= (pos + used == drained.size()) || n_out == 2;
+            got.insert(got.end(), out, out + n_out);
+            pos += used;
+        }
+        CHECK(stopped_full);
+        CHECK(got.size() == expected.size() && !got.empty());
+        bool same = got.size() == expected.size();
+        for (size_t k = 0; same && k < got.size(); k++) {
+            same &= got[k].t_us == expected[k].t_us;
+            for (size_t j = 0; j < BEHAVIOR_F_COUNT; j++) {
+                same &= got[k].v[j] == expected[k].v[j];
+            }
+        }
+        CHECK(same);
+
+        // without gyro and rotation vector the accel features are unchanged and the rest stay 0
+        behavior_features_t last = {};
+        for (const imu_sample_t &s : drained) {
+            accel_only.push(s, last);
+        }
+        CHECK(accel_only.vectors() == expected.size());
+        CHECK(last.v[BEHAVIOR_F_ACC_JERK] == expected.back().v[BEHAVIOR_F_ACC_JERK]);
+        CHECK(last.v[BEHAVIOR_F_GYRO_ENERGY] == 0.0f && last.v[BEHAVIOR_F_GYRO_VAR_Z] == 0.0f);
+        CHECK(last.v[BEHAVIOR_F_ORIENT_CHANGE] == 0.0f);
+    }
+} // namespace
+
+int main() {
+    test_configure();
+    test_cadence();
+    test_bounce_and_turn();
+    test_batch_push_and_config();
+
+    return test::result("behavior_features_test");
+}
@@ -0,0 +1,268 @@
+/**
+ * binlog host test: a BINLOG_x() call queues its site and raw argument words
+ * without formatting, binlog_render() formats them later like printf, and
+ * the binary sink writes the documented stream: header, then one record per
+ * call with the FNV-1a format ID, level, argument count and the number of
+ * records lost to a full ring just before it. Levels above BINLOG_MAX_LEVEL
+ * are compiled out, and producers on several threads lose nothing while the
+ * ring has room.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "binlog.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr const char *TAG = "BINLOG_TEST";
+
+    std::vector<uint8_t> stream;
+
+    size_t capture(const void *data, size_t len) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        stream.insert(stream.end(), bytes, bytes + len);
+        return len;
+    }
+
+    struct decoded_t {
+        uint32_t timestamp_us;
+        uint32_t fmt_id;
+        uint8_t level;
+        uint8_t nargs;
+        uint16_t dropped_before;
+        uint32_t args[BINLOG_MAX_ARGS];
+    };
+
+    uint32_t word_at(size_t pos) {
+        uint32_t word;
+        std::memcpy(&word, &stream[pos], sizeof(word));
+        return word;
+    }
+
+    /**
+    * @brief Split the captured stream into records
+    * @param records: decoded records, replaced
+    * @param header: the stream starts with the file header, false once it has been written
+    * @return false if the stream does not parse
+    */
+    bool decode(std::vector<decoded_t> &records, bool header = true) {
+        records.clear();
+        size_t pos = 0;
+        if (header) {
+            if (stream.size() < 8 || word_at(0) != BINLOG_MAGIC || word_at(4) != BINLOG_VERSION) {
+                return false;
+            }
+            pos = 8;
+        }
+        while (pos < stream.size()) {
+            if (stream.size() - pos < 12) {
+                return false;
+            }
+            decoded_t r = {};
+            r.timestamp_us = word_at(pos);
+            r.fmt_id = word_at(pos + 4);
+            r.level = stream[pos + 8];
+            r.nargs = stream[pos + 9];
+            std::memcpy(&r.dropped_before, &stream[pos + 10], 2);
+            pos += 12;
+            if (r.nargs > BINLOG_MAX_ARGS || stream.size() - pos < r.nargs * 4U) {
+                return false;
+            }
+            for (uint8_t i = 0; i < r.nargs; i++, pos += 4) {
+                r.args[i] = word_at(pos);
+            }
+            records.push_back(r);
+        }
+        return true;
+    }
+
+    float as_float(uint32_t word) {
+        float value;
+        std::memcpy(&value, &word, sizeof(value));
+        return value;
+    }
+
+    void test_fmt_id() {
+        // FNV-1a reference values
+        static_assert(binlog_fmt_id("", 0) == 2166136261UL);
+        static_assert(binlog_fmt_id("a", 1) == 0xE40C292CUL);
+        static_assert(binlog_fmt_id("foobar", 6) == 0xBF9CF968UL);
+        CHECK(binlog_fmt_id("x=%d", 4) != binlog_fmt_id("x=%u", 4));
+    }
+
+    void test_render() {
+        char out[64];
+        const uint32_t ints[] = {binlog_word(-42), binlog_word(4000000000U), binlog_word(255)};
+        CHECK(binlog_render("a=%d b=%u c=%02x", ints, 3, out, sizeof(out)) == std::strlen("a=-42 b=4000000000 c=ff"));
+        CHECK(std::strcmp(out, "a=-42 b=4000000000 c=ff") == 0);
+
+        // length modifiers are dropped, every argument is one word; doubles travel as float
+        const uint32_t mixed[] = {binlog_word(int32_t{7}), binlog_word(1.25), binlog_word(-0.5f)};
+        binlog_render("%ld %.2f %+.1f 100%%", mixed, 3, out, sizeof(out));
+        CHECK(std::strcmp(out, "7 1.25 -0.5 100%") == 0);
+
+        // strings never reach the ring, missing arguments render as zero
+        binlog_render("%s %d", ints, 0, out, sizeof(out));
+        CHECK(std::strcmp(out, "<s?> 0") == 0);
+
+        // truncated, always terminated
+        CHECK(binlog_render("a=%d b=%u", ints, 2, out, 8) == 7);
+        CHECK(std::strcmp(out, "a=-42 b") == 0);
+        CHECK(binlog_render("abc", nullptr, 0, out, 0) == 0);
+    }
+
+    /// @brief Before binlog_start() the consumer uses the text sink
+    void test_text_sink() {
+        binlog_reset_stats();
+        BINLOG_I(TAG, "text %d", 1);
+        BINLOG_W(TAG, "text %d %d", 2, 3);
+        // above BINLOG_MAX_LEVEL, compiled out
+        BINLOG_D(TAG, "debug %d", 4);
+        BINLOG_V(TAG, "verbose %d", 5);
+
+        binlog_stats_t stats = binlog_get_stats();
+        CHECK(stats.logged == 2);
+        CHECK(stats.emitted == 0);
+        CHECK(binlog_flush() == 2);
+        stats = binlog_get_stats();
+        CHECK(stats.emitted == 2);
+        CHECK(stats.high_water == 2);
+        CHECK(stats.capacity == BINLOG_RING_CAPACITY);
+    }
+
+    void test_binary_stream() {
+        binlog_config_t config;
+        config.sink = BINLOG_SINK_BINARY;
+        CHECK(!binlog_start(config));
+
+        // the task drains once at start and then sleeps, the test is the consumer after that
+        config.write = capture;
+        config.drain_period_ms = 3600000UL;
+        CHECK(binlog_start(config));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        stream.clear();
+        binlog_reset_stats();
+
+        BINLOG_I(TAG, "no args");
+        BINLOG_W(TAG, "x=%d y=%u", -3, 70000U);
+        BINLOG_E(TAG, "f=%.3f e=%d", 0.125f, ESP_LOG_WARN);
+        CHECK(binlog_flush() == 3);
+
+        std::vector<decoded_t> records;
+        CHECK(decode(records));
+        CHECK(records.size() == 3);
+        if (records.size() == 3) {
+            CHECK(records[0].fmt_id == binlog_fmt_id("no args", 7));
+            CHECK(records[0].level == ESP_LOG_INFO && records[0].nargs == 0);
+
+            CHECK(records[1].fmt_id == binlog_fmt_id("x=%d y=%u", 9));
+            CHECK(records[1].level == ESP_LOG_WARN && records[1].nargs == 2);
+            CHECK(static_cast<int32_t>(records[1].args[0]) == -3 && records[1].args[1] == 70000U);
+
+            CHECK(records[2].level == ESP_LOG_ERROR && records[2].nargs == 2);
+            CHECK(as_float(records[2].args[0]) == 0.125f && records[2].args[1] == ESP_LOG_WARN);
+
+            CHECK(records[0].timestamp_us <= records[1].timestamp_us);
+            CHECK(records[1].timestamp_us <= records[2].timestamp_us);
+            CHECK(records[2].dropped_before == 0);
+        }
+
+        // the header is written once per stream
+        size_t before = stream.size();
+        BINLOG_I(TAG, "again %d", 1);
+        CHECK(binlog_flush() == 1);
+        CHECK(stream.size() == before + 12 + 4);
+    }
+
+    void test_overflow() {
+        stream.clear();
+        binlog_reset_stats();
+
+        // a full ring drops the newest call and reports the gap on the next one that gets in
+        constexpr int EXCESS = 5;
+        for (int i = 0; i < BINLOG_RING_CAPACITY + EXCESS; i++) {
+            BINLOG_I(TAG, "fill %d", i);
+        }
+        binlog_stats_t stats = binlog_get_stats();
+        CHECK(stats.logged == BINLOG_RING_CAPACITY);
+        CHECK(stats.dropped == EXCESS);
+
+        CHECK(binlog_flush() == BINLOG_RING_CAPACITY);
+        BINLOG_I(TAG, "after %d", 1);
+        BINLOG_I(TAG, "after %d", 2);
+        CHECK(binlog_flush() == 2);
+
+        std::vector<decoded_t> records;
+        CHECK(decode(records, false));
+        CHECK(records.size() == BINLOG_RING_CAPACITY + 2);
+        if (records.size() == BINLOG_RING_CAPACITY + 2) {
+            bool ordered = true;
+            for (int i = 0; i < BINLOG_RING_CAPACITY; i++) {
+                ordered &= records[i].args[0] == static_cast<uint32_t>(i) && records[i].dropped_before == 0;
+            }
+            CHECK(ordered);
+            CHECK(records[BINLOG_RING_CAPACITY].dropped_before == EXCESS);
+            CHECK(records[BINLOG_RING_CAPACITY + 1].dropped_before == 0);
+        }
+
+        stats = binlog_get_stats();
+        CHECK(stats.emitted == BINLOG_RING_CAPACITY + 2);
+        CHECK(stats.high_water == BINLOG_RING_CAPACITY);
+    }
+
+    /// @brief Several producers, one consumer: nothing lost while the ring has room, each thread in order
+    void test_producers() {
+        constexpr int THREADS = 4;
+        constexpr uint32_t PER_THREAD = BINLOG_RING_CAPACITY / THREADS;
+        stream.clear();
+        binlog_reset_stats();
+
+        std::thread producers[THREADS];
+        for (int t = 0; t < THREADS; t++) {
+            producers[t] = std::thread([t]() {
+                for (uint32_t i = 0; i < PER_THREAD; i++) {
+                    BINLOG_I(TAG, "thread %d seq %u", t, i);
+                }
+            });
+        }
+        for (std::thread &producer : producers) {
+            producer.join();
+        }
+        CHECK(binlog_get_stats().dropped == 0);
+        CHECK(binlog_flush() == THREADS * PER_THREAD);
+
+        std::vector<decoded_t> records;
+        CHECK(decode(records, false));
+        uint32_t next[THREADS] = {};
+        bool ordered = true;
+        for (const decoded_t &r : records) {
+            const uint32_t t = r.args[0];
+            if (t >= THREADS) {
+                ordered = false;
+                continue;
+            }
+            ordered &= r.args[1] == next[t]++;
+        }
+        CHECK(ordered);
+        for (uint32_t n : next) {
+            CHECK(n == PER_THREAD);
+        }
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    test_fmt_id();
+    test_render();
+    test_text_sink();
+    test_binary_stream();
+    test_overflow();
+    test_producers();
+
+    return test::result("binlog_test");
+}
@@ -0,0 +1,254 @@
+/**
+ * event_journal host test: the journal on a file-backed partition, reopened
+ * from the file the way a reboot finds it. Covers "since T" seeks against a
+ * plain scan of what was written, cursor paging, delta coded times across
+ * block and sector boundaries, ring laps, a torn block and the observe() rules.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "esp_partition_sim.hpp"
+#include "esp_timer.h"
+#include "event_journal.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr uint32_t JOURNAL_SIZE = 64U * 1024U;
+
+    std::string temp_path() {
+        char path[] = "/tmp/event_journal_test_XXXXXX";
+        const int fd = mkstemp(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        std::remove(path);
+        return path;
+    }
+
+    /// @brief Simulated reboot: the partition is reloaded from its file and the journal reopened
+    const esp_partition_t* reboot(const std::string& path, uint32_t size = JOURNAL_SIZE) {
+        esp_partition_sim::remove_all();
+        const esp_partition_t* part = esp_partition_sim::add(EVENT_JOURNAL_DEFAULT_LABEL, size, path.c_str());
+        CHECK(part != nullptr);
+        CHECK(event_journal_open());
+        return part;
+    }
+
+    std::vector<journal_event_t> read_all(uint64_t since_ms, size_t page = 64) {
+        std::vector<journal_event_t> events;
+        std::vector<journal_event_t> buf(page);
+        size_t n;
+        while ((n = event_journal_read_since(since_ms, buf.data(), page)) > 0) {
+            events.insert(events.end(), buf.begin(), buf.begin() + n);
+            since_ms = buf[n - 1].t_ms;
+        }
+        return events;
+    }
+
+    bool same(const journal_event_t& a, const journal_event_t& b) {
+        return a.t_ms == b.t_ms && a.type == b.type && a.value == b.value;
+    }
+
+    bool same(const std::vector<journal_event_t>& a, const std::vector<journal_event_t>& b, size_t b_from = 0) {
+        if (a.size() != b.size() - b_from) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); i++) {
+            if (!same(a[i], b[b_from + i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// @brief Events of every type with gaps from 1 ms to minutes, so deltas span one to three varint bytes
+    std::vector<journal_event_t> make_events(size_t count, uint64_t start_ms) {
+        std::vector<journal_event_t> events;
+        uint64_t t = start_ms;
+        uint32_t seed = 12345;
+        for (size_t i = 0; i < count; i++) {
+            seed = seed * 1103515245U + 12345U;
+            const uint32_t r = seed >> 8;
+            t += (r % 8 == 0) ? 60000 + r % 100000 : 1 + r % 3000;
+            const uint8_t type = static_cast<uint8_t>(JOURNAL_EVT_SIG_MOTION + r % 5);
+            const uint32_t value = (type == JOURNAL_EVT_SIG_MOTION) ? 0 : (type == JOURNAL_EVT_STEPS) ? r % 400 : r % 6;
+            events.push_back({t, type, value});
+        }
+        return events;
+    }
+
+    void append_all(const std::vector<journal_event_t>& events) {
+        for (const journal_event_t& ev : events) {
+            CHECK(event_journal_append(ev.type, ev.value, ev.t_ms));
+        }
+    }
+
+    void test_seek_and_reopen(const std::string& path) {
+        reboot(path);
+        CHECK(read_all(0).empty());
+
+        const std::vector<journal_event_t> expected = make_events(3000, 5000);
+        append_all(expected);
+        CHECK(event_journal_sync());
+
+        const event_journal_stats_t stats = event_journal_get_stats();
+        const double bytes_per_event = static_cast<double>(stats.payload_bytes) / stats.events;
+        std::printf("event_journal: %lu events in %lu blocks, %.2f payload bytes/event\n",
+                (unsigned long)stats.events, (unsigned long)stats.blocks_written, bytes_per_event);
+        CHECK(bytes_per_event < 4.5);
+
+        CHECK(same(read_all(0), expected));
+        CHECK(same(read_all(0, 7), expected));
+
+        // cursor at, just before and between events; the seek reads O(log blocks), the scan one or two blocks
+        for (size_t k : {size_t(0), size_t(1), size_t(499), size_t(1500), size_t(2998), size_t(2999)}) {
+            for (uint64_t since : {expected[k].t_ms, expected[k].t_ms - 1}) {
+                journal_event_t page[16];
+                const size_t n = event_journal_read_since(since, page, 16);
+                size_t first = 0;
+                while (first < expected.size() && expected[first].t_ms <= since) {
+                    first++;
+                }
+                CHECK(n == std::min<size_t>(16, expected.size() - first));
+                for (size_t i = 0; i < n; i++) {
+                    CHECK(same(page[i], expected[first + i]));
+                }
+
+                const event_journal_stats_t seek = event_journal_get_stats();
+                CHECK(seek.seek_blocks <= 10);
+                CHECK(seek.scan_blocks <= 3);
+            }
+        }
+        CHECK(event_journal_read_since(expected.back().t_ms, nullptr, 0) == 0);
+
+        // same millisecond: the later event moves 1 ms so the cursor stays exact
+        const uint64_t t = expected.back().t_ms + 10;
+        CHECK(event_journal_append(JOURNAL_EVT_SHAKE, 1, t));
+        CHECK(event_journal_append(JOURNAL_EVT_SHAKE, 2, t));
+        journal_event_t tail[4];
+        CHECK(event_journal_read_since(expected.back().t_ms, tail, 4) == 2);
+        CHECK(tail[0].t_ms == t && tail[1].t_ms == t + 1);
+        CHECK(event_journal_read_since(tail[0].t_ms, tail, 4) == 1 && tail[0].value == 2);
+
+        // staged events are lost on a power cut, synced ones survive and the clock resumes past them
+        std::vector<journal_event_t> after = expected;
+        after.push_back({t, JOURNAL_EVT_SHAKE, 1});
+        after.push_back({t + 1, JOURNAL_EVT_SHAKE, 2});
+        CHECK(event_journal_sync());
+        CHECK(event_journal_append(JOURNAL_EVT_SIG_MOTION, 0, t + 5));
+
+        reboot(path);
+        CHECK(same(read_all(0), after));
+        CHECK(event_journal_now_ms() > after.back().t_ms);
+        CHECK(event_journal_get_stats().torn_blocks == 0);
+    }
+
+    void test_ring_lap(const std::string& path) {
+        // 4 sectors hold ~3 sectors of events, the oldest go as the ring laps
+        reboot(path, 4 * esp_partition_sim::SECTOR_SIZE);
+        const std::vector<journal_event_t> expected = make_events(20000, event_journal_now_ms());
+        append_all(expected);
+        CHECK(event_journal_sync());
+
+        const std::vector<journal_event_t> kept = read_all(0);
+        CHECK(!kept.empty() && kept.size() < expected.size());
+        CHECK(same(kept, expected, expected.size() - kept.size()));
+
+        const size_t mid = expected.size() - kept.size() / 2;
+        CHECK(same(read_all(expected[mid].t_ms), expected, mid + 1));
+        CHECK(event_journal_get_stats().seek_blocks <= 8);
+
+        reboot(path, 4 * esp_partition_sim::SECTOR_SIZE);
+        CHECK(same(read_all(0), kept));
+    }
+
+    void test_torn_block(const std::string& path) {
+        const esp_partition_t* part = reboot(path);
+        const std::vector<journal_event_t> before = make_events(500, event_journal_now_ms());
+        append_all(before);
+        CHECK(event_journal_sync());
+
+        // power lost 100 bytes into the next block: reboot skips it and appends after it
+        esp_partition_sim::tear_next_write(part, 100);
+        append_all(make_events(30, before.back().t_ms));
+        CHECK(event_journal_sync());
+
+        reboot(path);
+        CHECK(event_journal_get_stats().torn_blocks == 1);
+        CHECK(same(read_all(0), before));
+
+        const uint64_t t = event_journal_now_ms();
+        CHECK(event_journal_append(JOURNAL_EVT_SHAKE, 3, t));
+        CHECK(event_journal_sync());
+        reboot(path);
+        std::vector<journal_event_t> expected = before;
+        expected.push_back({t, JOURNAL_EVT_SHAKE, 3});
+        CHECK(same(read_all(0), expected));
+    }
+
+    imu_sample_t value_sample(uint8_t report_id, uint32_t value) {
+        imu_sample_t s = {};
+        s.timestamp_us = static_cast<uint32_t>(esp_timer_get_time());
+        s.report_id = report_id;
+        s.data.value = value;
+        return s;
+    }
+
+    void test_observe(const std::string& path) {
+        reboot(path);
+        CHECK(event_journal_erase());
+
+        // stability: transitions only
+        for (uint32_t v : {1U, 1U, 1U, 3U, 3U, 1U}) {
+            CHECK(event_journal_observe(value_sample(SH2_STABILITY_CLASSIFIER, v)));
+        }
+
+        // activity: a confidence change alone is not a transition
+        imu_sample_t activity = value_sample(SH2_PERSONAL_ACTIVITY_CLASSIFIER, 0);
+        activity.data.activity = {4, 80};
+        CHECK(event_journal_observe(activity));
+        activity.data.activity = {4, 95};
+        CHECK(event_journal_observe(activity));
+
+        // steps: summed, the 16 bit hub counter wraps
+        for (uint32_t steps : {65530U, 65534U, 2U, 10U}) {
+            CHECK(event_journal_observe(value_sample(SH2_STEP_COUNTER, steps)));
+        }
+
+        CHECK(event_journal_observe(value_sample(SH2_SIGNIFICANT_MOTION, 1)));
+        CHECK(event_journal_observe(value_sample(SH2_ACCELEROMETER, 0)));
+        CHECK(event_journal_sync());
+
+        const std::vector<journal_event_t> events = read_all(0);
+        CHECK(events.size() == 6);
+        if (events.size() == 6) {
+            CHECK(events[0].type == JOURNAL_EVT_STABILITY && events[0].value == 1);
+            CHECK(events[1].type == JOURNAL_EVT_STABILITY && events[1].value == 3);
+            CHECK(events[2].type == JOURNAL_EVT_STABILITY && events[2].value == 1);
+            CHECK(events[3].type == JOURNAL_EVT_ACTIVITY && events[3].value == (4U | (80U << 8)));
+            CHECK(events[4].type == JOURNAL_EVT_SIG_MOTION);
+            CHECK(events[5].type == JOURNAL_EVT_STEPS && events[5].value == 16);
+            for (size_t i = 1; i < events.size(); i++) {
+                CHECK(events[i].t_ms > events[i - 1].t_ms);
+            }
+        }
+    }
+} // namespace
+
+int main() {
+    const std::string path = temp_path();
+    test_seek_and_reopen(path);
+    std::remove(path.c_str());
+    test_ring_lap(path);
+    std::remove(path.c_str());
+    test_torn_block(path);
+    test_observe(path);
+    esp_partition_sim::remove_all();
+    std::remove(path.c_str());
+
+    return test::result("event_journal_test");
+}
@@ -0,0 +1,308 @@
+/**
+ * flash_log host test: the sample log on a file-backed partition, reopened
+ * from the file the way a reboot finds it, and read back from the raw image
+ * with the flash_log_format.hpp helpers the decoder uses. Covers tail
+ * recovery after a clean stop and after a block torn by a power cut, CRC
+ * rejection of damaged blocks and headers, laps of the ring with the oldest
+ * sector found after the head (or one further when the head's successor was
+ * erased mid-lap), and sector erase counts carried across laps and erases.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "esp_partition.h"
+#include "esp_partition_sim.hpp"
+#include "flash_log.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr uint32_t LOG_SIZE = 16U * FLASH_LOG_SECTOR_SIZE;
+    constexpr uint32_t RING_SIZE = 4U * FLASH_LOG_SECTOR_SIZE;
+    constexpr uint32_t RECORDS_PER_SECTOR = (FLASH_LOG_BLOCKS_PER_SECTOR - 1) * FLASH_LOG_RECORDS_PER_BLOCK;
+
+    uint32_t next_us = 1000;
+
+    std::string temp_path() {
+        char path[] = "/tmp/flash_log_test_XXXXXX";
+        const int fd = mkstemp(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        std::remove(path);
+        return path;
+    }
+
+    /// @brief Simulated reboot: the partition is reloaded from its file and the log reopened
+    const esp_partition_t* reboot(const std::string& path, uint32_t size = LOG_SIZE) {
+        esp_partition_sim::remove_all();
+        const esp_partition_t* part = esp_partition_sim::add(FLASH_LOG_DEFAULT_LABEL, size, path.c_str());
+        CHECK(part != nullptr);
+        CHECK(flash_log_open());
+        return part;
+    }
+
+    /// @brief Append count records with rising timestamps
+    std::vector<uint32_t> append(size_t count) {
+        std::vector<uint32_t> stamps;
+        for (size_t i = 0; i < count; i++) {
+            imu_compact_sample_t rec = {};
+            rec.timestamp_us = next_us;
+            rec.report_id = SH2_ACCELEROMETER;
+            rec.v[0] = static_cast<int16_t>(i);
+            CHECK(flash_log_append(rec));
+            stamps.push_back(next_us);
+            next_us += 10000;
+        }
+        return stamps;
+    }
+
+    std::vector<uint32_t> concat(std::vector<uint32_t> a, const std::vector<uint32_t>& b) {
+        a.insert(a.end(), b.begin(), b.end());
+        return a;
+    }
+
+    bool is_suffix(const std::vector<uint32_t>& part, const std::vector<uint32_t>& whole) {
+        return part.size() <= whole.size() && std::equal(part.begin(), part.end(), whole.end() - part.size());
+    }
+
+    flash_log_sector_hdr_t sector_hdr(const esp_partition_t* part, uint32_t sector) {
+        flash_log_sector_hdr_t hdr;
+        std::memcpy(&hdr, esp_partition_sim::data(part) + sector * FLASH_LOG_SECTOR_SIZE, sizeof(hdr));
+        return hdr;
+    }
+
+    /**
+     * @brief What a reader of the raw image sees, oldest sector to head
+     * @param stamps: timestamps of the records in valid blocks, in log order
+     * @param rejected: written blocks whose CRC fails
+     */
+    struct log_view_t {
+        flash_log_tail_t tail;
+        std::vector<uint32_t> stamps;
+        uint32_t rejected = 0;
+    };
+
+    log_view_t read_log(const esp_partition_t* part) {
+        const uint8_t* flash = esp_partition_sim::data(part);
+        const uint32_t sectors = part->size / FLASH_LOG_SECTOR_SIZE;
+        log_view_t view;
+        view.tail = flash_log_find_tail([&](uint32_t offset, void* dst, size_t len) {
+            std::memcpy(dst, flash + offset, len);
+            return true;
+        }, sectors);
+        if (view.tail.empty) {
+            return view;
+        }
+
+        for (uint32_t s = view.tail.oldest_sector;; s = (s + 1) % sectors) {
+            if (flash_log_sector_valid(sector_hdr(part, s))) {
+                for (uint32_t b = 1; b < FLASH_LOG_BLOCKS_PER_SECTOR; b++) {
+                    const uint8_t* block = flash + s * FLASH_LOG_SECTOR_SIZE + b * FLASH_LOG_BLOCK_SIZE;
+                    if (flash_log_block_erased(block)) {
+                        break;
+                    }
+                    if (!flash_log_block_valid(block)) {
+                        view.rejected++;
+                        continue;
+                    }
+                    flash_log_block_hdr_t hdr;
+                    std::memcpy(&hdr, block, sizeof(hdr));
+                    for (uint32_t i = 0; i < hdr.count; i++) {
+                        imu_compact_sample_t rec;
+                        std::memcpy(&rec, block + FLASH_LOG_BLOCK_HDR_SIZE + i * sizeof(rec), sizeof(rec));
+                        view.stamps.push_back(rec.timestamp_us);
+                    }
+                }
+            }
+            if (s == view.tail.head_sector) {
+                break;
+            }
+        }
+        return view;
+    }
+
+    void test_tail_recovery(const std::string& path) {
+        const esp_partition_t* part = reboot(path);
+        CHECK(flash_log_erase());
+        CHECK(read_log(part).tail.empty);
+
+        // three and a half blocks: the partial one only reaches flash on sync
+        const std::vector<uint32_t> first = append(3 * FLASH_LOG_RECORDS_PER_BLOCK + FLASH_LOG_RECORDS_PER_BLOCK / 2);
+        CHECK(read_log(part).stamps.size() == 3 * FLASH_LOG_RECORDS_PER_BLOCK);
+        CHECK(flash_log_sync());
+        CHECK(read_log(part).stamps == first);
+        CHECK(flash_log_get_stats().blocks_written == 4);
+
+        // a reboot resumes in the same sector after the last block, reading headers only
+        part = reboot(path);
+        const flash_log_stats_t reopened = flash_log_get_stats();
+        CHECK(reopened.torn_blocks == 0 && reopened.head_seq == 0);
+        CHECK(reopened.recovery_reads <= 16);
+        const log_view_t view = read_log(part);
+        CHECK(view.tail.head_sector == 0 && view.tail.next_block == 5);
+
+        // enough to open two more sectors, all of it readable after another reboot
+        const std::vector<uint32_t> second = append(2 * RECORDS_PER_SECTOR);
+        CHECK(flash_log_sync());
+        part = reboot(path);
+        CHECK(flash_log_get_stats().head_seq == 2);
+        CHECK(read_log(part).stamps == concat(first, second));
+    }
+
+    void test_torn_block(const std::string& path) {
+        const esp_partition_t* part = reboot(path);
+        CHECK(flash_log_erase());
+        const std::vector<uint32_t> before = append(2 * FLASH_LOG_RECORDS_PER_BLOCK);
+
+        // power lost 100 bytes into the next block: its CRC fails, the reboot skips it and appends after it
+        esp_partition_sim::tear_next_write(part, 100);
+        append(FLASH_LOG_RECORDS_PER_BLOCK);
+        part = reboot(path);
+        CHECK(flash_log_get_stats().torn_blocks == 1);
+        log_view_t view = read_log(part);
+        CHECK(view.tail.torn && view.tail.next_block == 4);
+        CHECK(view.stamps == before && view.rejected == 1);
+
+        const std::vector<uint32_t> after = append(FLASH_LOG_RECORDS_PER_BLOCK);
+        part = reboot(path);
+        CHECK(flash_log_get_stats().torn_blocks == 0);
+        view = read_log(part);
+        CHECK(view.stamps == concat(before, after) && view.rejected == 1);
+    }
+
+    void test_crc_rejection(const std::string& path) {
+        const esp_partition_t* part = reboot(path);
+        CHECK(flash_log_erase());
+        const std::vector<uint32_t> written = append(4 * FLASH_LOG_RECORDS_PER_BLOCK);
+
+        // one bit of the third block's payload cleared, as flash only can: that block alone is rejected
+        const uint32_t offset = 3 * FLASH_LOG_BLOCK_SIZE + FLASH_LOG_BLOCK_HDR_SIZE;
+        uint8_t byte = esp_partition_sim::data(part)[offset];
+        CHECK(byte != 0);
+        byte &= static_cast<uint8_t>(byte - 1);
+        CHECK(esp_partition_write(part, offset, &byte, 1) == ESP_OK);
+
+        part = reboot(path);
+        const log_view_t view = read_log(part);
+        CHECK(view.rejected == 1 && !view.tail.torn);
+        std::vector<uint32_t> expected(written.begin(), written.begin() + 2 * FLASH_LOG_RECORDS_PER_BLOCK);
+        expected.insert(expected.end(), written.begin() + 3 * FLASH_LOG_RECORDS_PER_BLOCK, written.end());
+        CHECK(view.stamps == expected);
+
+        // a header whose fields do not match its CRC is not a sector, nor a block its length overruns
+        flash_log_sector_hdr_t hdr = sector_hdr(part, 0);
+        CHECK(flash_log_sector_valid(hdr));
+        hdr.seq++;
+        CHECK(!flash_log_sector_valid(hdr));
+        uint8_t block[FLASH_LOG_BLOCK_SIZE];
+        std::memcpy(block, esp_partition_sim::data(part) + FLASH_LOG_BLOCK_SIZE, sizeof(block));
+        CHECK(flash_log_block_valid(block));
+        block[2] = 0xFF;
+        CHECK(!flash_log_block_valid(block));
+    }
+
+    void test_lapping(const std::string& path) {
+        const esp_partition_t* part = reboot(path, RING_SIZE);
+        CHECK(flash_log_erase());
+
+        // two and a half laps of a 4 sector ring: the newest three sectors and the head are kept
+        const std::vector<uint32_t> written = append(10 * RECORDS_PER_SECTOR + RECORDS_PER_SECTOR / 2);
+        CHECK(flash_log_sync());
+        const flash_log_stats_t stats = flash_log_get_stats();
+        CHECK(stats.head_seq == 10 && stats.sectors_erased == 4 + 11);
+
+        part = reboot(path, RING_SIZE);
+        log_view_t view = read_log(part);
+        CHECK(view.tail.head_sector == 10 % 4 && view.tail.head_seq == 10);
+        CHECK(view.tail.oldest_sector == (view.tail.head_sector + 1) % 4);
+        CHECK(view.stamps.size() == 3 * RECORDS_PER_SECTOR + RECORDS_PER_SECTOR / 2);
+        CHECK(is_suffix(view.stamps, written));
+
+        // the head filled up, then power was lost between erasing its successor and writing the header
+        append((FLASH_LOG_BLOCKS_PER_SECTOR - view.tail.next_block) * FLASH_LOG_RECORDS_PER_BLOCK);
+        view = read_log(part);
+        const std::vector<uint32_t> kept = view.stamps;
+        const uint32_t head = view.tail.head_sector;
+        CHECK(view.tail.next_block == FLASH_LOG_BLOCKS_PER_SECTOR);
+        const uint32_t lost = (head + 1) % 4;
+        const uint32_t head_erases = sector_hdr(part, head).erase_count;
+        CHECK(esp_partition_erase_range(part, lost * FLASH_LOG_SECTOR_SIZE, FLASH_LOG_SECTOR_SIZE) == ESP_OK);
+
+        part = reboot(path, RING_SIZE);
+        view = read_log(part);
+        CHECK(view.tail.head_sector == head && view.tail.next_block == FLASH_LOG_BLOCKS_PER_SECTOR);
+        CHECK(view.tail.oldest_sector == (head + 2) % 4);
+        CHECK(std::vector<uint32_t>(kept.begin() + RECORDS_PER_SECTOR, kept.end()) == view.stamps);
+
+        // the next sector opens in the erased one, taken to be as worn as the head
+        const std::vector<uint32_t> more = append(FLASH_LOG_RECORDS_PER_BLOCK);
+        CHECK(flash_log_sync());
+        CHECK(sector_hdr(part, lost).erase_count == head_erases);
+        view = read_log(part);
+        CHECK(view.tail.head_sector == lost && view.tail.oldest_sector == (head + 2) % 4);
+        CHECK(view.stamps == concat(std::vector<uint32_t>(kept.begin() + RECORDS_PER_SECTOR, kept.end()), more));
+    }
+
+    void test_erase_counts(const std::string& path) {
+        const esp_partition_t* part = reboot(path, RING_SIZE);
+        CHECK(flash_log_erase());
+        uint32_t base_min = 0;
+        uint32_t base_max = 0;
+        CHECK(flash_log_wear(base_min, base_max));
+
+        // one lap opens every sector once, each starts above the most worn count before the erase
+        append(4 * RECORDS_PER_SECTOR);
+        CHECK(flash_log_sync());
+        uint32_t lap[4];
+        for (uint32_t s = 0; s < 4; s++) {
+            lap[s] = sector_hdr(part, s).erase_count;
+            CHECK(lap[s] >= 1);
+        }
+        uint32_t min_erases = 0;
+        uint32_t max_erases = 0;
+        CHECK(flash_log_wear(min_erases, max_erases));
+        CHECK(max_erases - min_erases <= 1);
+
+        // wrapping to sector 0 again carries each sector's own count on, across a reboot too
+        part = reboot(path, RING_SIZE);
+        append(2 * RECORDS_PER_SECTOR);
+        CHECK(flash_log_sync());
+        part = reboot(path, RING_SIZE);
+        append(2 * RECORDS_PER_SECTOR);
+        CHECK(flash_log_sync());
+        for (uint32_t s = 0; s < 4; s++) {
+            CHECK(sector_hdr(part, s).erase_count == lap[s] + 1);
+        }
+        CHECK(flash_log_wear(min_erases, max_erases));
+        CHECK(max_erases - min_erases <= 1);
+
+        // an erase keeps the history: every sector counts it on top of the most worn one's count
+        CHECK(flash_log_erase());
+        append(RECORDS_PER_SECTOR + FLASH_LOG_RECORDS_PER_BLOCK);
+        CHECK(flash_log_sync());
+        CHECK(sector_hdr(part, 0).erase_count == max_erases + 2);
+        CHECK(sector_hdr(part, 1).erase_count == max_erases + 2);
+    }
+} // namespace
+
+int main() {
+    const std::string path = temp_path();
+    test_tail_recovery(path);
+    std::remove(path.c_str());
+    test_torn_block(path);
+    std::remove(path.c_str());
+    test_crc_rejection(path);
+    std::remove(path.c_str());
+    test_lapping(path);
+    std::remove(path.c_str());
+    test_erase_counts(path);
+    esp_partition_sim::remove_all();
+    std::remove(path.c_str());
+
+    return test::result("flash_log_test");
+}
@@ -0,0 +1,155 @@
+/**
+ * imu_batching host test: imu_enable_multi_rpts() hands each entry's config
+ * to the hub, batch_us becomes the hub batch interval, and batched samples
+ * stay in the simulated hub FIFO until the interval expires or a flush is
+ * requested. imu_sample_ring_drain_burst() wakes once per flush and returns
+ * the whole burst in order, and times out when nothing comes.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "imu_driver.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr uint32_t PERIOD_US = 10000UL;
+    constexpr uint32_t BATCH_US = 1000000UL;
+
+    uint32_t stream_t_us = 0;
+
+    /// @brief One accel and one gyro sample per period, accel carries a running index
+    void inject_periods(uint32_t periods, uint32_t &index) {
+        bno08x_sim_sample_t accel;
+        accel.report_id = SH2_ACCELEROMETER;
+        bno08x_sim_sample_t gyro;
+        gyro.report_id = SH2_GYROSCOPE_CALIBRATED;
+        for (uint32_t i = 0; i < periods; i++, stream_t_us += PERIOD_US) {
+            accel.t_us = stream_t_us;
+            accel.v[0] = static_cast<float>(index++);
+            gyro.t_us = stream_t_us;
+            bno08x_sim::inject(accel);
+            bno08x_sim::inject(gyro);
+        }
+    }
+
+    size_t drain_all() {
+        static imu_sample_t out[IMU_SAMPLE_RING_CAPACITY];
+        size_t total = 0;
+        size_t n;
+        while ((n = imu_sample_ring_drain(out, IMU_SAMPLE_RING_CAPACITY)) > 0) {
+            total += n;
+        }
+        return total;
+    }
+
+    void test_config_passed_through() {
+        imu_report_cfg_t rpts[2] = {{SH2_ACCELEROMETER, PERIOD_US}, {SH2_GYROSCOPE_CALIBRATED, 20000UL}};
+        rpts[0].config.changeSensitivityEnabled = true;
+        rpts[0].config.changeSensitivity = 123;
+        rpts[0].config.sensorSpecific = 0xA5;
+        rpts[1].batch_us = 500000UL;
+        CHECK(imu_enable_multi_rpts(rpts, 2));
+
+        imu_report_cfg_t live;
+        CHECK(imu_get_rpt_cfg(SH2_ACCELEROMETER, live));
+        CHECK(live.period_us == PERIOD_US);
+        CHECK(live.config.changeSensitivityEnabled && live.config.changeSensitivity == 123);
+        CHECK(live.config.sensorSpecific == 0xA5);
+        CHECK(live.batch_us == 0 && live.config.batchInterval_us == 0);
+
+        CHECK(imu_get_rpt_cfg(SH2_GYROSCOPE_CALIBRATED, live));
+        CHECK(live.period_us == 20000UL);
+        CHECK(live.batch_us == 500000UL && live.config.batchInterval_us == 500000UL);
+
+        CHECK(imu_disable_all_rpts());
+    }
+
+    void test_fifo_holds_until_interval() {
+        CHECK(imu_enable_rpt_batched(SH2_ACCELEROMETER, PERIOD_US, BATCH_US));
+        CHECK(imu_enable_rpt_batched(SH2_GYROSCOPE_CALIBRATED, PERIOD_US, BATCH_US));
+        drain_all();
+        bno08x_sim::reset_stats();
+
+        // t = 0 .. 990 ms stays in the hub
+        uint32_t index = 0;
+        inject_periods(100, index);
+        CHECK(drain_all() == 0);
+        CHECK(bno08x_sim::stats().host_wakes == 0);
+
+        // accel at t = 1 s reaches the first sample's deadline and goes out with the 200 before it
+        inject_periods(1, index);
+        bno08x_sim_stats_t stats = bno08x_sim::stats();
+        CHECK(stats.fifo_flushes == 1);
+        CHECK(stats.host_wakes == 1);
+        CHECK(drain_all() == 201);
+
+        // each further second is one wake, unbatched it would be 200
+        inject_periods(100, index);
+        CHECK(drain_all() == 200);
+        inject_periods(100, index);
+        CHECK(drain_all() == 200);
+        stats = bno08x_sim::stats();
+        CHECK(stats.fifo_flushes == 3);
+        CHECK(stats.host_wakes == 3);
+        CHECK(stats.samples_batched == 2 * 301);
+
+        // the gyro sample at t = 3 s is still queued, a flush request sends it now
+        CHECK(imu_flush_rpts());
+        CHECK(drain_all() == 1);
+        CHECK(imu_sample_ring_get_stats().overflows == 0);
+
+        CHECK(imu_disable_all_rpts());
+    }
+
+    void test_burst_drain() {
+        CHECK(imu_enable_rpt_batched(SH2_ACCELEROMETER, PERIOD_US, BATCH_US));
+        CHECK(imu_enable_rpt_batched(SH2_GYROSCOPE_CALIBRATED, PERIOD_US, BATCH_US));
+        CHECK(imu_flush_rpts());
+        drain_all();
+
+        static imu_sample_t out[IMU_SAMPLE_RING_CAPACITY];
+        CHECK(imu_sample_ring_drain_burst(out, IMU_SAMPLE_RING_CAPACITY, pdMS_TO_TICKS(20)) == 0);
+
+        // the hub fills its FIFO while the consumer sleeps, the flush is one burst and one wake
+        uint32_t index = 1000;
+        std::thread hub([&index]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+            inject_periods(100, index);
+            imu_flush_rpts();
+        });
+        const size_t n = imu_sample_ring_drain_burst(out, IMU_SAMPLE_RING_CAPACITY, pdMS_TO_TICKS(2000));
+        hub.join();
+
+        CHECK(n == 200);
+        bool ordered = true;
+        float next = 1000.0f;
+        for (size_t i = 0; i < n; i++) {
+            if (out[i].report_id == SH2_ACCELEROMETER) {
+                ordered &= out[i].data.vec.x == next;
+                next += 1.0f;
+            }
+        }
+        CHECK(ordered);
+        CHECK(next == 1100.0f);
+
+        CHECK(imu_disable_all_rpts());
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_WARN);
+    if (!imu_init() || !imu_sample_ring_start()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    test_config_passed_through();
+    test_fifo_holds_until_interval();
+    test_burst_drain();
+
+    return test::result("imu_batching_test");
+}
@@ -0,0 +1,156 @@
+/**
+ * imu_cal host test: the DCD snapshot is only taken once the rotation vector
+ * reaches HIGH accuracy, and imu_init() restores it. A blank hub gets the
+ * record written back and reaches HIGH within SIM_CAL_DCD_SETTLE_US instead
+ * of the minutes a cold calibration takes; a hub that kept its record is left
+ * alone. Corrupt snapshots (CRC) and snapshots older than
+ * IMU_CAL_MAX_AGE_BOOTS are erased rather than loaded.
+ */
+
+#include <cstdio>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "imu_driver.hpp"
+#include "nvs_flash.h"
+#include "test_check.hpp"
+
+namespace {
+    constexpr uint32_t RV_PERIOD_US = 10000UL;
+    constexpr uint32_t NEVER = UINT32_MAX;
+
+    void boot(bool keep_flash) {
+        bno08x_sim::power_cycle(keep_flash);
+        bno08x_sim::reset_stats();
+        CHECK(imu_init());
+        CHECK(imu_enable_rpt(SH2_ROTATION_VECTOR, RV_PERIOD_US));
+    }
+
+    /// @brief Stream rotation vectors from t = 0, stream time of the first HIGH accuracy one
+    uint32_t stream_to_high(uint32_t limit_us) {
+        bno08x_sim_sample_t rv;
+        rv.report_id = SH2_ROTATION_VECTOR;
+        rv.v[0] = 1.0f;
+        uint32_t seq = 0;
+        for (rv.t_us = 0; rv.t_us <= limit_us; rv.t_us += RV_PERIOD_US) {
+            bno08x_sim::inject(rv);
+            imu_sample_t latest;
+            if (imu_latest_read_new(SH2_ROTATION_VECTOR, latest, seq) &&
+                    latest.accuracy == static_cast<uint8_t>(BNO08xAccuracy::HIGH)) {
+                return rv.t_us;
+            }
+        }
+        return NEVER;
+    }
+
+    void test_cold_boot_and_snapshot() {
+        nvs_flash_erase();
+        boot(false);
+        imu_cal_stats_t stats = imu_cal_get_stats();
+        CHECK(stats.restore == IMU_CAL_RESTORE_NONE);
+        CHECK(stats.boot == 1);
+        CHECK(stats.boot_to_high_us == -1);
+
+        // not converged yet: nothing is saved
+        CHECK(stream_to_high(60000000UL) == NEVER);
+        CHECK(!imu_cal_save_if_converged());
+        CHECK(imu_cal_get_stats().saves == 0);
+
+        // three accuracy steps of 40 s without a DCD
+        CHECK(stream_to_high(300000000UL) == 120000000UL);
+        CHECK(imu_cal_save_if_converged());
+        stats = imu_cal_get_stats();
+        CHECK(stats.saves == 1);
+        CHECK(stats.boot_to_high_us >= 0);
+
+        // rate limited to one snapshot per IMU_CAL_SAVE_INTERVAL_MS
+        CHECK(!imu_cal_save_if_converged());
+        CHECK(imu_cal_get_stats().saves == 1);
+    }
+
+    void test_restore() {
+        // a blank hub gets the snapshot written back and settles in well under a second
+        boot(false);
+        imu_cal_stats_t stats = imu_cal_get_stats();
+        CHECK(stats.restore == IMU_CAL_RESTORE_WRITTEN);
+        CHECK(stats.boot == 2);
+        CHECK(stats.snapshot_age_boots == 1);
+        CHECK(bno08x_sim::stats().frs_writes == 1);
+        const uint32_t high_us = stream_to_high(10000000UL);
+        CHECK(high_us != NEVER && high_us <= 300000UL);
+
+        // a hub that kept its record is only read
+        boot(true);
+        CHECK(imu_cal_get_stats().restore == IMU_CAL_RESTORE_CURRENT);
+        CHECK(bno08x_sim::stats().frs_writes == 0);
+        CHECK(stream_to_high(10000000UL) <= 300000UL);
+    }
+
+    void test_corrupt_snapshot() {
+        nvs_handle_t nvs;
+        CHECK(nvs_open("imu_cal", NVS_READWRITE, &nvs) == ESP_OK);
+        uint8_t blob[256];
+        size_t len = sizeof(blob);
+        CHECK(nvs_get_blob(nvs, "dcd", blob, &len) == ESP_OK);
+        CHECK(len > 20);
+        blob[20] ^= 0x01;   // a DCD word, covered by the CRC
+        CHECK(nvs_set_blob(nvs, "dcd", blob, len) == ESP_OK);
+        nvs_commit(nvs);
+        nvs_close(nvs);
+
+        boot(false);
+        CHECK(imu_cal_get_stats().restore == IMU_CAL_RESTORE_CORRUPT);
+        CHECK(bno08x_sim::stats().frs_writes == 0);
+
+        // erased, not retried
+        boot(false);
+        CHECK(imu_cal_get_stats().restore == IMU_CAL_RESTORE_NONE);
+    }
+
+    void test_stale_snapshot() {
+        boot(false);
+        CHECK(imu_cal_save());
+        const uint32_t saved_boot = imu_cal_get_stats().boot;
+
+        while (imu_cal_get_stats().boot - saved_boot < IMU_CAL_MAX_AGE_BOOTS) {
+            imu_init();
+        }
+        CHECK(imu_cal_get_stats().restore != IMU_CAL_RESTORE_STALE);
+
+        boot(false);
+        imu_cal_stats_t stats = imu_cal_get_stats();
+        CHECK(stats.restore == IMU_CAL_RESTORE_STALE);
+        CHECK(stats.snapshot_age_boots == IMU_CAL_MAX_AGE_BOOTS + 1);
+        CHECK(bno08x_sim::stats().frs_writes == 0);
+
+        boot(false);
+        CHECK(imu_cal_get_stats().restore == IMU_CAL_RESTORE_NONE);
+    }
+
+    void test_erase() {
+        boot(false);
+        CHECK(imu_cal_save());
+        CHECK(imu_cal_erase());
+        boot(false);
+        CHECK(imu_cal_get_stats().restore == IMU_CAL_RESTORE_NONE);
+        CHECK(imu_cal_erase());
+
+        CHECK(imu_disable_all_rpts());
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_NONE);
+    if (!imu_init() || !imu_latest_start()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    test_cold_boot_and_snapshot();
+    test_restore();
+    test_corrupt_snapshot();
+    test_stale_snapshot();
+    test_erase();
+
+    return test::result("imu_cal_test");
+}
@@ -0,0 +1,224 @@
+/**
+ * imu_clock host test: against a hub clock 1.2 s ahead and 200 ppm fast,
+ * delivered in real time with a random interrupt delay, the clock sync locks
+ * after one window, estimates the drift to within 10 ppm and maps hub time
+ * onto esp_timer time to within the smallest delivery delay. Raw samples are
+ * stamped closer to their true time than their arrival, and so are the other
+ * unbatched reports once the typical delay is taken off. A reset or a hub
+ * time step restarts the estimate. The frame aligner interpolates reports
+ * sampled at different phases onto one grid (linear, nlerp, hold).
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "imu_align.hpp"
+#include "imu_driver.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr int32_t HUB_OFFSET_US = 1200000;
+    constexpr float HUB_DRIFT_PPM = 200.0f;
+    constexpr uint32_t PERIOD_US = 10000UL;
+
+    struct stamp_err_t {
+        double arrival = 0.0;
+        double stamp = 0.0;
+        uint32_t n = 0;
+    };
+
+    double abs_diff_us(uint32_t a, uint32_t b) {
+        return std::fabs(static_cast<double>(static_cast<int32_t>(a - b)));
+    }
+
+    void test_sync() {
+        CHECK(imu_enable_rpt(SH2_RAW_ACCELEROMETER, PERIOD_US));
+        CHECK(imu_enable_rpt(SH2_ACCELEROMETER, PERIOD_US));
+        bno08x_sim::set_hub_clock(HUB_OFFSET_US, HUB_DRIFT_PPM);
+        imu_clock_reset();
+        imu_sample_t drained[16];
+        while (imu_sample_ring_drain(drained, 16) > 0) {
+        }
+
+        // 100..400 us of interrupt delay, one in 20 stalls 2..5 ms behind other work
+        uint32_t rng = 2024U;
+        auto next_rand = [&rng]() {
+            rng = rng * 1664525U + 1013904223U;
+            return rng >> 8;
+        };
+
+        stamp_err_t raw_err, fused_err;
+        bno08x_sim_sample_t raw;
+        raw.report_id = SH2_RAW_ACCELEROMETER;
+        bno08x_sim_sample_t accel;
+        accel.report_id = SH2_ACCELEROMETER;
+        const auto start = std::chrono::steady_clock::now();
+        const uint32_t host0_us = static_cast<uint32_t>(esp_timer_get_time());
+        constexpr uint32_t DURATION_US = 6000000UL;
+        for (uint32_t t_us = 0; t_us < DURATION_US; t_us += PERIOD_US) {
+            const uint32_t delay_us = (next_rand() % 20 == 0) ? 2000 + next_rand() % 3000 : 100 + next_rand() % 300;
+            std::this_thread::sleep_until(start + std::chrono::microseconds(t_us + delay_us));
+            const uint32_t arrival_us = static_cast<uint32_t>(esp_timer_get_time());
+            raw.t_us = t_us;
+            accel.t_us = t_us;
+            bno08x_sim::inject(raw);
+            bno08x_sim::inject(accel);
+
+            const uint32_t true_us = host0_us + t_us;
+            const size_t n = imu_sample_ring_drain(drained, 16);
+            // the first window locks on, score the rest
+            for (size_t i = 0; i < n && t_us >= 1000000UL; i++) {
+                stamp_err_t &err = (drained[i].report_id == SH2_RAW_ACCELEROMETER) ? raw_err : fused_err;
+                err.arrival += abs_diff_us(arrival_us, true_us);
+                err.stamp += abs_diff_us(drained[i].timestamp_us, true_us);
+                err.n++;
+            }
+        }
+
+        const imu_clock_stats_t stats = imu_clock_get_stats();
+        CHECK(stats.locked);
+        CHECK(stats.windows >= 10);
+        // the explicit reset is the only restart, the stall never maps a sample into the future
+        CHECK(stats.resyncs == 1);
+        // published as each window closes
+        constexpr uint32_t TOTAL = DURATION_US / PERIOD_US;
+        CHECK(stats.samples <= TOTAL && stats.samples + IMU_CLOCK_WINDOW_MS * 1000UL / PERIOD_US >= TOTAL);
+        CHECK(std::fabs(stats.drift_ppm - HUB_DRIFT_PPM) < 10.0f);
+        std::printf("drift %.1f ppm (hub %.1f), typical delay %lu us\n", stats.drift_ppm, HUB_DRIFT_PPM,
+                    (unsigned long)stats.delay_us);
+
+        // hub time at the end of the run maps back onto the host time it was taken at, plus the smallest delay
+        const uint32_t t_end = DURATION_US - PERIOD_US;
+        const uint32_t hub_end = t_end + HUB_OFFSET_US + static_cast<uint32_t>(std::lround(t_end * HUB_DRIFT_PPM * 1e-6));
+        uint32_t host_us = 0;
+        CHECK(imu_clock_hub_to_host(hub_end, host_us));
+        const int32_t map_err = static_cast<int32_t>(host_us - (host0_us + t_end));
+        CHECK(map_err >= 0 && map_err < 1000);
+
+        CHECK(raw_err.n > 0 && fused_err.n > 0);
+        if (raw_err.n > 0 && fused_err.n > 0) {
+            CHECK(raw_err.stamp < raw_err.arrival);
+            CHECK(raw_err.stamp / raw_err.n < 500.0);
+            CHECK(fused_err.stamp < fused_err.arrival);
+        }
+
+        CHECK(imu_disable_all_rpts());
+    }
+
+    void test_resync() {
+        CHECK(imu_enable_rpt(SH2_RAW_ACCELEROMETER, PERIOD_US));
+        bno08x_sim_sample_t raw;
+        raw.report_id = SH2_RAW_ACCELEROMETER;
+        raw.t_us = 7000000UL;
+        const uint32_t resyncs = imu_clock_get_stats().resyncs;
+
+        // an explicit reset restarts on the next raw sample
+        imu_clock_reset();
+        CHECK(bno08x_sim::inject(raw));
+        imu_clock_stats_t stats = imu_clock_get_stats();
+        CHECK(stats.resyncs == resyncs + 1);
+        CHECK(stats.samples == 1 && stats.windows == 0 && !stats.locked);
+        CHECK(stats.drift_ppm == 0.0f);
+
+        // hub time jumping back (the hub restarted its clock) does the same
+        raw.t_us += PERIOD_US;
+        CHECK(bno08x_sim::inject(raw));
+        bno08x_sim::set_hub_clock(0, 0.0f);
+        raw.t_us += PERIOD_US;
+        CHECK(bno08x_sim::inject(raw));
+        stats = imu_clock_get_stats();
+        CHECK(stats.resyncs == resyncs + 2);
+        CHECK(stats.samples == 1);
+
+        CHECK(imu_disable_all_rpts());
+    }
+
+    imu_sample_t vec_sample(uint8_t id, uint32_t t_us, float x) {
+        imu_sample_t s = {};
+        s.report_id = id;
+        s.timestamp_us = t_us;
+        s.data.vec = {x, 2.0f * x, -x};
+        return s;
+    }
+
+    imu_sample_t yaw_sample(uint32_t t_us, float yaw_rad) {
+        imu_sample_t s = {};
+        s.report_id = SH2_ROTATION_VECTOR;
+        s.timestamp_us = t_us;
+        s.data.quat = {std::cos(yaw_rad / 2.0f), 0.0f, 0.0f, std::sin(yaw_rad / 2.0f)};
+        return s;
+    }
+
+    void test_aligner() {
+        imu_frame_aligner aligner;
+        const uint8_t ids[] = {SH2_ACCELEROMETER, SH2_GYROSCOPE_CALIBRATED, SH2_ROTATION_VECTOR,
+                               SH2_STABILITY_CLASSIFIER};
+        CHECK(!aligner.configure(ids, 0, PERIOD_US));
+        CHECK(!aligner.configure(ids, 4, 0));
+        CHECK(aligner.configure(ids, 4, PERIOD_US));
+
+        // accel on the grid, gyro 4 ms late, RV at 50 Hz 7 ms late; x ramps 1 per ms, yaw 0.01 rad per ms
+        imu_frame_t frame;
+        CHECK(!aligner.next(frame));
+        for (uint32_t k = 0; k < 6; k++) {
+            const uint32_t t = 100000UL + k * PERIOD_US;
+            CHECK(aligner.push(vec_sample(SH2_ACCELEROMETER, t, t / 1000.0f)));
+            CHECK(aligner.push(vec_sample(SH2_GYROSCOPE_CALIBRATED, t + 4000, (t + 4000) / 1000.0f)));
+            if (k % 2 == 0) {
+                CHECK(aligner.push(yaw_sample(t + 7000, (t + 7000 - 100000UL) / 100000.0f)));
+            }
+        }
+        imu_sample_t other = vec_sample(SH2_MAGNETIC_FIELD_CALIBRATED, 100000UL, 1.0f);
+        CHECK(!aligner.push(other));
+
+        // the grid starts at the first tick every interpolated report covers
+        CHECK(aligner.next(frame));
+        CHECK(frame.timestamp_us == 110000UL);
+        CHECK(frame.count == 4);
+        CHECK(frame.valid == 0x7);     // no classifier sample yet
+        CHECK(std::fabs(frame.rpt[0].data.vec.x - 110.0f) < 1e-3f);
+        CHECK(std::fabs(frame.rpt[1].data.vec.x - 110.0f) < 1e-3f);
+        CHECK(std::fabs(frame.rpt[1].data.vec.y - 220.0f) < 1e-3f);
+        CHECK(frame.rpt[1].timestamp_us == 110000UL);
+        // between 107 and 127 ms: yaw 0.1 rad, nlerp is within a hair of slerp over such a short arc
+        const float yaw = 2.0f * std::atan2(frame.rpt[2].data.quat.k, frame.rpt[2].data.quat.real);
+        CHECK(std::fabs(yaw - 0.1f) < 1e-3f);
+
+        // a held report appears once a sample at or before the tick exists
+        imu_sample_t stable = {};
+        stable.report_id = SH2_STABILITY_CLASSIFIER;
+        stable.timestamp_us = 115000UL;
+        CHECK(aligner.push(stable));
+        CHECK(aligner.next(frame));
+        CHECK(frame.timestamp_us == 120000UL);
+        CHECK(frame.valid == 0xF);
+        CHECK(frame.rpt[3].timestamp_us == 115000UL);
+
+        // ticks run until the slowest interpolated report (RV, last at 147 ms) stops covering them
+        uint32_t last = frame.timestamp_us;
+        while (aligner.next(frame)) {
+            last = frame.timestamp_us;
+        }
+        CHECK(last == 140000UL);
+        CHECK(aligner.skipped() == 0);
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_WARN);
+    if (!imu_init() || !imu_sample_ring_start()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    test_sync();
+    test_resync();
+    test_aligner();
+
+    return test::result("imu_clock_test");
+}
@@ -0,0 +1,263 @@
+/**
+ * imu_codec host test: blocks decode back to the exact compact records that
+ * were pushed, for every flag combination and block size, including full
+ * scale jumps, interval changes, format changes and timestamps wrapping. Each
+ * block decodes on its own and starts with a key sample whose time can be
+ * read without decoding. A block never exceeds its size or IMU_CODEC_MAX_CHANNELS
+ * reports, and a refused push leaves it unchanged. Smooth streams cost well
+ * under half a compact record per sample, and a rotation vector crossing the
+ * real = 0 hemisphere boundary costs one ext byte with IMU_CODEC_F_QUAT_TRACK.
+ * Truncated blocks are rejected.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "imu_codec.hpp"
+#include "imu_driver.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr uint32_t PERIOD_US = 10000UL;
+
+    struct stream_t {
+        std::vector<imu_compact_sample_t> samples;
+        std::vector<std::vector<uint8_t>> blocks;
+    };
+
+    bool same_record(const imu_compact_sample_t &a, const imu_compact_sample_t &b) {
+        return a.timestamp_us == b.timestamp_us && a.report_id == b.report_id && a.format == b.format &&
+               a.v[0] == b.v[0] && a.v[1] == b.v[1] && a.v[2] == b.v[2];
+    }
+
+    imu_compact_sample_t pack(const imu_sample_t &s) {
+        imu_compact_sample_t out;
+        imu_compact_pack(s, out);
+        return out;
+    }
+
+    /// @brief 100 Hz accel, gyro and rotation vector plus a step counter, from t0_us
+    std::vector<imu_compact_sample_t> walk(uint32_t count, uint32_t t0_us) {
+        std::vector<imu_compact_sample_t> out;
+        uint32_t rng = 7U;
+        auto noise = [&rng]() {
+            rng = rng * 1664525U + 1013904223U;
+            return static_cast<float>(static_cast<int32_t>(rng >> 24) - 128) / 4096.0f;
+        };
+        for (uint32_t i = 0; i < count; i++) {
+            const float t = static_cast<float>(i) * 0.01f;
+            const uint32_t t_us = t0_us + i * PERIOD_US;
+
+            imu_sample_t s = {};
+            s.timestamp_us = t_us;
+            s.accuracy = 3;
+            s.report_id = SH2_ACCELEROMETER;
+            s.data.vec = {std::sin(t * 12.0f) * 3.0f + noise(), std::cos(t * 12.0f) + noise(), 9.81f + noise()};
+            out.push_back(pack(s));
+
+            // the gyro runs 3 ms behind accel
+            s.timestamp_us = t_us + 3000;
+            s.report_id = SH2_GYROSCOPE_CALIBRATED;
+            s.data.vec = {std::cos(t * 12.0f) * 2.0f + noise(), noise(), 0.3f * std::sin(t) + noise()};
+            out.push_back(pack(s));
+
+            // a full turn of yaw every 4 s, through the real = 0 boundary
+            s.timestamp_us = t_us + 5000;
+            s.report_id = SH2_ROTATION_VECTOR;
+            const float yaw = t * 1.5707964f;
+            s.data.quat = {std::cos(yaw / 2.0f), 0.01f * std::sin(t), 0.0f, std::sin(yaw / 2.0f)};
+            out.push_back(pack(s));
+
+            if (i % 50 == 0) {
+                s.timestamp_us = t_us + 7000;
+                s.report_id = SH2_STEP_COUNTER;
+                s.data.value = i / 50;
+                out.push_back(pack(s));
+            }
+        }
+        return out;
+    }
+
+    template <size_t BLOCK_BYTES>
+    void encode(stream_t &stream, uint8_t flags) {
+        imu_codec_encoder_t<BLOCK_BYTES> enc(flags);
+        stream.blocks.clear();
+        for (const imu_compact_sample_t &s : stream.samples) {
+            if (!enc.push(s)) {
+                stream.blocks.emplace_back(enc.block(), enc.block() + enc.size());
+                enc.start_block();
+                CHECK(enc.push(s));
+            }
+        }
+        if (enc.samples() > 0) {
+            stream.blocks.emplace_back(enc.block(), enc.block() + enc.size());
+        }
+    }
+
+    /// @brief Decode every block on its own and compare with what was pushed
+    bool round_trips(const stream_t &stream, size_t block_bytes) {
+        static imu_compact_sample_t decoded[4096];
+        size_t next = 0;
+        bool ok = true;
+        for (const std::vector<uint8_t> &block : stream.blocks) {
+            ok &= block.size() <= block_bytes;
+            const size_t n = imu_codec_decode_block(block.data(), block.size(), decoded, 4096);
+            ok &= n > 0 && n == imu_codec_block_samples(block.data(), block.size());
+
+            uint32_t first_us = 0;
+            ok &= imu_codec_block_first_us(block.data(), block.size(), first_us);
+            ok &= first_us == decoded[0].timestamp_us;
+            for (size_t i = 0; i < n && next < stream.samples.size(); i++, next++) {
+                ok &= same_record(decoded[i], stream.samples[next]);
+            }
+        }
+        return ok && next == stream.samples.size();
+    }
+
+    size_t encoded_bytes(const stream_t &stream) {
+        size_t bytes = 0;
+        for (const std::vector<uint8_t> &block : stream.blocks) {
+            bytes += block.size();
+        }
+        return bytes;
+    }
+
+    void test_primitives() {
+        const int32_t values[] = {0, -1, 1, -64, 63, 64, 32767, -32768, INT32_MAX, INT32_MIN};
+        uint8_t buf[8];
+        bool ok = true;
+        for (int32_t v : values) {
+            ok &= imu_codec_unzigzag(imu_codec_zigzag(v)) == v;
+            const uint32_t z = imu_codec_zigzag(v);
+            const size_t n = imu_codec_put_varint(buf, z);
+            const uint8_t *p = buf;
+            uint32_t back = 0;
+            ok &= imu_codec_get_varint(p, buf + n, back) && back == z && p == buf + n;
+        }
+        CHECK(ok);
+        CHECK(imu_codec_zigzag(-1) == 1 && imu_codec_zigzag(1) == 2 && imu_codec_zigzag(-2) == 3);
+        CHECK(imu_codec_put_varint(buf, 0x7F) == 1 && imu_codec_put_varint(buf, 0x80) == 2);
+        CHECK(imu_codec_put_varint(buf, UINT32_MAX) == 5);
+
+        // a varint cut short is an error, not a read past the end
+        imu_codec_put_varint(buf, 0x4000);
+        const uint8_t *p = buf;
+        uint32_t v = 0;
+        CHECK(!imu_codec_get_varint(p, buf + 2, v));
+
+        // each packing picked at its limit and read back
+        const uint32_t limits[][3] = {{31, 0, 31}, {32, 255, 0}, {256, 1023, 7}, {1024, 0, 70000}};
+        const uint8_t packs[] = {IMU_CODEC_PACK_5, IMU_CODEC_PACK_8, IMU_CODEC_PACK_10, IMU_CODEC_PACK_VARINT};
+        for (int k = 0; k < 4; k++) {
+            uint8_t pack = 0xFF;
+            const size_t n = imu_codec_put_residuals(buf, limits[k], pack);
+            CHECK(pack == packs[k]);
+            uint32_t r[3] = {};
+            const uint8_t *q = buf;
+            CHECK(imu_codec_get_residuals(q, buf + n, pack, r) && q == buf + n);
+            CHECK(r[0] == limits[k][0] && r[1] == limits[k][1] && r[2] == limits[k][2]);
+        }
+    }
+
+    void test_round_trip() {
+        stream_t stream;
+        stream.samples = walk(1000, 0xFFFFFFFFUL - 3000000UL);
+
+        // full scale jumps, an interval change and a format (accuracy) change in the middle
+        stream.samples[600].v[0] = 32767;
+        stream.samples[603].v[0] = -32768;
+        stream.samples[606].format ^= 0x10;
+        for (size_t i = 900; i < stream.samples.size(); i++) {
+            stream.samples[i].timestamp_us += static_cast<uint32_t>(i - 900) * 17;
+        }
+
+        const uint8_t flag_sets[] = {0, IMU_CODEC_F_ADAPTIVE, IMU_CODEC_F_QUAT_TRACK, IMU_CODEC_F_DEFAULT};
+        for (uint8_t flags : flag_sets) {
+            encode<IMU_CODEC_BLOCK_BYTES>(stream, flags);
+            CHECK(stream.blocks.size() > 1);
+            CHECK(round_trips(stream, IMU_CODEC_BLOCK_BYTES));
+            encode<4096>(stream, flags);
+            CHECK(round_trips(stream, 4096));
+        }
+    }
+
+    void test_ratio() {
+        stream_t stream;
+        stream.samples = walk(3000, 0);
+        encode<IMU_CODEC_BLOCK_BYTES>(stream, IMU_CODEC_F_DEFAULT);
+        const float small = static_cast<float>(encoded_bytes(stream)) / stream.samples.size();
+        encode<4096>(stream, IMU_CODEC_F_DEFAULT);
+        const float large = static_cast<float>(encoded_bytes(stream)) / stream.samples.size();
+        std::printf("walk: %.2f B/sample in %u B blocks, %.2f in 4 KB blocks\n", small, IMU_CODEC_BLOCK_BYTES, large);
+        CHECK(small < sizeof(imu_compact_sample_t) / 2.0f);
+        CHECK(large < small);
+    }
+
+    void test_quat_track() {
+        // only the rotation vector, across the boundary at yaw = pi (t = 2 s)
+        stream_t stream;
+        for (const imu_compact_sample_t &s : walk(300, 0)) {
+            if (s.report_id == SH2_ROTATION_VECTOR && s.timestamp_us >= 1900000UL && s.timestamp_us < 2100000UL) {
+                stream.samples.push_back(s);
+            }
+        }
+        CHECK(stream.samples.size() == 20);
+        encode<4096>(stream, IMU_CODEC_F_DEFAULT);
+        const size_t tracked = encoded_bytes(stream);
+        CHECK(round_trips(stream, 4096));
+        encode<4096>(stream, IMU_CODEC_F_ADAPTIVE);
+        const size_t untracked = encoded_bytes(stream);
+        CHECK(round_trips(stream, 4096));
+        CHECK(stream.blocks.size() == 1);
+        CHECK(tracked + 4 < untracked);
+    }
+
+    void test_limits() {
+        imu_codec_encoder_t<IMU_CODEC_BLOCK_BYTES> enc;
+        CHECK(enc.samples() == 0 && enc.size() == IMU_CODEC_HDR_BYTES);
+
+        // one report more than channels: refused, block untouched
+        imu_sample_t s = {};
+        s.data.vec = {1.0f, 2.0f, 3.0f};
+        const uint8_t ids[] = {SH2_ACCELEROMETER, SH2_GYROSCOPE_CALIBRATED, SH2_MAGNETIC_FIELD_CALIBRATED,
+                               SH2_LINEAR_ACCELERATION, SH2_GRAVITY, SH2_RAW_ACCELEROMETER, SH2_RAW_GYROSCOPE,
+                               SH2_RAW_MAGNETOMETER, SH2_GYROSCOPE_UNCALIBRATED};
+        static_assert(sizeof(ids) == IMU_CODEC_MAX_CHANNELS + 1);
+        for (size_t i = 0; i < IMU_CODEC_MAX_CHANNELS; i++) {
+            s.report_id = ids[i];
+            CHECK(enc.push(pack(s)));
+        }
+        uint8_t before[IMU_CODEC_BLOCK_BYTES];
+        const size_t size = enc.size();
+        std::memcpy(before, enc.block(), size);
+        s.report_id = ids[IMU_CODEC_MAX_CHANNELS];
+        CHECK(!enc.push(pack(s)));
+        CHECK(enc.size() == size && enc.samples() == IMU_CODEC_MAX_CHANNELS);
+        CHECK(std::memcmp(before, enc.block(), size) == 0);
+
+        // truncated or undersized: nothing decoded
+        imu_compact_sample_t out[IMU_CODEC_MAX_CHANNELS];
+        CHECK(imu_codec_decode_block(enc.block(), size, out, IMU_CODEC_MAX_CHANNELS) == IMU_CODEC_MAX_CHANNELS);
+        CHECK(imu_codec_decode_block(enc.block(), size - 1, out, IMU_CODEC_MAX_CHANNELS) == 0);
+        CHECK(imu_codec_decode_block(enc.block(), size, out, IMU_CODEC_MAX_CHANNELS - 1) == 0);
+        CHECK(imu_codec_block_samples(enc.block(), 3) == 0);
+        uint32_t first_us = 0;
+        CHECK(!imu_codec_block_first_us(enc.block(), 6, first_us));
+
+        enc.start_block();
+        CHECK(enc.samples() == 0 && enc.size() == IMU_CODEC_HDR_BYTES);
+        CHECK(!imu_codec_block_first_us(enc.block(), enc.size(), first_us));
+    }
+} // namespace
+
+int main() {
+    test_primitives();
+    test_round_trip();
+    test_ratio();
+    test_quat_track();
+    test_limits();
+
+    return test::result("imu_codec_test");
+}
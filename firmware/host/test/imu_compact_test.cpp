@@ -0,0 +1,237 @@
+/**
+ * imu_compact host test: a compact record is 12 bytes holding the report's
+ * native Q point int16 values. Values on the Q grid round trip exactly, others
+ * to within half a step, and out of range values saturate. Quaternions come
+ * back as the same rotation with real >= 0; activity and integer reports keep
+ * every bit. The batch converters agree with per sample unpacking, and
+ * imu_sample_ring_drain_compact() returns what imu_compact_pack() makes of
+ * the full samples.
+ *
+ * Also built with IMU_SAMPLE_RING_COMPACT=1 (imu_compact_ring): the ring then
+ * stores compact records and the full drain unpacks them.
+ */
+
+#include <cmath>
+#include <cstdio>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "imu_driver.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr uint32_t PERIOD_US = 10000UL;
+
+    imu_sample_t vec_sample(uint8_t id, float x, float y, float z) {
+        imu_sample_t s = {};
+        s.timestamp_us = 123456UL;
+        s.report_id = id;
+        s.accuracy = static_cast<uint8_t>(BNO08xAccuracy::MED);
+        s.data.vec = {x, y, z};
+        return s;
+    }
+
+    imu_sample_t round_trip(const imu_sample_t &in) {
+        imu_compact_sample_t packed;
+        imu_compact_pack(in, packed);
+        imu_sample_t out;
+        imu_compact_unpack(packed, out);
+        return out;
+    }
+
+    bool same_record(const imu_compact_sample_t &a, const imu_compact_sample_t &b) {
+        return a.report_id == b.report_id && a.format == b.format && a.v[0] == b.v[0] && a.v[1] == b.v[1] &&
+               a.v[2] == b.v[2];
+    }
+
+    void test_layout() {
+        imu_compact_sample_t packed;
+        imu_compact_pack(vec_sample(SH2_GYROSCOPE_CALIBRATED, 1.0f, -2.0f, 0.5f), packed);
+        CHECK(packed.timestamp_us == 123456UL);
+        CHECK(packed.report_id == SH2_GYROSCOPE_CALIBRATED);
+        CHECK(imu_compact_q_point(packed) == 9);
+        CHECK(imu_compact_accuracy(packed) == static_cast<uint8_t>(BNO08xAccuracy::MED));
+        CHECK(packed.v[0] == 512 && packed.v[1] == -1024 && packed.v[2] == 256);
+        CHECK(sizeof(imu_compact_sample_t) * 2 == sizeof(imu_sample_t));
+    }
+
+    void test_vec_round_trip() {
+        // on the grid: exact, whatever the Q point
+        const imu_sample_t on_grid[] = {
+            vec_sample(SH2_ACCELEROMETER, 9.80078125f, -0.00390625f, 127.99609375f),
+            vec_sample(SH2_GYROSCOPE_CALIBRATED, -63.998046875f, 0.001953125f, 0.0f),
+            vec_sample(SH2_MAGNETIC_FIELD_CALIBRATED, 42.5625f, -2047.9375f, 0.0625f),
+            vec_sample(SH2_RAW_ACCELEROMETER, 32767.0f, -32768.0f, 17.0f),
+        };
+        for (const imu_sample_t &in : on_grid) {
+            const imu_sample_t out = round_trip(in);
+            CHECK(out.timestamp_us == in.timestamp_us && out.report_id == in.report_id && out.accuracy == in.accuracy);
+            CHECK(out.data.vec.x == in.data.vec.x && out.data.vec.y == in.data.vec.y && out.data.vec.z == in.data.vec.z);
+        }
+
+        // off the grid: nearest step
+        const imu_sample_t accel = vec_sample(SH2_ACCELEROMETER, 9.81f, -0.001f, 3.14159f);
+        const imu_sample_t out = round_trip(accel);
+        CHECK(std::fabs(out.data.vec.x - accel.data.vec.x) <= 0.5f / 256.0f);
+        CHECK(std::fabs(out.data.vec.y - accel.data.vec.y) <= 0.5f / 256.0f);
+        CHECK(std::fabs(out.data.vec.z - accel.data.vec.z) <= 0.5f / 256.0f);
+
+        // beyond the int16 range: the end of the range, never a wrap
+        const imu_sample_t big = round_trip(vec_sample(SH2_ACCELEROMETER, 200.0f, -200.0f, 0.0f));
+        CHECK(big.data.vec.x == 32767.0f / 256.0f);
+        CHECK(big.data.vec.y == -128.0f);
+    }
+
+    void test_quat_round_trip() {
+        // 120 degrees about (1, 1, 1) / sqrt(3), stored as given and negated
+        const float h = 0.5f;
+        imu_sample_t rv = {};
+        rv.report_id = SH2_ROTATION_VECTOR;
+        rv.accuracy = static_cast<uint8_t>(BNO08xAccuracy::HIGH);
+        for (float sign : {1.0f, -1.0f}) {
+            rv.data.quat = {sign * h, sign * h, sign * h, sign * h};
+            imu_compact_sample_t packed;
+            imu_compact_pack(rv, packed);
+            CHECK(imu_compact_q_point(packed) == 14);
+            CHECK(packed.v[0] == 8192 && packed.v[1] == 8192 && packed.v[2] == 8192);
+
+            imu_sample_t out;
+            imu_compact_unpack(packed, out);
+            CHECK(out.accuracy == rv.accuracy);
+            CHECK(std::fabs(out.data.quat.real - h) < 1e-6f);
+            CHECK(out.data.quat.i == h && out.data.quat.j == h && out.data.quat.k == h);
+        }
+
+        // off the grid the restored real part is within a few steps
+        rv.data.quat = {0.8f, 0.36f, -0.48f, 0.0f};
+        const imu_sample_t out = round_trip(rv);
+        CHECK(std::fabs(out.data.quat.real - 0.8f) < 4.0f / 16384.0f);
+        CHECK(std::fabs(out.data.quat.j + 0.48f) <= 0.5f / 16384.0f);
+    }
+
+    void test_other_kinds() {
+        imu_sample_t activity = {};
+        activity.report_id = SH2_PERSONAL_ACTIVITY_CLASSIFIER;
+        activity.data.activity = {6, 93};
+        imu_sample_t out = round_trip(activity);
+        CHECK(out.data.activity.state == 6 && out.data.activity.confidence == 93);
+
+        // every bit of a 32 bit value, including the ones that make the halves negative
+        const uint32_t values[] = {0UL, 1UL, 0x12345678UL, 0xFFFF8001UL, 0x8000FFFFUL};
+        imu_sample_t steps = {};
+        steps.report_id = SH2_STEP_COUNTER;
+        for (uint32_t value : values) {
+            steps.data.value = value;
+            out = round_trip(steps);
+            CHECK(out.data.value == value);
+        }
+    }
+
+    void test_batch_converters() {
+        // one sensor's pre-trigger history
+        imu_compact_sample_t history[9];
+        imu_sample_t full[9];
+        for (int i = 0; i < 9; i++) {
+            const float x = 0.37f * static_cast<float>(i) - 1.0f;
+            imu_compact_pack(vec_sample(SH2_GYROSCOPE_CALIBRATED, x, -2.0f * x, x * x), history[i]);
+        }
+        float xyz[27];
+        imu_compact_vec_to_float(history, 9, xyz);
+        imu_compact_unpack_batch(history, 9, full);
+        bool same = true;
+        for (int i = 0; i < 9; i++) {
+            imu_sample_t one;
+            imu_compact_unpack(history[i], one);
+            same &= xyz[3 * i] == one.data.vec.x && xyz[3 * i + 1] == one.data.vec.y && xyz[3 * i + 2] == one.data.vec.z;
+            same &= full[i].data.vec.x == one.data.vec.x && full[i].data.vec.z == one.data.vec.z;
+        }
+        CHECK(same);
+
+        const int16_t raw[] = {-32768, -1, 0, 1, 256, 32767};
+        float scaled[6];
+        imu_q16_to_float(raw, scaled, 6, 8);
+        CHECK(scaled[0] == -128.0f && scaled[1] == -1.0f / 256.0f && scaled[2] == 0.0f);
+        CHECK(scaled[4] == 1.0f && scaled[5] == 32767.0f / 256.0f);
+
+        CHECK(imu_float_to_q16(1.0f / 1024.0f, 8) == 0);
+        CHECK(imu_float_to_q16(3.0f / 1024.0f, 8) == 1);
+        CHECK(imu_float_to_q16(-1e9f, 14) == -32768);
+    }
+
+    void inject_stream(uint32_t t0_us) {
+        bno08x_sim_sample_t accel, rv;
+        accel.report_id = SH2_ACCELEROMETER;
+        rv.report_id = SH2_ROTATION_VECTOR;
+        for (uint32_t i = 0; i < 20; i++) {
+            const float a = 0.05f * static_cast<float>(i);
+            accel.t_us = rv.t_us = t0_us + i * PERIOD_US;
+            accel.v[0] = 9.81f - a;
+            accel.v[1] = a * 0.333f;
+            accel.v[2] = -a;
+            rv.v[0] = -std::cos(a);    // the negative half, packing flips it
+            rv.v[1] = 0.0f;
+            rv.v[2] = 0.0f;
+            rv.v[3] = -std::sin(a);
+            bno08x_sim::inject(accel);
+            bno08x_sim::inject(rv);
+        }
+    }
+
+    void test_ring_drain() {
+        CHECK(imu_enable_rpt(SH2_ACCELEROMETER, PERIOD_US));
+        CHECK(imu_enable_rpt(SH2_ROTATION_VECTOR, PERIOD_US));
+        imu_sample_t full[64];
+        while (imu_sample_ring_drain(full, 64) > 0) {
+        }
+
+        // the same stream twice, drained once each way
+        inject_stream(0);
+        const size_t n_full = imu_sample_ring_drain(full, 64);
+        inject_stream(0);
+        imu_compact_sample_t compact[64];
+        const size_t n_compact = imu_sample_ring_drain_compact(compact, 64);
+        CHECK(n_full == 40);
+        CHECK(n_compact == n_full);
+
+        bool same = true;
+        for (size_t i = 0; i < n_full && i < n_compact; i++) {
+            imu_compact_sample_t packed;
+            imu_compact_pack(full[i], packed);
+            same &= same_record(packed, compact[i]);
+#if IMU_SAMPLE_RING_COMPACT
+            // the full drain is already quantized and on the positive half
+            if (full[i].report_id == SH2_ACCELEROMETER) {
+                same &= full[i].data.vec.y * 256.0f == std::round(full[i].data.vec.y * 256.0f);
+            } else {
+                same &= full[i].data.quat.real >= 0.0f;
+            }
+#endif
+        }
+        CHECK(same);
+
+        CHECK(imu_sample_ring_drain_compact(compact, 0) == 0);
+        CHECK(imu_sample_ring_drain_compact(nullptr, 64) == 0);
+        CHECK(imu_disable_all_rpts());
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_WARN);
+    if (!imu_init() || !imu_sample_ring_start()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    test_layout();
+    test_vec_round_trip();
+    test_quat_round_trip();
+    test_other_kinds();
+    test_batch_converters();
+    test_ring_drain();
+
+#if IMU_SAMPLE_RING_COMPACT
+    return test::result("imu_compact_ring_test");
+#else
+    return test::result("imu_compact_test");
+#endif
+}
@@ -0,0 +1,316 @@
+/**
+ * imu_dsp host test: the biquad designs have the gains they are named for
+ * (unity at DC for a low pass, zero for a high pass, -3 dB at the cutoff of a
+ * Butterworth cascade and its roll-off beyond), moving statistics match a
+ * double precision reference even for a small signal on 1 g, gravity removal
+ * leaves motion and drops the constant part, and decimation keeps one sample
+ * in factor with an alias suppressed. Every filter's block form gives the
+ * same output, bit for bit, as its one sample form over ragged block sizes,
+ * and imu_dsp_gather() fills blocks from mixed drained samples.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "imu_dsp.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr float PI = 3.14159265358979f;
+    constexpr float FS_HZ = 100.0f;
+
+    /// @brief Three axis test signal: per axis a different mix of tones, noise and offset
+    struct signal_t {
+        uint32_t rng = 99U;
+
+        float noise() {
+            rng = rng * 1664525U + 1013904223U;
+            return static_cast<float>(static_cast<int32_t>(rng >> 8) - (1 << 23)) / static_cast<float>(1 << 23);
+        }
+
+        void sample(size_t i, float v[IMU_DSP_AXES]) {
+            const float t = static_cast<float>(i) / FS_HZ;
+            v[0] = std::sin(2.0f * PI * 2.0f * t) + 0.2f * noise();
+            v[1] = 0.5f * std::sin(2.0f * PI * 17.0f * t) + 0.05f * noise();
+            v[2] = 9.81f + 0.01f * noise();
+        }
+    };
+
+    /// @brief Amplitude (from the RMS over whole cycles) of a single axis sine through a cascade, after it settles
+    float cascade_gain(const imu_dsp_biquad_t *stages, size_t n_stages, float f_hz) {
+        imu_dsp_cascade cascade;
+        cascade.configure(stages, n_stages);
+        double power = 0.0;
+        for (size_t i = 0; i < 4000; i++) {
+            float v[IMU_DSP_AXES] = {std::sin(2.0f * PI * f_hz * static_cast<float>(i) / FS_HZ), 0.0f, 0.0f};
+            cascade.process(v);
+            if (i >= 3000) {
+                power += v[0] * v[0];
+            }
+        }
+        return static_cast<float>(std::sqrt(2.0 * power / 1000.0));
+    }
+
+    /// @brief Block sizes that do not line up with the window or the decimation factor
+    const size_t RAGGED[] = {1, 7, IMU_DSP_BLOCK_LEN, 3, 29, IMU_DSP_BLOCK_LEN, 16, 0, 31};
+
+    /// @brief Feed the same signal through a one sample and a block filter, true if bit exact
+    template <typename ONE, typename BLOCK>
+    bool same_as_blocks(ONE one_sample, BLOCK block_form) {
+        signal_t sig_a, sig_b;
+        size_t i_a = 0, i_b = 0;
+        bool same = true;
+        for (size_t n : RAGGED) {
+            imu_dsp_block_t block = {};
+            for (size_t k = 0; k < n; k++, i_b++) {
+                float v[IMU_DSP_AXES];
+                sig_b.sample(i_b, v);
+                for (int a = 0; a < IMU_DSP_AXES; a++) {
+                    block.axis[a][k] = v[a];
+                }
+                block.t_us[k] = static_cast<uint32_t>(i_b * 10000UL);
+            }
+            block.n = n;
+            std::vector<std::vector<float>> expected;
+            for (size_t k = 0; k < n; k++, i_a++) {
+                float v[IMU_DSP_AXES];
+                sig_a.sample(i_a, v);
+                if (one_sample(v)) {
+                    expected.push_back({v[0], v[1], v[2], static_cast<float>(i_a)});
+                }
+            }
+            block_form(block);
+            same &= block.n == expected.size();
+            for (size_t k = 0; k < block.n && k < expected.size(); k++) {
+                for (int a = 0; a < IMU_DSP_AXES; a++) {
+                    same &= std::memcmp(&block.axis[a][k], &expected[k][a], sizeof(float)) == 0;
+                }
+                same &= block.t_us[k] == static_cast<uint32_t>(expected[k][3]) * 10000UL;
+            }
+        }
+        return same;
+    }
+
+    void test_design() {
+        imu_dsp_biquad_t c;
+        CHECK(!imu_dsp_lowpass(c, 0.0f, FS_HZ));
+        CHECK(!imu_dsp_lowpass(c, 50.0f, FS_HZ));
+        CHECK(!imu_dsp_lowpass(c, 10.0f, FS_HZ, 0.0f));
+        CHECK(!imu_dsp_highpass(c, 10.0f, 0.0f));
+
+        // DC gain (b0 + b1 + b2) / (1 + a1 + a2), Nyquist gain with alternating signs
+        CHECK(imu_dsp_lowpass(c, 10.0f, FS_HZ));
+        CHECK(std::fabs((c.b0 + c.b1 + c.b2) / (1.0f + c.a1 + c.a2) - 1.0f) < 1e-5f);
+        CHECK(std::fabs(c.b0 - c.b1 + c.b2) < 1e-6f);
+        CHECK(imu_dsp_highpass(c, 10.0f, FS_HZ));
+        CHECK(std::fabs(c.b0 + c.b1 + c.b2) < 1e-6f);
+        CHECK(std::fabs((c.b0 - c.b1 + c.b2) / (1.0f - c.a1 + c.a2) - 1.0f) < 1e-5f);
+
+        imu_dsp_biquad_t stages[IMU_DSP_MAX_STAGES + 1];
+        CHECK(!imu_dsp_butterworth_lowpass(stages, 0, 10.0f, FS_HZ));
+        CHECK(!imu_dsp_butterworth_lowpass(stages, IMU_DSP_MAX_STAGES + 1, 10.0f, FS_HZ));
+        imu_dsp_cascade cascade;
+        CHECK(!cascade.configure(stages, 0));
+        CHECK(!cascade.configure(nullptr, 2));
+    }
+
+    void test_butterworth_response() {
+        // 4th and 8th order at 10 Hz: flat in the pass band, -3 dB at the cutoff, 2N x 6 dB per octave after
+        for (size_t n_stages : {size_t{2}, size_t{4}}) {
+            imu_dsp_biquad_t stages[IMU_DSP_MAX_STAGES];
+            CHECK(imu_dsp_butterworth_lowpass(stages, n_stages, 10.0f, FS_HZ));
+            CHECK(std::fabs(cascade_gain(stages, n_stages, 1.0f) - 1.0f) < 0.01f);
+            CHECK(std::fabs(cascade_gain(stages, n_stages, 10.0f) - 0.7071f) < 0.01f);
+            // analog Butterworth at one octave, the bilinear transform only adds attenuation
+            const float octave = 1.0f / std::sqrt(1.0f + std::pow(2.0f, 4.0f * n_stages));
+            CHECK(cascade_gain(stages, n_stages, 20.0f) < octave * 1.1f);
+        }
+    }
+
+    void test_moving_stats() {
+        imu_dsp_moving_stats stats;
+        CHECK(!stats.configure(0));
+        CHECK(!stats.configure(IMU_DSP_MAX_WINDOW + 1));
+        CHECK(stats.configure(50));
+        float mean[IMU_DSP_AXES], var[IMU_DSP_AXES];
+        stats.current(mean, var);
+        CHECK(mean[0] == 0.0f && var[0] == 0.0f);
+
+        // against a double reference over the window, for longer than many rebases
+        signal_t sig;
+        std::vector<float> z;
+        double worst_mean = 0.0, worst_var = 0.0;
+        for (size_t i = 0; i < 2000; i++) {
+            float v[IMU_DSP_AXES];
+            sig.sample(i, v);
+            stats.process(v, mean, var);
+            z.push_back(v[2]);
+
+            const size_t from = (z.size() > 50) ? z.size() - 50 : 0;
+            double m = 0.0, q = 0.0;
+            for (size_t k = from; k < z.size(); k++) {
+                m += z[k];
+            }
+            m /= static_cast<double>(z.size() - from);
+            for (size_t k = from; k < z.size(); k++) {
+                q += (z[k] - m) * (z[k] - m);
+            }
+            q /= static_cast<double>(z.size() - from);
+            if (i >= 1) {
+                worst_mean = std::fmax(worst_mean, std::fabs(mean[2] - m));
+                worst_var = std::fmax(worst_var, std::fabs(var[2] - q) / q);
+            }
+        }
+        // variance of a +-0.01 signal on 9.81: about 3e-5, kept to a few percent
+        CHECK(worst_mean < 1e-5);
+        CHECK(worst_var < 0.05);
+        CHECK(stats.filled() == 50 && stats.window() == 50);
+
+        // the window just rebased (2000 is a multiple of 50), current() reads the recomputed sums
+        float now_mean[IMU_DSP_AXES], now_var[IMU_DSP_AXES];
+        stats.current(now_mean, now_var);
+        CHECK(std::fabs(now_mean[1] - mean[1]) < 1e-6f && std::fabs(now_var[1] - var[1]) < 1e-6f * var[1]);
+
+        stats.reset();
+        CHECK(stats.filled() == 0);
+    }
+
+    void test_gravity() {
+        imu_dsp_gravity_hp gravity;
+        CHECK(!gravity.configure(0.0f, FS_HZ));
+        CHECK(!gravity.configure(60.0f, FS_HZ));
+        CHECK(gravity.configure(0.3f, FS_HZ));
+
+        // tilted, still: nothing but zeros from the first sample on
+        float worst_still = 0.0f;
+        for (int i = 0; i < 100; i++) {
+            float v[IMU_DSP_AXES] = {0.0f, 4.9f, 8.5f};
+            gravity.process(v);
+            worst_still = std::fmax(worst_still, std::fabs(v[1]) + std::fabs(v[2]));
+        }
+        CHECK(worst_still == 0.0f);
+        CHECK(gravity.gravity()[2] == 8.5f);
+
+        // a 3 Hz motion on top passes, the estimate stays on the constant part
+        float peak = 0.0f;
+        for (int i = 0; i < 1000; i++) {
+            const float motion = std::sin(2.0f * PI * 3.0f * static_cast<float>(i) / FS_HZ);
+            float v[IMU_DSP_AXES] = {motion, 4.9f, 8.5f};
+            gravity.process(v);
+            if (i >= 500) {
+                peak = std::fmax(peak, std::fabs(v[0]));
+            }
+        }
+        CHECK(peak > 0.95f && peak < 1.05f);
+        // a one pole at 0.3 Hz lets about fc / f of the motion into the estimate
+        CHECK(std::fabs(gravity.gravity()[0]) < 0.15f && std::fabs(gravity.gravity()[2] - 8.5f) < 1e-4f);
+    }
+
+    void test_decimator() {
+        imu_dsp_decimator dec;
+        CHECK(!dec.configure(0, 400.0f));
+        CHECK(!dec.configure(4, 400.0f, 0));
+        CHECK(dec.configure(4, 400.0f, 4));
+
+        // 400 -> 100 Hz: 5 Hz passes, 90 Hz (an alias at 10 Hz) is gone
+        auto peak_out = [&dec](float f_hz) {
+            dec.reset();
+            float peak = 0.0f;
+            size_t kept = 0;
+            for (size_t i = 0; i < 4000; i++) {
+                float v[IMU_DSP_AXES] = {std::sin(2.0f * PI * f_hz * static_cast<float>(i) / 400.0f), 0.0f, 0.0f};
+                if (dec.process(v)) {
+                    kept++;
+                    if (i >= 2000) {
+                        peak = std::fmax(peak, std::fabs(v[0]));
+                    }
+                }
+            }
+            return (kept == 1000) ? peak : -1.0f;
+        };
+        CHECK(peak_out(5.0f) > 0.97f);
+        const float alias = peak_out(90.0f);
+        CHECK(alias >= 0.0f && alias < 0.01f);
+    }
+
+    void test_blocks_match_one_sample() {
+        imu_dsp_biquad_t stages[IMU_DSP_MAX_STAGES];
+        CHECK(imu_dsp_butterworth_lowpass(stages, IMU_DSP_MAX_STAGES, 8.0f, FS_HZ));
+        for (size_t n_stages = 1; n_stages <= IMU_DSP_MAX_STAGES; n_stages++) {
+            imu_dsp_cascade one, block;
+            one.configure(stages, n_stages);
+            block.configure(stages, n_stages);
+            CHECK(same_as_blocks([&one](float *v) { one.process(v); return true; },
+                                 [&block](imu_dsp_block_t &b) { block.process(b); }));
+        }
+
+        imu_dsp_gravity_hp g_one, g_block;
+        g_one.configure(0.3f, FS_HZ);
+        g_block.configure(0.3f, FS_HZ);
+        CHECK(same_as_blocks([&g_one](float *v) { g_one.process(v); return true; },
+                             [&g_block](imu_dsp_block_t &b) { g_block.process(b); }));
+
+        // window 20 rebases inside most blocks; checked for the mean and the variance output
+        for (bool want_var : {false, true}) {
+            imu_dsp_moving_stats s_one, s_block;
+            s_one.configure(20);
+            s_block.configure(20);
+            CHECK(same_as_blocks(
+                    [&s_one, want_var](float *v) {
+                        float mean[IMU_DSP_AXES], var[IMU_DSP_AXES];
+                        s_one.process(v, mean, var);
+                        std::memcpy(v, want_var ? var : mean, sizeof(mean));
+                        return true;
+                    },
+                    [&s_block, want_var](imu_dsp_block_t &b) {
+                        static imu_dsp_block_t out;
+                        s_block.process(b, want_var ? nullptr : &out, want_var ? &out : nullptr);
+                        b = out;
+                    }));
+        }
+
+        imu_dsp_decimator d_one, d_block;
+        d_one.configure(3, FS_HZ);
+        d_block.configure(3, FS_HZ);
+        CHECK(same_as_blocks([&d_one](float *v) { return d_one.process(v); },
+                             [&d_block](imu_dsp_block_t &b) { d_block.process(b); }));
+    }
+
+    void test_gather() {
+        constexpr size_t COUNT = 2 * IMU_DSP_BLOCK_LEN;
+        imu_sample_t drained[COUNT];
+        for (size_t i = 0; i < COUNT; i++) {
+            drained[i] = {};
+            drained[i].report_id = (i % 3 == 2) ? SH2_GYROSCOPE_CALIBRATED : SH2_ACCELEROMETER;
+            drained[i].timestamp_us = static_cast<uint32_t>(i);
+            drained[i].data.vec = {static_cast<float>(i), 0.0f, -static_cast<float>(i)};
+        }
+
+        // a third are gyro: all of it fits
+        imu_dsp_block_t block = {};
+        CHECK(imu_dsp_gather(drained, 30, SH2_ACCELEROMETER, block) == 30);
+        CHECK(block.n == 20);
+        CHECK(block.axis[0][2] == 3.0f && block.axis[2][2] == -3.0f && block.t_us[2] == 3);
+
+        // the block fills: consumed stops after the last sample that went in
+        const size_t used = imu_dsp_gather(drained + 30, COUNT - 30, SH2_ACCELEROMETER, block);
+        CHECK(block.n == IMU_DSP_BLOCK_LEN);
+        CHECK(used < COUNT - 30);
+        CHECK(block.t_us[IMU_DSP_BLOCK_LEN - 1] == 30 + used - 1);
+        CHECK(imu_dsp_gather(drained, 5, SH2_ACCELEROMETER, block) == 0);
+    }
+} // namespace
+
+int main() {
+    test_design();
+    test_butterworth_response();
+    test_moving_stats();
+    test_gravity();
+    test_decimator();
+    test_blocks_match_one_sample();
+    test_gather();
+
+    return test::result("imu_dsp_test");
+}
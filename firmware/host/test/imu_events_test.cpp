@@ -0,0 +1,159 @@
+/**
+ * imu_events host test: a task blocked in imu_wait_events() is woken by sig
+ * motion, shake and a stability change, each returning only its own bit and
+ * counting one wake in imu_get_wake_stats(); a repeated stability output
+ * posts nothing. Every event is timed from its own post: an event left
+ * pending while another is waited for keeps its stamp, a hub reset wake and
+ * a poll count no wake and consume no other event's stamp.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "imu_driver.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr uint32_t WAIT_MS = 1000;
+    constexpr uint32_t PENDING_MS = 50;
+
+    bool post(uint8_t report_id, float value = 1.0f) {
+        if (report_id == SH2_SIGNIFICANT_MOTION && !imu_rearm_sig_motion()) {
+            return false;
+        }
+        bno08x_sim_sample_t s;
+        s.report_id = report_id;
+        s.v[0] = value;
+        return bno08x_sim::inject(s);
+    }
+
+    struct waiter_t {
+        std::atomic<bool> running{false};
+        uint32_t events = 0;
+    };
+
+    void waiter_task(void *arg) {
+        waiter_t &w = *static_cast<waiter_t *>(arg);
+        w.running.store(true);
+        w.events = imu_wait_events(IMU_EVT_ALL | IMU_EVT_HUB_RESET, pdMS_TO_TICKS(WAIT_MS));
+        w.running.store(false);
+        vTaskDelete(nullptr);
+    }
+
+    /// @brief Post one event to a task already blocked on every event
+    uint32_t wake_with(uint8_t report_id, float value = 1.0f) {
+        static waiter_t w;
+        w.events = 0;
+        CHECK(xTaskCreatePinnedToCore(waiter_task, "waiter", 4096, &w, 5, nullptr, 0) == pdPASS);
+        while (!w.running.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        CHECK(post(report_id, value));
+        while (w.running.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return w.events;
+    }
+
+    void test_each_event() {
+        const struct {
+            uint8_t report_id;
+            float value;
+            uint32_t bit;
+        } cases[] = {
+            {SH2_SIGNIFICANT_MOTION, 1.0f, IMU_EVT_SIG_MOTION},
+            {SH2_SHAKE_DETECTOR, 1.0f, IMU_EVT_SHAKE},
+            {SH2_STABILITY_CLASSIFIER, static_cast<float>(BNO08xStability::STATIONARY), IMU_EVT_STABILITY_CHANGE},
+        };
+
+        for (const auto &c : cases) {
+            imu_reset_wake_stats();
+            CHECK(wake_with(c.report_id, c.value) == c.bit);
+            const imu_wake_stats_t stats = imu_get_wake_stats();
+            CHECK(stats.wakes == 1);
+            CHECK(stats.last_us == stats.max_us && stats.total_us == stats.last_us);
+            CHECK(stats.last_us < WAIT_MS * 1000UL);
+        }
+
+        // the same stability output again is not a change
+        imu_reset_wake_stats();
+        CHECK(post(SH2_STABILITY_CLASSIFIER, static_cast<float>(BNO08xStability::STATIONARY)));
+        CHECK(imu_wait_events(IMU_EVT_ALL, pdMS_TO_TICKS(PENDING_MS)) == 0);
+        CHECK(imu_get_wake_stats().wakes == 0);
+    }
+
+    void test_own_stamps() {
+        // a shake pending while sig motion is waited for keeps its own post time
+        imu_reset_wake_stats();
+        CHECK(post(SH2_SHAKE_DETECTOR));
+        std::this_thread::sleep_for(std::chrono::milliseconds(PENDING_MS));
+        CHECK(post(SH2_SIGNIFICANT_MOTION));
+        CHECK(imu_wait_events(IMU_EVT_SIG_MOTION, pdMS_TO_TICKS(WAIT_MS)) == IMU_EVT_SIG_MOTION);
+        imu_wake_stats_t stats = imu_get_wake_stats();
+        CHECK(stats.wakes == 1 && stats.last_us < PENDING_MS * 1000UL);
+        CHECK(imu_wait_events(IMU_EVT_SHAKE, pdMS_TO_TICKS(WAIT_MS)) == IMU_EVT_SHAKE);
+        stats = imu_get_wake_stats();
+        CHECK(stats.wakes == 2 && stats.last_us >= PENDING_MS * 1000UL && stats.max_us == stats.last_us);
+
+        // both returned by one wait: one wake each
+        imu_reset_wake_stats();
+        CHECK(post(SH2_SHAKE_DETECTOR));
+        CHECK(post(SH2_SIGNIFICANT_MOTION));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        CHECK(imu_wait_events(IMU_EVT_ALL, pdMS_TO_TICKS(WAIT_MS)) == (IMU_EVT_SIG_MOTION | IMU_EVT_SHAKE));
+        CHECK(imu_get_wake_stats().wakes == 2);
+
+        // a poll consumes the event without counting a wake
+        imu_reset_wake_stats();
+        CHECK(post(SH2_SHAKE_DETECTOR));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        CHECK(imu_wait_events(IMU_EVT_SHAKE, 0) == IMU_EVT_SHAKE);
+        CHECK(imu_get_wake_stats().wakes == 0);
+        CHECK(imu_wait_events(IMU_EVT_SHAKE, pdMS_TO_TICKS(PENDING_MS)) == 0);
+    }
+
+    void test_hub_reset() {
+        // a reset wake is not a motion wake and leaves the pending shake's stamp alone
+        imu_reset_wake_stats();
+        CHECK(post(SH2_SHAKE_DETECTOR));
+        std::this_thread::sleep_for(std::chrono::milliseconds(PENDING_MS));
+        CHECK(bno08x_sim::power_cycle());
+        CHECK(imu_wait_events(IMU_EVT_HUB_RESET, pdMS_TO_TICKS(WAIT_MS)) == IMU_EVT_HUB_RESET);
+        CHECK(imu_get_wake_stats().wakes == 0);
+        CHECK(imu_recover());
+
+        CHECK(imu_wait_events(IMU_EVT_SHAKE, pdMS_TO_TICKS(WAIT_MS)) == IMU_EVT_SHAKE);
+        const imu_wake_stats_t stats = imu_get_wake_stats();
+        CHECK(stats.wakes == 1 && stats.last_us >= PENDING_MS * 1000UL);
+
+        // and the replayed reports wake as before
+        imu_reset_wake_stats();
+        CHECK(wake_with(SH2_SHAKE_DETECTOR) == IMU_EVT_SHAKE);
+        CHECK(imu_get_wake_stats().wakes == 1);
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_NONE);
+    if (!imu_init()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+    CHECK(imu_events_start());
+    CHECK(imu_enable_rpt(SH2_SHAKE_DETECTOR, 100000UL));
+    CHECK(imu_enable_rpt(SH2_STABILITY_CLASSIFIER, 100000UL));
+
+    test_each_event();
+    test_own_stamps();
+    test_hub_reset();
+
+    CHECK(imu_disable_all_rpts());
+    return test::result("imu_events_test");
+}
@@ -0,0 +1,214 @@
+/**
+ * imu_frs host test: FRS records are read over the bus once and served from
+ * RAM after that. Typed setters stage a change; imu_frs_commit() writes every
+ * dirty record in one session and reads each back. A write the hub stored
+ * differently fails verification and stays dirty until a later commit
+ * succeeds. The typed records round trip through their Q24 / Q30 encodings,
+ * and a change equal to the cached record costs nothing.
+ */
+
+#include <cmath>
+#include <cstdio>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "imu_driver.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr float Q24_STEP = 1.0f / 16777216.0f;
+    constexpr float Q30_STEP = 1.0f / 1073741824.0f;
+
+    /// @brief FRS handshakes on the simulated bus since the last reset_stats()
+    uint32_t bus_transfers() {
+        const bno08x_sim_stats_t stats = bno08x_sim::stats();
+        return stats.frs_reads + stats.frs_writes;
+    }
+
+    void fresh_cache() {
+        imu_frs_invalidate_all();
+        imu_frs_cache_reset_stats();
+        bno08x_sim::reset_stats();
+    }
+
+    void test_hits_and_empty_records() {
+        // blank hub: every record empty
+        bno08x_sim::power_cycle(false);
+        CHECK(imu_init());
+        fresh_cache();
+
+        imu_orientation_t orientation;
+        CHECK(imu_get_system_orientation(orientation));
+        CHECK(orientation.real == 1.0f && orientation.i == 0.0f && orientation.j == 0.0f && orientation.k == 0.0f);
+        imu_frs_cache_stats_t stats = imu_frs_cache_get_stats();
+        CHECK(stats.misses == 1 && stats.hits == 0 && stats.bus_reads == 1);
+
+        // the empty record is cached too
+        CHECK(imu_get_system_orientation(orientation));
+        stats = imu_frs_cache_get_stats();
+        CHECK(stats.misses == 1 && stats.hits == 1);
+        CHECK(bus_transfers() == 1);
+
+        // the hub runs its defaults, there is nothing to decode
+        imu_stability_config_t stability;
+        CHECK(!imu_get_stability_config(stability));
+    }
+
+    void test_set_verify_and_round_trip() {
+        fresh_cache();
+
+        // main.cpp: read, write, read to verify, dump
+        imu_sig_motion_config_t sig;
+        CHECK(!imu_get_sig_motion_config(sig));
+        const imu_sig_motion_config_t wanted = {7.25f, 3};
+        CHECK(imu_set_sig_motion_config(wanted));
+        CHECK(imu_get_sig_motion_config(sig));
+        CHECK(sig.accel_threshold_ms2 == 7.25f && sig.step_threshold == 3);
+        imu_frs_dump(BNO08xFrsID::SIG_MOTION_DETECT_CONFIG);
+        // the miss, the write and its verify read
+        CHECK(bus_transfers() == 3);
+        imu_frs_cache_stats_t stats = imu_frs_cache_get_stats();
+        CHECK(stats.bus_writes == 1 && stats.commits == 1 && stats.verify_failures == 0);
+
+        // the same change again is dropped
+        CHECK(imu_set_sig_motion_config(wanted));
+        CHECK(bus_transfers() == 3);
+
+        // what reached the hub is what was asked for
+        uint32_t words[16];
+        uint16_t size = 0;
+        CHECK(imu_frs_read(BNO08xFrsID::SIG_MOTION_DETECT_CONFIG, words, size));
+        CHECK(size == 2 && words[0] == static_cast<uint32_t>(7.25f * 16777216.0f) && words[1] == 3);
+
+        // Q24 keeps the sign and rounds toward zero by less than one step
+        imu_stability_config_t stability = {-0.3f, 250000UL};
+        CHECK(imu_set_stability_config(stability));
+        imu_stability_config_t back;
+        CHECK(imu_get_stability_config(back));
+        CHECK(std::fabs(back.accel_threshold_ms2 - stability.accel_threshold_ms2) <= Q24_STEP);
+        CHECK(back.duration_us == 250000UL);
+
+        // Q30 quaternion, 90 degrees about Z
+        const imu_orientation_t rot = {0.70710677f, 0.0f, 0.0f, 0.70710677f};
+        CHECK(imu_set_system_orientation(rot));
+        imu_orientation_t rot_back;
+        CHECK(imu_get_system_orientation(rot_back));
+        CHECK(std::fabs(rot_back.real - rot.real) <= 64 * Q30_STEP);
+        CHECK(std::fabs(rot_back.k - rot.k) <= 64 * Q30_STEP);
+        CHECK(rot_back.i == 0.0f && rot_back.j == 0.0f);
+    }
+
+    void test_batched_commit() {
+        fresh_cache();
+        const imu_stability_config_t stability = {0.5f, 100000UL};
+        const imu_shake_config_t shake = {12.0f, 50000UL, 400000UL, 4, 0x7};
+        const imu_sig_motion_config_t sig = {9.0f, 5};
+
+        CHECK(imu_set_stability_config(stability, false));
+        CHECK(imu_set_shake_config(shake, false));
+        CHECK(imu_set_sig_motion_config(sig, false));
+        CHECK(imu_set_max_fusion_period(20000UL, false));
+        CHECK(imu_frs_dirty_count() == 4);
+        CHECK(bno08x_sim::stats().frs_writes == 0);
+
+        // staged values are what the getters return, still without touching the bus
+        const uint32_t before = bus_transfers();
+        imu_shake_config_t shake_back;
+        CHECK(imu_get_shake_config(shake_back));
+        CHECK(shake_back.accel_threshold_ms2 == 12.0f && shake_back.min_time_us == 50000UL &&
+              shake_back.max_time_us == 400000UL && shake_back.direction_changes == 4 && shake_back.enabled_axes == 0x7);
+        uint32_t period = 0;
+        CHECK(imu_get_max_fusion_period(period) && period == 20000UL);
+        CHECK(bus_transfers() == before);
+
+        // one session: four writes, four verify reads
+        CHECK(imu_frs_commit());
+        CHECK(imu_frs_dirty_count() == 0);
+        const imu_frs_cache_stats_t stats = imu_frs_cache_get_stats();
+        CHECK(stats.commits == 1);
+        CHECK(stats.bus_writes == 4);
+        CHECK(bno08x_sim::stats().frs_writes == 4);
+        CHECK(bno08x_sim::stats().frs_reads == 4);
+
+        // nothing dirty, nothing sent
+        CHECK(imu_frs_commit());
+        CHECK(imu_frs_cache_get_stats().commits == 1);
+    }
+
+    void test_verify_failure() {
+        fresh_cache();
+        bno08x_sim::corrupt_frs_writes(1);
+        CHECK(!imu_set_max_fusion_period(30000UL));
+        imu_frs_cache_stats_t stats = imu_frs_cache_get_stats();
+        CHECK(stats.verify_failures == 1);
+        CHECK(imu_frs_dirty_count() == 1);
+
+        // the next commit writes it again
+        CHECK(imu_frs_commit());
+        CHECK(imu_frs_dirty_count() == 0);
+        uint32_t words[16];
+        uint16_t size = 0;
+        CHECK(imu_frs_read(BNO08xFrsID::MAX_FUSION_PERIOD, words, size));
+        CHECK(size == 1 && words[0] == 30000UL);
+    }
+
+    void test_direct_access_and_eviction() {
+        fresh_cache();
+        uint32_t period = 0;
+        CHECK(imu_get_max_fusion_period(period));
+
+        // a direct write keeps the cached copy in step
+        uint32_t word = 40000UL;
+        CHECK(imu_frs_write(BNO08xFrsID::MAX_FUSION_PERIOD, &word, 1));
+        const uint32_t hits = imu_frs_cache_get_stats().hits;
+        CHECK(imu_get_max_fusion_period(period) && period == 40000UL);
+        CHECK(imu_frs_cache_get_stats().hits == hits + 1);
+
+        // an invalidated record is read again
+        imu_frs_invalidate(BNO08xFrsID::MAX_FUSION_PERIOD);
+        const uint32_t misses = imu_frs_cache_get_stats().misses;
+        CHECK(imu_get_max_fusion_period(period) && period == 40000UL);
+        CHECK(imu_frs_cache_get_stats().misses == misses + 1);
+
+        // one more record than slots: the least recently used one goes
+        const BNO08xFrsID ids[] = {
+            BNO08xFrsID::MAX_FUSION_PERIOD,
+            BNO08xFrsID::SYSTEM_ORIENTATION,
+            BNO08xFrsID::SIG_MOTION_DETECT_CONFIG,
+            BNO08xFrsID::SHAKE_DETECT_CONFIG,
+            BNO08xFrsID::STABILITY_DETECTOR_CONFIG,
+            BNO08xFrsID::TAP_DETECT_CONFIG,
+            BNO08xFrsID::ME_POWER_MGMT,
+            BNO08xFrsID::ACCEL_ORIENTATION,
+            BNO08xFrsID::GYROSCOPE_ORIENTATION,
+        };
+        static_assert(sizeof(ids) / sizeof(ids[0]) == IMU_FRS_CACHE_SLOTS + 1);
+        fresh_cache();
+        uint32_t data[16];
+        uint16_t size = 0;
+        for (BNO08xFrsID id : ids) {
+            CHECK(imu_frs_cached_read(id, data, size));
+        }
+        CHECK(imu_frs_cache_get_stats().evictions == 1);
+        CHECK(imu_frs_cached_read(ids[IMU_FRS_CACHE_SLOTS], data, size));
+        CHECK(imu_frs_cache_get_stats().hits == 1);
+        CHECK(imu_frs_cached_read(ids[0], data, size));
+        CHECK(imu_frs_cache_get_stats().misses == IMU_FRS_CACHE_SLOTS + 2);
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_NONE);
+    if (!imu_init()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    test_hits_and_empty_records();
+    test_set_verify_and_round_trip();
+    test_batched_commit();
+    test_verify_failure();
+    test_direct_access_and_eviction();
+
+    return test::result("imu_frs_test");
+}
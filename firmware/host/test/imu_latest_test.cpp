@@ -0,0 +1,193 @@
+/**
+ * imu_latest host test: the seqlock never hands out a torn value. A writer
+ * thread publishes records whose words all carry the write number while
+ * reader threads copy them; every copy must be self consistent, carry the
+ * sequence it was returned with and never go backwards. Through the driver,
+ * imu_latest_read() / imu_latest_read_new() follow the injected samples,
+ * keep only the newest and stay consistent against a concurrent stream.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "imu_driver.hpp"
+#include "imu_seqlock.hpp"
+#include "test_check.hpp"
+
+namespace {
+    struct record_t {
+        uint32_t words[7];
+    };
+
+    void test_empty_and_single() {
+        static imu_seqlock<record_t> lock;
+        record_t r = {};
+        CHECK(lock.sequence() == 0);
+        CHECK(lock.read(r) == 0);
+
+        record_t w;
+        for (uint32_t &word : w.words) {
+            word = 42;
+        }
+        lock.write(w);
+        CHECK(lock.sequence() == 1);
+        CHECK(lock.read(r) == 1);
+        CHECK(r.words[0] == 42 && r.words[6] == 42);
+    }
+
+    void test_concurrent_readers() {
+        static imu_seqlock<record_t> lock;
+        constexpr uint32_t WRITES = 1000000;
+        constexpr int READERS = 3;
+        std::atomic<bool> done{false};
+        std::atomic<uint32_t> torn{0};
+        std::atomic<uint32_t> mismatched{0};
+        std::atomic<uint32_t> backwards{0};
+        std::atomic<uint32_t> reads{0};
+
+        std::thread readers[READERS];
+        for (std::thread &reader : readers) {
+            reader = std::thread([&]() {
+                uint32_t last = 0;
+                record_t r;
+                while (!done.load(std::memory_order_relaxed)) {
+                    const uint32_t seq = lock.read(r);
+                    for (uint32_t word : r.words) {
+                        if (seq != 0 && word != r.words[0]) {
+                            torn++;
+                            break;
+                        }
+                    }
+                    // write k stores k in every word and completes sequence k
+                    if (seq != 0 && r.words[0] != seq) {
+                        mismatched++;
+                    }
+                    if (seq < last) {
+                        backwards++;
+                    }
+                    last = seq;
+                    reads++;
+                }
+            });
+        }
+
+        record_t w;
+        for (uint32_t k = 1; k <= WRITES; k++) {
+            for (uint32_t &word : w.words) {
+                word = k;
+            }
+            lock.write(w);
+        }
+        done.store(true);
+        for (std::thread &reader : readers) {
+            reader.join();
+        }
+
+        CHECK(torn.load() == 0);
+        CHECK(mismatched.load() == 0);
+        CHECK(backwards.load() == 0);
+        CHECK(reads.load() > 0);
+        CHECK(lock.sequence() == WRITES);
+    }
+
+    void test_driver_cache() {
+        CHECK(imu_latest_start());
+        CHECK(imu_enable_rpt(SH2_ACCELEROMETER, 2500UL));
+
+        imu_sample_t s;
+        CHECK(imu_latest_read(SH2_PRESSURE, s) == 0);
+        CHECK(imu_latest_seq(SH2_GYROSCOPE_CALIBRATED) == 0);
+
+        bno08x_sim_sample_t accel;
+        accel.report_id = SH2_ACCELEROMETER;
+        accel.v[0] = 1.0f;
+        accel.v[1] = 2.0f;
+        accel.v[2] = 3.0f;
+        const uint32_t base = imu_latest_seq(SH2_ACCELEROMETER);
+        CHECK(bno08x_sim::inject(accel));
+        CHECK(imu_latest_read(SH2_ACCELEROMETER, s) == base + 1);
+        CHECK(s.report_id == SH2_ACCELEROMETER && s.data.vec.x == 1.0f && s.data.vec.z == 3.0f);
+
+        // non-destructive new-data check, one success per new sample
+        uint32_t cursor = 0;
+        CHECK(imu_latest_read_new(SH2_ACCELEROMETER, s, cursor));
+        CHECK(cursor == base + 1);
+        CHECK(!imu_latest_read_new(SH2_ACCELEROMETER, s, cursor));
+
+        // only the newest of several is kept
+        for (int i = 0; i < 5; i++) {
+            accel.v[0] = 10.0f + i;
+            CHECK(bno08x_sim::inject(accel));
+        }
+        CHECK(imu_latest_read_new(SH2_ACCELEROMETER, s, cursor));
+        CHECK(cursor == base + 6);
+        CHECK(s.data.vec.x == 14.0f);
+        CHECK(!imu_latest_read_new(SH2_ACCELEROMETER, s, cursor));
+    }
+
+    void test_driver_concurrent() {
+        constexpr uint32_t SAMPLES = 200000;
+        std::atomic<bool> done{false};
+        std::atomic<uint32_t> torn{0};
+        std::atomic<uint32_t> backwards{0};
+
+        std::thread readers[2];
+        for (std::thread &reader : readers) {
+            reader = std::thread([&]() {
+                uint32_t last = 0;
+                imu_sample_t s;
+                while (!done.load(std::memory_order_relaxed)) {
+                    const uint32_t seq = imu_latest_read(SH2_ACCELEROMETER, s);
+                    if (s.data.vec.x != s.data.vec.y || s.data.vec.y != s.data.vec.z) {
+                        torn++;
+                    }
+                    if (seq < last) {
+                        backwards++;
+                    }
+                    last = seq;
+                }
+            });
+        }
+
+        bno08x_sim_sample_t accel;
+        accel.report_id = SH2_ACCELEROMETER;
+        for (uint32_t i = 0; i < SAMPLES; i++) {
+            const float v = static_cast<float>(i);
+            accel.t_us = i * 2500UL;
+            accel.v[0] = v;
+            accel.v[1] = v;
+            accel.v[2] = v;
+            bno08x_sim::inject(accel);
+        }
+        done.store(true);
+        for (std::thread &reader : readers) {
+            reader.join();
+        }
+
+        CHECK(torn.load() == 0);
+        CHECK(backwards.load() == 0);
+        imu_sample_t s;
+        imu_latest_read(SH2_ACCELEROMETER, s);
+        CHECK(s.data.vec.x == static_cast<float>(SAMPLES - 1));
+
+        CHECK(imu_disable_all_rpts());
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_WARN);
+    if (!imu_init()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    test_empty_and_single();
+    test_concurrent_readers();
+    test_driver_cache();
+    test_driver_concurrent();
+
+    return test::result("imu_latest_test");
+}
@@ -0,0 +1,239 @@
+/**
+ * imu_metrics host test: a metrics slot fed with synthetic arrival times
+ * reports the exact count, interval range, effective rate and jitter, counts
+ * a gap only past IMU_METRICS_GAP_PCT of the requested period (with the
+ * samples lost inside it), sorts callback durations into their log2 buckets
+ * and applies a reset on the next sample. Through the driver, a paced stream
+ * with withheld samples shows the gap, batched reports are not held to a
+ * period, and the binary snapshot follows the layout in imu_metrics.hpp.
+ *
+ * Also built with IMU_METRICS_ENABLED=0 (imu_metrics_off): the API then
+ * reports nothing.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "imu_driver.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr uint32_t PERIOD_US = 10000UL;
+
+    void feed(imu_rpt_metrics_slot &slot, uint32_t &t_us, uint32_t interval_us, uint32_t count, uint32_t period_us) {
+        for (uint32_t i = 0; i < count; i++) {
+            t_us += interval_us;
+            slot.on_sample(t_us, period_us);
+        }
+    }
+
+    void test_slot_intervals() {
+        static imu_rpt_metrics_slot slot;
+        imu_rpt_metrics_t m;
+        uint32_t t_us = 0;
+
+        slot.read(m);
+        CHECK(m.received == 0 && imu_metrics_rate_hz(m) == 0.0f);
+
+        // a steady 100 Hz stream
+        feed(slot, t_us, PERIOD_US, 101, PERIOD_US);
+        slot.read(m);
+        CHECK(m.received == 101);
+        CHECK(m.interval_min_us == PERIOD_US && m.interval_max_us == PERIOD_US);
+        CHECK(m.interval_avg_q4 == PERIOD_US * 16);
+        CHECK(imu_metrics_rate_hz(m) == 100.0f);
+        CHECK(m.jitter_q4 == 0);
+        CHECK(m.gaps == 0 && m.missed == 0);
+
+        // exactly 150 % is late, not a gap; one microsecond more is a gap with one sample lost
+        feed(slot, t_us, PERIOD_US * 3 / 2, 1, PERIOD_US);
+        slot.read(m);
+        CHECK(m.gaps == 0);
+        feed(slot, t_us, PERIOD_US * 3 / 2 + 1, 1, PERIOD_US);
+        slot.read(m);
+        CHECK(m.gaps == 1 && m.missed == 1);
+
+        // three samples withheld
+        feed(slot, t_us, 4 * PERIOD_US, 1, PERIOD_US);
+        slot.read(m);
+        CHECK(m.gaps == 2 && m.missed == 4);
+        CHECK(m.interval_max_us == 4 * PERIOD_US);
+
+        // without a requested period nothing is a gap
+        feed(slot, t_us, 100 * PERIOD_US, 1, 0);
+        slot.read(m);
+        CHECK(m.gaps == 2 && m.missed == 4);
+        CHECK(m.received == 105);
+    }
+
+    void test_slot_jitter_and_reset() {
+        static imu_rpt_metrics_slot slot;
+        imu_rpt_metrics_t m;
+        uint32_t t_us = 0;
+
+        // +-1 ms around 10 ms: the average settles on the period, the jitter on 1 ms
+        slot.on_sample(t_us, PERIOD_US);
+        for (int i = 0; i < 200; i++) {
+            feed(slot, t_us, PERIOD_US - 1000, 1, PERIOD_US);
+            feed(slot, t_us, PERIOD_US + 1000, 1, PERIOD_US);
+        }
+        slot.read(m);
+        CHECK(m.interval_min_us == PERIOD_US - 1000 && m.interval_max_us == PERIOD_US + 1000);
+        CHECK(imu_metrics_rate_hz(m) > 99.0f && imu_metrics_rate_hz(m) < 101.0f);
+        CHECK(imu_metrics_jitter_us(m) > 900.0f && imu_metrics_jitter_us(m) < 1100.0f);
+
+        // a reset reads as zero at once and is applied by the next sample, which starts a new interval chain
+        slot.request_reset();
+        slot.read(m);
+        CHECK(m.received == 0 && m.interval_max_us == 0);
+        t_us += 1000000UL;
+        slot.on_sample(t_us, PERIOD_US);
+        slot.read(m);
+        CHECK(m.received == 1 && m.gaps == 0 && m.interval_max_us == 0);
+        feed(slot, t_us, PERIOD_US, 1, PERIOD_US);
+        slot.read(m);
+        CHECK(m.received == 2 && m.interval_min_us == PERIOD_US && m.interval_max_us == PERIOD_US);
+    }
+
+    void test_slot_histogram() {
+        static imu_rpt_metrics_slot slot;
+        imu_rpt_metrics_t m;
+        const uint32_t cycles[] = {0, 255, 256, 511, 512, 1UL << 18, 1UL << 30};
+        for (uint32_t c : cycles) {
+            slot.on_callback(c);
+        }
+        slot.read(m);
+        CHECK(m.cb_hist[0] == 2);
+        CHECK(m.cb_hist[1] == 2);
+        CHECK(m.cb_hist[2] == 1);
+        CHECK(m.cb_hist[11] == 2);
+        CHECK(m.cb_max_cycles == 1UL << 30);
+
+        CHECK(imu_metrics_bucket_limit_cycles(0) == 256);
+        CHECK(imu_metrics_bucket_limit_cycles(1) == 512);
+        CHECK(imu_metrics_bucket_limit_cycles(IMU_METRICS_HIST_BUCKETS - 1) == 0);
+    }
+
+    void inject_paced(uint8_t report_id, uint32_t count, uint32_t skip_from, uint32_t skip_count) {
+        bno08x_sim_sample_t sample;
+        sample.report_id = report_id;
+        for (uint32_t i = 0; i < count + skip_count; i++) {
+            if (i < skip_from || i >= skip_from + skip_count) {
+                sample.t_us = i * PERIOD_US;
+                bno08x_sim::inject(sample);
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(PERIOD_US));
+        }
+    }
+
+#if IMU_METRICS_ENABLED
+    void test_driver() {
+        CHECK(imu_enable_rpt(SH2_ACCELEROMETER, PERIOD_US));
+        CHECK(imu_enable_rpt_batched(SH2_GYROSCOPE_CALIBRATED, PERIOD_US, 20 * PERIOD_US));
+        imu_metrics_reset();
+        const uint32_t cycles_before = imu_metrics_cb_cycles();
+
+        // four accel samples withheld mid stream
+        inject_paced(SH2_ACCELEROMETER, 30, 15, 4);
+        imu_rpt_metrics_t m;
+        CHECK(imu_metrics_get(SH2_ACCELEROMETER, m));
+        CHECK(m.received == 30);
+        CHECK(m.gaps >= 1);
+        CHECK(m.missed >= 4);
+        CHECK(m.interval_max_us >= 5 * PERIOD_US);
+        uint32_t timed = 0;
+        for (uint32_t count : m.cb_hist) {
+            timed += count;
+        }
+        CHECK(timed == m.received);
+        CHECK(imu_metrics_cb_cycles() != cycles_before);
+
+        // a batched report arrives in bursts, it has no period to miss
+        inject_paced(SH2_GYROSCOPE_CALIBRATED, 30, 10, 10);
+        CHECK(imu_flush_rpts());
+        CHECK(imu_metrics_get(SH2_GYROSCOPE_CALIBRATED, m));
+        CHECK(m.received == 30);
+        CHECK(m.gaps == 0);
+
+        CHECK(!imu_metrics_get(SH2_MAX_SENSOR_ID + 1, m));
+        CHECK(imu_disable_all_rpts());
+    }
+
+    uint32_t u32_at(const uint8_t *p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    uint16_t u16_at(const uint8_t *p) {
+        uint16_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    void test_snapshot() {
+        static uint8_t buf[IMU_METRICS_SNAPSHOT_MAX];
+        const size_t len = imu_metrics_snapshot(buf, sizeof(buf));
+        constexpr size_t RECORD_SZ = 4 + sizeof(imu_rpt_metrics_t);
+        CHECK(len == 20 + 2 * RECORD_SZ);
+        CHECK(u32_at(buf) == IMU_METRICS_MAGIC);
+        CHECK(u16_at(buf + 4) == IMU_METRICS_VERSION);
+        CHECK(buf[6] == IMU_METRICS_HIST_BUCKETS && buf[7] == IMU_METRICS_HIST_SHIFT);
+        CHECK(u32_at(buf + 8) == esp_rom_get_cpu_ticks_per_us());
+        CHECK(u16_at(buf + 16) == 2);
+        CHECK(u16_at(buf + 18) == RECORD_SZ);
+
+        // records in report ID order, each the same words imu_metrics_get() returns
+        if (len == 20 + 2 * RECORD_SZ) {
+            const uint8_t ids[2] = {SH2_ACCELEROMETER, SH2_GYROSCOPE_CALIBRATED};
+            for (size_t r = 0; r < 2; r++) {
+                const uint8_t *record = buf + 20 + r * RECORD_SZ;
+                imu_rpt_metrics_t m;
+                CHECK(record[0] == ids[r]);
+                CHECK(imu_metrics_get(ids[r], m));
+                CHECK(std::memcmp(record + 4, &m, sizeof(m)) == 0);
+            }
+        }
+
+        CHECK(imu_metrics_snapshot(buf, 20 + RECORD_SZ) == 0);
+        CHECK(imu_metrics_snapshot(buf, 19) == 0);
+    }
+#else
+    void test_compiled_out() {
+        CHECK(imu_enable_rpt(SH2_ACCELEROMETER, PERIOD_US));
+        inject_paced(SH2_ACCELEROMETER, 5, 0, 0);
+
+        imu_rpt_metrics_t m;
+        CHECK(!imu_metrics_get(SH2_ACCELEROMETER, m));
+        CHECK(imu_metrics_cb_cycles() == 0);
+        static uint8_t buf[IMU_METRICS_SNAPSHOT_MAX];
+        CHECK(imu_metrics_snapshot(buf, sizeof(buf)) == 0);
+        CHECK(imu_disable_all_rpts());
+    }
+#endif
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_WARN);
+    if (!imu_init() || !imu_latest_start()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    test_slot_intervals();
+    test_slot_jitter_and_reset();
+    test_slot_histogram();
+#if IMU_METRICS_ENABLED
+    test_driver();
+    test_snapshot();
+    return test::result("imu_metrics_test");
+#else
+    test_compiled_out();
+    return test::result("imu_metrics_off_test");
+#endif
+}
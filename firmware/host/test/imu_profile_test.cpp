@@ -0,0 +1,154 @@
+/**
+ * imu_profile host test: imu_apply_rpt_profile() sends only the difference
+ * between the live set and the profile. Re-applying a profile sends nothing,
+ * a period or config change is one set-feature without a disable, reports
+ * left out are disabled, one-shot reports are always re-sent, and a report
+ * that is unchanged keeps streaming through the switch.
+ */
+
+#include <cstdio>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "imu_driver.hpp"
+#include "test_check.hpp"
+
+namespace {
+    uint32_t commands() {
+        return bno08x_sim::stats().set_feature_cmds;
+    }
+
+    bool diff_is(const imu_reconfig_stats_t &d, uint8_t enabled, uint8_t changed, uint8_t disabled,
+            uint8_t unchanged) {
+        return d.enabled == enabled && d.changed == changed && d.disabled == disabled && d.unchanged == unchanged;
+    }
+
+    size_t drain_accel() {
+        imu_sample_t out[32];
+        size_t accel = 0;
+        size_t n;
+        while ((n = imu_sample_ring_drain(out, 32)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                accel += out[i].report_id == SH2_ACCELEROMETER;
+            }
+        }
+        return accel;
+    }
+
+    void test_diff() {
+        const imu_report_cfg_t a[] = {
+            {SH2_ACCELEROMETER, 10000UL},
+            {SH2_GYROSCOPE_CALIBRATED, 10000UL},
+            {SH2_ROTATION_VECTOR, 20000UL},
+        };
+        imu_reconfig_stats_t diff;
+
+        uint32_t before = commands();
+        CHECK(imu_apply_rpt_profile(a, 3, &diff));
+        CHECK(diff_is(diff, 3, 0, 0, 0));
+        CHECK(commands() == before + 3);
+        CHECK(imu_get_enabled_rpts() == (IMU_RPT_BIT(SH2_ACCELEROMETER) | IMU_RPT_BIT(SH2_GYROSCOPE_CALIBRATED) |
+                                         IMU_RPT_BIT(SH2_ROTATION_VECTOR)));
+
+        // the same profile again costs nothing
+        before = commands();
+        CHECK(imu_apply_rpt_profile(a, 3, &diff));
+        CHECK(diff_is(diff, 0, 0, 0, 3));
+        CHECK(commands() == before);
+
+        // gyro faster, rotation vector dropped, magnetometer added, accel untouched
+        const imu_report_cfg_t b[] = {
+            {SH2_ACCELEROMETER, 10000UL},
+            {SH2_GYROSCOPE_CALIBRATED, 5000UL},
+            {SH2_MAGNETIC_FIELD_CALIBRATED, 20000UL},
+        };
+        bno08x_sim_sample_t accel;
+        accel.report_id = SH2_ACCELEROMETER;
+        CHECK(bno08x_sim::inject(accel));
+        drain_accel();
+
+        before = commands();
+        CHECK(imu_apply_rpt_profile(b, 3, &diff));
+        CHECK(diff_is(diff, 1, 1, 1, 1));
+        CHECK(commands() == before + 3);
+        CHECK(imu_get_enabled_rpts() == (IMU_RPT_BIT(SH2_ACCELEROMETER) | IMU_RPT_BIT(SH2_GYROSCOPE_CALIBRATED) |
+                                         IMU_RPT_BIT(SH2_MAGNETIC_FIELD_CALIBRATED)));
+        imu_report_cfg_t live;
+        CHECK(imu_get_rpt_cfg(SH2_GYROSCOPE_CALIBRATED, live) && live.period_us == 5000UL);
+
+        // accel was never touched, its callback still delivers
+        CHECK(bno08x_sim::inject(accel));
+        CHECK(drain_accel() == 1);
+
+        // a config change at the same period is a change
+        imu_report_cfg_t c[3] = {b[0], b[1], b[2]};
+        c[0].config.changeSensitivityEnabled = true;
+        c[0].config.changeSensitivity = 50;
+        before = commands();
+        CHECK(imu_apply_rpt_profile(c, 3, &diff));
+        CHECK(diff_is(diff, 0, 1, 0, 2));
+        CHECK(commands() == before + 1);
+
+        // so is a batch latency
+        c[0].batch_us = 100000UL;
+        CHECK(imu_apply_rpt_profile(c, 3, &diff));
+        CHECK(diff_is(diff, 0, 1, 0, 2));
+        CHECK(imu_get_rpt_cfg(SH2_ACCELEROMETER, live) && live.batch_us == 100000UL);
+
+        // an empty profile disables everything
+        before = commands();
+        CHECK(imu_apply_rpt_profile(nullptr, 0, &diff));
+        CHECK(diff_is(diff, 0, 0, 3, 0));
+        CHECK(commands() == before + 3);
+        CHECK(imu_get_enabled_rpts() == 0);
+    }
+
+    void test_one_shot_and_errors() {
+        const imu_report_cfg_t sleep[] = {{SH2_SIGNIFICANT_MOTION, 100000UL}};
+        imu_reconfig_stats_t diff;
+        CHECK(imu_apply_rpt_profile(sleep, 1, &diff));
+        CHECK(diff_is(diff, 1, 0, 0, 0));
+
+        // the hub may have retired the one-shot since, it is re-armed every time
+        const uint32_t before = commands();
+        CHECK(imu_apply_rpt_profile(sleep, 1, &diff));
+        CHECK(diff_is(diff, 0, 1, 0, 0));
+        CHECK(commands() == before + 1);
+
+        // an unknown ID fails the call, the rest of the profile still applies
+        const imu_report_cfg_t bad[] = {
+            {static_cast<sh2_SensorId_t>(SH2_PRESSURE), 10000UL},
+            {SH2_ACCELEROMETER, 10000UL},
+        };
+        CHECK(!imu_apply_rpt_profile(bad, 2, &diff));
+        CHECK(imu_get_enabled_rpts() == IMU_RPT_BIT(SH2_ACCELEROMETER));
+
+        // a rejected set-feature is reported and the report stays off
+        const imu_report_cfg_t two[] = {
+            {SH2_ACCELEROMETER, 10000UL},
+            {SH2_GYROSCOPE_CALIBRATED, 10000UL},
+        };
+        bno08x_sim::reject_commands(1);
+        CHECK(!imu_apply_rpt_profile(two, 2, &diff));
+        CHECK(imu_get_enabled_rpts() == IMU_RPT_BIT(SH2_ACCELEROMETER));
+
+        // and the next apply retries it
+        CHECK(imu_apply_rpt_profile(two, 2, &diff));
+        CHECK(diff_is(diff, 1, 0, 0, 1));
+
+        CHECK(imu_disable_all_rpts());
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_NONE);
+    if (!imu_init() || !imu_sample_ring_start()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    test_diff();
+    test_one_shot_and_errors();
+
+    return test::result("imu_profile_test");
+}
@@ -0,0 +1,176 @@
+/**
+ * imu_recovery host test: after every kind of hub reset the driver puts the
+ * hub back to the configuration the application asked for, periods and
+ * dynamic calibration included, with one set-feature per wanted report. A
+ * requested reset replays before it returns; a reset nobody asked for is
+ * counted as unexpected and replayed by imu_recover(), several of them by
+ * one replay. A late reset message fails the request and is then replayed
+ * like an unexpected one, a lost one is found by imu_hub_check() once the
+ * reports have been silent IMU_HUB_SILENT_MS, and a command the hub rejects
+ * keeps the reset pending until a later imu_recover() sends what is missing.
+ */
+
+#include <cstdio>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "imu_driver.hpp"
+#include "test_check.hpp"
+
+namespace {
+    imu_report_cfg_t WANTED[] = {
+        {SH2_ACCELEROMETER, 2500UL},
+        {SH2_GYROSCOPE_CALIBRATED, 5000UL},
+        {SH2_ROTATION_VECTOR, 10000UL},
+        {SH2_STABILITY_CLASSIFIER, 1000000UL},
+    };
+    constexpr uint32_t N_WANTED = sizeof(WANTED) / sizeof(WANTED[0]);
+    const uint8_t CAL_SENSORS = static_cast<uint8_t>(BNO08xCalSel::accelerometer) |
+                                static_cast<uint8_t>(BNO08xCalSel::gyro);
+
+    uint64_t wanted_mask() {
+        uint64_t mask = 0;
+        for (const imu_report_cfg_t &r : WANTED) {
+            mask |= IMU_RPT_BIT(r.report_id);
+        }
+        return mask;
+    }
+
+    /// @brief The hub runs the wanted reports at the wanted periods
+    bool hub_restored() {
+        bool ok = imu_get_enabled_rpts() == wanted_mask() && imu_get_desired_rpts() == wanted_mask();
+        for (const imu_report_cfg_t &r : WANTED) {
+            imu_report_cfg_t live;
+            ok &= imu_get_rpt_cfg(r.report_id, live) && live.period_us == r.period_us;
+        }
+        return ok;
+    }
+
+    bool inject_accel() {
+        bno08x_sim_sample_t s;
+        s.report_id = SH2_ACCELEROMETER;
+        s.v[2] = 9.81f;
+        return bno08x_sim::inject(s);
+    }
+
+    void test_requested() {
+        imu_recovery_reset_stats();
+        bno08x_sim::reset_stats();
+
+        CHECK(imu_hard_reset());
+        imu_recovery_stats_t st = imu_recovery_get_stats();
+        CHECK(st.resets == 1 && st.unexpected == 0 && st.replays == 1 && st.failed == 0);
+        // one set-feature per report plus the calibration command, never a disable
+        CHECK(st.commands == N_WANTED + 1);
+        CHECK(bno08x_sim::stats().set_feature_cmds == N_WANTED);
+        CHECK(hub_restored());
+        CHECK(bno08x_sim::cal_config() == CAL_SENSORS);
+        CHECK(inject_accel());
+
+        // already replayed: nothing to do
+        CHECK(!imu_recover());
+
+        CHECK(imu_soft_reset());
+        st = imu_recovery_get_stats();
+        CHECK(st.resets == 2 && st.unexpected == 0 && st.replays == 2);
+        CHECK(hub_restored());
+    }
+
+    void test_unexpected() {
+        imu_recovery_reset_stats();
+
+        // the hub comes back running nothing, the event is posted for the recovering task
+        imu_wait_events(IMU_EVT_HUB_RESET, 0);
+        CHECK(bno08x_sim::power_cycle(true));
+        CHECK(imu_get_enabled_rpts() == 0 && imu_get_desired_rpts() == wanted_mask());
+        CHECK(!inject_accel());
+        CHECK(imu_wait_events(IMU_EVT_HUB_RESET, 0) == IMU_EVT_HUB_RESET);
+        CHECK(imu_recover());
+        CHECK(hub_restored());
+        CHECK(bno08x_sim::cal_config() == CAL_SENSORS);
+        CHECK(inject_accel());
+
+        // two resets before the task runs cost one replay
+        CHECK(bno08x_sim::power_cycle(true));
+        CHECK(bno08x_sim::power_cycle(true));
+        CHECK(imu_recover());
+        CHECK(!imu_recover());
+        const imu_recovery_stats_t st = imu_recovery_get_stats();
+        CHECK(st.resets == 3 && st.unexpected == 3 && st.silent == 0 && st.replays == 2);
+        CHECK(st.commands == 2 * (N_WANTED + 1));
+        CHECK(st.max_us >= st.last_us && st.lost >= st.last_lost);
+        CHECK(hub_restored());
+    }
+
+    void test_late_and_lost_message() {
+        imu_recovery_reset_stats();
+
+        // a message later than IMU_HUB_BOOT_MAX_MS fails the request, then replays as unexpected
+        bno08x_sim::set_reset_message_delay((IMU_HUB_BOOT_MAX_MS + 100) * 1000UL);
+        CHECK(!imu_hard_reset());
+        vTaskDelay(pdMS_TO_TICKS(200));
+        CHECK(imu_recover());
+        imu_recovery_stats_t st = imu_recovery_get_stats();
+        CHECK(st.resets == 1 && st.unexpected == 1 && st.replays == 1);
+        CHECK(hub_restored());
+
+        // lost: the driver still thinks the reports run, only their silence tells
+        bno08x_sim::set_reset_message_delay(BNO08X_SIM_RESET_MSG_LOST);
+        CHECK(inject_accel());
+        CHECK(bno08x_sim::power_cycle(true));
+        CHECK(imu_get_enabled_rpts() == wanted_mask());
+        CHECK(!inject_accel());
+        CHECK(!imu_hub_check());
+        vTaskDelay(pdMS_TO_TICKS(IMU_HUB_SILENT_MS + 100));
+        CHECK(imu_hub_check());
+        CHECK(imu_recover());
+        st = imu_recovery_get_stats();
+        CHECK(st.resets == 2 && st.unexpected == 2 && st.silent == 1 && st.replays == 2);
+        CHECK(hub_restored());
+        CHECK(inject_accel());
+        CHECK(!imu_hub_check());
+
+        bno08x_sim::set_reset_message_delay(0);
+    }
+
+    void test_rejected_command() {
+        imu_recovery_reset_stats();
+
+        // the first enable of the replay fails, the rest go through
+        bno08x_sim::reject_commands(1);
+        CHECK(bno08x_sim::power_cycle(true));
+        CHECK(imu_recover());
+        imu_recovery_stats_t st = imu_recovery_get_stats();
+        CHECK(st.failed == 1 && st.commands == N_WANTED + 1);
+        CHECK(__builtin_popcountll(imu_get_enabled_rpts()) == N_WANTED - 1);
+
+        // still pending: only the missing report and the calibration are sent again
+        CHECK(imu_recover());
+        st = imu_recovery_get_stats();
+        CHECK(st.replays == 2 && st.failed == 1 && st.commands == N_WANTED + 1 + 2);
+        CHECK(hub_restored());
+        CHECK(!imu_recover());
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_NONE);
+    if (!imu_init()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+    CHECK(imu_events_start());
+    CHECK(imu_enable_multi_rpts(WANTED, N_WANTED));
+    CHECK(imu_set_dynamic_calibration(CAL_SENSORS));
+
+    test_requested();
+    test_unexpected();
+    test_late_and_lost_message();
+    test_rejected_command();
+
+    CHECK(imu_set_dynamic_calibration(static_cast<uint8_t>(BNO08xCalSel::all)));
+    CHECK(imu_disable_all_rpts());
+    return test::result("imu_recovery_test");
+}
@@ -0,0 +1,166 @@
+/**
+ * imu_registry host test: every report in the registry enables, reports
+ * metadata, flags new data and disables through the one dispatch table, and
+ * IDs outside it are refused without a command reaching the hub. Capability
+ * flags drive the batching fallback, imu_get<ID>() returns the injected
+ * values, and the enabled / desired masks only change once the hub accepted
+ * the command.
+ */
+
+#include <cstdio>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "imu_driver.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr uint8_t supported[] = {
+        SH2_RAW_ACCELEROMETER,
+        SH2_ACCELEROMETER,
+        SH2_LINEAR_ACCELERATION,
+        SH2_GRAVITY,
+        SH2_RAW_GYROSCOPE,
+        SH2_GYROSCOPE_CALIBRATED,
+        SH2_GYROSCOPE_UNCALIBRATED,
+        SH2_RAW_MAGNETOMETER,
+        SH2_MAGNETIC_FIELD_CALIBRATED,
+        SH2_MAGNETIC_FIELD_UNCALIBRATED,
+        SH2_ROTATION_VECTOR,
+        SH2_GAME_ROTATION_VECTOR,
+        SH2_ARVR_STABILIZED_RV,
+        SH2_ARVR_STABILIZED_GRV,
+        SH2_GYRO_INTEGRATED_RV,
+        SH2_GEOMAGNETIC_ROTATION_VECTOR,
+        SH2_PERSONAL_ACTIVITY_CLASSIFIER,
+        SH2_STABILITY_CLASSIFIER,
+        SH2_SHAKE_DETECTOR,
+        SH2_STEP_COUNTER,
+        SH2_SIGNIFICANT_MOTION,
+    };
+
+    constexpr uint8_t unsupported[] = {0, SH2_PRESSURE, SH2_TAP_DETECTOR, SH2_HEART_RATE_MONITOR,
+                                       SH2_MAX_SENSOR_ID + 1, 0xFF};
+
+    void test_dispatch() {
+        CHECK(imu_disable_all_rpts());
+
+        for (uint8_t id : supported) {
+            CHECK(imu_get_rpt_caps(id) != IMU_RPT_CAP_NONE);
+
+            const uint32_t cmds = bno08x_sim::stats().set_feature_cmds;
+            CHECK(imu_enable_rpt(id, 10000UL));
+            CHECK(bno08x_sim::stats().set_feature_cmds == cmds + 1);
+            CHECK(imu_get_enabled_rpts() == IMU_RPT_BIT(id));
+
+            imu_report_cfg_t live;
+            CHECK(imu_get_rpt_cfg(id, live) && live.period_us == 10000UL);
+
+            // metadata is dispatched for every report, accel and gravity included
+            bno08x_meta_data_t meta;
+            CHECK(imu_get_meta_data(id, meta));
+
+            bno08x_sim_sample_t sample;
+            sample.report_id = id;
+            sample.v[0] = 1.0f;
+            CHECK(bno08x_sim::inject(sample));
+            CHECK(imu_has_new_data(id));
+            CHECK(!imu_has_new_data(id));
+
+            CHECK(imu_disable_rpt(id));
+            CHECK(imu_get_enabled_rpts() == 0);
+            CHECK(!imu_get_rpt_cfg(id, live));
+        }
+    }
+
+    void test_unsupported() {
+        const uint32_t cmds = bno08x_sim::stats().set_feature_cmds;
+        for (uint8_t id : unsupported) {
+            bno08x_meta_data_t meta;
+            CHECK(imu_get_rpt_caps(id) == IMU_RPT_CAP_NONE);
+            CHECK(!imu_enable_rpt(id, 10000UL));
+            CHECK(!imu_disable_rpt(id));
+            CHECK(!imu_get_meta_data(id, meta));
+            CHECK(!imu_has_new_data(id));
+        }
+        CHECK(bno08x_sim::stats().set_feature_cmds == cmds);
+        CHECK(imu_get_enabled_rpts() == 0);
+    }
+
+    void test_poll_and_caps() {
+        // only the enabled reports are walked, and only those with data come back
+        CHECK(imu_enable_rpt(SH2_ACCELEROMETER, 10000UL));
+        CHECK(imu_enable_rpt(SH2_GYROSCOPE_CALIBRATED, 10000UL));
+        CHECK(imu_enable_rpt(SH2_ROTATION_VECTOR, 10000UL));
+
+        bno08x_sim_sample_t accel;
+        accel.report_id = SH2_ACCELEROMETER;
+        accel.v[0] = 1.5f;
+        accel.v[1] = -2.0f;
+        accel.v[2] = 9.81f;
+        bno08x_sim_sample_t rv;
+        rv.report_id = SH2_ROTATION_VECTOR;
+        rv.v[0] = 1.0f;
+        CHECK(bno08x_sim::inject(accel));
+        CHECK(bno08x_sim::inject(rv));
+        CHECK(imu_poll_new_data() == (IMU_RPT_BIT(SH2_ACCELEROMETER) | IMU_RPT_BIT(SH2_ROTATION_VECTOR)));
+        CHECK(imu_poll_new_data() == 0);
+
+        const bno08x_accel_t got = imu_get<SH2_ACCELEROMETER>();
+        CHECK(got.x == 1.5f && got.y == -2.0f && got.z == 9.81f);
+        CHECK(imu_get_accel().z == got.z);
+
+        const uint8_t raw = imu_get_rpt_caps(SH2_RAW_ACCELEROMETER);
+        CHECK((raw & IMU_RPT_CAP_TIMESTAMP) && (raw & IMU_RPT_CAP_CONTINUOUS));
+        CHECK(!(imu_get_rpt_caps(SH2_ACCELEROMETER) & IMU_RPT_CAP_TIMESTAMP));
+        const uint8_t sig = imu_get_rpt_caps(SH2_SIGNIFICANT_MOTION);
+        CHECK((sig & IMU_RPT_CAP_EVENT) && (sig & IMU_RPT_CAP_ONE_SHOT) && !(sig & IMU_RPT_CAP_BATCHABLE));
+
+        // a report without the batchable flag is enabled unbatched
+        CHECK(!(imu_get_rpt_caps(SH2_GYRO_INTEGRATED_RV) & IMU_RPT_CAP_BATCHABLE));
+        CHECK(imu_enable_rpt_batched(SH2_GYRO_INTEGRATED_RV, 10000UL, 100000UL));
+        imu_report_cfg_t live;
+        CHECK(imu_get_rpt_cfg(SH2_GYRO_INTEGRATED_RV, live) && live.batch_us == 0);
+        CHECK(imu_enable_rpt_batched(SH2_ACCELEROMETER, 10000UL, 100000UL));
+        CHECK(imu_get_rpt_cfg(SH2_ACCELEROMETER, live) && live.batch_us == 100000UL);
+
+        CHECK(imu_disable_all_rpts());
+    }
+
+    /// @brief The masks follow the hub: a rejected command leaves them as they were
+    void test_rejected_commands() {
+        CHECK(imu_enable_rpt(SH2_ACCELEROMETER, 10000UL));
+
+        bno08x_sim::reject_commands(1);
+        CHECK(!imu_disable_rpt(SH2_ACCELEROMETER));
+        CHECK(imu_get_enabled_rpts() == IMU_RPT_BIT(SH2_ACCELEROMETER));
+        CHECK(imu_get_desired_rpts() == IMU_RPT_BIT(SH2_ACCELEROMETER));
+
+        bno08x_sim::reject_commands(1);
+        CHECK(!imu_enable_rpt(SH2_GYROSCOPE_CALIBRATED, 10000UL));
+        CHECK(imu_get_enabled_rpts() == IMU_RPT_BIT(SH2_ACCELEROMETER));
+
+        bno08x_sim::reject_commands(1);
+        CHECK(!imu_disable_all_rpts());
+        CHECK(imu_get_enabled_rpts() == IMU_RPT_BIT(SH2_ACCELEROMETER));
+
+        CHECK(imu_disable_rpt(SH2_ACCELEROMETER));
+        CHECK(imu_get_enabled_rpts() == 0);
+        CHECK(imu_get_desired_rpts() == 0);
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_NONE);
+    if (!imu_init()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    test_dispatch();
+    test_unsupported();
+    test_poll_and_caps();
+    test_rejected_commands();
+
+    return test::result("imu_registry_test");
+}
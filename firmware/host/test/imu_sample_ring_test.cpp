@@ -0,0 +1,181 @@
+/**
+ * imu_sample_ring host test: the SPSC ring keeps FIFO order across index
+ * wrap, drops the newest record when full and counts it, and holds order with
+ * a producer and a consumer on two threads. Through the driver, samples
+ * injected into the simulated hub come out of imu_sample_ring_drain() in
+ * order, and a ring left undrained overflows by exactly the excess.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "imu_driver.hpp"
+#include "imu_sample_ring.hpp"
+#include "test_check.hpp"
+
+namespace {
+    void test_order_and_overflow() {
+        static imu_spsc_ring<uint32_t, 8> ring;
+        uint32_t out[16];
+
+        for (uint32_t i = 0; i < 8; i++) {
+            CHECK(ring.push(i));
+        }
+        CHECK(!ring.push(8));
+        CHECK(ring.size() == 8);
+
+        imu_ring_stats_t stats = ring.get_stats();
+        CHECK(stats.pushed == 8);
+        CHECK(stats.overflows == 1);
+        CHECK(stats.high_water == 8);
+        CHECK(stats.capacity == 8);
+
+        // the dropped record is the newest, the queued ones come out in order
+        CHECK(ring.pop_batch(out, 3) == 3);
+        CHECK(out[0] == 0 && out[1] == 1 && out[2] == 2);
+
+        // refill across the end of the slot array
+        for (uint32_t i = 100; i < 103; i++) {
+            CHECK(ring.push(i));
+        }
+        CHECK(ring.pop_batch(out, 16) == 8);
+        const uint32_t expected[] = {3, 4, 5, 6, 7, 100, 101, 102};
+        for (size_t i = 0; i < 8; i++) {
+            CHECK(out[i] == expected[i]);
+        }
+        CHECK(ring.empty());
+        CHECK(ring.pop_batch(out, 16) == 0);
+
+        stats = ring.get_stats();
+        CHECK(stats.pushed == 11);
+        CHECK(stats.popped == 11);
+
+        ring.reset_stats();
+        stats = ring.get_stats();
+        CHECK(stats.pushed == 0 && stats.popped == 0 && stats.overflows == 0 && stats.high_water == 0);
+    }
+
+    /// @brief Producer and consumer on their own threads, every record accounted for and in order
+    void test_two_threads() {
+        static imu_spsc_ring<uint32_t, 64> ring;
+        constexpr uint32_t N = 2000000;
+        std::atomic<bool> done{false};
+        uint32_t attempts = 0;
+
+        std::thread producer([&]() {
+            for (uint32_t i = 1; i <= N; i++) {
+                ring.push(i);
+                attempts++;
+            }
+            done.store(true, std::memory_order_release);
+        });
+
+        uint32_t out[32];
+        uint32_t last = 0;
+        uint32_t received = 0;
+        bool ordered = true;
+        while (true) {
+            const bool finished = done.load(std::memory_order_acquire);
+            const size_t n = ring.pop_batch(out, 32);
+            for (size_t i = 0; i < n; i++) {
+                ordered &= out[i] > last;
+                last = out[i];
+            }
+            received += static_cast<uint32_t>(n);
+            if (finished && n == 0) {
+                break;
+            }
+        }
+        producer.join();
+
+        const imu_ring_stats_t stats = ring.get_stats();
+        CHECK(ordered);
+        CHECK(attempts == N);
+        CHECK(stats.pushed + stats.overflows == N);
+        CHECK(stats.popped == stats.pushed);
+        CHECK(received == stats.pushed);
+        CHECK(stats.high_water <= 64);
+    }
+
+    void test_driver_ring() {
+        CHECK(imu_sample_ring_start());
+        CHECK(imu_enable_rpt(SH2_ACCELEROMETER, 2500UL));
+
+        imu_sample_t drained[64];
+        while (imu_sample_ring_drain(drained, 64) > 0) {
+        }
+        imu_sample_ring_reset_stats();
+
+        // drained as it fills: nothing lost, payloads in injection order
+        bno08x_sim_sample_t sample;
+        sample.report_id = SH2_ACCELEROMETER;
+        uint32_t next = 0;
+        bool ordered = true;
+        size_t total = 0;
+        for (uint32_t i = 0; i < 1000; i++) {
+            sample.t_us = i * 2500UL;
+            sample.v[0] = static_cast<float>(i);
+            CHECK(bno08x_sim::inject(sample));
+            if (i % 50 == 49) {
+                size_t n;
+                while ((n = imu_sample_ring_drain(drained, 64)) > 0) {
+                    for (size_t k = 0; k < n; k++) {
+                        ordered &= drained[k].report_id == SH2_ACCELEROMETER &&
+                                   drained[k].data.vec.x == static_cast<float>(next);
+                        next++;
+                    }
+                    total += n;
+                }
+            }
+        }
+        CHECK(ordered);
+        CHECK(total == 1000);
+        imu_ring_stats_t stats = imu_sample_ring_get_stats();
+        CHECK(stats.overflows == 0);
+        CHECK(stats.pushed == 1000 && stats.popped == 1000);
+
+        // left undrained: the ring keeps the oldest capacity samples and counts the rest
+        imu_sample_ring_reset_stats();
+        constexpr uint32_t EXCESS = 10;
+        for (uint32_t i = 0; i < IMU_SAMPLE_RING_CAPACITY + EXCESS; i++) {
+            sample.t_us = (1000 + i) * 2500UL;
+            sample.v[0] = static_cast<float>(i);
+            bno08x_sim::inject(sample);
+        }
+        stats = imu_sample_ring_get_stats();
+        CHECK(stats.overflows == EXCESS);
+        CHECK(stats.high_water == IMU_SAMPLE_RING_CAPACITY);
+
+        next = 0;
+        ordered = true;
+        total = 0;
+        size_t n;
+        while ((n = imu_sample_ring_drain(drained, 64)) > 0) {
+            for (size_t k = 0; k < n; k++) {
+                ordered &= drained[k].data.vec.x == static_cast<float>(next++);
+            }
+            total += n;
+        }
+        CHECK(ordered);
+        CHECK(total == IMU_SAMPLE_RING_CAPACITY);
+
+        CHECK(imu_disable_rpt(SH2_ACCELEROMETER));
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_WARN);
+    if (!imu_init()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    test_order_and_overflow();
+    test_two_threads();
+    test_driver_ring();
+
+    return test::result("imu_sample_ring_test");
+}
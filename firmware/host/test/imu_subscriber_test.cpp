@@ -0,0 +1,168 @@
+/**
+ * imu_subscriber host test: imu_subscribe() rejects a missing callback, a
+ * mask without a valid report and a subscription past IMU_MAX_SUBSCRIBERS.
+ * Every subscriber of a report gets each injected sample, after its own
+ * decimation (first sample, then every Nth) and filter, and the counters
+ * account for every sample. Subscriptions outlive disable / enable,
+ * imu_rearm_sig_motion() and hard and soft resets, and once
+ * imu_unsubscribe() returns the callback is not called again.
+ */
+
+#include <cstdio>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "imu_driver.hpp"
+#include "test_check.hpp"
+
+namespace {
+    struct sink_t {
+        uint32_t calls = 0;
+        uint64_t reports = 0;    // IMU_RPT_BIT of every report seen
+        float last_x = 0.0f;
+    };
+
+    void on_sample(const imu_sample_t &sample, void *arg) {
+        sink_t *sink = static_cast<sink_t *>(arg);
+        sink->calls++;
+        sink->reports |= IMU_RPT_BIT(sample.report_id);
+        sink->last_x = sample.data.vec.x;
+    }
+
+    bool positive_x(const imu_sample_t &sample, void *) {
+        return sample.data.vec.x > 0.0f;
+    }
+
+    int subscribe(sink_t &sink, uint64_t mask, uint16_t decimation = 1, imu_sub_filter_t filter = nullptr) {
+        imu_sub_cfg_t cfg;
+        cfg.report_mask = mask;
+        cfg.fn = on_sample;
+        cfg.arg = &sink;
+        cfg.decimation = decimation;
+        cfg.filter = filter;
+        return imu_subscribe(cfg);
+    }
+
+    bool inject(uint8_t report_id, float x) {
+        bno08x_sim_sample_t s;
+        s.report_id = report_id;
+        s.v[0] = x;
+        return bno08x_sim::inject(s);
+    }
+
+    void test_subscribe_limits() {
+        sink_t sink;
+        imu_sub_cfg_t cfg;
+        cfg.report_mask = IMU_RPT_BIT(SH2_ACCELEROMETER);
+        CHECK(imu_subscribe(cfg) == -1);
+        CHECK(subscribe(sink, 0) == -1);
+        CHECK(!imu_unsubscribe(-1) && !imu_unsubscribe(IMU_MAX_SUBSCRIBERS));
+
+        int handles[IMU_MAX_SUBSCRIBERS];
+        for (int &h : handles) {
+            h = subscribe(sink, IMU_RPT_BIT(SH2_ACCELEROMETER));
+            CHECK(h >= 0);
+        }
+        CHECK(imu_sub_count() == IMU_MAX_SUBSCRIBERS);
+        CHECK(subscribe(sink, IMU_RPT_BIT(SH2_ACCELEROMETER)) == -1);
+
+        // a freed slot is taken again
+        CHECK(imu_unsubscribe(handles[3]));
+        CHECK(!imu_unsubscribe(handles[3]));
+        CHECK(subscribe(sink, IMU_RPT_BIT(SH2_ACCELEROMETER)) == handles[3]);
+        for (int h : handles) {
+            CHECK(imu_unsubscribe(h));
+        }
+        CHECK(imu_sub_count() == 0);
+    }
+
+    void test_fan_out() {
+        CHECK(imu_enable_rpt(SH2_ACCELEROMETER, 10000UL));
+        CHECK(imu_enable_rpt(SH2_GYROSCOPE_CALIBRATED, 10000UL));
+
+        sink_t all, every_4th, positive, gyro;
+        const int h_all = subscribe(all, IMU_RPT_BIT(SH2_ACCELEROMETER) | IMU_RPT_BIT(SH2_GYROSCOPE_CALIBRATED));
+        const int h_dec = subscribe(every_4th, IMU_RPT_BIT(SH2_ACCELEROMETER), 4);
+        const int h_pos = subscribe(positive, IMU_RPT_BIT(SH2_ACCELEROMETER), 1, positive_x);
+        const int h_gyro = subscribe(gyro, IMU_RPT_BIT(SH2_GYROSCOPE_CALIBRATED));
+        CHECK(h_all >= 0 && h_dec >= 0 && h_pos >= 0 && h_gyro >= 0);
+
+        // 20 accel samples alternating in sign, 5 gyro
+        for (int i = 0; i < 20; i++) {
+            CHECK(inject(SH2_ACCELEROMETER, (i % 2 == 0) ? 1.0f + i : -1.0f - i));
+        }
+        for (int i = 0; i < 5; i++) {
+            CHECK(inject(SH2_GYROSCOPE_CALIBRATED, 0.5f));
+        }
+
+        CHECK(all.calls == 25);
+        CHECK(all.reports == (IMU_RPT_BIT(SH2_ACCELEROMETER) | IMU_RPT_BIT(SH2_GYROSCOPE_CALIBRATED)));
+        CHECK(gyro.calls == 5 && gyro.reports == IMU_RPT_BIT(SH2_GYROSCOPE_CALIBRATED));
+
+        // samples 0, 4, 8, 12 and 16
+        imu_sub_stats_t st = {};
+        CHECK(every_4th.calls == 5 && every_4th.last_x == 17.0f);
+        CHECK(imu_sub_get_stats(h_dec, st));
+        CHECK(st.delivered == 5 && st.decimated == 15 && st.filtered == 0);
+
+        CHECK(positive.calls == 10 && positive.last_x == 19.0f);
+        CHECK(imu_sub_get_stats(h_pos, st));
+        CHECK(st.delivered == 10 && st.filtered == 10 && st.decimated == 0);
+
+        CHECK(imu_unsubscribe(h_all) && imu_unsubscribe(h_dec) && imu_unsubscribe(h_pos) && imu_unsubscribe(h_gyro));
+        CHECK(!imu_sub_get_stats(h_all, st));
+
+        // nothing is called once unsubscribed
+        CHECK(inject(SH2_ACCELEROMETER, 1.0f));
+        CHECK(all.calls == 25 && positive.calls == 10);
+        CHECK(imu_disable_all_rpts());
+    }
+
+    void test_persistence() {
+        sink_t accel, motion;
+        const int h_accel = subscribe(accel, IMU_RPT_BIT(SH2_ACCELEROMETER));
+        const int h_motion = subscribe(motion, IMU_RPT_BIT(SH2_SIGNIFICANT_MOTION));
+        CHECK(h_accel >= 0 && h_motion >= 0);
+
+        // disabled: the hub drops the sample, enabled again: delivered without resubscribing
+        CHECK(imu_enable_rpt(SH2_ACCELEROMETER, 10000UL));
+        CHECK(inject(SH2_ACCELEROMETER, 1.0f));
+        CHECK(imu_disable_rpt(SH2_ACCELEROMETER));
+        CHECK(!inject(SH2_ACCELEROMETER, 2.0f));
+        CHECK(imu_enable_rpt(SH2_ACCELEROMETER, 10000UL));
+        CHECK(inject(SH2_ACCELEROMETER, 3.0f));
+        CHECK(accel.calls == 2 && accel.last_x == 3.0f);
+
+        // the one-shot report, re-armed
+        CHECK(imu_rearm_sig_motion());
+        CHECK(inject(SH2_SIGNIFICANT_MOTION, 1.0f));
+        CHECK(imu_rearm_sig_motion());
+        CHECK(inject(SH2_SIGNIFICANT_MOTION, 1.0f));
+        CHECK(motion.calls == 2);
+
+        // the resets replay the reports and the subscriptions still hold
+        CHECK(imu_hard_reset());
+        CHECK(inject(SH2_ACCELEROMETER, 4.0f));
+        CHECK(imu_soft_reset());
+        CHECK(inject(SH2_ACCELEROMETER, 5.0f));
+        CHECK(accel.calls == 4 && accel.last_x == 5.0f);
+        CHECK(imu_sub_count() == 2);
+
+        CHECK(imu_unsubscribe(h_accel) && imu_unsubscribe(h_motion));
+        CHECK(imu_disable_all_rpts());
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_NONE);
+    if (!imu_init()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    test_subscribe_limits();
+    test_fan_out();
+    test_persistence();
+
+    return test::result("imu_subscriber_test");
+}
@@ -0,0 +1,352 @@
+/**
+ * pipeline host test: the bounded queue keeps FIFO order, and when full
+ * drops the newest item, drops the oldest or blocks its producer for the
+ * configured time, counting every loss. pipeline_start() rejects invalid
+ * configurations and a second start, and a start that fails leaves no
+ * subscription behind. Through the driver every injected sample is stored
+ * and reaches the block sink in decodable codec blocks; with the uplink
+ * stalled each store policy loses records only in the store queue, and
+ * PROCESS output always equals what STORE stored plus what the queue
+ * dropped. on_batch sees every drained sample and housekeeping runs in
+ * STORE. The stages report the cores they ran on and their load, and a start
+ * whose ingestion callback runs off the ingest core is refused.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/task.h"
+#include "imu_codec.hpp"
+#include "imu_driver.hpp"
+#include "pipeline.hpp"
+#include "pipeline_queue.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr uint32_t PERIOD_US = 10000UL;
+
+    // filled by the STORE task through the block sink, read once pipeline_stop() returned
+    std::vector<imu_compact_sample_t> sunk;
+    uint32_t bad_blocks = 0;
+    uint32_t sink_stall_ms = 0;
+    uint32_t batch_samples = 0;
+    std::atomic<uint32_t> housekeeping_runs{0};
+    std::atomic<bool> feeding{false};
+
+    void sink(const uint8_t *block, size_t len) {
+        static imu_compact_sample_t decoded[4096];
+        const size_t n = imu_codec_decode_block(block, len, decoded, 4096);
+        if (n == 0) {
+            bad_blocks++;
+        }
+        sunk.insert(sunk.end(), decoded, decoded + n);
+        if (sink_stall_ms != 0) {
+            vTaskDelay(pdMS_TO_TICKS(sink_stall_ms));
+        }
+    }
+
+    void on_batch(const imu_sample_t *, size_t count) {
+        batch_samples += static_cast<uint32_t>(count);
+    }
+
+    void housekeeping() {
+        housekeeping_runs++;
+    }
+
+    void test_queue() {
+        static StaticEventGroup_t buf;
+        EventGroupHandle_t evt = xEventGroupCreateStatic(&buf);
+        static pipeline_queue<uint32_t, 4> q;
+        q.init(evt, 1, 2);
+        uint32_t out[8];
+
+        // drop newest: the queue keeps 0..3
+        for (uint32_t i = 0; i < 4; i++) {
+            CHECK(q.push(i, PIPELINE_DROP_NEWEST, 0));
+        }
+        CHECK(!q.push(4, PIPELINE_DROP_NEWEST, 0));
+        pipeline_queue_stats_t st = q.get_stats();
+        CHECK(st.depth == 4 && st.high_water == 4 && st.capacity == 4 && st.dropped == 1);
+        CHECK(q.pop(out, 8, 0) == 4 && out[0] == 0 && out[3] == 3);
+
+        // drop oldest: 2..5 survive
+        for (uint32_t i = 0; i < 6; i++) {
+            CHECK(q.push(i, PIPELINE_DROP_OLDEST, 0));
+        }
+        CHECK(q.pop(out, 8, 0) == 4 && out[0] == 2 && out[3] == 5);
+        CHECK(q.get_stats().dropped == 3);
+
+        // block: times out and drops, or takes the slot a consumer frees
+        q.reset_stats();
+        for (uint32_t i = 0; i < 4; i++) {
+            CHECK(q.push(i, PIPELINE_BLOCK, 0));
+        }
+        CHECK(!q.push(4, PIPELINE_BLOCK, pdMS_TO_TICKS(5)));
+        st = q.get_stats();
+        CHECK(st.dropped == 1 && st.blocked_us >= 4000);
+        std::thread consumer([&]() {
+            vTaskDelay(pdMS_TO_TICKS(5));
+            uint32_t one;
+            q.pop(&one, 1, 0);
+        });
+        CHECK(q.push(5, PIPELINE_BLOCK, pdMS_TO_TICKS(1000)));
+        consumer.join();
+        CHECK(q.get_stats().dropped == 1);
+        CHECK(q.pop(out, 8, 0) == 4 && out[0] == 1 && out[3] == 5);
+
+        // an empty queue times out
+        CHECK(q.pop(out, 8, pdMS_TO_TICKS(2)) == 0);
+    }
+
+    void test_start_errors() {
+        pipeline_config_t config;
+        config.batch = 0;
+        CHECK(!pipeline_start(config));
+        config.batch = PIPELINE_MAX_BATCH + 1;
+        CHECK(!pipeline_start(config));
+        config = {};
+        config.store_priority = config.process_priority;
+        CHECK(!pipeline_start(config));
+        config = {};
+        config.features.hop = 5;
+        CHECK(!pipeline_start(config));
+        config = {};
+        config.housekeeping = housekeeping;
+        config.housekeeping_ms = 0;
+        CHECK(!pipeline_start(config));
+        CHECK(!pipeline_running());
+
+        // no slot for the ingest probe: nothing is left subscribed or running
+        const size_t subs = imu_sub_count();
+        std::vector<int> taken;
+        imu_sub_cfg_t filler;
+        filler.report_mask = IMU_RPT_BIT(SH2_ACCELEROMETER);
+        filler.fn = [](const imu_sample_t &, void *) {};
+        for (int h = imu_subscribe(filler); h >= 0; h = imu_subscribe(filler)) {
+            taken.push_back(h);
+        }
+        CHECK(!pipeline_start(pipeline_config_t{}));
+        CHECK(!pipeline_running());
+        CHECK(imu_sub_count() == subs + taken.size());
+        for (int h : taken) {
+            imu_unsubscribe(h);
+        }
+
+        // then it starts, once, and a stop right after the start finds both stages parked
+        CHECK(pipeline_start(pipeline_config_t{}));
+        CHECK(imu_sub_count() == subs + 1);
+        CHECK(!pipeline_start(pipeline_config_t{}));
+        pipeline_stop();
+        CHECK(!pipeline_running());
+        CHECK(imu_sub_count() == subs);
+        for (int i = 0; i < 5; i++) {
+            CHECK(pipeline_start(pipeline_config_t{}));
+            pipeline_stop();
+        }
+        CHECK(!pipeline_running());
+    }
+
+    /// @brief Stream accel from the core this task is pinned to until feeding is cleared
+    void feeder_task(void *) {
+        bno08x_sim_sample_t s;
+        s.report_id = SH2_ACCELEROMETER;
+        s.v[2] = 9.81f;
+        while (feeding.load()) {
+            bno08x_sim::inject(s);
+            vTaskDelay(pdMS_TO_TICKS(5));
+        }
+        vTaskDelete(nullptr);
+    }
+
+    /// @brief Empty the ring without the pipeline, what a refused start left behind
+    void discard_ring() {
+        imu_sample_t out[32];
+        vTaskDelay(pdMS_TO_TICKS(20));
+        while (imu_sample_ring_drain(out, 32) > 0) {
+        }
+    }
+
+    void test_ingest_core() {
+        const size_t subs = imu_sub_count();
+
+        // ingestion on the process core: refused, nothing left subscribed
+        feeding.store(true);
+        CHECK(xTaskCreatePinnedToCore(feeder_task, "feeder", 4096, nullptr, 5, nullptr, PIPELINE_PROCESS_CORE) ==
+              pdPASS);
+        CHECK(!pipeline_start(pipeline_config_t{}));
+        CHECK(!pipeline_running());
+        CHECK(imu_sub_count() == subs);
+        feeding.store(false);
+        discard_ring();
+
+        // on the ingest core it starts
+        feeding.store(true);
+        CHECK(xTaskCreatePinnedToCore(feeder_task, "feeder", 4096, nullptr, 5, nullptr, PIPELINE_INGEST_CORE) ==
+              pdPASS);
+        CHECK(pipeline_start(pipeline_config_t{}));
+        feeding.store(false);
+        vTaskDelay(pdMS_TO_TICKS(20));
+        pipeline_stop();
+        CHECK(pipeline_get_stats().stage[PIPELINE_STAGE_INGEST].misplaced == 0);
+        CHECK(pipeline_get_process_task() != nullptr);
+        discard_ring();
+    }
+
+    /// @brief Inject ticks of accel + gyro, never more than half the ring ahead of PROCESS
+    void inject(uint32_t ticks) {
+        static uint32_t t_us = 0;
+        for (uint32_t i = 0; i < ticks; i++, t_us += PERIOD_US) {
+            while (true) {
+                const imu_ring_stats_t ring = imu_sample_ring_get_stats();
+                if (ring.pushed - ring.popped < IMU_SAMPLE_RING_CAPACITY / 2) {
+                    break;
+                }
+                vTaskDelay(1);
+            }
+            bno08x_sim_sample_t s;
+            s.t_us = t_us;
+            s.report_id = SH2_ACCELEROMETER;
+            s.v[2] = 9.81f + ((i % 8) < 4 ? 1.0f : -1.0f);
+            bno08x_sim::inject(s);
+            s.report_id = SH2_GYROSCOPE_CALIBRATED;
+            s.v[2] = 0.5f;
+            bno08x_sim::inject(s);
+        }
+    }
+
+    /// @brief Let PROCESS drain the ring, then stop
+    void drain_and_stop() {
+        while (true) {
+            const imu_ring_stats_t ring = imu_sample_ring_get_stats();
+            if (ring.pushed == ring.popped) {
+                break;
+            }
+            vTaskDelay(1);
+        }
+        pipeline_stop();
+    }
+
+    void test_nominal() {
+        constexpr uint32_t TICKS = 1000;
+        sunk.clear();
+        bad_blocks = 0;
+        sink_stall_ms = 0;
+        batch_samples = 0;
+        housekeeping_runs.store(0);
+
+        pipeline_config_t config;
+        config.block_sink = sink;
+        config.on_batch = on_batch;
+        config.housekeeping = housekeeping;
+        config.housekeeping_ms = 10;
+        CHECK(pipeline_start(config));
+        inject(TICKS);
+        drain_and_stop();
+        CHECK(batch_samples == 2 * TICKS);
+        CHECK(housekeeping_runs.load() > 0);
+
+        const pipeline_stats_t st = pipeline_get_stats();
+        const pipeline_stage_stats_t &ingest = st.stage[PIPELINE_STAGE_INGEST];
+        const pipeline_stage_stats_t &process = st.stage[PIPELINE_STAGE_PROCESS];
+        const pipeline_stage_stats_t &store = st.stage[PIPELINE_STAGE_STORE];
+        CHECK(ingest.items == 2 * TICKS && ingest.input.dropped == 0);
+        CHECK(process.items == 2 * TICKS && store.items == 2 * TICKS);
+        CHECK(store.input.dropped == 0 && store.input.depth == 0);
+        CHECK(store.input.capacity == PIPELINE_STORE_QUEUE_LEN);
+
+        // every record reaches the uplink, in order
+        CHECK(bad_blocks == 0 && sunk.size() == 2 * TICKS);
+        bool ordered = true;
+        for (size_t i = 1; i < sunk.size(); i++) {
+            ordered &= sunk[i].timestamp_us >= sunk[i - 1].timestamp_us;
+        }
+        CHECK(ordered);
+
+        // one vector per hop once the window filled, the feature queue keeps the newest
+        const uint32_t vectors = 1 + (TICKS - BEHAVIOR_WINDOW) / config.features.hop;
+        behavior_features_t fv[PIPELINE_FEATURE_QUEUE_LEN + 1];
+        const size_t popped = pipeline_pop_features(fv, PIPELINE_FEATURE_QUEUE_LEN + 1);
+        CHECK(popped == PIPELINE_FEATURE_QUEUE_LEN);
+        CHECK(popped + st.features.dropped == vectors);
+        bool increasing = true;
+        for (size_t i = 1; i < popped; i++) {
+            increasing &= fv[i].t_us > fv[i - 1].t_us;
+        }
+        CHECK(increasing);
+
+        // the ingest probe ran in the injecting thread, the stages on their pinned core
+        CHECK(ingest.core == PIPELINE_INGEST_CORE && process.core == PIPELINE_PROCESS_CORE);
+        CHECK(store.core == PIPELINE_PROCESS_CORE);
+        CHECK(ingest.misplaced == 0 && process.misplaced == 0 && store.misplaced == 0);
+        CHECK(process.busy_us <= st.window_us && store.busy_us <= st.window_us);
+        CHECK(process.max_run_us <= process.busy_us);
+    }
+
+    /// @brief Stalled uplink: the store queue is the only place records are lost, and every loss is counted
+    void test_backpressure(pipeline_policy_t policy) {
+        constexpr uint32_t TICKS = 3000;
+        sunk.clear();
+        bad_blocks = 0;
+        sink_stall_ms = 20;
+
+        pipeline_config_t config;
+        config.block_sink = sink;
+        config.store_policy = policy;
+        config.features_enabled = false;
+        CHECK(pipeline_start(config));
+        inject(TICKS);
+        drain_and_stop();
+        sink_stall_ms = 0;
+
+        const pipeline_stats_t st = pipeline_get_stats();
+        const pipeline_stage_stats_t &process = st.stage[PIPELINE_STAGE_PROCESS];
+        const pipeline_stage_stats_t &store = st.stage[PIPELINE_STAGE_STORE];
+        std::printf("%s: stored %lu, dropped %lu, blocked %lu us\n",
+                    policy == PIPELINE_BLOCK ? "block" : (policy == PIPELINE_DROP_OLDEST ? "drop oldest" : "drop newest"),
+                    (unsigned long)store.items, (unsigned long)store.input.dropped,
+                    (unsigned long)store.input.blocked_us);
+        CHECK(st.stage[PIPELINE_STAGE_INGEST].input.dropped == 0);
+        CHECK(process.items == 2 * TICKS);
+        CHECK(store.input.high_water == PIPELINE_STORE_QUEUE_LEN);
+        CHECK(process.items == store.items + store.input.dropped);
+        CHECK(bad_blocks == 0 && sunk.size() == store.items);
+        if (policy == PIPELINE_BLOCK) {
+            CHECK(store.input.blocked_us > 0);
+        } else {
+            CHECK(store.input.dropped > 0 && store.input.blocked_us == 0);
+        }
+        // what the queue dropped is gone from the middle (oldest) or the end (newest) of the stream
+        if (policy == PIPELINE_DROP_NEWEST && !sunk.empty()) {
+            CHECK(sunk.back().timestamp_us < (TICKS - 1) * PERIOD_US);
+        }
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_NONE);
+    if (!imu_init()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+    CHECK(imu_enable_rpt(SH2_ACCELEROMETER, PERIOD_US));
+    CHECK(imu_enable_rpt(SH2_GYROSCOPE_CALIBRATED, PERIOD_US));
+    // PROCESS starts it on its first drain otherwise, taking a subscription slot mid test
+    CHECK(imu_events_start());
+
+    test_queue();
+    test_start_errors();
+    test_ingest_core();
+    test_nominal();
+    test_backpressure(PIPELINE_DROP_NEWEST);
+    test_backpressure(PIPELINE_DROP_OLDEST);
+    test_backpressure(PIPELINE_BLOCK);
+
+    CHECK(imu_disable_all_rpts());
+    return test::result("pipeline_test");
+}
@@ -0,0 +1,237 @@
+/**
+ * power_manager host test: pm_task runs as a task against the simulated hub,
+ * a feeder thread streams linear accel at a magnitude the test sets. The
+ * cycle ACTIVE -> STATIC -> SLEEP -> (sig motion) ACTIVE -> STATIC ->
+ * (motion) ACTIVE -> STATIC -> SLEEP is driven through it and checked
+ * against the transition log, pm_get_stats() entries and residency, the
+ * report set the hub is held to in each state and the suspended processing
+ * task. A hub power cycle in ACTIVE must be recovered by pm_task, and a
+ * sig motion re-arm the hub rejects keeps the manager STATIC until a retry
+ * arms it.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "imu_driver.hpp"
+#include "power_manager.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr uint32_t FEED_PERIOD_US = 5000UL;
+    constexpr float STILL_MS2 = 0.05f;
+    constexpr float MOVING_MS2 = 2.0f;
+    constexpr uint32_t STILL_TIME_MS = 100;
+    constexpr uint32_t STATIC_TIMEOUT_MS = 200;
+    constexpr uint32_t STATE_WAIT_MS = 2000;
+    constexpr size_t MAX_TRANSITIONS = 16;
+    constexpr uint32_t GOVERNED_ACCEL_US = 20000UL;
+
+    imu_report_cfg_t active_rpts[] = {{SH2_ACCELEROMETER, 10000UL}};
+
+    std::atomic<float> magnitude_ms2{STILL_MS2};
+    std::atomic<bool> feeding{true};
+    std::atomic<uint32_t> processing_loops{0};
+
+    pm_state_t transitions[MAX_TRANSITIONS][2];
+    std::atomic<size_t> transition_count{0};
+
+    void on_transition(pm_state_t from, pm_state_t to) {
+        size_t n = transition_count.load();
+        if (n < MAX_TRANSITIONS) {
+            transitions[n][0] = from;
+            transitions[n][1] = to;
+        }
+        transition_count.store(n + 1);
+    }
+
+    /// @brief Stand-in for data_processing_task, counts loops so a suspension shows
+    void processing_task(void *) {
+        while (1) {
+            processing_loops++;
+            vTaskDelay(pdMS_TO_TICKS(5));
+        }
+    }
+
+    /// @brief Stream linear accel (and accel, the active profile) until stopped, hub time advancing with wall time
+    void feeder() {
+        bno08x_sim_sample_t linear;
+        linear.report_id = SH2_LINEAR_ACCELERATION;
+        bno08x_sim_sample_t accel;
+        accel.report_id = SH2_ACCELEROMETER;
+        accel.v[2] = 9.81f;
+
+        for (uint32_t t_us = 0; feeding.load(); t_us += FEED_PERIOD_US) {
+            linear.t_us = t_us;
+            linear.v[0] = magnitude_ms2.load();
+            accel.t_us = t_us;
+            bno08x_sim::inject(linear);
+            bno08x_sim::inject(accel);
+            std::this_thread::sleep_for(std::chrono::microseconds(FEED_PERIOD_US));
+        }
+    }
+
+    bool wait_state(pm_state_t state) {
+        for (uint32_t ms = 0; ms < STATE_WAIT_MS; ms++) {
+            if (pm_get_state() == state) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::fprintf(stderr, "power_manager_test: still %s, waited for %s\n", pm_state_to_str(pm_get_state()),
+                pm_state_to_str(state));
+        return false;
+    }
+
+    /// @brief Stands in for the rate governor: accel runs at its own period while ACTIVE
+    bool governed_period(uint8_t report_id, uint32_t &period_us) {
+        if (report_id != SH2_ACCELEROMETER) {
+            return false;
+        }
+        period_us = GOVERNED_ACCEL_US;
+        return true;
+    }
+
+    bool transition_is(size_t i, pm_state_t from, pm_state_t to) {
+        return i < transition_count.load() && i < MAX_TRANSITIONS && transitions[i][0] == from &&
+                transitions[i][1] == to;
+    }
+
+    void test_init_rejects() {
+        pm_config_t config;
+        CHECK(!pm_init(config));
+
+        config.active_rpts = active_rpts;
+        config.active_rpt_count = 1;
+        config.still_threshold_ms2 = 1.0f;
+        config.motion_threshold_ms2 = 0.5f;
+        CHECK(!pm_init(config));
+
+        config.motion_threshold_ms2 = 1.5f;
+        config.eval_period_ms = 0;
+        CHECK(!pm_init(config));
+    }
+
+    void test_cycle() {
+        TaskHandle_t processing = nullptr;
+        CHECK(xTaskCreatePinnedToCore(processing_task, "processing", 4096, nullptr, 5, &processing, 1) == pdPASS);
+
+        pm_config_t config;
+        config.active_rpts = active_rpts;
+        config.active_rpt_count = 1;
+        config.static_period_us = 50000UL;
+        config.still_time_ms = STILL_TIME_MS;
+        config.static_timeout_ms = STATIC_TIMEOUT_MS;
+        config.eval_period_ms = 10;
+        config.processing_task = processing;
+        config.on_transition = on_transition;
+        config.active_period = governed_period;
+        CHECK(pm_init(config));
+
+        std::thread feed(feeder);
+        const int64_t start_us = esp_timer_get_time();
+        CHECK(xTaskCreatePinnedToCore(pm_task, "power_manager", 4096, nullptr, 6, nullptr, 0) == pdPASS);
+
+        // ACTIVE holds the profile plus the linear accel pm_init() adds, accel at the governed period
+        CHECK(wait_state(PM_STATE_ACTIVE));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        CHECK(imu_get_desired_rpts() == (IMU_RPT_BIT(SH2_ACCELEROMETER) | IMU_RPT_BIT(SH2_LINEAR_ACCELERATION)));
+        imu_report_cfg_t live;
+        CHECK(imu_get_rpt_cfg(SH2_ACCELEROMETER, live) && live.period_us == GOVERNED_ACCEL_US);
+        CHECK(imu_get_rpt_cfg(SH2_LINEAR_ACCELERATION, live) && live.period_us == active_rpts[0].period_us);
+
+        // still: ACTIVE -> STATIC -> SLEEP, only sig motion armed and processing suspended
+        CHECK(wait_state(PM_STATE_STATIC));
+        CHECK(wait_state(PM_STATE_SLEEP));
+        CHECK(imu_get_desired_rpts() == IMU_RPT_BIT(SH2_SIGNIFICANT_MOTION));
+        const uint32_t loops = processing_loops.load();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(processing_loops.load() <= loops + 1);
+
+        // sig motion wakes it, processing resumes
+        magnitude_ms2.store(MOVING_MS2);
+        bno08x_sim_sample_t motion;
+        motion.report_id = SH2_SIGNIFICANT_MOTION;
+        motion.v[0] = 1.0f;
+        CHECK(bno08x_sim::inject(motion));
+        CHECK(wait_state(PM_STATE_ACTIVE));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(processing_loops.load() > loops + 1);
+
+        // a hub reset while ACTIVE is recovered by pm_task, the profile comes back
+        const imu_recovery_stats_t before = imu_recovery_get_stats();
+        CHECK(bno08x_sim::power_cycle());
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const imu_recovery_stats_t after = imu_recovery_get_stats();
+        CHECK(after.replays == before.replays + 1);
+        CHECK(imu_get_enabled_rpts() == (IMU_RPT_BIT(SH2_ACCELEROMETER) | IMU_RPT_BIT(SH2_LINEAR_ACCELERATION)));
+        CHECK(pm_get_state() == PM_STATE_ACTIVE);
+
+        // still -> STATIC, motion above the threshold takes it back to ACTIVE, then still until SLEEP
+        magnitude_ms2.store(STILL_MS2);
+        CHECK(wait_state(PM_STATE_STATIC));
+        CHECK(imu_get_desired_rpts() == IMU_RPT_BIT(SH2_LINEAR_ACCELERATION));
+        magnitude_ms2.store(MOVING_MS2);
+        CHECK(wait_state(PM_STATE_ACTIVE));
+        magnitude_ms2.store(STILL_MS2);
+        CHECK(wait_state(PM_STATE_STATIC));
+        // linear accel off, sig motion disable and enable all rejected: no sleep without a wake source
+        bno08x_sim::reject_commands(3);
+        CHECK(wait_state(PM_STATE_SLEEP));
+        CHECK(imu_get_enabled_rpts() == IMU_RPT_BIT(SH2_SIGNIFICANT_MOTION));
+
+        const pm_stats_t stats = pm_get_stats();
+        const int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+        CHECK(transition_count.load() == 7);
+        CHECK(transition_is(0, PM_STATE_ACTIVE, PM_STATE_STATIC));
+        CHECK(transition_is(1, PM_STATE_STATIC, PM_STATE_SLEEP));
+        CHECK(transition_is(2, PM_STATE_SLEEP, PM_STATE_ACTIVE));
+        CHECK(transition_is(3, PM_STATE_ACTIVE, PM_STATE_STATIC));
+        CHECK(transition_is(4, PM_STATE_STATIC, PM_STATE_ACTIVE));
+        CHECK(transition_is(5, PM_STATE_ACTIVE, PM_STATE_STATIC));
+        CHECK(transition_is(6, PM_STATE_STATIC, PM_STATE_SLEEP));
+
+        // the initial ACTIVE counts as an entry
+        CHECK(stats.entries[PM_STATE_ACTIVE] == 3);
+        CHECK(stats.entries[PM_STATE_STATIC] == 3);
+        CHECK(stats.entries[PM_STATE_SLEEP] == 2);
+        CHECK(stats.rearm_failures == 1);
+
+        // two full STATIC timeouts, ACTIVE held for at least the still time on each of its visits
+        CHECK(stats.residency_us[PM_STATE_STATIC] >= 2ULL * STATIC_TIMEOUT_MS * 1000ULL);
+        CHECK(stats.residency_us[PM_STATE_ACTIVE] >= 3ULL * STILL_TIME_MS * 1000ULL);
+        CHECK(stats.residency_us[PM_STATE_SLEEP] > 0);
+
+        // residency covers the run without gaps or double counting
+        const uint64_t total_us = stats.residency_us[PM_STATE_SLEEP] + stats.residency_us[PM_STATE_ACTIVE] +
+                stats.residency_us[PM_STATE_STATIC];
+        CHECK(total_us <= static_cast<uint64_t>(elapsed_us));
+        CHECK(total_us + 20000ULL >= static_cast<uint64_t>(elapsed_us));
+
+        // SLEEP light sleeps on the HINT pin
+        CHECK(stats.light_sleeps > 0);
+
+        feeding.store(false);
+        feed.join();
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_WARN);
+    if (!imu_init()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    test_init_rejects();
+    test_cycle();
+
+    return test::result("power_manager_test");
+}
@@ -0,0 +1,245 @@
+/**
+ * rate_governor host test: rg_init() rejects tables and thresholds it cannot
+ * govern with, and applies the initial level's periods. Fed synthetic drained
+ * samples in sample time, the governor moves up after up_dwell_ms when either
+ * the variance or the activity classifier asks for it, and down only after
+ * down_dwell_ms with both agreeing; a variance inside the hysteresis band
+ * holds the level. Stale or unsure classifier outputs are ignored, the
+ * stationary detector pulls a CALM band variance to REST, every change
+ * retunes only the reports whose period differs, rg_get_period() reports the
+ * current level's period of governed reports only, and the residency and entry
+ * counters add up.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "imu_driver.hpp"
+#include "rate_governor.hpp"
+#include "test_check.hpp"
+
+namespace {
+    constexpr uint32_t TICK_US = 10000UL;
+    constexpr float GRAVITY = 9.81f;
+
+    // accel on at every level, gyro off at REST, rotation vector only when VIGOROUS
+    const rg_rpt_rates_t RATES[] = {
+        {SH2_ACCELEROMETER, {100000UL, 20000UL, 5000UL}},
+        {SH2_GYROSCOPE_CALIBRATED, {0, 20000UL, 5000UL}},
+        {SH2_ROTATION_VECTOR, {0, 0, 10000UL}},
+    };
+
+    uint32_t now_us = 0;
+    std::vector<std::pair<rg_level_t, rg_level_t>> changes;
+
+    void on_change(rg_level_t from, rg_level_t to) {
+        changes.emplace_back(from, to);
+    }
+
+    rg_config_t base_config() {
+        rg_config_t config;
+        config.rates = RATES;
+        config.rate_count = sizeof(RATES) / sizeof(RATES[0]);
+        config.on_change = on_change;
+        return config;
+    }
+
+    uint32_t period_of(uint8_t report_id) {
+        imu_report_cfg_t live;
+        return imu_get_rpt_cfg(report_id, live) ? live.period_us : 0;
+    }
+
+    bool periods_are(rg_level_t level) {
+        bool ok = true;
+        for (const rg_rpt_rates_t &r : RATES) {
+            ok &= period_of(r.report_id) == r.period_us[level];
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Feed duration_ms of 100 Hz accel whose |accel| alternates gravity +- amp (variance amp^2)
+     * @param extra: a classifier sample fed with every tick, nullptr for none
+     * @return true if the level changed
+     */
+    bool feed(uint32_t duration_ms, float amp, const imu_sample_t *extra = nullptr) {
+        bool changed = false;
+        for (uint32_t t = 0; t < duration_ms * 1000UL; t += TICK_US, now_us += TICK_US) {
+            imu_sample_t batch[2] = {};
+            batch[0].report_id = SH2_ACCELEROMETER;
+            batch[0].timestamp_us = now_us;
+            batch[0].data.vec = {0.0f, 0.0f, GRAVITY + (((now_us / TICK_US) % 2 == 0) ? amp : -amp)};
+            size_t n = 1;
+            if (extra != nullptr) {
+                batch[1] = *extra;
+                batch[1].timestamp_us = now_us;
+                n = 2;
+            }
+            changed |= rg_feed(batch, n);
+        }
+        return changed;
+    }
+
+    imu_sample_t activity(BNO08xActivity state, uint8_t confidence) {
+        imu_sample_t s = {};
+        s.report_id = SH2_PERSONAL_ACTIVITY_CLASSIFIER;
+        s.data.activity = {static_cast<uint8_t>(state), confidence};
+        return s;
+    }
+
+    void test_config() {
+        rg_config_t config = base_config();
+        config.rates = nullptr;
+        CHECK(!rg_init(config));
+
+        // accel must be governed, and on at every level
+        const rg_rpt_rates_t no_accel[] = {{SH2_GYROSCOPE_CALIBRATED, {1, 1, 1}}};
+        config = base_config();
+        config.rates = no_accel;
+        config.rate_count = 1;
+        CHECK(!rg_init(config));
+        const rg_rpt_rates_t accel_off[] = {{SH2_ACCELEROMETER, {0, 20000UL, 5000UL}}};
+        config.rates = accel_off;
+        CHECK(!rg_init(config));
+        const rg_rpt_rates_t twice[] = {RATES[0], RATES[1], RATES[1]};
+        config.rates = twice;
+        config.rate_count = 3;
+        CHECK(!rg_init(config));
+
+        config = base_config();
+        config.vigorous_var = config.calm_var;
+        CHECK(!rg_init(config));
+        config = base_config();
+        config.hysteresis = 1.0f;
+        CHECK(!rg_init(config));
+        config = base_config();
+        config.eval_period_ms = 0;
+        CHECK(!rg_init(config));
+
+        // the initial level's rates go out at once
+        config = base_config();
+        config.initial = RG_LEVEL_REST;
+        CHECK(rg_init(config));
+        CHECK(rg_get_level() == RG_LEVEL_REST);
+        CHECK(periods_are(RG_LEVEL_REST));
+        CHECK(rg_get_stats().entries[RG_LEVEL_REST] == 1);
+        CHECK(std::string(rg_level_to_str(RG_LEVEL_VIGOROUS)) == "VIGOROUS");
+    }
+
+    void test_variance_up_and_down() {
+        CHECK(rg_init(base_config()));
+        changes.clear();
+        const rg_stats_t start = rg_get_stats();
+        CHECK(periods_are(RG_LEVEL_CALM));
+
+        // variance 16 > 12: up after 1 s of windows wanting it, not before
+        CHECK(!feed(900, 4.0f));
+        CHECK(rg_get_level() == RG_LEVEL_CALM);
+        CHECK(feed(600, 4.0f));
+        CHECK(rg_get_level() == RG_LEVEL_VIGOROUS);
+        CHECK(std::fabs(rg_get_variance() - 16.0f) < 0.1f);
+        CHECK(changes.size() == 1 && changes[0].first == RG_LEVEL_CALM && changes[0].second == RG_LEVEL_VIGOROUS);
+        CHECK(periods_are(RG_LEVEL_VIGOROUS));
+        uint32_t period_us = 0;
+        CHECK(rg_get_period(SH2_ROTATION_VECTOR, period_us) && period_us == RATES[2].period_us[RG_LEVEL_VIGOROUS]);
+        CHECK(!rg_get_period(SH2_MAGNETIC_FIELD_CALIBRATED, period_us));
+        // accel and gyro retuned, rotation vector enabled
+        CHECK(rg_get_stats().commands - start.commands == 3);
+
+        // 9 is below vigorous but inside the 30 % hysteresis band: held for good
+        CHECK(!feed(20000, 3.0f));
+        CHECK(rg_get_level() == RG_LEVEL_VIGOROUS);
+
+        // 4 is under the band: down after 10 s, not before
+        CHECK(!feed(9000, 2.0f));
+        CHECK(rg_get_stats().held > 0);
+        CHECK(feed(2000, 2.0f));
+        CHECK(rg_get_level() == RG_LEVEL_CALM);
+        CHECK(periods_are(RG_LEVEL_CALM));
+
+        // a still collar goes to REST after another 10 s, gyro off
+        CHECK(feed(11000, 0.01f));
+        CHECK(rg_get_level() == RG_LEVEL_REST);
+        CHECK(period_of(SH2_GYROSCOPE_CALIBRATED) == 0);
+
+        // residency covers the fed time, one entry per level visited
+        const rg_stats_t stats = rg_get_stats();
+        uint64_t total = 0;
+        for (uint64_t r : stats.residency_us) {
+            total += r;
+        }
+        CHECK(total + TICK_US == 1500000ULL + 20000000ULL + 11000000ULL + 11000000ULL);
+        CHECK(stats.entries[RG_LEVEL_VIGOROUS] == 1 && stats.entries[RG_LEVEL_REST] == 1);
+        CHECK(stats.windows > 0 && stats.failed == 0);
+    }
+
+    void test_classifiers() {
+        CHECK(rg_init(base_config()));
+        changes.clear();
+
+        // a sure RUNNING output moves up on its own; an unsure one does not
+        const imu_sample_t unsure = activity(BNO08xActivity::RUNNING, 30);
+        CHECK(!feed(2000, 0.3f, &unsure));
+        CHECK(rg_get_level() == RG_LEVEL_CALM);
+        const imu_sample_t running = activity(BNO08xActivity::RUNNING, 90);
+        CHECK(feed(1600, 0.3f, &running));
+        CHECK(rg_get_level() == RG_LEVEL_VIGOROUS);
+
+        // walking keeps CALM against a still variance until the output goes stale (5 s)
+        const imu_sample_t walking = activity(BNO08xActivity::WALKING, 90);
+        CHECK(feed(11000, 0.3f, &walking));
+        CHECK(rg_get_level() == RG_LEVEL_CALM);
+        CHECK(!feed(11000, 0.01f, &walking));
+        CHECK(rg_get_level() == RG_LEVEL_CALM);
+        feed(1, 0.01f, &walking);
+        CHECK(feed(16000, 0.01f));
+        CHECK(rg_get_level() == RG_LEVEL_REST);
+
+        // the stationary detector pulls a CALM band variance down to REST
+        CHECK(rg_init(base_config()));
+        imu_sample_t stable = {};
+        stable.report_id = SH2_STABILITY_CLASSIFIER;
+        stable.data.value = static_cast<uint32_t>(BNO08xStability::STATIONARY);
+        CHECK(feed(11000, 0.5f, &stable));
+        CHECK(rg_get_level() == RG_LEVEL_REST);
+    }
+
+    void test_reapply() {
+        CHECK(rg_init(base_config()));
+        const uint32_t commands = rg_get_stats().commands;
+
+        // nothing differs: nothing sent
+        rg_reapply();
+        CHECK(rg_get_stats().commands == commands);
+
+        // something else retuned the gyro: only it goes back
+        CHECK(imu_enable_rpt(SH2_GYROSCOPE_CALIBRATED, 2500UL));
+        rg_reapply();
+        CHECK(rg_get_stats().commands == commands + 1);
+        CHECK(periods_are(RG_LEVEL_CALM));
+
+        rg_reset_stats();
+        const rg_stats_t stats = rg_get_stats();
+        CHECK(stats.commands == 0 && stats.windows == 0 && stats.entries[RG_LEVEL_CALM] == 0);
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_NONE);
+    if (!imu_init()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    test_config();
+    test_variance_up_and_down();
+    test_classifiers();
+    test_reapply();
+
+    CHECK(imu_disable_all_rpts());
+    return test::result("rate_governor_test");
+}
@@ -0,0 +1,39 @@
+// test_check.hpp
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+/**
+ * CHECK() for the host tests. A failed condition prints its file, line and
+ * text and is counted; the test keeps going, so one run lists every failure.
+ * main() returns test::result().
+ */
+
+#include <cstdio>
+
+namespace test {
+inline int failures = 0;
+
+/**
+* @brief Print the test's summary line
+* @param name: test name, printed first
+* @return exit code for main(), 1 if any check failed
+*/
+inline int result(const char *name) {
+    if (failures != 0) {
+        std::fprintf(stderr, "%s: %d checks failed\n", name, failures);
+        return 1;
+    }
+    std::printf("%s: all checks passed\n", name);
+    return 0;
+}
+} // namespace test
+
+#define CHECK(cond)                                                                        \
+    do {                                                                                   \
+        if (!(cond)) {                                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            test::failures++;                                                              \
+        }                                                                                  \
+    } while (0)
+
+#endif /* TEST_CHECK_H */
@@ -0,0 +1,293 @@
+/**
+ * zero_heap host test: malloc and friends are interposed so every allocation
+ * in the process reaches heap_guard, as esp_heap_trace_alloc_hook() does on
+ * target. After init the data path runs the data_processing_task and
+ * pm_task loops (ring drain, binlog, sig motion wake and
+ * re-arm, report rate changes, subscriber fan-out, latest cache and metrics
+ * reads) with the guard armed, and any allocation fails the test.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <new>
+#include <vector>
+
+#include "binlog.hpp"
+#include "bno08x_sim.hpp"
+#include "esp_log.h"
+#include "freertos/task.h"
+#include "heap_guard.hpp"
+#include "imu_driver.hpp"
+#include "test_check.hpp"
+
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t n, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void* ptr);
+
+    // operator new and the C runtime both end up here
+    void* malloc(size_t size) {
+        heap_guard_on_alloc(size, __builtin_return_address(0));
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t n, size_t size) {
+        heap_guard_on_alloc(n * size, __builtin_return_address(0));
+        return __libc_calloc(n, size);
+    }
+
+    void* realloc(void* ptr, size_t size) {
+        heap_guard_on_alloc(size, __builtin_return_address(0));
+        return __libc_realloc(ptr, size);
+    }
+
+    void* memalign(size_t alignment, size_t size) {
+        heap_guard_on_alloc(size, __builtin_return_address(0));
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) {
+        heap_guard_on_alloc(size, __builtin_return_address(0));
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** out, size_t alignment, size_t size) {
+        heap_guard_on_alloc(size, __builtin_return_address(0));
+        void* ptr = __libc_memalign(alignment, size);
+        if (ptr == nullptr) {
+            return 12; // ENOMEM
+        }
+        *out = ptr;
+        return 0;
+    }
+
+    void free(void* ptr) {
+        __libc_free(ptr);
+    }
+}
+
+// replaced as well so the recorded caller is the new expression, not libstdc++
+void* operator new(std::size_t size) {
+    heap_guard_on_alloc(size, __builtin_return_address(0));
+    void* ptr = __libc_malloc(size != 0 ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size) {
+    heap_guard_on_alloc(size, __builtin_return_address(0));
+    void* ptr = __libc_malloc(size != 0 ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    __libc_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    __libc_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    __libc_free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    __libc_free(ptr);
+}
+
+namespace {
+    constexpr uint8_t processing_rpts[] = {
+        SH2_ACCELEROMETER,
+        SH2_GYROSCOPE_CALIBRATED,
+        SH2_ROTATION_VECTOR,
+        SH2_PERSONAL_ACTIVITY_CLASSIFIER,
+        SH2_STABILITY_CLASSIFIER,
+    };
+    constexpr uint32_t PERIOD_US = 10000UL;
+    constexpr uint32_t CYCLE_US = 100000UL;      ///< stream time injected between two data_processing_task wakes
+    constexpr uint32_t WARMUP_CYCLES = 20;
+    constexpr uint32_t DURATION_US = 30000000UL;
+
+    uint32_t binlog_bytes = 0;
+    uint32_t logger_samples = 0;
+    uint32_t uplink_samples = 0;
+
+    size_t binlog_sink(const void*, size_t len) {
+        binlog_bytes += static_cast<uint32_t>(len);
+        return len;
+    }
+
+    void logger_cb(const imu_sample_t&, void*) {
+        logger_samples++;
+    }
+
+    void uplink_cb(const imu_sample_t&, void*) {
+        uplink_samples++;
+    }
+
+    /// @brief The hook must see both C and C++ allocations, or a pass would mean nothing
+    void test_hook_counts() {
+        heap_guard_reset_stats();
+        heap_guard_arm();
+        void* volatile p = std::malloc(24);
+        int* volatile q = new int(7);
+        heap_guard_disarm();
+        std::free(p);
+        delete q;
+
+        const heap_guard_stats_t stats = heap_guard_get_stats();
+        CHECK(stats.allocs == 2);
+        CHECK(stats.first_size == 24);
+        CHECK(stats.first_caller != nullptr);
+
+        // disarmed allocations are not counted
+        void* volatile r = std::malloc(8);
+        std::free(r);
+        CHECK(heap_guard_get_stats().allocs == 2);
+        heap_guard_reset_stats();
+    }
+
+    /// @brief One data_processing_task wake: drain the ring in bursts and log every sample
+    size_t drain_and_log() {
+        static imu_sample_t batch[32];
+        size_t total = 0;
+        size_t n;
+        while ((n = imu_sample_ring_drain_burst(batch, 32, 0)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                BINLOG_I("TEST", "Sample %u: %.2f, %.2f, %.2f", batch[i].report_id, batch[i].data.vec.x,
+                        batch[i].data.vec.y, batch[i].data.vec.z);
+            }
+            total += n;
+        }
+        return total;
+    }
+
+    void test_steady_state() {
+        // ---------- init: everything here may allocate ----------
+        binlog_config_t log_config;
+        log_config.sink = BINLOG_SINK_BINARY;
+        log_config.write = binlog_sink;
+        log_config.drain_period_ms = 10;
+        CHECK(binlog_start(log_config));
+        CHECK(imu_events_start());
+
+        imu_report_cfg_t rpts[sizeof(processing_rpts)];
+        for (size_t i = 0; i < sizeof(processing_rpts); i++) {
+            rpts[i] = {static_cast<sh2_SensorId_t>(processing_rpts[i]), PERIOD_US};
+        }
+        CHECK(imu_enable_multi_rpts(rpts, sizeof(processing_rpts)));
+        CHECK(imu_enable_rpt(SH2_SIGNIFICANT_MOTION, 100000UL));
+        CHECK(imu_sample_ring_start());
+
+        imu_sub_cfg_t sub;
+        sub.report_mask = IMU_RPT_BIT(SH2_ACCELEROMETER) | IMU_RPT_BIT(SH2_GYROSCOPE_CALIBRATED);
+        sub.fn = logger_cb;
+        CHECK(imu_subscribe(sub) >= 0);
+        sub.report_mask = IMU_RPT_BIT(SH2_ROTATION_VECTOR);
+        sub.fn = uplink_cb;
+        sub.decimation = 10;
+        CHECK(imu_subscribe(sub) >= 0);
+
+        std::vector<bno08x_sim_sample_t> stream;
+        bno08x_sim::generate(bno08x_sim_profile_t::WALK, processing_rpts, sizeof(processing_rpts), PERIOD_US,
+                DURATION_US, stream);
+        bno08x_sim_sample_t motion;
+        motion.report_id = SH2_SIGNIFICANT_MOTION;
+        motion.v[0] = 1.0f;
+
+        // two report profiles the loop switches between, as a rate governor would, sig motion in both
+        constexpr size_t N_PROFILE = sizeof(processing_rpts) + 1;
+        imu_report_cfg_t fast[N_PROFILE];
+        imu_report_cfg_t slow[N_PROFILE];
+        for (size_t i = 0; i < sizeof(processing_rpts); i++) {
+            fast[i] = rpts[i];
+            slow[i] = rpts[i];
+            slow[i].period_us = 2 * PERIOD_US;
+        }
+        fast[N_PROFILE - 1] = {SH2_SIGNIFICANT_MOTION, 100000UL};
+        slow[N_PROFILE - 1] = fast[N_PROFILE - 1];
+        static uint8_t metrics[IMU_METRICS_SNAPSHOT_MAX];
+
+        // ---------- steady state: the first cycles warm lazy first-use paths, then armed ----------
+        size_t pos = 0;
+        uint32_t cycles = 0;
+        size_t drained = 0;
+        uint32_t motions = 0;
+        uint32_t wakes = 0;
+        for (uint32_t t_us = CYCLE_US; pos < stream.size(); t_us += CYCLE_US, cycles++) {
+            if (cycles == WARMUP_CYCLES) {
+                heap_guard_reset_stats();
+                heap_guard_arm();
+            }
+
+            while (pos < stream.size() && stream[pos].t_us <= t_us) {
+                bno08x_sim::inject(stream[pos++]);
+            }
+            drained += drain_and_log();
+
+            // pm_task in SLEEP: wake on sig motion, re-arm the one-shot report
+            if (cycles % 10 == 5) {
+                motion.t_us = t_us;
+                bno08x_sim::inject(motion);
+                motions++;
+                if (imu_wait_events(IMU_EVT_SIG_MOTION, 0) & IMU_EVT_SIG_MOTION) {
+                    wakes++;
+                    imu_rearm_sig_motion();
+                }
+            }
+
+            if (cycles % 20 == 10) {
+                imu_apply_rpt_profile((cycles / 20) % 2 ? slow : fast, N_PROFILE);
+            }
+
+            imu_sample_t latest;
+            imu_latest_read(SH2_ROTATION_VECTOR, latest);
+            if (cycles % 50 == 0) {
+                imu_metrics_snapshot(metrics, sizeof(metrics));
+            }
+        }
+        // let the binlog task drain what the loop queued while still armed
+        vTaskDelay(pdMS_TO_TICKS(50));
+        heap_guard_disarm();
+
+        const heap_guard_stats_t stats = heap_guard_get_stats();
+        if (stats.allocs != 0) {
+            Dl_info info = {};
+            dladdr(stats.first_caller, &info);
+            std::fprintf(stderr, "zero_heap_test: %u allocations (%u B) after init, first %u B from %p (%s)\n",
+                    static_cast<unsigned>(stats.allocs), static_cast<unsigned>(stats.bytes),
+                    static_cast<unsigned>(stats.first_size), stats.first_caller,
+                    info.dli_sname != nullptr ? info.dli_sname : "?");
+        }
+        CHECK(stats.allocs == 0);
+
+        // the loop really ran the paths it claims to cover
+        CHECK(drained > stream.size() / 2);
+        CHECK(motions > 0 && wakes == motions);
+        CHECK(logger_samples > 0);
+        CHECK(uplink_samples > 0);
+        CHECK(binlog_bytes > 0);
+    }
+} // namespace
+
+int main() {
+    esp_log_level_set("*", ESP_LOG_WARN);
+    if (!imu_init()) {
+        std::fprintf(stderr, "imu_init failed\n");
+        return 1;
+    }
+
+    test_hook_counts();
+    test_steady_state();
+
+    return test::result("zero_heap_test");
+}
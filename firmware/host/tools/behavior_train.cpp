@@ -0,0 +1,625 @@
+/**
+ * behavior_train: train the behavior classifier and write its int8 weights as
+ * components/behavior/behavior_model.hpp.
+ *
+ * Examples are windows of in_len feature vectors from behavior_feature_engine,
+ * run on simulated sessions of each behavior (bno08x_sim profiles) and on any
+ * labelled recordings given as class=file.csv (bno08x_sim::load_csv format,
+ * one behavior per file). Amplitude features are scaled by a random gain per
+ * window so the model keys on the shape of the motion more than on one
+ * synthetic pet's strength. A float network is trained with SGD, quantized
+ * after training (per channel weights, activation ranges from the training
+ * set) and checked through the firmware kernels on held out sessions before
+ * the header is written.
+ *
+ * usage: behavior_train out.hpp [class=recording.csv ...] [--epochs N] [--seed N]
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "behavior_classifier.hpp"
+#include "behavior_features.hpp"
+#include "bno08x_sim.hpp"
+
+namespace
+{
+    constexpr size_t T = 8;                   ///< feature vectors per example
+    constexpr size_t F = BEHAVIOR_F_COUNT;
+    constexpr size_t K = BEHAVIOR_CLASS_COUNT;
+    constexpr int32_t IN_ZP = -128;
+    constexpr uint32_t SESSION_US = 120000000UL;
+    constexpr uint32_t TRAIN_SEEDS = 5;
+    constexpr uint32_t VALIDATION_SEED = 1000;
+
+    /// @brief Amplitude features, compressed with sqrt on the collar and scaled by the augmentation gain
+    constexpr uint32_t SQRT_MASK = (1U << BEHAVIOR_F_ACC_ENERGY) | (1U << BEHAVIOR_F_ACC_VAR_X) |
+                                   (1U << BEHAVIOR_F_ACC_VAR_Y) | (1U << BEHAVIOR_F_ACC_VAR_Z) |
+                                   (1U << BEHAVIOR_F_GYRO_ENERGY) | (1U << BEHAVIOR_F_GYRO_VAR_X) |
+                                   (1U << BEHAVIOR_F_GYRO_VAR_Y) | (1U << BEHAVIOR_F_GYRO_VAR_Z);
+
+    constexpr bno08x_sim_profile_t class_profiles[K] = {
+        bno08x_sim_profile_t::SLEEP,   bno08x_sim_profile_t::WALK, bno08x_sim_profile_t::RUN,
+        bno08x_sim_profile_t::SCRATCH, bno08x_sim_profile_t::EAT,  bno08x_sim_profile_t::SHAKE,
+    };
+
+    constexpr uint8_t session_rpts[] = {SH2_ACCELEROMETER, SH2_GYROSCOPE_CALIBRATED, SH2_ROTATION_VECTOR};
+
+    /// @brief xorshift32, the same sequence on every host
+    struct rng_t {
+        uint32_t state;
+
+        uint32_t next()
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        double uniform(double lo, double hi) { return lo + (hi - lo) * (next() >> 8) * (1.0 / 16777216.0); }
+    };
+
+    struct example_t {
+        behavior_features_t v[T];
+        uint8_t label;
+    };
+
+    bool to_imu_sample(const bno08x_sim_sample_t& in, imu_sample_t& out)
+    {
+        out = {};
+        out.timestamp_us = in.t_us;
+        out.report_id = in.report_id;
+        out.accuracy = in.accuracy;
+        switch (imu_sample_kind(in.report_id))
+        {
+            case IMU_SAMPLE_VEC:
+                out.data.vec = {in.v[0], in.v[1], in.v[2]};
+                return true;
+            case IMU_SAMPLE_QUAT:
+                out.data.quat = {in.v[0], in.v[1], in.v[2], in.v[3]};
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /// @brief Feature vectors of a stream, then one example per window of T consecutive vectors
+    void add_examples(const std::vector<bno08x_sim_sample_t>& stream, uint8_t label, std::vector<example_t>& out)
+    {
+        static behavior_feature_engine engine;
+        engine.configure(behavior_features_config_t{});
+        std::vector<behavior_features_t> vectors;
+        for (const bno08x_sim_sample_t& s : stream)
+        {
+            imu_sample_t sample;
+            behavior_features_t v;
+            if (to_imu_sample(s, sample) && engine.push(sample, v))
+                vectors.push_back(v);
+        }
+        for (size_t i = 0; i + T <= vectors.size(); i++)
+        {
+            example_t ex;
+            std::copy(vectors.begin() + i, vectors.begin() + i + T, ex.v);
+            ex.label = label;
+            out.push_back(ex);
+        }
+    }
+
+    void add_sessions(uint32_t first_seed, uint32_t n_seeds, std::vector<example_t>& out)
+    {
+        for (size_t c = 0; c < K; c++)
+        {
+            for (uint32_t seed = first_seed; seed < first_seed + n_seeds; seed++)
+            {
+                std::vector<bno08x_sim_sample_t> stream;
+                bno08x_sim::generate(class_profiles[c], session_rpts, sizeof(session_rpts), 10000UL, SESSION_US,
+                        stream, 0x9E3779B9U * (seed + 1U) + c);
+                add_examples(stream, static_cast<uint8_t>(c), out);
+            }
+        }
+    }
+
+    /// @brief Scale the amplitude features of a whole window by one gain, energies and variances by its square
+    void augment(example_t& ex, rng_t& rng)
+    {
+        const float gain = static_cast<float>(rng.uniform(0.6, 1.6));
+        for (behavior_features_t& v : ex.v)
+        {
+            for (size_t f = 0; f < F; f++)
+            {
+                if ((SQRT_MASK >> f) & 1U)
+                    v.v[f] *= gain * gain;
+            }
+            v.v[BEHAVIOR_F_ACC_JERK] *= gain;
+        }
+    }
+
+    // ======================================================================
+    // FLOAT NETWORK
+    // ======================================================================
+
+    /// @brief Float twin of behavior_layer_t: one weight row of n per output, dotted with n contiguous inputs
+    struct layer_t {
+        behavior_layer_type_t type;
+        size_t kernel, in_len, in_ch, out_ch;
+        bool relu;
+        std::vector<double> w, b, vw, vb, gw, gb;
+
+        size_t n() const { return type == BEHAVIOR_LAYER_DENSE ? in_len * in_ch : kernel * in_ch; }
+        size_t out_len() const { return type == BEHAVIOR_LAYER_DENSE ? 1 : in_len - kernel + 1; }
+        size_t out_size() const { return out_len() * out_ch; }
+    };
+
+    struct network_t {
+        std::vector<layer_t> layers;
+    };
+
+    layer_t make_layer(behavior_layer_type_t type, size_t kernel, size_t in_len, size_t in_ch, size_t out_ch, bool relu,
+            rng_t& rng)
+    {
+        layer_t l{type, kernel, in_len, in_ch, out_ch, relu, {}, {}, {}, {}, {}, {}};
+        const size_t n = l.n();
+        const double limit = std::sqrt(6.0 / static_cast<double>(n));
+        l.w.resize(out_ch * n);
+        for (double& w : l.w)
+            w = rng.uniform(-limit, limit);
+        l.b.assign(out_ch, 0.0);
+        l.vw.assign(l.w.size(), 0.0);
+        l.vb.assign(out_ch, 0.0);
+        l.gw.assign(l.w.size(), 0.0);
+        l.gb.assign(out_ch, 0.0);
+        return l;
+    }
+
+    /// @brief conv1d 13 -> 16 (k 3), conv1d 16 -> 16 (k 3), dense 64 -> 24, dense 24 -> 6
+    network_t make_network(rng_t& rng)
+    {
+        network_t net;
+        net.layers.push_back(make_layer(BEHAVIOR_LAYER_CONV1D, 3, T, F, 16, true, rng));
+        net.layers.push_back(make_layer(BEHAVIOR_LAYER_CONV1D, 3, T - 2, 16, 16, true, rng));
+        net.layers.push_back(make_layer(BEHAVIOR_LAYER_DENSE, 0, T - 4, 16, 24, true, rng));
+        net.layers.push_back(make_layer(BEHAVIOR_LAYER_DENSE, 0, 1, 24, K, false, rng));
+        return net;
+    }
+
+    /// @brief acts[0] is the input, acts[i + 1] the output of layer i
+    void forward(const network_t& net, std::vector<std::vector<double>>& acts)
+    {
+        acts.resize(net.layers.size() + 1);
+        for (size_t i = 0; i < net.layers.size(); i++)
+        {
+            const layer_t& l = net.layers[i];
+            const std::vector<double>& in = acts[i];
+            std::vector<double>& out = acts[i + 1];
+            out.assign(l.out_size(), 0.0);
+            const size_t n = l.n();
+            for (size_t c = 0; c < l.out_ch; c++)
+            {
+                for (size_t t = 0; t < l.out_len(); t++)
+                {
+                    double acc = l.b[c];
+                    for (size_t j = 0; j < n; j++)
+                        acc += l.w[c * n + j] * in[t * l.in_ch + j];
+                    out[t * l.out_ch + c] = (l.relu && acc < 0.0) ? 0.0 : acc;
+                }
+            }
+        }
+    }
+
+    /// @brief Softmax cross entropy gradients into gw / gb, returns the loss
+    double backward(network_t& net, std::vector<std::vector<double>>& acts, uint8_t label)
+    {
+        std::vector<double> grad = acts.back();
+        const double top = *std::max_element(grad.begin(), grad.end());
+        double sum = 0.0;
+        for (double& g : grad)
+        {
+            g = std::exp(g - top);
+            sum += g;
+        }
+        for (double& g : grad)
+            g /= sum;
+        const double loss = -std::log(std::max(grad[label], 1e-12));
+        grad[label] -= 1.0;
+
+        for (size_t i = net.layers.size(); i-- > 0;)
+        {
+            layer_t& l = net.layers[i];
+            const std::vector<double>& in = acts[i];
+            const std::vector<double>& out = acts[i + 1];
+            std::vector<double> grad_in(in.size(), 0.0);
+            const size_t n = l.n();
+            for (size_t c = 0; c < l.out_ch; c++)
+            {
+                for (size_t t = 0; t < l.out_len(); t++)
+                {
+                    double g = grad[t * l.out_ch + c];
+                    if (l.relu && out[t * l.out_ch + c] <= 0.0)
+                        g = 0.0;
+                    if (g == 0.0)
+                        continue;
+                    l.gb[c] += g;
+                    for (size_t j = 0; j < n; j++)
+                    {
+                        l.gw[c * n + j] += g * in[t * l.in_ch + j];
+                        grad_in[t * l.in_ch + j] += g * l.w[c * n + j];
+                    }
+                }
+            }
+            grad.swap(grad_in);
+        }
+        return loss;
+    }
+
+    void step(network_t& net, double lr, size_t batch)
+    {
+        constexpr double MOMENTUM = 0.9;
+        constexpr double DECAY = 1e-4;
+        for (layer_t& l : net.layers)
+        {
+            for (size_t i = 0; i < l.w.size(); i++)
+            {
+                l.vw[i] = MOMENTUM * l.vw[i] - lr * (l.gw[i] / batch + DECAY * l.w[i]);
+                l.w[i] += l.vw[i];
+                l.gw[i] = 0.0;
+            }
+            for (size_t i = 0; i < l.b.size(); i++)
+            {
+                l.vb[i] = MOMENTUM * l.vb[i] - lr * l.gb[i] / batch;
+                l.b[i] += l.vb[i];
+                l.gb[i] = 0.0;
+            }
+        }
+    }
+
+    // ======================================================================
+    // QUANTIZATION
+    // ======================================================================
+
+    /// @brief Backing storage of a behavior_model_t built at run time
+    struct quant_model_t {
+        float in_gain[F];
+        std::vector<std::vector<int8_t>> weights;
+        std::vector<std::vector<int32_t>> bias, mult;
+        std::vector<std::vector<int8_t>> shift;
+        std::vector<behavior_layer_t> layers;
+        behavior_model_t model;
+    };
+
+    /// @brief real multiplier -> Q31 multiplier and exponent, as TFLite's QuantizeMultiplier
+    void quantize_multiplier(double m, int32_t& mult, int8_t& shift)
+    {
+        int exp = 0;
+        const double frac = std::frexp(m, &exp);
+        int64_t q = static_cast<int64_t>(std::llround(frac * 2147483648.0));
+        if (q == (int64_t(1) << 31))
+        {
+            q /= 2;
+            exp++;
+        }
+        if (m <= 0.0 || exp < -31)
+        {
+            q = 0;
+            exp = 0;
+        }
+        mult = static_cast<int32_t>(q);
+        shift = static_cast<int8_t>(exp);
+    }
+
+    void quantize_input(const quant_model_t& qm, const example_t& ex, int8_t* q)
+    {
+        for (size_t t = 0; t < T; t++)
+            behavior_quantize_input(qm.model, ex.v[t], q + t * F);
+    }
+
+    /// @brief Network input as training sees it: the int8 input the collar computes, dequantized
+    void input_acts(const quant_model_t& qm, const example_t& ex, std::vector<double>& in)
+    {
+        int8_t q[T * F];
+        quantize_input(qm, ex, q);
+        in.resize(T * F);
+        for (size_t i = 0; i < T * F; i++)
+            in[i] = (q[i] - IN_ZP) / 255.0;
+    }
+
+    void quantize(const network_t& net, const std::vector<example_t>& calib, quant_model_t& qm)
+    {
+        // activation ranges: ReLU outputs from 0, the logits both ways
+        const size_t L = net.layers.size();
+        std::vector<double> lo(L, 0.0), hi(L, 0.0);
+        std::vector<std::vector<double>> acts(L + 1);
+        for (const example_t& ex : calib)
+        {
+            input_acts(qm, ex, acts[0]);
+            forward(net, acts);
+            for (size_t i = 0; i < L; i++)
+            {
+                for (double a : acts[i + 1])
+                {
+                    lo[i] = std::min(lo[i], a);
+                    hi[i] = std::max(hi[i], a);
+                }
+            }
+        }
+
+        double in_scale = 1.0 / 255.0;
+        int32_t in_zp = IN_ZP;
+        qm.weights.resize(L);
+        qm.bias.resize(L);
+        qm.mult.resize(L);
+        qm.shift.resize(L);
+        qm.layers.resize(L);
+        for (size_t i = 0; i < L; i++)
+        {
+            const layer_t& l = net.layers[i];
+            const double out_scale = std::max(hi[i] - lo[i], 1e-6) / 255.0;
+            const int32_t out_zp = l.relu ? -128
+                                          : std::clamp(static_cast<int32_t>(std::lround(-128.0 - lo[i] / out_scale)),
+                                                    -128, 127);
+            const size_t n = l.n();
+            qm.weights[i].resize(l.w.size());
+            qm.bias[i].resize(l.out_ch);
+            qm.mult[i].resize(l.out_ch);
+            qm.shift[i].resize(l.out_ch);
+            for (size_t c = 0; c < l.out_ch; c++)
+            {
+                double w_max = 0.0;
+                for (size_t j = 0; j < n; j++)
+                    w_max = std::max(w_max, std::fabs(l.w[c * n + j]));
+                const double w_scale = w_max > 0.0 ? w_max / 127.0 : 1.0;
+                for (size_t j = 0; j < n; j++)
+                    qm.weights[i][c * n + j] = static_cast<int8_t>(std::lround(l.w[c * n + j] / w_scale));
+                qm.bias[i][c] = static_cast<int32_t>(std::lround(l.b[c] / (in_scale * w_scale)));
+                quantize_multiplier(in_scale * w_scale / out_scale, qm.mult[i][c], qm.shift[i][c]);
+            }
+            qm.layers[i] = {l.type,
+                            static_cast<uint8_t>(l.kernel),
+                            static_cast<uint16_t>(l.in_len),
+                            static_cast<uint16_t>(l.in_ch),
+                            static_cast<uint16_t>(l.out_ch),
+                            in_zp,
+                            out_zp,
+                            -128,
+                            qm.weights[i].data(),
+                            qm.bias[i].data(),
+                            qm.mult[i].data(),
+                            qm.shift[i].data()};
+            if (l.relu)
+                qm.layers[i].act_min = out_zp;
+            in_scale = out_scale;
+            in_zp = out_zp;
+        }
+        qm.model.layers = qm.layers.data();
+        qm.model.n_layers = L;
+    }
+
+    size_t argmax(const double* v, size_t n)
+    {
+        return static_cast<size_t>(std::max_element(v, v + n) - v);
+    }
+
+    size_t argmax(const int8_t* v, size_t n)
+    {
+        return static_cast<size_t>(std::max_element(v, v + n) - v);
+    }
+
+    struct eval_t {
+        double float_acc = 0.0;
+        double int8_acc = 0.0;
+        double agreement = 0.0;
+        size_t confusion[K][K] = {};
+    };
+
+    eval_t evaluate(const network_t& net, const quant_model_t& qm, const std::vector<example_t>& set)
+    {
+        eval_t e;
+        std::vector<std::vector<double>> acts(net.layers.size() + 1);
+        size_t float_ok = 0, int8_ok = 0, agree = 0;
+        for (const example_t& ex : set)
+        {
+            input_acts(qm, ex, acts[0]);
+            forward(net, acts);
+            const size_t f = argmax(acts.back().data(), K);
+
+            int8_t q[T * F], logits[K];
+            quantize_input(qm, ex, q);
+            behavior_model_run(qm.model, q, logits);
+            const size_t i = argmax(logits, K);
+
+            float_ok += f == ex.label;
+            int8_ok += i == ex.label;
+            agree += f == i;
+            e.confusion[ex.label][i]++;
+        }
+        e.float_acc = 100.0 * float_ok / set.size();
+        e.int8_acc = 100.0 * int8_ok / set.size();
+        e.agreement = 100.0 * agree / set.size();
+        return e;
+    }
+
+    // ======================================================================
+    // HEADER
+    // ======================================================================
+
+    template <typename V>
+    void write_array(FILE* out, const char* type, const std::string& name, const V& values)
+    {
+        std::fprintf(out, "static constexpr %s %s[%zu] = {", type, name.c_str(), values.size());
+        for (size_t i = 0; i < values.size(); i++)
+            std::fprintf(out, "%s%ld,", i % 16 == 0 ? "\n    " : " ", static_cast<long>(values[i]));
+        std::fprintf(out, "\n};\n");
+    }
+
+    bool write_header(const char* path, const quant_model_t& qm, const eval_t& e, size_t n_train, size_t n_recorded)
+    {
+        FILE* out = std::fopen(path, "w");
+        if (out == nullptr)
+            return false;
+
+        std::fprintf(out, "// behavior_model.hpp\n");
+        std::fprintf(out, "// Generated by host/tools/behavior_train, do not edit.\n");
+        std::fprintf(out, "// %zu training windows (%zu from recordings), held out: float %.1f%%, int8 %.1f%%\n",
+                n_train, n_recorded, e.float_acc, e.int8_acc);
+        std::fprintf(out, "#ifndef BEHAVIOR_MODEL_H\n#define BEHAVIOR_MODEL_H\n\n#include \"behavior_classifier.hpp\"\n\n");
+
+        std::fprintf(out, "static constexpr float behavior_model_in_gain[BEHAVIOR_F_COUNT] = {");
+        for (size_t f = 0; f < F; f++)
+            std::fprintf(out, "%s%.9gf,", f % 6 == 0 ? "\n    " : " ", qm.in_gain[f]);
+        std::fprintf(out, "\n};\n\n");
+
+        for (size_t i = 0; i < qm.layers.size(); i++)
+        {
+            const std::string prefix = "behavior_model_l" + std::to_string(i) + "_";
+            write_array(out, "int8_t", prefix + "weights", qm.weights[i]);
+            write_array(out, "int32_t", prefix + "bias", qm.bias[i]);
+            write_array(out, "int32_t", prefix + "mult", qm.mult[i]);
+            write_array(out, "int8_t", prefix + "shift", qm.shift[i]);
+            std::fprintf(out, "\n");
+        }
+
+        std::fprintf(out, "static constexpr behavior_layer_t behavior_model_layers[] = {\n");
+        for (size_t i = 0; i < qm.layers.size(); i++)
+        {
+            const behavior_layer_t& l = qm.layers[i];
+            const std::string prefix = "behavior_model_l" + std::to_string(i) + "_";
+            std::fprintf(out, "    {%s, %u, %u, %u, %u, %ld, %ld, %ld, %sweights, %sbias, %smult, %sshift},\n",
+                    l.type == BEHAVIOR_LAYER_DENSE ? "BEHAVIOR_LAYER_DENSE" : "BEHAVIOR_LAYER_CONV1D",
+                    (unsigned)l.kernel, (unsigned)l.in_len, (unsigned)l.in_ch, (unsigned)l.out_ch, (long)l.in_zp,
+                    (long)l.out_zp, (long)l.act_min, prefix.c_str(), prefix.c_str(), prefix.c_str(), prefix.c_str());
+        }
+        std::fprintf(out, "};\n\n");
+        std::fprintf(out,
+                "static constexpr behavior_model_t behavior_model = {behavior_model_layers, %zu, %zu, "
+                "behavior_model_in_gain,\n                                                    0x%04lx, %ld};\n\n",
+                qm.layers.size(), T, (unsigned long)qm.model.in_sqrt, (long)qm.model.in_zp);
+        std::fprintf(out, "#endif /* BEHAVIOR_MODEL_H */\n");
+        return std::fclose(out) == 0;
+    }
+
+    const char* arg_value(int argc, char** argv, const char* name, const char* fallback)
+    {
+        for (int i = 1; i + 1 < argc; i++)
+        {
+            if (std::strcmp(argv[i], name) == 0)
+                return argv[i + 1];
+        }
+        return fallback;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s out.hpp [class=recording.csv ...] [--epochs N] [--seed N]\n", argv[0]);
+        return 1;
+    }
+    const size_t epochs = std::strtoul(arg_value(argc, argv, "--epochs", "30"), nullptr, 10);
+    rng_t rng{static_cast<uint32_t>(std::strtoul(arg_value(argc, argv, "--seed", "1"), nullptr, 10)) | 1U};
+
+    std::vector<example_t> train, validation;
+    add_sessions(1, TRAIN_SEEDS, train);
+    add_sessions(VALIDATION_SEED, 1, validation);
+    const size_t n_simulated = train.size();
+    for (int i = 2; i < argc; i++)
+    {
+        if (argv[i][0] == '-')
+        {
+            i++;
+            continue;
+        }
+        const char* eq = std::strchr(argv[i], '=');
+        size_t label = K;
+        for (size_t c = 0; eq != nullptr && c < K; c++)
+        {
+            const char* name = behavior_class_to_str(static_cast<behavior_class_t>(c));
+            if (std::strlen(name) == static_cast<size_t>(eq - argv[i]) && std::strncmp(argv[i], name, eq - argv[i]) == 0)
+                label = c;
+        }
+        std::vector<bno08x_sim_sample_t> stream;
+        if (label == K || !bno08x_sim::load_csv(eq + 1, stream))
+        {
+            std::fprintf(stderr, "bad recording %s, expected class=file.csv with class one of sleeping, walking, "
+                    "running, scratching, eating, shaking\n", argv[i]);
+            return 1;
+        }
+        add_examples(stream, static_cast<uint8_t>(label), train);
+    }
+    for (example_t& ex : train)
+        augment(ex, rng);
+    for (example_t& ex : validation)
+        augment(ex, rng);
+
+    // input gains: the training range of each (sqrt compressed) feature onto 0..255 steps, with 10% headroom
+    quant_model_t qm;
+    for (size_t f = 0; f < F; f++)
+    {
+        float hi = 0.0f;
+        for (const example_t& ex : train)
+            for (const behavior_features_t& v : ex.v)
+                hi = std::max(hi, ((SQRT_MASK >> f) & 1U) ? std::sqrt(std::max(v.v[f], 0.0f)) : v.v[f]);
+        qm.in_gain[f] = 255.0f / std::max(1.1f * hi, 1e-3f);
+    }
+    qm.model = {nullptr, 0, T, qm.in_gain, SQRT_MASK, IN_ZP};
+
+    network_t net = make_network(rng);
+    std::vector<size_t> order(train.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::vector<std::vector<double>> acts(net.layers.size() + 1);
+    std::vector<std::vector<double>> inputs(train.size());
+    for (size_t i = 0; i < train.size(); i++)
+        input_acts(qm, train[i], inputs[i]);
+
+    constexpr size_t BATCH = 32;
+    for (size_t epoch = 0; epoch < epochs; epoch++)
+    {
+        for (size_t i = order.size(); i > 1; i--)
+            std::swap(order[i - 1], order[rng.next() % i]);
+        const double lr = 0.02 * (epoch < epochs * 2 / 3 ? 1.0 : 0.1);
+        double loss = 0.0;
+        for (size_t b = 0; b < order.size(); b += BATCH)
+        {
+            const size_t end = std::min(order.size(), b + BATCH);
+            for (size_t i = b; i < end; i++)
+            {
+                acts[0] = inputs[order[i]];
+                forward(net, acts);
+                loss += backward(net, acts, train[order[i]].label);
+            }
+            step(net, lr, end - b);
+        }
+        if (epoch % 5 == 4 || epoch + 1 == epochs)
+            std::printf("epoch %3zu  loss %.4f\n", epoch + 1, loss / order.size());
+    }
+
+    quantize(net, train, qm);
+    const eval_t e = evaluate(net, qm, validation);
+    std::printf("held out %zu windows: float %.1f%%, int8 %.1f%%, int8 agrees with float on %.1f%%\n",
+            validation.size(), e.float_acc, e.int8_acc, e.agreement);
+    std::printf("%-12s", "true \\ int8");
+    for (size_t c = 0; c < K; c++)
+        std::printf(" %10s", behavior_class_to_str(static_cast<behavior_class_t>(c)));
+    std::printf("\n");
+    for (size_t r = 0; r < K; r++)
+    {
+        std::printf("%-12s", behavior_class_to_str(static_cast<behavior_class_t>(r)));
+        for (size_t c = 0; c < K; c++)
+            std::printf(" %10zu", e.confusion[r][c]);
+        std::printf("\n");
+    }
+
+    if (!write_header(argv[1], qm, e, train.size(), train.size() - n_simulated))
+    {
+        std::fprintf(stderr, "failed to write %s\n", argv[1]);
+        return 1;
+    }
+    std::printf("wrote %s\n", argv[1]);
+    return 0;
+}
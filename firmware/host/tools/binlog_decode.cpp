@@ -0,0 +1,145 @@
+/**
+ * binlog_decode: render a binary binlog stream (BINLOG_SINK_BINARY output) as
+ * text with the table written by binlog_table.
+ *
+ * usage: binlog_decode binlog_fmt_table.tsv capture.blg
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "binlog.hpp"
+
+namespace
+{
+    struct fmt_entry_t {
+        char level;
+        std::string where;
+        std::string fmt;
+    };
+
+    std::string unescape(const std::string& text)
+    {
+        std::string out;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            if (text[i] != '\\' || i + 1 >= text.size())
+            {
+                out += text[i];
+                continue;
+            }
+
+            switch (text[++i])
+            {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                default: out += text[i]; break;
+            }
+        }
+        return out;
+    }
+
+    bool load_table(const char* path, std::map<uint32_t, fmt_entry_t>& table)
+    {
+        std::ifstream in(path);
+        if (!in)
+            return false;
+
+        std::string line;
+        while (std::getline(in, line))
+        {
+            size_t t1 = line.find('\t');
+            size_t t2 = line.find('\t', t1 + 1);
+            size_t t3 = line.find('\t', t2 + 1);
+            if (t1 == std::string::npos || t2 == std::string::npos || t3 == std::string::npos)
+                continue;
+
+            const uint32_t id = static_cast<uint32_t>(std::stoul(line.substr(0, t1), nullptr, 16));
+            table[id] = {line[t1 + 1], line.substr(t2 + 1, t3 - t2 - 1), unescape(line.substr(t3 + 1))};
+        }
+        return true;
+    }
+
+    template <typename T>
+    bool read_le(std::FILE* in, T& value)
+    {
+        return std::fread(&value, sizeof(value), 1, in) == 1;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::fprintf(stderr, "usage: %s binlog_fmt_table.tsv capture.blg\n", argv[0]);
+        return 1;
+    }
+
+    std::map<uint32_t, fmt_entry_t> table;
+    if (!load_table(argv[1], table))
+    {
+        std::fprintf(stderr, "binlog_decode: cannot read table %s\n", argv[1]);
+        return 1;
+    }
+
+    std::FILE* in = std::fopen(argv[2], "rb");
+    if (in == nullptr)
+    {
+        std::fprintf(stderr, "binlog_decode: cannot open %s\n", argv[2]);
+        return 1;
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    if (!read_le(in, magic) || !read_le(in, version) || magic != BINLOG_MAGIC || version != BINLOG_VERSION)
+    {
+        std::fprintf(stderr, "binlog_decode: %s is not a binlog v%d stream\n", argv[2], BINLOG_VERSION);
+        std::fclose(in);
+        return 1;
+    }
+
+    static constexpr char level_letter[] = {'N', 'E', 'W', 'I', 'D', 'V'};
+    size_t records = 0;
+    size_t unknown = 0;
+    uint32_t timestamp_us;
+    while (read_le(in, timestamp_us))
+    {
+        uint32_t fmt_id;
+        uint8_t level;
+        uint8_t nargs;
+        uint16_t dropped;
+        uint32_t args[BINLOG_MAX_ARGS] = {};
+        if (!read_le(in, fmt_id) || !read_le(in, level) || !read_le(in, nargs) || !read_le(in, dropped) ||
+                nargs > BINLOG_MAX_ARGS || std::fread(args, sizeof(uint32_t), nargs, in) != nargs)
+        {
+            std::fprintf(stderr, "binlog_decode: truncated record after %zu records\n", records);
+            break;
+        }
+
+        if (dropped != 0)
+            std::printf("-- %u%s records dropped --\n", dropped, dropped == 0xFFFFU ? "+" : "");
+
+        const char letter = (level < sizeof(level_letter)) ? level_letter[level] : '?';
+        auto it = table.find(fmt_id);
+        if (it == table.end())
+        {
+            unknown++;
+            std::printf("%c (%lu) <unknown format 0x%08x, %u args>\n", letter, (unsigned long)timestamp_us, fmt_id, nargs);
+        }
+        else
+        {
+            char text[512];
+            binlog_render(it->second.fmt.c_str(), args, nargs, text, sizeof(text));
+            std::printf("%c (%lu) %s\n", letter, (unsigned long)timestamp_us, text);
+        }
+        records++;
+    }
+
+    std::fclose(in);
+    std::fprintf(stderr, "binlog_decode: %zu records, %zu with unknown formats\n", records, unknown);
+    return 0;
+}
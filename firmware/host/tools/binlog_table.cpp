@@ -0,0 +1,202 @@
+/**
+ * binlog_table: scan firmware sources for BINLOG_x(tag, "format", ...) call sites
+ * and write the format table binlog_decode renders with. IDs are computed with
+ * the same FNV-1a as binlog_fmt_id(), so the table never needs to be kept by hand.
+ *
+ * usage: binlog_table out.tsv <source dir or file>...
+ * table: one line per format, id (hex) <TAB> level <TAB> file:line <TAB> format (C escaped)
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "binlog.hpp"
+
+namespace
+{
+    struct fmt_entry_t {
+        char level;
+        std::string where;
+        std::string fmt;
+    };
+
+    bool is_source(const std::filesystem::path& path)
+    {
+        const std::string ext = path.extension().string();
+        return ext == ".cpp" || ext == ".hpp" || ext == ".c" || ext == ".h";
+    }
+
+    void skip_space(const std::string& src, size_t& pos)
+    {
+        while (pos < src.size())
+        {
+            if (std::isspace(static_cast<unsigned char>(src[pos])))
+                pos++;
+            else if (src.compare(pos, 2, "//") == 0)
+                pos = src.find('\n', pos) == std::string::npos ? src.size() : src.find('\n', pos);
+            else if (src.compare(pos, 2, "/*") == 0)
+                pos = src.find("*/", pos) == std::string::npos ? src.size() : src.find("*/", pos) + 2;
+            else
+                break;
+        }
+    }
+
+    /// @brief Parse one or more adjacent string literals starting at pos, false if there is none
+    bool parse_literals(const std::string& src, size_t& pos, std::string& out)
+    {
+        bool found = false;
+        skip_space(src, pos);
+        while (pos < src.size() && src[pos] == '"')
+        {
+            found = true;
+            pos++;
+            while (pos < src.size() && src[pos] != '"')
+            {
+                char c = src[pos++];
+                if (c != '\\' || pos >= src.size())
+                {
+                    out += c;
+                    continue;
+                }
+
+                char esc = src[pos++];
+                switch (esc)
+                {
+                    case 'n': out += '\n'; break;
+                    case 't': out += '\t'; break;
+                    case 'r': out += '\r'; break;
+                    case '0': out += '\0'; break;
+                    default: out += esc; break;
+                }
+            }
+            pos++;
+            skip_space(src, pos);
+        }
+        return found;
+    }
+
+    /// @brief Advance past the first macro argument (the tag), honoring nested parentheses
+    bool skip_argument(const std::string& src, size_t& pos)
+    {
+        int depth = 0;
+        while (pos < src.size())
+        {
+            char c = src[pos++];
+            if (c == '(')
+                depth++;
+            else if (c == ')' && depth-- == 0)
+                return false;
+            else if (c == ',' && depth == 0)
+                return true;
+        }
+        return false;
+    }
+
+    std::string escape(const std::string& fmt)
+    {
+        std::string out;
+        for (char c : fmt)
+        {
+            switch (c)
+            {
+                case '\n': out += "\\n"; break;
+                case '\t': out += "\\t"; break;
+                case '\r': out += "\\r"; break;
+                case '\\': out += "\\\\"; break;
+                default: out += c; break;
+            }
+        }
+        return out;
+    }
+
+    size_t scan_file(const std::filesystem::path& path, std::map<uint32_t, fmt_entry_t>& table)
+    {
+        std::ifstream in(path);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        const std::string src = buffer.str();
+
+        size_t found = 0;
+        size_t pos = 0;
+        while ((pos = src.find("BINLOG_", pos)) != std::string::npos)
+        {
+            const size_t start = pos;
+            pos += 7;
+            if (pos >= src.size() || std::strchr("EWIDV", src[pos]) == nullptr)
+                continue;
+            if (start > 0 && (std::isalnum(static_cast<unsigned char>(src[start - 1])) || src[start - 1] == '_'))
+                continue;
+
+            const char level = src[pos++];
+            skip_space(src, pos);
+            if (pos >= src.size() || src[pos] != '(')
+                continue;
+            pos++;
+
+            std::string fmt;
+            if (!skip_argument(src, pos) || !parse_literals(src, pos, fmt))
+                continue;
+
+            const uint32_t id = binlog_fmt_id(fmt.data(), fmt.size());
+            const size_t line = 1 + static_cast<size_t>(std::count(src.begin(), src.begin() + start, '\n'));
+            const std::string where = path.filename().string() + ":" + std::to_string(line);
+
+            auto it = table.find(id);
+            if (it != table.end() && it->second.fmt != fmt)
+                std::fprintf(stderr, "binlog_table: ID collision 0x%08x between %s and %s\n", id,
+                        it->second.where.c_str(), where.c_str());
+            else if (it == table.end())
+                table[id] = {level, where, fmt};
+            found++;
+        }
+        return found;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::fprintf(stderr, "usage: %s out.tsv <source dir or file>...\n", argv[0]);
+        return 1;
+    }
+
+    std::map<uint32_t, fmt_entry_t> table;
+    size_t sites = 0;
+    for (int i = 2; i < argc; i++)
+    {
+        const std::filesystem::path root(argv[i]);
+        if (std::filesystem::is_regular_file(root))
+        {
+            sites += scan_file(root, table);
+            continue;
+        }
+
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(root))
+        {
+            if (entry.is_regular_file() && is_source(entry.path()))
+                sites += scan_file(entry.path(), table);
+        }
+    }
+
+    std::FILE* out = std::fopen(argv[1], "w");
+    if (out == nullptr)
+    {
+        std::fprintf(stderr, "binlog_table: cannot write %s\n", argv[1]);
+        return 1;
+    }
+
+    for (const auto& [id, entry] : table)
+        std::fprintf(out, "%08x\t%c\t%s\t%s\n", id, entry.level, entry.where.c_str(), escape(entry.fmt).c_str());
+    std::fclose(out);
+
+    std::printf("binlog_table: %zu call sites, %zu formats -> %s\n", sites, table.size(), argv[1]);
+    return 0;
+}
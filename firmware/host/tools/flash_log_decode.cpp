@@ -0,0 +1,155 @@
+/**
+ * flash_log_decode: stream a flash_log partition image (flash_log_format.hpp)
+ * as CSV, oldest record first. The image is mapped, not read, so multi-MB
+ * dumps decode without copying; only the sectors of the live ring are touched.
+ *
+ * usage: flash_log_decode log.img [--summary]
+ * output: timestamp_us,report_id,accuracy,values... (x,y,z / real,i,j,k / state,confidence / value)
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "flash_log_format.hpp"
+#include "imu_driver.hpp"
+
+namespace
+{
+    struct decode_stats_t {
+        size_t sectors = 0;
+        size_t blocks = 0;
+        size_t bad_blocks = 0;
+        size_t records = 0;
+        uint32_t first_us = 0;
+        uint32_t last_us = 0;
+    };
+
+    void print_sample(const imu_sample_t& s)
+    {
+        std::printf("%lu,%u,%u,", (unsigned long)s.timestamp_us, s.report_id, s.accuracy);
+        switch (imu_sample_kind(s.report_id))
+        {
+            case IMU_SAMPLE_VEC:
+                std::printf("%.6g,%.6g,%.6g\n", s.data.vec.x, s.data.vec.y, s.data.vec.z);
+                break;
+            case IMU_SAMPLE_QUAT:
+                std::printf("%.6f,%.6f,%.6f,%.6f\n", s.data.quat.real, s.data.quat.i, s.data.quat.j, s.data.quat.k);
+                break;
+            case IMU_SAMPLE_ACTIVITY:
+                std::printf("%u,%u\n", s.data.activity.state, s.data.activity.confidence);
+                break;
+            case IMU_SAMPLE_VALUE:
+                std::printf("%lu\n", (unsigned long)s.data.value);
+                break;
+        }
+    }
+
+    void decode_sector(const uint8_t* sector, uint32_t end_block, bool print, decode_stats_t& stats)
+    {
+        stats.sectors++;
+        for (uint32_t b = 1; b < end_block; b++)
+        {
+            const uint8_t* block = sector + b * FLASH_LOG_BLOCK_SIZE;
+            if (flash_log_block_erased(block))
+                break;
+
+            flash_log_block_hdr_t hdr;
+            std::memcpy(&hdr, block, sizeof(hdr));
+            if (!flash_log_block_valid(block) || hdr.format != FLASH_LOG_FMT_COMPACT)
+            {
+                stats.bad_blocks++;
+                continue;
+            }
+
+            stats.blocks++;
+            for (uint8_t r = 0; r < hdr.count; r++)
+            {
+                imu_compact_sample_t record;
+                std::memcpy(&record, block + FLASH_LOG_BLOCK_HDR_SIZE + r * sizeof(record), sizeof(record));
+                if (stats.records == 0)
+                    stats.first_us = record.timestamp_us;
+                stats.last_us = record.timestamp_us;
+                stats.records++;
+
+                if (print)
+                {
+                    imu_sample_t sample;
+                    imu_compact_unpack(record, sample);
+                    print_sample(sample);
+                }
+            }
+        }
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s log.img [--summary]\n", argv[0]);
+        return 1;
+    }
+    const bool print = !(argc > 2 && std::strcmp(argv[2], "--summary") == 0);
+
+    const int fd = open(argv[1], O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < FLASH_LOG_SECTOR_SIZE)
+    {
+        std::fprintf(stderr, "flash_log_decode: cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    const uint8_t* image = static_cast<const uint8_t*>(mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0));
+    close(fd);
+    if (image == MAP_FAILED)
+    {
+        std::fprintf(stderr, "flash_log_decode: cannot map %s\n", argv[1]);
+        return 1;
+    }
+    madvise(const_cast<uint8_t*>(image), size, MADV_SEQUENTIAL);
+
+    const uint32_t sectors = static_cast<uint32_t>(size / FLASH_LOG_SECTOR_SIZE);
+    auto read = [&](uint32_t offset, void* dst, size_t len) {
+        if (offset + len > size)
+            return false;
+        std::memcpy(dst, image + offset, len);
+        return true;
+    };
+    const flash_log_tail_t tail = flash_log_find_tail(read, sectors);
+
+    decode_stats_t stats;
+    if (!tail.empty)
+    {
+        if (print)
+            std::printf("timestamp_us,report_id,accuracy,values\n");
+
+        // oldest to newest along the ring, skipping a sector erased for the next lap
+        for (uint32_t s = tail.oldest_sector;; s = (s + 1) % sectors)
+        {
+            flash_log_sector_hdr_t hdr;
+            std::memcpy(&hdr, image + s * FLASH_LOG_SECTOR_SIZE, sizeof(hdr));
+            if (flash_log_sector_valid(hdr))
+            {
+                const bool head = (s == tail.head_sector);
+                decode_sector(image + s * FLASH_LOG_SECTOR_SIZE, head ? tail.next_block : FLASH_LOG_BLOCKS_PER_SECTOR,
+                        print, stats);
+            }
+            if (s == tail.head_sector)
+                break;
+        }
+    }
+
+    munmap(const_cast<uint8_t*>(image), size);
+    std::fprintf(stderr, "flash_log_decode: %u sectors in image, %zu live, %zu blocks, %zu bad blocks, %zu records",
+            sectors, stats.sectors, stats.blocks, stats.bad_blocks, stats.records);
+    if (stats.records != 0)
+        std::fprintf(stderr, ", %lu..%lu us, tail found in %lu reads", (unsigned long)stats.first_us,
+                (unsigned long)stats.last_us, (unsigned long)tail.reads);
+    std::fprintf(stderr, "\n");
+    return 0;
+}
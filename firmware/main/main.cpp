@@ -1,7 +1,72 @@
 #include <stdio.h>
 #include "BNO08x.hpp"
+#include "binlog.hpp"
+#include "heap_guard.hpp"
 #include "imu_driver.hpp"
+#include "pipeline.hpp"
+#include "power_manager.hpp"
+#include "rate_governor.hpp"
+#include "esp_log.h"
 #include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// REST / CALM / VIGOROUS periods of the reports the rate governor retunes
+static const rg_rpt_rates_t governed_rates[] = {
+    {SH2_ACCELEROMETER, {100000UL, 20000UL, 5000UL}},
+    {SH2_GYROSCOPE_CALIBRATED, {200000UL, 20000UL, 5000UL}},
+    {SH2_ROTATION_VECTOR, {200000UL, 20000UL, 10000UL}},
+};
+
+// reports streamed while the power manager is ACTIVE, it adds linear accel to judge motion;
+// governed reports take the governor's current level's period on every ACTIVE entry
+static imu_report_cfg_t active_rpts[] = {
+    {SH2_ACCELEROMETER, 20000UL},
+    {SH2_GYROSCOPE_CALIBRATED, 20000UL},
+    {SH2_MAGNETIC_FIELD_CALIBRATED, 100000UL},
+    {SH2_ROTATION_VECTOR, 20000UL},
+    {SH2_PERSONAL_ACTIVITY_CLASSIFIER, 100000UL},
+};
+
+static constexpr const char *TAG = "MAIN";
+static constexpr uint32_t STATS_EVERY_N_HOUSEKEEPING = 10;
+
+// PROCESS hands every drained batch to the rate governor
+static void governor_feed(const imu_sample_t *samples, size_t count) {
+    rg_feed(samples, count);
+}
+
+// runs in the pipeline's STORE task once a second, the only place that may allocate after init
+static void housekeeping() {
+    static uint32_t runs = 0;
+    const bool armed = heap_guard_armed();
+    heap_guard_disarm();
+
+    // an NVS write allocates, it happens once per convergence and is not part of the steady state
+    imu_cal_save_if_converged();
+
+    if (++runs % STATS_EVERY_N_HOUSEKEEPING == 0) {
+        // ESP_LOGx formats here and newlib's %f can allocate: a diagnostic, not the steady state
+        const pipeline_stats_t stats = pipeline_get_stats();
+        const pipeline_queue_stats_t &ring = stats.stage[PIPELINE_STAGE_PROCESS].input;
+        ESP_LOGI(TAG, "Ring: high water %lu/%lu, overflows %lu; stored %lu, late %lu, avg age %lu us",
+                 (unsigned long)ring.high_water, (unsigned long)ring.capacity, (unsigned long)ring.dropped,
+                 (unsigned long)stats.stage[PIPELINE_STAGE_STORE].items, (unsigned long)stats.late,
+                 (unsigned long)stats.latency_avg_us);
+        imu_metrics_print();
+
+        heap_guard_stats_t heap = heap_guard_get_stats();
+        if (heap.allocs != 0) {
+            ESP_LOGW(TAG, "Heap: %lu allocations (%lu B) since init, first %lu B from %p",
+                     (unsigned long)heap.allocs, (unsigned long)heap.bytes,
+                     (unsigned long)heap.first_size, heap.first_caller);
+        }
+    }
+
+    if (armed) {
+        heap_guard_arm();
+    }
+}
 
 extern "C" void app_main(void) {
 
@@ -44,5 +109,49 @@ extern "C" void app_main(void) {
     esp_rom_printf("\n=== Raw FRS Dump ===\n");
     imu_frs_dump(BNO08xFrsID::SIG_MOTION_DETECT_CONFIG);
 
+    // pm_task owns the report set, sig motion wakes and hub resets, and suspends PROCESS outside ACTIVE;
+    // the pipeline is the sample ring's only consumer and feeds every drained batch to the rate governor
+    binlog_config_t log_config;
+    log_config.core_id = PIPELINE_PROCESS_CORE;
+    if (!binlog_start(log_config)) {
+        esp_rom_printf("Binlog initialization failed!\n");
+        return;
+    }
+
+    rg_config_t rg_config;
+    rg_config.rates = governed_rates;
+    rg_config.rate_count = sizeof(governed_rates) / sizeof(governed_rates[0]);
+    if (!rg_init(rg_config)) {
+        esp_rom_printf("Rate governor initialization failed!\n");
+        return;
+    }
+
+    // the governor retunes the report rates, a feature engine would need one fixed rate
+    pipeline_config_t pl_config;
+    pl_config.features_enabled = false;
+    pl_config.on_batch = governor_feed;
+    pl_config.housekeeping = housekeeping;
+    if (!pipeline_start(pl_config)) {
+        esp_rom_printf("Pipeline initialization failed!\n");
+        return;
+    }
+
+    pm_config_t pm_config;
+    pm_config.active_rpts = active_rpts;
+    pm_config.active_rpt_count = sizeof(active_rpts) / sizeof(active_rpts[0]);
+    pm_config.processing_task = pipeline_get_process_task();
+    pm_config.active_period = rg_get_period;
+    if (!pm_init(pm_config)) {
+        esp_rom_printf("Power manager initialization failed!\n");
+        return;
+    }
+
+    if (xTaskCreatePinnedToCore(pm_task, "power_manager", 4096, nullptr, 6, nullptr, 0) != pdPASS) {
+        esp_rom_printf("Failed to create the power manager task!\n");
+        return;
+    }
+
+    // init is done, nothing below may allocate
+    heap_guard_arm();
 
 }
\ No newline at end of file